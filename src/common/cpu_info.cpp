@@ -0,0 +1,252 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "common/cpu_info.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#include <sys/types.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#include "common/log.h"
+
+namespace paddle_mobile {
+
+namespace {
+
+bool ReadLine(const std::string &path, char *line, int size) {
+  FILE *file = fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    return false;
+  }
+  bool success = fgets(line, size, file) != nullptr;
+  fclose(file);
+  return success;
+}
+
+// parse sizes like "32K", "2048K" or "8M"
+size_t ParseCacheSize(const char *text) {
+  char *end = nullptr;
+  size_t size = strtoul(text, &end, 10);
+  if (*end == 'K' || *end == 'k') {
+    size *= 1024;
+  } else if (*end == 'M' || *end == 'm') {
+    size *= 1024 * 1024;
+  }
+  return size;
+}
+
+// caches of one core from /sys/devices/system/cpu/cpuN/cache/indexM
+bool DetectCoreFromSysfs(int cpu, CPUInfo *info) {
+  std::string cpu_dir =
+      "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cache/index";
+  bool found = false;
+  char line[64];
+  for (int index = 0; index < 8; ++index) {
+    std::string dir = cpu_dir + std::to_string(index);
+    if (!ReadLine(dir + "/level", line, sizeof(line))) {
+      break;
+    }
+    int level = atoi(line);
+    if (!ReadLine(dir + "/type", line, sizeof(line)) ||
+        strncmp(line, "Instruction", 11) == 0) {
+      continue;
+    }
+    if (!ReadLine(dir + "/size", line, sizeof(line))) {
+      continue;
+    }
+    size_t size = ParseCacheSize(line);
+    if (size == 0) {
+      continue;
+    }
+    found = true;
+    if (level == 1) {
+      info->l1_cache = size;
+    } else if (level == 2) {
+      info->l2_cache = size;
+    } else if (level == 3) {
+      info->l3_cache = size;
+    }
+  }
+  return found;
+}
+
+// big.LITTLE cores have different caches, keep the core with the largest L2
+bool DetectFromSysfs(CPUInfo *info) {
+  bool found = false;
+  for (int cpu = 0; cpu < 64; ++cpu) {
+    CPUInfo core;
+    core.l1_cache = 0;
+    core.l2_cache = 0;
+    if (!DetectCoreFromSysfs(cpu, &core)) {
+      if (cpu > 0) break;
+      continue;
+    }
+    if (!found || core.l2_cache > info->l2_cache) {
+      if (core.l1_cache > 0) info->l1_cache = core.l1_cache;
+      if (core.l2_cache > 0) info->l2_cache = core.l2_cache;
+      info->l3_cache = core.l3_cache;
+    }
+    found = true;
+  }
+  return found;
+}
+
+// split the cores by cpuinfo_max_freq, the fastest ones are the big cores
+void DetectCoresFromSysfs(CPUInfo *info) {
+  std::vector<long> freqs;
+  char line[64];
+  for (int cpu = 0; cpu < 64; ++cpu) {
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                       "/cpufreq/cpuinfo_max_freq";
+    if (!ReadLine(path, line, sizeof(line))) {
+      break;
+    }
+    freqs.push_back(atol(line));
+  }
+  if (freqs.empty()) {
+    return;
+  }
+  long max_freq = *std::max_element(freqs.begin(), freqs.end());
+  for (int cpu = 0; cpu < freqs.size(); ++cpu) {
+    if (freqs[cpu] == max_freq) {
+      info->big_cores.push_back(cpu);
+    } else {
+      info->little_cores.push_back(cpu);
+    }
+  }
+}
+
+#ifdef __APPLE__
+size_t SysctlSize(const char *name) {
+  int64_t value = 0;
+  size_t length = sizeof(value);
+  if (sysctlbyname(name, &value, &length, nullptr, 0) != 0) {
+    return 0;
+  }
+  return static_cast<size_t>(value);
+}
+
+bool DetectFromSysctl(CPUInfo *info) {
+  size_t l1 = SysctlSize("hw.l1dcachesize");
+  size_t l2 = SysctlSize("hw.l2cachesize");
+  if (l1 == 0 && l2 == 0) {
+    return false;
+  }
+  if (l1 > 0) info->l1_cache = l1;
+  if (l2 > 0) info->l2_cache = l2;
+  info->l3_cache = SysctlSize("hw.l3cachesize");
+  return true;
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+// deterministic cache parameters, cpuid leaf 4
+bool DetectFromCpuid(CPUInfo *info) {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx) || eax < 4) {
+    return false;
+  }
+  bool found = false;
+  for (unsigned int index = 0; index < 8; ++index) {
+    __cpuid_count(4, index, eax, ebx, ecx, edx);
+    unsigned int type = eax & 0x1f;
+    if (type == 0) {
+      break;
+    }
+    // 1: data cache, 3: unified cache
+    if (type != 1 && type != 3) {
+      continue;
+    }
+    unsigned int level = (eax >> 5) & 0x7;
+    size_t ways = ((ebx >> 22) & 0x3ff) + 1;
+    size_t partitions = ((ebx >> 12) & 0x3ff) + 1;
+    size_t line_size = (ebx & 0xfff) + 1;
+    size_t sets = ecx + 1;
+    size_t size = ways * partitions * line_size * sets;
+    found = true;
+    if (level == 1) {
+      info->l1_cache = size;
+    } else if (level == 2) {
+      info->l2_cache = size;
+    } else if (level == 3) {
+      info->l3_cache = size;
+    }
+  }
+  return found;
+}
+
+// avx2, fma and f16c also need the os to save the ymm registers
+void DetectX86Features(CPUInfo *info) {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx) || eax < 7) {
+    return;
+  }
+  __cpuid(1, eax, ebx, ecx, edx);
+  bool osxsave = (ecx >> 27) & 1;
+  bool avx = (ecx >> 28) & 1;
+  bool fma = (ecx >> 12) & 1;
+  bool f16c = (ecx >> 29) & 1;
+  if (!osxsave || !avx) {
+    return;
+  }
+  unsigned int xcr0_low, xcr0_high;
+  __asm__ volatile("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+  if ((xcr0_low & 0x6) != 0x6) {
+    return;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  info->avx2 = (ebx >> 5) & 1;
+  info->fma = fma;
+  info->f16c = f16c;
+}
+#endif
+
+CPUInfo DetectCPUInfo() {
+  CPUInfo info;
+  DetectCoresFromSysfs(&info);
+  bool found = DetectFromSysfs(&info);
+#ifdef __APPLE__
+  found = found || DetectFromSysctl(&info);
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+  found = found || DetectFromCpuid(&info);
+  DetectX86Features(&info);
+#endif
+  if (!found) {
+    LOG(kLOG_WARNING) << "can not detect cache sizes, use the defaults";
+  }
+  DLOG << "L1 cache: " << info.l1_cache << " L2 cache: " << info.l2_cache
+       << " L3 cache: " << info.l3_cache
+       << " big cores: " << info.big_cores.size()
+       << " little cores: " << info.little_cores.size()
+       << " avx2: " << info.avx2 << " fma: " << info.fma
+       << " f16c: " << info.f16c;
+  return info;
+}
+
+}  // namespace
+
+const CPUInfo &GetCPUInfo() {
+  static CPUInfo info = DetectCPUInfo();
+  return info;
+}
+
+}  // namespace paddle_mobile
@@ -0,0 +1,45 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace paddle_mobile {
+
+struct CPUInfo {
+  // data cache sizes in bytes of the core with the largest L2 cache, the
+  // defaults are used when the sizes can not be detected
+  size_t l1_cache = 32 * 1024;
+  size_t l2_cache = 512 * 1024;
+  // 0 if there is no L3 cache
+  size_t l3_cache = 0;
+  // core ids grouped by their max frequency, all cores are big cores on a
+  // homogeneous cpu and both lists are empty if the cores are unknown
+  std::vector<int> big_cores;
+  std::vector<int> little_cores;
+  // x86 instruction set extensions usable by the kernels, detected at
+  // runtime so that one binary runs on both old and new hosts
+  bool avx2 = false;
+  bool fma = false;
+  // conversion between float and half
+  bool f16c = false;
+};
+
+// detect the cache sizes, core classes and x86 extensions once from sysfs,
+// sysctl or cpuid
+const CPUInfo &GetCPUInfo();
+
+}  // namespace paddle_mobile
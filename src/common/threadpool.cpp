@@ -0,0 +1,266 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "common/threadpool.h"
+#if defined(__linux__) || defined(__ANDROID__)
+#include <sched.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "common/cpu_info.h"
+#include "common/log.h"
+
+namespace paddle_mobile {
+
+namespace {
+
+// spins before a worker goes to sleep or the caller starts yielding, about
+// a few tens of microseconds
+const int kSpinCount = 1 << 12;
+
+// set while the thread runs a share of a parallel region
+thread_local bool in_parallel_region = false;
+
+// the pool of the calling thread if it is not the shared one
+thread_local ThreadPool *bound_pool = nullptr;
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+const std::vector<int> &AffinityCores(CPUAffinity affinity) {
+  static const std::vector<int> none;
+  const CPUInfo &info = GetCPUInfo();
+  if (affinity == AFFINITY_BIG_CORES) {
+    return info.big_cores;
+  } else if (affinity == AFFINITY_LITTLE_CORES) {
+    return info.little_cores.empty() ? info.big_cores : info.little_cores;
+  }
+  return none;
+}
+
+void BindToCores(const std::vector<int> &cores) {
+#if defined(__linux__) || defined(__ANDROID__)
+  if (cores.empty()) {
+    return;
+  }
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int core : cores) {
+    CPU_SET(core, &mask);
+  }
+  if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+    LOG(kLOG_WARNING) << "failed to set cpu affinity";
+  }
+#endif
+}
+
+}  // namespace
+
+ThreadPool *ThreadPool::Instance() {
+  if (bound_pool != nullptr) {
+    return bound_pool;
+  }
+  static ThreadPool pool;
+  return &pool;
+}
+
+ThreadPool *ThreadPool::Bind(ThreadPool *pool) {
+  ThreadPool *previous = bound_pool;
+  bound_pool = pool;
+  return previous;
+}
+
+ThreadPool::ThreadPool(int num)
+    : epoch_(0), pending_(0), thread_num_(std::max(num, 1)) {
+  StartWorkers();
+}
+
+ThreadPool::ThreadPool() : epoch_(0), pending_(0) {
+#ifdef _OPENMP
+  // keep the thread number of the former openmp kernels by default
+  thread_num_ = omp_get_max_threads();
+#endif
+  StartWorkers();
+}
+
+ThreadPool::~ThreadPool() { StopWorkers(); }
+
+void ThreadPool::SetThreadNum(int num, CPUAffinity affinity) {
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  num = std::max(num, 1);
+  if (num == thread_num_ && affinity == affinity_) {
+    return;
+  }
+  StopWorkers();
+  thread_num_ = num;
+  affinity_ = affinity;
+  // the caller runs the share of tid 0, keep it on the same core class
+  BindToCores(AffinityCores(affinity_));
+  StartWorkers();
+#ifdef _OPENMP
+  omp_set_num_threads(num);
+#endif
+}
+
+void ThreadPool::StartWorkers() {
+  stop_ = false;
+  for (int tid = 1; tid < thread_num_; ++tid) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this, tid,
+                          epoch_.load(std::memory_order_relaxed));
+  }
+}
+
+void ThreadPool::StopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  for (std::thread &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void ThreadPool::WorkerLoop(int tid, uint32_t seen) {
+  const std::vector<int> &cores = AffinityCores(affinity_);
+  if (!cores.empty()) {
+    BindToCores({cores[tid % cores.size()]});
+  }
+  in_parallel_region = true;
+  while (true) {
+    uint32_t epoch = epoch_.load(std::memory_order_acquire);
+    for (int spin = 0; epoch == seen && spin < kSpinCount; ++spin) {
+      CpuRelax();
+      epoch = epoch_.load(std::memory_order_acquire);
+    }
+    if (epoch == seen) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ++sleeping_;
+      cond_.wait(lock, [&] {
+        return stop_ || epoch_.load(std::memory_order_acquire) != seen;
+      });
+      --sleeping_;
+      if (stop_) {
+        return;
+      }
+      epoch = epoch_.load(std::memory_order_acquire);
+    }
+    seen = epoch;
+    if (tid < task_num_) {
+#ifdef ENABLE_EXCEPTION
+      try {
+        task_(context_, tid);
+      } catch (...) {
+        // Run rethrows it on the calling thread
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error_ == nullptr) {
+          error_ = std::current_exception();
+        }
+      }
+#else
+      task_(context_, tid);
+#endif
+    }
+    pending_.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+void ThreadPool::Run(Task task, void *context, int num) {
+  if (in_parallel_region || num <= 1) {
+    RunSerially(task, context, num);
+    return;
+  }
+  std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+  // workers_ only changes under run_mutex_
+  if (!run_lock.owns_lock() || workers_.empty()) {
+    // another thread owns the workers, do not wait for it
+    RunSerially(task, context, num);
+    return;
+  }
+  task_ = task;
+  context_ = context;
+  task_num_ = std::min(num, thread_num_);
+  error_ = nullptr;
+  pending_.store(static_cast<int>(workers_.size()), std::memory_order_relaxed);
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    epoch_.fetch_add(1, std::memory_order_release);
+    notify = sleeping_ > 0;
+  }
+  if (notify) {
+    cond_.notify_all();
+  }
+
+  // leaves the region even if the share of the caller throws, the workers
+  // still run task on context, which lives on the stack of the caller
+  class RegionGuard {
+   public:
+    explicit RegionGuard(ThreadPool *pool) : pool_(pool) {
+      in_parallel_region = true;
+    }
+    ~RegionGuard() {
+      in_parallel_region = false;
+      pool_->WaitWorkers();
+    }
+
+   private:
+    ThreadPool *pool_;
+  };
+  {
+    RegionGuard guard(this);
+    task(context, 0);
+    // shares beyond the pool size, only when num > ThreadNum()
+    for (int tid = thread_num_; tid < num; ++tid) {
+      task(context, tid);
+    }
+  }
+#ifdef ENABLE_EXCEPTION
+  if (error_ != nullptr) {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+#endif
+}
+
+void ThreadPool::RunSerially(Task task, void *context, int num) {
+  for (int tid = 0; tid < num; ++tid) {
+    task(context, tid);
+  }
+}
+
+void ThreadPool::WaitWorkers() {
+  // yield once the workers are late, they may share cores with the caller
+  for (int spin = 0; pending_.load(std::memory_order_acquire) != 0; ++spin) {
+    if (spin < kSpinCount) {
+      CpuRelax();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+}  // namespace paddle_mobile
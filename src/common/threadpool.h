@@ -14,113 +14,132 @@ limitations under the License. */
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
-#include <functional>
-#include <future>
-#include <memory>
+#include <cstdint>
+#include <exception>
 #include <mutex>
-#include <queue>
-#include <stdexcept>
 #include <thread>
 #include <vector>
+#include "common/types.h"
 
 namespace paddle_mobile {
+
+// Persistent worker pool shared by all cpu kernels. The calling thread runs
+// the first share of a parallel region itself, the workers spin for a short
+// while after each region and only then sleep, so back to back ops do not
+// pay for thread wakeups.
 class ThreadPool {
  public:
-  static ThreadPool& getThreadPool();
-  static int getThreadPoolThreadId();
-  explicit ThreadPool(size_t);
-  template <class F, class... Args>
-  auto enqueue(F&& f, Args&&... args)
-      -> std::future<typename std::result_of<F(Args...)>::type>;
+  typedef void (*Task)(void *context, int tid);
+
+  // a private pool of num threads for a thread which runs kernels at the
+  // same time as others, see Bind. Its workers are not pinned, they keep
+  // the cpu affinity of the thread which creates the pool.
+  explicit ThreadPool(int num);
   ~ThreadPool();
-  int getTid(const std::thread::id& id) {
-    for (int i = 0; i < workers.size(); i++) {
-      if (workers[i].get_id() == id) {
-        return i;
-      }
-    }
-    return -1;
-  }
 
- private:
-  // need to keep track of threads so we can join them
-  std::vector<std::thread> workers;
-  // the task queue
-  std::queue<std::function<void()>> tasks;
-
-  // synchronization
-  std::mutex queue_mutex;
-  std::condition_variable condition;
-  bool stop;
-};
+  // the pool bound to the calling thread, the shared pool by default
+  static ThreadPool *Instance();
+  // binds pool to the calling thread, nullptr binds the shared pool again,
+  // returns the pool bound before
+  static ThreadPool *Bind(ThreadPool *pool);
 
-// the constructor just launches some amount of workers
-inline ThreadPool::ThreadPool(size_t threads) : stop(false) {
-  for (size_t i = 0; i < threads; ++i)
-    workers.emplace_back([this] {
-      for (;;) {
-        std::function<void()> task;
-        {
-          std::unique_lock<std::mutex> lock(this->queue_mutex);
-          this->condition.wait(
-              lock, [this] { return this->stop || !this->tasks.empty(); });
-          // for (;;) {
-          //     if (this->stop || !this->tasks.empty()) {
-          //         break;
-          //     }
-          //     lock.unlock();
-          //     lock.lock();
-          // }
-          if (this->stop && this->tasks.empty()) return;
-          task = std::move(this->tasks.front());
-          this->tasks.pop();
-        }
-
-        task();
-      }
-    });
-}
+  // number of threads including the calling thread
+  void SetThreadNum(int num, CPUAffinity affinity = AFFINITY_NONE);
+  int ThreadNum() const { return thread_num_; }
 
-// add new work item to the pool
-template <class F, class... Args>
-auto ThreadPool::enqueue(F&& f, Args&&... args)
-    -> std::future<typename std::result_of<F(Args...)>::type> {
-  using return_type = typename std::result_of<F(Args...)>::type;
+  // call task(context, tid) for every tid in [0, num), tid 0 runs on the
+  // calling thread. Nested regions and regions issued while another thread
+  // owns the pool run serially on the calling thread. An exception thrown
+  // by a share is rethrown here once all shares have finished.
+  void Run(Task task, void *context, int num);
+
+ private:
+  ThreadPool();
+  void StartWorkers();
+  void StopWorkers();
+  // seen is the epoch of the last region before the worker started
+  void WorkerLoop(int tid, uint32_t seen);
+  void RunSerially(Task task, void *context, int num);
+  // until the workers finished their shares of the current region
+  void WaitWorkers();
+
+  std::vector<std::thread> workers_;
+  // serializes parallel regions from different threads
+  std::mutex run_mutex_;
+  // protects sleeping workers against missed wakeups
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::atomic<uint32_t> epoch_;
+  std::atomic<int> pending_;
+  int sleeping_ = 0;
+  bool stop_ = false;
+
+  Task task_ = nullptr;
+  void *context_ = nullptr;
+  int task_num_ = 0;
+  // the first exception thrown by a worker in the current region
+  std::exception_ptr error_;
+
+  int thread_num_ = 1;
+  CPUAffinity affinity_ = AFFINITY_NONE;
+};
 
-  auto task = std::make_shared<std::packaged_task<return_type()>>(
-      std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+namespace internal {
+
+template <typename F>
+struct ParallelRange {
+  int begin;
+  int end;
+  int num;
+  const F *func;
+
+  static void Run(void *context, int tid) {
+    const ParallelRange *range = static_cast<const ParallelRange *>(context);
+    int total = range->end - range->begin;
+    int start = range->begin + total * tid / range->num;
+    int stop = range->begin + total * (tid + 1) / range->num;
+    for (int i = start; i < stop; ++i) {
+      (*range->func)(i, tid);
+    }
+  }
+};
 
-  std::future<return_type> res = task->get_future();
-  {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+template <typename F>
+struct IgnoreTid {
+  const F *func;
+  void operator()(int i, int tid) const { (*func)(i); }
+};
 
-    // don't allow enqueueing after stopping the pool
-    // if(stop)
-    //     throw std::runtime_error("enqueue on stopped ThreadPool");
+}  // namespace internal
 
-    tasks.emplace([task]() { (*task)(); });
+// static schedule of [begin, end) over the pool, func(i, tid) where tid is
+// in [0, ThreadPool::Instance()->ThreadNum()) and can index per-thread
+// buffers
+template <typename F>
+void parallel_for_tid(int begin, int end, const F &func) {
+  if (end <= begin) {
+    return;
   }
-  condition.notify_one();
-  return res;
-}
-
-// the destructor joins all threads
-inline ThreadPool::~ThreadPool() {
-  {
-    std::unique_lock<std::mutex> lock(queue_mutex);
-    stop = true;
+  ThreadPool *pool = ThreadPool::Instance();
+  int num = std::min(pool->ThreadNum(), end - begin);
+  if (num <= 1) {
+    for (int i = begin; i < end; ++i) {
+      func(i, 0);
+    }
+    return;
   }
-  condition.notify_all();
-  for (std::thread& worker : workers) worker.join();
+  internal::ParallelRange<F> range = {begin, end, num, &func};
+  pool->Run(&internal::ParallelRange<F>::Run, &range, num);
 }
 
-ThreadPool& ThreadPool::getThreadPool() {
-  static ThreadPool threadPool(3);
-  return threadPool;
+// static schedule of [begin, end) over the pool, func(i)
+template <typename F>
+void parallel_for(int begin, int end, const F &func) {
+  internal::IgnoreTid<F> wrapper = {&func};
+  parallel_for_tid(begin, end, wrapper);
 }
 
-int ThreadPool::getThreadPoolThreadId() {
-  return getThreadPool().getTid(std::this_thread::get_id());
-}
 }  // namespace paddle_mobile
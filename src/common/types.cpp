@@ -88,6 +88,7 @@ const char *G_OP_TYPE_INCREMENT = "increment";
 
 const char *G_OP_TYPE_QUANTIZE = "quantize";
 const char *G_OP_TYPE_DEQUANTIZE = "dequantize";
+const char *G_OP_TYPE_LAYOUT_TRANSFORM = "layout_transform";
 const char *G_OP_TYPE_FUSION_DEQUANT_BN = "fusion_dequant_bn";
 const char *G_OP_TYPE_FUSION_DEQUANT_ADD_BN = "fusion_dequant_add_bn";
 const char *G_OP_TYPE_FUSION_DEQUANT_BN_RELU = "fusion_dequant_bn_relu";
@@ -96,6 +97,14 @@ const char *G_OP_TYPE_FUSION_DEQUANT_ADD_BN_QUANT =
     "fusion_dequant_add_bn_quant";
 const char *G_OP_TYPE_FUSION_DEQUANT_ADD_BN_RELU_QUANT =
     "fusion_dequant_add_bn_relu_quant";
+const char *G_OP_TYPE_FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT =
+    "fusion_conv_dequant_add_bn_relu_quant";
+const char *G_OP_TYPE_FUSION_CONV_DEQUANT_BN_RELU_QUANT =
+    "fusion_conv_dequant_bn_relu_quant";
+const char *G_OP_TYPE_FUSION_CONV_DEQUANT_BN_RELU6_QUANT =
+    "fusion_conv_dequant_bn_relu6_quant";
+const char *G_OP_TYPE_FUSION_CONV_DEQUANT_RELU_QUANT =
+    "fusion_conv_dequant_relu_quant";
 
 const char *G_OP_TYPE_TANH = "tanh";
 const char *G_OP_TYPE_FUSION_DECONV_RELU = "fusion_deconv_relu";
@@ -179,6 +188,7 @@ std::unordered_map<
         {G_OP_TYPE_CAST, {{"X"}, {"Out"}}},
         {G_OP_TYPE_QUANTIZE, {{"X"}, {"Out", "OutScale"}}},
         {G_OP_TYPE_DEQUANTIZE, {{"X", "Scale"}, {"Out"}}},
+        {G_OP_TYPE_LAYOUT_TRANSFORM, {{"X"}, {"Out"}}},
         {G_OP_TYPE_FUSION_DEQUANT_BN, {{"X", "Scale"}, {"Out"}}},
         {G_OP_TYPE_FUSION_DEQUANT_ADD_BN, {{"X", "Scale"}, {"Out"}}},
         {G_OP_TYPE_FUSION_DEQUANT_BN_RELU, {{"X", "Scale"}, {"Out"}}},
@@ -187,6 +197,14 @@ std::unordered_map<
          {{"X", "Scale"}, {"Out", "OutScale"}}},
         {G_OP_TYPE_FUSION_DEQUANT_ADD_BN_QUANT,
          {{"X", "Scale"}, {"Out", "OutScale"}}},
+        {G_OP_TYPE_FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT,
+         {{"Input", "Scale"}, {"Out", "OutScale"}}},
+        {G_OP_TYPE_FUSION_CONV_DEQUANT_BN_RELU_QUANT,
+         {{"Input", "Scale"}, {"Out", "OutScale"}}},
+        {G_OP_TYPE_FUSION_CONV_DEQUANT_BN_RELU6_QUANT,
+         {{"Input", "Scale"}, {"Out", "OutScale"}}},
+        {G_OP_TYPE_FUSION_CONV_DEQUANT_RELU_QUANT,
+         {{"Input", "Scale"}, {"Out", "OutScale"}}},
         {G_OP_TYPE_TANH, {{"X"}, {"Out"}}},
         {G_OP_TYPE_FUSION_DECONV_RELU, {{"Input"}, {"Out"}}},
         {G_OP_TYPE_FUSION_DECONV_ADD, {{"Input"}, {"Out"}}},
@@ -101,6 +101,14 @@ enum ActivationType {
   TANH = 5,
   SIGMOID = 6,
   LOG = 7,
+  HARD_SWISH = 8,
+};
+
+// which cores the worker threads are pinned to
+enum CPUAffinity {
+  AFFINITY_NONE = 0,
+  AFFINITY_BIG_CORES = 1,
+  AFFINITY_LITTLE_CORES = 2,
 };
 
 enum PoolingType {
@@ -112,6 +120,52 @@ enum PoolingType {
 
 struct PaddleMobileConfigInternal {
   bool load_when_predict = false;
+  // share memory between activations whose lifetimes are disjoint
+  bool memory_optimization = false;
+  // map the combined params file instead of reading it, weights refer to
+  // the mapped pages without copying
+  bool load_with_mmap = false;
+  // tune the gemm blocking of every new shape class at kernel Init and keep
+  // the results in this file, tuning is off if it is empty
+  std::string gemm_tuning_profile;
+  // time the algorithms of every new conv shape at Init, keep the fastest and
+  // record it in this file, tuning is off if it is empty
+  std::string conv_tuning_profile;
+  // run conv, pooling, batch norm, relu, elementwise add and concat on
+  // activations in the channel blocked layout NCHW4 or NCHW8, layout_transform
+  // ops are inserted between them and the other ops
+  bool layout_optimization = false;
+  // rewrite the program at load: drop identity ops, fold pad2d into the conv
+  // paddings, batch norms and channel scales into the conv weights and the
+  // ops of constant inputs into weights
+  bool graph_optimization = false;
+  // run independent ops at the same time on this many threads, the threads
+  // set by SetThreadNum are divided among them. 1 runs the ops in program
+  // order.
+  int inter_op_threads = 1;
+  // clones of the instance predicting the requests of PredictAsync, the feed,
+  // the run and the fetch of three requests overlap with 3
+  int pipeline_depth = 3;
+  // keep the optimized program, its weights and the data kernel Init derives
+  // from them in this file, a later load of the same model on the same build
+  // and cpu restores them instead of optimizing again. Off if it is empty,
+  // cpu only.
+  std::string model_cache;
+  // keep the weights the gemm convs and fcs packed at Init as uint8 with a
+  // scale and an offset for every output channel, and free the float ones.
+  // They are dequantized block by block while packing for the gemm, which
+  // takes a quarter of the weight memory at the error of 8 bit weights.
+  // cpu only.
+  bool weight_compression = false;
+  // FP16 keeps the same weights and the tables of lookup_table as half
+  // instead, converted back to float while packing and looking up, so the
+  // arithmetic stays fp32. It takes half the weight memory at the error of
+  // fp16 weights, weight_compression takes precedence. cpu only. Both keep
+  // the depthwise filters float, see OpParam::PackedConvFilter.
+  Precision weight_precision = Precision::FP32;
+  // keep the activations and the conv algorithms planned for at most this
+  // many input shapes, the least recently used plan is dropped for a new one
+  int max_shape_plans = 8;
 };
 
 extern const char *G_OP_TYPE_CONV;
@@ -142,6 +196,7 @@ extern const char *G_OP_TYPE_PRIOR_BOX;
 extern const char *G_OP_TYPE_RELU;
 extern const char *G_OP_TYPE_RELU6;
 extern const char *G_OP_TYPE_RESHAPE;
+extern const char *G_OP_TYPE_RESHAPE2;
 extern const char *G_OP_TYPE_SIGMOID;
 extern const char *G_OP_TYPE_SOFTMAX;
 extern const char *G_OP_TYPE_TRANSPOSE;
@@ -177,12 +232,17 @@ extern const char *G_OP_TYPE_INCREMENT;
 
 extern const char *G_OP_TYPE_QUANTIZE;
 extern const char *G_OP_TYPE_DEQUANTIZE;
+extern const char *G_OP_TYPE_LAYOUT_TRANSFORM;
 extern const char *G_OP_TYPE_FUSION_DEQUANT_BN;
 extern const char *G_OP_TYPE_FUSION_DEQUANT_ADD_BN;
 extern const char *G_OP_TYPE_FUSION_DEQUANT_BN_RELU;
 extern const char *G_OP_TYPE_FUSION_DEQUANT_ADD_BN_RELU;
 extern const char *G_OP_TYPE_FUSION_DEQUANT_ADD_BN_QUANT;
 extern const char *G_OP_TYPE_FUSION_DEQUANT_ADD_BN_RELU_QUANT;
+extern const char *G_OP_TYPE_FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT;
+extern const char *G_OP_TYPE_FUSION_CONV_DEQUANT_BN_RELU_QUANT;
+extern const char *G_OP_TYPE_FUSION_CONV_DEQUANT_BN_RELU6_QUANT;
+extern const char *G_OP_TYPE_FUSION_CONV_DEQUANT_RELU_QUANT;
 
 extern const char *G_OP_TYPE_TANH;
 extern const char *G_OP_TYPE_FUSION_DECONV_RELU;
@@ -13,6 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "common/util.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace paddle_mobile {
 
@@ -32,4 +36,28 @@ char *ReadFileToBuff(std::string filename) {
   return data;
 }
 
+std::shared_ptr<char> MapFileToBuff(std::string filename, size_t *size) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+    close(fd);
+    return nullptr;
+  }
+  size_t length = static_cast<size_t>(file_stat.st_size);
+  // pages are shared between processes until someone writes them
+  void *addr =
+      mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+  madvise(addr, length, MADV_WILLNEED);
+  *size = length;
+  return std::shared_ptr<char>(static_cast<char *>(addr),
+                               [length](char *p) { munmap(p, length); });
+}
+
 }  // namespace paddle_mobile
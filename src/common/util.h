@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "common/enforce.h"
 
@@ -21,4 +22,9 @@ namespace paddle_mobile {
 
 char *ReadFileToBuff(std::string filename);
 
+// map the whole file into memory as private copy-on-write pages, the file is
+// unmapped when the last reference is released. returns nullptr if the file
+// can not be mapped.
+std::shared_ptr<char> MapFileToBuff(std::string filename, size_t *size);
+
 }  // namespace paddle_mobile
@@ -0,0 +1,367 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#ifdef PADDLE_MOBILE_CPU
+
+#include "framework/calibrator.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include "framework/loader.h"
+#include "framework/model_writer.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+void Histogram::Add(const float *data, int64_t size) {
+  const int bins = counts_.size();
+  float max = 0.f;
+  for (int64_t i = 0; i < size; ++i) {
+    max = std::max(max, std::fabs(data[i]));
+  }
+  max_ = std::max(max_, max);
+  if (width_ == 0.f) {
+    if (max == 0.f) {
+      counts_[0] += size;
+      return;
+    }
+    width_ = max / bins;
+  }
+  // double the range until it covers the new values
+  while (max > width_ * bins) {
+    for (int i = 0; i < bins / 2; ++i) {
+      counts_[i] = counts_[2 * i] + counts_[2 * i + 1];
+    }
+    std::fill(counts_.begin() + bins / 2, counts_.end(), 0);
+    width_ *= 2.f;
+  }
+  for (int64_t i = 0; i < size; ++i) {
+    int bin = static_cast<int>(std::fabs(data[i]) / width_);
+    counts_[std::min(bin, bins - 1)] += 1;
+  }
+}
+
+float Histogram::PercentileThreshold(float percentile) const {
+  uint64_t total = 0;
+  for (uint64_t count : counts_) {
+    total += count;
+  }
+  uint64_t sum = 0;
+  for (int i = 0; i < counts_.size(); ++i) {
+    sum += counts_[i];
+    if (sum >= percentile * total) {
+      return std::min((i + 1) * width_, max_);
+    }
+  }
+  return max_;
+}
+
+float Histogram::KLThreshold(int levels) const {
+  const int bins = counts_.size();
+  int used = bins;
+  while (used > 0 && counts_[used - 1] == 0) {
+    --used;
+  }
+  if (used <= levels) {
+    return max_;
+  }
+  // try every clipping bin i, the values beyond are clipped into bin i - 1
+  // of the reference distribution p, while q merges the first i bins into
+  // the int8 levels and expands them back over the nonzero bins
+  std::vector<double> p(bins), q(bins);
+  double outliers = 0;
+  for (int i = levels; i < bins; ++i) {
+    outliers += counts_[i];
+  }
+  double min_divergence = -1;
+  int best = bins;
+  for (int i = levels; i <= bins; ++i) {
+    if (i > levels) {
+      outliers -= counts_[i - 1];
+    }
+    double p_sum = 0;
+    for (int k = 0; k < i; ++k) {
+      p[k] = counts_[k];
+      p_sum += p[k];
+    }
+    p[i - 1] += outliers;
+    p_sum += outliers;
+
+    double q_sum = 0;
+    for (int j = 0; j < levels; ++j) {
+      const int start = static_cast<int64_t>(j) * i / levels;
+      const int end = static_cast<int64_t>(j + 1) * i / levels;
+      double sum = 0;
+      int nonzero = 0;
+      for (int k = start; k < end; ++k) {
+        sum += counts_[k];
+        nonzero += counts_[k] != 0;
+      }
+      for (int k = start; k < end; ++k) {
+        q[k] = counts_[k] != 0 ? sum / nonzero : 0;
+        q_sum += q[k];
+      }
+    }
+    if (p_sum == 0 || q_sum == 0) {
+      continue;
+    }
+
+    double divergence = 0;
+    for (int k = 0; k < i; ++k) {
+      if (p[k] == 0) {
+        continue;
+      }
+      // the bins clipped into the last bin of p may have no mass in q
+      const double pk = p[k] / p_sum;
+      const double qk = std::max(q[k] / q_sum, 1e-10);
+      divergence += pk * std::log(pk / qk);
+    }
+    if (min_divergence < 0 || divergence < min_divergence) {
+      min_divergence = divergence;
+      best = i;
+    }
+  }
+  return std::min(best * width_, max_);
+}
+
+Calibrator::Calibrator(const std::string &dirname,
+                       const CalibrationConfig &config)
+    : config_(config) {
+  Loader<CPU, float> loader;
+  program_ = loader.Load(dirname, false, false);
+  Init();
+}
+
+Calibrator::Calibrator(const std::string &model_path,
+                       const std::string &para_path,
+                       const CalibrationConfig &config)
+    : config_(config) {
+  Loader<CPU, float> loader;
+  program_ = loader.Load(model_path, para_path, false, false);
+  Init();
+}
+
+void Calibrator::Init() {
+  // without memory optimization every activation keeps its own buffer, so
+  // all of them can be read after the prediction
+  PaddleMobileConfigInternal config;
+  config.memory_optimization = false;
+  executor_ = std::make_shared<Executor<CPU>>(program_, config,
+                                              config_.batch_size, false);
+  for (const auto &op : program_.originProgram->Block(0)->Ops()) {
+    if (Quantizable(op)) {
+      const bool conv = op->Type() != G_OP_TYPE_MUL;
+      histograms_[op->Input(conv ? "Input" : "X")[0]] = Histogram();
+    }
+  }
+}
+
+bool Calibrator::Quantizable(const std::shared_ptr<OpDesc> &op) const {
+  const bool conv = op->Type() == G_OP_TYPE_CONV ||
+                    op->Type() == G_OP_TYPE_DEPTHWISE_CONV;
+  if (!conv && op->Type() != G_OP_TYPE_MUL) {
+    return false;
+  }
+  const std::string &input = op->Input(conv ? "Input" : "X")[0];
+  const std::string &weight = op->Input(conv ? "Filter" : "Y")[0];
+  const std::string &output = op->Output(conv ? "Output" : "Out")[0];
+  std::shared_ptr<VarDesc> input_var, weight_var, output_var;
+  int weight_uses = 0;
+  auto block = program_.originProgram->Block(0);
+  for (const auto &var : block->Vars()) {
+    if (var->Name() == input) input_var = var;
+    if (var->Name() == weight) weight_var = var;
+    if (var->Name() == output) output_var = var;
+  }
+  for (const auto &other : block->Ops()) {
+    for (const auto &args : other->GetInputs()) {
+      weight_uses += std::count(args.second.begin(), args.second.end(),
+                                weight);
+    }
+  }
+  if (!input_var || !weight_var || !output_var || weight_uses != 1 ||
+      input_var->Persistable() || !weight_var->Persistable() ||
+      input_var->Tensor_desc().DataType() != VARTYPE_TYPE_FP32 ||
+      weight_var->Tensor_desc().DataType() != VARTYPE_TYPE_FP32) {
+    return false;
+  }
+  // the dequantize op scales the output channels of the second dimension
+  const size_t weight_rank = weight_var->Tensor_desc().Dims().size();
+  const size_t output_rank = output_var->Tensor_desc().Dims().size();
+  return conv ? weight_rank == 4 && output_rank == 4
+              : weight_rank == 2 && output_rank == 2;
+}
+
+void Calibrator::Collect(const Tensor &input) {
+  executor_->SetInput(input, "feed");
+  executor_->Predict();
+  for (auto &pair : histograms_) {
+    auto tensor = executor_->GetOutput(pair.first);
+    if (tensor->IsInitialized() && tensor->type() == typeid(float)) {
+      pair.second.Add(tensor->data<float>(), tensor->numel());
+    }
+  }
+}
+
+std::map<std::string, float> Calibrator::Thresholds() const {
+  std::map<std::string, float> thresholds;
+  for (const auto &pair : histograms_) {
+    switch (config_.method) {
+      case CALIBRATION_MAX:
+        thresholds[pair.first] = pair.second.Max();
+        break;
+      case CALIBRATION_KL:
+        thresholds[pair.first] = pair.second.KLThreshold();
+        break;
+      case CALIBRATION_PERCENTILE:
+        thresholds[pair.first] =
+            pair.second.PercentileThreshold(config_.percentile);
+        break;
+    }
+  }
+  return thresholds;
+}
+
+// Quantizes the weight symmetrically into [-127, 127] for every channel of
+// dimension axis, or for the whole tensor. The dequantize op divides the
+// int32 outputs by weight_scale = 127 * 127 / max(|w|) and multiplies them
+// by the activation threshold.
+static void QuantizeWeight(const Tensor &weight, int axis, bool per_channel,
+                           LoDTensor *quantized, std::vector<float> *scales) {
+  const DDim &dims = weight.dims();
+  const int channels = dims[axis];
+  int64_t inner = 1;
+  for (int i = axis + 1; i < dims.size(); ++i) {
+    inner *= dims[i];
+  }
+  const float *w = weight.data<float>();
+  std::vector<float> max(channels, 0.f);
+  for (int64_t i = 0; i < weight.numel(); ++i) {
+    int c = (i / inner) % channels;
+    max[c] = std::max(max[c], std::fabs(w[i]));
+  }
+  if (!per_channel) {
+    max.assign(channels, *std::max_element(max.begin(), max.end()));
+  }
+  quantized->Resize(dims);
+  int8_t *q = quantized->mutable_data<int8_t>();
+  for (int64_t i = 0; i < weight.numel(); ++i) {
+    int c = (i / inner) % channels;
+    float value = max[c] > 0 ? std::round(w[i] * 127.f / max[c]) : 0.f;
+    q[i] = static_cast<int8_t>(std::min(std::max(value, -127.f), 127.f));
+  }
+  scales->resize(channels);
+  for (int c = 0; c < channels; ++c) {
+    (*scales)[c] = 127.f * 127.f / (max[c] > 0 ? max[c] : 1.f);
+  }
+}
+
+void Calibrator::Save(const std::string &model_path,
+                      const std::string &para_path) {
+  const std::map<std::string, float> thresholds = Thresholds();
+  ProgramDesc program(*program_.originProgram);
+  auto block = program.Block(0);
+  std::map<std::string, std::vector<int64_t>> var_dims;
+  for (const auto &var : block->Vars()) {
+    var_dims[var->Name()] = var->Tensor_desc().Dims();
+  }
+  // the tensors written instead of the ones of the fp32 scope
+  std::map<std::string, LoDTensor> tensors;
+  std::set<std::string> quantized_inputs;
+  std::vector<std::shared_ptr<OpDesc>> ops;
+  for (const auto &op : block->Ops()) {
+    const bool conv = op->Type() != G_OP_TYPE_MUL;
+    if (!Quantizable(op) ||
+        thresholds.at(op->Input(conv ? "Input" : "X")[0]) <= 0.f) {
+      ops.push_back(op);
+      continue;
+    }
+    const std::string input = op->Input(conv ? "Input" : "X")[0];
+    const std::string weight = op->Input(conv ? "Filter" : "Y")[0];
+    const std::string output = op->Output(conv ? "Output" : "Out")[0];
+    const std::string input_int8 = input + ".int8";
+    const std::string input_scale = input + ".scale";
+    const std::string output_int32 = output + ".int32";
+
+    // an activation consumed by several ops is quantized once
+    if (quantized_inputs.insert(input).second) {
+      const std::string threshold = input + ".threshold";
+      LoDTensor &tensor = tensors[threshold];
+      tensor.Resize(make_ddim({1}));
+      tensor.mutable_data<float>()[0] = thresholds.at(input);
+      block->SetVar(std::make_shared<VarDesc>(threshold, VARTYPE_TYPE_FP32,
+                                              std::vector<int64_t>{1}, true));
+      block->SetVar(std::make_shared<VarDesc>(
+          input_int8, VARTYPE_TYPE_INT8, var_dims[input], false));
+      block->SetVar(std::make_shared<VarDesc>(input_scale, VARTYPE_TYPE_FP32,
+                                              std::vector<int64_t>{1}, false));
+      auto quantize = std::make_shared<OpDesc>(G_OP_TYPE_QUANTIZE);
+      quantize->SetInputs({{"X", {input}}, {"InScale", {threshold}}});
+      quantize->SetOutputs(
+          {{"Out", {input_int8}}, {"OutScale", {input_scale}}});
+      ops.push_back(quantize);
+    }
+
+    std::vector<float> scales;
+    const Tensor *fp32_weight =
+        program_.scope->FindVar(weight)->GetMutable<LoDTensor>();
+    QuantizeWeight(*fp32_weight, conv ? 0 : 1, config_.per_channel,
+                   &tensors[weight], &scales);
+    block->SetVar(std::make_shared<VarDesc>(weight, VARTYPE_TYPE_INT8,
+                                            var_dims[weight], true));
+    block->SetVar(std::make_shared<VarDesc>(output_int32, VARTYPE_TYPE_INT32,
+                                            var_dims[output], false));
+    auto int8_op = std::make_shared<OpDesc>(*op);
+    int8_op->GetInputs()[conv ? "Input" : "X"] = {input_int8};
+    int8_op->GetOutputs()[conv ? "Output" : "Out"] = {output_int32};
+    ops.push_back(int8_op);
+
+    auto dequantize = std::make_shared<OpDesc>(G_OP_TYPE_DEQUANTIZE);
+    dequantize->SetInputs({{"X", {output_int32}}, {"Scale", {input_scale}}});
+    dequantize->SetOutputs({{"Out", {output}}});
+    AttributeMap attrs;
+    if (config_.per_channel) {
+      attrs["weight_scales"].Set<std::vector<float>>(scales);
+    } else {
+      attrs["weight_scale"].Set<float>(scales[0]);
+    }
+    dequantize->SetAttrMap(attrs);
+    ops.push_back(dequantize);
+  }
+  block->SetOps(ops);
+  WriteFile(model_path, SerializeProgram(&program));
+
+  // combined params are the persistable variables sorted by name
+  std::string params;
+  for (const auto &program_block : program.Blocks()) {
+    for (const auto &var : program_block->Vars()) {
+      if (!var->Persistable() || var->Name() == "feed" ||
+          var->Name() == "fetch") {
+        continue;
+      }
+      auto it = tensors.find(var->Name());
+      const LoDTensor *tensor =
+          it != tensors.end()
+              ? &it->second
+              : program_.scope->FindVar(var->Name())->GetMutable<LoDTensor>();
+      SerializeTensor(*tensor, var->Tensor_desc().DataType(), &params);
+    }
+  }
+  WriteFile(para_path, params);
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
+
+#endif  // PADDLE_MOBILE_CPU
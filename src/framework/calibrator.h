@@ -0,0 +1,100 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#ifdef PADDLE_MOBILE_CPU
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "framework/executor.h"
+#include "framework/program/program.h"
+#include "framework/tensor.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+enum CalibrationMethod {
+  // the max absolute value seen
+  CALIBRATION_MAX = 0,
+  // the threshold minimizing the KL divergence of the int8 distribution
+  CALIBRATION_KL = 1,
+  // the percentile of the absolute values
+  CALIBRATION_PERCENTILE = 2,
+};
+
+struct CalibrationConfig {
+  CalibrationMethod method = CALIBRATION_KL;
+  float percentile = 0.9999f;
+  // quantize the weights of every output channel with its own scale
+  bool per_channel = true;
+  int batch_size = 1;
+};
+
+// Histogram of the absolute values of an activation over all calibration
+// inputs. The bin width doubles by merging bins whenever a larger value
+// shows up, so the range needs not be known before.
+class Histogram {
+ public:
+  explicit Histogram(int bins = 2048) : counts_(bins, 0) {}
+
+  void Add(const float *data, int64_t size);
+
+  float Max() const { return max_; }
+  float KLThreshold(int levels = 128) const;
+  float PercentileThreshold(float percentile) const;
+
+ private:
+  std::vector<uint64_t> counts_;
+  float width_ = 0.f;
+  float max_ = 0.f;
+};
+
+// Calibrator runs representative inputs through the fp32 program, then
+// writes a program whose conv and fc ops run in int8: a quantize op with the
+// calibrated threshold feeds every quantized op, the weights are stored as
+// int8 and a dequantize op restores the fp32 output.
+class Calibrator {
+ public:
+  // separate format model
+  Calibrator(const std::string &dirname, const CalibrationConfig &config);
+  // combined format model
+  Calibrator(const std::string &model_path, const std::string &para_path,
+             const CalibrationConfig &config);
+
+  // predicts the input fed to "feed" and collects the activations
+  void Collect(const Tensor &input);
+
+  // writes the quantized model in combined format
+  void Save(const std::string &model_path, const std::string &para_path);
+
+  // the calibrated threshold of every quantized activation
+  std::map<std::string, float> Thresholds() const;
+
+ private:
+  void Init();
+  bool Quantizable(const std::shared_ptr<OpDesc> &op) const;
+
+  CalibrationConfig config_;
+  Program<CPU> program_;
+  std::shared_ptr<Executor<CPU>> executor_;
+  std::map<std::string, Histogram> histograms_;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
+
+#endif  // PADDLE_MOBILE_CPU
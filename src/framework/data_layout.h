@@ -17,6 +17,7 @@ limitations under the License. */
 #include <cctype>
 #include <cstdlib>
 #include <string>
+#include "common/enforce.h"
 
 namespace paddle_mobile {
 namespace framework {
@@ -25,8 +26,24 @@ enum class DataLayout {
   kNHWC = 0,
   kNCHW = 1,
   kAnyLayout = 2,
+  // channel blocked layouts, a tensor of dims [N, C, H, W] is stored as
+  // [N, ceil(C / block), H, W, block] and the padded channels are zero
+  kNCHW4 = 3,
+  kNCHW8 = 4,
 };
 
+// the channel block size of layout, 1 for the plain layouts
+inline int DataLayoutBlock(DataLayout layout) {
+  switch (layout) {
+    case DataLayout::kNCHW4:
+      return 4;
+    case DataLayout::kNCHW8:
+      return 8;
+    default:
+      return 1;
+  }
+}
+
 inline DataLayout StringToDataLayout(const std::string &str) {
   std::string s(str);
   for (size_t i = 0; i < s.size(); ++i) {
@@ -39,6 +56,10 @@ inline DataLayout StringToDataLayout(const std::string &str) {
     return DataLayout::kNCHW;
   } else if (s == "ANYLAYOUT") {
     return DataLayout::kAnyLayout;
+  } else if (s == "NCHW4") {
+    return DataLayout::kNCHW4;
+  } else if (s == "NCHW8") {
+    return DataLayout::kNCHW8;
   } else {
     PADDLE_MOBILE_THROW_EXCEPTION("Unknown storage order string: %s", s.c_str())
   }
@@ -52,6 +73,10 @@ inline std::string DataLayoutToString(const DataLayout &data_layout) {
       return "NCHW";
     case DataLayout::kAnyLayout:
       return "ANY_LAYOUT";
+    case DataLayout::kNCHW4:
+      return "NCHW4";
+    case DataLayout::kNCHW8:
+      return "NCHW8";
     default:
       PADDLE_MOBILE_THROW_EXCEPTION("Unknown storage order string ")
       break;
@@ -14,19 +14,36 @@ limitations under the License. */
 
 #include "framework/executor.h"
 #include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include "common/enforce.h"
 #include "common/log.h"
+#include "common/threadpool.h"
 #include "framework/framework.pb-c.h"
+#include "framework/graph_optimize.h"
+#include "framework/layout_optimize.h"
 #include "framework/lod_tensor.h"
+#include "framework/memory_optimize.h"
+#include "framework/model_writer.h"
 #include "framework/operator.h"
+#include "framework/profiler.h"
 #include "framework/program/program-optimize/program_optimize.h"
 #include "framework/program/program_desc.h"
 #include "framework/program/var_desc.h"
 #include "framework/scope.h"
 #include "framework/tensor.h"
 #include "memory/t_malloc.h"
+#ifdef PADDLE_MOBILE_CPU
+#include "operators/math/blocked_layout.h"
+#include "operators/math/conv_tuner.h"
+#include "operators/math/gemm_tuner.h"
+#include "operators/math/math_function.h"
+#endif
 
 #ifdef PADDLE_MOBILE_CL
 #include "framework/cl/cl_image.h"
@@ -37,17 +54,23 @@ namespace framework {
 
 #pragma mark - executor
 
+// kid scopes of a shared scope are created and deleted by different threads
+static std::mutex kid_scope_mutex;
+
 template <typename Device, typename T>
 Executor<Device, T>::Executor(const Program<Device> &program,
                               paddle_mobile::PaddleMobileConfigInternal config,
                               int batch_size, const bool use_optimize,
-                              const bool lod_mode)
+                              const bool lod_mode, ModelCache *model_cache)
     : program_(program),
       batch_size_(batch_size),
       use_optimize_(use_optimize),
       lod_mode_(lod_mode),
       config_(config) {
   DLOG << "executor in lod mode: " << lod_mode_;
+#ifdef PADDLE_MOBILE_PROFILE
+  profiler_.Enable(true);
+#endif
 
   Variable *variable_ptr = program_.scope->Var("batch_size");
   variable_ptr->SetValue<int>(batch_size);
@@ -56,6 +79,14 @@ Executor<Device, T>::Executor(const Program<Device> &program,
       use_optimize_ ? program_.optimizeProgram : program_.originProgram;
   PADDLE_MOBILE_ENFORCE(program_desc_ != nullptr,
                         "program_desc_ should not be nullptr");
+  OptimizeGraph();
+  // the blocked layouts must be known before the kernels are initialized
+  OptimizeLayout();
+  if (model_cache != nullptr && model_cache->Restored()) {
+    var_layouts_.insert(model_cache->var_layouts.begin(),
+                        model_cache->var_layouts.end());
+  }
+  InitVarLayouts();
   const auto &blocks = program_desc_->Blocks();
   ops_of_block_.resize(blocks.size());
 
@@ -78,7 +109,33 @@ Executor<Device, T>::Executor(const Program<Device> &program,
     }
   }
 
-  if (program_.combined) {
+  InitOpDAG();
+  // plan activations before allocating them, so that each planned tensor
+  // takes a sub block of the shared arena instead of its own buffer
+  OptimizeMemory();
+
+#ifdef PADDLE_MOBILE_CPU
+  if (!config_.gemm_tuning_profile.empty() &&
+      std::is_same<Device, CPU>::value) {
+    operators::math::GemmTuner::Instance()->EnableTuning(
+        config_.gemm_tuning_profile);
+  }
+  if (!config_.conv_tuning_profile.empty() &&
+      std::is_same<Device, CPU>::value) {
+    operators::math::ConvTuner::Instance()->EnableTuning(
+        config_.conv_tuning_profile);
+  }
+#endif
+
+  // ops whose kernel Init ran while their weights were streamed
+  std::unordered_set<OperatorBase<Device> *> initialized;
+  if (weights_loaded_) {
+    InitActivationMemory();
+  } else if (program_.params_reader != nullptr && model_cache == nullptr &&
+             std::is_same<Device, CPU>::value) {
+    InitActivationMemory();
+    InitStreamMemoryAndOps(&initialized);
+  } else if (program_.combined) {
     InitCombineMemory();
   } else {
     InitMemory();
@@ -89,21 +146,494 @@ Executor<Device, T>::Executor(const Program<Device> &program,
   program_.scope->print_vars();
 #endif
 
+  if (model_cache != nullptr && model_cache->Restored()) {
+    RestoreKernels(*model_cache);
+  } else if (model_cache != nullptr) {
+    CacheProgram(model_cache);
+  }
   int count = 0;
   for (int block_id = 0; block_id < ops_of_block_.size(); ++block_id) {
     for (auto &op_handler : ops_of_block_[block_id]) {
       DLOG << "Initialize op[" << count++ << "]: " << op_handler->Type();
-      op_handler->Init();
+      if (initialized.count(op_handler.get()) == 0) {
+        op_handler->Init();
+      }
       ops_list_.push_back(op_handler);
     }
   }
+  if ((config_.weight_compression ||
+       config_.weight_precision == Precision::FP16) &&
+      std::is_same<Device, CPU>::value) {
+    CompressWeights();
+  }
+  if (model_cache != nullptr && !model_cache->Restored()) {
+    CacheKernels(model_cache);
+  }
+  InitShapePlan();
+}
+
+template <typename Device, typename T>
+Executor<Device, T>::Executor(const Executor<Device, T> *shared)
+    : batch_size_(shared->batch_size_),
+      use_optimize_(shared->use_optimize_),
+      lod_mode_(shared->lod_mode_),
+      config_(shared->config_),
+      program_(shared->program_),
+      program_desc_(shared->program_desc_),
+      var_layouts_(shared->var_layouts_),
+      op_dag_(shared->op_dag_) {
+  parent_scope_ = shared->parent_scope_ != nullptr ? shared->parent_scope_
+                                                   : shared->program_.scope;
+  {
+    std::lock_guard<std::mutex> lock(kid_scope_mutex);
+    Scope *scope = &parent_scope_->NewScope();
+    // the kid is owned by the parent, only keep the parent alive
+    program_.scope = std::shared_ptr<Scope>(parent_scope_, scope);
+  }
+
+  // variables written by predict are created in the kid scope before the
+  // operators look them up, the persistable ones are found in the parent
+  const auto &blocks = program_desc_->Blocks();
+  for (const auto &block : blocks) {
+    for (const auto &var_desc : block->Vars()) {
+      if (!var_desc->Persistable() || var_desc->Name() == "feed" ||
+          var_desc->Name() == "fetch") {
+        Variable *var = program_.scope->Var(var_desc->Name());
+        // sized from the descs as the loader does, the operators infer
+        // their shapes from the feed on
+        if (var_desc->Type() == VARTYPE_TYPE_LOD_TENSOR) {
+          std::vector<int64_t> dims = var_desc->Tensor_desc().Dims();
+          for (auto &d : dims) {
+            d = d < 0 ? -d : d;
+          }
+          var->GetMutable<LoDTensor>()->Resize(
+              dims.empty() ? make_ddim({0}) : make_ddim(dims));
+        }
+      }
+    }
+  }
+  Variable *variable_ptr = program_.scope->Var("batch_size");
+  variable_ptr->SetValue<int>(batch_size_);
+  InitVarLayouts();
+
+  ops_of_block_.resize(blocks.size());
+  for (int i = 0; i < blocks.size(); ++i) {
+    for (const auto &op_desc : blocks[i]->Ops()) {
+      auto op_handler = OpRegistry<Device>::CreateOp(
+          op_desc->Type(), op_desc->GetInputs(), op_desc->GetOutputs(),
+          op_desc->GetAttrMap(), program_.scope);
+      if (!lod_mode_) {
+        op_handler->InferShape();
+      }
+      ops_of_block_[i].push_back(op_handler);
+    }
+  }
+
+  OptimizeMemory();
+  InitActivationMemory();
+
+  for (int block_id = 0; block_id < ops_of_block_.size(); ++block_id) {
+    for (int j = 0; j < ops_of_block_[block_id].size(); ++j) {
+      auto &op_handler = ops_of_block_[block_id][j];
+      op_handler->InitFrom(shared->ops_of_block_[block_id][j].get());
+      ops_list_.push_back(op_handler);
+    }
+  }
+  InitShapePlan();
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::OptimizeMemory() {
+  // plan activations before allocating them, so that each planned tensor
+  // takes a sub block of the shared arena instead of its own buffer
+  const auto &blocks = program_desc_->Blocks();
+  if (config_.memory_optimization && !lod_mode_ && blocks.size() == 1 &&
+      std::is_same<Device, CPU>::value) {
+    MemoryOptPass memory_opt_pass(op_dag_.get());
+    memory_opt_pass(blocks[0], program_.scope.get());
+  }
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::InitOpDAG() {
+  const auto &blocks = program_desc_->Blocks();
+  if (config_.inter_op_threads > 1 && blocks.size() == 1 &&
+      std::is_same<Device, CPU>::value) {
+    op_dag_ = std::make_shared<OpDAG>(blocks[0]->Ops());
+    LOG(kLOG_INFO) << "inter-op parallelism: " << op_dag_->Size()
+                   << " ops, dag width " << op_dag_->Width();
+  }
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::PrepareOpScheduler() {
+  const int inter_op_threads =
+      std::min(config_.inter_op_threads, op_dag_->Width());
+  if (inter_op_threads <= 1) {
+    op_scheduler_.reset();
+    return;
+  }
+  const int intra_op_threads =
+      std::max(ThreadPool::Instance()->ThreadNum() / inter_op_threads, 1);
+  if (op_scheduler_ == nullptr ||
+      op_scheduler_->InterOpThreads() != inter_op_threads ||
+      op_scheduler_->IntraOpThreads() != intra_op_threads) {
+    op_scheduler_.reset(
+        new OpScheduler(op_dag_.get(), inter_op_threads, intra_op_threads));
+  }
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::OptimizeGraph() {
+#ifdef PADDLE_MOBILE_CPU
+  if (config_.graph_optimization && program_desc_->Blocks().size() == 1 &&
+      std::is_same<Device, CPU>::value) {
+    // the weights are read in the order of the variables of the model, so
+    // they are loaded before the pass adds and removes variables
+    program_desc_ = std::make_shared<ProgramDesc>(*program_desc_);
+    if (program_.combined) {
+      InitCombineMemory();
+    } else {
+      InitMemory();
+    }
+    weights_loaded_ = true;
+    GraphOptPass graph_opt_pass(program_.scope);
+    graph_opt_pass(program_desc_->Block(0));
+  }
+#endif
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::OptimizeLayout() {
+#if defined(PADDLE_MOBILE_CPU) && defined(LAYOUT_TRANSFORM_OP)
+  if (config_.layout_optimization && !lod_mode_ &&
+      program_desc_->Blocks().size() == 1 &&
+      std::is_same<Device, CPU>::value) {
+    // the pass edits the block, keep the program of the loader untouched
+    program_desc_ = std::make_shared<ProgramDesc>(*program_desc_);
+    LayoutOptPass layout_opt_pass(operators::math::PreferredBlockedLayout());
+    layout_opt_pass(program_desc_->Block(0));
+    var_layouts_ = layout_opt_pass.VarLayouts();
+  }
+#endif
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::InitVarLayouts() {
+  for (const auto &var_layout : var_layouts_) {
+    auto *tensor =
+        program_.scope->Var(var_layout.first)->template GetMutable<LoDTensor>();
+    tensor->set_layout(var_layout.second);
+  }
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::InitActivationMemory() {
+  for (const auto &block : program_desc_->Blocks()) {
+    for (const auto &var_desc : block->Vars()) {
+      if (!var_desc->Persistable() &&
+          var_desc->Type() == VARTYPE_TYPE_LOD_TENSOR) {
+        auto var = program_.scope->Var(var_desc->Name());
+        varInputMemory(var_desc, var, var->template GetMutable<LoDTensor>());
+      }
+    }
+  }
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::CompressWeights() {
+#ifdef PADDLE_MOBILE_CPU
+  // a weight read by several ops is kept for the others
+  std::unordered_map<std::string, int> readers;
+  for (const auto &op_handler : ops_list_) {
+    for (const auto &var_names : op_handler->Inputs()) {
+      for (const auto &name : var_names.second) {
+        ++readers[name];
+      }
+    }
+  }
+  // weight_compression takes precedence
+  const bool to_half = !config_.weight_compression;
+  size_t packed_size = 0;
+  size_t compressed_size = 0;
+  for (const auto &op_handler : ops_list_) {
+    for (const auto &weight : op_handler->PackedWeights()) {
+      const auto &names = op_handler->Inputs().at(weight.input);
+      // a table is converted in place, so no other op may read it
+      const bool table =
+          weight.packed ==
+          program_.scope->FindVar(names[0])->template GetMutable<LoDTensor>();
+      if (table && (!to_half || readers[names[0]] > 1)) {
+        continue;
+      }
+      // restored by a model cache if it is converted already
+      if (weight.packed->type() == typeid(float)) {
+        packed_size += weight.packed->numel() * sizeof(float);
+        Tensor compressed;
+        if (to_half) {
+          operators::math::ConvertToHalf(*weight.packed, &compressed);
+        } else {
+          operators::math::CompressPackedWeight(
+              *weight.packed, weight.packed_a, weight.k, &compressed);
+        }
+        *weight.packed = compressed;
+        compressed_size += compressed.memory_size();
+      }
+      for (const auto &name : names) {
+        if (table || readers[name] > 1) {
+          continue;
+        }
+        auto *tensor =
+            program_.scope->FindVar(name)->template GetMutable<LoDTensor>();
+        // the type and the dims stay for kernel Init of the clones, reading
+        // the data fails
+        tensor->ShareExternalData(nullptr, 0, tensor->type(), nullptr);
+      }
+    }
+  }
+  if (packed_size > 0) {
+    LOG(kLOG_INFO) << "weights " << (to_half ? "stored as half" : "compressed")
+                   << " from " << packed_size << " to " << compressed_size
+                   << " bytes";
+  }
+#endif
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::CacheProgram(ModelCache *model_cache) const {
+  model_cache->program = SerializeProgram(program_desc_.get());
+  // in the order InitCombineMemory reads them
+  for (const auto &block : program_desc_->Blocks()) {
+    for (const auto &var_desc : block->Vars()) {
+      if (!var_desc->Persistable() || var_desc->Name() == "feed" ||
+          var_desc->Name() == "fetch") {
+        continue;
+      }
+      auto *tensor = program_.scope->FindVar(var_desc->Name())
+                         ->template GetMutable<LoDTensor>();
+      if (!tensor->IsInitialized()) {
+        LOG(kLOG_WARNING) << "the model can't be cached, " << var_desc->Name()
+                          << " is not loaded";
+        model_cache->program.clear();
+        return;
+      }
+      SerializeTensor(*tensor, var_desc->Tensor_desc().DataType(),
+                      &model_cache->params);
+    }
+  }
+  model_cache->var_layouts.assign(var_layouts_.begin(), var_layouts_.end());
+}
+
+template <typename Device, typename T>
+std::vector<ModelCache::KernelState> Executor<Device, T>::KernelStates() const {
+  std::vector<ModelCache::KernelState> states;
+  for (const auto &ops : ops_of_block_) {
+    for (const auto &op_handler : ops) {
+      ModelCache::KernelState state;
+      state.exec_mode = op_handler->ExecModeName();
+      for (Tensor *weight : op_handler->KernelWeights()) {
+        state.weights.push_back(weight != nullptr ? *weight : Tensor());
+      }
+      states.push_back(std::move(state));
+    }
+  }
+  return states;
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::CacheKernels(ModelCache *model_cache) const {
+  model_cache->kernels = KernelStates();
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::RestoreKernels(const ModelCache &model_cache) {
+  int count = 0;
+  for (const auto &ops : ops_of_block_) {
+    for (const auto &op_handler : ops) {
+      PADDLE_MOBILE_ENFORCE(count < model_cache.kernels.size(),
+                            "the model cache does not match the program");
+      const ModelCache::KernelState &state = model_cache.kernels[count++];
+      if (!state.exec_mode.empty()) {
+        op_handler->SetExecModeName(state.exec_mode);
+      }
+      std::vector<Tensor *> weights = op_handler->KernelWeights();
+      PADDLE_MOBILE_ENFORCE(weights.size() == state.weights.size(),
+                            "the model cache does not match the program");
+      for (int i = 0; i < weights.size(); ++i) {
+        if (weights[i] != nullptr && state.weights[i].IsInitialized()) {
+          *weights[i] = state.weights[i];
+        }
+      }
+    }
+  }
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::InitShapePlan() {
+  // the shapes of lod mode are inferred by every op in every prediction
+  if (lod_mode_ || !std::is_same<Device, CPU>::value ||
+      ops_of_block_.empty()) {
+    return;
+  }
+  for (const auto &block : program_desc_->Blocks()) {
+    for (const auto &var_desc : block->Vars()) {
+      if (!var_desc->Persistable() &&
+          var_desc->Type() == VARTYPE_TYPE_LOD_TENSOR) {
+        auto var = program_.scope->Var(var_desc->Name());
+        activations_.push_back(var->template GetMutable<LoDTensor>());
+      }
+    }
+  }
+  for (auto &op_handler : ops_of_block_[0]) {
+    if (op_handler->Type() == G_OP_TYPE_FEED) {
+      feed_ops_.push_back(op_handler);
+    }
+  }
+  shape_key_ = InputShapeKey();
+  SaveShapePlan();
+}
+
+template <typename Device, typename T>
+std::vector<int64_t> Executor<Device, T>::InputShapeKey() const {
+  std::vector<int64_t> key;
+  for (const auto &op_handler : feed_ops_) {
+    for (const auto &pair : op_handler->Outputs()) {
+      for (const auto &name : pair.second) {
+        const DDim &dims =
+            program_.scope->FindVar(name)->template Get<LoDTensor>()->dims();
+        key.push_back(dims.size());
+        for (int i = 0; i < dims.size(); ++i) {
+          key.push_back(dims[i]);
+        }
+      }
+    }
+  }
+  return key;
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::SaveShapePlan() {
+  const int max_plans = std::max(config_.max_shape_plans, 1);
+  while (static_cast<int>(shape_plans_.size()) >= max_plans) {
+    auto lru = shape_plans_.begin();
+    for (auto it = shape_plans_.begin(); it != shape_plans_.end(); ++it) {
+      if (it->second.last_used < lru->second.last_used) {
+        lru = it;
+      }
+    }
+    // the memory of the activations and the weights the kernels picked for
+    // the shape are freed with the plan
+    shape_plans_.erase(lru);
+  }
+  ShapePlan &plan = shape_plans_[shape_key_];
+  for (const LoDTensor *tensor : activations_) {
+    plan.activations.push_back(*tensor);
+  }
+  plan.kernels = KernelStates();
+  plan.last_used = ++shape_plan_clock_;
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::RestoreShapePlan(ShapePlan *plan) {
+  plan->last_used = ++shape_plan_clock_;
+  // the tensors share the memory kept by the plan
+  for (int i = 0; i < activations_.size(); ++i) {
+    *activations_[i] = plan->activations[i];
+  }
+  int count = 0;
+  for (const auto &ops : ops_of_block_) {
+    for (const auto &op_handler : ops) {
+      const ModelCache::KernelState &state = plan->kernels[count++];
+      if (state.exec_mode == op_handler->ExecModeName()) {
+        // the same weights unless the mode is picked again for every shape
+        continue;
+      }
+      op_handler->SetExecModeName(state.exec_mode);
+      std::vector<Tensor *> weights = op_handler->KernelWeights();
+      for (int i = 0; i < weights.size(); ++i) {
+        if (weights[i] != nullptr) {
+          *weights[i] = state.weights[i];
+        }
+      }
+    }
+  }
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::ReplanKernels() {
+  // the filters to pick from are freed if the weights are compressed
+  if (config_.weight_compression ||
+      config_.weight_precision == Precision::FP16) {
+    return;
+  }
+  for (auto &block : ops_of_block_) {
+    for (auto &op_handler : block) {
+      op_handler->Replan();
+    }
+  }
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::PrepareShapePlan() {
+  for (auto &op_handler : feed_ops_) {
+    op_handler->InferShape();
+  }
+  std::vector<int64_t> key = InputShapeKey();
+  if (key == shape_key_) {
+    return;
+  }
+  shape_key_ = key;
+  auto it = shape_plans_.find(key);
+  if (it != shape_plans_.end()) {
+    RestoreShapePlan(&it->second);
+    return;
+  }
+  LOG(kLOG_INFO) << "plan the activations for a new input shape";
+  for (auto &block : ops_of_block_) {
+    for (auto &op_handler : block) {
+      op_handler->InferShape();
+    }
+  }
+  OptimizeMemory();
+  InitActivationMemory();
+  ReplanKernels();
+  SaveShapePlan();
+}
+
+template <typename Device, typename T>
+Executor<Device, T>::~Executor() {
+  if (parent_scope_ != nullptr) {
+    // operators refer to the variables of the kid scope
+    ops_list_.clear();
+    ops_of_block_.clear();
+    std::lock_guard<std::mutex> lock(kid_scope_mutex);
+    parent_scope_->DeleteScope(program_.scope.get());
+  }
+}
+
+template <typename Device, typename T>
+std::shared_ptr<Executor<Device, T>> Executor<Device, T>::Clone() const {
+  PADDLE_MOBILE_ENFORCE((std::is_same<Device, CPU>::value),
+                        "only cpu executor can be cloned");
+  return std::shared_ptr<Executor<Device, T>>(new Executor<Device, T>(this));
 }
 
 template <typename T>
 static void LoadMemInternal(void **data, LoDTensor *tensor,
-                            bool quant_uint8 = false) {
+                            bool quant_uint8 = false,
+                            const std::shared_ptr<char> &mapped_data =
+                                nullptr) {
   char **data_buf = reinterpret_cast<char **>(data);
   int64_t size = tensor->numel();
+  if (!quant_uint8 && mapped_data != nullptr &&
+      reinterpret_cast<uintptr_t>(*data_buf) % sizeof(T) == 0) {
+    // refer to the mapped file directly, the pages are copied by the system
+    // only if some kernel rewrites them
+    tensor->ShareExternalData(*data_buf, size * sizeof(T), typeid(T),
+                              mapped_data);
+    *data_buf += size * sizeof(T);
+    return;
+  }
   T *tensor_data = tensor->mutable_data<T>();
   if (quant_uint8) {
     // should be moved into operator init function
@@ -125,9 +655,9 @@ static void LoadMemInternal(void **data, LoDTensor *tensor,
 }
 
 template <typename Device, typename T>
-void Executor<Device, T>::LoadMemory(void **data,
-                                     const std::shared_ptr<VarDesc> var_desc,
-                                     LoDTensor *tensor) {
+void Executor<Device, T>::LoadMemory(
+    void **data, const std::shared_ptr<VarDesc> var_desc, LoDTensor *tensor,
+    const std::shared_ptr<char> &mapped_data) {
   char **data_buf = reinterpret_cast<char **>(data);
   // version
   uint32_t version = *(reinterpret_cast<uint32_t *>(*data_buf));
@@ -163,19 +693,136 @@ void Executor<Device, T>::LoadMemory(void **data,
   switch (tensor_desc.DataType()) {
     case VARTYPE_TYPE_FP32:
       LoadMemInternal<float>(reinterpret_cast<void **>(data_buf), tensor,
-                             program_.quantification);
+                             program_.quantification, mapped_data);
       break;
     case VARTYPE_TYPE_INT8:
-      LoadMemInternal<int8_t>(reinterpret_cast<void **>(data_buf), tensor);
+      LoadMemInternal<int8_t>(reinterpret_cast<void **>(data_buf), tensor,
+                              false, mapped_data);
       break;
     case VARTYPE_TYPE_INT32:
-      LoadMemInternal<int>(reinterpret_cast<void **>(data_buf), tensor);
+      LoadMemInternal<int>(reinterpret_cast<void **>(data_buf), tensor, false,
+                           mapped_data);
       break;
     default:
       LOG(kLOG_ERROR) << "data type is not supported";
   }
 }
 
+// reads the record of a variable from the combined params to buffer, in the
+// format of LoadMemory. Only the desc of the variable tells the size of its
+// data, which follows the header.
+static void ReadParam(StreamReader *reader, const VarDesc &var_desc,
+                      bool quantification, std::vector<char> *buffer) {
+  buffer->clear();
+  auto read = [&](size_t size) {
+    const size_t offset = buffer->size();
+    buffer->resize(offset + size);
+    PADDLE_MOBILE_ENFORCE(reader->Read(buffer->data() + offset, size),
+                          "the params end before %s",
+                          var_desc.Name().c_str());
+    return buffer->data() + offset;
+  };
+  // version
+  read(sizeof(uint32_t));
+  uint64_t lod_level = 0;
+  memcpy(&lod_level, read(sizeof(uint64_t)), sizeof(uint64_t));
+  for (uint64_t i = 0; i < lod_level; ++i) {
+    uint64_t size = 0;
+    memcpy(&size, read(sizeof(uint64_t)), sizeof(uint64_t));
+    read(size);
+  }
+  // tensor version
+  read(sizeof(uint32_t));
+  int32_t tensor_desc_size = 0;
+  memcpy(&tensor_desc_size, read(sizeof(int32_t)), sizeof(int32_t));
+  read(tensor_desc_size);
+
+  const TensorDesc &tensor_desc = var_desc.Tensor_desc();
+  const size_t numel = product(make_ddim(tensor_desc.Dims()));
+  switch (tensor_desc.DataType()) {
+    case VARTYPE_TYPE_FP32:
+      // quantified as min, max and a byte per element, see LoadMemInternal
+      read(quantification ? 2 * sizeof(float) + numel : numel * sizeof(float));
+      break;
+    case VARTYPE_TYPE_INT8:
+      read(numel * sizeof(int8_t));
+      break;
+    case VARTYPE_TYPE_INT32:
+      read(numel * sizeof(int32_t));
+      break;
+    default:
+      break;
+  }
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::InitStreamMemory(
+    const std::function<void(const std::string &)> &loaded) {
+  // one record at a time, the params are never buffered whole
+  std::vector<char> buffer;
+  for (const auto &block : program_desc_->Blocks()) {
+    for (const auto &var_desc : block->Vars()) {
+      if (!var_desc->Persistable() || var_desc->Name() == "feed" ||
+          var_desc->Name() == "fetch") {
+        continue;
+      }
+      ReadParam(program_.params_reader.get(), *var_desc,
+                program_.quantification, &buffer);
+      auto *tensor = program_.scope->Var(var_desc->Name())
+                         ->template GetMutable<LoDTensor>();
+      char *data = buffer.data();
+      LoadMemory(reinterpret_cast<void **>(&data), var_desc, tensor);
+      if (loaded) {
+        loaded(var_desc->Name());
+      }
+    }
+  }
+  // stops the reader thread
+  program_.params_reader = nullptr;
+  LOG(kLOG_INFO) << "init stream memory finish";
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::InitStreamMemoryAndOps(
+    std::unordered_set<OperatorBase<Device> *> *initialized) {
+  std::unordered_set<std::string> weights;
+  for (const auto &block : program_desc_->Blocks()) {
+    for (const auto &var_desc : block->Vars()) {
+      if (var_desc->Persistable() && var_desc->Name() != "feed" &&
+          var_desc->Name() != "fetch") {
+        weights.insert(var_desc->Name());
+      }
+    }
+  }
+  // the ops of every weight and the count of unloaded weights of every op
+  std::unordered_map<std::string, std::vector<OperatorBase<Device> *>> readers;
+  std::unordered_map<OperatorBase<Device> *, int> unloaded;
+  for (const auto &block : ops_of_block_) {
+    for (const auto &op_handler : block) {
+      std::unordered_set<std::string> names;
+      for (const auto *var_map : {&op_handler->Inputs(),
+                                  &op_handler->Outputs()}) {
+        for (const auto &var_names : *var_map) {
+          for (const auto &name : var_names.second) {
+            if (weights.count(name) > 0 && names.insert(name).second) {
+              readers[name].push_back(op_handler.get());
+            }
+          }
+        }
+      }
+      unloaded[op_handler.get()] = static_cast<int>(names.size());
+    }
+  }
+  InitStreamMemory([&](const std::string &name) {
+    for (auto *op_handler : readers[name]) {
+      if (--unloaded[op_handler] == 0) {
+        op_handler->Init();
+        initialized->insert(op_handler);
+      }
+    }
+  });
+}
+
 template <typename Device, typename T>
 void Executor<Device, T>::InitMemory() {
   for (const auto &block : program_desc_->Blocks()) {
@@ -202,12 +849,23 @@ void Executor<Device, T>::InitMemory() {
 
 template <typename Device, typename T>
 void Executor<Device, T>::InitCombineMemory() {
+  if (program_.params_reader != nullptr) {
+    InitActivationMemory();
+    InitStreamMemory();
+    return;
+  }
   char *origin_data = nullptr;
   bool self_alloc = false;
+  std::shared_ptr<char> mapped_data;
   if (program_.combined_params_buf && program_.combined_params_len) {
     origin_data = reinterpret_cast<char *>(
         const_cast<uint8_t *>(program_.combined_params_buf));
-  } else {
+  } else if (config_.load_with_mmap && std::is_same<Device, CPU>::value) {
+    size_t mapped_size = 0;
+    mapped_data = MapFileToBuff(program_.para_path, &mapped_size);
+    origin_data = mapped_data.get();
+  }
+  if (origin_data == nullptr) {
     self_alloc = true;
     origin_data = ReadFileToBuff(program_.para_path);
   }
@@ -224,7 +882,8 @@ void Executor<Device, T>::InitCombineMemory() {
 
         DLOG << " init combine memory persistable: " << var_desc->Name();
 
-        LoadMemory(reinterpret_cast<void **>(&data), var_desc, tensor);
+        LoadMemory(reinterpret_cast<void **>(&data), var_desc, tensor,
+                   mapped_data);
       } else {
         if (var_desc->Type() == VARTYPE_TYPE_LOD_TENSOR) {
           DLOG << " init combine memory no persistable in lod: "
@@ -246,14 +905,14 @@ template <typename Device, typename T>
 void Executor<Device, T>::InitNoPersistableMemory(const Tensor &input_tensor) {
   for (const auto &block : program_desc_->Blocks()) {
     for (const auto &var_desc : block->Vars()) {
-      auto var = program_.scope->Var(var_desc->Name());
-      auto tensor = var->template GetMutable<LoDTensor>();
       if (var_desc->Persistable()) {
         if (var_desc->Name() == "feed" || var_desc->Name() == "fetch") {
           continue;
         }
       } else {
         if (var_desc->Type() == VARTYPE_TYPE_LOD_TENSOR) {
+          auto var = program_.scope->Var(var_desc->Name());
+          auto tensor = var->template GetMutable<LoDTensor>();
           DDim tensor_dim = tensor->dims();
           DDim new_dim =
               make_ddim({tensor_dim[0], tensor_dim[1], input_tensor.dims()[2],
@@ -344,7 +1003,8 @@ void Executor<Device, T>::SetInput(const Tensor &input,
 
   auto *target_tensor = target_var->template GetMutable<LoDTensor>();
 
-  if (config_.load_when_predict) {
+  // cpu executors plan the shapes of a new input in Predict
+  if (config_.load_when_predict && !std::is_same<Device, CPU>::value) {
     if (input_dim_last_ != input.dims()) {
       InitNoPersistableMemory(input);
       input_dim_last_ = input.dims();
@@ -363,7 +1023,8 @@ void Executor<Device, T>::SetInput(const LoDTensor &input,
                         var_name.c_str());
   auto *target_tensor = target_var->template GetMutable<LoDTensor>();
 
-  if (config_.load_when_predict) {
+  // cpu executors plan the shapes of a new input in Predict
+  if (config_.load_when_predict && !std::is_same<Device, CPU>::value) {
     if (input_dim_last_ != input.dims()) {
       InitNoPersistableMemory(*target_tensor);
       input_dim_last_ = input.dims();
@@ -375,64 +1036,109 @@ void Executor<Device, T>::SetInput(const LoDTensor &input,
   target_tensor->set_lod(input.lod());
 }
 
-template <typename Device, typename T>
-PMStatus Executor<Device, T>::Predict() {
-#ifdef PADDLE_MOBILE_PROFILE
-  std::vector<ProfInfo> profile(ops_list_.size());
-  struct timespec ts;
-  int op_index = 0;
-#endif
-  for (auto &block : ops_of_block_) {
-    for (auto &op_handler : block) {
-#ifdef PADDLE_MOBILE_PROFILE
-      clock_gettime(CLOCK_MONOTONIC, &ts);
-      profile[op_index].runBegin = (uint64_t)ts.tv_sec * 1e9 + ts.tv_nsec;
-#endif
-      if (lod_mode_) {
-        op_handler->InferShape();
+// convolutions and fully connected layers are counted as multiply-adds,
+// other operators as one operation per output element
+template <typename Device>
+static void EstimateOpCost(const OperatorBase<Device> &op, const Scope &scope,
+                           OpProfile *profile) {
+  std::map<std::string, const LoDTensor *> tensors;
+  for (int output = 0; output < 2; ++output) {
+    const VariableNameMap &var_map = output ? op.Outputs() : op.Inputs();
+    auto *dims_list = output ? &profile->output_dims : &profile->input_dims;
+    for (const auto &pair : var_map) {
+      for (const auto &name : pair.second) {
+        Variable *var = scope.FindVar(name);
+        if (var == nullptr || !var->template IsType<LoDTensor>()) {
+          continue;
+        }
+        const LoDTensor *tensor = var->template Get<LoDTensor>();
+        tensors[pair.first] = tensor;
+        dims_list->push_back(vectorize(tensor->dims()));
+        if (tensor->IsInitialized()) {
+          profile->bytes += tensor->numel() * SizeOfType(tensor->type());
+        }
+        if (output) {
+          profile->flops += tensor->numel();
+        }
       }
-      op_handler->Run();
-#ifdef PADDLE_MOBILE_PROFILE
-      clock_gettime(CLOCK_MONOTONIC, &ts);
-      profile[op_index].runEnd = (uint64_t)ts.tv_sec * 1e9 + ts.tv_nsec;
-      ++op_index;
-#endif
     }
   }
-#ifdef PADDLE_MOBILE_PROFILE
-  std::unordered_map<std::string, uint64_t> _tp;
-  for (int i = 0; i < profile.size(); i++) {
-    const auto &pInfo = profile[i];
-    uint64_t timeCost = pInfo.runEnd - pInfo.runBegin;
-    if (ops_list_[i]->Type() == "conv2d" ||
-        ops_list_[i]->Type() == "depthwise_conv2d") {
-      auto inputs = ops_list_[i]->Inputs();
-      auto *filter =
-          GetVarValue<LoDTensor>("Filter", inputs, *(program_.scope));
-      int kernel_size = filter->dims()[2];
-      _tp[ops_list_[i]->Type() + "_" + std::to_string(kernel_size)] += timeCost;
+  const LoDTensor *out = nullptr;
+  for (const char *key : {"Output", "Out", "Y"}) {
+    if (tensors.count(key)) {
+      out = tensors[key];
+      break;
+    }
+  }
+  if (out == nullptr || out->numel() == 0) {
+    return;
+  }
+  if (tensors.count("Filter") && tensors.count("Input")) {
+    const LoDTensor *filter = tensors["Filter"];
+    double filter_size = filter->numel() / filter->dims()[0];
+    if (op.Type() == G_OP_TYPE_CONV_TRANSPOSE) {
+      profile->flops = 2.0 * tensors["Input"]->numel() * filter_size;
     } else {
-      _tp[ops_list_[i]->Type()] += timeCost;
+      profile->flops = 2.0 * out->numel() * filter_size;
     }
+  } else if ((op.Type() == G_OP_TYPE_FC || op.Type() == G_OP_TYPE_MUL) &&
+             tensors.count("Y")) {
+    // y is a K x N matrix and the last dim of out is N
+    const DDim &out_dims = out->dims();
+    double k = static_cast<double>(tensors["Y"]->numel()) /
+               out_dims[out_dims.size() - 1];
+    profile->flops = 2.0 * out->numel() * k;
   }
-  printf("====================[ profile ]======================\n");
-  typedef std::pair<std::string, uint64_t> prof_t;
-  std::vector<prof_t> _tv(_tp.begin(), _tp.end());
-  uint64_t _ptotal = 0;
-  for (auto const &p : _tv) {
-    _ptotal += p.second;
+}
+
+template <typename Device, typename T>
+void Executor<Device, T>::RunOp(OperatorBase<Device> *op_handler, int op_index,
+                                int run) {
+  const bool profile = profiler_.Enabled();
+  const uint64_t begin = profile ? Profiler::Now() : 0;
+  if (lod_mode_) {
+    op_handler->InferShape();
   }
-  auto compf = [](const prof_t &a, const prof_t &b) {
-    return a.second > b.second;
-  };
-  std::sort(_tv.begin(), _tv.end(), compf);
-  _tv.push_back(std::make_pair("total", _ptotal));
-  for (auto const &p : _tv) {
-    printf("%-16s\t%-10.0f\t%-2.4f\n", p.first.c_str(),
-           static_cast<float>(p.second),
-           static_cast<float>(p.second) / _ptotal * 100.0);
-  }
-  printf("====================[---------]======================\n");
+  op_handler->Run();
+  if (profile) {
+    OpProfile op_profile;
+    op_profile.end = Profiler::Now();
+    op_profile.begin = begin;
+    op_profile.index = op_index;
+    op_profile.run = run;
+    op_profile.type = op_handler->Type();
+    op_profile.exec_mode = op_handler->ExecModeName();
+    op_profile.tid = Profiler::ThreadId();
+    EstimateOpCost(*op_handler, *program_.scope, &op_profile);
+    profiler_.Record(std::move(op_profile));
+  }
+}
+
+template <typename Device, typename T>
+PMStatus Executor<Device, T>::Predict() {
+  if (!lod_mode_ && std::is_same<Device, CPU>::value) {
+    PrepareShapePlan();
+  }
+  const int run = profiler_.Enabled() ? profiler_.BeginRun() : 0;
+  if (op_dag_ != nullptr) {
+    PrepareOpScheduler();
+  }
+  if (op_scheduler_ != nullptr) {
+    const auto &ops = ops_of_block_[0];
+    op_scheduler_->Run([&](int i) { RunOp(ops[i].get(), i, run); });
+  } else {
+    WorkspaceBinding binding(&workspace_);
+    int op_index = 0;
+    for (auto &block : ops_of_block_) {
+      for (auto &op_handler : block) {
+        RunOp(op_handler.get(), op_index++, run);
+      }
+    }
+  }
+#ifdef PADDLE_MOBILE_PROFILE
+  // print the profile of every prediction as before
+  printf("%s", profiler_.Summary().c_str());
+  profiler_.Clear();
 #endif
   return PMSuccess;
 }
@@ -14,17 +14,26 @@ limitations under the License. */
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include "common/types.h"
 #include "common/util.h"
+#include "framework/data_layout.h"
 #include "framework/lod_tensor.h"
+#include "framework/op_dag.h"
+#include "framework/op_scheduler.h"
 #include "framework/operator.h"
+#include "framework/model_cache.h"
+#include "framework/profiler.h"
 #include "framework/program/program.h"
 #include "framework/tensor.h"
+#include "framework/workspace.h"
 
 namespace paddle_mobile {
 namespace framework {
@@ -32,9 +41,21 @@ namespace framework {
 template <typename Device, typename T = float>
 class Executor {
  public:
+  // If model_cache is read, the program of the loader is the optimized one
+  // of the cache and the kernels are restored from it before Init. If it is
+  // empty, the optimized program, its weights and the kernel weights are
+  // recorded into it.
   Executor(const Program<Device> &program,
            paddle_mobile::PaddleMobileConfigInternal config, int batch_size = 1,
-           const bool use_optimize = true, const bool lod_mode = false);
+           const bool use_optimize = true, const bool lod_mode = false,
+           ModelCache *model_cache = nullptr);
+  ~Executor();
+
+  // Create an execution context of the same program. It shares all the
+  // persistable variables and the weights packed by kernels with this
+  // executor, and only owns its activations and kernel workspaces, so
+  // contexts can predict in different threads at the same time.
+  std::shared_ptr<Executor<Device, T>> Clone() const;
 
   PMStatus Predict(const std::vector<std::pair<std::string, Tensor>> &inputs);
   PMStatus Predict(
@@ -49,6 +70,9 @@ class Executor {
 
   std::shared_ptr<LoDTensor> GetOutput(const std::string &var_name);
 
+  // operator profiles of the predictions, disabled by default
+  Profiler *GetProfiler() { return &profiler_; }
+
 #ifdef PADDLE_MOBILE_FPGA
   void InjectVariable(const Tensor &t, std::string var_name);
   void FeedData(const Tensor &t);
@@ -62,14 +86,70 @@ class Executor {
 
  protected:
   Executor() = default;
+  explicit Executor(const Executor<Device, T> *shared);
 
   bool varInputMemory(const std::shared_ptr<VarDesc> &var_desc, Variable *var,
                       LoDTensor *tensor) const;
   void InitMemory();
   void InitCombineMemory();
+  // loads the persistable variables from program_.params_reader, calling
+  // loaded with the name of each once its tensor is complete
+  void InitStreamMemory(
+      const std::function<void(const std::string &)> &loaded = nullptr);
+  // streams the weights and initializes every op as soon as the weights it
+  // reads are loaded, so that the kernel transforms overlap with the reads
+  void InitStreamMemoryAndOps(
+      std::unordered_set<OperatorBase<Device> *> *initialized);
   void InitNoPersistableMemory(const Tensor &input_tensor);
+  void OptimizeMemory();
+  // rewrites the program with the weights, which are loaded before that
+  void OptimizeGraph();
+  // builds the op dag of the block if independent ops may run concurrently
+  void InitOpDAG();
+  // divides the threads of the pool between the ops running at once, they
+  // may have changed since the last prediction
+  void PrepareOpScheduler();
+  void RunOp(OperatorBase<Device> *op_handler, int op_index, int run);
+  // rewrites the program to run supported ops on a blocked layout
+  void OptimizeLayout();
+  // sets the layouts picked by OptimizeLayout on the scope tensors
+  void InitVarLayouts();
+  // allocates the non-persistable tensors for their inferred shapes
+  void InitActivationMemory();
+  // records the program and the weights before kernel Init changes them
+  void CacheProgram(ModelCache *model_cache) const;
+  // compresses the weights the kernels packed for the gemm or stores them
+  // as half and frees the float weights they were packed from, see
+  // PaddleMobileConfigInternal::weight_compression and weight_precision
+  void CompressWeights();
+  // the exec modes and the kernel weights of the ops of all blocks, in order
+  std::vector<ModelCache::KernelState> KernelStates() const;
+  // records the exec modes and the kernel weights after Init
+  void CacheKernels(ModelCache *model_cache) const;
+  void RestoreKernels(const ModelCache &model_cache);
+
+  // Shapes and memory of the activations are planned once for every input
+  // shape, and the kernels pick their implementations for it again.
+  // Switching to a planned shape restores the tensors and the kernel states
+  // from the plan, only a new shape infers the shapes of all ops, allocates
+  // and picks again. The least recently used plan is dropped for a new one
+  // once there are config_.max_shape_plans.
+  struct ShapePlan {
+    // heads of the activation tensors
+    std::vector<LoDTensor> activations;
+    std::vector<ModelCache::KernelState> kernels;
+    uint64_t last_used = 0;
+  };
+  void InitShapePlan();
+  std::vector<int64_t> InputShapeKey() const;
+  void SaveShapePlan();
+  void RestoreShapePlan(ShapePlan *plan);
+  // see OperatorBase::Replan
+  void ReplanKernels();
+  void PrepareShapePlan();
   void LoadMemory(void **data, const std::shared_ptr<VarDesc> var_desc,
-                  LoDTensor *tensor);
+                  LoDTensor *tensor,
+                  const std::shared_ptr<char> &mapped_data = nullptr);
 #ifdef PADDLE_MOBILE_CL
   void LoadMemory(const VarDesc var_desc, float *tensorInput, char **data);
 #endif
@@ -80,14 +160,37 @@ class Executor {
   PaddleMobileConfigInternal config_;
   Program<Device> program_;
   std::shared_ptr<ProgramDesc> program_desc_;
+  // blocked layouts of the variables added by OptimizeLayout
+  std::unordered_map<std::string, DataLayout> var_layouts_;
+  // set if OptimizeGraph loaded the weights before the ops are created
+  bool weights_loaded_ = false;
+  // dependencies of the ops of block 0, only set for inter-op parallelism
+  std::shared_ptr<OpDAG> op_dag_;
+  std::unique_ptr<OpScheduler> op_scheduler_;
+  // scratch memory of the kernels when the ops run one after another on the
+  // thread calling Predict, the op scheduler has one for each of its threads
+  Workspace workspace_;
   typedef std::shared_ptr<OperatorBase<Device>> OperatorBasePtr;
   std::vector<std::vector<OperatorBasePtr>> ops_of_block_;
   // operators list
   std::vector<OperatorBasePtr> ops_list_;
+  // the scope of persistable variables if this executor is a context created
+  // by Clone, program_.scope is a kid scope of it
+  std::shared_ptr<Scope> parent_scope_;
 
   // for super resoltion
   DDim input_dim_last_;
 
+  Profiler profiler_;
+
+  std::vector<OperatorBasePtr> feed_ops_;
+  std::vector<LoDTensor *> activations_;
+  // dims of all the feed outputs of the current plan
+  std::vector<int64_t> shape_key_;
+  std::map<std::vector<int64_t>, ShapePlan> shape_plans_;
+  // counts the plans used, orders them for the least recently used
+  uint64_t shape_plan_clock_ = 0;
+
 #ifdef PADDLE_MOBILE_PROFILE
   struct ProfInfo {
     int tid = 0;
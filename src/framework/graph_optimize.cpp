@@ -0,0 +1,855 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "framework/graph_optimize.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <utility>
+#include "common/enforce.h"
+#include "common/log.h"
+#include "common/types.h"
+#include "framework/op_registry.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// the arguments of a parameter, none if the op has no such parameter
+static const std::vector<std::string> &Args(const VariableNameMap &map,
+                                            const std::string &parameter) {
+  static const std::vector<std::string> none;
+  auto it = map.find(parameter);
+  return it == map.end() ? none : it->second;
+}
+
+static const std::string &Arg(const VariableNameMap &map,
+                              const std::string &parameter) {
+  static const std::string none;
+  const std::vector<std::string> &args = Args(map, parameter);
+  return args.size() == 1 ? args[0] : none;
+}
+
+template <typename T>
+static T AttrOr(const std::shared_ptr<OpDesc> &op, const std::string &name,
+                T value) {
+  const AttributeMap &attrs = op->GetAttrMap();
+  return attrs.count(name) ? attrs.at(name).Get<T>() : value;
+}
+
+template <>
+std::string AttrOr<std::string>(const std::shared_ptr<OpDesc> &op,
+                                const std::string &name, std::string value) {
+  const AttributeMap &attrs = op->GetAttrMap();
+  return attrs.count(name) ? attrs.at(name).GetString() : value;
+}
+
+int Pattern::AddNode(const std::vector<std::string> &types,
+                     Condition condition) {
+  nodes_.push_back({types, condition});
+  return static_cast<int>(nodes_.size()) - 1;
+}
+
+void Pattern::AddEdge(int from, const std::string &output, int to,
+                      const std::string &input, bool is_private) {
+  PADDLE_MOBILE_ENFORCE(from != to && from >= 0 && to >= 0 &&
+                            from < nodes_.size() && to < nodes_.size(),
+                        "invalid pattern edge from %d to %d", from, to);
+  edges_.push_back({from, output, to, input, is_private});
+}
+
+OpGraph::OpGraph(const std::vector<std::shared_ptr<OpDesc>> &ops)
+    : ops_(ops) {
+  for (int i = 0; i < ops_.size(); ++i) {
+    for (const auto &input : ops_[i]->GetInputs()) {
+      for (const auto &name : input.second) {
+        std::vector<int> &consumers = consumers_[name];
+        if (consumers.empty() || consumers.back() != i) {
+          consumers.push_back(i);
+        }
+      }
+    }
+    for (const auto &output : ops_[i]->GetOutputs()) {
+      for (const auto &name : output.second) {
+        std::vector<int> &producers = producers_[name];
+        if (producers.empty() || producers.back() != i) {
+          producers.push_back(i);
+        }
+      }
+    }
+  }
+}
+
+const std::vector<int> &OpGraph::Producers(const std::string &name) const {
+  auto it = producers_.find(name);
+  return it == producers_.end() ? none_ : it->second;
+}
+
+const std::vector<int> &OpGraph::Consumers(const std::string &name) const {
+  auto it = consumers_.find(name);
+  return it == consumers_.end() ? none_ : it->second;
+}
+
+bool OpGraph::NodeMatches(const Pattern::Node &node, int op) const {
+  const std::string &type = ops_[op]->Type();
+  if (!node.types.empty() &&
+      std::find(node.types.begin(), node.types.end(), type) ==
+          node.types.end()) {
+    return false;
+  }
+  return node.condition == nullptr || node.condition(ops_[op]);
+}
+
+bool OpGraph::EdgeHolds(const Pattern::Edge &edge,
+                        const std::vector<int> &match) const {
+  const auto &outputs = Args(ops_[match[edge.from]]->GetOutputs(),
+                             edge.output);
+  const auto &inputs = Args(ops_[match[edge.to]]->GetInputs(), edge.input);
+  for (const auto &name : outputs) {
+    if (std::find(inputs.begin(), inputs.end(), name) == inputs.end()) {
+      continue;
+    }
+    if (!edge.is_private) {
+      return true;
+    }
+    const std::vector<int> &consumers = Consumers(name);
+    if (Producers(name).size() == 1 &&
+        std::all_of(consumers.begin(), consumers.end(), [&](int op) {
+          return std::find(match.begin(), match.end(), op) != match.end();
+        })) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool OpGraph::Extend(
+    const Pattern &pattern, std::vector<int> *match,
+    const std::function<bool(const std::vector<int> &)> &visit) const {
+  const int node = static_cast<int>(match->size());
+  if (node == pattern.nodes_.size()) {
+    return visit(*match);
+  }
+  // the candidates are the ops connected to a matched node by one edge,
+  // all the edges between the matched nodes are checked after that
+  std::vector<int> candidates;
+  bool connected = false;
+  for (const auto &edge : pattern.edges_) {
+    if (edge.to == node && edge.from < node) {
+      const auto &op = ops_[(*match)[edge.from]];
+      for (const auto &name : Args(op->GetOutputs(), edge.output)) {
+        const std::vector<int> &consumers = Consumers(name);
+        candidates.insert(candidates.end(), consumers.begin(),
+                          consumers.end());
+      }
+    } else if (edge.from == node && edge.to < node) {
+      const auto &op = ops_[(*match)[edge.to]];
+      for (const auto &name : Args(op->GetInputs(), edge.input)) {
+        const std::vector<int> &producers = Producers(name);
+        candidates.insert(candidates.end(), producers.begin(),
+                          producers.end());
+      }
+    } else {
+      continue;
+    }
+    connected = true;
+    break;
+  }
+  PADDLE_MOBILE_ENFORCE(connected,
+                        "pattern node %d is not connected to an earlier node",
+                        node);
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
+  for (int op : candidates) {
+    if (std::find(match->begin(), match->end(), op) != match->end() ||
+        !NodeMatches(pattern.nodes_[node], op)) {
+      continue;
+    }
+    match->push_back(op);
+    bool holds = true;
+    for (const auto &edge : pattern.edges_) {
+      if (std::max(edge.from, edge.to) == node && !EdgeHolds(edge, *match)) {
+        holds = false;
+        break;
+      }
+    }
+    if (holds && Extend(pattern, match, visit)) {
+      return true;
+    }
+    match->pop_back();
+  }
+  return false;
+}
+
+bool OpGraph::Match(
+    const Pattern &pattern,
+    const std::function<bool(const std::vector<int> &)> &visit) const {
+  if (pattern.nodes_.empty()) {
+    return false;
+  }
+  std::vector<int> match;
+  for (int i = 0; i < ops_.size(); ++i) {
+    if (!NodeMatches(pattern.nodes_[0], i)) {
+      continue;
+    }
+    match.assign(1, i);
+    if (Extend(pattern, &match, visit)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// the convs folding an affine map after them, with their output parameter
+static const std::vector<std::string> kConvs = {G_OP_TYPE_CONV,
+                                                G_OP_TYPE_DEPTHWISE_CONV};
+static const std::vector<std::string> kConvAdds = {
+    G_OP_TYPE_FUSION_CONV_ADD, G_OP_TYPE_FUSION_CONV_ADD_RELU};
+// the convs with a batch norm and the parameter of their output
+static const std::vector<std::pair<std::string, std::string>> kConvBNs = {
+    {G_OP_TYPE_FUSION_CONV_BN, "Y"},
+    {G_OP_TYPE_FUSION_CONV_BN_RELU, "Out"},
+    {G_OP_TYPE_FUSION_DWCONV_BN_RELU, "Out"},
+    {G_OP_TYPE_FUSION_CONV_ADD_BN, "Y"},
+    {G_OP_TYPE_FUSION_CONV_ADD_BN_RELU, "Out"}};
+
+static bool HasRelu(const std::string &type) {
+  return type.size() > 5 && type.compare(type.size() - 5, 5, "_relu") == 0;
+}
+
+// a fusion_conv_add applying an activation or adding a residual, see
+// FusionConvAddParam
+static bool HasEpilogue(const std::shared_ptr<OpDesc> &op) {
+  return !AttrOr<std::string>(op, "fuse_activation", "").empty() ||
+         !Args(op->GetInputs(), "ResidualData").empty();
+}
+
+// ops which must run in every prediction even if their inputs are constant
+static const std::unordered_set<std::string> kNotFoldable = {
+    G_OP_TYPE_FEED, G_OP_TYPE_FETCH, G_OP_TYPE_INCREMENT,
+    G_OP_TYPE_WRITE_TO_ARRAY, G_OP_TYPE_READ_FROM_ARRAY};
+
+GraphOptPass::GraphOptPass(std::shared_ptr<Scope> scope) : scope_(scope) {
+  AddRules();
+}
+
+void GraphOptPass::AddRule(const std::string &name, const Pattern &pattern,
+                           Rewrite rewrite, bool folds_weights) {
+  rules_.push_back({name, pattern, rewrite, folds_weights});
+}
+
+bool GraphOptPass::IsPersistable(const std::string &name) const {
+  auto it = var_descs_.find(name);
+  return it != var_descs_.end() && it->second->Persistable();
+}
+
+std::vector<int64_t> GraphOptPass::Dims(const std::string &name) const {
+  auto it = var_descs_.find(name);
+  return it == var_descs_.end() ? std::vector<int64_t>()
+                                : it->second->Tensor_desc().Dims();
+}
+
+LoDTensor *GraphOptPass::Weight(const std::string &name) const {
+  if (scope_ == nullptr || !IsPersistable(name) ||
+      var_descs_.at(name)->Tensor_desc().DataType() != VARTYPE_TYPE_FP32) {
+    return nullptr;
+  }
+  Variable *var = scope_->FindVar(name);
+  if (var == nullptr || !var->template IsType<LoDTensor>()) {
+    return nullptr;
+  }
+  LoDTensor *tensor = var->template GetMutable<LoDTensor>();
+  return tensor->IsInitialized() && tensor->type() == typeid(float) &&
+                 tensor->numel() > 0
+             ? tensor
+             : nullptr;
+}
+
+LoDTensor *GraphOptPass::NewWeight(const std::string &prefix,
+                                   const std::vector<int64_t> &dims,
+                                   std::string *name) {
+  *name = prefix + ".folded";
+  for (int i = 1; var_descs_.count(*name); ++i) {
+    *name = prefix + ".folded" + std::to_string(i);
+  }
+  auto var_desc =
+      std::make_shared<VarDesc>(*name, VARTYPE_TYPE_FP32, dims, true);
+  block_->SetVar(var_desc);
+  var_descs_[*name] = var_desc;
+  LoDTensor *tensor = scope_->Var(*name)->template GetMutable<LoDTensor>();
+  tensor->mutable_data<float>(make_ddim(dims));
+  return tensor;
+}
+
+bool GraphOptPass::FoldConstant(const std::shared_ptr<OpDesc> &op) {
+#ifdef PADDLE_MOBILE_CPU
+  try {
+    auto op_handler = OpRegistry<CPU>::CreateOp(
+        op->Type(), op->GetInputs(), op->GetOutputs(), op->GetAttrMap(),
+        scope_);
+    op_handler->InferShape();
+    op_handler->Init();
+    op_handler->Run();
+  } catch (...) {
+    // the op is kept to run in the prediction
+    return false;
+  }
+  for (const auto &output : op->GetOutputs()) {
+    for (const auto &name : output.second) {
+      var_descs_[name]->SetPersistable(true);
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool GraphOptPass::BatchNormAffine(const std::shared_ptr<OpDesc> &op,
+                                   std::vector<float> *scale,
+                                   std::vector<float> *shift) {
+  const auto &inputs = op->GetInputs();
+  const LoDTensor *gamma = Weight(Arg(inputs, "Scale"));
+  const LoDTensor *beta = Weight(Arg(inputs, "Bias"));
+  const LoDTensor *mean = Weight(Arg(inputs, "Mean"));
+  const LoDTensor *variance = Weight(Arg(inputs, "Variance"));
+  if (gamma == nullptr || beta == nullptr || mean == nullptr ||
+      variance == nullptr || beta->numel() != gamma->numel() ||
+      mean->numel() != gamma->numel() ||
+      variance->numel() != gamma->numel()) {
+    return false;
+  }
+  const float epsilon = AttrOr<float>(op, "epsilon", 1e-5f);
+  const int channels = static_cast<int>(gamma->numel());
+  scale->resize(channels);
+  shift->resize(channels);
+  for (int c = 0; c < channels; ++c) {
+    const float inv_std =
+        1.f / std::sqrt(variance->data<float>()[c] + epsilon);
+    (*scale)[c] = gamma->data<float>()[c] * inv_std;
+    (*shift)[c] =
+        beta->data<float>()[c] - mean->data<float>()[c] * (*scale)[c];
+  }
+  return true;
+}
+
+bool GraphOptPass::FoldAffine(const std::shared_ptr<OpDesc> &conv,
+                              const std::vector<float> &scale,
+                              const std::vector<float> &shift, bool relu,
+                              const std::string &output,
+                              Replacement *replacement) {
+  if (HasEpilogue(conv)) {
+    return false;
+  }
+  const auto &inputs = conv->GetInputs();
+  const std::string &filter_name = Arg(inputs, "Filter");
+  const LoDTensor *filter = Weight(filter_name);
+  if (filter == nullptr || filter->dims().size() != 4) {
+    return false;
+  }
+  const int channels = static_cast<int>(filter->dims()[0]);
+  if (scale.size() != channels ||
+      (!shift.empty() && shift.size() != channels)) {
+    return false;
+  }
+  const int64_t filter_size = filter->numel() / channels;
+  const float *bias = nullptr;
+  if (!Args(inputs, "Y").empty()) {
+    const LoDTensor *y = Weight(Arg(inputs, "Y"));
+    if (y == nullptr || y->numel() != channels ||
+        AttrOr<int>(conv, "axis", 1) != 1) {
+      return false;
+    }
+    bias = y->data<float>();
+  }
+#ifndef FUSION_CONVADD_OP
+  if (!relu) {
+    return false;
+  }
+#endif
+#ifndef FUSION_CONVADDRELU_OP
+  if (relu) {
+    return false;
+  }
+#endif
+
+  std::string new_filter_name, new_bias_name;
+  LoDTensor *new_filter = NewWeight(
+      filter_name, framework::vectorize(filter->dims()), &new_filter_name);
+  LoDTensor *new_bias = NewWeight(filter_name + ".bias", {channels},
+                                  &new_bias_name);
+  const float *w = filter->data<float>();
+  float *new_w = new_filter->data<float>();
+  float *new_b = new_bias->data<float>();
+  for (int c = 0; c < channels; ++c) {
+    for (int64_t i = 0; i < filter_size; ++i) {
+      new_w[c * filter_size + i] = w[c * filter_size + i] * scale[c];
+    }
+    new_b[c] = (bias != nullptr ? bias[c] * scale[c] : 0.f) +
+               (shift.empty() ? 0.f : shift[c]);
+  }
+
+  auto op = std::make_shared<OpDesc>(relu ? G_OP_TYPE_FUSION_CONV_ADD_RELU
+                                          : G_OP_TYPE_FUSION_CONV_ADD);
+  op->SetInputs({{"Input", Args(inputs, "Input")},
+                 {"Filter", {new_filter_name}},
+                 {"Y", {new_bias_name}}});
+  op->SetOutputs({{"Out", {output}}});
+  AttributeMap attrs;
+  for (const char *name : {"strides", "paddings", "dilations", "groups"}) {
+    attrs[name] = conv->GetAttrMap().at(name);
+  }
+  attrs["axis"].Set<int>(1);
+  op->SetAttrMap(attrs);
+  replacement->ops.push_back(op);
+  return true;
+}
+
+void GraphOptPass::AddRules() {
+  // ops of constant inputs run once at load, their outputs become weights
+  {
+    Pattern pattern;
+    pattern.AddNode({}, [this](const std::shared_ptr<OpDesc> &op) {
+      if (kNotFoldable.count(op->Type()) || op->GetOutputs().empty()) {
+        return false;
+      }
+      for (const auto &input : op->GetInputs()) {
+        for (const auto &name : input.second) {
+          if (!IsPersistable(name) ||
+              var_descs_.at(name)->Type() != VARTYPE_TYPE_LOD_TENSOR) {
+            return false;
+          }
+        }
+      }
+      for (const auto &output : op->GetOutputs()) {
+        for (const auto &name : output.second) {
+          if (!var_descs_.count(name) || IsPersistable(name) ||
+              var_descs_.at(name)->Type() != VARTYPE_TYPE_LOD_TENSOR) {
+            return false;
+          }
+        }
+      }
+      return true;
+    });
+    AddRule("fold_constants", pattern,
+            [this](const OpGraph &graph, const std::vector<int> &match,
+                   Replacement *replacement) {
+              const auto &op = graph.Op(match[0]);
+              for (const auto &output : op->GetOutputs()) {
+                for (const auto &name : output.second) {
+                  if (graph.Producers(name).size() != 1) {
+                    return false;
+                  }
+                }
+              }
+              return FoldConstant(op);
+            },
+            true);
+  }
+
+  // dropout of the inference keeps x unless it downgrades it by 1 - p
+  {
+    Pattern pattern;
+    pattern.AddNode({G_OP_TYPE_DROPOUT}, [](const std::shared_ptr<OpDesc> &op) {
+      return AttrOr<float>(op, "dropout_prob", 0.f) == 0.f ||
+             AttrOr<std::string>(op, "dropout_implementation", "") ==
+                 "upscale_in_train";
+    });
+    AddRule("remove_dropout", pattern,
+            [](const OpGraph &graph, const std::vector<int> &match,
+               Replacement *replacement) {
+              const auto &op = graph.Op(match[0]);
+              const std::string &x = Arg(op->GetInputs(), "X");
+              const std::string &out = Arg(op->GetOutputs(), "Out");
+              // an output read by nobody may be fetched by its name
+              if (x.empty() || out.empty() || x == out ||
+                  graph.Producers(x).size() > 1 ||
+                  graph.Producers(out).size() != 1 ||
+                  graph.Consumers(out).empty()) {
+                return false;
+              }
+              replacement->renames[out] = x;
+              return true;
+            });
+  }
+
+  // zero padding before a conv is done by the conv itself
+  {
+    Pattern pattern;
+    int pad = pattern.AddNode({G_OP_TYPE_PAD2D});
+    std::vector<std::string> convs = kConvs;
+    convs.insert(convs.end(), kConvAdds.begin(), kConvAdds.end());
+    for (const auto &conv_bn : kConvBNs) {
+      convs.push_back(conv_bn.first);
+    }
+    int conv = pattern.AddNode(convs);
+    pattern.AddEdge(pad, "Out", conv, "Input");
+    AddRule("fold_pad2d", pattern,
+            [](const OpGraph &graph, const std::vector<int> &match,
+               Replacement *replacement) {
+              const auto &pad = graph.Op(match[0]);
+              const std::vector<int> pads =
+                  AttrOr<std::vector<int>>(pad, "paddings", {});
+              const std::vector<int> conv_pads = AttrOr<std::vector<int>>(
+                  graph.Op(match[1]), "paddings", {});
+              // the paddings of pad2d are top, bottom, left and right
+              if (pads.size() != 4 || pads[0] != pads[1] ||
+                  pads[2] != pads[3] || conv_pads.size() != 2 ||
+                  AttrOr<std::string>(pad, "mode", "") != "constant" ||
+                  AttrOr<float>(pad, "pad_value", 0.f) != 0.f) {
+                return false;
+              }
+              auto conv = std::make_shared<OpDesc>(*graph.Op(match[1]));
+              conv->GetInputs()["Input"] = pad->GetInputs()["X"];
+              conv->GetAttrMap()["paddings"].Set<std::vector<int>>(
+                  std::vector<int>({conv_pads[0] + pads[0],
+                                    conv_pads[1] + pads[2]}));
+              replacement->ops.push_back(conv);
+              return true;
+            });
+  }
+
+#ifdef FUSION_CONVADD_OP
+  // the bias of a conv is added by the conv
+  {
+    Pattern pattern;
+    int conv = pattern.AddNode(kConvs);
+    int add = pattern.AddNode({G_OP_TYPE_ELEMENTWISE_ADD});
+    pattern.AddEdge(conv, "Output", add, "X");
+    AddRule("fuse_conv_bias", pattern,
+            [this](const OpGraph &graph, const std::vector<int> &match,
+                   Replacement *replacement) {
+              const auto &conv = graph.Op(match[0]);
+              const auto &add = graph.Op(match[1]);
+              const std::vector<int64_t> filter =
+                  Dims(Arg(conv->GetInputs(), "Filter"));
+              const std::string &y = Arg(add->GetInputs(), "Y");
+              if (!IsPersistable(y) || filter.size() != 4 ||
+                  Dims(y) != std::vector<int64_t>({filter[0]}) ||
+                  AttrOr<int>(add, "axis", -1) != 1) {
+                return false;
+              }
+              auto op = std::make_shared<OpDesc>(G_OP_TYPE_FUSION_CONV_ADD);
+              op->SetInputs({{"Input", conv->GetInputs()["Input"]},
+                             {"Filter", conv->GetInputs()["Filter"]},
+                             {"Y", {y}}});
+              op->SetOutputs({{"Out", add->GetOutputs()["Out"]}});
+              AttributeMap attrs = conv->GetAttrMap();
+              attrs["axis"].Set<int>(1);
+              op->SetAttrMap(attrs);
+              replacement->ops.push_back(op);
+              return true;
+            });
+  }
+#endif
+
+  // a batch norm after a conv scales the filter and shifts the bias
+  for (const auto &source : {std::make_pair(kConvs, "Output"),
+                             std::make_pair(kConvAdds, "Out")}) {
+    Pattern pattern;
+    int conv = pattern.AddNode(source.first);
+    int batch_norm = pattern.AddNode({G_OP_TYPE_BATCHNORM});
+    pattern.AddEdge(conv, source.second, batch_norm, "X");
+    AddRule("fold_batch_norm", pattern,
+            [this](const OpGraph &graph, const std::vector<int> &match,
+                   Replacement *replacement) {
+              const auto &batch_norm = graph.Op(match[1]);
+              std::vector<float> scale, shift;
+              return !HasRelu(graph.Op(match[0])->Type()) &&
+                     BatchNormAffine(batch_norm, &scale, &shift) &&
+                     FoldAffine(graph.Op(match[0]), scale, shift, false,
+                                Arg(batch_norm->GetOutputs(), "Y"),
+                                replacement);
+            },
+            true);
+  }
+  {
+    Pattern pattern;
+    std::vector<std::string> types;
+    for (const auto &conv_bn : kConvBNs) {
+      types.push_back(conv_bn.first);
+    }
+    pattern.AddNode(types);
+    AddRule("fold_batch_norm", pattern,
+            [this](const OpGraph &graph, const std::vector<int> &match,
+                   Replacement *replacement) {
+              const auto &conv = graph.Op(match[0]);
+              const std::string &output = std::find_if(
+                  kConvBNs.begin(), kConvBNs.end(),
+                  [&](const std::pair<std::string, std::string> &conv_bn) {
+                    return conv_bn.first == conv->Type();
+                  })->second;
+              std::vector<float> scale, shift;
+              return BatchNormAffine(conv, &scale, &shift) &&
+                     FoldAffine(conv, scale, shift, HasRelu(conv->Type()),
+                                Arg(conv->GetOutputs(), output),
+                                replacement);
+            },
+            true);
+  }
+
+  // a scale per channel after a conv, such as the dropout downgrading its
+  // input, scales the filter and the bias
+  for (const auto &source : {std::make_pair(kConvs, "Output"),
+                             std::make_pair(kConvAdds, "Out")}) {
+    Pattern pattern;
+    int conv = pattern.AddNode(source.first);
+    int scale = pattern.AddNode({G_OP_TYPE_DROPOUT, G_OP_TYPE_ELEMENTWISE_MUL});
+    pattern.AddEdge(conv, source.second, scale, "X");
+    AddRule("fold_scale", pattern,
+            [this](const OpGraph &graph, const std::vector<int> &match,
+                   Replacement *replacement) {
+              const auto &conv = graph.Op(match[0]);
+              const auto &op = graph.Op(match[1]);
+              const LoDTensor *filter =
+                  Weight(Arg(conv->GetInputs(), "Filter"));
+              if (filter == nullptr || filter->dims().size() != 4) {
+                return false;
+              }
+              std::vector<float> scale(filter->dims()[0]);
+              if (op->Type() == G_OP_TYPE_DROPOUT) {
+                if (AttrOr<std::string>(op, "dropout_implementation", "") ==
+                    "upscale_in_train") {
+                  return false;
+                }
+                std::fill(scale.begin(), scale.end(),
+                          1.f - AttrOr<float>(op, "dropout_prob", 0.f));
+              } else {
+                const LoDTensor *y = Weight(Arg(op->GetInputs(), "Y"));
+                if (y == nullptr || y->dims().size() != 1 ||
+                    y->numel() != scale.size() ||
+                    AttrOr<int>(op, "axis", -1) != 1) {
+                  return false;
+                }
+                std::copy(y->data<float>(), y->data<float>() + y->numel(),
+                          scale.begin());
+              }
+              // relu(x) * s = relu(x * s) only for s >= 0
+              const bool relu = HasRelu(conv->Type());
+              if (relu && std::any_of(scale.begin(), scale.end(),
+                                      [](float s) { return s < 0; })) {
+                return false;
+              }
+              return FoldAffine(conv, scale, {}, relu,
+                                Arg(op->GetOutputs(), "Out"), replacement);
+            },
+            true);
+  }
+
+#ifdef FUSION_CONVADD_OP
+  // an add of the conv output and another activation of the same dims, such
+  // as the shortcut of a residual block, is added by the conv
+  for (const char *input : {"X", "Y"}) {
+    Pattern pattern;
+    int conv = pattern.AddNode({G_OP_TYPE_FUSION_CONV_ADD},
+                               [](const std::shared_ptr<OpDesc> &op) {
+                                 return !HasEpilogue(op);
+                               });
+    int add = pattern.AddNode({G_OP_TYPE_ELEMENTWISE_ADD});
+    pattern.AddEdge(conv, "Out", add, input);
+    AddRule("fuse_conv_residual", pattern,
+            [this, input](const OpGraph &graph, const std::vector<int> &match,
+                          Replacement *replacement) {
+              const auto &conv = graph.Op(match[0]);
+              const auto &add = graph.Op(match[1]);
+              const std::string &out = Arg(conv->GetOutputs(), "Out");
+              const std::string &residual =
+                  Arg(add->GetInputs(), std::string(input) == "X" ? "Y" : "X");
+              const std::vector<int64_t> dims = Dims(out);
+              if (residual.empty() || residual == out ||
+                  IsPersistable(residual) || dims.size() != 4 ||
+                  Dims(residual) != dims) {
+                return false;
+              }
+              auto op = std::make_shared<OpDesc>(*conv);
+              op->GetInputs()["ResidualData"] = {residual};
+              op->SetOutputs(add->GetOutputs());
+              replacement->ops.push_back(op);
+              return true;
+            });
+  }
+
+  // an activation after the conv is applied by the conv, so is relu after
+  // a residual. Relu alone makes a fusion_conv_add_relu below.
+  {
+    Pattern pattern;
+    int conv = pattern.AddNode({G_OP_TYPE_FUSION_CONV_ADD},
+                               [](const std::shared_ptr<OpDesc> &op) {
+                                 return AttrOr<std::string>(
+                                            op, "fuse_activation", "")
+                                     .empty();
+                               });
+    int act = pattern.AddNode(
+        {G_OP_TYPE_RELU, G_OP_TYPE_RELU6, G_OP_TYPE_SIGMOID, G_OP_TYPE_TANH});
+    pattern.AddEdge(conv, "Out", act, "X");
+    AddRule("fuse_conv_activation", pattern,
+            [](const OpGraph &graph, const std::vector<int> &match,
+               Replacement *replacement) {
+              const auto &conv = graph.Op(match[0]);
+              const auto &act = graph.Op(match[1]);
+#ifdef FUSION_CONVADDRELU_OP
+              if (act->Type() == G_OP_TYPE_RELU && !HasEpilogue(conv)) {
+                return false;
+              }
+#endif
+              auto op = std::make_shared<OpDesc>(*conv);
+              op->GetAttrMap()["fuse_activation"].SetString(act->Type());
+              op->SetOutputs(act->GetOutputs());
+              replacement->ops.push_back(op);
+              return true;
+            });
+  }
+#endif
+
+#ifdef FUSION_CONVADDRELU_OP
+  {
+    Pattern pattern;
+    int conv = pattern.AddNode({G_OP_TYPE_FUSION_CONV_ADD},
+                               [](const std::shared_ptr<OpDesc> &op) {
+                                 return !HasEpilogue(op);
+                               });
+    int relu = pattern.AddNode({G_OP_TYPE_RELU});
+    pattern.AddEdge(conv, "Out", relu, "X");
+    AddRule("fuse_conv_relu", pattern,
+            [](const OpGraph &graph, const std::vector<int> &match,
+               Replacement *replacement) {
+              auto op =
+                  std::make_shared<OpDesc>(G_OP_TYPE_FUSION_CONV_ADD_RELU);
+              op->SetInputs(graph.Op(match[0])->GetInputs());
+              op->SetOutputs(graph.Op(match[1])->GetOutputs());
+              op->SetAttrMap(graph.Op(match[0])->GetAttrMap());
+              replacement->ops.push_back(op);
+              return true;
+            });
+  }
+#endif
+}
+
+int GraphOptPass::ApplyRule(const Rule &rule,
+                            const std::shared_ptr<BlockDesc> &block) {
+  int count = 0;
+  while (true) {
+    const auto ops = block->Ops();
+    OpGraph graph(ops);
+    auto replace = [&](const std::vector<int> &match) {
+      // the replacement takes the place of the last matched op, so no op
+      // before it may read what the other matched ops write
+      const int last = *std::max_element(match.begin(), match.end());
+      for (int i : match) {
+        for (const auto &output : ops[i]->GetOutputs()) {
+          for (const auto &name : output.second) {
+            for (int consumer : graph.Consumers(name)) {
+              if (consumer < last &&
+                  std::find(match.begin(), match.end(), consumer) ==
+                      match.end()) {
+                return false;
+              }
+            }
+          }
+        }
+      }
+      Replacement replacement;
+      if (!rule.rewrite(graph, match, &replacement)) {
+        return false;
+      }
+      std::vector<std::shared_ptr<OpDesc>> new_ops;
+      for (int i = 0; i < ops.size(); ++i) {
+        if (i == last) {
+          new_ops.insert(new_ops.end(), replacement.ops.begin(),
+                         replacement.ops.end());
+        } else if (std::find(match.begin(), match.end(), i) == match.end()) {
+          auto op = ops[i];
+          if (i > last && !replacement.renames.empty()) {
+            op = std::make_shared<OpDesc>(*op);
+            for (auto &input : op->GetInputs()) {
+              for (auto &name : input.second) {
+                auto it = replacement.renames.find(name);
+                if (it != replacement.renames.end()) {
+                  name = it->second;
+                }
+              }
+            }
+          }
+          new_ops.push_back(op);
+        }
+      }
+      block->SetOps(new_ops);
+      return true;
+    };
+    if (!graph.Match(rule.pattern, replace)) {
+      return count;
+    }
+    ++count;
+  }
+}
+
+void GraphOptPass::RemoveUnusedWeights(
+    const std::shared_ptr<BlockDesc> &block) {
+  std::unordered_set<std::string> used;
+  for (const auto &op : block->Ops()) {
+    for (const auto &input : op->GetInputs()) {
+      used.insert(input.second.begin(), input.second.end());
+    }
+    for (const auto &output : op->GetOutputs()) {
+      used.insert(output.second.begin(), output.second.end());
+    }
+  }
+  std::vector<std::string> unused;
+  for (const auto &var_desc : block->Vars()) {
+    const std::string name = var_desc->Name();
+    if (var_desc->Persistable() && !used.count(name) &&
+        var_desc->Type() == VARTYPE_TYPE_LOD_TENSOR) {
+      block->RemoveVar(name);
+      unused.push_back(name);
+    }
+  }
+  scope_->EraseVars(unused);
+}
+
+void GraphOptPass::operator()(const std::shared_ptr<BlockDesc> &block) {
+  block_ = block;
+  for (const auto &var_desc : block->Vars()) {
+    var_descs_[var_desc->Name()] = var_desc;
+  }
+  const size_t op_count = block->Ops().size();
+  // a rule may make others match again, such as a bias fused into a conv
+  // followed by a batch norm
+  std::unordered_map<std::string, int> counts;
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (const auto &rule : rules_) {
+      if (rule.folds_weights && scope_ == nullptr) {
+        continue;
+      }
+      const int count = ApplyRule(rule, block);
+      counts[rule.name] += count;
+      changed = changed || count > 0;
+    }
+  }
+  if (scope_ != nullptr) {
+    RemoveUnusedWeights(block);
+  }
+  for (const auto &count : counts) {
+    if (count.second > 0) {
+      LOG(kLOG_INFO) << "graph optimize: " << count.first << " applied "
+                     << count.second << " times";
+    }
+  }
+  LOG(kLOG_INFO) << "graph optimize: " << op_count << " ops to "
+                 << block->Ops().size();
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -0,0 +1,153 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "framework/lod_tensor.h"
+#include "framework/program/block_desc.h"
+#include "framework/scope.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// Pattern is a dag of op nodes. An edge says that an output of one node is
+// read by an input of another node, the variable of a private edge is read
+// by no op out of the match, so the rewrite may drop it.
+class Pattern {
+ public:
+  typedef std::function<bool(const std::shared_ptr<OpDesc> &)> Condition;
+
+  // adds a node matching an op of one of the types, any type if types is
+  // empty, and returns its id. Every node but the first must be connected
+  // to an earlier node.
+  int AddNode(const std::vector<std::string> &types,
+              Condition condition = nullptr);
+  void AddEdge(int from, const std::string &output, int to,
+               const std::string &input, bool is_private = true);
+
+ private:
+  friend class OpGraph;
+  struct Node {
+    std::vector<std::string> types;
+    Condition condition;
+  };
+  struct Edge {
+    int from;
+    std::string output;
+    int to;
+    std::string input;
+    bool is_private;
+  };
+  std::vector<Node> nodes_;
+  std::vector<Edge> edges_;
+};
+
+// OpGraph indexes the producers and consumers of the variables of an op list
+class OpGraph {
+ public:
+  explicit OpGraph(const std::vector<std::shared_ptr<OpDesc>> &ops);
+
+  const std::shared_ptr<OpDesc> &Op(int i) const { return ops_[i]; }
+  const std::vector<int> &Producers(const std::string &name) const;
+  const std::vector<int> &Consumers(const std::string &name) const;
+
+  // calls visit with the op index of every node for each match, in the
+  // order of the first node, until visit returns true
+  bool Match(const Pattern &pattern,
+             const std::function<bool(const std::vector<int> &)> &visit) const;
+
+ private:
+  bool Extend(const Pattern &pattern, std::vector<int> *match,
+              const std::function<bool(const std::vector<int> &)> &visit)
+      const;
+  bool NodeMatches(const Pattern::Node &node, int op) const;
+  bool EdgeHolds(const Pattern::Edge &edge, const std::vector<int> &match)
+      const;
+
+  std::vector<std::shared_ptr<OpDesc>> ops_;
+  std::unordered_map<std::string, std::vector<int>> producers_;
+  std::unordered_map<std::string, std::vector<int>> consumers_;
+  std::vector<int> none_;
+};
+
+// GraphOptPass rewrites a block by rules, each a pattern and a function
+// which replaces the matched ops. A rule is applied until it matches no
+// more ops. The rules dropping identity ops, folding pad2d into the conv
+// paddings and fusing a conv with its bias, a residual add and an
+// activation only edit the program.
+// With the scope holding the loaded weights, the ops of persistable inputs
+// are run once at load and batch norms and channel scales are folded into
+// the conv filters and biases.
+class GraphOptPass {
+ public:
+  explicit GraphOptPass(std::shared_ptr<Scope> scope = nullptr);
+
+  void operator()(const std::shared_ptr<BlockDesc> &block);
+
+ private:
+  struct Replacement {
+    std::vector<std::shared_ptr<OpDesc>> ops;
+    // the ops after the match read these variables under the new names
+    std::unordered_map<std::string, std::string> renames;
+  };
+  // returns false to keep the matched ops
+  typedef std::function<bool(const OpGraph &, const std::vector<int> &,
+                             Replacement *)>
+      Rewrite;
+  struct Rule {
+    std::string name;
+    Pattern pattern;
+    Rewrite rewrite;
+    bool folds_weights;
+  };
+
+  void AddRules();
+  void AddRule(const std::string &name, const Pattern &pattern,
+               Rewrite rewrite, bool folds_weights = false);
+  int ApplyRule(const Rule &rule, const std::shared_ptr<BlockDesc> &block);
+  void RemoveUnusedWeights(const std::shared_ptr<BlockDesc> &block);
+
+  bool IsPersistable(const std::string &name) const;
+  std::vector<int64_t> Dims(const std::string &name) const;
+  // a float tensor of the loaded weights
+  LoDTensor *Weight(const std::string &name) const;
+  // adds a persistable variable of the block and returns its tensor
+  LoDTensor *NewWeight(const std::string &prefix,
+                       const std::vector<int64_t> &dims, std::string *name);
+
+  bool FoldConstant(const std::shared_ptr<OpDesc> &op);
+  // the scale and shift per channel of the batch norm inputs of op
+  bool BatchNormAffine(const std::shared_ptr<OpDesc> &op,
+                       std::vector<float> *scale, std::vector<float> *shift);
+  // replaces conv and the y = x * scale + shift per output channel after it
+  // by a conv with bias writing output, followed by relu if set. shift may
+  // be empty.
+  bool FoldAffine(const std::shared_ptr<OpDesc> &conv,
+                  const std::vector<float> &scale,
+                  const std::vector<float> &shift, bool relu,
+                  const std::string &output, Replacement *replacement);
+
+  std::shared_ptr<Scope> scope_;
+  std::shared_ptr<BlockDesc> block_;
+  std::unordered_map<std::string, std::shared_ptr<VarDesc>> var_descs_;
+  std::vector<Rule> rules_;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -0,0 +1,254 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+#include "framework/layout_optimize.h"
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+#include "common/log.h"
+#include "common/types.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+static bool IsConv(const std::string &type) {
+  return type == G_OP_TYPE_CONV || type == G_OP_TYPE_DEPTHWISE_CONV ||
+         type == G_OP_TYPE_FUSION_CONV_ADD ||
+         type == G_OP_TYPE_FUSION_CONV_ADD_RELU ||
+         type == G_OP_TYPE_FUSION_CONV_BN_RELU ||
+         type == G_OP_TYPE_FUSION_DWCONV_BN_RELU;
+}
+
+// the argument names of the activations an op reads and writes blocked
+static const char *BlockedInput(const std::string &type) {
+  return IsConv(type) ? "Input" : "X";
+}
+
+static const char *BlockedOutput(const std::string &type) {
+  if (type == G_OP_TYPE_CONV || type == G_OP_TYPE_DEPTHWISE_CONV) {
+    return "Output";
+  }
+  return type == G_OP_TYPE_BATCHNORM ? "Y" : "Out";
+}
+
+template <typename T>
+static T AttrOr(const std::shared_ptr<OpDesc> &op, const std::string &name,
+                T value) {
+  const AttributeMap &attrs = op->GetAttrMap();
+  return attrs.count(name) ? attrs.at(name).Get<T>() : value;
+}
+
+template <>
+std::string AttrOr<std::string>(const std::shared_ptr<OpDesc> &op,
+                                const std::string &name, std::string value) {
+  const AttributeMap &attrs = op->GetAttrMap();
+  return attrs.count(name) ? attrs.at(name).GetString() : value;
+}
+
+static std::shared_ptr<OpDesc> LayoutTransform(const std::string &input,
+                                               const std::string &output,
+                                               DataLayout layout) {
+  auto op = std::make_shared<OpDesc>(G_OP_TYPE_LAYOUT_TRANSFORM);
+  op->SetInputs({{"X", {input}}});
+  op->SetOutputs({{"Out", {output}}});
+  AttributeMap attrs;
+  attrs["dst_layout"].SetString(DataLayoutToString(layout));
+  op->SetAttrMap(attrs);
+  return op;
+}
+
+std::vector<int64_t> LayoutOptPass::Dims(const std::string &name) const {
+  auto it = var_descs_.find(name);
+  return it == var_descs_.end() ? std::vector<int64_t>()
+                                : it->second->Tensor_desc().Dims();
+}
+
+bool LayoutOptPass::IsActivation(const std::string &name) const {
+  auto it = var_descs_.find(name);
+  return it != var_descs_.end() && !it->second->Persistable() &&
+         it->second->Type() == VARTYPE_TYPE_LOD_TENSOR &&
+         it->second->Tensor_desc().DataType() == VARTYPE_TYPE_FP32 &&
+         it->second->Tensor_desc().Dims().size() == 4;
+}
+
+bool LayoutOptPass::Supported(const std::shared_ptr<OpDesc> &op) const {
+  const std::string type = op->Type();
+  if (!IsConv(type) && type != G_OP_TYPE_POOL2D &&
+      type != G_OP_TYPE_BATCHNORM && type != G_OP_TYPE_RELU &&
+      type != G_OP_TYPE_RELU6 && type != G_OP_TYPE_ELEMENTWISE_ADD &&
+      type != G_OP_TYPE_CONCAT) {
+    return false;
+  }
+  const auto &inputs = op->GetInputs();
+  const auto &outputs = op->GetOutputs();
+  if (!inputs.count(BlockedInput(type)) ||
+      !outputs.count(BlockedOutput(type)) ||
+      outputs.at(BlockedOutput(type)).size() != 1) {
+    return false;
+  }
+  const std::vector<std::string> &x = inputs.at(BlockedInput(type));
+  const std::string &out = outputs.at(BlockedOutput(type))[0];
+  if (x.empty() || !IsActivation(out) ||
+      std::find(x.begin(), x.end(), out) != x.end()) {
+    return false;
+  }
+  for (const auto &name : x) {
+    if (!IsActivation(name)) {
+      return false;
+    }
+  }
+
+  if (IsConv(type)) {
+    // groups 1 or depthwise
+    const std::vector<int64_t> filter = Dims(op->Input("Filter")[0]);
+    const int groups = AttrOr<int>(op, "groups", 1);
+    if (filter.size() != 4 ||
+        (groups != 1 && (filter[1] != 1 || groups != filter[0] ||
+                         Dims(x[0])[1] != groups))) {
+      return false;
+    }
+    if (type == G_OP_TYPE_FUSION_CONV_ADD ||
+        type == G_OP_TYPE_FUSION_CONV_ADD_RELU) {
+      // the blocked conv applies no activation but relu and no residual
+      if (!AttrOr<std::string>(op, "fuse_activation", "").empty() ||
+          op->GetInputs().count("ResidualData")) {
+        return false;
+      }
+      return Dims(op->Input("Y")[0]).size() == 1 &&
+             AttrOr<int>(op, "axis", 1) == 1;
+    }
+    return true;
+  }
+  if (type == G_OP_TYPE_POOL2D) {
+    const std::string pooling_type = AttrOr<std::string>(
+        op, "pooling_type", "");
+    return pooling_type == "max" || pooling_type == "avg";
+  }
+  if (type == G_OP_TYPE_ELEMENTWISE_ADD) {
+    // y is an activation of the same dims or a bias of the channels
+    const std::string &y = op->Input("Y")[0];
+    if (IsActivation(y)) {
+      return Dims(y) == Dims(x[0]);
+    }
+    return var_descs_.count(y) && var_descs_.at(y)->Persistable() &&
+           Dims(y).size() == 1 && AttrOr<int>(op, "axis", -1) == 1;
+  }
+  if (type == G_OP_TYPE_CONCAT) {
+    // the inputs are copied by whole blocks
+    if (AttrOr<int>(op, "axis", 0) != 1) {
+      return false;
+    }
+    const int block = DataLayoutBlock(layout_);
+    for (int i = 0; i + 1 < x.size(); ++i) {
+      const int64_t channels = Dims(x[i])[1];
+      if (channels <= 0 || channels % block != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::string LayoutOptPass::Blocked(const std::shared_ptr<BlockDesc> &block,
+                                   const std::string &name) {
+  std::string suffix = DataLayoutToString(layout_);
+  std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::tolower);
+  const std::string blocked = name + "." + suffix;
+  if (!var_descs_.count(blocked)) {
+    auto var_desc = std::make_shared<VarDesc>(blocked, VARTYPE_TYPE_FP32,
+                                              Dims(name), false);
+    block->SetVar(var_desc);
+    var_descs_[blocked] = var_desc;
+    var_layouts_[blocked] = layout_;
+  }
+  return blocked;
+}
+
+void LayoutOptPass::operator()(const std::shared_ptr<BlockDesc> &block) {
+  for (const auto &var_desc : block->Vars()) {
+    var_descs_[var_desc->Name()] = var_desc;
+  }
+  const auto ops = block->Ops();
+  // the rewriting relies on every activation being written by one op
+  std::unordered_map<std::string, int> producers;
+  std::unordered_map<std::string, std::vector<int>> consumers;
+  for (int i = 0; i < ops.size(); ++i) {
+    for (const auto &pair : ops[i]->GetOutputs()) {
+      for (const auto &name : pair.second) {
+        if (IsActivation(name) && !producers.emplace(name, i).second) {
+          return;
+        }
+      }
+    }
+    for (const auto &pair : ops[i]->GetInputs()) {
+      for (const auto &name : pair.second) {
+        consumers[name].push_back(i);
+      }
+    }
+  }
+  std::vector<bool> supported(ops.size());
+  int blocked_ops = 0;
+  for (int i = 0; i < ops.size(); ++i) {
+    supported[i] = Supported(ops[i]);
+    blocked_ops += supported[i];
+  }
+  if (blocked_ops == 0) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<OpDesc>> new_ops;
+  // the NCHW activations already converted to a blocked variable
+  std::unordered_set<std::string> converted;
+  for (int i = 0; i < ops.size(); ++i) {
+    if (!supported[i]) {
+      new_ops.push_back(ops[i]);
+      continue;
+    }
+    const std::string type = ops[i]->Type();
+    auto op = std::make_shared<OpDesc>(*ops[i]);
+    std::vector<const char *> slots{BlockedInput(type)};
+    if (type == G_OP_TYPE_ELEMENTWISE_ADD && IsActivation(op->Input("Y")[0])) {
+      slots.push_back("Y");
+    }
+    for (const char *slot : slots) {
+      for (auto &name : op->GetInputs()[slot]) {
+        auto producer = producers.find(name);
+        if ((producer == producers.end() || !supported[producer->second]) &&
+            converted.insert(name).second) {
+          new_ops.push_back(
+              LayoutTransform(name, Blocked(block, name), layout_));
+        }
+        name = Blocked(block, name);
+      }
+    }
+    std::string &out = op->GetOutputs()[BlockedOutput(type)][0];
+    const std::string plain = out;
+    out = Blocked(block, plain);
+    new_ops.push_back(op);
+    // an output read by other ops or by nobody, such as the one fetched by
+    // name, is converted back to NCHW
+    const auto &users = consumers[plain];
+    if (users.empty() ||
+        std::any_of(users.begin(), users.end(),
+                    [&](int user) { return !supported[user]; })) {
+      new_ops.push_back(LayoutTransform(out, plain, DataLayout::kNCHW));
+    }
+  }
+  block->SetOps(new_ops);
+  LOG(kLOG_INFO) << "layout optimize: " << blocked_ops << " ops run in "
+                 << DataLayoutToString(layout_) << ", "
+                 << new_ops.size() - ops.size() << " layout transforms";
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
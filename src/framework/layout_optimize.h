@@ -0,0 +1,56 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "framework/data_layout.h"
+#include "framework/program/block_desc.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// LayoutOptPass rewrites a block so that the ops with kernels for the channel
+// blocked layouts run on blocked activations. The blocked copy of an
+// activation is a new variable, its name is the NCHW one suffixed by the
+// layout. A layout_transform op converts an activation where it passes
+// between a blocked op and any other op, so the feed and fetch ops and the
+// unsupported ops still see the NCHW variables.
+class LayoutOptPass {
+ public:
+  explicit LayoutOptPass(DataLayout layout) : layout_(layout) {}
+
+  void operator()(const std::shared_ptr<BlockDesc> &block);
+
+  // the layout of every variable added by the pass
+  const std::unordered_map<std::string, DataLayout> &VarLayouts() const {
+    return var_layouts_;
+  }
+
+ private:
+  bool Supported(const std::shared_ptr<OpDesc> &op) const;
+  std::vector<int64_t> Dims(const std::string &name) const;
+  bool IsActivation(const std::string &name) const;
+  std::string Blocked(const std::shared_ptr<BlockDesc> &block,
+                      const std::string &name);
+
+  DataLayout layout_;
+  std::unordered_map<std::string, std::shared_ptr<VarDesc>> var_descs_;
+  std::unordered_map<std::string, DataLayout> var_layouts_;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
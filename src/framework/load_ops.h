@@ -246,6 +246,9 @@ LOAD_OP1(quantize, CPU);
 #ifdef DEQUANT_OP
 LOAD_OP1(dequantize, CPU);
 #endif
+#ifdef LAYOUT_TRANSFORM_OP
+LOAD_OP1(layout_transform, CPU);
+#endif
 #ifdef FUSION_DEQUANT_BN_OP
 LOAD_OP1(fusion_dequant_bn, CPU);
 LOAD_FUSION_MATCHER(fusion_dequant_bn);
@@ -270,6 +273,22 @@ LOAD_FUSION_MATCHER(fusion_dequant_add_bn_quant);
 LOAD_OP1(fusion_dequant_add_bn_relu_quant, CPU);
 LOAD_FUSION_MATCHER(fusion_dequant_add_bn_relu_quant);
 #endif
+#ifdef FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP
+LOAD_OP1(fusion_conv_dequant_add_bn_relu_quant, CPU);
+LOAD_FUSION_MATCHER(fusion_conv_dequant_add_bn_relu_quant);
+#endif
+#ifdef FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP
+LOAD_OP1(fusion_conv_dequant_bn_relu_quant, CPU);
+LOAD_FUSION_MATCHER(fusion_conv_dequant_bn_relu_quant);
+#endif
+#ifdef FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP
+LOAD_OP1(fusion_conv_dequant_bn_relu6_quant, CPU);
+LOAD_FUSION_MATCHER(fusion_conv_dequant_bn_relu6_quant);
+#endif
+#ifdef FUSION_CONV_DEQUANT_RELU_QUANT_OP
+LOAD_OP1(fusion_conv_dequant_relu_quant, CPU);
+LOAD_FUSION_MATCHER(fusion_conv_dequant_relu_quant);
+#endif
 #ifdef SEQUENCE_EXPAND_OP
 LOAD_OP1(sequence_expand, CPU);
 #endif
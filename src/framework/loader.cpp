@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "framework/loader.h"
+#include <vector>
 
 #include "framework/lod_tensor.h"
 #include "framework/program/program-optimize/program_optimize.h"
@@ -280,6 +281,27 @@ const Program<Device, T> Loader<Device, T>::LoadCombinedMemory(
   return program;
 }
 
+template <typename Device, typename T>
+const Program<Device, T> Loader<Device, T>::LoadStream(
+    const StreamReadFunc &model_reader, const StreamReadFunc &params_reader,
+    bool optimize, bool quantification) {
+  // start reading the params ahead while the model is parsed
+  auto reader = std::make_shared<StreamReader>(params_reader);
+  std::vector<uint8_t> model;
+  size_t read = 0;
+  do {
+    const size_t size = model.size();
+    model.resize(size + (1 << 16));
+    read = model_reader(model.data() + size, model.size() - size);
+    model.resize(size + read);
+  } while (read > 0);
+  PADDLE_MOBILE_ENFORCE(!model.empty(), "read from __model__ is empty");
+  Program<Device, T> program = LoadCombinedMemory(
+      model.size(), model.data(), 0, nullptr, optimize, quantification);
+  program.params_reader = reader;
+  return program;
+}
+
 template class Loader<CPU, float>;
 
 template class Loader<FPGA, float>;
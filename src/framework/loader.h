@@ -18,6 +18,7 @@ limitations under the License. */
 
 #include "common/types.h"
 #include "framework/program/program.h"
+#include "framework/stream_reader.h"
 
 namespace paddle_mobile {
 namespace framework {
@@ -50,6 +51,16 @@ class Loader {
                                               bool optimize = false,
                                               bool quantification = false);
 
+  /*
+   * @b load combine format fluid model from readers, the model is read whole
+   * before the parse while the params are read by the executor as it loads
+   * them, see StreamReader
+   * */
+  const Program<Device, T> LoadStream(const StreamReadFunc &model_reader,
+                                      const StreamReadFunc &params_reader,
+                                      bool optimize = false,
+                                      bool quantification = false);
+
  private:
   const Program<Device, T> LoadProgram(const std::string &model_path,
                                        bool optimize = false,
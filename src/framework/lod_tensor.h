@@ -209,6 +209,10 @@ inline Print &operator<<(Print &printer, const LoDTensor &tensor) {
   printer << " dims: " << tensor.dims() << "\n";
   int stride = tensor.numel() / 20;
   stride = stride > 0 ? stride : 1;
+  if (tensor.memory_size() == 0) {
+    // such as the weights freed by weight compression
+    return printer;
+  }
 #ifndef PADDLE_MOBILE_FPGA
   for (int i = 0; i < tensor.numel(); i += stride) {
     if (tensor.type() == typeid(float)) {
@@ -0,0 +1,226 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "framework/memory_optimize.h"
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+#include "common/log.h"
+#include "common/types.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// keep every planned tensor aligned the same as memory::Alloc
+static const size_t kArenaAlign = 64;
+
+static inline size_t AlignTo(size_t size) {
+  return (size + kArenaAlign - 1) / kArenaAlign * kArenaAlign;
+}
+
+static bool GetTensorType(VarType_Type type, std::type_index *type_index) {
+  switch (type) {
+    case VARTYPE_TYPE_FP32:
+      *type_index = typeid(float);
+      return true;
+    case VARTYPE_TYPE_INT8:
+      *type_index = typeid(int8_t);
+      return true;
+    case VARTYPE_TYPE_INT32:
+      *type_index = typeid(int32_t);
+      return true;
+    case VARTYPE_TYPE_INT64:
+      *type_index = typeid(int64_t);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// ops whose output may share memory with its input by ShareDataWith
+static bool IsAliasOp(const std::string &type) {
+  return type == G_OP_TYPE_RESHAPE || type == G_OP_TYPE_RESHAPE2 ||
+         type == G_OP_TYPE_LOD_RESET || type == G_OP_TYPE_FETCH;
+}
+
+const std::string &MemoryOptPass::AliasRoot(const std::string &name) {
+  auto it = alias_.find(name);
+  if (it == alias_.end() || it->second == name) {
+    return name;
+  }
+  const std::string &root = AliasRoot(it->second);
+  it->second = root;
+  return it->second;
+}
+
+void MemoryOptPass::CollectLifeCycles(const std::shared_ptr<BlockDesc> &block,
+                                      Scope *scope) {
+  std::unordered_map<std::string, std::shared_ptr<VarDesc>> var_descs;
+  for (const auto &var_desc : block->Vars()) {
+    var_descs[var_desc->Name()] = var_desc;
+  }
+  const auto &ops = block->Ops();
+  // tensors fed from outside never own the memory, skip them
+  std::unordered_set<std::string> externals;
+  for (const auto &op : ops) {
+    if (op->Type() == G_OP_TYPE_FEED) {
+      for (const auto &output : op->GetOutputs()) {
+        externals.insert(output.second.begin(), output.second.end());
+      }
+    } else if (IsAliasOp(op->Type())) {
+      const auto &inputs = op->GetInputs();
+      const auto &outputs = op->GetOutputs();
+      if (inputs.count("X") && outputs.count("Out") &&
+          !inputs.at("X").empty() && !outputs.at("Out").empty()) {
+        const std::string in_root = AliasRoot(inputs.at("X")[0]);
+        const std::string out_root = AliasRoot(outputs.at("Out")[0]);
+        if (in_root != out_root) {
+          alias_[out_root] = in_root;
+        }
+      }
+    }
+  }
+
+  std::unordered_map<std::string, VarLifeCycle> groups;
+  std::vector<std::string> group_order;
+  std::unordered_set<std::string> visited;
+  for (int i = 0; i < ops.size(); ++i) {
+    for (const auto *var_map : {&ops[i]->GetInputs(), &ops[i]->GetOutputs()}) {
+      for (const auto &pair : *var_map) {
+        for (const auto &name : pair.second) {
+          auto it = var_descs.find(name);
+          if (it == var_descs.end() || it->second->Persistable() ||
+              it->second->Type() != VARTYPE_TYPE_LOD_TENSOR) {
+            continue;
+          }
+          const std::string root = AliasRoot(name);
+          if (groups.find(root) == groups.end()) {
+            groups[root].first_use = i;
+            group_order.push_back(root);
+          }
+          VarLifeCycle &life = groups[root];
+          life.last_use = i;
+          if (life.uses.empty() || life.uses.back() != i) {
+            life.uses.push_back(i);
+          }
+          if (visited.insert(name).second) {
+            life.names.push_back(name);
+          }
+        }
+      }
+    }
+  }
+
+  for (const auto &root : group_order) {
+    VarLifeCycle &life = groups[root];
+    bool plannable = true;
+    size_t group_bytes = 0;
+    for (int i = 0; i < life.names.size() && plannable; ++i) {
+      const std::string &name = life.names[i];
+      std::type_index type = typeid(float);
+      auto *tensor = scope->Var(name)->GetMutable<LoDTensor>();
+      plannable = !externals.count(name) && tensor->numel() > 0 &&
+                  GetTensorType(var_descs[name]->Tensor_desc().DataType(),
+                                &type) &&
+                  (i == 0 || type == life.type);
+      if (plannable) {
+        size_t size = AlignTo(tensor->storage_numel() * SizeOfType(type));
+        life.type = type;
+        life.size = std::max(life.size, size);
+        group_bytes += size;
+      }
+    }
+    if (plannable) {
+      naive_bytes_ += group_bytes;
+      life_cycles_.push_back(std::move(life));
+    }
+  }
+}
+
+bool MemoryOptPass::UsedBefore(const VarLifeCycle &a,
+                               const VarLifeCycle &b) const {
+  for (int use : a.uses) {
+    if (!dag_->Precedes(use, b.first_use)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MemoryOptPass::Overlap(const VarLifeCycle &a,
+                            const VarLifeCycle &b) const {
+  if (dag_ == nullptr) {
+    return a.last_use >= b.first_use && b.last_use >= a.first_use;
+  }
+  return !UsedBefore(a, b) && !UsedBefore(b, a);
+}
+
+size_t MemoryOptPass::PlanArena() {
+  std::vector<VarLifeCycle *> vars;
+  for (auto &life : life_cycles_) {
+    vars.push_back(&life);
+  }
+  // greedy by size, larger tensors are placed first at the lowest offset
+  // which doesn't overlap with any placed tensor alive at the same time
+  std::stable_sort(vars.begin(), vars.end(),
+                   [](const VarLifeCycle *a, const VarLifeCycle *b) {
+                     return a->size > b->size;
+                   });
+  size_t arena_size = 0;
+  std::vector<VarLifeCycle *> placed;
+  for (auto *var : vars) {
+    std::vector<std::pair<size_t, size_t>> busy;
+    for (const auto *other : placed) {
+      if (Overlap(*other, *var)) {
+        busy.emplace_back(other->offset, other->offset + other->size);
+      }
+    }
+    std::sort(busy.begin(), busy.end());
+    size_t offset = 0;
+    for (const auto &range : busy) {
+      if (offset + var->size <= range.first) {
+        break;
+      }
+      offset = std::max(offset, range.second);
+    }
+    var->offset = offset;
+    arena_size = std::max(arena_size, offset + var->size);
+    placed.push_back(var);
+  }
+  return arena_size;
+}
+
+void MemoryOptPass::operator()(const std::shared_ptr<BlockDesc> &block,
+                               Scope *scope) {
+  CollectLifeCycles(block, scope);
+  planned_bytes_ = PlanArena();
+  if (planned_bytes_ == 0) {
+    return;
+  }
+  LoDTensor arena;
+  arena.mutable_data<int8_t>(
+      make_ddim({static_cast<int64_t>(planned_bytes_)}));
+  for (const auto &life : life_cycles_) {
+    for (const auto &name : life.names) {
+      auto *tensor = scope->Var(name)->GetMutable<LoDTensor>();
+      tensor->ShareBufferWith(arena, life.offset, life.size, life.type);
+    }
+  }
+  LOG(kLOG_INFO) << "memory optimize: " << life_cycles_.size()
+                 << " activations, naive bytes: " << naive_bytes_
+                 << ", planned bytes: " << planned_bytes_;
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -0,0 +1,79 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+#include "framework/lod_tensor.h"
+#include "framework/op_dag.h"
+#include "framework/program/block_desc.h"
+#include "framework/scope.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// the lifetime of an activation tensor, measured in op indices of a block,
+// tensors aliased by ops such as reshape are planned as a whole
+struct VarLifeCycle {
+  std::vector<std::string> names;
+  std::type_index type = typeid(float);
+  int first_use = -1;
+  int last_use = -1;
+  // every op using the tensor, in op order
+  std::vector<int> uses;
+  size_t size = 0;
+  size_t offset = 0;
+};
+
+// MemoryOptPass plans the storage of all non-persistable activations of a
+// block. The first and last use of each tensor is computed from the op list,
+// then tensors with disjoint lifetimes are packed by offset into one shared
+// arena, so they alias the same memory block. With the dag of the block,
+// whose ops may run at the same time, two lifetimes are disjoint only if
+// every op using one tensor precedes the first op of the other in the dag.
+class MemoryOptPass {
+ public:
+  explicit MemoryOptPass(const OpDAG *dag = nullptr) : dag_(dag) {}
+
+  // must be called after all ops of `block` have inferred their output shapes
+  void operator()(const std::shared_ptr<BlockDesc> &block, Scope *scope);
+
+  // the sum of bytes when every activation holds its own buffer
+  size_t NaiveBytes() const { return naive_bytes_; }
+  // the bytes of the planned arena
+  size_t PlannedBytes() const { return planned_bytes_; }
+
+ private:
+  void CollectLifeCycles(const std::shared_ptr<BlockDesc> &block,
+                         Scope *scope);
+  const std::string &AliasRoot(const std::string &name);
+  size_t PlanArena();
+  bool Overlap(const VarLifeCycle &a, const VarLifeCycle &b) const;
+  // whether all uses of a finish before b is first written
+  bool UsedBefore(const VarLifeCycle &a, const VarLifeCycle &b) const;
+
+  const OpDAG *dag_;
+
+  std::vector<VarLifeCycle> life_cycles_;
+  // tensors which share memory with another one by an op, such as reshape
+  std::unordered_map<std::string, std::string> alias_;
+  size_t naive_bytes_ = 0;
+  size_t planned_bytes_ = 0;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
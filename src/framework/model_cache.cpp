@@ -0,0 +1,337 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "framework/model_cache.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <typeindex>
+#include "common/cpu_info.h"
+#include "common/log.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+namespace {
+
+// bump it whenever the program passes or the data derived by kernel Init
+// change, the caches of older libraries are ignored then
+const int kModelCacheVersion = 1;
+const char kMagic[8] = {'P', 'M', 'C', 'A', 'C', 'H', 'E', '\0'};
+
+// 64 bit FNV-1a
+const uint64_t kHashBasis = 14695981039346656037ULL;
+const uint64_t kHashPrime = 1099511628211ULL;
+
+uint64_t Hash(const void *data, size_t size, uint64_t hash) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * kHashPrime;
+  }
+  return hash;
+}
+
+std::string HexString(uint64_t value) {
+  char buffer[17];
+  snprintf(buffer, sizeof(buffer), "%016llx",
+           static_cast<unsigned long long>(value));  // NOLINT
+  return buffer;
+}
+
+const char *BuildName() {
+#if defined(__aarch64__)
+  return "arm64";
+#elif defined(__ARM_NEON__)
+  return "armv7-neon";
+#elif defined(__arm__)
+  return "armv7";
+#elif defined(__x86_64__)
+  return "x86_64";
+#elif defined(__i386__)
+  return "x86";
+#else
+  return "unknown";
+#endif
+}
+
+// the element types of the kernel weights, by their index in the file
+const std::type_index kWeightTypes[] = {
+    typeid(float),   typeid(int8_t),  typeid(uint8_t),
+    typeid(int16_t), typeid(int32_t), typeid(int64_t)};
+const int kWeightTypeCount = sizeof(kWeightTypes) / sizeof(kWeightTypes[0]);
+
+template <typename T>
+void Put(const T &value, std::string *out) {
+  out->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void PutString(const std::string &value, std::string *out) {
+  Put<uint64_t>(value.size(), out);
+  out->append(value);
+}
+
+// reads a cache file, every read fails once the data is exhausted
+class Reader {
+ public:
+  Reader(const char *data, size_t size) : data_(data), left_(size) {}
+
+  bool Read(void *out, size_t size) {
+    if (size > left_) {
+      left_ = 0;
+      return false;
+    }
+    memcpy(out, data_, size);
+    data_ += size;
+    left_ -= size;
+    return true;
+  }
+
+  template <typename T>
+  bool Get(T *value) {
+    return Read(value, sizeof(T));
+  }
+
+  bool GetString(std::string *value) {
+    uint64_t size = 0;
+    if (!Get(&size) || size > left_) {
+      return false;
+    }
+    value->assign(data_, size);
+    data_ += size;
+    left_ -= size;
+    return true;
+  }
+
+ private:
+  const char *data_;
+  size_t left_;
+};
+
+void PutTensor(const Tensor &tensor, std::string *out) {
+  int type = -1;
+  if (tensor.IsInitialized()) {
+    type = std::find(kWeightTypes, kWeightTypes + kWeightTypeCount,
+                     std::type_index(tensor.type())) -
+           kWeightTypes;
+  }
+  if (type < 0 || type == kWeightTypeCount) {
+    Put<int32_t>(-1, out);
+    return;
+  }
+  Put<int32_t>(type, out);
+  const std::vector<int64_t> dims = vectorize(tensor.dims());
+  Put<uint64_t>(dims.size(), out);
+  for (int64_t d : dims) {
+    Put<int64_t>(d, out);
+  }
+  const size_t size = tensor.numel() * SizeOfType(tensor.type());
+  Put<uint64_t>(size, out);
+  out->append(reinterpret_cast<const char *>(tensor.data<void>()), size);
+}
+
+bool GetTensor(Reader *reader, Tensor *tensor) {
+  int32_t type = -1;
+  if (!reader->Get(&type) || type >= kWeightTypeCount) {
+    return false;
+  }
+  if (type < 0) {
+    return true;
+  }
+  uint64_t rank = 0;
+  if (!reader->Get(&rank) || rank > 8) {
+    return false;
+  }
+  std::vector<int64_t> dims(rank);
+  for (auto &d : dims) {
+    if (!reader->Get(&d) || d < 0) {
+      return false;
+    }
+  }
+  uint64_t size = 0;
+  if (!reader->Get(&size)) {
+    return false;
+  }
+  tensor->Resize(make_ddim(dims));
+  const std::type_index &type_index = kWeightTypes[type];
+  if (size != tensor->numel() * SizeOfType(type_index)) {
+    return false;
+  }
+  return reader->Read(tensor->mutable_data(type_index), size);
+}
+
+}  // namespace
+
+std::string ModelCache::HashFiles(const std::vector<std::string> &files) {
+  uint64_t hash = kHashBasis;
+  std::vector<char> buffer(1 << 20);
+  for (const auto &file : files) {
+    FILE *fp = fopen(file.c_str(), "rb");
+    if (fp == nullptr) {
+      continue;
+    }
+    uint64_t total = 0;
+    size_t read = 0;
+    while ((read = fread(buffer.data(), 1, buffer.size(), fp)) > 0) {
+      hash = Hash(buffer.data(), read, hash);
+      total += read;
+    }
+    fclose(fp);
+    // the sizes separate the contents of the files
+    hash = Hash(&total, sizeof(total), hash);
+  }
+  return HexString(hash);
+}
+
+std::string ModelCache::HashBuffer(const void *data, size_t size,
+                                   const std::string &seed) {
+  uint64_t hash = Hash(seed.data(), seed.size(), kHashBasis);
+  hash = Hash(data, size, hash);
+  const uint64_t total = size;
+  return HexString(Hash(&total, sizeof(total), hash));
+}
+
+std::vector<std::string> ModelCache::ListFiles(const std::string &dirname) {
+  std::vector<std::string> files;
+  DIR *dir = opendir(dirname.c_str());
+  if (dir == nullptr) {
+    return files;
+  }
+  while (dirent *entry = readdir(dir)) {
+    const std::string path = dirname + "/" + entry->d_name;
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+      files.push_back(path);
+    }
+  }
+  closedir(dir);
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+std::string ModelCache::Key(const std::string &model_hash,
+                            const std::string &options) {
+  const CPUInfo &info = GetCPUInfo();
+  std::string key = "version " + std::to_string(kModelCacheVersion) +
+                    "; model " + model_hash + "; build " + BuildName() +
+                    "; cpu";
+  if (info.avx2) {
+    key += " avx2";
+  }
+  if (info.fma) {
+    key += " fma";
+  }
+  return key + "; " + options;
+}
+
+bool ModelCache::Read(const std::string &filename) {
+  FILE *fp = fopen(filename.c_str(), "rb");
+  if (fp == nullptr) {
+    return false;
+  }
+  std::string content;
+  std::vector<char> buffer(1 << 20);
+  size_t read = 0;
+  while ((read = fread(buffer.data(), 1, buffer.size(), fp)) > 0) {
+    content.append(buffer.data(), read);
+  }
+  fclose(fp);
+
+  Reader reader(content.data(), content.size());
+  char magic[sizeof(kMagic)];
+  std::string key;
+  if (!reader.Read(magic, sizeof(magic)) ||
+      memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !reader.GetString(&key)) {
+    LOG(kLOG_WARNING) << "model cache " << filename << " is damaged";
+    return false;
+  }
+  if (key != key_) {
+    LOG(kLOG_INFO) << "model cache " << filename << " is of another model, "
+                   << "build or cpu";
+    return false;
+  }
+  uint64_t layout_count = 0;
+  bool ok = reader.GetString(&program) && reader.GetString(&params) &&
+            reader.Get(&layout_count);
+  for (uint64_t i = 0; ok && i < layout_count; ++i) {
+    std::string name;
+    int32_t layout = 0;
+    ok = reader.GetString(&name) && reader.Get(&layout);
+    var_layouts.emplace_back(name, static_cast<DataLayout>(layout));
+  }
+  uint64_t kernel_count = 0;
+  ok = ok && reader.Get(&kernel_count);
+  for (uint64_t i = 0; ok && i < kernel_count; ++i) {
+    KernelState state;
+    uint64_t weight_count = 0;
+    ok = reader.GetString(&state.exec_mode) && reader.Get(&weight_count) &&
+         weight_count <= 16;
+    state.weights.resize(ok ? weight_count : 0);
+    for (auto &weight : state.weights) {
+      ok = ok && GetTensor(&reader, &weight);
+    }
+    kernels.push_back(std::move(state));
+  }
+  if (!ok) {
+    LOG(kLOG_WARNING) << "model cache " << filename << " is damaged";
+    program.clear();
+    params.clear();
+    var_layouts.clear();
+    kernels.clear();
+    return false;
+  }
+  restored_ = true;
+  return true;
+}
+
+bool ModelCache::Write(const std::string &filename) const {
+  std::string content(kMagic, sizeof(kMagic));
+  PutString(key_, &content);
+  PutString(program, &content);
+  PutString(params, &content);
+  Put<uint64_t>(var_layouts.size(), &content);
+  for (const auto &var_layout : var_layouts) {
+    PutString(var_layout.first, &content);
+    Put<int32_t>(static_cast<int32_t>(var_layout.second), &content);
+  }
+  Put<uint64_t>(kernels.size(), &content);
+  for (const auto &state : kernels) {
+    PutString(state.exec_mode, &content);
+    Put<uint64_t>(state.weights.size(), &content);
+    for (const auto &weight : state.weights) {
+      PutTensor(weight, &content);
+    }
+  }
+
+  const std::string temp = filename + ".tmp";
+  FILE *fp = fopen(temp.c_str(), "wb");
+  if (fp == nullptr) {
+    LOG(kLOG_WARNING) << "can't write model cache " << filename;
+    return false;
+  }
+  const size_t written = fwrite(content.data(), 1, content.size(), fp);
+  const bool closed = fclose(fp) == 0;
+  if (written != content.size() || !closed ||
+      rename(temp.c_str(), filename.c_str()) != 0) {
+    remove(temp.c_str());
+    LOG(kLOG_WARNING) << "can't write model cache " << filename;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -0,0 +1,81 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "framework/data_layout.h"
+#include "framework/tensor.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// ModelCache keeps what loading a model derives from it before the first
+// prediction: the program after the fusion, graph and layout passes, its
+// weights after folding, and for every operator the implementation and the
+// weights its kernel Init picked and derived, such as packed or winograd
+// transformed filters. The executor records them into an empty cache and
+// restores them from a read one, see Executor.
+//
+// A cache file is only read back under the key it was written with, which
+// covers the model files, the cache format, the build and the cpu features.
+class ModelCache {
+ public:
+  struct KernelState {
+    std::string exec_mode;
+    // one entry for every OperatorBase::KernelWeights, uninitialized if the
+    // kernel derived nothing there
+    std::vector<Tensor> weights;
+  };
+
+  // hash of the contents of the files, in the given order
+  static std::string HashFiles(const std::vector<std::string> &files);
+  static std::string HashBuffer(const void *data, size_t size,
+                                const std::string &seed = "");
+  // the regular files of a directory sorted by name
+  static std::vector<std::string> ListFiles(const std::string &dirname);
+  // the key of a model of the hash under the load options, extended with the
+  // format version, the build and the cpu features
+  static std::string Key(const std::string &model_hash,
+                         const std::string &options);
+
+  explicit ModelCache(const std::string &key) : key_(key) {}
+
+  // reads the cache file, false if it is missing, damaged or of another key
+  bool Read(const std::string &filename);
+  // writes the cache file through a temporary file, so that a concurrent
+  // reader never sees a partial one. false if it can not be written.
+  bool Write(const std::string &filename) const;
+
+  // set if Read succeeded, the executor restores from the cache then
+  bool Restored() const { return restored_; }
+
+  // the optimized program in the format of __model__
+  std::string program;
+  // its persistable variables in the format of combined params
+  std::string params;
+  // blocked layouts of the variables, see LayoutOptPass
+  std::vector<std::pair<std::string, DataLayout>> var_layouts;
+  // one entry for every operator of the program in the order of the blocks
+  std::vector<KernelState> kernels;
+
+ private:
+  std::string key_;
+  bool restored_ = false;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -0,0 +1,230 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "framework/model_writer.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "common/enforce.h"
+#include "framework/attribute.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+namespace {
+
+// protobuf wire types
+enum WireType { WIRE_VARINT = 0, WIRE_FIXED32 = 5, WIRE_BYTES = 2 };
+
+void PutVarint(uint64_t value, std::string *out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void PutTag(int field, WireType type, std::string *out) {
+  PutVarint((static_cast<uint64_t>(field) << 3) | type, out);
+}
+
+// int32 and int64 fields are varints of the 64 bits two's complement
+void PutInt(int field, int64_t value, std::string *out) {
+  PutTag(field, WIRE_VARINT, out);
+  PutVarint(static_cast<uint64_t>(value), out);
+}
+
+void PutFloat(int field, float value, std::string *out) {
+  PutTag(field, WIRE_FIXED32, out);
+  char bytes[sizeof(float)];
+  memcpy(bytes, &value, sizeof(float));
+  out->append(bytes, sizeof(float));
+}
+
+void PutBytes(int field, const std::string &value, std::string *out) {
+  PutTag(field, WIRE_BYTES, out);
+  PutVarint(value.size(), out);
+  out->append(value);
+}
+
+std::string TensorDescMessage(const TensorDesc &desc) {
+  std::string msg;
+  PutInt(1, desc.DataType(), &msg);
+  for (int64_t dim : desc.Dims()) {
+    PutInt(2, dim, &msg);
+  }
+  return msg;
+}
+
+// the attribute fields of the variant type held
+struct AttrEncoder {
+  typedef void type_t;
+  std::string *msg;
+
+  void operator()(int value) {
+    PutInt(2, PADDLE_MOBILE__FRAMEWORK__PROTO__ATTR_TYPE__INT, msg);
+    PutInt(3, value, msg);
+  }
+  void operator()(float value) {
+    PutInt(2, PADDLE_MOBILE__FRAMEWORK__PROTO__ATTR_TYPE__FLOAT, msg);
+    PutFloat(4, value, msg);
+  }
+  void operator()(const std::string &value) {
+    PutInt(2, PADDLE_MOBILE__FRAMEWORK__PROTO__ATTR_TYPE__STRING, msg);
+    PutBytes(5, value, msg);
+  }
+  void operator()(const std::vector<int> &value) {
+    PutInt(2, PADDLE_MOBILE__FRAMEWORK__PROTO__ATTR_TYPE__INTS, msg);
+    for (int v : value) {
+      PutInt(6, v, msg);
+    }
+  }
+  void operator()(const std::vector<float> &value) {
+    PutInt(2, PADDLE_MOBILE__FRAMEWORK__PROTO__ATTR_TYPE__FLOATS, msg);
+    for (float v : value) {
+      PutFloat(7, v, msg);
+    }
+  }
+  void operator()(const std::vector<std::string> &value) {
+    PutInt(2, PADDLE_MOBILE__FRAMEWORK__PROTO__ATTR_TYPE__STRINGS, msg);
+    for (const auto &v : value) {
+      PutBytes(8, v, msg);
+    }
+  }
+  void operator()(bool value) {
+    PutInt(2, PADDLE_MOBILE__FRAMEWORK__PROTO__ATTR_TYPE__BOOLEAN, msg);
+    PutInt(10, value, msg);
+  }
+  void operator()(const std::vector<bool> &value) {
+    PutInt(2, PADDLE_MOBILE__FRAMEWORK__PROTO__ATTR_TYPE__BOOLEANS, msg);
+    for (bool v : value) {
+      PutInt(11, v, msg);
+    }
+  }
+  void operator()(int64_t value) {
+    PutInt(2, PADDLE_MOBILE__FRAMEWORK__PROTO__ATTR_TYPE__LONG, msg);
+    PutInt(13, value, msg);
+  }
+};
+
+std::string OpVarMessage(const std::string &parameter,
+                         const std::vector<std::string> &arguments) {
+  std::string msg;
+  PutBytes(1, parameter, &msg);
+  for (const auto &argument : arguments) {
+    PutBytes(2, argument, &msg);
+  }
+  return msg;
+}
+
+std::string OpMessage(OpDesc *op) {
+  std::string msg;
+  for (const auto &input : op->GetInputs()) {
+    PutBytes(1, OpVarMessage(input.first, input.second), &msg);
+  }
+  for (const auto &output : op->GetOutputs()) {
+    PutBytes(2, OpVarMessage(output.first, output.second), &msg);
+  }
+  PutBytes(3, op->Type(), &msg);
+  for (const auto &attr : op->GetAttrMap()) {
+    std::string attr_msg;
+    PutBytes(1, attr.first, &attr_msg);
+    Attribute::ApplyVistor(AttrEncoder{&attr_msg}, attr.second);
+    PutBytes(4, attr_msg, &msg);
+  }
+  return msg;
+}
+
+std::string VarMessage(const VarDesc &var) {
+  std::string type;
+  PutInt(1, var.Type(), &type);
+  std::string tensor = TensorDescMessage(var.Tensor_desc());
+  switch (var.Type()) {
+    case VARTYPE_TYPE_LOD_TENSOR:
+    case VARTYPE_TYPE_STEP_LOD_TENSOR_ARRAY: {
+      // lod tensor and lod tensor array descs have the same fields
+      std::string lod_tensor;
+      PutBytes(1, tensor, &lod_tensor);
+      int field = var.Type() == VARTYPE_TYPE_LOD_TENSOR ? 3 : 4;
+      PutBytes(field, lod_tensor, &type);
+      break;
+    }
+    case VARTYPE_TYPE_SELECTED_ROWS:
+      PutBytes(2, tensor, &type);
+      break;
+    default:
+      break;
+  }
+  std::string msg;
+  PutBytes(1, var.Name(), &msg);
+  PutBytes(2, type, &msg);
+  PutInt(3, var.Persistable(), &msg);
+  return msg;
+}
+
+}  // namespace
+
+std::string SerializeProgram(ProgramDesc *program) {
+  std::string msg;
+  for (const auto &block : program->Blocks()) {
+    std::string block_msg;
+    PutInt(1, block->ID(), &block_msg);
+    PutInt(2, block->Parent(), &block_msg);
+    for (const auto &var : block->Vars()) {
+      PutBytes(3, VarMessage(*var), &block_msg);
+    }
+    for (const auto &op : block->Ops()) {
+      PutBytes(4, OpMessage(op.get()), &block_msg);
+    }
+    PutBytes(1, block_msg, &msg);
+  }
+  return msg;
+}
+
+void SerializeTensor(const LoDTensor &tensor, VarType_Type data_type,
+                     std::string *out) {
+  auto append = [out](const void *data, size_t size) {
+    out->append(reinterpret_cast<const char *>(data), size);
+  };
+  const uint32_t version = 0;
+  append(&version, sizeof(uint32_t));
+  const uint64_t lod_level = tensor.lod().size();
+  append(&lod_level, sizeof(uint64_t));
+  for (const auto &level : tensor.lod()) {
+    const uint64_t size = level.size() * sizeof(size_t);
+    append(&size, sizeof(uint64_t));
+    append(level.data(), size);
+  }
+  append(&version, sizeof(uint32_t));
+
+  std::vector<int64_t> dims = vectorize(tensor.dims());
+  const std::string desc = TensorDescMessage(TensorDesc(data_type, dims));
+  const int32_t desc_size = desc.size();
+  append(&desc_size, sizeof(int32_t));
+  out->append(desc);
+  append(tensor.data<void>(), tensor.numel() * SizeOfType(tensor.type()));
+}
+
+void WriteFile(const std::string &filename, const std::string &content) {
+  FILE *file = fopen(filename.c_str(), "wb");
+  PADDLE_MOBILE_ENFORCE(file != nullptr, "can't open file: %s",
+                        filename.c_str());
+  size_t written = fwrite(content.data(), 1, content.size(), file);
+  fclose(file);
+  PADDLE_MOBILE_ENFORCE(written == content.size(), "can't write file: %s",
+                        filename.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -0,0 +1,38 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+#include "framework/lod_tensor.h"
+#include "framework/program/program_desc.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// Encodes the program in the protobuf format of the fluid __model__ file.
+// The bundled protobuf-c only unpacks messages, so the wire format is
+// written here directly from the descriptors.
+std::string SerializeProgram(ProgramDesc *program);
+
+// Appends the tensor in the format read by Executor::LoadMemory, which is
+// the format of a separate param file and of one entry of combined params.
+void SerializeTensor(const LoDTensor &tensor, VarType_Type data_type,
+                     std::string *out);
+
+// writes the bytes to the file, throws if it can not be written
+void WriteFile(const std::string &filename, const std::string &content);
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -0,0 +1,89 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "framework/op_dag.h"
+#include <algorithm>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace paddle_mobile {
+namespace framework {
+
+OpDAG::OpDAG(const std::vector<std::shared_ptr<OpDesc>> &ops) {
+  const int size = static_cast<int>(ops.size());
+  successors_.resize(size);
+  in_degree_.resize(size, 0);
+
+  // the last op writing each variable, and the ops reading it since then
+  std::unordered_map<std::string, int> writer;
+  std::unordered_map<std::string, std::vector<int>> readers;
+  for (int i = 0; i < size; ++i) {
+    std::set<int> predecessors;
+    for (const auto &input : ops[i]->GetInputs()) {
+      for (const auto &name : input.second) {
+        auto it = writer.find(name);
+        if (it != writer.end()) {
+          predecessors.insert(it->second);
+        }
+        readers[name].push_back(i);
+      }
+    }
+    for (const auto &output : ops[i]->GetOutputs()) {
+      for (const auto &name : output.second) {
+        auto it = writer.find(name);
+        if (it != writer.end()) {
+          predecessors.insert(it->second);
+        }
+        for (int reader : readers[name]) {
+          predecessors.insert(reader);
+        }
+        writer[name] = i;
+        readers[name].clear();
+      }
+    }
+    predecessors.erase(i);
+    for (int predecessor : predecessors) {
+      successors_[predecessor].push_back(i);
+    }
+    in_degree_[i] = static_cast<int>(predecessors.size());
+  }
+
+  // every edge goes from a lower index to a higher one, so the reverse op
+  // order visits all successors of an op before the op
+  const int words = (size + 63) / 64;
+  reach_.assign(size, std::vector<uint64_t>(words, 0));
+  height_.assign(size, 1);
+  for (int i = size - 1; i >= 0; --i) {
+    for (int successor : successors_[i]) {
+      reach_[i][successor / 64] |= uint64_t(1) << (successor % 64);
+      for (int w = 0; w < words; ++w) {
+        reach_[i][w] |= reach_[successor][w];
+      }
+      height_[i] = std::max(height_[i], height_[successor] + 1);
+    }
+  }
+
+  std::vector<int> depth(size, 0);
+  std::vector<int> ops_of_depth(size + 1, 0);
+  for (int i = 0; i < size; ++i) {
+    for (int successor : successors_[i]) {
+      depth[successor] = std::max(depth[successor], depth[i] + 1);
+    }
+    width_ = std::max(width_, ++ops_of_depth[depth[i]]);
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -0,0 +1,59 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "framework/program/op_desc.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// OpDAG holds the dependencies between the ops of a block. An op depends on
+// an earlier op if it reads a variable the earlier op writes, or writes a
+// variable the earlier op reads or writes. Every order of the ops which
+// keeps the dependencies computes the same results as the op list.
+class OpDAG {
+ public:
+  explicit OpDAG(const std::vector<std::shared_ptr<OpDesc>> &ops);
+
+  int Size() const { return static_cast<int>(successors_.size()); }
+  const std::vector<int> &Successors(int op) const { return successors_[op]; }
+  // the number of ops op depends on directly
+  int InDegree(int op) const { return in_degree_[op]; }
+  // the number of ops on the longest path from op to the end of the block,
+  // ops of a higher height are on the critical path
+  int Height(int op) const { return height_[op]; }
+  // the most ops of the same depth, an estimate of how many ops can run at
+  // the same time
+  int Width() const { return width_; }
+
+  // whether op `after` can only start once op `before` finished
+  bool Precedes(int before, int after) const {
+    return (reach_[before][after / 64] >> (after % 64)) & 1;
+  }
+
+ private:
+  std::vector<std::vector<int>> successors_;
+  std::vector<int> in_degree_;
+  std::vector<int> height_;
+  // bit j of reach_[i] is set if op j depends on op i through any path
+  std::vector<std::vector<uint64_t>> reach_;
+  int width_ = 0;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
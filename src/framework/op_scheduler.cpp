@@ -0,0 +1,130 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "framework/op_scheduler.h"
+#include <algorithm>
+
+namespace paddle_mobile {
+namespace framework {
+
+OpScheduler::OpScheduler(const OpDAG *dag, int inter_op_threads,
+                         int intra_op_threads)
+    : dag_(dag) {
+  inter_op_threads = std::max(inter_op_threads, 1);
+  for (int i = 0; i < inter_op_threads; ++i) {
+    pools_.emplace_back(new ThreadPool(intra_op_threads));
+    workspaces_.emplace_back(new Workspace);
+  }
+  for (int i = 1; i < inter_op_threads; ++i) {
+    workers_.emplace_back(&OpScheduler::WorkerLoop, this, i);
+  }
+}
+
+OpScheduler::~OpScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  for (std::thread &worker : workers_) {
+    worker.join();
+  }
+}
+
+void OpScheduler::WorkerLoop(int id) {
+  ThreadPool::Bind(pools_[id].get());
+  Workspace::Bind(workspaces_[id].get());
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [&] { return stop_ || !ready_.empty(); });
+    if (stop_) {
+      return;
+    }
+    RunReadyOp(&lock);
+  }
+}
+
+void OpScheduler::RunReadyOp(std::unique_lock<std::mutex> *lock) {
+  const int op = -ready_.top().second;
+  ready_.pop();
+  const bool skip = error_ != nullptr;
+  lock->unlock();
+  std::exception_ptr error;
+  if (!skip) {
+    try {
+      (*run_op_)(op);
+    } catch (...) {
+      error = std::current_exception();
+    }
+  }
+  lock->lock();
+  if (error != nullptr && error_ == nullptr) {
+    error_ = error;
+  }
+  int released = 0;
+  for (int successor : dag_->Successors(op)) {
+    if (--in_degree_[successor] == 0) {
+      ready_.emplace(dag_->Height(successor), -successor);
+      ++released;
+    }
+  }
+  if (--remaining_ == 0) {
+    // wake up the thread waiting in Run
+    cond_.notify_all();
+  } else if (released > 1) {
+    // this thread takes one of them itself
+    for (int i = 1; i < released; ++i) {
+      cond_.notify_one();
+    }
+  }
+}
+
+void OpScheduler::Run(const std::function<void(int)> &run_op) {
+  if (dag_->Size() == 0) {
+    return;
+  }
+  ThreadPool *previous = ThreadPool::Bind(pools_[0].get());
+  Workspace *previous_workspace = Workspace::Bind(workspaces_[0].get());
+  std::unique_lock<std::mutex> lock(mutex_);
+  run_op_ = &run_op;
+  error_ = nullptr;
+  remaining_ = dag_->Size();
+  in_degree_.resize(dag_->Size());
+  for (int i = 0; i < dag_->Size(); ++i) {
+    in_degree_[i] = dag_->InDegree(i);
+    if (in_degree_[i] == 0) {
+      ready_.emplace(dag_->Height(i), -i);
+    }
+  }
+  cond_.notify_all();
+  while (remaining_ > 0) {
+    if (ready_.empty()) {
+      cond_.wait(lock, [&] { return remaining_ == 0 || !ready_.empty(); });
+      continue;
+    }
+    RunReadyOp(&lock);
+  }
+  run_op_ = nullptr;
+  std::exception_ptr error = error_;
+  error_ = nullptr;
+  lock.unlock();
+  ThreadPool::Bind(previous);
+  Workspace::Bind(previous_workspace);
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
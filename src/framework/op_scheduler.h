@@ -0,0 +1,77 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "common/threadpool.h"
+#include "framework/op_dag.h"
+#include "framework/workspace.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// OpScheduler runs the ops of a dag on inter_op_threads threads, an op starts
+// as soon as all the ops it depends on finished. The thread calling Run is
+// one of them. Each of the threads owns a ThreadPool of intra_op_threads
+// threads for the parallel regions of its kernels, so the cores are divided
+// between the ops running at the same time instead of being fought over,
+// and a Workspace for their temporaries.
+class OpScheduler {
+ public:
+  OpScheduler(const OpDAG *dag, int inter_op_threads, int intra_op_threads);
+  ~OpScheduler();
+
+  int InterOpThreads() const { return static_cast<int>(pools_.size()); }
+  int IntraOpThreads() const { return pools_[0]->ThreadNum(); }
+
+  // calls run_op(i) for every op i of the dag and returns once all of them
+  // finished. If run_op throws, the ops not started yet are skipped and the
+  // first exception is thrown again here.
+  void Run(const std::function<void(int)> &run_op);
+
+ private:
+  void WorkerLoop(int id);
+  // pops a ready op, runs it and releases its successors, the lock is
+  // dropped while the op runs
+  void RunReadyOp(std::unique_lock<std::mutex> *lock);
+
+  const OpDAG *dag_;
+  // pools_[0] and workspaces_[0] serve the thread calling Run
+  std::vector<std::unique_ptr<ThreadPool>> pools_;
+  std::vector<std::unique_ptr<Workspace>> workspaces_;
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  // ready ops by height then by the lower index, the critical path first
+  std::priority_queue<std::pair<int, int>> ready_;
+  std::vector<int> in_degree_;
+  const std::function<void(int)> *run_op_ = nullptr;
+  // ops of the current run which have not finished
+  int remaining_ = 0;
+  std::exception_ptr error_;
+  bool stop_ = false;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -28,6 +28,7 @@ limitations under the License. */
 #include "framework/op_info.h"
 #include "framework/op_kernel_type.h"
 #include "framework/op_registry.h"
+#include "framework/packed_weight.h"
 #include "framework/program/block_desc.h"
 #include "framework/program/program-optimize/node.h"
 #include "framework/scope.h"
@@ -62,8 +63,25 @@ class OperatorBase {
   virtual ~OperatorBase() {}
 
   virtual void Init() = 0;
+  // init like `op`, the same operator of another executor of the program,
+  // and share the read only data its kernel derived from the weights
+  virtual void InitFrom(const OperatorBase<Dtype> *op) { Init(); }
   virtual void InferShape() const = 0;
   virtual void Run();
+  // the kernel implementation chosen at Init, empty if there is no choice
+  virtual std::string ExecModeName() const { return ""; }
+  // the data kernel Init derives from the weights, such as packed or
+  // transformed filters. A ModelCache saves it after Init and fills it
+  // before Init of a later load, which keeps the tensors already filled.
+  virtual std::vector<Tensor *> KernelWeights() { return {}; }
+  // picks the implementation named by ExecModeName before Init
+  virtual void SetExecModeName(const std::string &name) {}
+  // picks the implementation again for the shapes inferred for a new input
+  // shape, by running Init again if the kernel depends on them
+  virtual void Replan() {}
+  // the weights kernel Init packed for the float gemm and the tables the
+  // kernel also reads as half
+  virtual std::vector<PackedWeight> PackedWeights() { return {}; }
   virtual void RunImpl() = 0;
 
   std::vector<std::string> GetOutKeys() const;
@@ -136,6 +154,30 @@ class OperatorWithKernel : public OperatorBase<Dtype> {
                           this->type_.c_str());
   }
 
+  std::string ExecModeName() const { return param_.ExecModeName(); }
+
+  std::vector<Tensor *> KernelWeights() { return param_.KernelWeights(); }
+
+  void SetExecModeName(const std::string &name) {
+    param_.SetExecModeName(name);
+  }
+
+  std::vector<PackedWeight> PackedWeights() { return param_.PackedWeights(); }
+
+  void Replan() {
+    if (param_.ResetExecMode()) {
+      Init();
+    }
+  }
+
+  void InitFrom(const OperatorBase<Dtype> *op) {
+    auto *shared = dynamic_cast<const OperatorWithKernel *>(op);
+    if (shared != nullptr) {
+      param_.ShareWeightsFrom(shared->param_);
+    }
+    Init();
+  }
+
  protected:
   KernelType kernel_;
   ParamType param_;
@@ -192,6 +234,9 @@ class FusionOpMatcher {
 
   virtual std::vector<std::pair<int, std::string>> NeedCheck() { return {}; }
 
+  // checks the op descs of the matched nodes before folding them
+  virtual bool Fusible(Node *node) { return true; }
+
  protected:
   Node node_;
   std::string type_;
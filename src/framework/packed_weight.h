@@ -0,0 +1,41 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+#include "framework/tensor.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// a weight kernel Init packed for the float gemm, which the executor may
+// compress or store as half, see OperatorBase::PackedWeights. A table the
+// kernel reads as it is, such as the one of lookup_table, may be stored as
+// half too.
+struct PackedWeight {
+  // the packed matrices of the groups, one in every row
+  Tensor *packed;
+  // packed as the A of the gemm, such as conv filters, or as the B, such as
+  // fc weights
+  bool packed_a;
+  // the depth of the gemm
+  int k;
+  // the input the weight was packed from, the kernel does not read it
+  // again. A table is the tensor of the input itself.
+  std::string input;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
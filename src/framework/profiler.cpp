@@ -0,0 +1,172 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "framework/profiler.h"
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <sstream>
+
+namespace paddle_mobile {
+namespace framework {
+
+namespace {
+
+std::string DimsToString(const std::vector<int64_t> &dims) {
+  std::string str = "[";
+  for (int i = 0; i < dims.size(); ++i) {
+    str += (i == 0 ? "" : ",") + std::to_string(dims[i]);
+  }
+  return str + "]";
+}
+
+std::string DimsListToString(const std::vector<std::vector<int64_t>> &list) {
+  std::string str;
+  for (int i = 0; i < list.size(); ++i) {
+    str += (i == 0 ? "" : " ") + DimsToString(list[i]);
+  }
+  return str;
+}
+
+// the profile of an operator over all runs
+struct OpSummary {
+  const OpProfile *last = nullptr;
+  int count = 0;
+  uint64_t time = 0;
+  double flops = 0;
+  double bytes = 0;
+};
+
+}  // namespace
+
+void Profiler::Enable(bool enable) {
+  if (enable && !enabled_) {
+    Clear();
+  }
+  enabled_ = enable;
+}
+
+void Profiler::Clear() {
+  runs_ = 0;
+  profiles_.clear();
+}
+
+uint64_t Profiler::Now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000UL + ts.tv_nsec;
+}
+
+int Profiler::ThreadId() {
+  static std::atomic<int> next_id(0);
+  thread_local int id = next_id++;
+  return id;
+}
+
+std::string Profiler::ChromeTrace() const {
+  uint64_t start = profiles_.empty() ? 0 : profiles_[0].begin;
+  for (const auto &profile : profiles_) {
+    start = std::min(start, profile.begin);
+  }
+  std::ostringstream os;
+  os.precision(15);
+  os << "{\"traceEvents\":[";
+  for (int i = 0; i < profiles_.size(); ++i) {
+    const OpProfile &profile = profiles_[i];
+    // trace events are in microseconds
+    os << (i == 0 ? "" : ",") << "\n{\"name\":\"" << profile.type
+       << "\",\"cat\":\"op\",\"ph\":\"X\",\"pid\":0,\"tid\":" << profile.tid
+       << ",\"ts\":" << (profile.begin - start) / 1000.0
+       << ",\"dur\":" << (profile.end - profile.begin) / 1000.0
+       << ",\"args\":{\"index\":" << profile.index
+       << ",\"run\":" << profile.run << ",\"exec_mode\":\""
+       << profile.exec_mode << "\",\"inputs\":\""
+       << DimsListToString(profile.input_dims) << "\",\"outputs\":\""
+       << DimsListToString(profile.output_dims)
+       << "\",\"flops\":" << profile.flops << ",\"bytes\":" << profile.bytes
+       << "}}";
+  }
+  os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return os.str();
+}
+
+std::string Profiler::Summary(double peak_gflops, double peak_gbps) const {
+  std::map<int, OpSummary> ops;
+  std::map<std::string, uint64_t> types;
+  uint64_t total = 0;
+  for (const auto &profile : profiles_) {
+    OpSummary &op = ops[profile.index];
+    op.last = &profile;
+    op.count += 1;
+    op.time += profile.end - profile.begin;
+    op.flops += profile.flops;
+    op.bytes += profile.bytes;
+    types[profile.type] += profile.end - profile.begin;
+    total += profile.end - profile.begin;
+  }
+  const bool roofline = peak_gflops > 0 && peak_gbps > 0;
+
+  std::string summary;
+  char line[512];
+  snprintf(line, sizeof(line), "%5s  %-20s %-22s %10s %8s %8s %9s", "index",
+           "type", "exec mode", "time(ms)", "GFLOPS", "GB/s", "flops/B");
+  summary += line;
+  summary += roofline ? "  bound    attain%  output\n" : "  output\n";
+  for (const auto &pair : ops) {
+    const OpSummary &op = pair.second;
+    const double time = static_cast<double>(op.time) / op.count;
+    // flops per nanosecond equals GFLOPS
+    const double gflops = time > 0 ? op.flops / op.count / time : 0;
+    const double gbps = time > 0 ? op.bytes / op.count / time : 0;
+    const double intensity = op.bytes > 0 ? op.flops / op.bytes : 0;
+    snprintf(line, sizeof(line), "%5d  %-20s %-22s %10.4f %8.3f %8.3f %9.3f",
+             pair.first, op.last->type.c_str(), op.last->exec_mode.c_str(),
+             time / 1e6, gflops, gbps, intensity);
+    summary += line;
+    if (roofline) {
+      const bool memory_bound = intensity < peak_gflops / peak_gbps;
+      const double attainable =
+          std::min(peak_gflops, intensity * peak_gbps);
+      snprintf(line, sizeof(line), "  %-8s %7.2f",
+               memory_bound ? "memory" : "compute",
+               attainable > 0 ? gflops / attainable * 100 : 0);
+      summary += line;
+    }
+    summary += "  " + DimsListToString(op.last->output_dims) + "\n";
+  }
+
+  std::vector<std::pair<std::string, uint64_t>> sorted(types.begin(),
+                                                       types.end());
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const std::pair<std::string, uint64_t> &a,
+                      const std::pair<std::string, uint64_t> &b) {
+                     return a.second > b.second;
+                   });
+  sorted.push_back(std::make_pair("total", total));
+  const int runs = std::max(runs_, 1);
+  summary += "====================[ profile ]======================\n";
+  for (const auto &pair : sorted) {
+    snprintf(line, sizeof(line), "%-20s\t%-10.4f\t%-2.4f\n",
+             pair.first.c_str(), pair.second / 1e6 / runs,
+             total > 0 ? pair.second * 100.0 / total : 0);
+    summary += line;
+  }
+  summary += "====================[---------]======================\n";
+  return summary;
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
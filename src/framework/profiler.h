@@ -0,0 +1,86 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace paddle_mobile {
+namespace framework {
+
+// one run of an operator
+struct OpProfile {
+  // index of the operator in the program
+  int index = 0;
+  // index of the prediction since the profiler was enabled
+  int run = 0;
+  std::string type;
+  // kernel implementation chosen at Init, empty if the op has no choice
+  std::string exec_mode;
+  // nanoseconds of a monotonic clock
+  uint64_t begin = 0;
+  uint64_t end = 0;
+  // small id of the thread which runs the operator
+  int tid = 0;
+  std::vector<std::vector<int64_t>> input_dims;
+  std::vector<std::vector<int64_t>> output_dims;
+  // estimated float operations, and bytes of all inputs and outputs
+  double flops = 0;
+  double bytes = 0;
+};
+
+// Profiler records every operator run of an executor while it is enabled.
+// It is switched at runtime, a disabled profiler only costs a flag check
+// per operator.
+class Profiler {
+ public:
+  // enabling drops the profiles recorded before
+  void Enable(bool enable);
+  bool Enabled() const { return enabled_; }
+  void Clear();
+
+  // starts a new prediction and returns its run index
+  int BeginRun() { return runs_++; }
+  // ops running at the same time record from their own threads
+  void Record(OpProfile &&profile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    profiles_.push_back(std::move(profile));
+  }
+  const std::vector<OpProfile> &Profiles() const { return profiles_; }
+
+  // trace event json, which can be opened by chrome://tracing or perfetto
+  std::string ChromeTrace() const;
+
+  // average time, GFLOPS, GB/s and flops per byte of every operator over all
+  // runs, followed by the time of every op type. With the peak GFLOPS and
+  // GB/s of the device, it also reports the roofline bound of each operator
+  // and the fraction of the attainable performance.
+  std::string Summary(double peak_gflops = 0, double peak_gbps = 0) const;
+
+  static uint64_t Now();
+  static int ThreadId();
+
+ private:
+  bool enabled_ = false;
+  int runs_ = 0;
+  std::vector<OpProfile> profiles_;
+  std::mutex mutex_;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -22,6 +22,27 @@ std::vector<std::shared_ptr<VarDesc>> BlockDesc::Vars() const { return vars_; }
 
 std::vector<std::shared_ptr<OpDesc>> BlockDesc::Ops() const { return ops_; }
 
+void BlockDesc::SetVar(const std::shared_ptr<VarDesc> &var_desc) {
+  auto it = std::lower_bound(
+      vars_.begin(), vars_.end(), var_desc->Name(),
+      [](const std::shared_ptr<VarDesc> &var, const std::string &name) {
+        return var->Name() < name;
+      });
+  if (it != vars_.end() && (*it)->Name() == var_desc->Name()) {
+    *it = var_desc;
+  } else {
+    vars_.insert(it, var_desc);
+  }
+}
+
+void BlockDesc::RemoveVar(const std::string &name) {
+  vars_.erase(std::remove_if(vars_.begin(), vars_.end(),
+                             [&](const std::shared_ptr<VarDesc> &var) {
+                               return var->Name() == name;
+                             }),
+              vars_.end());
+}
+
 BlockDesc::BlockDesc(PaddleMobile__Framework__Proto__BlockDesc *desc)
     : index_(desc->idx), parent_index_(desc->idx) {
   for (int i = 0; i < desc->n_vars; ++i) {
@@ -57,6 +57,12 @@ class BlockDesc {
   std::vector<std::shared_ptr<VarDesc>> Vars() const;
   std::vector<std::shared_ptr<OpDesc>> Ops() const;
 
+  // for program rewriting, the variables are kept sorted by name as the
+  // combined params are
+  void SetOps(const std::vector<std::shared_ptr<OpDesc>> &ops) { ops_ = ops; }
+  void SetVar(const std::shared_ptr<VarDesc> &var_desc);
+  void RemoveVar(const std::string &name);
+
  private:
   int index_;
   bool multi_thread_;
@@ -37,6 +37,7 @@ class OpDesc {
   }
 
   OpDesc() {}
+  explicit OpDesc(const std::string &type) : type_(type) {}
   const std::vector<std::string> &Input(const std::string &name) const;
   const std::vector<std::string> &Output(const std::string &name) const;
   Attribute GetAttr(const std::string &name) const;
@@ -122,7 +122,7 @@ std::shared_ptr<ProgramDesc> ProgramOptimize::FusionOptimize(
             }
           }
 
-          if (!can_folder) {
+          if (!can_folder || !matcher->Fusible(match_node.get())) {
             continue;
           }
 
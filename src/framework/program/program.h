@@ -14,10 +14,12 @@ limitations under the License. */
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "common/types.h"
 #include "framework/program/program_desc.h"
 #include "framework/scope.h"
+#include "framework/stream_reader.h"
 
 namespace paddle_mobile {
 namespace framework {
@@ -34,6 +36,8 @@ class Program {
   bool quantification = false;
   size_t combined_params_len;
   uint8_t *combined_params_buf;
+  // reads the combined params instead of para_path, see Loader::LoadStream
+  std::shared_ptr<StreamReader> params_reader;
 };
 
 }  // namespace framework
@@ -49,6 +49,8 @@ enum VarType_Type {
 class TensorDesc {
  public:
   TensorDesc() = default;
+  TensorDesc(VarType_Type data_type, const std::vector<int64_t> &dims)
+      : dims_(dims), data_type_(data_type) {}
   TensorDesc(const TensorDesc &desc) {
     this->dims_ = desc.dims_;
     this->data_type_ = desc.data_type_;
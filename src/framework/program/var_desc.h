@@ -32,6 +32,15 @@ class VarDesc {
     this->type_ = var_desc.type_;
   }
 
+  // a lod tensor variable created by program rewriting
+  VarDesc(const std::string &name, VarType_Type data_type,
+          const std::vector<int64_t> &dims, bool persistable)
+      : name_(name),
+        persistable_(persistable),
+        tensor_desc_(data_type, dims),
+        type_(VARTYPE_TYPE_LOD_TENSOR),
+        data_type_(data_type) {}
+
   VarDesc(PaddleMobile__Framework__Proto__VarDesc *desc) {
     type_ = (VarType_Type)desc->type->type;
     name_ = std::string(desc->name);
@@ -66,6 +75,9 @@ class VarDesc {
 
   bool Persistable() const { return persistable_; }
 
+  // for program rewriting, such as an activation folded into a constant
+  void SetPersistable(bool persistable) { persistable_ = persistable; }
+
   const TensorDesc &Tensor_desc() const { return tensor_desc_; }
 
  private:
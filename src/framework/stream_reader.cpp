@@ -0,0 +1,99 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "framework/stream_reader.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace paddle_mobile {
+namespace framework {
+
+StreamReader::StreamReader(const StreamReadFunc &read, size_t chunk_size,
+                           int chunk_count)
+    : read_(read), chunk_size_(std::max<size_t>(chunk_size, 1)) {
+  free_.resize(std::max(chunk_count, 1));
+  thread_ = std::thread(&StreamReader::ReadLoop, this);
+}
+
+StreamReader::~StreamReader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  thread_.join();
+}
+
+void StreamReader::ReadLoop() {
+  while (true) {
+    std::vector<char> chunk;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] { return stop_ || !free_.empty(); });
+      if (stop_) {
+        return;
+      }
+      chunk = std::move(free_.back());
+      free_.pop_back();
+    }
+    // the callback may return less than asked before the end
+    chunk.resize(chunk_size_);
+    size_t filled = 0;
+    size_t read = 0;
+    while (filled < chunk.size() &&
+           (read = read_(chunk.data() + filled, chunk.size() - filled)) > 0) {
+      filled += read;
+    }
+    chunk.resize(filled);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (filled > 0) {
+        filled_.push_back(std::move(chunk));
+      }
+      end_ = filled < chunk_size_;
+    }
+    cond_.notify_all();
+    if (filled < chunk_size_) {
+      return;
+    }
+  }
+}
+
+bool StreamReader::Read(void *data, size_t size) {
+  char *out = reinterpret_cast<char *>(data);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (size > 0) {
+    cond_.wait(lock, [this] { return end_ || !filled_.empty(); });
+    if (filled_.empty()) {
+      return false;
+    }
+    std::vector<char> &chunk = filled_.front();
+    const size_t count = std::min(size, chunk.size() - offset_);
+    memcpy(out, chunk.data() + offset_, count);
+    out += count;
+    size -= count;
+    offset_ += count;
+    if (offset_ == chunk.size()) {
+      free_.push_back(std::move(chunk));
+      filled_.pop_front();
+      offset_ = 0;
+      cond_.notify_all();
+    }
+  }
+  return true;
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
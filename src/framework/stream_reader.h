@@ -0,0 +1,63 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace paddle_mobile {
+namespace framework {
+
+// copies up to size bytes of a stream to buffer and returns the count, 0 at
+// the end of the stream
+typedef std::function<size_t(void *buffer, size_t size)> StreamReadFunc;
+
+// StreamReader calls a StreamReadFunc on a background thread to fill a few
+// chunks ahead of the reads, so that producing the bytes, such as
+// downloading, decompressing or decrypting them, overlaps with consuming the
+// ones before. At most chunk_count chunks are held at a time.
+class StreamReader {
+ public:
+  explicit StreamReader(const StreamReadFunc &read,
+                        size_t chunk_size = 1 << 20, int chunk_count = 4);
+  // stops reading ahead once the current call of read returned
+  ~StreamReader();
+
+  // copies the next size bytes to data, false if the stream ends before
+  bool Read(void *data, size_t size);
+
+ private:
+  void ReadLoop();
+
+  StreamReadFunc read_;
+  size_t chunk_size_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::vector<char>> filled_;
+  std::vector<std::vector<char>> free_;
+  // read position in filled_.front()
+  size_t offset_ = 0;
+  bool end_ = false;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
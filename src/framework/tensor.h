@@ -52,6 +52,7 @@ class Tensor : public TensorBase {
     this->dims_ = inTensor.dims_;
     this->holder_ = inTensor.holder_;
     this->offset_ = inTensor.offset_;
+    this->layout_ = inTensor.layout_;
   }
 
   /*! Resize the dimensions of the memory block. */
@@ -69,12 +70,42 @@ class Tensor : public TensorBase {
     return *this;
   }
 
+  /**
+   * @brief   Alias a sub block of the memory held by arena.
+   *
+   * @note    The tensor only sees `size` bytes from `offset`, and it
+   *          allocates a new memory block if it needs more than that.
+   */
+  inline Tensor &ShareBufferWith(const Tensor &arena, size_t offset,
+                                 size_t size, std::type_index type) {
+    PADDLE_MOBILE_ENFORCE(arena.holder_ != nullptr &&
+                              offset + size <= arena.holder_->size(),
+                          "The sub block is out of the arena.");
+    holder_.reset(new SubPlaceholderImpl(arena.holder_, offset, size, type));
+    offset_ = 0;
+    return *this;
+  }
+
+  /**
+   * @brief   Point to an external memory block without copying.
+   *
+   * @note    keeper holds the owner of the memory block, such as a
+   *          mapped file, as long as the tensor refers to it.
+   */
+  inline Tensor &ShareExternalData(void *ptr, size_t size,
+                                   std::type_index type,
+                                   std::shared_ptr<void> keeper) {
+    holder_.reset(new ExternalPlaceholderImpl(ptr, size, type, keeper));
+    offset_ = 0;
+    return *this;
+  }
+
   inline void *mutable_data(std::type_index type) {
     if (holder_ != nullptr) {
       holder_->set_type(type);
     }
     PADDLE_MOBILE_ENFORCE(numel() >= 0, "the Tensor's numel must >=0.")
-    int64_t size = numel() * SizeOfType(type);
+    int64_t size = storage_numel() * SizeOfType(type);
     if (holder_ == nullptr || holder_->size() < size + offset_) {
       holder_.reset(new PlaceholderImpl(size, type));
       offset_ = 0;
@@ -130,9 +161,10 @@ class Tensor : public TensorBase {
     if (dims_[0] == 1) {
       return *this;
     } else {
-      size_t base = numel() / dims_[0];
+      size_t base = storage_numel() / dims_[0];
       Tensor dst;
       dst.holder_ = holder_;
+      dst.layout_ = layout_;
       DDim dst_dims = dims_;
       dst_dims[0] = end_idx - begin_idx;
       dst.Resize(dst_dims);
@@ -197,6 +229,57 @@ class Tensor : public TensorBase {
     std::type_index type_;
   };
 
+  struct SubPlaceholderImpl : public Placeholder {
+    SubPlaceholderImpl(std::shared_ptr<Placeholder> arena, size_t offset,
+                       size_t size, std::type_index type)
+        : arena_(arena), offset_(offset), size_(size), type_(type) {}
+
+    virtual size_t size() const { return size_; }
+
+    virtual void *ptr() const {
+      return reinterpret_cast<void *>(
+          reinterpret_cast<uintptr_t>(arena_->ptr()) + offset_);
+    }
+
+    virtual std::type_index type() const { return type_; }
+
+    virtual void set_type(std::type_index type) { type_ = type; }
+
+    /*! the memory block shared with other tensors. */
+    std::shared_ptr<Placeholder> arena_;
+
+    /*! the byte offset in the shared memory block. */
+    size_t offset_;
+
+    size_t size_;
+
+    std::type_index type_;
+  };
+
+  struct ExternalPlaceholderImpl : public Placeholder {
+    ExternalPlaceholderImpl(void *ptr, size_t size, std::type_index type,
+                            std::shared_ptr<void> keeper)
+        : ptr_(ptr), size_(size), type_(type), keeper_(keeper) {}
+
+    virtual size_t size() const { return size_; }
+
+    virtual void *ptr() const { return ptr_; }
+
+    virtual std::type_index type() const { return type_; }
+
+    virtual void set_type(std::type_index type) { type_ = type; }
+
+    /*! the memory block which is not owned by the tensor. */
+    void *ptr_;
+
+    size_t size_;
+
+    std::type_index type_;
+
+    /*! keep the owner of the memory block alive. */
+    std::shared_ptr<void> keeper_;
+  };
+
 #ifdef PADDLE_MOBILE_FPGA
  public:  // NOLINT
   inline void reset_data_ptr(void *p) {
@@ -231,6 +314,10 @@ inline Print &operator<<(Print &printer, const Tensor &tensor) {
   printer << " dims: " << tensor.dims() << "\n";
   int stride = tensor.numel() / 20;
   stride = stride > 0 ? stride : 1;
+  if (tensor.memory_size() == 0) {
+    // such as the weights freed by weight compression
+    return printer;
+  }
 #ifndef PADDLE_MOBILE_FPGA
   for (int i = 0; i < tensor.numel(); i += stride) {
     if (tensor.type() == typeid(float)) {
@@ -19,6 +19,7 @@ limitations under the License. */
 
 #include "common/enforce.h"
 #include "common/types.h"
+#include "framework/data_layout.h"
 #include "framework/ddim.h"
 
 namespace paddle_mobile {
@@ -57,8 +58,8 @@ struct SizeOfTypeFunctor<HEAD, TAIL...> {
 };
 
 static inline size_t SizeOfType(std::type_index type) {
-  SizeOfTypeFunctor<int8_t, int, half, float, double, int16_t, int64_t, bool,
-                    size_t>
+  SizeOfTypeFunctor<int8_t, uint8_t, int, half, float, double, int16_t, int64_t,
+                    bool, size_t>
       functor;
   size_t size = functor(type);
 
@@ -78,6 +79,26 @@ class TensorBase {
   /*! Return the numel of the memory block. */
   inline int64_t numel() const { return product(dims_); }
 
+  /*! Return the layout of the memory block. */
+  inline DataLayout layout() const { return layout_; }
+
+  inline void set_layout(DataLayout layout) { layout_ = layout; }
+
+  /**
+   * @brief   Return the number of elements stored in the memory block.
+   *
+   * @note    It is larger than numel() for a channel blocked layout whose
+   *          channels are not a multiple of the block.
+   */
+  inline int64_t storage_numel() const {
+    const int block = DataLayoutBlock(layout_);
+    if (block == 1 || dims_.size() != 4) {
+      return numel();
+    }
+    const int64_t channels = (dims_[1] + block - 1) / block * block;
+    return dims_[0] * channels * dims_[2] * dims_[3];
+  }
+
   std::type_index type() const {
     PADDLE_MOBILE_ENFORCE(
         holder_ != nullptr,
@@ -97,7 +118,8 @@ class TensorBase {
     PADDLE_MOBILE_ENFORCE(
         holder_ != nullptr,
         "Tensor holds no memory. Call Tensor::mutable_data first.");
-    PADDLE_MOBILE_ENFORCE(numel() * SizeOfType(type()) <= memory_size(),
+    PADDLE_MOBILE_ENFORCE(
+        storage_numel() * SizeOfType(type()) <= memory_size(),
                           "Tensor's dims_ is out of bound. ");
   }
 
@@ -139,6 +161,9 @@ class TensorBase {
    * begins.
    */
   size_t offset_ = 0;
+
+  /*! the order of the elements in the memory block. */
+  DataLayout layout_ = DataLayout::kNCHW;
 };
 
 }  // namespace framework
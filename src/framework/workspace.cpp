@@ -0,0 +1,114 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "framework/workspace.h"
+#include <algorithm>
+#include <cstdint>
+#include "common/log.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+namespace {
+
+// the alignment of memory::Alloc, every allocation starts at a cache line
+const size_t kAlignment = 64;
+
+thread_local Workspace *bound_workspace = nullptr;
+
+size_t AlignedSize(size_t size) {
+  return (std::max<size_t>(size, 1) + kAlignment - 1) / kAlignment *
+         kAlignment;
+}
+
+uint8_t *NewBuffer(size_t size, Tensor *tensor) {
+  return tensor->mutable_data<uint8_t>(
+      make_ddim({static_cast<int64_t>(size)}));
+}
+
+}  // namespace
+
+Workspace *Workspace::Instance() { return bound_workspace; }
+
+Workspace *Workspace::Bind(Workspace *workspace) {
+  Workspace *previous = bound_workspace;
+  bound_workspace = workspace;
+  return previous;
+}
+
+void *Workspace::Allocate(size_t size, const Tensor **chunk, size_t *offset) {
+  size = AlignedSize(size);
+  const size_t begin = used_;
+  used_ += size;
+  peak_ = std::max(peak_, used_);
+  if (used_ <= Capacity()) {
+    *chunk = &block_;
+    *offset = begin;
+    return block_.data<uint8_t>() + begin;
+  }
+  overflow_.emplace_back(begin, Tensor());
+  Tensor *tensor = &overflow_.back().second;
+  *chunk = tensor;
+  *offset = 0;
+  return NewBuffer(size, tensor);
+}
+
+void Workspace::Release(size_t mark) {
+  used_ = mark;
+  while (!overflow_.empty() && overflow_.back().first >= mark) {
+    overflow_.pop_back();
+  }
+  if (used_ == 0 && peak_ > Capacity()) {
+    // the tensors still sharing the old block keep it
+    block_ = Tensor();
+    NewBuffer(peak_, &block_);
+    DLOG << "workspace grows to " << peak_ << " bytes";
+  }
+}
+
+WorkspaceScope::WorkspaceScope() : workspace_(Workspace::Instance()) {
+  if (workspace_ != nullptr) {
+    mark_ = workspace_->Used();
+  }
+}
+
+WorkspaceScope::~WorkspaceScope() {
+  if (workspace_ != nullptr) {
+    workspace_->Release(mark_);
+  }
+}
+
+void *WorkspaceScope::Allocate(size_t size) {
+  if (workspace_ == nullptr) {
+    heap_.emplace_back();
+    return NewBuffer(AlignedSize(size), &heap_.back());
+  }
+  const Tensor *chunk = nullptr;
+  size_t offset = 0;
+  return workspace_->Allocate(size, &chunk, &offset);
+}
+
+Tensor WorkspaceScope::Reserve(size_t size) {
+  Tensor tensor;
+  if (workspace_ != nullptr) {
+    const Tensor *chunk = nullptr;
+    size_t offset = 0;
+    workspace_->Allocate(size, &chunk, &offset);
+    tensor.ShareBufferWith(*chunk, offset, size, typeid(uint8_t));
+  }
+  return tensor;
+}
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -0,0 +1,113 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+#include "framework/tensor.h"
+
+namespace paddle_mobile {
+namespace framework {
+
+// Workspace is the scratch memory of the kernel temporaries, such as the col
+// matrix of a conv or the packed blocks of a gemm. Kernels take it through a
+// WorkspaceScope, which bumps a pointer in one block and gives everything
+// back when it ends, so the ops of an executor share the memory one after
+// another instead of allocating and freeing it on every call.
+//
+// Whatever does not fit into the block comes from the heap until the
+// workspace is empty again, the block then grows to the most the kernels
+// needed. The first prediction of an input shape plans it that way, the
+// later ones do not allocate.
+//
+// The executor binds its workspace to the thread running its ops, the op
+// scheduler binds one to each of its threads. A workspace is only used by
+// the thread it is bound to.
+class Workspace {
+ public:
+  // the workspace bound to the calling thread, nullptr if there is none
+  static Workspace *Instance();
+  // binds workspace to the calling thread, nullptr unbinds it, returns the
+  // workspace bound before
+  static Workspace *Bind(Workspace *workspace);
+
+  // bytes of the block
+  size_t Capacity() const { return block_.memory_size(); }
+
+ private:
+  friend class WorkspaceScope;
+
+  // size bytes, *chunk and *offset locate them for Tensor::ShareBufferWith
+  void *Allocate(size_t size, const Tensor **chunk, size_t *offset);
+  size_t Used() const { return used_; }
+  // gives back everything allocated since used was mark
+  void Release(size_t mark);
+
+  Tensor block_;
+  // the allocations which did not fit into the block by the used bytes they
+  // start at
+  std::vector<std::pair<size_t, Tensor>> overflow_;
+  size_t used_ = 0;
+  size_t peak_ = 0;
+};
+
+// binds a workspace to the calling thread for its lifetime
+class WorkspaceBinding {
+ public:
+  explicit WorkspaceBinding(Workspace *workspace)
+      : previous_(Workspace::Bind(workspace)) {}
+  ~WorkspaceBinding() { Workspace::Bind(previous_); }
+
+ private:
+  Workspace *previous_;
+};
+
+// The temporaries of a kernel, allocated on the workspace bound to the
+// calling thread and given back together when the scope ends. Without a
+// bound workspace, such as in the workers of a parallel region, they come
+// from the heap as before. Allocate the buffers of a parallel region before
+// it starts, a scope belongs to the thread which created it.
+class WorkspaceScope {
+ public:
+  WorkspaceScope();
+  ~WorkspaceScope();
+
+  // size bytes aligned to 64 bytes
+  void *Allocate(size_t size);
+  template <typename T>
+  T *Allocate(size_t count) {
+    return static_cast<T *>(Allocate(count * sizeof(T)));
+  }
+
+  // an empty tensor with size bytes reserved, filling it with mutable_data
+  // does not allocate as long as it fits
+  Tensor Reserve(size_t size);
+  // a tensor of dims
+  template <typename T>
+  Tensor NewTensor(const DDim &dims) {
+    Tensor tensor = Reserve(product(dims) * sizeof(T));
+    tensor.mutable_data<T>(dims);
+    return tensor;
+  }
+
+ private:
+  Workspace *workspace_;
+  size_t mark_ = 0;
+  // the allocations without a workspace
+  std::vector<Tensor> heap_;
+};
+
+}  // namespace framework
+}  // namespace paddle_mobile
@@ -29,7 +29,14 @@ PaddleMobilePredictor<Device, T>::PaddleMobilePredictor(
 
 template <typename Device, typename T>
 bool PaddleMobilePredictor<Device, T>::Init(const PaddleMobileConfig &config) {
-  paddle_mobile_.reset(new PaddleMobile<Device, T>());
+  PaddleMobileConfigInternal config_internal;
+  config_internal.memory_optimization = config.memory_optimization;
+  config_internal.load_with_mmap = config.load_with_mmap;
+  config_internal.gemm_tuning_profile = config.gemm_tuning_profile;
+  config_internal.conv_tuning_profile = config.conv_tuning_profile;
+  config_internal.inter_op_threads = config.inter_op_threads;
+  config_internal.graph_optimization = config.graph_optimization;
+  paddle_mobile_.reset(new PaddleMobile<Device, T>(config_internal));
 #ifdef PADDLE_MOBILE_CL
   paddle_mobile_->SetCLPath(config.cl_path);
 #endif
@@ -51,8 +58,8 @@ bool PaddleMobilePredictor<Device, T>::Init(const PaddleMobileConfig &config) {
     LOG(kLOG_ERROR) << "fail to load inference model!";
     return false;
   }
-  // If the openmp is open, set the thread num
-  paddle_mobile_->SetThreadNum(config.thread_num);
+  paddle_mobile_->SetThreadNum(
+      config.thread_num, static_cast<CPUAffinity>(config.cpu_affinity));
   return true;
 }
 template <typename Device, typename T>
@@ -197,6 +204,12 @@ void PaddleMobilePredictor<Device, T>::Predict_From_To(int start, int end) {
 }
 
 #endif
+template <typename Device, typename T>
+std::unique_ptr<PaddlePredictor> PaddleMobilePredictor<Device, T>::Clone() {
+  return std::unique_ptr<PaddlePredictor>(
+      new PaddleMobilePredictor<Device, T>(config_, paddle_mobile_->Clone()));
+}
+
 template <typename Device, typename T>
 PaddleMobilePredictor<Device, T>::~PaddleMobilePredictor() {
   paddle_mobile_->Clear();
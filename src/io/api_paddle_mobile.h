@@ -39,10 +39,15 @@ class PaddleMobilePredictor : public PaddlePredictor {
   void GetResults(std::vector<void*>* outputs) override;
   void Predict_From_To(int start = 0, int end = -1) override;
 #endif
+  std::unique_ptr<PaddlePredictor> Clone() override;
   ~PaddleMobilePredictor() override;
 
  private:
-  std::unique_ptr<PaddleMobile<Device, T>> paddle_mobile_;
+  PaddleMobilePredictor(const PaddleMobileConfig& config,
+                        std::shared_ptr<PaddleMobile<Device, T>> paddle_mobile)
+      : paddle_mobile_(paddle_mobile), config_(config) {}
+
+  std::shared_ptr<PaddleMobile<Device, T>> paddle_mobile_;
   bool Init(const PaddleMobileConfig& config);
 
   PaddleMobileConfig config_;
@@ -106,6 +106,10 @@ class PaddlePredictor {
   virtual bool Run(const std::vector<PaddleTensor>& inputs,
                    std::vector<PaddleTensor>* output_data,
                    int batch_size = -1) = 0;
+  // Clone a predictor which shares the model weights with this one, the
+  // predictors can run in different threads at the same time.
+  virtual std::unique_ptr<PaddlePredictor> Clone() = 0;
+
   // Destroy the Predictor.
   virtual ~PaddlePredictor() = default;
 
@@ -139,6 +143,7 @@ struct PaddleModelMemoryPack {
 struct PaddleMobileConfig : public PaddlePredictor::Config {
   enum Precision { FP32 = 0 };
   enum Device { kCPU = 0, kFPGA = 1, kGPU_MALI = 2, kGPU_CL = 3 };
+  enum CPUAffinity { kAffinityNone = 0, kAffinityBig = 1, kAffinityLittle = 2 };
 
   enum Precision precision;
   enum Device device;
@@ -147,7 +152,17 @@ struct PaddleMobileConfig : public PaddlePredictor::Config {
   bool optimize = true;
   bool quantification = false;
   bool lod_mode = false;
+  bool memory_optimization = false;
+  bool load_with_mmap = false;
+  std::string gemm_tuning_profile;
+  std::string conv_tuning_profile;
   int thread_num = 1;
+  // fold batch norms, scales, paddings and constants into the weights at load
+  bool graph_optimization = false;
+  // threads running independent ops at the same time, they share thread_num
+  int inter_op_threads = 1;
+  // pin the worker threads to the big or little cores
+  enum CPUAffinity cpu_affinity = kAffinityNone;
   std::string cl_path;
   struct PaddleModelMemoryPack memory_pack;
 };
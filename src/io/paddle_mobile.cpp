@@ -13,11 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "io/paddle_mobile.h"
+#include <algorithm>
 #include <utility>
 #include "common/common.h"
-#ifdef _OPENMP
-#include <omp.h>
-#endif  // _OPENMP
+#include "common/threadpool.h"
 #ifdef PADDLE_MOBILE_CL
 #include <CL/cl.h>
 #include "framework/cl/cl_tensor.h"
@@ -27,10 +26,8 @@ limitations under the License. */
 namespace paddle_mobile {
 
 template <typename Device, typename T>
-void PaddleMobile<Device, T>::SetThreadNum(int num) {
-#ifdef _OPENMP
-  omp_set_num_threads(num);
-#endif
+void PaddleMobile<Device, T>::SetThreadNum(int num, CPUAffinity affinity) {
+  ThreadPool::Instance()->SetThreadNum(num, affinity);
 }
 
 template <typename Device, typename T>
@@ -44,9 +41,18 @@ PMStatus PaddleMobile<Device, T>::Load(const std::string &dirname,
   }
 
   if (executor_.get() == nullptr) {
-    executor_ = std::make_shared<framework::Executor<Device, T>>(
-        loader_->Load(dirname, optimize, quantification), config_, batch_size,
-        optimize, lod_mode);
+    InitExecutor(
+        [&] { return loader_->Load(dirname, optimize, quantification); },
+        [&] {
+          std::vector<std::string> files =
+              framework::ModelCache::ListFiles(dirname);
+          // the cache may be kept with the model
+          files.erase(std::remove(files.begin(), files.end(),
+                                  config_.model_cache),
+                      files.end());
+          return framework::ModelCache::HashFiles(files);
+        },
+        optimize, quantification, batch_size, lod_mode);
   } else {
     LOG(kLOG_INFO) << "executor inited";
   }
@@ -66,9 +72,15 @@ PMStatus PaddleMobile<Device, T>::Load(const std::string &model_path,
   }
 
   if (executor_.get() == nullptr) {
-    executor_ = std::make_shared<framework::Executor<Device, T>>(
-        loader_->Load(model_path, para_path, optimize, quantification), config_,
-        batch_size, optimize, lod_mode);
+    InitExecutor(
+        [&] {
+          return loader_->Load(model_path, para_path, optimize,
+                               quantification);
+        },
+        [&] {
+          return framework::ModelCache::HashFiles({model_path, para_path});
+        },
+        optimize, quantification, batch_size, lod_mode);
   } else {
     LOG(kLOG_INFO) << "executor inited";
   }
@@ -76,6 +88,59 @@ PMStatus PaddleMobile<Device, T>::Load(const std::string &model_path,
   return PMSuccess;
 }
 
+template <typename Device, typename T>
+void PaddleMobile<Device, T>::InitExecutor(
+    const std::function<framework::Program<Device, T>()> &load,
+    const std::function<std::string()> &model_hash, bool optimize,
+    bool quantification, int batch_size, bool lod_mode) {
+  if (config_.model_cache.empty() || !std::is_same<Device, CPU>::value) {
+    executor_ = std::make_shared<framework::Executor<Device, T>>(
+        load(), config_, batch_size, optimize, lod_mode);
+    return;
+  }
+  // everything the optimized program and the kernel weights depend on
+  std::string options = "optimize " + std::to_string(optimize) +
+                        ", quantification " + std::to_string(quantification) +
+                        ", batch size " + std::to_string(batch_size) +
+                        ", lod mode " + std::to_string(lod_mode) +
+                        ", graph optimization " +
+                        std::to_string(config_.graph_optimization) +
+                        ", layout optimization " +
+                        std::to_string(config_.layout_optimization) +
+                        ", weight compression " +
+                        std::to_string(config_.weight_compression) +
+                        ", weight precision " +
+                        std::to_string(
+                            static_cast<int>(config_.weight_precision));
+  if (!config_.conv_tuning_profile.empty()) {
+    // the convs are tuned for the thread count
+    options += ", conv tuning threads " +
+               std::to_string(ThreadPool::Instance()->ThreadNum());
+  }
+  framework::ModelCache cache(framework::ModelCache::Key(model_hash(),
+                                                         options));
+  if (cache.Read(config_.model_cache)) {
+    // the cached program is optimized and its weights are folded already
+    PaddleMobileConfigInternal config = config_;
+    config.graph_optimization = false;
+    config.layout_optimization = false;
+    executor_ = std::make_shared<framework::Executor<Device, T>>(
+        loader_->LoadCombinedMemory(
+            cache.program.size(),
+            reinterpret_cast<const uint8_t *>(cache.program.data()),
+            cache.params.size(),
+            reinterpret_cast<uint8_t *>(&cache.params[0]), false, false),
+        config, batch_size, false, lod_mode, &cache);
+    LOG(kLOG_INFO) << "model restored from cache " << config_.model_cache;
+    return;
+  }
+  executor_ = std::make_shared<framework::Executor<Device, T>>(
+      load(), config_, batch_size, optimize, lod_mode, &cache);
+  if (!cache.program.empty() && cache.Write(config_.model_cache)) {
+    LOG(kLOG_INFO) << "model cached in " << config_.model_cache;
+  }
+}
+
 template <typename Device, typename T>
 PMStatus PaddleMobile<Device, T>::Load(const PaddleMobileConfig &config) {
   if (!config.model_dir.empty()) {
@@ -101,16 +166,50 @@ bool PaddleMobile<Device, T>::LoadCombinedMemory(
   } else {
     LOG(kLOG_INFO) << "loader inited";
   }
+  if (executor_.get() == nullptr) {
+    InitExecutor(
+        [&] {
+          return loader_->LoadCombinedMemory(model_len, model_buf,
+                                             combined_params_len,
+                                             combined_params_buf, optimize,
+                                             quantification);
+        },
+        [&] {
+          const std::string model_hash =
+              framework::ModelCache::HashBuffer(model_buf, model_len);
+          return framework::ModelCache::HashBuffer(
+              combined_params_buf, combined_params_len, model_hash);
+        },
+        optimize, quantification, batch_size, lod_mode);
+  } else {
+    LOG(kLOG_INFO) << "executor inited";
+  }
+
+  return PMSuccess;
+}
+
+template <typename Device, typename T>
+PMStatus PaddleMobile<Device, T>::LoadStream(
+    const framework::StreamReadFunc &model_reader,
+    const framework::StreamReadFunc &params_reader, bool optimize,
+    bool quantification, int batch_size, bool lod_mode) {
+  if (!std::is_same<Device, CPU>::value) {
+    LOG(kLOG_ERROR) << "stream loading is supported on cpu only";
+    return PMWrongDevice;
+  }
+  if (loader_.get() == nullptr) {
+    loader_ = std::make_shared<framework::Loader<Device, T>>();
+  } else {
+    LOG(kLOG_INFO) << "loader inited";
+  }
   if (executor_.get() == nullptr) {
     executor_ = std::make_shared<framework::Executor<Device, T>>(
-        loader_->LoadCombinedMemory(model_len, model_buf, combined_params_len,
-                                    combined_params_buf, optimize,
-                                    quantification),
+        loader_->LoadStream(model_reader, params_reader, optimize,
+                            quantification),
         config_, batch_size, optimize, lod_mode);
   } else {
     LOG(kLOG_INFO) << "executor inited";
   }
-
   return PMSuccess;
 }
 
@@ -146,11 +245,79 @@ std::vector<T> PaddleMobile<Device, T>::Predict(
   return executor_->Predict(input, dims);
 }
 
+template <typename Device, typename T>
+std::vector<std::vector<T>> PaddleMobile<Device, T>::PredictBatch(
+    const std::vector<std::vector<T>> &inputs,
+    const std::vector<int64_t> &dims) {
+  PADDLE_MOBILE_ENFORCE(!inputs.empty() && !dims.empty() && dims[0] == 1,
+                        "dims should be the dims of one image");
+  const int64_t image_size = framework::product(framework::make_ddim(dims));
+  std::vector<T> batch;
+  batch.reserve(inputs.size() * image_size);
+  for (const auto &input : inputs) {
+    PADDLE_MOBILE_ENFORCE(input.size() == image_size,
+                          "every image should have the same dims");
+    batch.insert(batch.end(), input.begin(), input.end());
+  }
+  std::vector<int64_t> batch_dims(dims);
+  batch_dims[0] = inputs.size();
+  std::vector<T> output = executor_->Predict(batch, batch_dims);
+
+  std::vector<std::vector<T>> outputs(inputs.size());
+  const size_t output_size = output.size() / inputs.size();
+  for (int i = 0; i < outputs.size(); ++i) {
+    outputs[i].assign(output.begin() + i * output_size,
+                      output.begin() + (i + 1) * output_size);
+  }
+  return outputs;
+}
+
 template <typename Device, typename T>
 PMStatus PaddleMobile<Device, T>::Predict() {
   return executor_->Predict();
 }
 
+template <typename Device, typename T>
+std::future<std::vector<T>> PaddleMobile<Device, T>::PredictAsync(
+    const std::vector<T> &input, const std::vector<int64_t> &dims) {
+  return Pipeline()->Submit(input, dims);
+}
+
+template <typename Device, typename T>
+void PaddleMobile<Device, T>::PredictAsync(
+    const std::vector<T> &input, const std::vector<int64_t> &dims,
+    std::function<void(PMStatus, std::vector<T>)> callback) {
+  Pipeline()->Submit(input, dims, std::move(callback));
+}
+
+template <typename Device, typename T>
+void PaddleMobile<Device, T>::WaitAsync() {
+  std::shared_ptr<PredictPipeline<Device, T>> pipeline;
+  {
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    pipeline = pipeline_;
+  }
+  if (pipeline != nullptr) {
+    pipeline->Wait();
+  }
+}
+
+template <typename Device, typename T>
+std::shared_ptr<PredictPipeline<Device, T>>
+PaddleMobile<Device, T>::Pipeline() {
+  std::lock_guard<std::mutex> lock(pipeline_mutex_);
+  if (pipeline_ == nullptr) {
+    PADDLE_MOBILE_ENFORCE(config_.pipeline_depth > 0,
+                          "pipeline_depth should be positive");
+    std::vector<std::shared_ptr<PaddleMobile<Device, T>>> slots;
+    for (int i = 0; i < config_.pipeline_depth; ++i) {
+      slots.push_back(Clone());
+    }
+    pipeline_ = std::make_shared<PredictPipeline<Device, T>>(slots);
+  }
+  return pipeline_;
+}
+
 template <typename Device, typename T>
 void PaddleMobile<Device, T>::Feed(const framework::Tensor &input,
                                    const std::string &var_name) {
@@ -171,10 +338,43 @@ LoDTensorPtr PaddleMobile<Device, T>::Fetch(const std::string &var_name) {
 
 template <typename Device, typename T>
 void PaddleMobile<Device, T>::Clear() {
+  pipeline_ = nullptr;
   executor_ = nullptr;
   loader_ = nullptr;
 }
 
+template <typename Device, typename T>
+void PaddleMobile<Device, T>::EnableProfile(bool enable) {
+  PADDLE_MOBILE_ENFORCE(executor_ != nullptr,
+                        "the model should be loaded before profiling");
+  executor_->GetProfiler()->Enable(enable);
+}
+
+template <typename Device, typename T>
+std::string PaddleMobile<Device, T>::GetProfileTrace() {
+  PADDLE_MOBILE_ENFORCE(executor_ != nullptr,
+                        "the model should be loaded before profiling");
+  return executor_->GetProfiler()->ChromeTrace();
+}
+
+template <typename Device, typename T>
+std::string PaddleMobile<Device, T>::GetProfileSummary(double peak_gflops,
+                                                       double peak_gbps) {
+  PADDLE_MOBILE_ENFORCE(executor_ != nullptr,
+                        "the model should be loaded before profiling");
+  return executor_->GetProfiler()->Summary(peak_gflops, peak_gbps);
+}
+
+template <typename Device, typename T>
+std::shared_ptr<PaddleMobile<Device, T>> PaddleMobile<Device, T>::Clone() {
+  PADDLE_MOBILE_ENFORCE(executor_ != nullptr,
+                        "the model should be loaded before clone");
+  auto paddle_mobile = std::make_shared<PaddleMobile<Device, T>>(config_);
+  paddle_mobile->loader_ = loader_;
+  paddle_mobile->executor_ = executor_->Clone();
+  return paddle_mobile;
+}
+
 template <typename Device, typename T>
 double PaddleMobile<Device, T>::GetPredictTime() {}
 
@@ -14,7 +14,10 @@ limitations under the License. */
 
 #pragma once
 
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -24,6 +27,7 @@ limitations under the License. */
 #include "framework/loader.h"
 #include "framework/tensor.h"
 #include "io/paddle_inference_api.h"
+#include "io/predict_pipeline.h"
 #ifdef PADDLE_MOBILE_CL
 #include "framework/cl/cl_engine.h"
 #endif
@@ -67,8 +71,25 @@ class PaddleMobile {
 
   std::vector<T> Predict(const std::vector<T> &input,
                          const std::vector<int64_t> &dims);
+  // predict images of the same dims in one batch, dims is the dims of one
+  // image with dims[0] = 1, returns the output of every image
+  std::vector<std::vector<T>> PredictBatch(
+      const std::vector<std::vector<T>> &inputs,
+      const std::vector<int64_t> &dims);
   PMStatus Predict();
 
+  // predict in the background on config.pipeline_depth clones of this
+  // instance made at the first call, see PredictPipeline. The outputs are
+  // those of Predict(input, dims), in the order of the calls. A failed
+  // prediction throws from the future or passes its status to callback.
+  std::future<std::vector<T>> PredictAsync(const std::vector<T> &input,
+                                           const std::vector<int64_t> &dims);
+  void PredictAsync(const std::vector<T> &input,
+                    const std::vector<int64_t> &dims,
+                    std::function<void(PMStatus, std::vector<T>)> callback);
+  // blocks until the requests of PredictAsync completed
+  void WaitAsync();
+
   void Feed(const framework::LoDTensor &input, const std::string &var_name);
   void Feed(const framework::Tensor &input, const std::string &var_name);
 
@@ -82,11 +103,33 @@ class PaddleMobile {
                           uint8_t *combined_params_buf, bool optimize = false,
                           bool quantification = false, int batch_size = 1,
                           bool lod_mode = false);
-
-  void SetThreadNum(int count);
+  // loads a combined model from readers, such as ones decrypting an asset,
+  // without holding the whole params. The ops are initialized while the
+  // later weights are read, see Loader::LoadStream. Not cached in
+  // config.model_cache.
+  PMStatus LoadStream(const framework::StreamReadFunc &model_reader,
+                      const framework::StreamReadFunc &params_reader,
+                      bool optimize = false, bool quantification = false,
+                      int batch_size = 1, bool lod_mode = false);
+
+  // threads of the cpu kernels, the workers are shared by all instances
+  void SetThreadNum(int count, CPUAffinity affinity = AFFINITY_NONE);
   void Clear();
   double GetPredictTime();
 
+  // record the time, shapes and estimated cost of every operator run from
+  // now on, the profiles recorded before are dropped
+  void EnableProfile(bool enable);
+  // the recorded operator runs as chrome trace event json
+  std::string GetProfileTrace();
+  // per operator GFLOPS summary, pass the peak GFLOPS and GB/s of the device
+  // to get the roofline bound of each operator
+  std::string GetProfileSummary(double peak_gflops = 0, double peak_gbps = 0);
+
+  // create an instance sharing the loaded weights with this one, every
+  // instance owns its activations and can predict in its own thread
+  std::shared_ptr<PaddleMobile<Device, T>> Clone();
+
 #ifdef PADDLE_MOBILE_FPGA
   void InjectVariable(const framework::Tensor &t, std::string var_name);
   void FeedData(const framework::Tensor &t);
@@ -106,9 +149,19 @@ class PaddleMobile {
 #endif
 
  private:
+  std::shared_ptr<PredictPipeline<Device, T>> Pipeline();
+  // creates executor_ for the program returned by load, or for the one of
+  // config_.model_cache if it was written for the model of model_hash
+  void InitExecutor(
+      const std::function<framework::Program<Device, T>()> &load,
+      const std::function<std::string()> &model_hash, bool optimize,
+      bool quantification, int batch_size, bool lod_mode);
+
   std::shared_ptr<framework::Loader<Device, T>> loader_;
   std::shared_ptr<framework::Executor<Device, T>> executor_;
   PaddleMobileConfigInternal config_;
+  std::mutex pipeline_mutex_;
+  std::shared_ptr<PredictPipeline<Device, T>> pipeline_;
 };
 
 }  // namespace paddle_mobile
@@ -0,0 +1,208 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "io/predict_pipeline.h"
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "common/enforce.h"
+#include "common/log.h"
+#include "io/paddle_mobile.h"
+
+namespace paddle_mobile {
+
+template <typename Device, typename T>
+PredictPipeline<Device, T>::PredictPipeline(
+    const std::vector<std::shared_ptr<PaddleMobile<Device, T>>> &slots)
+    : slots_(slots) {
+  PADDLE_MOBILE_ENFORCE(!slots_.empty(), "the pipeline needs a slot at least");
+  // the first slot is taken first
+  for (int i = static_cast<int>(slots_.size()) - 1; i >= 0; --i) {
+    free_slots_.push_back(i);
+  }
+  run_thread_ = std::thread(&PredictPipeline::RunLoop, this);
+  fetch_thread_ = std::thread(&PredictPipeline::FetchLoop, this);
+}
+
+template <typename Device, typename T>
+PredictPipeline<Device, T>::~PredictPipeline() {
+  Wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  fed_.notify_all();
+  ran_.notify_all();
+  run_thread_.join();
+  fetch_thread_.join();
+}
+
+template <typename Device, typename T>
+void PredictPipeline<Device, T>::Submit(const std::vector<T> &input,
+                                        const std::vector<int64_t> &dims,
+                                        Callback callback) {
+  Enqueue(input, dims,
+          [callback](PMStatus status, std::exception_ptr error,
+                     std::vector<T> *output) {
+            callback(status, std::move(*output));
+          });
+}
+
+template <typename Device, typename T>
+std::future<std::vector<T>> PredictPipeline<Device, T>::Submit(
+    const std::vector<T> &input, const std::vector<int64_t> &dims) {
+  // std::function needs a copyable callable
+  auto promise = std::make_shared<std::promise<std::vector<T>>>();
+  std::future<std::vector<T>> future = promise->get_future();
+  Enqueue(input, dims,
+          [promise](PMStatus status, std::exception_ptr error,
+                    std::vector<T> *output) {
+            if (error != nullptr) {
+              promise->set_exception(error);
+            } else if (status != PMSuccess) {
+              promise->set_exception(
+                  std::make_exception_ptr(std::runtime_error(
+                      "predict returned status " +
+                      std::to_string(static_cast<int>(status)))));
+            } else {
+              promise->set_value(std::move(*output));
+            }
+          });
+  return future;
+}
+
+template <typename Device, typename T>
+void PredictPipeline<Device, T>::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  released_.wait(lock, [this] { return pending_ == 0; });
+}
+
+template <typename Device, typename T>
+void PredictPipeline<Device, T>::Enqueue(const std::vector<T> &input,
+                                         const std::vector<int64_t> &dims,
+                                         Done done) {
+  Request request;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    released_.wait(lock, [this] { return !free_slots_.empty(); });
+    request.slot = free_slots_.back();
+    free_slots_.pop_back();
+    ++pending_;
+  }
+  // the copy and the feed run on the calling thread while the run thread
+  // predicts the request before
+  try {
+    request.input = framework::Tensor(input, framework::make_ddim(dims));
+    slots_[request.slot]->Feed(request.input, "feed");
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_slots_.push_back(request.slot);
+      --pending_;
+    }
+    released_.notify_all();
+    throw;
+  }
+  request.status = PMSuccess;
+  request.done = std::move(done);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    to_run_.push(std::move(request));
+  }
+  fed_.notify_one();
+}
+
+template <typename Device, typename T>
+void PredictPipeline<Device, T>::RunLoop() {
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      fed_.wait(lock, [this] { return stop_ || !to_run_.empty(); });
+      if (to_run_.empty()) {
+        return;
+      }
+      request = std::move(to_run_.front());
+      to_run_.pop();
+    }
+    try {
+      request.status = slots_[request.slot]->Predict();
+    } catch (...) {
+      request.error = std::current_exception();
+    }
+    request.input = framework::Tensor();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      to_fetch_.push(std::move(request));
+    }
+    ran_.notify_one();
+  }
+}
+
+template <typename Device, typename T>
+void PredictPipeline<Device, T>::FetchLoop() {
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ran_.wait(lock, [this] { return stop_ || !to_fetch_.empty(); });
+      if (to_fetch_.empty()) {
+        return;
+      }
+      request = std::move(to_fetch_.front());
+      to_fetch_.pop();
+    }
+    // the output is copied out of the slot before it is fed again
+    std::vector<T> output;
+    if (request.error == nullptr && request.status == PMSuccess) {
+      try {
+        auto tensor = slots_[request.slot]->Fetch();
+        const T *data = tensor->template data<T>();
+        output.assign(data, data + tensor->numel());
+      } catch (...) {
+        request.error = std::current_exception();
+        output.clear();
+      }
+    }
+    if (request.error != nullptr) {
+      request.status = PMUnKownError;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_slots_.push_back(request.slot);
+    }
+    released_.notify_all();
+    // the request is done even if its callback throws, nobody could catch
+    // it on this thread
+    try {
+      request.done(request.status, request.error, &output);
+    } catch (const std::exception &e) {
+      LOG(kLOG_ERROR) << "the callback of a request threw: " << e.what();
+    } catch (...) {
+      LOG(kLOG_ERROR) << "the callback of a request threw";
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --pending_;
+    }
+    released_.notify_all();
+  }
+}
+
+template class PredictPipeline<CPU, float>;
+template class PredictPipeline<FPGA, float>;
+template class PredictPipeline<GPU_MALI, float>;
+template class PredictPipeline<GPU_CL, float>;
+
+}  // namespace paddle_mobile
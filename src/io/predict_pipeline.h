@@ -0,0 +1,106 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "common/types.h"
+#include "framework/tensor.h"
+
+namespace paddle_mobile {
+
+template <typename Device, typename T>
+class PaddleMobile;
+
+// PredictPipeline predicts the submitted inputs in the background on a few
+// instances sharing the same weights, such as the clones of one instance.
+// Every instance is a slot of the pipeline: the thread calling Submit feeds
+// a free slot, one thread runs the slots in the order they were fed and
+// another fetches the outputs and calls back. So the feed of a request, the
+// run of the one before and the fetch of the one before that overlap, while
+// only one request at a time uses the threads set by SetThreadNum.
+template <typename Device, typename T = float>
+class PredictPipeline {
+ public:
+  // called on the fetch thread with the status of the prediction and the
+  // output of the "fetch" variable, which is empty unless the status is
+  // PMSuccess. An exception thrown by the prediction or the fetch is
+  // reported as PMUnKownError.
+  typedef std::function<void(PMStatus, std::vector<T>)> Callback;
+
+  explicit PredictPipeline(
+      const std::vector<std::shared_ptr<PaddleMobile<Device, T>>> &slots);
+  // waits for the submitted requests
+  ~PredictPipeline();
+
+  int Depth() const { return static_cast<int>(slots_.size()); }
+
+  // blocks until a slot is free, the requests complete in the order they
+  // were submitted. A callback submitting again may wait for its own slot,
+  // so it should not block on a full pipeline.
+  void Submit(const std::vector<T> &input, const std::vector<int64_t> &dims,
+              Callback callback);
+  // the future rethrows the exception thrown by the prediction if any, a
+  // prediction returning another status than PMSuccess throws as well
+  std::future<std::vector<T>> Submit(const std::vector<T> &input,
+                                     const std::vector<int64_t> &dims);
+
+  // blocks until the callbacks of all the submitted requests returned
+  void Wait();
+
+ private:
+  typedef std::function<void(PMStatus, std::exception_ptr, std::vector<T> *)>
+      Done;
+
+  struct Request {
+    int slot;
+    // the fed variable shares its data, so it lives until the run finished
+    framework::Tensor input;
+    PMStatus status;
+    std::exception_ptr error;
+    Done done;
+  };
+
+  void Enqueue(const std::vector<T> &input, const std::vector<int64_t> &dims,
+               Done done);
+  void RunLoop();
+  void FetchLoop();
+
+  std::vector<std::shared_ptr<PaddleMobile<Device, T>>> slots_;
+
+  std::mutex mutex_;
+  // fed_ and ran_ wake the run and the fetch thread, released_ wakes Submit
+  // and Wait
+  std::condition_variable fed_;
+  std::condition_variable ran_;
+  std::condition_variable released_;
+  std::vector<int> free_slots_;
+  std::queue<Request> to_run_;
+  std::queue<Request> to_fetch_;
+  // requests whose callback has not returned
+  int pending_ = 0;
+  bool stop_ = false;
+  std::thread run_thread_;
+  std::thread fetch_thread_;
+};
+
+}  // namespace paddle_mobile
@@ -42,6 +42,9 @@ void FusionConvAddOp<Dtype, T>::InferShape() const {
   }
 
   framework::DDim ddim = framework::make_ddim(output_shape);
+  const auto *residual = this->param_.ResidualData();
+  PADDLE_MOBILE_ENFORCE(residual == nullptr || residual->dims() == ddim,
+                        "ResidualData should have the dims of the output");
   this->param_.Output()->Resize(ddim);
 }
 
@@ -0,0 +1,97 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "operators/fusion_conv_dequant_quant_op.h"
+#include "operators/math/conv_func.h"
+
+namespace paddle_mobile {
+namespace operators {
+
+#define DEFINE_CONV_DEQUANT_QUANT_INFERSHAPE(OpName)                          \
+  template <typename Dtype, typename T>                                       \
+  void OpName##Op<Dtype, T>::InferShape() const {                             \
+    auto in_dims = this->param_.Input()->dims();                              \
+    auto filter_dims = this->param_.Filter()->dims();                         \
+    const std::vector<int> &strides = this->param_.Strides();                 \
+    const std::vector<int> &paddings = this->param_.Paddings();               \
+    const std::vector<int> &dilations = this->param_.Dilations();             \
+    PADDLE_MOBILE_ENFORCE((in_dims.size() == filter_dims.size() &&            \
+                           dilations.size() == paddings.size() &&             \
+                           paddings.size() == strides.size()),                \
+                          "ConvParam is not suitable");                       \
+    std::vector<int64_t> output_shape({in_dims[0], filter_dims[0]});          \
+    for (size_t i = 0; i < strides.size(); ++i) {                             \
+      output_shape.push_back(math::ConvOutputSize(                            \
+          in_dims[i + 2], filter_dims[i + 2], dilations[i], paddings[i],      \
+          strides[i]));                                                       \
+    }                                                                         \
+    this->param_.Output()->Resize(framework::make_ddim(output_shape));        \
+    this->param_.online_scale_->Resize(framework::make_ddim({1}));            \
+  }
+
+#ifdef FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP
+DEFINE_CONV_DEQUANT_QUANT_INFERSHAPE(FusionConvDequantAddBNReluQuant);
+#endif
+
+#ifdef FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP
+DEFINE_CONV_DEQUANT_QUANT_INFERSHAPE(FusionConvDequantBNReluQuant);
+#endif
+
+#ifdef FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP
+DEFINE_CONV_DEQUANT_QUANT_INFERSHAPE(FusionConvDequantBNRelu6Quant);
+#endif
+
+#ifdef FUSION_CONV_DEQUANT_RELU_QUANT_OP
+DEFINE_CONV_DEQUANT_QUANT_INFERSHAPE(FusionConvDequantReluQuant);
+#endif
+
+}  // namespace operators
+}  // namespace paddle_mobile
+
+namespace ops = paddle_mobile::operators;
+#ifdef FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP
+REGISTER_FUSION_MATCHER(fusion_conv_dequant_add_bn_relu_quant,
+                        ops::FusionConvDequantAddBNReluQuantMatcher);
+#ifdef PADDLE_MOBILE_CPU
+REGISTER_OPERATOR_CPU(fusion_conv_dequant_add_bn_relu_quant,
+                      ops::FusionConvDequantAddBNReluQuantOp);
+#endif
+#endif  // FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP
+
+#ifdef FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP
+REGISTER_FUSION_MATCHER(fusion_conv_dequant_bn_relu_quant,
+                        ops::FusionConvDequantBNReluQuantMatcher);
+#ifdef PADDLE_MOBILE_CPU
+REGISTER_OPERATOR_CPU(fusion_conv_dequant_bn_relu_quant,
+                      ops::FusionConvDequantBNReluQuantOp);
+#endif
+#endif  // FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP
+
+#ifdef FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP
+REGISTER_FUSION_MATCHER(fusion_conv_dequant_bn_relu6_quant,
+                        ops::FusionConvDequantBNRelu6QuantMatcher);
+#ifdef PADDLE_MOBILE_CPU
+REGISTER_OPERATOR_CPU(fusion_conv_dequant_bn_relu6_quant,
+                      ops::FusionConvDequantBNRelu6QuantOp);
+#endif
+#endif  // FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP
+
+#ifdef FUSION_CONV_DEQUANT_RELU_QUANT_OP
+REGISTER_FUSION_MATCHER(fusion_conv_dequant_relu_quant,
+                        ops::FusionConvDequantReluQuantMatcher);
+#ifdef PADDLE_MOBILE_CPU
+REGISTER_OPERATOR_CPU(fusion_conv_dequant_relu_quant,
+                      ops::FusionConvDequantReluQuantOp);
+#endif
+#endif  // FUSION_CONV_DEQUANT_RELU_QUANT_OP
@@ -0,0 +1,140 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "framework/operator.h"
+#include "framework/program/program-optimize/fusion_op_register.h"
+#include "operators/kernel/conv_dequant_quant_kernel.h"
+#include "operators/op_param.h"
+
+namespace paddle_mobile {
+namespace operators {
+
+#if defined(FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP) || \
+    defined(FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP) ||     \
+    defined(FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP) ||    \
+    defined(FUSION_CONV_DEQUANT_RELU_QUANT_OP)
+// Folds an int8 conv and the ops up to the quantize of its output, so that
+// the int32 accumulator is requantized to int8 when the gemm writes it back.
+class FusionConvDequantQuantMatcher : public framework::FusionOpMatcher {
+ public:
+  void FolderNodes(
+      framework::Node *node,
+      std::vector<std::shared_ptr<framework::Node>> *removed_nodes) {
+    node->Folder(node_.Depth(), Type(),
+                 {{G_OP_TYPE_DEQUANTIZE, {{"Scale", "Scale"}}},
+                  {G_OP_TYPE_ELEMENTWISE_ADD, {{"Y", "Y"}}},
+                  {G_OP_TYPE_BATCHNORM,
+                   {{"Scale", "BNScale"},
+                    {"Mean", "BNMean"},
+                    {"Bias", "BNBias"},
+                    {"Variance", "BNVariance"}}},
+                  {G_OP_TYPE_QUANTIZE, {{"InScale", "InScale"}}}},
+                 removed_nodes);
+  }
+
+  // the output threshold is needed before the output is computed, so only
+  // the quantize ops calibrated offline can be fused.
+  bool Fusible(framework::Node *node) {
+    for (auto *quantize : (*node)[node_.Depth() - 1]) {
+      if (quantize->Type() != G_OP_TYPE_QUANTIZE ||
+          quantize->OpDescOfNode()->GetInputs().count("InScale") == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+#endif
+
+#ifdef FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP
+class FusionConvDequantAddBNReluQuantMatcher
+    : public FusionConvDequantQuantMatcher {
+ public:
+  FusionConvDequantAddBNReluQuantMatcher() {
+    node_ = framework::Node(G_OP_TYPE_CONV);
+    node_ > std::make_shared<framework::Node>(G_OP_TYPE_DEQUANTIZE) >
+        std::make_shared<framework::Node>(G_OP_TYPE_ELEMENTWISE_ADD) >
+        std::make_shared<framework::Node>(G_OP_TYPE_BATCHNORM) >
+        std::make_shared<framework::Node>(G_OP_TYPE_RELU) >
+        std::make_shared<framework::Node>(G_OP_TYPE_QUANTIZE);
+  }
+
+  std::string Type() { return G_OP_TYPE_FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT; }
+};
+
+DECLARE_OPERATOR(FusionConvDequantAddBNReluQuant, FusionConvDequantQuantParam,
+                 FusionConvDequantAddBNReluQuantKernel);
+#endif  // FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP
+
+#ifdef FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP
+class FusionConvDequantBNReluQuantMatcher
+    : public FusionConvDequantQuantMatcher {
+ public:
+  FusionConvDequantBNReluQuantMatcher() {
+    node_ = framework::Node(G_OP_TYPE_CONV);
+    node_ > std::make_shared<framework::Node>(G_OP_TYPE_DEQUANTIZE) >
+        std::make_shared<framework::Node>(G_OP_TYPE_BATCHNORM) >
+        std::make_shared<framework::Node>(G_OP_TYPE_RELU) >
+        std::make_shared<framework::Node>(G_OP_TYPE_QUANTIZE);
+  }
+
+  std::string Type() { return G_OP_TYPE_FUSION_CONV_DEQUANT_BN_RELU_QUANT; }
+};
+
+DECLARE_OPERATOR(FusionConvDequantBNReluQuant, FusionConvDequantQuantParam,
+                 FusionConvDequantBNReluQuantKernel);
+#endif  // FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP
+
+#ifdef FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP
+class FusionConvDequantBNRelu6QuantMatcher
+    : public FusionConvDequantQuantMatcher {
+ public:
+  FusionConvDequantBNRelu6QuantMatcher() {
+    node_ = framework::Node(G_OP_TYPE_CONV);
+    node_ > std::make_shared<framework::Node>(G_OP_TYPE_DEQUANTIZE) >
+        std::make_shared<framework::Node>(G_OP_TYPE_BATCHNORM) >
+        std::make_shared<framework::Node>(G_OP_TYPE_RELU6) >
+        std::make_shared<framework::Node>(G_OP_TYPE_QUANTIZE);
+  }
+
+  std::string Type() { return G_OP_TYPE_FUSION_CONV_DEQUANT_BN_RELU6_QUANT; }
+};
+
+DECLARE_OPERATOR(FusionConvDequantBNRelu6Quant, FusionConvDequantQuantParam,
+                 FusionConvDequantBNRelu6QuantKernel);
+#endif  // FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP
+
+#ifdef FUSION_CONV_DEQUANT_RELU_QUANT_OP
+class FusionConvDequantReluQuantMatcher : public FusionConvDequantQuantMatcher {
+ public:
+  FusionConvDequantReluQuantMatcher() {
+    node_ = framework::Node(G_OP_TYPE_CONV);
+    node_ > std::make_shared<framework::Node>(G_OP_TYPE_DEQUANTIZE) >
+        std::make_shared<framework::Node>(G_OP_TYPE_RELU) >
+        std::make_shared<framework::Node>(G_OP_TYPE_QUANTIZE);
+  }
+
+  std::string Type() { return G_OP_TYPE_FUSION_CONV_DEQUANT_RELU_QUANT; }
+};
+
+DECLARE_OPERATOR(FusionConvDequantReluQuant, FusionConvDequantQuantParam,
+                 FusionConvDequantReluQuantKernel);
+#endif  // FUSION_CONV_DEQUANT_RELU_QUANT_OP
+
+}  // namespace operators
+}  // namespace paddle_mobile
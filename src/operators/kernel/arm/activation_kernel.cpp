@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "operators/kernel/activation_kernel.h"
+#include "common/threadpool.h"
 #include "common/types.h"
 #include "operators/math/activation.h"
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
@@ -31,14 +32,15 @@ template <ActivationType Act>
 struct ActivationCompute<float, Act> {
   void operator()(const Tensor *input, Tensor *output) {
     const float *x = input->data<float>();
+    // elementwise on the whole memory block whatever the layout is
+    output->set_layout(input->layout());
     float *y = output->mutable_data<float>();
-    size_t remain = input->numel();
+    size_t remain = input->storage_numel();
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
     size_t loop = remain >> 4;
     remain = remain & 0xF;
 
-#pragma omp parallel for
-    for (size_t i = 0; i < loop; ++i) {
+    parallel_for(0, loop, [&](int i) {
       const float *local_x = x + (i << 4);
       float *local_y = y + (i << 4);
       float32x4_t r0 = vld1q_f32(local_x);
@@ -53,9 +55,19 @@ struct ActivationCompute<float, Act> {
       vst1q_f32(local_y + 4, r1);
       vst1q_f32(local_y + 8, r2);
       vst1q_f32(local_y + 12, r3);
-    }
+    });
     x += (loop << 4);
     y += (loop << 4);
+#elif defined(__x86_64__) || defined(__i386__)
+    if (math::HasAvx2()) {
+      size_t loop = remain >> 4;
+      remain = remain & 0xF;
+      parallel_for(0, loop, [&](int i) {
+        math::vActive256<Act>(x + (i << 4), y + (i << 4), 16);
+      });
+      x += (loop << 4);
+      y += (loop << 4);
+    }
 #endif
     for (size_t i = 0; i < remain; ++i) {
       y[i] = math::Active<Act>(x[i]);
@@ -23,6 +23,7 @@ namespace operators {
 template <>
 bool ConvAddAddPReluKernel<CPU, float>::Init(
     FusionConvAddAddPReluParam<CPU> *param) {
+  InitFloatConv(param);
   return true;
 }
 
@@ -51,6 +51,7 @@ bool ConvAddBNReluKernel<CPU, float>::Init(
   }
   param->SetNewScale(new_scale);
   param->SetNewBias(new_bias);
+  InitFloatConv(param);
   return true;
 }
 
@@ -15,17 +15,32 @@ limitations under the License. */
 
 #include "operators/kernel/conv_add_kernel.h"
 #include "../central-arm-func/conv_add_arm_func.h"
+#include "operators/math/blocked_layout.h"
 
 namespace paddle_mobile {
 namespace operators {
 
 template <>
 bool ConvAddKernel<CPU, float>::Init(FusionConvAddParam<CPU> *param) {
+  if (framework::DataLayoutBlock(param->Input()->layout()) > 1) {
+    math::PackConvFilterBlocked(*param->Filter(), param->Groups(),
+                                param->Input()->layout(),
+                                &param->packed_filter_);
+    return true;
+  }
+  InitFloatConv(param);
   return true;
 }
 
 template <>
 void ConvAddKernel<CPU, float>::Compute(const FusionConvAddParam<CPU> &param) {
+  if (framework::DataLayoutBlock(param.Input()->layout()) > 1) {
+    math::ConvBlocked(*param.Input(), param.packed_filter_, param.Groups(),
+                      param.Strides(), param.Paddings(), param.Dilations(),
+                      nullptr, param.Bias()->data<float>(), false,
+                      param.Output());
+    return;
+  }
   ConvAddCompute<float>(param);
 }
 
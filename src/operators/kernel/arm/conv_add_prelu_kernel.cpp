@@ -22,6 +22,7 @@ namespace operators {
 
 template <>
 bool ConvAddPReluKernel<CPU, float>::Init(FusionConvAddPReluParam<CPU> *param) {
+  InitFloatConv(param);
   return true;
 }
 
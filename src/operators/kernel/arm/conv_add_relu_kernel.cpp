@@ -16,18 +16,33 @@ limitations under the License. */
 
 #include "operators/kernel/conv_add_relu_kernel.h"
 #include "operators/kernel/central-arm-func/conv_add_relu_arm_func.h"
+#include "operators/math/blocked_layout.h"
 
 namespace paddle_mobile {
 namespace operators {
 
 template <>
 bool ConvAddReluKernel<CPU, float>::Init(FusionConvAddReluParam<CPU> *param) {
+  if (framework::DataLayoutBlock(param->Input()->layout()) > 1) {
+    math::PackConvFilterBlocked(*param->Filter(), param->Groups(),
+                                param->Input()->layout(),
+                                &param->packed_filter_);
+    return true;
+  }
+  InitFloatConv(param);
   return true;
 }
 
 template <>
 void ConvAddReluKernel<CPU, float>::Compute(
     const FusionConvAddReluParam<CPU> &param) {
+  if (framework::DataLayoutBlock(param.Input()->layout()) > 1) {
+    math::ConvBlocked(*param.Input(), param.packed_filter_, param.Groups(),
+                      param.Strides(), param.Paddings(), param.Dilations(),
+                      nullptr, param.Bias()->data<float>(), true,
+                      param.Output());
+    return;
+  }
   ConvAddReluCompute<float, float>(param);
 }
 template class ConvAddReluKernel<CPU, float>;
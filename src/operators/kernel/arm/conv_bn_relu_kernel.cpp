@@ -17,6 +17,7 @@ limitations under the License. */
 #include "operators/kernel/conv_bn_relu_kernel.h"
 #include <cmath>
 #include "operators/kernel/central-arm-func/conv_bn_relu_arm_func.h"
+#include "operators/math/blocked_layout.h"
 
 namespace paddle_mobile {
 namespace operators {
@@ -53,12 +54,26 @@ bool ConvBNReluKernel<CPU, float>::Init(FusionConvBNReluParam<CPU> *param) {
 
   param->SetNewScale(new_scale);
   param->SetNewBias(new_bias);
+  if (framework::DataLayoutBlock(param->Input()->layout()) > 1) {
+    math::PackConvFilterBlocked(*param->Filter(), param->Groups(),
+                                param->Input()->layout(),
+                                &param->packed_filter_);
+    return true;
+  }
+  InitFloatConv(param);
   return true;
 }
 
 template <>
 void ConvBNReluKernel<CPU, float>::Compute(
     const FusionConvBNReluParam<CPU> &param) {
+  if (framework::DataLayoutBlock(param.Input()->layout()) > 1) {
+    math::ConvBlocked(*param.Input(), param.packed_filter_, param.Groups(),
+                      param.Strides(), param.Paddings(), param.Dilations(),
+                      param.NewScale()->data<float>(),
+                      param.NewBias()->data<float>(), true, param.Output());
+    return;
+  }
   ConvBNReluCompute<float>(param);
 }
 template class ConvBNReluKernel<CPU, float>;
@@ -0,0 +1,150 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#if defined(FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP) || \
+    defined(FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP) ||     \
+    defined(FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP) ||    \
+    defined(FUSION_CONV_DEQUANT_RELU_QUANT_OP)
+
+#include <algorithm>
+#include <cmath>
+#include "operators/kernel/central-arm-func/conv_arm_func.h"
+#include "operators/kernel/conv_dequant_quant_kernel.h"
+#include "operators/math/gemm.h"
+
+namespace paddle_mobile {
+namespace operators {
+
+// folds the elementwise add and batch norm into a scale and bias of every
+// output channel, the params of the model are kept unchanged
+void ConvDequantQuantInitParam(FusionConvDequantQuantParam<CPU> *param) {
+  PADDLE_MOBILE_ENFORCE(param->Filter()->type() == typeid(int8_t),
+                        "the filter of a fused int8 conv must be int8");
+  const int channels = param->Filter()->dims()[0];
+  float *scale = param->fused_scale_.mutable_data<float>({channels});
+  float *bias = param->fused_bias_.mutable_data<float>({channels});
+  for (int c = 0; c < channels; ++c) {
+    scale[c] = 1.f;
+    bias[c] = 0.f;
+  }
+  if (param->bias_ != nullptr) {
+    PADDLE_MOBILE_ENFORCE(param->bias_->numel() == channels,
+                          "only the bias of every channel can be fused");
+    const float *y = param->bias_->data<float>();
+    for (int c = 0; c < channels; ++c) {
+      bias[c] = y[c];
+    }
+  }
+  if (param->bn_scale_ != nullptr) {
+    const float *mean = param->bn_mean_->data<float>();
+    const float *variance = param->bn_variance_->data<float>();
+    const float *bn_scale = param->bn_scale_->data<float>();
+    const float *bn_bias = param->bn_bias_->data<float>();
+    for (int c = 0; c < channels; ++c) {
+      float inv_std = 1.f / std::sqrt(variance[c] + param->epsilon_);
+      scale[c] = bn_scale[c] * inv_std;
+      bias[c] = (bias[c] - mean[c]) * scale[c] + bn_bias[c];
+    }
+  }
+  param->requant_scale_.mutable_data<float>({channels});
+  param->requant_bias_.ShareDataWith(param->fused_bias_);
+}
+
+template <ActivationType Act>
+void ConvDequantQuantCompute(const FusionConvDequantQuantParam<CPU> &param) {
+  // the activation scale is written by the quantize op of the input, so the
+  // dequantize scale is only known when running
+  const float activation_scale = param.activation_scale_->data<float>()[0];
+  const float *fused_scale = param.fused_scale_.data<float>();
+  float *scale = param.requant_scale_.mutable_data<float>();
+  for (int c = 0; c < param.requant_scale_.numel(); ++c) {
+    scale[c] = fused_scale[c] * activation_scale / param.WeightScale(c);
+  }
+  const float threshold =
+      std::max(param.offline_scale_->data<float>()[0], 1e-6f);
+  param.online_scale_->mutable_data<float>()[0] = threshold;
+
+  math::RequantParam requant;
+  requant.scale = scale;
+  requant.bias = param.requant_bias_.data<float>();
+  requant.act = Act;
+  requant.quant_scale = 127.f / threshold;
+  requant.round = param.round_type_;
+  GemmConv<int8_t, int8_t>(param, &requant);
+}
+
+#ifdef FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP
+template <>
+bool FusionConvDequantAddBNReluQuantKernel<CPU, float>::Init(
+    FusionConvDequantQuantParam<CPU> *param) {
+  ConvDequantQuantInitParam(param);
+  return true;
+}
+
+template <>
+void FusionConvDequantAddBNReluQuantKernel<CPU, float>::Compute(
+    const FusionConvDequantQuantParam<CPU> &param) {
+  ConvDequantQuantCompute<RELU>(param);
+}
+#endif  // FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP
+
+#ifdef FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP
+template <>
+bool FusionConvDequantBNReluQuantKernel<CPU, float>::Init(
+    FusionConvDequantQuantParam<CPU> *param) {
+  ConvDequantQuantInitParam(param);
+  return true;
+}
+
+template <>
+void FusionConvDequantBNReluQuantKernel<CPU, float>::Compute(
+    const FusionConvDequantQuantParam<CPU> &param) {
+  ConvDequantQuantCompute<RELU>(param);
+}
+#endif  // FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP
+
+#ifdef FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP
+template <>
+bool FusionConvDequantBNRelu6QuantKernel<CPU, float>::Init(
+    FusionConvDequantQuantParam<CPU> *param) {
+  ConvDequantQuantInitParam(param);
+  return true;
+}
+
+template <>
+void FusionConvDequantBNRelu6QuantKernel<CPU, float>::Compute(
+    const FusionConvDequantQuantParam<CPU> &param) {
+  ConvDequantQuantCompute<RELU6>(param);
+}
+#endif  // FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP
+
+#ifdef FUSION_CONV_DEQUANT_RELU_QUANT_OP
+template <>
+bool FusionConvDequantReluQuantKernel<CPU, float>::Init(
+    FusionConvDequantQuantParam<CPU> *param) {
+  ConvDequantQuantInitParam(param);
+  return true;
+}
+
+template <>
+void FusionConvDequantReluQuantKernel<CPU, float>::Compute(
+    const FusionConvDequantQuantParam<CPU> &param) {
+  ConvDequantQuantCompute<RELU>(param);
+}
+#endif  // FUSION_CONV_DEQUANT_RELU_QUANT_OP
+
+}  // namespace operators
+}  // namespace paddle_mobile
+
+#endif
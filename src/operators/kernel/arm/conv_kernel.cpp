@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include "operators/kernel/conv_kernel.h"
 #include "operators/kernel/central-arm-func/conv_arm_func.h"
+#include "operators/math/blocked_layout.h"
 
 namespace paddle_mobile {
 namespace operators {
@@ -44,40 +45,14 @@ bool ConvKernel<CPU, float>::Init(ConvParam<CPU> *param) {
 #ifndef __aarch64__
     }
 #endif  // __aarch64__
+  } else if (framework::DataLayoutBlock(param->Input()->layout()) > 1) {
+    // the input is blocked by the layout optimization pass
+    param->ExecMode() = ConvParam<CPU>::EXEC_BLOCKED_FLOAT;
+    math::PackConvFilterBlocked(*param->Filter(), param->Groups(),
+                                param->Input()->layout(),
+                                &param->packed_filter_);
   } else {
-    if (depth3x3 && param->Strides()[0] == param->Strides()[1] &&
-        param->Strides()[0] == 1 && param->Paddings()[0] == 1 &&
-        param->Paddings()[0] == param->Paddings()[1]) {
-      param->ExecMode() = ConvParam<CPU>::EXEC_DEPTHWISE3x3S1P1_FLOAT;
-    } else if (depth3x3 && param->Strides()[0] == param->Strides()[1] &&
-               param->Strides()[0] == 2 && param->Paddings()[0] == 0 &&
-               param->Paddings()[0] == param->Paddings()[1]) {
-      param->ExecMode() = ConvParam<CPU>::EXEC_DEPTHWISE3x3S2P0_FLOAT;
-    } else if (depth3x3 && param->Strides()[0] == param->Strides()[1] &&
-               param->Strides()[0] == 2 && param->Paddings()[0] == 1 &&
-               param->Paddings()[0] == param->Paddings()[1]) {
-      param->ExecMode() = ConvParam<CPU>::EXEC_DEPTHWISE3x3S2P1_FLOAT;
-    } else if (depth3x3) {
-      param->ExecMode() = ConvParam<CPU>::EXEC_DEPTHWISE3x3_FLOAT;
-#ifndef __aarch64__
-    } else if (depth5x5 && param->Strides()[0] == param->Strides()[1] &&
-               param->Strides()[0] == 1) {
-      param->ExecMode() = ConvParam<CPU>::EXEC_DEPTHWISE5x5_FLOAT;
-    } else if (conv3x3 && param->Strides()[0] == param->Strides()[1] &&
-               param->Dilations()[0] == param->Dilations()[1] &&
-               param->Strides()[0] == 1 && param->Dilations()[0] == 1 &&
-               param->Output()->dims()[1] >= 16 &&
-               param->Input()->dims()[1] >= 16 &&
-               param->Input()->dims()[2] <= 140 /* refered from ncnn */) {
-      param->ExecMode() = ConvParam<CPU>::EXEC_WINOGRAD3X3_FLOAT;
-      // transform weight
-      param->transformed_filter_ = new framework::Tensor;
-      operators::math::winograd_transform_weight<8, 3>(
-          *param->Filter(), param->transformed_filter_);
-#endif
-    } else {
-      param->ExecMode() = ConvParam<CPU>::EXEC_GEMM_FLOAT;
-    }
+    InitFloatConv(param);
   }
   return true;
 }
@@ -96,36 +71,14 @@ void ConvKernel<CPU, float>::Compute(const ConvParam<CPU> &param) {
       DepthwiseConv5x5<int8_t, int32_t>(param);
       break;
 #endif  // __aarch64__
-    case ConvParam<CPU>::EXEC_DEPTHWISE3x3S1P1_FLOAT:
-      math::DepthwiseConv3x3s1p1(param.Input(), param.Filter(), param.Output(),
-                                 nullptr, false, false);
-      break;
-    case ConvParam<CPU>::EXEC_DEPTHWISE3x3S2P1_FLOAT:
-      math::DepthwiseConv3x3s2p1v2(param.Input(), param.Filter(),
-                                   param.Output(), nullptr, false, false);
-      break;
-    case ConvParam<CPU>::EXEC_DEPTHWISE3x3S2P0_FLOAT:
-      math::DepthwiseConv3x3s2p0(param.Input(), param.Filter(), param.Output(),
-                                 nullptr, false, false);
-      break;
-    case ConvParam<CPU>::EXEC_DEPTHWISE3x3_FLOAT:
-      math::DepthwiseConv3x3(param.Input(), param.Strides(), param.Paddings(),
-                             param.Filter(), nullptr, param.Output(), false);
-      break;
-#ifndef __aarch64__
-    case ConvParam<CPU>::EXEC_DEPTHWISE5x5_FLOAT:
-      DepthwiseConv5x5<float, float>(param);
-      break;
-    case ConvParam<CPU>::EXEC_WINOGRAD3X3_FLOAT:
-      WinogradConv3x3<8, 3>(param);
-      break;
-#endif  // __aarch64__
-    case ConvParam<CPU>::EXEC_GEMM_FLOAT:
-      GemmConv<float, float>(param);
+    case ConvParam<CPU>::EXEC_BLOCKED_FLOAT:
+      math::ConvBlocked(*param.Input(), param.packed_filter_, param.Groups(),
+                        param.Strides(), param.Paddings(), param.Dilations(),
+                        nullptr, nullptr, false, param.Output());
       break;
     default:
-      PADDLE_MOBILE_THROW_EXCEPTION("Invalid convolution execute mode %d",
-                                    param.ExecMode());
+      FloatConv(param, NoEpilogue());
+      break;
   }
 }
 
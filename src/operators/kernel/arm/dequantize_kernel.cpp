@@ -15,6 +15,7 @@ limitations under the License. */
 #ifdef DEQUANT_OP
 
 #include "operators/kernel/dequantize_kernel.h"
+#include "common/threadpool.h"
 
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
 #include <arm_neon.h>
@@ -28,6 +29,25 @@ bool DequantizeKernel<CPU, float>::Init(DequantizeParam<CPU> *param) {
   return true;
 }
 
+// y = x * scale over a block of one channel
+static void DequantizeBlock(const int32_t *x, const float scale, float *y,
+                            size_t size) {
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+  size_t loop = size >> 3;
+  size &= 0x7;
+  float32x4_t s = vdupq_n_f32(scale);
+  for (size_t i = 0; i < loop; ++i, x += 8, y += 8) {
+    float32x4_t f0 = vcvtq_f32_s32(vld1q_s32(x));
+    float32x4_t f1 = vcvtq_f32_s32(vld1q_s32(x + 4));
+    vst1q_f32(y, vmulq_f32(f0, s));
+    vst1q_f32(y + 4, vmulq_f32(f1, s));
+  }
+#endif
+  for (size_t i = 0; i < size; ++i) {
+    y[i] = x[i] * scale;
+  }
+}
+
 template <>
 void DequantizeKernel<CPU, float>::Compute(const DequantizeParam<CPU> &param) {
   const LoDTensor *input = param.input_;
@@ -37,6 +57,22 @@ void DequantizeKernel<CPU, float>::Compute(const DequantizeParam<CPU> &param) {
   const int32_t *x = input->data<const int32_t>();
   float *y = output->mutable_data<float>();
   size_t size = output->numel();
+  if (!param.weight_scales_.empty()) {
+    // per channel weight scales, the channels are the second dimension of
+    // the conv and fc outputs
+    const int channels = param.weight_scales_.size();
+    const int outer = output->dims()[0];
+    PADDLE_MOBILE_ENFORCE(output->dims().size() >= 2 &&
+                              output->dims()[1] == channels,
+                          "weight scales mismatch the output channels");
+    const size_t inner = size / (outer * channels);
+    parallel_for(0, outer * channels, [&](int i) {
+      float scale = activation_scale / param.WeightScale(i % channels);
+      DequantizeBlock(x + i * inner, scale, y + i * inner, inner);
+    });
+    output->set_lod(input->lod());
+    return;
+  }
   // float scale = 1.f / (activation_scale * weight_scale);
   float scale = activation_scale / weight_scale;
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
@@ -44,8 +80,7 @@ void DequantizeKernel<CPU, float>::Compute(const DequantizeParam<CPU> &param) {
   size_t remain = size & 0xF;
   float32x4_t s = vdupq_n_f32(scale);
 
-  #pragma omp parallel for
-  for (size_t i = 0; i < loop; ++i) {
+  parallel_for(0, loop, [&](int i) {
     const int32_t *local_x = x + (i << 4);
     float *local_y = y + (i << 4);
     int32x4_t r0 = vld1q_s32(local_x);
@@ -64,7 +99,7 @@ void DequantizeKernel<CPU, float>::Compute(const DequantizeParam<CPU> &param) {
     vst1q_f32(local_y + 4, f1);
     vst1q_f32(local_y + 8, f2);
     vst1q_f32(local_y + 12, f3);
-  }
+  });
   size = remain;
   x += (loop << 4);
   y += (loop << 4);
@@ -16,12 +16,24 @@ limitations under the License. */
 
 #include "operators/kernel/fusion_fc_kernel.h"
 #include "operators/kernel/central-arm-func/fusion_fc_arm_func.h"
+#include "operators/math/gemm_tuner.h"
 
 namespace paddle_mobile {
 namespace operators {
 
 template <>
 bool FusionFcKernel<CPU, float>::Init(FusionFcParam<CPU> *param) {
+  const Tensor *input_y = param->InputY();
+  const Tensor y_matrix =
+      input_y->dims().size() > 2
+          ? framework::ReshapeToMatrix(*input_y, param->YNumColDims())
+          : *input_y;
+  // an unknown batch size leaves m negative, which is not tuned
+  const framework::DDim x_dims = framework::flatten_to_2d(
+      param->InputX()->dims(), param->XNumColDims());
+  math::GemmTuner::Instance()->Tune(x_dims[0], y_matrix.dims()[1],
+                                    x_dims[1]);
+  math::PackFcWeight(y_matrix, &param->packed_weight_);
   return true;
 }
 
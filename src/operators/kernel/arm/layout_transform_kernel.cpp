@@ -0,0 +1,36 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+#ifdef LAYOUT_TRANSFORM_OP
+
+#include "operators/kernel/layout_transform_kernel.h"
+#include "operators/math/blocked_layout.h"
+
+namespace paddle_mobile {
+namespace operators {
+
+template <>
+bool LayoutTransformKernel<CPU, float>::Init(LayoutTransformParam<CPU> *param) {
+  return true;
+}
+
+template <>
+void LayoutTransformKernel<CPU, float>::Compute(
+    const LayoutTransformParam<CPU> &param) {
+  math::LayoutTransform(*param.input_, param.dst_layout_, param.output_);
+}
+
+}  // namespace operators
+}  // namespace paddle_mobile
+
+#endif  // LAYOUT_TRANSFORM_OP
@@ -16,12 +16,19 @@ limitations under the License. */
 
 #include "operators/kernel/mul_kernel.h"
 #include "operators/kernel/central-arm-func/mul_arm_func.h"
+#include "operators/math/gemm_tuner.h"
 
 namespace paddle_mobile {
 namespace operators {
 
 template <>
 bool MulKernel<CPU, float>::Init(MulParam<CPU> *param) {
+  // an unknown batch size leaves m negative, which is not tuned
+  const framework::DDim x_dims = framework::flatten_to_2d(
+      param->InputX()->dims(), param->XNumColDims());
+  const framework::DDim y_dims = framework::flatten_to_2d(
+      param->InputY()->dims(), param->YNumColDims());
+  math::GemmTuner::Instance()->Tune(x_dims[0], y_dims[1], x_dims[1]);
   return true;
 }
 
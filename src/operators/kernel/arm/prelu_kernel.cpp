@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include "operators/kernel/prelu_kernel.h"
 #include <operators/math/transform.h>
+#include "common/threadpool.h"
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif
@@ -47,12 +48,9 @@ void PReluKernel<CPU, float>::Compute(const PReluParam<CPU> &param) {
   auto dim = x->dims();
   int k = dim[0] * dim[1];
   int n = dim[2] * dim[3];
-  int index = 0;
-  int i = 0;
   int temp = 0;
 #if __ARM_NEON
-  #pragma omp parallel for
-  for (int i = 0; i < k; i++) {
+  parallel_for(0, k, [&](int i) {
     float32x4_t zero = vdupq_n_f32(0.0);
     float32x4_t cv;
     float32x4_t cv1;
@@ -93,26 +91,23 @@ void PReluKernel<CPU, float>::Compute(const PReluParam<CPU> &param) {
                                : alpha_ptr[0] * x_ptr[i * n + m];
       }
     }
-  }
+  });
 
 #else
   if (mode == "channel") {
     temp = numel / (dim[0] * dim[1]);
-#pragma omp parallel for
-    for (i = 0; i < numel; i++) {
-      index = (i / temp) % dim[1];
+    parallel_for(0, numel, [&](int i) {
+      int index = (i / temp) % dim[1];
       o_ptr[i] = x_ptr[i] > 0 ? x_ptr[i] : alpha_ptr[index] * x_ptr[i];
-    }
+    });
   } else if (mode == "element") {
-#pragma omp parallel for
-    for (i = 0; i < numel; i++) {
+    parallel_for(0, numel, [&](int i) {
       o_ptr[i] = x_ptr[i] > 0 ? x_ptr[i] : alpha_ptr[i] * x_ptr[i];
-    }
+    });
   } else {
-#pragma omp parallel for
-    for (i = 0; i < numel; i++) {
+    parallel_for(0, numel, [&](int i) {
       o_ptr[i] = x_ptr[i] > 0 ? x_ptr[i] : alpha_ptr[0] * x_ptr[i];
-    }
+    });
   }
 #endif
 }
@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include "operators/kernel/quantize_kernel.h"
 #include <cmath>
+#include "common/threadpool.h"
 #include "operators/math/quantize.h"
 
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
@@ -31,7 +32,8 @@ inline float32_t vmaxvq_f32(float32x4_t r) {
   float32x2_t v = vmax_f32(vget_high_f32(r), vget_low_f32(r));
   return vget_lane_f32(vpmax_f32(v, v), 0);
 }
-#endif
+#endif  // __aarch64__
+#endif  // __ARM_NEON__
 
 template <RoundType R>
 inline void QuantizeOffline(const Tensor *input, const float scale,
@@ -45,8 +47,7 @@ inline void QuantizeOffline(const Tensor *input, const float scale,
   float32x4_t __scale = vdupq_n_f32(scale);
   float32x4_t __postive_max = vdupq_n_f32(max_abs);
   float32x4_t __negtive_max = vdupq_n_f32(-max_abs);
-  #pragma omp parallel for
-  for (size_t i = 0; i < loop; ++i) {
+  parallel_for(0, loop, [&](int i) {
     const float *local_x = x + (i << 4);
     int8_t *local_y = y + (i << 4);
     float32x4_t r0 = vld1q_f32(local_x);
@@ -75,7 +76,7 @@ inline void QuantizeOffline(const Tensor *input, const float scale,
     int8x8_t d6 = vmovn_s16(q6);
     vst1_s8(local_y, d5);
     vst1_s8(local_y + 8, d6);
-  }
+  });
   x += (loop << 4);
   y += (loop << 4);
 #endif
@@ -95,8 +96,7 @@ inline void QuantizeOnline(const Tensor *input, const float scale,
   size_t loop = remain >> 4;
   remain = remain & 0xF;
   float32x4_t __scale = vdupq_n_f32(scale);
-  #pragma omp parallel for
-  for (size_t i = 0; i < loop; ++i) {
+  parallel_for(0, loop, [&](int i) {
     const float *local_x = x + (i << 4);
     int8_t *local_y = y + (i << 4);
     float32x4_t r0 = vld1q_f32(local_x);
@@ -121,7 +121,7 @@ inline void QuantizeOnline(const Tensor *input, const float scale,
     int8x8_t d6 = vmovn_s16(q6);
     vst1_s8(local_y, d5);
     vst1_s8(local_y + 8, d6);
-  }
+  });
   x += (loop << 4);
   y += (loop << 4);
 #endif
@@ -167,18 +167,11 @@ float find_abs_max(const Tensor *input) {
   max_abs = vmaxvq_f32(__max);
 #endif
   for (size_t i = 0; i < remain; ++i) {
-    max_abs = std::max(max_abs, fabs(x[i]));
+    max_abs = std::max(max_abs, std::fabs(x[i]));
   }
   return max_abs;
 }
 
-}  // namespace operators
-}  // namespace paddle_mobile
-#endif  // __ARM_NEON__
-
-namespace paddle_mobile {
-namespace operators {
-
 template <>
 bool QuantizeKernel<CPU, float>::Init(QuantizeParam<CPU> *param) {
   return true;
@@ -15,6 +15,7 @@ limitations under the License. */
 #ifdef SCALE_OP
 
 #include "operators/kernel/scale_kernel.h"
+#include "common/threadpool.h"
 
 namespace paddle_mobile {
 namespace operators {
@@ -38,15 +39,13 @@ void ScaleKernel<CPU, float>::Compute(const ScaleParam<CPU> &param) {
       const int input_width = input_x->dims()[0];
       if (has_bias) {
         const vector<float> biases = param.Biases();
-        #pragma omp parallel for
-        for (int w = 0; w < input_width; w++) {
+        parallel_for(0, input_width, [&](int w) {
           out_ptr[w] = input_x_ptr[w] * scales[w] + biases[w];
-        }
+        });
       } else {
-        #pragma omp parallel for
-        for (int w = 0; w < input_width; w++) {
+        parallel_for(0, input_width, [&](int w) {
           out_ptr[w] = input_x_ptr[w] * scales[w];
-        }
+        });
       }
     } break;
     case 2: {
@@ -55,23 +54,21 @@ void ScaleKernel<CPU, float>::Compute(const ScaleParam<CPU> &param) {
 
       if (has_bias) {
         const vector<float> biases = param.Biases();
-        #pragma omp parallel for
-        for (int h = 0; h < input_height; ++h) {
+        parallel_for(0, input_height, [&](int h) {
           const float *iptr = input_x_ptr + h * input_width;
           float *optr = out_ptr + h * input_width;
           for (int w = 0; w < input_width; ++w) {
             optr[w] = iptr[w] * scales[w] + biases[w];
           }
-        }
+        });
       } else {
-        #pragma omp parallel for
-        for (int h = 0; h < input_height; ++h) {
+        parallel_for(0, input_height, [&](int h) {
           const float *iptr = input_x_ptr + h * input_width;
           float *optr = out_ptr + h * input_width;
           for (int w = 0; w < input_width; ++w) {
             optr[w] = iptr[w] * scales[w];
           }
-        }
+        });
       }
     } break;
     case 3: {
@@ -83,23 +80,21 @@ void ScaleKernel<CPU, float>::Compute(const ScaleParam<CPU> &param) {
       if (has_bias) {
         const vector<float> biases = param.Biases();
 
-        #pragma omp parallel for
-        for (int c = 0; c < chan_size; ++c) {
+        parallel_for(0, chan_size, [&](int c) {
           const float *iptr = input_x_ptr + c * size;
           float *optr = out_ptr + c * size;
           for (int i = 0; i < size; ++i) {
             optr[i] = iptr[i] * scales[c] + biases[c];
           }
-        }
+        });
       } else {
-        #pragma omp parallel for
-        for (int c = 0; c < chan_size; ++c) {
+        parallel_for(0, chan_size, [&](int c) {
           const float *iptr = input_x_ptr + c * size;
           float *optr = out_ptr + c * size;
           for (int i = 0; i < size; ++i) {
             optr[i] = iptr[i] * scales[c];
           }
-        }
+        });
       }
     } break;
 
@@ -113,8 +108,7 @@ void ScaleKernel<CPU, float>::Compute(const ScaleParam<CPU> &param) {
       if (has_bias) {
         const vector<float> biases = param.Biases();
 
-        #pragma omp parallel for
-        for (int b = 0; b < batch_size; ++b) {
+        parallel_for(0, batch_size, [&](int b) {
           for (int c = 0; c < chan_size; ++c) {
             const float *iptr = input_x_ptr + b * c * size;
             float *optr = out_ptr + b * c * size;
@@ -122,10 +116,9 @@ void ScaleKernel<CPU, float>::Compute(const ScaleParam<CPU> &param) {
               optr[i] = iptr[i] * scales[c] + biases[c];
             }
           }
-        }
+        });
       } else {
-        #pragma omp parallel for
-        for (int b = 0; b < batch_size; ++b) {
+        parallel_for(0, batch_size, [&](int b) {
           for (int c = 0; c < chan_size; ++c) {
             const float *iptr = input_x_ptr + b * c * size;
             float *optr = out_ptr + b * c * size;
@@ -133,7 +126,7 @@ void ScaleKernel<CPU, float>::Compute(const ScaleParam<CPU> &param) {
               optr[i] = iptr[i] * scales[c];
             }
           }
-        }
+        });
       }
     } break;
     default:
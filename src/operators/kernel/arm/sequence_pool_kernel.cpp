@@ -18,6 +18,7 @@ limitations under the License. */
 #include <limits>
 #include <string>
 #include <vector>
+#include "common/threadpool.h"
 #include "common/types.h"
 #include "operators/kernel/sequence_kernels.h"
 #include "operators/math/pooling.h"
@@ -36,8 +37,7 @@ void SequencePoolImpl(const framework::LoDTensor &input,
   const auto &lod = input.lod()[0];
   int64_t width = input.numel() / input.dims()[0];
 
-  #pragma omp parallel for
-  for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
+  parallel_for(0, static_cast<int>(lod.size()) - 1, [&](int i) {
     const float *in_ptr = input_ptr + lod[i] * width;
     float *out_ptr = output_ptr + i * width;
     int64_t height = static_cast<int64_t>(lod[i + 1] - lod[i]);
@@ -85,7 +85,7 @@ void SequencePoolImpl(const framework::LoDTensor &input,
         in_ptr += width;
       }
     }
-  }
+  });
 }
 
 template <>
@@ -96,8 +96,7 @@ void SequencePoolImpl<SUM, float>(const framework::LoDTensor &input,
   const auto &lod = input.lod()[0];
   int64_t width = input.numel() / input.dims()[0];
 
-  #pragma omp parallel for
-  for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
+  parallel_for(0, static_cast<int>(lod.size()) - 1, [&](int i) {
     const float *in_ptr = input_ptr + lod[i] * width;
     float *out_ptr = output_ptr + i * width;
     int64_t height = static_cast<int64_t>(lod[i + 1] - lod[i]);
@@ -145,7 +144,7 @@ void SequencePoolImpl<SUM, float>(const framework::LoDTensor &input,
         in_ptr += width;
       }
     }
-  }
+  });
 }
 
 template <>
@@ -16,7 +16,10 @@ limitations under the License. */
 
 #include <algorithm>
 #include <iostream>
-#include <vector>
+#include <new>
+#include <utility>
+#include "common/threadpool.h"
+#include "framework/workspace.h"
 #include "operators/kernel/kernels.h"
 
 namespace paddle_mobile {
@@ -41,25 +44,30 @@ void TopKKernel<CPU, float>::Compute(const TopKParam<CPU> &param) {
       framework::slice_ddim(input_dims, 0, input_dims.size() - 1));
   const size_t col = input_dims[input_dims.size() - 1];
 
-  #pragma omp parallel for
-  for (size_t i = 0; i < row; i++) {
-    std::vector<std::pair<float, size_t>> vec(col);
+  // the row every thread sorts
+  typedef std::pair<float, size_t> Entry;
+  framework::WorkspaceScope scratch;
+  Entry *entries =
+      scratch.Allocate<Entry>(ThreadPool::Instance()->ThreadNum() * col);
+
+  parallel_for_tid(0, row, [&](int i, int tid) {
+    Entry *vec = entries + tid * col;
     const float *input_ptr = input_data + i * col;
     float *output_ptr = output_data + i * param.k_;
     int64_t *indices_ptr = indices_data + i * param.k_;
 
     for (size_t j = 0; j < col; j++) {
-      vec[j] = std::move(std::pair<float, size_t>(input_ptr[j], j));
+      new (&vec[j]) Entry(input_ptr[j], j);
     }
-    std::partial_sort(
-        vec.begin(), vec.begin() + param.k_, vec.end(),
-        [](const std::pair<float, size_t> &l,
-           const std::pair<float, size_t> &r) { return l.first > r.first; });
+    std::partial_sort(vec, vec + param.k_, vec + col,
+                      [](const Entry &l, const Entry &r) {
+                        return l.first > r.first;
+                      });
     for (int j = 0; j < param.k_; ++j) {
       output_ptr[j] = vec[j].first;
       indices_ptr[j] = static_cast<int64_t>(vec[j].second);
     }
-  }
+  });
 }
 
 }  // namespace operators
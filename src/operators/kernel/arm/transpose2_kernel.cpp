@@ -15,6 +15,7 @@ limitations under the License. */
 #ifdef TRANSPOSE2_OP
 
 #include "operators/kernel/transpose2_kernel.h"
+#include "common/threadpool.h"
 
 namespace paddle_mobile {
 namespace operators {
@@ -49,18 +50,15 @@ void ShuffleChannelCompute(const Transpose2Param<CPU> &param) {
     offset *= in_dim[i];
   }
 
-  #pragma omp parallel for collapse(3)
-  for (int batch = 0; batch < out_dim[0]; ++batch) {
-    for (int c1 = 0; c1 < out_dim[1]; ++c1) {
-      for (int c2 = 0; c2 < out_dim[2]; ++c2) {
-        size_t out_offset =
-            ((batch * out_dim[1] + c1) * out_dim[2] + c2) * offset;
-        size_t in_offset = ((batch * in_dim[1] + c2) * in_dim[2] + c1) * offset;
-        memcpy(output_ptr + out_offset, input_ptr + in_offset,
-               offset * sizeof(Dtype));
-      }
-    }
-  }
+  parallel_for(0, out_dim[0] * out_dim[1] * out_dim[2], [&](int index) {
+    int batch = index / (out_dim[1] * out_dim[2]);
+    int c1 = index / out_dim[2] % out_dim[1];
+    int c2 = index % out_dim[2];
+    size_t out_offset = ((batch * out_dim[1] + c1) * out_dim[2] + c2) * offset;
+    size_t in_offset = ((batch * in_dim[1] + c2) * in_dim[2] + c1) * offset;
+    memcpy(output_ptr + out_offset, input_ptr + in_offset,
+           offset * sizeof(Dtype));
+  });
 }
 
 template <typename Dtype>
@@ -91,29 +89,28 @@ void Transpose2Compute(const Transpose2Param<CPU> &param) {
     reamin_dim *= out_dim[i];
   }
 
-  #pragma omp parallel for collapse(2)
-  for (int batch = 0; batch < out_dim[0]; ++batch) {
-    for (int j = 0; j < out_dim[1]; ++j) {
-      size_t offset = batch * strides[permute - 1] + j * strides[permute - 2];
-      Dtype *out_ptr = output_ptr + (batch * out_dim[1] + j) * reamin_dim;
-      int indics[4] = {0, 0, 0, 0};
-      for (int k = 0; k < reamin_dim; ++k) {
-        out_ptr[k] = input_ptr[offset];
-        indics[0] += 1;
-        offset += strides[0];
-        for (int p = 0; p < permute - 3; ++p) {
-          if (indics[p] == rout_dim[p]) {
-            indics[p + 1] += 1;
-            indics[p] = 0;
-            offset += strides[p + 1];
-            offset -= rout_dim[p] * strides[p];
-          } else {
-            break;
-          }
+  parallel_for(0, out_dim[0] * out_dim[1], [&](int index) {
+    int batch = index / out_dim[1];
+    int j = index % out_dim[1];
+    size_t offset = batch * strides[permute - 1] + j * strides[permute - 2];
+    Dtype *out_ptr = output_ptr + (batch * out_dim[1] + j) * reamin_dim;
+    int indics[4] = {0, 0, 0, 0};
+    for (int k = 0; k < reamin_dim; ++k) {
+      out_ptr[k] = input_ptr[offset];
+      indics[0] += 1;
+      offset += strides[0];
+      for (int p = 0; p < permute - 3; ++p) {
+        if (indics[p] == rout_dim[p]) {
+          indics[p + 1] += 1;
+          indics[p] = 0;
+          offset += strides[p + 1];
+          offset -= rout_dim[p] * strides[p];
+        } else {
+          break;
         }
       }
     }
-  }
+  });
 }
 
 template <>
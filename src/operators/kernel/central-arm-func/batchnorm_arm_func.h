@@ -17,6 +17,10 @@ limitations under the License. */
 #pragma once
 
 #include <cmath>
+#include <vector>
+#include "common/threadpool.h"
+#include "operators/math/blocked_layout.h"
+#include "operators/math/math_func_avx.h"
 #include "operators/op_param.h"
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
 #include <arm_neon.h>
@@ -36,45 +40,60 @@ void BatchnormCompute(const BatchNormParam<CPU> &param) {
   const framework::Tensor *input = param.InputX();
   const float *input_ptr = input->data<float>();
   framework::Tensor *output = param.OutputY();
+  if (framework::DataLayoutBlock(input->layout()) > 1) {
+    const int channels = input->dims()[1];
+    std::vector<float> scale(channels), bias(channels);
+    for (int c = 0; c < channels; ++c) {
+      float inv_scale = 1.f / (std::sqrt(variance_ptr[c] + epsilon));
+      scale[c] = inv_scale * scale_ptr[c];
+      bias[c] = bias_ptr[c] - scale[c] * mean_ptr[c];
+    }
+    math::ScaleBiasBlocked(*input, scale.data(), bias.data(), false, output);
+    return;
+  }
   float *output_ptr = output->mutable_data<float>();
   size_t spatial_size = output->dims()[2] * output->dims()[3];
   int channels = output->dims()[1];
 
-  #pragma omp parallel for collapse(2)
-  for (int batch = 0; batch < output->dims()[0]; ++batch) {
-    for (int c = 0; c < channels; ++c) {
-      float inv_scale = 1.f / (std::sqrt(variance_ptr[c] + epsilon));
-      float bias = bias_ptr[c] - inv_scale * scale_ptr[c] * mean_ptr[c];
-      float scale = inv_scale * scale_ptr[c];
-      size_t offset = (batch * channels + c) * spatial_size;
-      const float *x = input_ptr + offset;
-      float *y = output_ptr + offset;
-      size_t remain = spatial_size;
+  parallel_for(0, output->dims()[0] * channels, [&](int index) {
+    int batch = index / channels;
+    int c = index % channels;
+    float inv_scale = 1.f / (std::sqrt(variance_ptr[c] + epsilon));
+    float bias = bias_ptr[c] - inv_scale * scale_ptr[c] * mean_ptr[c];
+    float scale = inv_scale * scale_ptr[c];
+    size_t offset = (batch * channels + c) * spatial_size;
+    const float *x = input_ptr + offset;
+    float *y = output_ptr + offset;
+    size_t remain = spatial_size;
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
-      int loop = spatial_size >> 4;
-      remain = spatial_size & 0xF;
-      float32x4_t __scale = vdupq_n_f32(scale);
-      float32x4_t __bias = vdupq_n_f32(bias);
-      for (int k = 0; k < loop; ++k, x += 16, y += 16) {
-        float32x4_t r0 = vld1q_f32(x);
-        float32x4_t r1 = vld1q_f32(x + 4);
-        float32x4_t r2 = vld1q_f32(x + 8);
-        float32x4_t r3 = vld1q_f32(x + 12);
-        r0 = vmlaq_f32(__bias, __scale, r0);
-        r1 = vmlaq_f32(__bias, __scale, r1);
-        r2 = vmlaq_f32(__bias, __scale, r2);
-        r3 = vmlaq_f32(__bias, __scale, r3);
-        vst1q_f32(y, r0);
-        vst1q_f32(y + 4, r1);
-        vst1q_f32(y + 8, r2);
-        vst1q_f32(y + 12, r3);
-      }
+    int loop = spatial_size >> 4;
+    remain = spatial_size & 0xF;
+    float32x4_t __scale = vdupq_n_f32(scale);
+    float32x4_t __bias = vdupq_n_f32(bias);
+    for (int k = 0; k < loop; ++k, x += 16, y += 16) {
+      float32x4_t r0 = vld1q_f32(x);
+      float32x4_t r1 = vld1q_f32(x + 4);
+      float32x4_t r2 = vld1q_f32(x + 8);
+      float32x4_t r3 = vld1q_f32(x + 12);
+      r0 = vmlaq_f32(__bias, __scale, r0);
+      r1 = vmlaq_f32(__bias, __scale, r1);
+      r2 = vmlaq_f32(__bias, __scale, r2);
+      r3 = vmlaq_f32(__bias, __scale, r3);
+      vst1q_f32(y, r0);
+      vst1q_f32(y + 4, r1);
+      vst1q_f32(y + 8, r2);
+      vst1q_f32(y + 12, r3);
+    }
+#elif defined(__x86_64__) || defined(__i386__)
+    if (math::HasAvx2()) {
+      math::ScaleBias256(x, scale, bias, y, spatial_size);
+      return;
+    }
 #endif  // __ARM_NEON__
-      for (int k = 0; k < remain; ++k) {
-        y[k] = scale * x[k] + bias;
-      }
+    for (int k = 0; k < remain; ++k) {
+      y[k] = scale * x[k] + bias;
     }
-  }
+  });
 }
 
 }  // namespace operators
@@ -16,6 +16,7 @@ limitations under the License. */
 #pragma once
 
 #include <vector>
+#include "operators/math/blocked_layout.h"
 
 namespace paddle_mobile {
 namespace operators {
@@ -58,6 +59,12 @@ void ConcatCompute(const ConcatParam<CPU> &param) {
   auto inputs = param.Inputs();
   auto *out = param.Out();
   int axis = param.Axis();
+  if (framework::DataLayoutBlock(inputs[0]->layout()) > 1) {
+    math::ConcatBlocked(
+        std::vector<const framework::Tensor *>(inputs.begin(), inputs.end()),
+        out);
+    return;
+  }
   out->mutable_data<P>();
 
   /// Sometimes direct copies will be faster, this maybe need deeply analysis.
@@ -17,10 +17,10 @@ limitations under the License. */
 
 #include <string>
 #include <vector>
+#include "operators/kernel/central-arm-func/conv_arm_func.h"
 #include "operators/math/conv_func.h"
-#include "operators/math/im2col.h"
+#include "operators/math/gemm_epilogue.h"
 #include "operators/math/math_function.h"
-#include "operators/math/vol2col.h"
 #include "operators/op_param.h"
 
 namespace paddle_mobile {
@@ -28,98 +28,19 @@ namespace operators {
 
 template <typename P>
 void ConvAddAddPReluCompute(const FusionConvAddAddPReluParam<CPU> &param) {
-  const Tensor *input = param.Input();
-  Tensor filter = *param.Filter();
-  Tensor bias = *param.Bias();
-  Tensor bias1 = *param.Bias1();
   Tensor *output = param.Output();
   output->mutable_data<float>();
-  float *biase_data = bias.data<float>();
-
-  int axis = param.Axis();
-  int groups = param.Groups();
-  std::vector<int> strides = param.Strides();
-  std::vector<int> paddings = param.Paddings();
-  std::vector<int> dilations = param.Dilations();
-  Tensor aa = *param.InputAlpha();
-  float *p = aa.data<float>();
-
-  std::string mode = param.Mode();
-  const int batch_size = static_cast<int>(input->dims()[0]);
-
-  std::vector<int64_t> filter_shape_vec(framework::vectorize(filter.dims()));
-
-  std::vector<int64_t> output_shape_vec(framework::vectorize(output->dims()));
-  size_t data_dim = filter_shape_vec.size() - 2;
-  std::vector<int64_t> col_shape_vec(1 + 2 * data_dim);
-  col_shape_vec[0] = input->dims()[1] / groups;
-  for (size_t j = 0; j < data_dim; ++j) {
-    col_shape_vec[j + 1] = filter_shape_vec[j + 2];
-    col_shape_vec[j + 1 + data_dim] = output_shape_vec[j + 2];
-  }
-  framework::DDim col_shape(framework::make_ddim(col_shape_vec));
-
-  framework::DDim col_matrix_shape =
-      framework::flatten_to_2d(col_shape, data_dim + 1);
-
-  bool is_expand =
-      math::IsExpand(filter_shape_vec, strides, paddings, dilations);
-  Tensor col;
-  Tensor col_matrix;
-  if (is_expand) {
-    col.mutable_data<float>(col_shape);
-    col_matrix.ShareDataWith(col);
-    col_matrix.Resize(col_matrix_shape);
-  }
-
-  framework::DDim input_shape = framework::slice_ddim(
-      input->dims(), 1, static_cast<int>(input->dims().size()));
-
-  framework::DDim filter_matrix_shape = {filter.dims()[0],
-                                         filter.numel() / filter.dims()[0]};
-  filter.Resize(filter_matrix_shape);
-  framework::DDim output_matrix_shape = {
-      output->dims()[1],
-      output->numel() / (output->dims()[0] * output->dims()[1])};
-
-  // convolution operator: im2col(or vol2col) + gemm
-  int in_step = static_cast<int>(input->dims()[1]) / groups;
-  int out_step = static_cast<int>(output->dims()[1]) / groups;
-
-  math::Vol2ColFunctor<CPU, float> vol2col;
-  math::Im2ColFunctor<math::ColFormat::kCFO, CPU, float> im2col;
-
-  for (int i = 0; i < batch_size; i++) {
-    Tensor in_batch = input->Slice(i, i + 1).Resize(input_shape);
-    Tensor out_batch = output->Slice(i, i + 1).Resize(output_matrix_shape);
-    Tensor bias1_batch = bias1.Slice(i, i + 1).Resize(output_matrix_shape);
-    for (int g = 0; g < groups; g++) {
-      Tensor in_slice = in_batch.Slice(g * in_step, (g + 1) * in_step);
-
-      if (!is_expand) {
-        col.ShareDataWith(in_slice);
-        col_matrix.ShareDataWith(col);
-        col_matrix.Resize(col_matrix_shape);
-      } else if (data_dim == 2U) {
-        // im2col
-        im2col(in_slice, dilations, strides,
-               std::vector<int>{paddings[0], paddings[1], paddings[0],
-                                paddings[1]},
-               &col);
-      } else if (data_dim == 3U) {
-        // vol2col
-        vol2col(in_slice, dilations, strides, paddings, &col);
-      }
-
-      // gemm
-      Tensor out_slice = out_batch.Slice(g * out_step, (g + 1) * out_step);
-      Tensor filter_slice = filter.Slice(g * out_step, (g + 1) * out_step);
-      Tensor bias1_slice = bias1_batch.Slice(g * out_step, (g + 1) * out_step);
-      float *biase_data1 = bias1_slice.data<float>();
-      math::MatMulWithPRelu(filter_slice, false, col_matrix, false, &out_slice,
-                            p, mode, biase_data, biase_data1);
-    }
-  }
+  const int image_size = output->numel() / output->dims()[0];
+  const int size = image_size / output->dims()[1];
+  const float *bias = param.Bias()->data<float>();
+  const float *residual = param.Bias1()->data<float>();
+  const math::epilogue::PRelu prelu =
+      math::MakePRelu(param.InputAlpha()->data<float>(), param.Mode(), size);
+  FloatConv(param, [&](int i) {
+    return math::MakeEpilogue(
+        math::epilogue::RowBias{bias},
+        math::epilogue::Residual{residual + i * image_size, size}, prelu);
+  });
 }
 
 }  // namespace operators
@@ -15,108 +15,59 @@ limitations under the License. */
 #ifdef FUSION_CONVADD_OP
 #pragma once
 
+#include <type_traits>
 #include <vector>
+#include "operators/kernel/central-arm-func/conv_arm_func.h"
 #include "operators/math/conv_func.h"
 #include "operators/math/depthwise_conv3x3.h"
-#include "operators/math/im2col.h"
+#include "operators/math/gemm_epilogue.h"
 #include "operators/math/math_function.h"
-#include "operators/math/vol2col.h"
 #include "operators/op_param.h"
 
 namespace paddle_mobile {
 namespace operators {
 
-void ConvAddBasic(const FusionConvAddParam<CPU> &param) {
-  const Tensor *input = param.Input();
-  Tensor filter = *param.Filter();
-  Tensor bias = *param.Bias();
+// 对已加上偏置的输出原地加上残差并应用激活, 输出按 [N * C, H * W] 看待
+template <typename Act>
+void ConvAddPostProcess(const FusionConvAddParam<CPU> &param, const Act &act) {
   Tensor *output = param.Output();
-  output->mutable_data<float>();
-  float *biase_data = bias.data<float>();
-
-  int axis = param.Axis();
-  int groups = param.Groups();
-  std::vector<int> strides = param.Strides();
-  std::vector<int> paddings = param.Paddings();
-  std::vector<int> dilations = param.Dilations();
-
-  const int batch_size = static_cast<int>(input->dims()[0]);
-
-  std::vector<int64_t> filter_shape_vec(framework::vectorize(filter.dims()));
-
-  std::vector<int64_t> output_shape_vec(framework::vectorize(output->dims()));
-  size_t data_dim = filter_shape_vec.size() - 2;
-  std::vector<int64_t> col_shape_vec(1 + 2 * data_dim);
-  col_shape_vec[0] = input->dims()[1] / groups;
-  for (size_t j = 0; j < data_dim; ++j) {
-    col_shape_vec[j + 1] = filter_shape_vec[j + 2];
-    col_shape_vec[j + 1 + data_dim] = output_shape_vec[j + 2];
+  const int rows = output->dims()[0] * output->dims()[1];
+  const int cols = output->numel() / rows;
+  const Tensor *residual = param.ResidualData();
+  if (residual != nullptr) {
+    math::ApplyEpilogue(
+        rows, cols, output,
+        math::MakeEpilogue(
+            math::epilogue::Residual{residual->data<float>(), cols}, act));
+  } else if (!std::is_same<Act, math::epilogue::Activation<IDENTITY>>::value) {
+    math::ApplyEpilogue(rows, cols, output, math::MakeEpilogue(act));
   }
-  framework::DDim col_shape(framework::make_ddim(col_shape_vec));
-
-  framework::DDim col_matrix_shape =
-      framework::flatten_to_2d(col_shape, data_dim + 1);
-
-  bool is_expand =
-      math::IsExpand(filter_shape_vec, strides, paddings, dilations);
-  Tensor col;
-  Tensor col_matrix;
-  if (is_expand) {
-    col.mutable_data<float>(col_shape);
-    col_matrix.ShareDataWith(col);
-    col_matrix.Resize(col_matrix_shape);
-  }
-
-  framework::DDim input_shape = framework::slice_ddim(
-      input->dims(), 1, static_cast<int>(input->dims().size()));
-
-  framework::DDim filter_matrix_shape = {filter.dims()[0],
-                                         filter.numel() / filter.dims()[0]};
-  filter.Resize(filter_matrix_shape);
-  framework::DDim output_matrix_shape = {
-      output->dims()[1],
-      output->numel() / (output->dims()[0] * output->dims()[1])};
-
-  // convolution operator: im2col(or vol2col) + gemm
-  int in_step = static_cast<int>(input->dims()[1]) / groups;
-  int out_step = static_cast<int>(output->dims()[1]) / groups;
-
-  math::Vol2ColFunctor<CPU, float> vol2col;
-  math::Im2ColFunctor<math::ColFormat::kCFO, CPU, float> im2col;
-
-  for (int i = 0; i < batch_size; i++) {
-    Tensor in_batch = input->Slice(i, i + 1).Resize(input_shape);
-    Tensor out_batch = output->Slice(i, i + 1).Resize(output_matrix_shape);
-
-    for (int g = 0; g < groups; g++) {
-      Tensor in_slice = in_batch.Slice(g * in_step, (g + 1) * in_step);
+}
 
-      if (!is_expand) {
-        col.ShareDataWith(in_slice);
-        col_matrix.ShareDataWith(col);
-        col_matrix.Resize(col_matrix_shape);
-      } else if (data_dim == 2U) {
-        // im2col
-        im2col(in_slice, dilations, strides,
-               std::vector<int>{paddings[0], paddings[1], paddings[0],
-                                paddings[1]},
-               &col);
-      } else if (data_dim == 3U) {
-        // vol2col
-        vol2col(in_slice, dilations, strides, paddings, &col);
-      }
-      // gemm
-      Tensor out_slice = out_batch.Slice(g * out_step, (g + 1) * out_step);
-      Tensor filter_slice = filter.Slice(g * out_step, (g + 1) * out_step);
-      math::MatMul<float, float>(filter_slice, false, col_matrix, false,
-                                 static_cast<float>(1), &out_slice,
-                                 static_cast<float>(1), false, biase_data);
-    }
+// 按执行模式计算卷积, 依次加上偏置和残差, 再应用激活
+template <typename Act>
+void ConvAddBasic(const FusionConvAddParam<CPU> &param, const Act &act) {
+  const Tensor *output = param.Output();
+  const float *bias = param.Bias()->data<float>();
+  const Tensor *residual = param.ResidualData();
+  if (residual == nullptr) {
+    FloatConv(param, [&](int i) {
+      return math::MakeEpilogue(math::epilogue::RowBias{bias}, act);
+    });
+    return;
   }
+  const int image_size = output->numel() / output->dims()[0];
+  const int size = image_size / output->dims()[1];
+  const float *residual_data = residual->data<float>();
+  FloatConv(param, [&](int i) {
+    return math::MakeEpilogue(
+        math::epilogue::RowBias{bias},
+        math::epilogue::Residual{residual_data + i * image_size, size}, act);
+  });
 }
 
-template <typename P>
-void ConvAddCompute(const FusionConvAddParam<CPU> &param) {
+template <typename Act>
+void ConvAddCompute(const FusionConvAddParam<CPU> &param, const Act &act) {
   param.Output()->mutable_data<float>();
   if (param.Groups() == param.Input()->dims()[1] &&
       param.Input()->dims()[1] == param.Output()->dims()[1] &&
@@ -125,6 +76,7 @@ void ConvAddCompute(const FusionConvAddParam<CPU> &param) {
       param.paddings_[0] == 1) {
     math::DepthwiseConv3x3s1p1(param.Input(), param.Filter(), param.Output(),
                                param.Bias(), true, false);
+    ConvAddPostProcess(param, act);
   } else if (param.Groups() == param.Input()->dims()[1] &&
              param.Input()->dims()[1] == param.Output()->dims()[1] &&
              param.Filter()->dims()[2] == param.Filter()->dims()[3] &&
@@ -140,8 +92,37 @@ void ConvAddCompute(const FusionConvAddParam<CPU> &param) {
       math::DepthwiseConv3x3s2p1v2(param.Input(), param.Filter(),
                                    param.Output(), param.Bias(), true, false);
     }
+    ConvAddPostProcess(param, act);
   } else {
-    ConvAddBasic(param);
+    ConvAddBasic(param, act);
+  }
+}
+
+template <typename P>
+void ConvAddCompute(const FusionConvAddParam<CPU> &param) {
+  switch (math::GetActivationType(param.FuseActivation())) {
+    case RELU:
+      ConvAddCompute(param, math::epilogue::Activation<RELU>{});
+      break;
+    case RELU6:
+      ConvAddCompute(param, math::epilogue::Activation<RELU6>{});
+      break;
+    case LEAKY_RELU:
+      ConvAddCompute(param,
+                     math::epilogue::Activation<LEAKY_RELU>{param.FuseAlpha()});
+      break;
+    case SIGMOID:
+      ConvAddCompute(param, math::epilogue::Activation<SIGMOID>{});
+      break;
+    case TANH:
+      ConvAddCompute(param, math::epilogue::Activation<TANH>{});
+      break;
+    case HARD_SWISH:
+      ConvAddCompute(param, math::epilogue::Activation<HARD_SWISH>{});
+      break;
+    default:
+      ConvAddCompute(param, math::epilogue::Activation<IDENTITY>{});
+      break;
   }
 }
 
@@ -12,13 +12,22 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
-#ifdef CONV_OP
-
 #pragma once
+
+#include <algorithm>
+#include <string>
+#include <type_traits>
 #include <vector>
+#include "common/common.h"
+#include "common/threadpool.h"
+#include "framework/workspace.h"
 #include "operators/math/conv_func.h"
+#include "operators/math/conv_tuner.h"
 #include "operators/math/depthwise_conv3x3.h"
 #include "operators/math/depthwise_conv5x5.h"
+#include "operators/math/gemm.h"
+#include "operators/math/gemm_epilogue.h"
+#include "operators/math/gemm_tuner.h"
 #include "operators/math/im2col.h"
 #include "operators/math/math_function.h"
 #include "operators/math/pad.h"
@@ -29,8 +38,50 @@ limitations under the License. */
 namespace paddle_mobile {
 namespace operators {
 
+// 一组卷积的 gemm, int8 输出时在 gemm 写回阶段重量化
 template <typename Itype, typename Otype>
-inline void GemmConv(const ConvParam<CPU> &param) {
+inline void GroupGemm(const Tensor &filter, const Tensor &col, Tensor *output,
+                      const math::RequantParam *requant) {
+  math::MatMul<Itype, Otype>(filter, false, col, false, static_cast<float>(1),
+                             output, static_cast<float>(0), false,
+                             static_cast<Otype *>(nullptr));
+}
+
+template <>
+inline void GroupGemm<int8_t, int8_t>(const Tensor &filter, const Tensor &col,
+                                      Tensor *output,
+                                      const math::RequantParam *requant) {
+  math::MatMulWithRequant(filter, col, output, *requant);
+}
+
+// 浮点卷积的 epilogue_of(i) 返回第 i 张图片的输出按 [C, H * W] 看待时的
+// epilogue, 融合的卷积由此在写回时加上偏置, batch norm, 残差和激活
+struct NoEpilogue {
+  math::Epilogue<> operator()(int i) const { return math::MakeEpilogue(); }
+};
+
+// 对不在 gemm 写回阶段完成后处理的算法, 计算后逐张图片原地应用 epilogue
+template <typename EpilogueOf>
+inline void ApplyImageEpilogues(const ConvParam<CPU> &param,
+                                const EpilogueOf &epilogue_of) {
+  Tensor *output = param.Output();
+  const int batch_size = output->dims()[0];
+  const int channels = output->dims()[1];
+  const int size = output->numel() / (batch_size * channels);
+  for (int i = 0; i < batch_size; ++i) {
+    Tensor out_batch = output->Slice(i, i + 1);
+    math::ApplyEpilogue(channels, size, &out_batch, epilogue_of(i));
+  }
+}
+
+inline void ApplyImageEpilogues(const ConvParam<CPU> &param,
+                                const NoEpilogue &epilogue_of) {}
+
+// 权重预打包时 epilogue 在 gemm 写回时应用, 浮点卷积的 gemm 总是预打包的
+template <typename Itype, typename Otype, typename EpilogueOf = NoEpilogue>
+inline void GemmConv(const ConvParam<CPU> &param,
+                     const math::RequantParam *requant = nullptr,
+                     const EpilogueOf &epilogue_of = EpilogueOf()) {
   const Tensor *input = param.Input();
   Tensor filter = *param.Filter();
   Tensor *output = param.Output();
@@ -56,13 +107,6 @@ inline void GemmConv(const ConvParam<CPU> &param) {
 
   bool is_expand =
       math::IsExpand(filter_shape_vec, strides, paddings, dilations);
-  Tensor col;
-  Tensor col_matrix;
-  if (is_expand) {
-    col.mutable_data<Itype>(col_shape);
-    col_matrix.ShareDataWith(col);
-    col_matrix.Resize(col_matrix_shape);
-  }
 
   framework::DDim input_shape = framework::slice_ddim(
       input->dims(), 1, static_cast<int>(input->dims().size()));
@@ -82,7 +126,31 @@ inline void GemmConv(const ConvParam<CPU> &param) {
   math::Im2ColFunctor<math::ColFormat::kCFO, CPU, Itype> im2col;
 
   const int batch_size = static_cast<int>(input->dims()[0]);
-  for (int i = 0; i < batch_size; i++) {
+  // 按图片并行时每个线程使用自己的 col 和 gemm workspace
+  const bool batch_parallel =
+      math::ParallelOverBatch(batch_size, output_matrix_shape[1]);
+  const int threads =
+      batch_parallel ? ThreadPool::Instance()->ThreadNum() : 1;
+  framework::WorkspaceScope scratch;
+  std::vector<Tensor> cols(threads);
+  if (is_expand) {
+    for (auto &col : cols) {
+      col = scratch.NewTensor<Itype>(col_shape);
+    }
+  }
+  if (batch_parallel && param.thread_workspaces_.size() < threads) {
+    param.thread_workspaces_.resize(threads);
+  }
+
+  auto conv_image = [&](int i, int tid) {
+    Tensor &col = cols[tid];
+    Tensor col_matrix;
+    if (is_expand) {
+      col_matrix.ShareDataWith(col);
+      col_matrix.Resize(col_matrix_shape);
+    }
+    Tensor *workspace = batch_parallel ? &param.thread_workspaces_[tid]
+                                       : &param.gemm_workspace_;
     Tensor in_batch = input->Slice(i, i + 1).Resize(input_shape);
     Tensor out_batch = output->Slice(i, i + 1).Resize(output_matrix_shape);
 
@@ -106,19 +174,103 @@ inline void GemmConv(const ConvParam<CPU> &param) {
 
       // gemm
       Tensor out_slice = out_batch.Slice(g * out_step, (g + 1) * out_step);
+      if (param.packed_filter_.IsInitialized()) {
+        math::MatMulPackedA(param.packed_filter_.Slice(g, g + 1), col_matrix,
+                            &out_slice, epilogue_of(i).Offset(g * out_step, 0),
+                            workspace);
+        continue;
+      }
       Tensor filter_slice = filter.Slice(g * out_step, (g + 1) * out_step);
-      math::MatMul<Itype, Otype>(filter_slice, false, col_matrix, false,
-                                 static_cast<float>(1), &out_slice,
-                                 static_cast<float>(0), false,
-                                 static_cast<Otype *>(nullptr));
+      if (requant != nullptr) {
+        // 第 g 组使用对应输出通道的 scale 和 bias
+        math::RequantParam group_requant = *requant;
+        group_requant.scale += g * out_step;
+        group_requant.bias += g * out_step;
+        GroupGemm<Itype, Otype>(filter_slice, col_matrix, &out_slice,
+                                &group_requant);
+      } else {
+        GroupGemm<Itype, Otype>(filter_slice, col_matrix, &out_slice, nullptr);
+      }
+    }
+  };
+
+  if (batch_parallel) {
+    parallel_for_tid(0, batch_size, conv_image);
+  } else {
+    for (int i = 0; i < batch_size; i++) {
+      conv_image(i, 0);
+    }
+  }
+}
+
+// 隐式 gemm 卷积: 权重已由 PackConvFilter 预打包, gemm 打包 B 时直接从输入
+// 图片读取, 不生成 col 矩阵. 与 GemmConv 相同, epilogue 在 gemm 写回时应用
+template <typename EpilogueOf = NoEpilogue>
+inline void ImplicitGemmConv(const ConvParam<CPU> &param,
+                             const EpilogueOf &epilogue_of = EpilogueOf()) {
+  const Tensor *input = param.Input();
+  Tensor *output = param.Output();
+  output->mutable_data<float>();
+  const Tensor &filter = *param.Filter();
+  int groups = param.Groups();
+  int batch_size = input->dims()[0];
+  int in_step = input->dims()[1] / groups;
+  int out_step = output->dims()[1] / groups;
+  int k = filter.numel() / filter.dims()[0];
+
+  math::Im2ColGeometry geo;
+  geo.height = input->dims()[2];
+  geo.width = input->dims()[3];
+  geo.kernel_h = filter.dims()[2];
+  geo.kernel_w = filter.dims()[3];
+  geo.stride_h = param.Strides()[0];
+  geo.stride_w = param.Strides()[1];
+  geo.pad_h = param.Paddings()[0];
+  geo.pad_w = param.Paddings()[1];
+  geo.dilation_h = param.Dilations()[0];
+  geo.dilation_w = param.Dilations()[1];
+  geo.output_w = output->dims()[3];
+
+  int in_size = geo.height * geo.width;
+  int out_size = output->dims()[2] * output->dims()[3];
+  framework::DDim output_matrix_shape = {output->dims()[1], out_size};
+  const bool batch_parallel = math::ParallelOverBatch(batch_size, out_size);
+  const int threads =
+      batch_parallel ? ThreadPool::Instance()->ThreadNum() : 1;
+  if (batch_parallel && param.thread_workspaces_.size() < threads) {
+    param.thread_workspaces_.resize(threads);
+  }
+
+  auto conv_image = [&](int i, int tid) {
+    Tensor *workspace = batch_parallel ? &param.thread_workspaces_[tid]
+                                       : &param.gemm_workspace_;
+    Tensor out_batch = output->Slice(i, i + 1).Resize(output_matrix_shape);
+    math::Im2ColGeometry image_geo = geo;
+    for (int g = 0; g < groups; g++) {
+      image_geo.input = input->data<float>() +
+                        (i * input->dims()[1] + g * in_step) * in_size;
+      Tensor out_slice = out_batch.Slice(g * out_step, (g + 1) * out_step);
+      math::MatMulPackedAIm2Col(param.packed_filter_.Slice(g, g + 1),
+                                image_geo, k, &out_slice,
+                                epilogue_of(i).Offset(g * out_step, 0),
+                                workspace);
+    }
+  };
+
+  if (batch_parallel) {
+    parallel_for_tid(0, batch_size, conv_image);
+  } else {
+    for (int i = 0; i < batch_size; i++) {
+      conv_image(i, 0);
     }
   }
 }
 
-template <int tile, int kernel>
-inline void WinogradConv3x3(const ConvParam<CPU> &param) {
+template <int tile, int kernel, typename EpilogueOf = NoEpilogue>
+inline void WinogradConv(const ConvParam<CPU> &param,
+                         const EpilogueOf &epilogue_of = EpilogueOf()) {
   const Tensor *input = param.Input();
-  const Tensor *filter = param.transformed_filter_;
+  const Tensor *filter = &param.transformed_filter_;
   Tensor *output = param.Output();
   output->mutable_data<float>();
   int batch_size = input->dims()[0];
@@ -134,9 +286,30 @@ inline void WinogradConv3x3(const ConvParam<CPU> &param) {
   };
 
   math::PadFunctor<CPU, float> pad;
-  Tensor input_pad;
-  framework::Tensor transformed_input;
-  for (int i = 0; i < batch_size; ++i) {
+  const bool batch_parallel = math::ParallelOverBatch(
+      batch_size, output->numel() / (batch_size * output->dims()[1]));
+  const int threads =
+      batch_parallel ? ThreadPool::Instance()->ThreadNum() : 1;
+  // 每个线程的 pad 和变换后的输入预留在 workspace 上
+  framework::WorkspaceScope scratch;
+  std::vector<Tensor> input_pads(threads);
+  std::vector<Tensor> transformed_inputs(threads);
+  framework::DDim pad_shape = input->dims();
+  pad_shape[0] = 1;
+  pad_shape[2] += 2 * paddings[0];
+  pad_shape[3] += 2 * paddings[1];
+  for (int t = 0; t < threads; ++t) {
+    if (paddings[0] || paddings[1]) {
+      input_pads[t] = scratch.Reserve(product(pad_shape) * sizeof(float));
+    }
+    transformed_inputs[t] = scratch.Reserve(
+        math::winograd_transformed_input_size<tile, kernel>(pad_shape) *
+        sizeof(float));
+  }
+
+  auto conv_image = [&](int i, int tid) {
+    Tensor &input_pad = input_pads[tid];
+    Tensor &transformed_input = transformed_inputs[tid];
     Tensor in_batch = input->Slice(i, i + 1);
     Tensor out_batch = output->Slice(i, i + 1);
     // int pad_bottom = winograd_pad(in_batch.dims()[2], paddings[0]);
@@ -157,11 +330,45 @@ inline void WinogradConv3x3(const ConvParam<CPU> &param) {
     math::winograd_transform_input<tile, kernel>(input_pad, &transformed_input);
     // caculate output
     math::winograd_transform_output<tile, kernel>(transformed_input, *filter,
-                                                  output);
+                                                  &out_batch);
+    // 输出仍在缓存中时应用融合的后处理, 按图片并行时不再分行并行
+    if (!std::is_same<EpilogueOf, NoEpilogue>::value) {
+      int channels = out_batch.dims()[1];
+      int size = out_batch.numel() / channels;
+      if (batch_parallel) {
+        float *out_data = out_batch.data<float>();
+        math::WriteWithEpilogue(channels, size, out_data, size, out_data, size,
+                                epilogue_of(i));
+      } else {
+        math::ApplyEpilogue(channels, size, &out_batch, epilogue_of(i));
+      }
+    }
+  };
+
+  if (batch_parallel) {
+    parallel_for_tid(0, batch_size, conv_image);
+  } else {
+    for (int i = 0; i < batch_size; ++i) {
+      conv_image(i, 0);
+    }
   }
 }
 
 #ifndef __aarch64__
+// 逐张图片调用 func(i), 按图片并行时每张图片内部不再并行
+template <typename F>
+inline void DepthwiseForEachImage(int batch_size, const Tensor &output,
+                                  const F &func) {
+  if (math::ParallelOverBatch(
+          batch_size, output.numel() / (batch_size * output.dims()[1]))) {
+    parallel_for(0, batch_size, func);
+  } else {
+    for (int i = 0; i < batch_size; i++) {
+      func(i);
+    }
+  }
+}
+
 template <typename Itype, typename Otype>
 inline void DepthwiseConv3x3(const ConvParam<CPU> &param) {
   const Tensor *input = param.Input();
@@ -172,19 +379,22 @@ inline void DepthwiseConv3x3(const ConvParam<CPU> &param) {
   Tensor *output = param.Output();
   output->mutable_data<Otype>();
 
-  for (int i = 0; i < batch_size; i++) {
+  if (strides[0] != 1 && strides[0] != 2) {
+    GemmConv<Itype, Otype>(param);
+    return;
+  }
+  auto conv_image = [&](int i) {
     Tensor in_batch = input->Slice(i, i + 1);
     Tensor out_batch = output->Slice(i, i + 1);
     if (strides[0] == 1) {
       math::DepthwiseConv3x3S1<Itype, Otype>(in_batch, *filter, paddings,
                                              &out_batch);
-    } else if (strides[0] == 2) {
+    } else {
       math::DepthwiseConv3x3S2<Itype, Otype>(in_batch, *filter, paddings,
                                              &out_batch);
-    } else {
-      GemmConv<Itype, Otype>(param);
     }
-  }
+  };
+  DepthwiseForEachImage(batch_size, *output, conv_image);
 }
 
 template <typename Itype, typename Otype>
@@ -198,19 +408,326 @@ inline void DepthwiseConv5x5(const ConvParam<CPU> &param) {
   output->mutable_data<Otype>();
 
   if (strides[0] == 1) {
-    for (int i = 0; i < batch_size; i++) {
+    DepthwiseForEachImage(batch_size, *output, [&](int i) {
       Tensor in_batch = input->Slice(i, i + 1);
       Tensor out_batch = output->Slice(i, i + 1);
       math::DepthwiseConv5x5S1<Itype, Otype>(in_batch, *filter, paddings,
                                              &out_batch);
-    }
+    });
   } else {
     GemmConv<Itype, Otype>(param);
   }
 }
 #endif  // __aarch64__
 
+typedef enum ConvParam<CPU>::ExecMode ConvExecMode;
+
+// the float convolution algorithms that are valid for the shape of param
+inline std::vector<ConvExecMode> FloatConvModes(const ConvParam<CPU> &param) {
+  const Tensor *filter = param.Filter();
+  bool conv3x3 =
+      filter->dims()[2] == filter->dims()[3] && filter->dims()[2] == 3;
+  bool conv5x5 =
+      filter->dims()[2] == filter->dims()[3] && filter->dims()[2] == 5;
+  bool depthwise = param.Groups() == param.Input()->dims()[1] &&
+                   param.Input()->dims()[1] == param.Output()->dims()[1];
+  bool square = param.Strides()[0] == param.Strides()[1] &&
+                param.Paddings()[0] == param.Paddings()[1] &&
+                param.Dilations()[0] == param.Dilations()[1];
+  int stride = param.Strides()[0];
+  int padding = param.Paddings()[0];
+  bool dilated = param.Dilations()[0] != 1 || param.Dilations()[1] != 1;
+
+  std::vector<ConvExecMode> modes;
+  if (conv3x3 && depthwise && !dilated) {
+    if (square && stride == 1 && padding == 1) {
+      modes.push_back(ConvParam<CPU>::EXEC_DEPTHWISE3x3S1P1_FLOAT);
+    }
+    if (square && stride == 2 && padding == 0) {
+      modes.push_back(ConvParam<CPU>::EXEC_DEPTHWISE3x3S2P0_FLOAT);
+    }
+    if (square && stride == 2 && padding == 1) {
+      modes.push_back(ConvParam<CPU>::EXEC_DEPTHWISE3x3S2P1_FLOAT);
+    }
+    modes.push_back(ConvParam<CPU>::EXEC_DEPTHWISE3x3_FLOAT);
+  }
+#if defined(__ARM_NEON__) && !defined(__aarch64__)
+  if (conv5x5 && depthwise && !dilated && square && stride == 1) {
+    modes.push_back(ConvParam<CPU>::EXEC_DEPTHWISE5x5_FLOAT);
+  }
+#endif  // __ARM_NEON__
+  bool winograd = param.Groups() == 1 && !dilated && square && stride == 1;
+  if (conv3x3 && winograd) {
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+    modes.push_back(ConvParam<CPU>::EXEC_WINOGRAD3X3_FLOAT);
+#endif  // __ARM_NEON__
+    modes.push_back(ConvParam<CPU>::EXEC_WINOGRAD3X3_F4_FLOAT);
+    modes.push_back(ConvParam<CPU>::EXEC_WINOGRAD3X3_F2_FLOAT);
+  }
+  if (conv5x5 && winograd) {
+    modes.push_back(ConvParam<CPU>::EXEC_WINOGRAD5X5_FLOAT);
+  }
+  // the implicit gemm packs the input directly instead of an im2col buffer,
+  // a 1x1 conv of stride 1 reads its input as the matrix anyway
+  if (filter->dims().size() == 4 &&
+      math::IsExpand(framework::vectorize(filter->dims()), param.Strides(),
+                     param.Paddings(), param.Dilations())) {
+    modes.push_back(ConvParam<CPU>::EXEC_GEMM_IMPLICIT_FLOAT);
+  }
+  modes.push_back(ConvParam<CPU>::EXEC_GEMM_FLOAT);
+  return modes;
+}
+
+// the algorithms that run on the filter transformed into transformed_filter_
+inline bool IsWinograd(ConvExecMode mode) {
+  return mode == ConvParam<CPU>::EXEC_WINOGRAD3X3_FLOAT ||
+         mode == ConvParam<CPU>::EXEC_WINOGRAD3X3_F2_FLOAT ||
+         mode == ConvParam<CPU>::EXEC_WINOGRAD3X3_F4_FLOAT ||
+         mode == ConvParam<CPU>::EXEC_WINOGRAD5X5_FLOAT;
+}
+
+// the float convolution algorithm picked by fixed rules
+inline ConvExecMode DefaultFloatConvMode(const ConvParam<CPU> &param) {
+  std::vector<ConvExecMode> modes = FloatConvModes(param);
+  int channels = std::min(param.Input()->dims()[1], param.Output()->dims()[1]);
+  int height = param.Input()->dims()[2];
+  int width = param.Input()->dims()[3];
+  for (auto mode : modes) {
+    switch (mode) {
+      case ConvParam<CPU>::EXEC_WINOGRAD3X3_FLOAT:
+#ifdef __aarch64__
+        // the arm64 F(6,3) multiplies the tiles in plain C, it is left to
+        // the tuner
+        continue;
+#else
+        if (channels < 16 || height > 140 /* refered from ncnn */) {
+          continue;
+        }
+        break;
+#endif  // __aarch64__
+      case ConvParam<CPU>::EXEC_WINOGRAD3X3_F4_FLOAT:
+        // the portable transforms only pay off on wide convolutions, and the
+        // 6x6 tiles waste most of their work on small feature maps
+        if (channels < 64 || height < 8 || width < 8) {
+          continue;
+        }
+        break;
+      case ConvParam<CPU>::EXEC_WINOGRAD5X5_FLOAT:
+        if (channels < 64) {
+          continue;
+        }
+        break;
+      case ConvParam<CPU>::EXEC_WINOGRAD3X3_F2_FLOAT:
+        // F(2,3) rarely beats gemm, it is left to the tuner
+        continue;
+      default:
+        break;
+    }
+    return mode;
+  }
+  return ConvParam<CPU>::EXEC_GEMM_FLOAT;
+}
+
+// transforms or packs the filter for the algorithm of param
+inline void PrepareFloatConv(ConvParam<CPU> *param) {
+  if (IsWinograd(param->ExecMode()) &&
+      param->transformed_filter_.IsInitialized()) {
+    // restored by a model cache or shared with the cloned instance
+    return;
+  }
+  switch (param->ExecMode()) {
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+    case ConvParam<CPU>::EXEC_WINOGRAD3X3_FLOAT:
+      math::winograd_transform_weight<8, 3>(*param->Filter(),
+                                            &param->transformed_filter_);
+      break;
+#endif  // __ARM_NEON__
+    case ConvParam<CPU>::EXEC_WINOGRAD3X3_F2_FLOAT:
+      math::winograd_transform_weight<4, 3>(*param->Filter(),
+                                            &param->transformed_filter_);
+      break;
+    case ConvParam<CPU>::EXEC_WINOGRAD3X3_F4_FLOAT:
+      math::winograd_transform_weight<6, 3>(*param->Filter(),
+                                            &param->transformed_filter_);
+      break;
+    case ConvParam<CPU>::EXEC_WINOGRAD5X5_FLOAT:
+      math::winograd_transform_weight<6, 5>(*param->Filter(),
+                                            &param->transformed_filter_);
+      break;
+    case ConvParam<CPU>::EXEC_GEMM_FLOAT:
+    case ConvParam<CPU>::EXEC_GEMM_IMPLICIT_FLOAT:
+      math::PackConvFilter(*param->Filter(), param->Groups(),
+                           &param->packed_filter_);
+      break;
+    default:
+      break;
+  }
+}
+
+// the conv shape and thread count the tuned algorithm is kept for
+inline std::vector<int> ConvTuningKey(const ConvParam<CPU> &param) {
+  std::vector<int> key{ThreadPool::Instance()->ThreadNum(), param.Groups()};
+  for (int i = 0; i < param.Input()->dims().size(); ++i) {
+    key.push_back(static_cast<int>(param.Input()->dims()[i]));
+  }
+  for (int i = 0; i < param.Filter()->dims().size(); ++i) {
+    key.push_back(static_cast<int>(param.Filter()->dims()[i]));
+  }
+  key.insert(key.end(), param.Strides().begin(), param.Strides().end());
+  key.insert(key.end(), param.Paddings().begin(), param.Paddings().end());
+  key.insert(key.end(), param.Dilations().begin(), param.Dilations().end());
+  return key;
+}
+
+// 按 param 的执行模式计算浮点卷积, 卷积本身不做后处理的算法在计算后
+// 应用 epilogue_of
+template <typename EpilogueOf>
+inline void FloatConv(const ConvParam<CPU> &param,
+                      const EpilogueOf &epilogue_of) {
+  switch (param.ExecMode()) {
+    case ConvParam<CPU>::EXEC_DEPTHWISE3x3S1P1_FLOAT:
+      math::DepthwiseConv3x3s1p1(param.Input(), param.Filter(), param.Output(),
+                                 nullptr, false, false);
+      ApplyImageEpilogues(param, epilogue_of);
+      break;
+    case ConvParam<CPU>::EXEC_DEPTHWISE3x3S2P1_FLOAT:
+      math::DepthwiseConv3x3s2p1v2(param.Input(), param.Filter(),
+                                   param.Output(), nullptr, false, false);
+      ApplyImageEpilogues(param, epilogue_of);
+      break;
+    case ConvParam<CPU>::EXEC_DEPTHWISE3x3S2P0_FLOAT:
+      math::DepthwiseConv3x3s2p0(param.Input(), param.Filter(), param.Output(),
+                                 nullptr, false, false);
+      ApplyImageEpilogues(param, epilogue_of);
+      break;
+    case ConvParam<CPU>::EXEC_DEPTHWISE3x3_FLOAT:
+      math::DepthwiseConv3x3(param.Input(), param.Strides(), param.Paddings(),
+                             param.Filter(), nullptr, param.Output(), false);
+      ApplyImageEpilogues(param, epilogue_of);
+      break;
+#ifndef __aarch64__
+    case ConvParam<CPU>::EXEC_DEPTHWISE5x5_FLOAT:
+      DepthwiseConv5x5<float, float>(param);
+      ApplyImageEpilogues(param, epilogue_of);
+      break;
+#endif  // __aarch64__
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+    case ConvParam<CPU>::EXEC_WINOGRAD3X3_FLOAT:
+      WinogradConv<8, 3>(param, epilogue_of);
+      break;
+#endif  // __ARM_NEON__
+    case ConvParam<CPU>::EXEC_WINOGRAD3X3_F2_FLOAT:
+      WinogradConv<4, 3>(param, epilogue_of);
+      break;
+    case ConvParam<CPU>::EXEC_WINOGRAD3X3_F4_FLOAT:
+      WinogradConv<6, 3>(param, epilogue_of);
+      break;
+    case ConvParam<CPU>::EXEC_WINOGRAD5X5_FLOAT:
+      WinogradConv<6, 5>(param, epilogue_of);
+      break;
+    case ConvParam<CPU>::EXEC_GEMM_FLOAT:
+      GemmConv<float, float>(param, nullptr, epilogue_of);
+      break;
+    case ConvParam<CPU>::EXEC_GEMM_IMPLICIT_FLOAT:
+      ImplicitGemmConv(param, epilogue_of);
+      break;
+    default:
+      PADDLE_MOBILE_THROW_EXCEPTION("Invalid convolution execute mode %d",
+                                    param.ExecMode());
+  }
+}
+
+// times the valid algorithms on the shape of param and returns the fastest,
+// the result is recorded by ConvTuner so that it is timed once per shape.
+// A fused conv is timed without its epilogue, which costs about the same
+// whatever the algorithm.
+inline ConvExecMode TuneFloatConv(const ConvParam<CPU> &param) {
+  for (int i = 0; i < param.Input()->dims().size(); ++i) {
+    if (param.Input()->dims()[i] <= 0) {
+      // the shape is not known until the input is fed
+      return DefaultFloatConvMode(param);
+    }
+  }
+  std::vector<ConvExecMode> modes = FloatConvModes(param);
+  std::vector<int> key = ConvTuningKey(param);
+  std::string recorded = math::ConvTuner::Instance()->Algorithm(key);
+  ConvParam<CPU> trial = param;
+  for (auto mode : modes) {
+    trial.ExecMode() = mode;
+    if (trial.ExecModeName() == recorded) {
+      return mode;
+    }
+  }
+
+  Tensor input, output;
+  float *input_data = input.mutable_data<float>(param.Input()->dims());
+  for (int i = 0; i < input.numel(); ++i) {
+    input_data[i] = static_cast<float>(i % 16) / 16;
+  }
+  output.Resize(param.Output()->dims());
+  trial.input_ = &input;
+  trial.output_ = &output;
+
+  static const int kTuneRepeats = 3;
+  auto best_mode = ConvParam<CPU>::EXEC_GEMM_FLOAT;
+  double best_time = -1;
+  for (auto mode : modes) {
+    trial.ExecMode() = mode;
+    trial.packed_filter_ = Tensor();
+    trial.transformed_filter_ = Tensor();
+    PrepareFloatConv(&trial);
+    double min_time = -1;
+    // the first run warms up caches and is not counted
+    for (int r = 0; r <= kTuneRepeats; ++r) {
+      auto t0 = paddle_mobile::time();
+      FloatConv(trial, NoEpilogue());
+      double cost = time_diff(t0, paddle_mobile::time());
+      if (r > 0 && (min_time < 0 || cost < min_time)) {
+        min_time = cost;
+      }
+    }
+    DLOG << "conv " << trial.ExecModeName() << " cost: " << min_time << "ms";
+    if (best_time < 0 || min_time < best_time) {
+      best_time = min_time;
+      best_mode = mode;
+    }
+  }
+  trial.ExecMode() = best_mode;
+  math::ConvTuner::Instance()->Record(key, trial.ExecModeName());
+  return best_mode;
+}
+
+// tunes the blocking of the gemm of one group at Init, the gemm of an input
+// shape that is not known until it is fed keeps the default blocking
+inline void TuneConvGemm(const ConvParam<CPU> &param) {
+  const framework::DDim &input_dims = param.Input()->dims();
+  for (int i = 0; i < input_dims.size(); ++i) {
+    if (input_dims[i] <= 0) {
+      return;
+    }
+  }
+  const framework::DDim &filter_dims = param.Filter()->dims();
+  const framework::DDim &output_dims = param.Output()->dims();
+  int m = filter_dims[0] / param.Groups();
+  int k = framework::product(filter_dims) / filter_dims[0];
+  int n = framework::product(
+      framework::slice_ddim(output_dims, 2, output_dims.size()));
+  math::GemmTuner::Instance()->Tune(m, n, k);
+}
+
+// picks the algorithm of a float conv, plain or fused, unless a model cache
+// restored it, and prepares the filter for it
+inline void InitFloatConv(ConvParam<CPU> *param) {
+  // before the algorithms are timed, so that the gemm ones run with the
+  // tuned blocking
+  TuneConvGemm(*param);
+  if (param->ExecMode() == ConvParam<CPU>::EXEC_INVALID) {
+    param->ExecMode() = math::ConvTuner::Instance()->Enabled()
+                            ? TuneFloatConv(*param)
+                            : DefaultFloatConvMode(*param);
+  }
+  PrepareFloatConv(param);
+}
+
 }  // namespace operators
 }  // namespace paddle_mobile
-
-#endif
@@ -18,6 +18,7 @@ limitations under the License. */
 
 #include <vector>
 #include "framework/ddim.h"
+#include "framework/workspace.h"
 #include "operators/math/im2col.h"
 #include "operators/math/math_function.h"
 #include "operators/math/vol2col.h"
@@ -61,8 +62,8 @@ void ConvTransposeCompute(const ConvTransposeParam<CPU> &param) {
   framework::DDim col_matrix_shape =
       framework::flatten_to_2d(col_shape, data_dim + 1);
 
-  Tensor col;
-  col.mutable_data<P>(col_shape);
+  framework::WorkspaceScope scratch;
+  Tensor col = scratch.NewTensor<P>(col_shape);
 
   Tensor col_matrix;
   col_matrix.ShareDataWith(col);
@@ -16,7 +16,10 @@ limitations under the License. */
 
 #pragma once
 
+#include "common/threadpool.h"
+#include "operators/math/blocked_layout.h"
 #include "operators/math/elementwise_op_function.h"
+#include "operators/math/math_func_avx.h"
 #include "operators/op_param.h"
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
 #include <arm_neon.h>
@@ -31,6 +34,17 @@ inline void ElementwiseAddCompute(const ElementwiseAddParam<CPU> &param) {
   const framework::Tensor *input_y = param.InputY();
   framework::Tensor *Out = param.Out();
   int axis = param.Axis();
+  if (framework::DataLayoutBlock(input_x->layout()) > 1) {
+    // a blocked x is added by a blocked y of the same dims or by a bias of
+    // every channel
+    if (input_y->dims() == input_x->dims()) {
+      math::AddBlocked(*input_x, *input_y, Out);
+    } else {
+      math::ScaleBiasBlocked(*input_x, nullptr, input_y->data<float>(), false,
+                             Out);
+    }
+    return;
+  }
 
   const auto &x_dims = input_x->dims();
   const auto &y_dims = input_y->dims();
@@ -52,75 +66,80 @@ inline void ElementwiseAddCompute(const ElementwiseAddParam<CPU> &param) {
   const float *input_data = input_x->data<float>();
   float *output_data = Out->mutable_data<float>();
 
-  #pragma omp parallel for collapse(2)
-  for (int i = 0; i < batch; ++i) {
-    for (int j = 0; j < channels; ++j) {
-      size_t offset = (i * channels + j) * elementwise_num;
-      const float *input = input_data + offset;
-      const float bias = bias_data[j];
-      float *output = output_data + offset;
+  parallel_for(0, batch * channels, [&](int index) {
+    int i = index / channels;
+    int j = index % channels;
+    size_t offset = (i * channels + j) * elementwise_num;
+    const float *input = input_data + offset;
+    const float bias = bias_data[j];
+    float *output = output_data + offset;
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
-      int loop = elementwise_num >> 0x4;
-      int remain = elementwise_num & 0xF;
-      float32x4_t rb = vdupq_n_f32(bias);
-      for (int k = 0; k < loop; ++k) {
-        float32x4_t r0 = vld1q_f32(input);
-        float32x4_t r1 = vld1q_f32(input + 4);
-        float32x4_t r2 = vld1q_f32(input + 8);
-        float32x4_t r3 = vld1q_f32(input + 12);
-        r0 = vaddq_f32(r0, rb);
-        r1 = vaddq_f32(r1, rb);
-        r2 = vaddq_f32(r2, rb);
-        r3 = vaddq_f32(r3, rb);
-        vst1q_f32(output, r0);
-        vst1q_f32(output + 4, r1);
-        vst1q_f32(output + 8, r2);
-        vst1q_f32(output + 12, r3);
-        input += 16;
-        output += 16;
-      }
-      if (remain >= 8) {
-        float32x4_t r0 = vld1q_f32(input);
-        float32x4_t r1 = vld1q_f32(input + 4);
-        r0 = vaddq_f32(r0, rb);
-        r1 = vaddq_f32(r1, rb);
-        vst1q_f32(output, r0);
-        vst1q_f32(output + 4, r1);
-        input += 8;
-        output += 8;
-        remain -= 8;
-      }
-      if (remain >= 4) {
-        float32x4_t r0 = vld1q_f32(input);
-        r0 = vaddq_f32(r0, rb);
-        vst1q_f32(output, r0);
-        input += 4;
-        output += 4;
-        remain -= 4;
-      }
-      if (remain > 0) {
-        float32x4_t r0 = vld1q_f32(input);
-        r0 = vaddq_f32(r0, rb);
-        switch (remain) {
-          case 1:
-            vst1q_lane_f32(output, r0, 0);
-            break;
-          case 2:
-            vst1_f32(output, vget_low_f32(r0));
-            break;
-          case 3:
-            vst1_f32(output, vget_low_f32(r0));
-            vst1q_lane_f32(output, r0, 2);
-            break;
-        }
+    int loop = elementwise_num >> 0x4;
+    int remain = elementwise_num & 0xF;
+    float32x4_t rb = vdupq_n_f32(bias);
+    for (int k = 0; k < loop; ++k) {
+      float32x4_t r0 = vld1q_f32(input);
+      float32x4_t r1 = vld1q_f32(input + 4);
+      float32x4_t r2 = vld1q_f32(input + 8);
+      float32x4_t r3 = vld1q_f32(input + 12);
+      r0 = vaddq_f32(r0, rb);
+      r1 = vaddq_f32(r1, rb);
+      r2 = vaddq_f32(r2, rb);
+      r3 = vaddq_f32(r3, rb);
+      vst1q_f32(output, r0);
+      vst1q_f32(output + 4, r1);
+      vst1q_f32(output + 8, r2);
+      vst1q_f32(output + 12, r3);
+      input += 16;
+      output += 16;
+    }
+    if (remain >= 8) {
+      float32x4_t r0 = vld1q_f32(input);
+      float32x4_t r1 = vld1q_f32(input + 4);
+      r0 = vaddq_f32(r0, rb);
+      r1 = vaddq_f32(r1, rb);
+      vst1q_f32(output, r0);
+      vst1q_f32(output + 4, r1);
+      input += 8;
+      output += 8;
+      remain -= 8;
+    }
+    if (remain >= 4) {
+      float32x4_t r0 = vld1q_f32(input);
+      r0 = vaddq_f32(r0, rb);
+      vst1q_f32(output, r0);
+      input += 4;
+      output += 4;
+      remain -= 4;
+    }
+    if (remain > 0) {
+      float32x4_t r0 = vld1q_f32(input);
+      r0 = vaddq_f32(r0, rb);
+      switch (remain) {
+        case 1:
+          vst1q_lane_f32(output, r0, 0);
+          break;
+        case 2:
+          vst1_f32(output, vget_low_f32(r0));
+          break;
+        case 3:
+          vst1_f32(output, vget_low_f32(r0));
+          vst1q_lane_f32(output, r0, 2);
+          break;
       }
+    }
 #else
-      for (int k = 0; k < elementwise_num; ++k) {
-        output[k] = input[k] + bias;
-      }
-#endif  // __ARM_NEON__
+#if defined(__x86_64__) || defined(__i386__)
+    if (math::HasAvx2()) {
+      math::ScaleBias256(input, 1.f, bias, output, elementwise_num);
+      return;
     }
-  }
+#endif  // __x86_64__
+    for (int k = 0; k < elementwise_num; ++k) {
+      output[k] = input[k] + bias;
+    }
+#endif  // __ARM_NEON__
+  });
 }
 
 template class ElementwiseAddKernel<CPU, float>;
@@ -17,6 +17,7 @@ limitations under the License. */
 #pragma once
 
 #include <type_traits>
+#include "operators/math/gemm_epilogue.h"
 #include "operators/math/math_function.h"
 #include "operators/op_param.h"
 
@@ -52,6 +53,21 @@ void FusionFcCompute(const FusionFcParam<CPU> &param) {
   axis = (axis == -1 ? out_dim.size() - input_z->dims().size() : axis);
   PADDLE_MOBILE_ENFORCE(axis == 1, " to fit broadcast, axis = 1. ");
 
+  bool packed = param.packed_weight_.IsInitialized();
+#ifndef __aarch64__
+  // 向量矩阵乘法直接读取 B, 不需要打包. 权重压缩或存为 half 时 B 已释放,
+  // 只能使用打包的
+  packed = packed &&
+           (out_dim[0] > 1 || !math::IsPackedFloat(param.packed_weight_));
+#endif  // __aarch64__
+  if (packed) {
+    // 偏置在 gemm 回写时按列加上
+    math::MatMulPackedB(
+        x_matrix, param.packed_weight_, out,
+        math::MakeEpilogue(math::epilogue::ColBias{input_z->data<float>()}),
+        &param.gemm_workspace_);
+    return;
+  }
   // bias_data的维度和out的第二个维度一致
   int64_t classes = input_z->numel();
   for (int i = 0; i < out_dim[0]; i++) {
@@ -17,6 +17,7 @@ limitations under the License. */
 
 #include <vector>
 #include "framework/ddim.h"
+#include "operators/math/half_convert.h"
 #include "operators/op_param.h"
 
 constexpr int64_t kNoPadding = -1;
@@ -36,7 +37,14 @@ void LookupCompute(const LookupParam<CPU> &param) {
   ids_numel = ids_t->numel();
   int64_t row_number = table_t->dims()[0];
   int64_t row_width = table_t->dims()[1];
-  auto *table = table_t->data<float>();
+  // 表可能以 half 存储, 见 PaddleMobileConfigInternal::weight_precision
+  const half *half_table = nullptr;
+  const float *table = nullptr;
+  if (table_t->type() == typeid(half)) {
+    half_table = table_t->data<half>();
+  } else {
+    table = table_t->data<float>();
+  }
   auto *output = output_t->mutable_data<float>();
   for (int64_t i = 0; i < ids_numel; ++i) {
     if (padding_idx != kNoPadding && ids[i] == padding_idx) {
@@ -47,8 +55,13 @@ void LookupCompute(const LookupParam<CPU> &param) {
       PADDLE_MOBILE_ENFORCE(ids[i] >= 0,
                             "lookuptable ids[i] >= 0 check failed");
 
-      memcpy(output + i * row_width, table + ids[i] * row_width,
-             row_width * sizeof(float));
+      if (half_table != nullptr) {
+        math::HalfToFloat(half_table + ids[i] * row_width,
+                          output + i * row_width, row_width);
+      } else {
+        memcpy(output + i * row_width, table + ids[i] * row_width,
+               row_width * sizeof(float));
+      }
     }
   }
 }
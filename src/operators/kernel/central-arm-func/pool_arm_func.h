@@ -19,6 +19,7 @@ limitations under the License. */
 #include <string>
 #include <vector>
 #include "common/types.h"
+#include "operators/math/blocked_layout.h"
 #include "operators/math/pooling.h"
 
 namespace paddle_mobile {
@@ -38,6 +39,14 @@ void PoolCompute(const PoolParam<CPU> &param) {
       ksize[i] = static_cast<int>(input->dims()[i + 2]);
     }
   }
+  if (framework::DataLayoutBlock(input->layout()) > 1) {
+    if (pooling_type == "max") {
+      math::PoolBlocked<MAX>(*input, ksize, strides, paddings, output);
+    } else {
+      math::PoolBlocked<AVG>(*input, ksize, strides, paddings, output);
+    }
+    return;
+  }
   if (ksize[0] == 3 && ksize[0] == ksize[1]) {
     if (pooling_type == "max" && strides[0] == strides[1]) {
       if (strides[0] == 1) {
@@ -0,0 +1,36 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+#ifdef LAYOUT_TRANSFORM_OP
+
+#include "operators/layout_transform_op.h"
+
+namespace paddle_mobile {
+namespace operators {
+
+template <typename DeviceType, typename T>
+void LayoutTransformOp<DeviceType, T>::InferShape() const {
+  // the blocked tensor keeps the dims of the NCHW one
+  this->param_.output_->Resize(this->param_.input_->dims());
+  this->param_.output_->set_layout(this->param_.dst_layout_);
+}
+
+}  // namespace operators
+}  // namespace paddle_mobile
+
+namespace ops = paddle_mobile::operators;
+#ifdef PADDLE_MOBILE_CPU
+REGISTER_OPERATOR_CPU(layout_transform, ops::LayoutTransformOp);
+#endif
+
+#endif  // LAYOUT_TRANSFORM_OP
@@ -23,6 +23,7 @@ limitations under the License. */
 #include <arm_neon.h>
 #include "operators/math/math_func_neon.h"
 #endif
+#include "operators/math/math_func_avx.h"
 
 namespace paddle_mobile {
 namespace operators {
@@ -39,6 +40,12 @@ inline ActivationType GetActivationType(const std::string &type) {
     return ActivationType::RELU;
   } else if (type == "tanh") {
     return ActivationType::TANH;
+  } else if (type == "relu6") {
+    return ActivationType::RELU6;
+  } else if (type == "leaky_relu") {
+    return ActivationType::LEAKY_RELU;
+  } else if (type == "hard_swish") {
+    return ActivationType::HARD_SWISH;
   } else if (type == "identity" || type == "") {
     return ActivationType::IDENTITY;
   }
@@ -104,8 +111,71 @@ template <>
 inline float32x4_t vActiveq_f32<LOG>(const float32x4_t &x) {
   return log_ps(x);
 }
+
+// x * relu6(x + 3) / 6
+template <>
+inline float32x4_t vActiveq_f32<HARD_SWISH>(const float32x4_t &x) {
+  float32x4_t __r = vaddq_f32(x, vdupq_n_f32(3.f));
+  __r = vminq_f32(vmaxq_f32(__r, vdupq_n_f32(0.f)), vdupq_n_f32(6.f));
+  return vmulq_f32(vmulq_n_f32(x, 1.f / 6), __r);
+}
 #endif
 
+#if defined(__x86_64__) || defined(__i386__)
+template <ActivationType Act = IDENTITY>
+AVX2_TARGET inline __m256 vActive256_f32(const __m256 &x) {
+  return x;
+}
+
+template <>
+AVX2_TARGET inline __m256 vActive256_f32<RELU>(const __m256 &x) {
+  return _mm256_max_ps(x, _mm256_setzero_ps());
+}
+
+template <>
+AVX2_TARGET inline __m256 vActive256_f32<RELU6>(const __m256 &x) {
+  __m256 __six = _mm256_set1_ps(6.f);
+  return _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), __six);
+}
+
+template <>
+AVX2_TARGET inline __m256 vActive256_f32<SIGMOID>(const __m256 &x) {
+  __m256 __one = _mm256_set1_ps(1.f);
+  __m256 __x = exp256_ps(_mm256_sub_ps(_mm256_setzero_ps(), x));
+  return _mm256_div_ps(__one, _mm256_add_ps(__x, __one));
+}
+
+template <>
+AVX2_TARGET inline __m256 vActive256_f32<TANH>(const __m256 &x) {
+  __m256 __one = _mm256_set1_ps(1.f);
+  __m256 __two = _mm256_set1_ps(2.f);
+  __m256 __x = exp256_ps(_mm256_mul_ps(x, _mm256_set1_ps(-2.f)));
+  __x = _mm256_div_ps(__two, _mm256_add_ps(__x, __one));
+  return _mm256_sub_ps(__x, __one);
+}
+
+template <>
+AVX2_TARGET inline __m256 vActive256_f32<LOG>(const __m256 &x) {
+  return log256_ps(x);
+}
+
+template <>
+AVX2_TARGET inline __m256 vActive256_f32<HARD_SWISH>(const __m256 &x) {
+  __m256 __r = _mm256_add_ps(x, _mm256_set1_ps(3.f));
+  __r = _mm256_min_ps(_mm256_max_ps(__r, _mm256_setzero_ps()),
+                      _mm256_set1_ps(6.f));
+  return _mm256_mul_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.f / 6)), __r);
+}
+
+// y = Act(x) over n floats, n is a multiple of 8
+template <ActivationType Act>
+AVX2_TARGET inline void vActive256(const float *x, float *y, size_t n) {
+  for (size_t i = 0; i < n; i += 8) {
+    _mm256_storeu_ps(y + i, vActive256_f32<Act>(_mm256_loadu_ps(x + i)));
+  }
+}
+#endif  // __x86_64__
+
 template <ActivationType Act = IDENTITY>
 inline float Active(const float &x) {
   return x;
@@ -142,6 +212,11 @@ inline float Active<LOG>(const float &x) {
   return log(x);
 }
 
+template <>
+inline float Active<HARD_SWISH>(const float &x) {
+  return x * std::min(std::max(x + 3.f, 0.f), 6.f) * (1.f / 6);
+}
+
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle_mobile
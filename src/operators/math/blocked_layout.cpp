@@ -0,0 +1,798 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "operators/math/blocked_layout.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "common/enforce.h"
+#include "common/threadpool.h"
+#include "operators/math/math_func_avx.h"
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+using framework::DataLayout;
+using framework::Tensor;
+
+DataLayout PreferredBlockedLayout() {
+#if defined(__x86_64__) || defined(__i386__)
+  if (HasAvx2()) {
+    return DataLayout::kNCHW8;
+  }
+#endif  // __x86_64__
+  return DataLayout::kNCHW4;
+}
+
+static inline int Blocks(int channels, int block) {
+  return (channels + block - 1) / block;
+}
+
+template <int B>
+static void ToBlocked(const float *input, int batch, int channels,
+                      int spatial, float *output) {
+  const int blocks = Blocks(channels, B);
+  parallel_for(0, batch * blocks, [&](int index) {
+    const int n = index / blocks;
+    const int cb = index % blocks;
+    float *y = output + static_cast<int64_t>(index) * spatial * B;
+    for (int b = 0; b < B; ++b) {
+      const int c = cb * B + b;
+      if (c >= channels) {
+        for (int s = 0; s < spatial; ++s) {
+          y[s * B + b] = 0.f;
+        }
+        continue;
+      }
+      const float *x =
+          input + (static_cast<int64_t>(n) * channels + c) * spatial;
+      for (int s = 0; s < spatial; ++s) {
+        y[s * B + b] = x[s];
+      }
+    }
+  });
+}
+
+template <int B>
+static void FromBlocked(const float *input, int batch, int channels,
+                        int spatial, float *output) {
+  const int blocks = Blocks(channels, B);
+  parallel_for(0, batch * blocks, [&](int index) {
+    const int n = index / blocks;
+    const int cb = index % blocks;
+    const float *x = input + static_cast<int64_t>(index) * spatial * B;
+    for (int b = 0; b < B && cb * B + b < channels; ++b) {
+      float *y = output +
+                 (static_cast<int64_t>(n) * channels + cb * B + b) * spatial;
+      for (int s = 0; s < spatial; ++s) {
+        y[s] = x[s * B + b];
+      }
+    }
+  });
+}
+
+void LayoutTransform(const Tensor &input, DataLayout layout, Tensor *output) {
+  PADDLE_MOBILE_ENFORCE(input.dims().size() == 4,
+                        "Only 4-D tensors have a blocked layout.");
+  const int batch = input.dims()[0];
+  const int channels = input.dims()[1];
+  const int spatial = input.dims()[2] * input.dims()[3];
+  const float *x = input.data<float>();
+  output->Resize(input.dims());
+  output->set_layout(layout);
+  float *y = output->mutable_data<float>();
+  if (input.layout() == layout) {
+    memcpy(y, x, input.storage_numel() * sizeof(float));
+    return;
+  }
+  const int in_block = framework::DataLayoutBlock(input.layout());
+  const int out_block = framework::DataLayoutBlock(layout);
+  PADDLE_MOBILE_ENFORCE(in_block == 1 || out_block == 1,
+                        "Can not transform %s to %s.",
+                        framework::DataLayoutToString(input.layout()).c_str(),
+                        framework::DataLayoutToString(layout).c_str());
+  switch (in_block * out_block) {
+    case 4:
+      if (in_block == 1) {
+        ToBlocked<4>(x, batch, channels, spatial, y);
+      } else {
+        FromBlocked<4>(x, batch, channels, spatial, y);
+      }
+      break;
+    case 8:
+      if (in_block == 1) {
+        ToBlocked<8>(x, batch, channels, spatial, y);
+      } else {
+        FromBlocked<8>(x, batch, channels, spatial, y);
+      }
+      break;
+    default:
+      PADDLE_MOBILE_THROW_EXCEPTION("Unsupported layout transform.");
+  }
+}
+
+void PackConvFilterBlocked(const Tensor &filter, int groups,
+                           DataLayout layout, Tensor *packed_filter) {
+  if (packed_filter->IsInitialized()) {
+    // shared from another executor by OperatorBase::InitFrom
+    return;
+  }
+  const int block = framework::DataLayoutBlock(layout);
+  const int out_c = filter.dims()[0];
+  const int in_c = filter.dims()[1] * groups;
+  const int kernel_h = filter.dims()[2];
+  const int kernel_w = filter.dims()[3];
+  const int kernel_size = kernel_h * kernel_w;
+  const int out_blocks = Blocks(out_c, block);
+  const int in_blocks = Blocks(in_c, block);
+  const float *w = filter.data<float>();
+  if (groups > 1) {
+    PADDLE_MOBILE_ENFORCE(groups == out_c && filter.dims()[1] == 1,
+                          "A blocked conv has groups 1 or is depthwise.");
+    float *packed = packed_filter->mutable_data<float>(
+        framework::make_ddim({out_blocks, kernel_h, kernel_w, block}));
+    memset(packed, 0, packed_filter->numel() * sizeof(float));
+    for (int c = 0; c < out_c; ++c) {
+      for (int k = 0; k < kernel_size; ++k) {
+        packed[((c / block) * kernel_size + k) * block + c % block] =
+            w[c * kernel_size + k];
+      }
+    }
+    return;
+  }
+  float *packed = packed_filter->mutable_data<float>(framework::make_ddim(
+      {out_blocks, in_blocks, kernel_h, kernel_w, block * block}));
+  memset(packed, 0, packed_filter->numel() * sizeof(float));
+  for (int oc = 0; oc < out_c; ++oc) {
+    for (int ic = 0; ic < in_c; ++ic) {
+      for (int k = 0; k < kernel_size; ++k) {
+        int64_t offset =
+            ((static_cast<int64_t>(oc / block) * in_blocks + ic / block) *
+                 kernel_size +
+             k) *
+                block * block +
+            (ic % block) * block + oc % block;
+        packed[offset] = w[(oc * in_c + ic) * kernel_size + k];
+      }
+    }
+  }
+}
+
+struct BlockedConvArgs {
+  const float *input;
+  const float *filter;
+  const float *scale;
+  const float *bias;
+  float *output;
+  int in_blocks;
+  int in_h;
+  int in_w;
+  int out_blocks;
+  int out_h;
+  int out_w;
+  int kernel_h;
+  int kernel_w;
+  int stride_h;
+  int stride_w;
+  int pad_h;
+  int pad_w;
+  int dilation_h;
+  int dilation_w;
+  bool depthwise;
+  bool relu;
+};
+
+template <int B>
+static inline __attribute__((always_inline)) void StoreBlocked(
+    const BlockedConvArgs &args, const float *acc, const float *scale,
+    const float *bias, float *y) {
+  for (int b = 0; b < B; ++b) {
+    float v = acc[b] * scale[b] + bias[b];
+    y[b] = args.relu ? std::max(v, 0.f) : v;
+  }
+}
+
+// T outputs of a row whose input columns are all inside the image
+template <int B, int T>
+static inline __attribute__((always_inline)) void ConvTile(
+    const BlockedConvArgs &args, const float *x, const float *w, int oh,
+    int ow, const float *scale, const float *bias, float *y) {
+  float acc[T][B] = {{0.f}};
+  const int x_step = args.stride_w * B;
+  const int in_block_size = args.in_h * args.in_w * B;
+  for (int ib = 0; ib < (args.depthwise ? 1 : args.in_blocks); ++ib) {
+    for (int kh = 0; kh < args.kernel_h; ++kh) {
+      const int ih = oh * args.stride_h - args.pad_h + kh * args.dilation_h;
+      if (ih < 0 || ih >= args.in_h) {
+        continue;
+      }
+      const float *x_row =
+          x + ib * in_block_size +
+          (ih * args.in_w + ow * args.stride_w - args.pad_w) * B;
+      for (int kw = 0; kw < args.kernel_w; ++kw) {
+        const float *x_k = x_row + kw * args.dilation_w * B;
+        const int k = kh * args.kernel_w + kw;
+        if (args.depthwise) {
+          const float *w_k = w + k * B;
+          for (int t = 0; t < T; ++t) {
+            for (int b = 0; b < B; ++b) {
+              acc[t][b] += x_k[t * x_step + b] * w_k[b];
+            }
+          }
+        } else {
+          const float *w_k =
+              w + (ib * args.kernel_h * args.kernel_w + k) * B * B;
+          for (int t = 0; t < T; ++t) {
+            for (int ic = 0; ic < B; ++ic) {
+              const float v = x_k[t * x_step + ic];
+              for (int oc = 0; oc < B; ++oc) {
+                acc[t][oc] += v * w_k[ic * B + oc];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  for (int t = 0; t < T; ++t) {
+    StoreBlocked<B>(args, acc[t], scale, bias, y + (ow + t) * B);
+  }
+}
+
+// one output at the border of the row, the input columns are checked
+template <int B>
+static inline void ConvPoint(const BlockedConvArgs &args, const float *x,
+                             const float *w, int oh, int ow,
+                             const float *scale, const float *bias,
+                             float *y) {
+  float acc[B] = {0.f};
+  const int in_block_size = args.in_h * args.in_w * B;
+  for (int ib = 0; ib < (args.depthwise ? 1 : args.in_blocks); ++ib) {
+    for (int kh = 0; kh < args.kernel_h; ++kh) {
+      const int ih = oh * args.stride_h - args.pad_h + kh * args.dilation_h;
+      if (ih < 0 || ih >= args.in_h) {
+        continue;
+      }
+      for (int kw = 0; kw < args.kernel_w; ++kw) {
+        const int iw = ow * args.stride_w - args.pad_w + kw * args.dilation_w;
+        if (iw < 0 || iw >= args.in_w) {
+          continue;
+        }
+        const float *x_k = x + ib * in_block_size + (ih * args.in_w + iw) * B;
+        const int k = kh * args.kernel_w + kw;
+        if (args.depthwise) {
+          for (int b = 0; b < B; ++b) {
+            acc[b] += x_k[b] * w[k * B + b];
+          }
+        } else {
+          const float *w_k =
+              w + (ib * args.kernel_h * args.kernel_w + k) * B * B;
+          for (int ic = 0; ic < B; ++ic) {
+            for (int oc = 0; oc < B; ++oc) {
+              acc[oc] += x_k[ic] * w_k[ic * B + oc];
+            }
+          }
+        }
+      }
+    }
+  }
+  StoreBlocked<B>(args, acc, scale, bias, y + ow * B);
+}
+
+// the pointers of one output row of block ob, and the range of outputs
+// [valid_begin, valid_end) whose input columns are all inside the image
+struct BlockedConvRow {
+  const float *x;
+  const float *w;
+  const float *scale;
+  const float *bias;
+  float *y;
+  int valid_begin;
+  int valid_end;
+};
+
+template <int B>
+static inline __attribute__((always_inline)) BlockedConvRow
+GetBlockedConvRow(const BlockedConvArgs &args, int n, int ob, int oh) {
+  BlockedConvRow row;
+  const int64_t in_image = static_cast<int64_t>(args.in_blocks) * args.in_h *
+                           args.in_w * B;
+  row.x = args.input + n * in_image;
+  if (args.depthwise) {
+    row.x += static_cast<int64_t>(ob) * args.in_h * args.in_w * B;
+    row.w = args.filter + ob * args.kernel_h * args.kernel_w * B;
+  } else {
+    row.w = args.filter + static_cast<int64_t>(ob) * args.in_blocks *
+                              args.kernel_h * args.kernel_w * B * B;
+  }
+  row.y = args.output +
+          ((static_cast<int64_t>(n) * args.out_blocks + ob) * args.out_h +
+           oh) *
+              args.out_w * B;
+  row.scale = args.scale + ob * B;
+  row.bias = args.bias + ob * B;
+  row.valid_begin =
+      std::min((args.pad_w + args.stride_w - 1) / args.stride_w, args.out_w);
+  const int last = args.in_w - 1 + args.pad_w -
+                   (args.kernel_w - 1) * args.dilation_w;
+  row.valid_end =
+      last < 0 ? 0 : std::min(last / args.stride_w + 1, args.out_w);
+  return row;
+}
+
+// one output row of block ob without simd, 32 floats of accumulators
+template <int B>
+static void ConvBlockedRow(const BlockedConvArgs &args, int n, int ob,
+                           int oh) {
+  const int T = 32 / B;
+  const BlockedConvRow r = GetBlockedConvRow<B>(args, n, ob, oh);
+  int ow = 0;
+  for (; ow < r.valid_begin; ++ow) {
+    ConvPoint<B>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+  for (; ow + T <= r.valid_end; ow += T) {
+    ConvTile<B, T>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+  for (; ow < args.out_w; ++ow) {
+    ConvPoint<B>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+}
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__SSE2__)
+#define BLOCKED_CONV_FLOAT4
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+typedef float32x4_t Float4;
+static inline Float4 Load4(const float *p) { return vld1q_f32(p); }
+static inline void Store4(float *p, Float4 v) { vst1q_f32(p, v); }
+static inline Float4 Zero4() { return vdupq_n_f32(0.f); }
+static inline Float4 Max4(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+// acc + a * b
+static inline Float4 MulAdd4(Float4 acc, Float4 a, Float4 b) {
+  return vmlaq_f32(acc, a, b);
+}
+static inline Float4 MulAdd4(Float4 acc, Float4 a, float b) {
+  return vmlaq_n_f32(acc, a, b);
+}
+#else
+typedef __m128 Float4;
+static inline Float4 Load4(const float *p) { return _mm_loadu_ps(p); }
+static inline void Store4(float *p, Float4 v) { _mm_storeu_ps(p, v); }
+static inline Float4 Zero4() { return _mm_setzero_ps(); }
+static inline Float4 Max4(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+static inline Float4 MulAdd4(Float4 acc, Float4 a, Float4 b) {
+  return _mm_add_ps(acc, _mm_mul_ps(a, b));
+}
+static inline Float4 MulAdd4(Float4 acc, Float4 a, float b) {
+  return _mm_add_ps(acc, _mm_mul_ps(a, _mm_set1_ps(b)));
+}
+#endif  // __ARM_NEON
+
+// T outputs of a row of NCHW4 with neon or sse, each register holds the 4
+// channels of one output. Border checks the input columns of one output at
+// the border of the row.
+template <int T, bool Border>
+static inline __attribute__((always_inline)) void ConvTile4(
+    const BlockedConvArgs &args, const float *x, const float *w, int oh,
+    int ow, const float *scale, const float *bias, float *y) {
+  Float4 acc[T];
+  for (int t = 0; t < T; ++t) {
+    acc[t] = Zero4();
+  }
+  const int x_step = args.stride_w * 4;
+  const int in_block_size = args.in_h * args.in_w * 4;
+  for (int ib = 0; ib < (args.depthwise ? 1 : args.in_blocks); ++ib) {
+    for (int kh = 0; kh < args.kernel_h; ++kh) {
+      const int ih = oh * args.stride_h - args.pad_h + kh * args.dilation_h;
+      if (ih < 0 || ih >= args.in_h) {
+        continue;
+      }
+      const float *x_row =
+          x + ib * in_block_size +
+          (ih * args.in_w + ow * args.stride_w - args.pad_w) * 4;
+      for (int kw = 0; kw < args.kernel_w; ++kw) {
+        if (Border) {
+          const int iw =
+              ow * args.stride_w - args.pad_w + kw * args.dilation_w;
+          if (iw < 0 || iw >= args.in_w) {
+            continue;
+          }
+        }
+        const float *x_k = x_row + kw * args.dilation_w * 4;
+        const int k = kh * args.kernel_w + kw;
+        if (args.depthwise) {
+          const Float4 wv = Load4(w + k * 4);
+          for (int t = 0; t < T; ++t) {
+            acc[t] = MulAdd4(acc[t], Load4(x_k + t * x_step), wv);
+          }
+        } else {
+          const float *w_k = w + (ib * args.kernel_h * args.kernel_w + k) * 16;
+          const Float4 w0 = Load4(w_k);
+          const Float4 w1 = Load4(w_k + 4);
+          const Float4 w2 = Load4(w_k + 8);
+          const Float4 w3 = Load4(w_k + 12);
+          for (int t = 0; t < T; ++t) {
+            const float *x_t = x_k + t * x_step;
+            acc[t] = MulAdd4(acc[t], w0, x_t[0]);
+            acc[t] = MulAdd4(acc[t], w1, x_t[1]);
+            acc[t] = MulAdd4(acc[t], w2, x_t[2]);
+            acc[t] = MulAdd4(acc[t], w3, x_t[3]);
+          }
+        }
+      }
+    }
+  }
+  const Float4 s = Load4(scale);
+  const Float4 b = Load4(bias);
+  for (int t = 0; t < T; ++t) {
+    Float4 v = MulAdd4(b, acc[t], s);
+    if (args.relu) {
+      v = Max4(v, Zero4());
+    }
+    Store4(y + (ow + t) * 4, v);
+  }
+}
+
+static void ConvBlockedRow4(const BlockedConvArgs &args, int n, int ob,
+                            int oh) {
+  const BlockedConvRow r = GetBlockedConvRow<4>(args, n, ob, oh);
+  int ow = 0;
+  for (; ow < r.valid_begin; ++ow) {
+    ConvTile4<1, true>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+  for (; ow + 8 <= r.valid_end; ow += 8) {
+    ConvTile4<8, false>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+  for (; ow + 4 <= r.valid_end; ow += 4) {
+    ConvTile4<4, false>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+  for (; ow < r.valid_end; ++ow) {
+    ConvTile4<1, false>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+  for (; ow < args.out_w; ++ow) {
+    ConvTile4<1, true>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+}
+#endif  // __ARM_NEON || __SSE2__
+
+#if defined(__x86_64__) || defined(__i386__)
+// T outputs of a row with avx2, each register holds the 8 channels of one
+// output and every input channel is broadcast to a register. Border checks
+// the input columns of one output at the border of the row.
+template <int T, bool Border>
+AVX2_TARGET static inline __attribute__((always_inline)) void ConvTileAvx2(
+    const BlockedConvArgs &args, const float *x, const float *w, int oh,
+    int ow, const float *scale, const float *bias, float *y) {
+  __m256 acc[T];
+  for (int t = 0; t < T; ++t) {
+    acc[t] = _mm256_setzero_ps();
+  }
+  const int x_step = args.stride_w * 8;
+  const int in_block_size = args.in_h * args.in_w * 8;
+  for (int ib = 0; ib < (args.depthwise ? 1 : args.in_blocks); ++ib) {
+    for (int kh = 0; kh < args.kernel_h; ++kh) {
+      const int ih = oh * args.stride_h - args.pad_h + kh * args.dilation_h;
+      if (ih < 0 || ih >= args.in_h) {
+        continue;
+      }
+      const float *x_row =
+          x + ib * in_block_size +
+          (ih * args.in_w + ow * args.stride_w - args.pad_w) * 8;
+      for (int kw = 0; kw < args.kernel_w; ++kw) {
+        if (Border) {
+          const int iw =
+              ow * args.stride_w - args.pad_w + kw * args.dilation_w;
+          if (iw < 0 || iw >= args.in_w) {
+            continue;
+          }
+        }
+        const float *x_k = x_row + kw * args.dilation_w * 8;
+        const int k = kh * args.kernel_w + kw;
+        if (args.depthwise) {
+          const __m256 wv = _mm256_loadu_ps(w + k * 8);
+          for (int t = 0; t < T; ++t) {
+            acc[t] =
+                _mm256_fmadd_ps(_mm256_loadu_ps(x_k + t * x_step), wv, acc[t]);
+          }
+        } else {
+          const float *w_k = w + (ib * args.kernel_h * args.kernel_w + k) * 64;
+          for (int ic = 0; ic < 8; ++ic) {
+            const __m256 wv = _mm256_loadu_ps(w_k + ic * 8);
+            for (int t = 0; t < T; ++t) {
+              acc[t] = _mm256_fmadd_ps(
+                  _mm256_broadcast_ss(x_k + t * x_step + ic), wv, acc[t]);
+            }
+          }
+        }
+      }
+    }
+  }
+  const __m256 s = _mm256_loadu_ps(scale);
+  const __m256 b = _mm256_loadu_ps(bias);
+  const __m256 zero = _mm256_setzero_ps();
+  for (int t = 0; t < T; ++t) {
+    __m256 v = _mm256_fmadd_ps(acc[t], s, b);
+    if (args.relu) {
+      v = _mm256_max_ps(v, zero);
+    }
+    _mm256_storeu_ps(y + (ow + t) * 8, v);
+  }
+}
+
+AVX2_TARGET static void ConvBlockedRowAvx2(const BlockedConvArgs &args,
+                                           int n, int ob, int oh) {
+  const BlockedConvRow r = GetBlockedConvRow<8>(args, n, ob, oh);
+  int ow = 0;
+  for (; ow < r.valid_begin; ++ow) {
+    ConvTileAvx2<1, true>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+  for (; ow + 8 <= r.valid_end; ow += 8) {
+    ConvTileAvx2<8, false>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+  for (; ow + 4 <= r.valid_end; ow += 4) {
+    ConvTileAvx2<4, false>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+  for (; ow < r.valid_end; ++ow) {
+    ConvTileAvx2<1, false>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+  for (; ow < args.out_w; ++ow) {
+    ConvTileAvx2<1, true>(args, r.x, r.w, oh, ow, r.scale, r.bias, r.y);
+  }
+}
+#endif  // __x86_64__
+
+template <int B>
+static void ConvBlockedImpl(const BlockedConvArgs &args, int batch) {
+  const int rows = args.out_blocks * args.out_h;
+  parallel_for(0, batch * rows, [&](int index) {
+    const int n = index / rows;
+    const int ob = (index % rows) / args.out_h;
+    const int oh = index % args.out_h;
+#if defined(__x86_64__) || defined(__i386__)
+    if (B == 8 && HasAvx2()) {
+      ConvBlockedRowAvx2(args, n, ob, oh);
+      return;
+    }
+#endif  // __x86_64__
+#ifdef BLOCKED_CONV_FLOAT4
+    if (B == 4) {
+      ConvBlockedRow4(args, n, ob, oh);
+      return;
+    }
+#endif  // BLOCKED_CONV_FLOAT4
+    ConvBlockedRow<B>(args, n, ob, oh);
+  });
+}
+
+void ConvBlocked(const Tensor &input, const Tensor &packed_filter, int groups,
+                 const std::vector<int> &strides,
+                 const std::vector<int> &paddings,
+                 const std::vector<int> &dilations, const float *scale,
+                 const float *bias, bool relu, Tensor *output) {
+  const int block = framework::DataLayoutBlock(input.layout());
+  const int out_c = output->dims()[1];
+  const bool depthwise = groups > 1;
+  BlockedConvArgs args;
+  args.input = input.data<float>();
+  args.filter = packed_filter.data<float>();
+  args.in_blocks = Blocks(input.dims()[1], block);
+  args.in_h = input.dims()[2];
+  args.in_w = input.dims()[3];
+  args.out_blocks = Blocks(out_c, block);
+  args.out_h = output->dims()[2];
+  args.out_w = output->dims()[3];
+  args.kernel_h = packed_filter.dims()[depthwise ? 1 : 2];
+  args.kernel_w = packed_filter.dims()[depthwise ? 2 : 3];
+  args.stride_h = strides[0];
+  args.stride_w = strides[1];
+  args.pad_h = paddings[0];
+  args.pad_w = paddings[1];
+  args.dilation_h = dilations[0];
+  args.dilation_w = dilations[1];
+  args.depthwise = depthwise;
+  args.relu = relu;
+  // the padded channels are scaled by 0 to stay zero
+  std::vector<float> scales(args.out_blocks * block, 0.f);
+  std::vector<float> biases(args.out_blocks * block, 0.f);
+  for (int c = 0; c < out_c; ++c) {
+    scales[c] = scale ? scale[c] : 1.f;
+    biases[c] = bias ? bias[c] : 0.f;
+  }
+  args.scale = scales.data();
+  args.bias = biases.data();
+  output->set_layout(input.layout());
+  args.output = output->mutable_data<float>();
+
+  const int batch = input.dims()[0];
+  switch (block) {
+    case 4:
+      ConvBlockedImpl<4>(args, batch);
+      break;
+    case 8:
+      ConvBlockedImpl<8>(args, batch);
+      break;
+    default:
+      PADDLE_MOBILE_THROW_EXCEPTION("The input of conv is not blocked.");
+  }
+}
+
+template <PoolingType P, int B>
+static void PoolBlockedImpl(const Tensor &input,
+                            const std::vector<int> &kernel_size,
+                            const std::vector<int> &strides,
+                            const std::vector<int> &paddings,
+                            Tensor *output) {
+  const int in_h = input.dims()[2];
+  const int in_w = input.dims()[3];
+  const int out_h = output->dims()[2];
+  const int out_w = output->dims()[3];
+  const int blocks = input.dims()[0] * Blocks(input.dims()[1], B);
+  const float *input_data = input.data<float>();
+  float *output_data = output->mutable_data<float>();
+  parallel_for(0, blocks * out_h, [&](int index) {
+    const int oh = index % out_h;
+    const float *x =
+        input_data + static_cast<int64_t>(index / out_h) * in_h * in_w * B;
+    float *y = output_data + static_cast<int64_t>(index) * out_w * B;
+    int h_start = oh * strides[0] - paddings[0];
+    const int h_end = std::min(h_start + kernel_size[0], in_h);
+    h_start = std::max(h_start, 0);
+    for (int ow = 0; ow < out_w; ++ow, y += B) {
+      int w_start = ow * strides[1] - paddings[1];
+      const int w_end = std::min(w_start + kernel_size[1], in_w);
+      w_start = std::max(w_start, 0);
+      float val[B];
+      for (int b = 0; b < B; ++b) {
+        val[b] = P == MAX ? -std::numeric_limits<float>::max() : 0.f;
+      }
+      for (int h = h_start; h < h_end; ++h) {
+        const float *x_row = x + (h * in_w + w_start) * B;
+        for (int w = w_start; w < w_end; ++w, x_row += B) {
+          for (int b = 0; b < B; ++b) {
+            val[b] = P == MAX ? std::max(val[b], x_row[b]) : val[b] + x_row[b];
+          }
+        }
+      }
+      const int count = (h_end - h_start) * (w_end - w_start);
+      const float factor = P == MAX ? 1.f : 1.f / std::max(count, 1);
+      for (int b = 0; b < B; ++b) {
+        y[b] = count > 0 ? val[b] * factor : 0.f;
+      }
+    }
+  });
+}
+
+template <PoolingType P>
+void PoolBlocked(const Tensor &input, const std::vector<int> &kernel_size,
+                 const std::vector<int> &strides,
+                 const std::vector<int> &paddings, Tensor *output) {
+  output->set_layout(input.layout());
+  switch (framework::DataLayoutBlock(input.layout())) {
+    case 4:
+      PoolBlockedImpl<P, 4>(input, kernel_size, strides, paddings, output);
+      break;
+    case 8:
+      PoolBlockedImpl<P, 8>(input, kernel_size, strides, paddings, output);
+      break;
+    default:
+      PADDLE_MOBILE_THROW_EXCEPTION("The input of pooling is not blocked.");
+  }
+}
+
+template void PoolBlocked<MAX>(const Tensor &input,
+                               const std::vector<int> &kernel_size,
+                               const std::vector<int> &strides,
+                               const std::vector<int> &paddings,
+                               Tensor *output);
+template void PoolBlocked<AVG>(const Tensor &input,
+                               const std::vector<int> &kernel_size,
+                               const std::vector<int> &strides,
+                               const std::vector<int> &paddings,
+                               Tensor *output);
+
+template <int B>
+static void ScaleBiasBlockedImpl(const Tensor &input, const float *scale,
+                                 const float *bias, bool relu,
+                                 Tensor *output) {
+  const int channels = input.dims()[1];
+  const int blocks = Blocks(channels, B);
+  const int spatial = input.dims()[2] * input.dims()[3];
+  const float *input_data = input.data<float>();
+  float *output_data = output->mutable_data<float>();
+  parallel_for(0, input.dims()[0] * blocks, [&](int index) {
+    const int cb = index % blocks;
+    float s[B], t[B];
+    for (int b = 0; b < B; ++b) {
+      const int c = cb * B + b;
+      s[b] = c >= channels ? 0.f : scale ? scale[c] : 1.f;
+      t[b] = c >= channels ? 0.f : bias[c];
+    }
+    const float *x = input_data + static_cast<int64_t>(index) * spatial * B;
+    float *y = output_data + static_cast<int64_t>(index) * spatial * B;
+    for (int i = 0; i < spatial; ++i, x += B, y += B) {
+      for (int b = 0; b < B; ++b) {
+        float v = x[b] * s[b] + t[b];
+        y[b] = relu ? std::max(v, 0.f) : v;
+      }
+    }
+  });
+}
+
+void ScaleBiasBlocked(const Tensor &input, const float *scale,
+                      const float *bias, bool relu, Tensor *output) {
+  output->set_layout(input.layout());
+  switch (framework::DataLayoutBlock(input.layout())) {
+    case 4:
+      ScaleBiasBlockedImpl<4>(input, scale, bias, relu, output);
+      break;
+    case 8:
+      ScaleBiasBlockedImpl<8>(input, scale, bias, relu, output);
+      break;
+    default:
+      PADDLE_MOBILE_THROW_EXCEPTION("The input is not blocked.");
+  }
+}
+
+void AddBlocked(const Tensor &input0, const Tensor &input1, Tensor *output) {
+  PADDLE_MOBILE_ENFORCE(input0.layout() == input1.layout() &&
+                            input0.dims() == input1.dims(),
+                        "The inputs of blocked add differ in layout or dims.");
+  output->set_layout(input0.layout());
+  const float *x0 = input0.data<float>();
+  const float *x1 = input1.data<float>();
+  float *y = output->mutable_data<float>();
+  // the padded channels are 0 + 0
+  const int64_t size = input0.storage_numel();
+  const int64_t chunk = 4096;
+  parallel_for(0, (size + chunk - 1) / chunk, [&](int index) {
+    const int64_t end = std::min(size, (index + 1) * chunk);
+    for (int64_t i = index * chunk; i < end; ++i) {
+      y[i] = x0[i] + x1[i];
+    }
+  });
+}
+
+void ConcatBlocked(const std::vector<const Tensor *> &inputs,
+                   Tensor *output) {
+  const DataLayout layout = inputs[0]->layout();
+  const int block = framework::DataLayoutBlock(layout);
+  output->set_layout(layout);
+  float *y = output->mutable_data<float>();
+  const int batch = output->dims()[0];
+  const int64_t out_image = output->storage_numel() / batch;
+  int64_t offset = 0;
+  for (int i = 0; i < inputs.size(); ++i) {
+    const Tensor *input = inputs[i];
+    PADDLE_MOBILE_ENFORCE(
+        input->layout() == layout &&
+            (i + 1 == inputs.size() || input->dims()[1] % block == 0),
+        "The channels of blocked concat inputs must fill whole blocks.");
+    const int64_t in_image = input->storage_numel() / batch;
+    const float *x = input->data<float>();
+    for (int n = 0; n < batch; ++n) {
+      memcpy(y + n * out_image + offset, x + n * in_image,
+             in_image * sizeof(float));
+    }
+    offset += in_image;
+  }
+  PADDLE_MOBILE_ENFORCE(offset == out_image,
+                        "The inputs of blocked concat do not fill the output.");
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
@@ -0,0 +1,79 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <vector>
+#include "common/types.h"
+#include "framework/data_layout.h"
+#include "framework/tensor.h"
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+// Kernels on the channel blocked layouts NCHW4 and NCHW8. A 4-D tensor of
+// dims [N, C, H, W] keeps its dims but stores [N, C / b, H, W, b], so the
+// innermost loop of every kernel runs over the b channels of one pixel and
+// maps onto a vector register. The channels padded up to a multiple of b are
+// zero, every kernel below keeps them zero.
+
+// the blocked layout of the widest vector register of this cpu
+framework::DataLayout PreferredBlockedLayout();
+
+// converts input to layout, one of the input layout and layout is NCHW and
+// the other one is blocked
+void LayoutTransform(const framework::Tensor &input,
+                     framework::DataLayout layout, framework::Tensor *output);
+
+// reorders the OIHW filter of a conv with groups 1 into
+// [OC / b, IC / b, KH, KW, b(ic), b(oc)], or the filter of a depthwise conv
+// into [C / b, KH, KW, b]
+void PackConvFilterBlocked(const framework::Tensor &filter, int groups,
+                           framework::DataLayout layout,
+                           framework::Tensor *packed_filter);
+
+// the conv of a blocked input with a filter packed by PackConvFilterBlocked,
+// the output is multiplied by scale, added by bias and passed through relu,
+// scale and bias have one value per output channel and may be nullptr
+void ConvBlocked(const framework::Tensor &input,
+                 const framework::Tensor &packed_filter, int groups,
+                 const std::vector<int> &strides,
+                 const std::vector<int> &paddings,
+                 const std::vector<int> &dilations, const float *scale,
+                 const float *bias, bool relu, framework::Tensor *output);
+
+template <PoolingType P>
+void PoolBlocked(const framework::Tensor &input,
+                 const std::vector<int> &kernel_size,
+                 const std::vector<int> &strides,
+                 const std::vector<int> &paddings, framework::Tensor *output);
+
+// y = x * scale + bias for every channel, scale may be nullptr
+void ScaleBiasBlocked(const framework::Tensor &input, const float *scale,
+                      const float *bias, bool relu,
+                      framework::Tensor *output);
+
+// y = x0 + x1 of two blocked tensors with the same dims
+void AddBlocked(const framework::Tensor &input0,
+                const framework::Tensor &input1, framework::Tensor *output);
+
+// concatenates blocked inputs along the channels, the channels of all inputs
+// but the last one must be a multiple of the block
+void ConcatBlocked(const std::vector<const framework::Tensor *> &inputs,
+                   framework::Tensor *output);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
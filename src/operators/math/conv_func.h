@@ -18,6 +18,7 @@ limitations under the License. */
 #include <arm_neon.h>
 #endif
 
+#include "common/threadpool.h"
 #include "framework/ddim.h"
 #include "framework/tensor.h"
 
@@ -98,6 +99,24 @@ inline bool IsExpand(const std::vector<int64_t> &filter_dim,
   return !(filter_1 && strides_1 && padding_0 && dilation_1);
 }
 
+// 3x3 depthwise 卷积有专门的实现, 不需要预打包 gemm 权重
+inline bool IsDepthwise3x3(const Tensor *input, const Tensor *filter,
+                           const Tensor *output, int groups) {
+  return groups == input->dims()[1] && input->dims()[1] == output->dims()[1] &&
+         filter->dims()[2] == filter->dims()[3] && filter->dims()[2] == 3;
+}
+
+// 单张图片的输出不超过 16x16 时, 图片内的并行度不足以用满所有线程
+static const int kSmallImageSize = 16 * 16;
+
+// batch 中的图片数不少于线程数, 或者单张图片很小时按图片并行,
+// 此时每张图片的计算 (包括其中的 gemm) 都只在一个线程上完成
+inline bool ParallelOverBatch(int batch_size, int64_t image_size) {
+  const int threads = ThreadPool::Instance()->ThreadNum();
+  return batch_size > 1 && threads > 1 &&
+         (batch_size >= threads || image_size <= kSmallImageSize);
+}
+
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle_mobile
@@ -0,0 +1,97 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "operators/math/conv_tuner.h"
+#include <cstdio>
+#include "common/log.h"
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+ConvTuner *ConvTuner::Instance() {
+  static ConvTuner tuner;
+  return &tuner;
+}
+
+void ConvTuner::EnableTuning(const std::string &profile) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (enabled_ && profile_ == profile) {
+    return;
+  }
+  enabled_ = true;
+  profile_ = profile;
+  LoadProfile();
+}
+
+bool ConvTuner::Enabled() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return enabled_;
+}
+
+std::string ConvTuner::Algorithm(const std::vector<int> &key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = algorithms_.find(key);
+  return iter == algorithms_.end() ? "" : iter->second;
+}
+
+void ConvTuner::Record(const std::vector<int> &key,
+                       const std::string &algorithm) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  algorithms_[key] = algorithm;
+  SaveProfile();
+}
+
+// one shape per line: key size, key values, algorithm
+void ConvTuner::LoadProfile() {
+  FILE *file = fopen(profile_.c_str(), "r");
+  if (file == nullptr) {
+    return;
+  }
+  int size = 0;
+  while (fscanf(file, "%d", &size) == 1 && size > 0) {
+    std::vector<int> key(size);
+    bool valid = true;
+    for (int i = 0; i < size && valid; ++i) {
+      valid = fscanf(file, "%d", &key[i]) == 1;
+    }
+    char algorithm[64];
+    if (!valid || fscanf(file, "%63s", algorithm) != 1) {
+      break;
+    }
+    algorithms_[key] = algorithm;
+  }
+  fclose(file);
+  DLOG << "load " << algorithms_.size() << " conv shapes from " << profile_;
+}
+
+void ConvTuner::SaveProfile() const {
+  FILE *file = fopen(profile_.c_str(), "w");
+  if (file == nullptr) {
+    LOG(kLOG_WARNING) << "can not write conv tuning profile " << profile_;
+    return;
+  }
+  for (const auto &iter : algorithms_) {
+    fprintf(file, "%d", static_cast<int>(iter.first.size()));
+    for (int value : iter.first) {
+      fprintf(file, " %d", value);
+    }
+    fprintf(file, " %s\n", iter.second.c_str());
+  }
+  fclose(file);
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
@@ -0,0 +1,58 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+// ConvTuner keeps the convolution algorithm chosen for every conv shape. A
+// conv kernel times its valid algorithms at Init the first time a shape is
+// seen and records the fastest, the records are kept in a profile file so
+// that later processes on the same device reuse them without timing.
+class ConvTuner {
+ public:
+  static ConvTuner *Instance();
+
+  // start tuning unseen shapes, previous records are loaded from profile if
+  // it exists and new records are written back to it
+  void EnableTuning(const std::string &profile);
+
+  bool Enabled();
+
+  // the algorithm recorded for the conv shape key, empty if it is not tuned
+  std::string Algorithm(const std::vector<int> &key);
+
+  void Record(const std::vector<int> &key, const std::string &algorithm);
+
+ private:
+  ConvTuner() {}
+  void LoadProfile();
+  void SaveProfile() const;
+
+  std::mutex mutex_;
+  bool enabled_ = false;
+  std::string profile_;
+  std::map<std::vector<int>, std::string> algorithms_;
+};
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
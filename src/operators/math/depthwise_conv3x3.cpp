@@ -14,14 +14,174 @@ limitations under the License. */
 
 #include "operators/math/depthwise_conv3x3.h"
 #include <vector>
+#include "common/threadpool.h"
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif
+#include "operators/math/math_func_avx.h"
 
 namespace paddle_mobile {
 namespace operators {
 namespace math {
 
+#if !__ARM_NEON
+namespace {
+
+#if defined(__x86_64__) || defined(__i386__)
+// 一行输出中输入列全部有效的部分, 每次计算 8 个输出, 返回下一个未计算的位置
+template <int Stride>
+AVX2_TARGET int DepthwiseConv3x3RowAvx2(const float *const rows[3],
+                                        const float *filter, int padding,
+                                        int input_w, int ow, int ow_end,
+                                        float scale, float bias, bool relu,
+                                        float *output) {
+  __m256 f[9];
+  for (int i = 0; i < 9; ++i) {
+    f[i] = _mm256_set1_ps(filter[i]);
+  }
+  const __m256 __scale = _mm256_set1_ps(scale);
+  const __m256 __bias = _mm256_set1_ps(bias);
+  const __m256 __zero = _mm256_setzero_ps();
+  for (; ow + 8 <= ow_end; ow += 8) {
+    const int iw = ow * Stride - padding;
+    // 步长为 2 时多读 2 个 float
+    if (Stride == 2 && iw + 18 > input_w) {
+      break;
+    }
+    __m256 acc = _mm256_setzero_ps();
+    for (int r = 0; r < 3; ++r) {
+      const float *in = rows[r] + iw;
+      __m256 x0, x1, x2;
+      if (Stride == 1) {
+        x0 = _mm256_loadu_ps(in);
+        x1 = _mm256_loadu_ps(in + 1);
+        x2 = _mm256_loadu_ps(in + 2);
+      } else {
+        __m256 unused;
+        deinterleave256_ps(_mm256_loadu_ps(in), _mm256_loadu_ps(in + 8), &x0,
+                           &x1);
+        deinterleave256_ps(_mm256_loadu_ps(in + 2), _mm256_loadu_ps(in + 10),
+                           &x2, &unused);
+      }
+      acc = _mm256_fmadd_ps(x0, f[3 * r], acc);
+      acc = _mm256_fmadd_ps(x1, f[3 * r + 1], acc);
+      acc = _mm256_fmadd_ps(x2, f[3 * r + 2], acc);
+    }
+    acc = _mm256_fmadd_ps(acc, __scale, __bias);
+    if (relu) {
+      acc = _mm256_max_ps(acc, __zero);
+    }
+    _mm256_storeu_ps(output + ow, acc);
+  }
+  return ow;
+}
+#endif  // __x86_64__
+
+// 没有 NEON 时的 3x3 depthwise 卷积, output = conv(input) * scale + bias,
+// 越界的输入行指向 zero_row
+template <int Stride>
+void DepthwiseConv3x3Channel(const float *input, const float *filter,
+                             int input_h, int input_w, int padding,
+                             float scale, float bias, bool relu,
+                             const float *zero_row, int output_h, int output_w,
+                             float *output) {
+  // 输入列全部有效的输出区间 [valid_w_start, valid_w_end)
+  const int valid_w_start =
+      std::min((padding + Stride - 1) / Stride, output_w);
+  const int valid_w_end =
+      input_w + padding < 3
+          ? valid_w_start
+          : std::max(std::min((input_w + padding - 3) / Stride + 1, output_w),
+                     valid_w_start);
+  auto border = [&](const float *const rows[3], int ow) {
+    const int iw = ow * Stride - padding;
+    float acc = 0.f;
+    for (int r = 0; r < 3; ++r) {
+      for (int k = 0; k < 3; ++k) {
+        if (iw + k >= 0 && iw + k < input_w) {
+          acc += rows[r][iw + k] * filter[3 * r + k];
+        }
+      }
+    }
+    return acc;
+  };
+  for (int oh = 0; oh < output_h; ++oh) {
+    const int ih = oh * Stride - padding;
+    const float *rows[3];
+    for (int r = 0; r < 3; ++r) {
+      const bool valid = ih + r >= 0 && ih + r < input_h;
+      rows[r] = valid ? input + (ih + r) * input_w : zero_row;
+    }
+    float *out = output + oh * output_w;
+    for (int ow = 0; ow < valid_w_start; ++ow) {
+      out[ow] = border(rows, ow) * scale + bias;
+    }
+    int ow = valid_w_start;
+#if defined(__x86_64__) || defined(__i386__)
+    if (HasAvx2()) {
+      ow = DepthwiseConv3x3RowAvx2<Stride>(rows, filter, padding, input_w, ow,
+                                           valid_w_end, scale, bias, relu,
+                                           out);
+    }
+#endif  // __x86_64__
+    for (; ow < valid_w_end; ++ow) {
+      const int iw = ow * Stride - padding;
+      float acc = 0.f;
+      for (int r = 0; r < 3; ++r) {
+        acc += rows[r][iw] * filter[3 * r] +
+               rows[r][iw + 1] * filter[3 * r + 1] +
+               rows[r][iw + 2] * filter[3 * r + 2];
+      }
+      out[ow] = acc * scale + bias;
+    }
+    for (ow = valid_w_end; ow < output_w; ++ow) {
+      out[ow] = border(rows, ow) * scale + bias;
+    }
+    if (relu) {
+      for (ow = 0; ow < output_w; ++ow) {
+        out[ow] = std::max(out[ow], 0.f);
+      }
+    }
+  }
+}
+
+// scale 和 bias 为空时分别按 1 和 0 处理
+void DepthwiseConv3x3Generic(const framework::Tensor *input,
+                             const framework::Tensor *filter,
+                             framework::Tensor *output, int stride,
+                             int padding, const float *scale,
+                             const float *bias, bool if_relu) {
+  const int channels = static_cast<int>(input->dims()[1]);
+  const int input_h = static_cast<int>(input->dims()[2]);
+  const int input_w = static_cast<int>(input->dims()[3]);
+  const int output_h = static_cast<int>(output->dims()[2]);
+  const int output_w = static_cast<int>(output->dims()[3]);
+  const float *input_data = input->data<float>();
+  const float *filter_data = filter->data<float>();
+  float *output_data = output->mutable_data<float>();
+  const std::vector<float> zero_row(input_w, 0.f);
+
+  parallel_for(0, input->dims()[0] * channels, [&](int index) {
+    const int c = index % channels;
+    const float *in = input_data + index * input_h * input_w;
+    float *out = output_data + index * output_h * output_w;
+    const float s = scale == nullptr ? 1.f : scale[c];
+    const float b = bias == nullptr ? 0.f : bias[c];
+    if (stride == 1) {
+      DepthwiseConv3x3Channel<1>(in, filter_data + c * 9, input_h, input_w,
+                                 padding, s, b, if_relu, zero_row.data(),
+                                 output_h, output_w, out);
+    } else {
+      DepthwiseConv3x3Channel<2>(in, filter_data + c * 9, input_h, input_w,
+                                 padding, s, b, if_relu, zero_row.data(),
+                                 output_h, output_w, out);
+    }
+  });
+}
+
+}  // namespace
+#endif  // __ARM_NEON
+
 void DepthwiseConv3x3(const framework::Tensor *input,
                       const std::vector<int> &strides,
                       const std::vector<int> &paddings,
@@ -234,7 +394,16 @@ void DepthwiseConv3x3(const framework::Tensor *input,
                 : "memory", "q0", "q1", "q2", "q3", "q4", "q5", "q6");
 #endif  // __aarch64__
 #else
-
+            result = 0;
+            for (int j = 0; j < 3; ++j) {
+              result += pos1[j] * filter1[j] + pos2[j] * filter2[j] +
+                        pos3[j] * filter3[j];
+            }
+            if (if_bias) {
+              output_data[ph * output_width + pw] += result;
+            } else {
+              output_data[ph * output_width + pw] = result;
+            }
 #endif  // __ARM_NEON
           }
         }
@@ -273,8 +442,7 @@ void DepthwiseConv3x3s1p1(const framework::Tensor *input,
   float32x4_t zero = vdupq_n_f32(0.0);
 
   for (int b = 0; b < batch_size; ++b) {
-#pragma omp parallel for
-    for (int j = 0; j < c; ++j) {
+    parallel_for(0, c, [&](int j) {
       const float *filter_data_tmp = filter->data<float>() + j * 9;
       const float *input_data = input->data<float>() + j * hxw;
       float *output_data = output->mutable_data<float>() + j * hxw;
@@ -550,9 +718,12 @@ void DepthwiseConv3x3s1p1(const framework::Tensor *input,
           }
         }
       }
-    }
+    });
   }
-#endif
+#else
+  DepthwiseConv3x3Generic(input, filter, output, 1, 1, nullptr,
+                          if_bias ? bias->data<float>() : nullptr, if_relu);
+#endif  // __ARM_NEON
 }
 
 void DepthwiseConvAddBNRelu3x3s1p1(const framework::Tensor *input,
@@ -584,8 +755,7 @@ void DepthwiseConvAddBNRelu3x3s1p1(const framework::Tensor *input,
   float32x4_t vzero = vdupq_n_f32(0);
 
   for (int b = 0; b < batch_size; b++) {
-#pragma omp parallel for
-    for (int c = 0; c < input_channel; c++) {
+    parallel_for(0, input_channel, [&](int c) {
       const float *filter_data = filter->data<float>() + c * 9;
       const float *input_data = input->data<float>() + c * hxw;
       float *output_data = output->data<float>() + c * hxw;
@@ -803,7 +973,7 @@ void DepthwiseConvAddBNRelu3x3s1p1(const framework::Tensor *input,
                   : output_data[(output_height - 1) * output_width + j];
         }
       }
-    }
+    });
   }
 
     /*
@@ -1096,7 +1266,10 @@ void DepthwiseConvAddBNRelu3x3s1p1(const framework::Tensor *input,
         }
     */
 
-#endif
+#else
+  DepthwiseConv3x3Generic(input, filter, output, 1, 1, new_scale->data<float>(),
+                          new_bias->data<float>(), if_relu);
+#endif  // __ARM_NEON
 }
 
 /// w!=h not fix
@@ -1299,7 +1472,10 @@ void DepthwiseConvAddBNRelu3x3s2p1(const framework::Tensor *input,
     input_data += input_batch_stride;
     output_data += output_batch_stride;
   }
-#endif
+#else
+  DepthwiseConv3x3Generic(input, filter, output, 2, 1, new_scale->data<float>(),
+                          new_bias->data<float>(), if_relu);
+#endif  // __ARM_NEON
 }
 
 void DepthwiseConv3x3s2p1v2(const framework::Tensor *input,
@@ -1535,7 +1711,10 @@ void DepthwiseConv3x3s2p1v2(const framework::Tensor *input,
     input_data += inhxw * c;
     output_data += outhxw * c;
   }
-#endif
+#else
+  DepthwiseConv3x3Generic(input, filter, output, 2, 1, nullptr,
+                          if_bias ? bias->data<float>() : nullptr, if_relu);
+#endif  // __ARM_NEON
 }
 
 void DepthwiseConvAddBNRelu3x3s2p1v2(const framework::Tensor *input,
@@ -1749,8 +1928,7 @@ void DepthwiseConvAddBNRelu3x3s2p1v2(const framework::Tensor *input,
   const int w_times = (out_w - 2) / 3;
   float32x4_t zero = vdupq_n_f32(0.0);
   for (int b = batch_size; b > 0; --b) {
-#pragma omp parallel for
-    for (int j = 0; j < c; j++) {
+    parallel_for(0, c, [&](int j) {
       const float *input_row_ptr;
       float *output_row_ptr;
       float32x4x2_t input_buff_mid{}, input_buff_bottom[w_times + 1];
@@ -1956,12 +2134,15 @@ void DepthwiseConvAddBNRelu3x3s2p1v2(const framework::Tensor *input,
                   : output_data_tmp[i * out_w + out_w - 1];
         }
       }
-    }
+    });
     input_data += inhxw * c;
     output_data += outhxw * c;
   }
 // #endif
-#endif
+#else
+  DepthwiseConv3x3Generic(input, filter, output, 2, 1, new_scale->data<float>(),
+                          new_bias->data<float>(), if_relu);
+#endif  // __ARM_NEON
 }
 
 void DepthwiseConv3x3s2p0(const framework::Tensor *input,
@@ -1982,8 +2163,7 @@ void DepthwiseConv3x3s2p0(const framework::Tensor *input,
 
   float32x4_t zero = vdupq_n_f32(0.0);
   for (int b = 0; b < batch_size; b++) {
-#pragma omp parallel for
-    for (int c = 0; c < input_channel; c++) {
+    parallel_for(0, input_channel, [&](int c) {
       const float *filter_data = filter->data<float>() + c * 9;
       const float *input_data = input->data<float>() + c * inhxw;
       const float *bias_data;
@@ -2070,10 +2250,13 @@ void DepthwiseConv3x3s2p0(const framework::Tensor *input,
           }
         }
       }
-    }
+    });
   }
 
-#endif
+#else
+  DepthwiseConv3x3Generic(input, filter, output, 2, 0, nullptr,
+                          if_bias ? bias->data<float>() : nullptr, if_relu);
+#endif  // __ARM_NEON
 }
 
 }  // namespace math
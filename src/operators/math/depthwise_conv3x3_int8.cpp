@@ -15,6 +15,7 @@ limitations under the License. */
 #if defined(__ARM_NEON__) && !defined(__aarch64__)
 
 #include <arm_neon.h>
+#include "common/threadpool.h"
 #include "operators/math/depthwise_conv3x3.h"
 
 namespace paddle_mobile {
@@ -133,8 +134,7 @@ void DepthwiseConv3x3S1<int8_t, int32_t>(const framework::Tensor &input,
   int valid_w_end = output_w - valid_w_start;
   int valid_w = valid_w_end - valid_w_start;
 
-  #pragma omp parallel for
-  for (int g = 0; g < input.dims()[1]; ++g) {
+  parallel_for(0, input.dims()[1], [&](int g) {
     const int8_t *input_ptr = input_data + g * image_size;
     const int8_t *filter_ptr = filter_data + g * 9;
     int32_t *output_ptr = out_data + g * out_image_size;
@@ -1026,7 +1026,7 @@ void DepthwiseConv3x3S1<int8_t, int32_t>(const framework::Tensor &input,
                                       input_w, padding_h, padding_w, output_w,
                                       output_ptr, _ker);
     }
-  }
+  });
 }
 
 template <>
@@ -1059,8 +1059,7 @@ void DepthwiseConv3x3S2<int8_t, int32_t>(const framework::Tensor &input,
   //  DLOG << "valid_w_start: " << valid_w_start;
   //  DLOG << "valid_w_end: " << valid_w_end;
 
-  #pragma omp parallel for
-  for (int g = 0; g < input.dims()[1]; ++g) {
+  parallel_for(0, input.dims()[1], [&](int g) {
     const int8_t *input_ptr = input_data + g * image_size;
     const int8_t *filter_ptr = filter_data + g * 9;
     int32_t *output_ptr = out_data + g * out_image_size;
@@ -1638,7 +1637,7 @@ void DepthwiseConv3x3S2<int8_t, int32_t>(const framework::Tensor &input,
                                       input_w, padding_h, padding_w, output_w,
                                       output_ptr, _ker);
     }
-  }
+  });
 }
 
 }  // namespace math
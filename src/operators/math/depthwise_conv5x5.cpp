@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include "operators/math/depthwise_conv5x5.h"
 #include <arm_neon.h>
+#include "common/threadpool.h"
 
 namespace paddle_mobile {
 namespace operators {
@@ -159,8 +160,7 @@ void DepthwiseConv5x5S1<float, float>(const framework::Tensor &input,
   int valid_w_end = output_w - valid_w_start;
   int valid_w = valid_w_end - valid_w_start;
 
-  #pragma omp parallel for
-  for (int g = 0; g < input.dims()[1]; ++g) {
+  parallel_for(0, input.dims()[1], [&](int g) {
     const float *input_ptr = input_data + g * image_size;
     const float *filter_ptr = filter_data + g * 25;
     float *output_ptr = out_data + g * out_image_size;
@@ -721,7 +721,7 @@ void DepthwiseConv5x5S1<float, float>(const framework::Tensor &input,
                                       input_w, padding_h, padding_w, output_w,
                                       output_ptr, _ker, _ker1);
     }
-  }
+  });
 }
 
 template <>
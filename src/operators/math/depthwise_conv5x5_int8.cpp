@@ -15,6 +15,7 @@ limitations under the License. */
 #if defined(__ARM_NEON__) && !defined(__aarch64__)
 
 #include <arm_neon.h>
+#include "common/threadpool.h"
 #include "operators/math/depthwise_conv5x5.h"
 
 namespace paddle_mobile {
@@ -161,8 +162,7 @@ void DepthwiseConv5x5S1<int8_t, int32_t>(const framework::Tensor &input,
   int valid_w_end = output_w - valid_w_start;
   int valid_w = valid_w_end - valid_w_start;
 
-  #pragma omp parallel for
-  for (int g = 0; g < input.dims()[1]; ++g) {
+  parallel_for(0, input.dims()[1], [&](int g) {
     const int8_t *input_ptr = input_data + g * image_size;
     const int8_t *filter_ptr = filter_data + g * 25;
     int32_t *output_ptr = out_data + g * out_image_size;
@@ -1025,7 +1025,7 @@ void DepthwiseConv5x5S1<int8_t, int32_t>(const framework::Tensor &input,
                                       input_w, padding_h, padding_w, output_w,
                                       output_ptr, _ker, kernel);
     }
-  }
+  });
 }
 
 template <>
@@ -14,14 +14,16 @@ limitations under the License. */
 
 #include "operators/math/gemm.h"
 #include <string.h>
+#include <algorithm>
 #include "common/log.h"
-#include "memory/t_malloc.h"
+#include "framework/workspace.h"
+#include "operators/math/gemm_epilogue.h"
+#include "operators/math/gemm_tuner.h"
+#include "operators/math/half_convert.h"
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include "operators/math/math_func_avx.h"
 
 namespace paddle_mobile {
 namespace operators {
@@ -31,7 +33,7 @@ namespace math {
 void Gemm::PackMatrixA_4r(int m, int k, int m_tail, const float *A, int lda,
                           float *buffer) {
   const float *a0, *a1, *a2, *a3;
-  for (int i = 0; i < m - m_tail; i += MR) {
+  for (int i = 0; i < m - m_tail; i += 4) {
     a0 = A + i * lda;
     a1 = A + (i + 1) * lda;
     a2 = A + (i + 2) * lda;
@@ -126,8 +128,8 @@ void Gemm::PackMatrixA_6r(int m, int k, int m_tail, const float *A, int lda,
 void Gemm::PackMatrixA_omp_6r(int m, int k, int m_tail, const float *A, int lda,
                               float *buffer) {
   const int i_length = m - m_tail;
-#pragma omp parallel for
-  for (int i = 0; i < i_length; i += MR) {
+  parallel_for(0, (i_length + MR - 1) / MR, [&](int ib) {
+    int i = ib * MR;
     const float *a0 = A + i * lda;
     const float *a1 = A + (i + 1) * lda;
     const float *a2 = A + (i + 2) * lda;
@@ -143,7 +145,7 @@ void Gemm::PackMatrixA_omp_6r(int m, int k, int m_tail, const float *A, int lda,
       *local_buffer++ = *a4++;
       *local_buffer++ = *a5++;
     }
-  }
+  });
   if (m_tail != 0) {
     const float *a0 = &A(i_length, 0);
     const float *a1 = a0 + lda;
@@ -181,7 +183,7 @@ void Gemm::PackMatrixA_omp_6r(int m, int k, int m_tail, const float *A, int lda,
 void Gemm::PackMatrixA_8r(int m, int k, int m_tail, const float *A, int lda,
                           float *buffer) {
   const int i_length = m - m_tail;
-  for (int i = 0; i < i_length; i += MR) {
+  for (int i = 0; i < i_length; i += 8) {
     const float *a0 = A + i * lda;
     const float *a1 = A + (i + 1) * lda;
     const float *a2 = A + (i + 2) * lda;
@@ -247,8 +249,8 @@ void Gemm::PackMatrixA_8r(int m, int k, int m_tail, const float *A, int lda,
 void Gemm::PackMatrixA_omp_8r(int m, int k, int m_tail, const float *A, int lda,
                               float *buffer) {
   const int i_length = m - m_tail;
-#pragma omp parallel for
-  for (int i = 0; i < i_length; i += MR) {
+  parallel_for(0, (i_length + 7) / 8, [&](int ib) {
+    int i = ib * 8;
     const float *a0 = A + i * lda;
     const float *a1 = A + (i + 1) * lda;
     const float *a2 = A + (i + 2) * lda;
@@ -268,7 +270,7 @@ void Gemm::PackMatrixA_omp_8r(int m, int k, int m_tail, const float *A, int lda,
       *local_buffer++ = *a6++;
       *local_buffer++ = *a7++;
     }
-  }
+  });
   if (m_tail != 0) {
     const float *a0 = &A(i_length, 0);
     const float *a1 = a0 + lda;
@@ -363,11 +365,64 @@ void Gemm::PackMatrixB_8c(int k, int n, int n_tail, const float *B, int ldb,
   }
 }
 
+// 与 PackMatrixB_8c 的布局相同, 每行 NR 个数依次为各输出像素在该卷积核
+// 位置上的输入. NR 个输出像素在同一输出行时, 不越界的行按 stride 直接复制
+void Gemm::PackMatrixB_im2col(int k, int j, int n, const Im2ColGeometry &geo,
+                              float *buffer) {
+  int ih0[NR];
+  int iw0[NR];
+  for (int jj = 0; jj < n; ++jj) {
+    int oh = (j + jj) / geo.output_w;
+    int ow = (j + jj) % geo.output_w;
+    ih0[jj] = oh * geo.stride_h - geo.pad_h;
+    iw0[jj] = ow * geo.stride_w - geo.pad_w;
+  }
+  const bool same_row = n == NR && ih0[0] == ih0[NR - 1];
+  const int stride_w = geo.stride_w;
+  const int plane = geo.height * geo.width;
+  const int channels = k / (geo.kernel_h * geo.kernel_w);
+  const float *in = geo.input;
+  for (int c = 0; c < channels; ++c, in += plane) {
+    for (int ki = 0; ki < geo.kernel_h; ++ki) {
+      int dh = ki * geo.dilation_h;
+      for (int kj = 0; kj < geo.kernel_w; ++kj, buffer += NR) {
+        int dw = kj * geo.dilation_w;
+        if (same_row) {
+          int ih = ih0[0] + dh;
+          int iw = iw0[0] + dw;
+          if (ih >= 0 && ih < geo.height && iw >= 0 &&
+              iw0[NR - 1] + dw < geo.width) {
+            const float *row = in + ih * geo.width + iw;
+            if (stride_w == 1) {
+              memcpy(buffer, row, NR * sizeof(float));
+            } else {
+              for (int jj = 0; jj < NR; ++jj) {
+                buffer[jj] = row[jj * stride_w];
+              }
+            }
+            continue;
+          }
+        }
+        for (int jj = 0; jj < n; ++jj) {
+          int ih = ih0[jj] + dh;
+          int iw = iw0[jj] + dw;
+          bool inside =
+              ih >= 0 && ih < geo.height && iw >= 0 && iw < geo.width;
+          buffer[jj] = inside ? in[ih * geo.width + iw] : 0.f;
+        }
+        for (int jj = n; jj < NR; ++jj) {
+          buffer[jj] = 0.f;
+        }
+      }
+    }
+  }
+}
+
 void Gemm::PackMatrixB_omp_8c(int k, int n, int n_tail, const float *B, int ldb,
                               float *buffer) {
   const int j_length = n - n_tail;
-#pragma omp parallel for
-  for (int j = 0; j < j_length; j += NR) {
+  parallel_for(0, (j_length + NR - 1) / NR, [&](int jb) {
+    int j = jb * NR;
     float *local_buffer = buffer + j * k;
     for (int i = 0; i < k; ++i) {
       const float *b0 = &B(i, j);
@@ -400,7 +455,7 @@ void Gemm::PackMatrixB_omp_8c(int k, int n, int n_tail, const float *B, int ldb,
       *local_buffer++ = *b0++;
 #endif  // __ARM_NEON
     }
-  }
+  });
   if (n_tail != 0) {
     float *local_buffer = buffer + j_length * k;
     for (int i = 0; i < k; ++i) {
@@ -420,7 +475,7 @@ void Gemm::PackMatrixB_omp_8c(int k, int n, int n_tail, const float *B, int ldb,
 void Gemm::PackMatrixB_12c(int k, int n, int n_tail, const float *B, int ldb,
                            float *buffer) {
   const int j_length = n - n_tail;
-  for (int j = 0; j < j_length; j += NR) {
+  for (int j = 0; j < j_length; j += 12) {
     float *local_buffer = buffer + j * k;
     for (int i = 0; i < k; ++i) {
       const float *b0 = &B(i, j);
@@ -440,7 +495,7 @@ void Gemm::PackMatrixB_12c(int k, int n, int n_tail, const float *B, int ldb,
       for (int j = j_length; j < n; ++j) {
         *local_buffer++ = *b0++;
       }
-      for (int j = n; j < j_length + NR; ++j) {
+      for (int j = n; j < j_length + 12; ++j) {
         *local_buffer++ = 0;
       }
     }
@@ -450,8 +505,8 @@ void Gemm::PackMatrixB_12c(int k, int n, int n_tail, const float *B, int ldb,
 void Gemm::PackMatrixB_omp_12c(int k, int n, int n_tail, const float *B,
                                int ldb, float *buffer) {
   const int j_length = n - n_tail;
-#pragma omp parallel for
-  for (int j = 0; j < j_length; j += NR) {
+  parallel_for(0, (j_length + 11) / 12, [&](int jb) {
+    int j = jb * 12;
     float *local_buffer = buffer + j * k;
     for (int i = 0; i < k; ++i) {
       const float *b0 = &B(i, j);
@@ -463,7 +518,7 @@ void Gemm::PackMatrixB_omp_12c(int k, int n, int n_tail, const float *B,
           : [b0] "r"(b0)
           : "memory", "v0", "v1", "v2");
     }
-  }
+  });
   if (n_tail != 0) {
     float *local_buffer = buffer + j_length * k;
     for (int i = 0; i < k; ++i) {
@@ -471,7 +526,7 @@ void Gemm::PackMatrixB_omp_12c(int k, int n, int n_tail, const float *B,
       for (int j = j_length; j < n; ++j) {
         *local_buffer++ = *b0++;
       }
-      for (int j = n; j < j_length + NR; ++j) {
+      for (int j = n; j < j_length + 12; ++j) {
         *local_buffer++ = 0;
       }
     }
@@ -511,8 +566,8 @@ void Gemm::PackMatrixB_16c(int k, int n, int n_tail, const float *B, int ldb,
 void Gemm::PackMatrixB_omp_16c(int k, int n, int n_tail, const float *B,
                                int ldb, float *buffer) {
   const int j_length = n - n_tail;
-#pragma omp parallel for
-  for (int j = 0; j < n - n_tail; j += NR) {
+  parallel_for(0, (n - n_tail + NR - 1) / NR, [&](int jb) {
+    int j = jb * NR;
     float *local_buffer = buffer + j * k;
     for (int i = 0; i < k; ++i) {
       const float *b0 = &B(i, j);
@@ -524,7 +579,7 @@ void Gemm::PackMatrixB_omp_16c(int k, int n, int n_tail, const float *B,
           : [b0] "r"(b0)
           : "memory", "v0", "v1", "v2", "v3");
     }
-  }
+  });
   if (n_tail != 0) {
     float *local_buffer = buffer + j_length * k;
     for (int i = 0; i < k; ++i) {
@@ -541,151 +596,454 @@ void Gemm::PackMatrixB_omp_16c(int k, int n, int n_tail, const float *B,
 #endif  // __aarch64__
 #endif  // __ARM_NEON
 
-// 分块矩阵乘法
+// 分块矩阵乘法, relu 时对结果做 relu
+// beta 为 1 时 C = alpha * A * B + C, 为 0 时 C = alpha * A * B
 void Gemm::InnerKernel(int mc, int nc, float alpha, const float *a,
                        const float *b, float beta, float *c, float *C, int ldc,
                        bool relu) {
-#pragma omp parallel for
-  for (int j = 0; j < nc; j += NR) {
-    for (int i = 0; i < mc; i += MR) {
-#if __aarch64__
-      // AddDot8x12(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      AddDot6x16(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-#else
-      // AddDot4x4(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      // AddDot4x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      AddDot6x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-#endif
-    }
-  }
-
-  if (alpha != 1) {
-    WriteWithAlphaBeta(mc, nc, c, C, ldc);
-    return;
-  }
-  if (beta == 0) {
-    WriteBasic(mc, nc, c, C, ldc);
-    return;
-  }
-  if (beta == 1 && !relu) {
-    WriteWithAdd(mc, nc, c, C, ldc);
-    return;
-  }
-  if (beta == 1 && relu) {
-    WriteWithAddRelu(mc, nc, c, C, ldc);
-    return;
-  }
+  InnerKernelWithBias(mc, nc, alpha, a, b, beta, c, C, ldc, relu, nullptr);
 }
 
-// 分块矩阵乘法
+// 分块矩阵乘法, bias 不为空时 C = alpha * A * B + bias, 不再加上 C
 void Gemm::InnerKernelWithBias(int mc, int nc, float alpha, const float *a,
                                const float *b, float beta, float *c, float *C,
                                int ldc, bool relu, float *bias) {
-#pragma omp parallel for
-  for (int j = 0; j < nc; j += NR) {
-    for (int i = 0; i < mc; i += MR) {
-#if __aarch64__
-      // AddDot8x12(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      AddDot6x16(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-#else
-      // AddDot4x4(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      // AddDot4x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      AddDot6x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-#endif
-    }
-  }
-
+  const epilogue::Scale scale{alpha};
+  const epilogue::RowBias row_bias{bias};
+  const epilogue::Residual accumulate{C, ldc};
+  const epilogue::Activation<RELU> act{};
   if (alpha != 1) {
-    WriteWithAlphaBeta(mc, nc, c, C, ldc);
-    return;
-  }
-  if (beta == 0) {
-    WriteBasic(mc, nc, c, C, ldc);
-    return;
-  }
-  if (beta == 1 && !relu) {
-    if (bias == nullptr) {
-      WriteWithAdd(mc, nc, c, C, ldc);
+    if (bias != nullptr) {
+      InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc,
+                              MakeEpilogue(scale, row_bias));
+    } else if (beta == 1) {
+      InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc,
+                              MakeEpilogue(scale, accumulate));
     } else {
-      WriteWithAddV1(mc, nc, c, C, ldc, bias);
+      InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc, MakeEpilogue(scale));
     }
-    return;
-  }
-  if (beta == 1 && relu) {
-    if (bias == nullptr) {
-      WriteWithAddRelu(mc, nc, c, C, ldc);
+  } else if (bias != nullptr) {
+    if (relu) {
+      InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc,
+                              MakeEpilogue(row_bias, act));
     } else {
-      WriteWithAddReluV1(mc, nc, c, C, ldc, bias);
+      InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc,
+                              MakeEpilogue(row_bias));
     }
-    return;
+  } else if (beta == 1) {
+    if (relu) {
+      InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc,
+                              MakeEpilogue(accumulate, act));
+    } else {
+      InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc,
+                              MakeEpilogue(accumulate));
+    }
+  } else if (relu) {
+    InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc, MakeEpilogue(act));
+  } else {
+    InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc, MakeEpilogue());
   }
 }
 
-// 分块矩阵乘法
+// 分块矩阵乘法, C = A * B * new_scale + new_bias
 void Gemm::InnerKernelWithBn(int mc, int nc, float alpha, const float *a,
                              const float *b, float beta, float *c, float *C,
                              int ldc, bool relu, float *new_scale,
                              float *new_bias) {
-#pragma omp parallel for
-  for (int j = 0; j < nc; j += NR) {
-    for (int i = 0; i < mc; i += MR) {
-#if __aarch64__
-      // AddDot8x12(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      AddDot6x16(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-#else
-      // AddDot4x4(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      // AddDot4x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      AddDot6x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-#endif
-    }
-  }
-
+  const epilogue::RowScaleShift bn{new_scale, new_bias};
   if (relu) {
-    WriteWithBnRelu(mc, nc, c, C, ldc, new_scale, new_bias);
+    InnerKernelWithEpilogue(
+        mc, nc, a, b, c, C, ldc,
+        MakeEpilogue(bn, epilogue::Activation<RELU>()));
   } else {
-    WriteWithBn(mc, nc, c, C, ldc, new_scale, new_bias);
+    InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc, MakeEpilogue(bn));
   }
 }
 
-// 分块矩阵乘法
+// 分块矩阵乘法, C = A * B * new_scale + new_bias + bias, bias 的行距为 ldc
 void Gemm::InnerKernelWithBnAdd(int mc, int nc, float alpha, const float *a,
                                 const float *b, float beta, float *c, float *C,
                                 int ldc, bool relu, float *new_scale,
                                 float *new_bias, float *bias) {
-#pragma omp parallel for
-  for (int j = 0; j < nc; j += NR) {
-    for (int i = 0; i < mc; i += MR) {
-#if __aarch64__
-      // AddDot8x12(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      AddDot6x16(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-#else
-      // AddDot4x4(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      // AddDot4x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      AddDot6x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-#endif
-    }
+  const epilogue::RowScaleShift bn{new_scale, new_bias};
+  const epilogue::Residual residual{bias, ldc};
+  if (relu) {
+    InnerKernelWithEpilogue(
+        mc, nc, a, b, c, C, ldc,
+        MakeEpilogue(bn, residual, epilogue::Activation<RELU>()));
+  } else {
+    InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc,
+                            MakeEpilogue(bn, residual));
   }
-  WriteWithBnAddRelu(mc, nc, c, C, ldc, new_scale, new_bias, bias);
 }
 
+// 分块矩阵乘法, C = prelu(A * B + bias + bias1), 每行一个斜率 p
 void Gemm::InnerKernelWithPRelu(int mc, int nc, const float *a, const float *b,
                                 float *c, float *C, int ldc, float *p,
                                 std::string mode, float *bias, float *bias1) {
-#pragma omp parallel for
-  for (int j = 0; j < nc; j += NR) {
-    for (int i = 0; i < mc; i += MR) {
+  const epilogue::RowBias row_bias{bias};
+  const epilogue::PRelu prelu{p, 1, 0};
+  if (bias1 == nullptr) {
+    InnerKernelWithEpilogue(mc, nc, a, b, c, C, ldc,
+                            MakeEpilogue(row_bias, prelu));
+  } else {
+    InnerKernelWithEpilogue(
+        mc, nc, a, b, c, C, ldc,
+        MakeEpilogue(row_bias, epilogue::Residual{bias1, ldc}, prelu));
+  }
+}
+
+#if __ARM_NEON
+// 常用后处理组合的回写, 见 gemm_epilogue.h. 下面的函数返回已写的列数,
+// 余下不足一组的列由通用的 WriteWithEpilogue 处理
+
+// dst = relu(src * scale[i] + shift[i] + residual), 按模板参数取舍各项.
+// 每行的缩放和偏置只广播一次
+template <bool kScale, bool kShift, bool kResidual, bool kRelu>
+static int WriteRowsNeon(int rows, int cols, const float *src, int src_ld,
+                         float *dst, int dst_ld, const float *scale,
+                         const float *shift, const float *residual,
+                         int residual_ld) {
+  const int cols4 = cols & ~3;
+  const float32x4_t zero = vdupq_n_f32(0.f);
+  for (int i = 0; i < rows; ++i) {
+    const float *src_ptr = src + i * src_ld;
+    const float *res_ptr = kResidual ? residual + i * residual_ld : nullptr;
+    float *dst_ptr = dst + i * dst_ld;
+    const float32x4_t scalev = vdupq_n_f32(kScale ? scale[i] : 1.f);
+    const float32x4_t shiftv = vdupq_n_f32(kShift ? shift[i] : 0.f);
+    for (int j = 0; j < cols4; j += 4) {
+      float32x4_t v = vld1q_f32(src_ptr + j);
+      if (kScale) {
+        v = vmlaq_f32(shiftv, v, scalev);
+      } else if (kShift) {
+        v = vaddq_f32(v, shiftv);
+      }
+      if (kResidual) {
+        v = vaddq_f32(v, vld1q_f32(res_ptr + j));
+      }
+      if (kRelu) {
+        v = vmaxq_f32(v, zero);
+      }
+      vst1q_f32(dst_ptr + j, v);
+    }
+  }
+  return cols4;
+}
+
+#if !__aarch64__
+// armv7 上每行 8 列一组, 与 NR 相同
+
+// dst = src
+static int WriteBasic(int rows, int cols, const float *src, int src_ld,
+                      float *dst, int dst_ld) {
+  int nc1 = cols / 8;
+  if (rows <= 0 || nc1 == 0) {
+    return 0;
+  }
+  int step = 4 * (dst_ld - 8 * nc1);
+  int step1 = 4 * (src_ld - 8 * nc1);
+  asm volatile(
+      "loop_mc_%=:                          \n\t"
+      "mov        r5,   %[nc1]              \n\t"
+      "loop_nc1_%=:                         \n\t"
+
+      "vld1.32    {q8, q9},   [%[src]]!     \n\t"
+      "vst1.32    {q8, q9},   [%[dst]]!     \n\t"
+
+      "subs       r5,   r5,   #1            \n\t"
+      "bne        loop_nc1_%=               \n\t"
+
+      "add        %[dst], %[dst], %[step]   \n\t"
+      "add        %[src], %[src], %[step1]  \n\t"
+      "subs       %[mc], %[mc], #1          \n\t"
+      "bne        loop_mc_%=                \n\t"
+
+      : [src] "+r"(src), [dst] "+r"(dst), [mc] "+r"(rows)
+      : [nc1] "r"(nc1), [step] "r"(step), [step1] "r"(step1)
+      : "cc", "memory", "r5", "q8", "q9");
+  return 8 * nc1;
+}
+
+// dst = src + residual, dst 可以与 residual 相同, 即 C += A * B
+static int WriteWithAdd(int rows, int cols, const float *src, int src_ld,
+                        float *dst, int dst_ld, const float *residual,
+                        int residual_ld) {
+  int nc1 = cols / 8;
+  if (rows <= 0 || nc1 == 0) {
+    return 0;
+  }
+  int step = 4 * (dst_ld - 8 * nc1);
+  int step1 = 4 * (src_ld - 8 * nc1);
+  int step2 = 4 * (residual_ld - 8 * nc1);
+  asm volatile(
+      "loop_mc_%=:                          \n\t"
+      "mov        r5,   %[nc1]              \n\t"
+      "loop_nc1_%=:                         \n\t"
+
+      "vld1.32    {q8, q9},   [%[src]]!     \n\t"
+      "vld1.32    {q10, q11}, [%[res]]!     \n\t"
+      "vadd.f32   q8,   q8,   q10           \n\t"
+      "vadd.f32   q9,   q9,   q11           \n\t"
+      "vst1.32    {q8, q9},   [%[dst]]!     \n\t"
+
+      "subs       r5,   r5,   #1            \n\t"
+      "bne        loop_nc1_%=               \n\t"
+
+      "add        %[dst], %[dst], %[step]   \n\t"
+      "add        %[src], %[src], %[step1]  \n\t"
+      "add        %[res], %[res], %[step2]  \n\t"
+      "subs       %[mc], %[mc], #1          \n\t"
+      "bne        loop_mc_%=                \n\t"
+
+      : [src] "+r"(src), [dst] "+r"(dst), [res] "+r"(residual),
+        [mc] "+r"(rows)
+      : [nc1] "r"(nc1), [step] "r"(step), [step1] "r"(step1),
+        [step2] "r"(step2)
+      : "cc", "memory", "r5", "q8", "q9", "q10", "q11");
+  return 8 * nc1;
+}
+
+// dst = relu(src + residual)
+static int WriteWithAddRelu(int rows, int cols, const float *src, int src_ld,
+                            float *dst, int dst_ld, const float *residual,
+                            int residual_ld) {
+  int nc1 = cols / 8;
+  if (rows <= 0 || nc1 == 0) {
+    return 0;
+  }
+  int step = 4 * (dst_ld - 8 * nc1);
+  int step1 = 4 * (src_ld - 8 * nc1);
+  int step2 = 4 * (residual_ld - 8 * nc1);
+  asm volatile(
+      "vmov.i32   q15,  #0                  \n\t"
+      "loop_mc_%=:                          \n\t"
+      "mov        r5,   %[nc1]              \n\t"
+      "loop_nc1_%=:                         \n\t"
+
+      "vld1.32    {q8, q9},   [%[src]]!     \n\t"
+      "vld1.32    {q10, q11}, [%[res]]!     \n\t"
+      "vadd.f32   q8,   q8,   q10           \n\t"
+      "vadd.f32   q9,   q9,   q11           \n\t"
+      "vmax.f32   q8,   q8,   q15           \n\t"
+      "vmax.f32   q9,   q9,   q15           \n\t"
+      "vst1.32    {q8, q9},   [%[dst]]!     \n\t"
+
+      "subs       r5,   r5,   #1            \n\t"
+      "bne        loop_nc1_%=               \n\t"
+
+      "add        %[dst], %[dst], %[step]   \n\t"
+      "add        %[src], %[src], %[step1]  \n\t"
+      "add        %[res], %[res], %[step2]  \n\t"
+      "subs       %[mc], %[mc], #1          \n\t"
+      "bne        loop_mc_%=                \n\t"
+
+      : [src] "+r"(src), [dst] "+r"(dst), [res] "+r"(residual),
+        [mc] "+r"(rows)
+      : [nc1] "r"(nc1), [step] "r"(step), [step1] "r"(step1),
+        [step2] "r"(step2)
+      : "cc", "memory", "r5", "q8", "q9", "q10", "q11", "q15");
+  return 8 * nc1;
+}
+
+// dst = src * scale[i] + shift[i]
+static int WriteWithBn(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld, const float *scale,
+                       const float *shift) {
+  int nc1 = cols / 8;
+  if (rows <= 0 || nc1 == 0) {
+    return 0;
+  }
+  int step = 4 * (dst_ld - 8 * nc1);
+  int step1 = 4 * (src_ld - 8 * nc1);
+  asm volatile(
+      "loop_mc_%=:                          \n\t"
+      "mov        r5,   %[nc1]              \n\t"
+      "vld1.32    {d0[0]},  [%[scale]]!     \n\t"
+      "vld1.32    {d1[0]},  [%[shift]]!     \n\t"
+      "vdup.32    q14,  d0[0]               \n\t"
+      "vdup.32    q15,  d1[0]               \n\t"
+      "loop_nc1_%=:                         \n\t"
+
+      "vld1.32    {q8, q9},   [%[src]]!     \n\t"
+      "vmov       q10,  q15                 \n\t"
+      "vmov       q11,  q15                 \n\t"
+      "vmla.f32   q10,  q8,   q14           \n\t"
+      "vmla.f32   q11,  q9,   q14           \n\t"
+      "vst1.32    {q10, q11}, [%[dst]]!     \n\t"
+
+      "subs       r5,   r5,   #1            \n\t"
+      "bne        loop_nc1_%=               \n\t"
+
+      "add        %[dst], %[dst], %[step]   \n\t"
+      "add        %[src], %[src], %[step1]  \n\t"
+      "subs       %[mc], %[mc], #1          \n\t"
+      "bne        loop_mc_%=                \n\t"
+
+      : [src] "+r"(src), [dst] "+r"(dst), [mc] "+r"(rows),
+        [scale] "+r"(scale), [shift] "+r"(shift)
+      : [nc1] "r"(nc1), [step] "r"(step), [step1] "r"(step1)
+      : "cc", "memory", "r5", "q0", "q8", "q9", "q10", "q11", "q14", "q15");
+  return 8 * nc1;
+}
+
+// dst = relu(src * scale[i] + shift[i])
+static int WriteWithBnRelu(int rows, int cols, const float *src, int src_ld,
+                           float *dst, int dst_ld, const float *scale,
+                           const float *shift) {
+  int nc1 = cols / 8;
+  if (rows <= 0 || nc1 == 0) {
+    return 0;
+  }
+  int step = 4 * (dst_ld - 8 * nc1);
+  int step1 = 4 * (src_ld - 8 * nc1);
+  asm volatile(
+      "vmov.i32   q13,  #0                  \n\t"
+      "loop_mc_%=:                          \n\t"
+      "mov        r5,   %[nc1]              \n\t"
+      "vld1.32    {d0[0]},  [%[scale]]!     \n\t"
+      "vld1.32    {d1[0]},  [%[shift]]!     \n\t"
+      "vdup.32    q14,  d0[0]               \n\t"
+      "vdup.32    q15,  d1[0]               \n\t"
+      "loop_nc1_%=:                         \n\t"
+
+      "vld1.32    {q8, q9},   [%[src]]!     \n\t"
+      "vmov       q10,  q15                 \n\t"
+      "vmov       q11,  q15                 \n\t"
+      "vmla.f32   q10,  q8,   q14           \n\t"
+      "vmla.f32   q11,  q9,   q14           \n\t"
+      "vmax.f32   q10,  q10,  q13           \n\t"
+      "vmax.f32   q11,  q11,  q13           \n\t"
+      "vst1.32    {q10, q11}, [%[dst]]!     \n\t"
+
+      "subs       r5,   r5,   #1            \n\t"
+      "bne        loop_nc1_%=               \n\t"
+
+      "add        %[dst], %[dst], %[step]   \n\t"
+      "add        %[src], %[src], %[step1]  \n\t"
+      "subs       %[mc], %[mc], #1          \n\t"
+      "bne        loop_mc_%=                \n\t"
+
+      : [src] "+r"(src), [dst] "+r"(dst), [mc] "+r"(rows),
+        [scale] "+r"(scale), [shift] "+r"(shift)
+      : [nc1] "r"(nc1), [step] "r"(step), [step1] "r"(step1)
+      : "cc", "memory", "r5", "q0", "q8", "q9", "q10", "q11", "q13", "q14",
+        "q15");
+  return 8 * nc1;
+}
+#endif  // !__aarch64__
+
+// 从第 done 列起用通用的 WriteWithEpilogue 回写余下的列
+template <typename Epilogue>
+static void WriteRemainder(int rows, int cols, int done, const float *src,
+                           int src_ld, float *dst, int dst_ld,
+                           const Epilogue &epilogue) {
+  if (done < cols) {
+    WriteWithEpilogue<Epilogue>(rows, cols - done, src + done, src_ld,
+                                dst + done, dst_ld, epilogue.Offset(0, done));
+  }
+}
+
+void WriteWithEpilogue(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld, const Epilogue<> &epilogue) {
 #if __aarch64__
-      // AddDot8x12(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      AddDot6x16(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
+  int done = WriteRowsNeon<false, false, false, false>(
+      rows, cols, src, src_ld, dst, dst_ld, nullptr, nullptr, nullptr, 0);
 #else
-      // AddDot4x4(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      // AddDot4x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-      AddDot6x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
+  int done = WriteBasic(rows, cols, src, src_ld, dst, dst_ld);
 #endif
-    }
-  }
-  WriteWithAddPRelu(mc, nc, c, C, ldc, p, mode, bias, bias1);
+  WriteRemainder(rows, cols, done, src, src_ld, dst, dst_ld, epilogue);
+}
+
+void WriteWithEpilogue(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld,
+                       const Epilogue<epilogue::Residual> &epilogue) {
+  const epilogue::Residual &residual = epilogue.stage;
+#if __aarch64__
+  int done = WriteRowsNeon<false, false, true, false>(
+      rows, cols, src, src_ld, dst, dst_ld, nullptr, nullptr, residual.data,
+      residual.ld);
+#else
+  int done = WriteWithAdd(rows, cols, src, src_ld, dst, dst_ld, residual.data,
+                          residual.ld);
+#endif
+  WriteRemainder(rows, cols, done, src, src_ld, dst, dst_ld, epilogue);
+}
+
+void WriteWithEpilogue(
+    int rows, int cols, const float *src, int src_ld, float *dst, int dst_ld,
+    const Epilogue<epilogue::Residual, epilogue::Activation<RELU>> &epilogue) {
+  const epilogue::Residual &residual = epilogue.stage;
+#if __aarch64__
+  int done = WriteRowsNeon<false, false, true, true>(
+      rows, cols, src, src_ld, dst, dst_ld, nullptr, nullptr, residual.data,
+      residual.ld);
+#else
+  int done = WriteWithAddRelu(rows, cols, src, src_ld, dst, dst_ld,
+                              residual.data, residual.ld);
+#endif
+  WriteRemainder(rows, cols, done, src, src_ld, dst, dst_ld, epilogue);
+}
+
+void WriteWithEpilogue(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld,
+                       const Epilogue<epilogue::RowBias> &epilogue) {
+  int done = WriteRowsNeon<false, true, false, false>(
+      rows, cols, src, src_ld, dst, dst_ld, nullptr, epilogue.stage.bias,
+      nullptr, 0);
+  WriteRemainder(rows, cols, done, src, src_ld, dst, dst_ld, epilogue);
+}
+
+void WriteWithEpilogue(
+    int rows, int cols, const float *src, int src_ld, float *dst, int dst_ld,
+    const Epilogue<epilogue::RowBias, epilogue::Activation<RELU>> &epilogue) {
+  int done = WriteRowsNeon<false, true, false, true>(
+      rows, cols, src, src_ld, dst, dst_ld, nullptr, epilogue.stage.bias,
+      nullptr, 0);
+  WriteRemainder(rows, cols, done, src, src_ld, dst, dst_ld, epilogue);
+}
+
+void WriteWithEpilogue(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld,
+                       const Epilogue<epilogue::RowScaleShift> &epilogue) {
+  const epilogue::RowScaleShift &bn = epilogue.stage;
+#if __aarch64__
+  int done = WriteRowsNeon<true, true, false, false>(
+      rows, cols, src, src_ld, dst, dst_ld, bn.scale, bn.shift, nullptr, 0);
+#else
+  int done =
+      WriteWithBn(rows, cols, src, src_ld, dst, dst_ld, bn.scale, bn.shift);
+#endif
+  WriteRemainder(rows, cols, done, src, src_ld, dst, dst_ld, epilogue);
+}
+
+void WriteWithEpilogue(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld,
+                       const Epilogue<epilogue::RowScaleShift,
+                                      epilogue::Activation<RELU>> &epilogue) {
+  const epilogue::RowScaleShift &bn = epilogue.stage;
+#if __aarch64__
+  int done = WriteRowsNeon<true, true, false, true>(
+      rows, cols, src, src_ld, dst, dst_ld, bn.scale, bn.shift, nullptr, 0);
+#else
+  int done = WriteWithBnRelu(rows, cols, src, src_ld, dst, dst_ld, bn.scale,
+                             bn.shift);
+#endif
+  WriteRemainder(rows, cols, done, src, src_ld, dst, dst_ld, epilogue);
+}
+
+void WriteWithEpilogue(
+    int rows, int cols, const float *src, int src_ld, float *dst, int dst_ld,
+    const Epilogue<epilogue::RowScaleShift, epilogue::Residual,
+                   epilogue::Activation<RELU>> &epilogue) {
+  const epilogue::RowScaleShift &bn = epilogue.stage;
+  const epilogue::Residual &residual = epilogue.rest.stage;
+  int done = WriteRowsNeon<true, true, true, true>(
+      rows, cols, src, src_ld, dst, dst_ld, bn.scale, bn.shift, residual.data,
+      residual.ld);
+  WriteRemainder(rows, cols, done, src, src_ld, dst, dst_ld, epilogue);
 }
+#endif  // __ARM_NEON
 
 #if __ARM_NEON
 #if __aarch64__
@@ -1333,434 +1691,93 @@ void Gemm::AddDot6x8(int k, const float *a, const float *b, float *c, int ldc) {
 }
 
 #endif  // __aarch64__
-#endif  // __ARM_NEON
-
-#if __ARM_NEON
-#if __aarch64__
+#else
 
-// 分块矩阵乘法结果回写
-// C = A * B
-void Gemm::WriteBasic(int mc, int nc, float *c, float *C, int ldc) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr;
-  float32x4_t cv;
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-      }
-    }
-  }
+#if defined(__x86_64__) || defined(__i386__)
+// 每行 8 个 float 正好放进一个 ymm 寄存器, 6 行累加结果占用 6 个寄存器
+AVX2_TARGET static void AddDot6x8Avx2(int k, const float *a, const float *b,
+                                      float *c, int ldc) {
+  __m256 cv0 = _mm256_setzero_ps();
+  __m256 cv1 = _mm256_setzero_ps();
+  __m256 cv2 = _mm256_setzero_ps();
+  __m256 cv3 = _mm256_setzero_ps();
+  __m256 cv4 = _mm256_setzero_ps();
+  __m256 cv5 = _mm256_setzero_ps();
+  for (int p = 0; p < k; ++p, a += 6, b += 8) {
+    __m256 bv = _mm256_loadu_ps(b);
+    cv0 = _mm256_fmadd_ps(_mm256_broadcast_ss(a), bv, cv0);
+    cv1 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 1), bv, cv1);
+    cv2 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 2), bv, cv2);
+    cv3 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 3), bv, cv3);
+    cv4 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 4), bv, cv4);
+    cv5 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 5), bv, cv5);
+  }
+  _mm256_storeu_ps(c, cv0);
+  _mm256_storeu_ps(c + ldc, cv1);
+  _mm256_storeu_ps(c + 2 * ldc, cv2);
+  _mm256_storeu_ps(c + 3 * ldc, cv3);
+  _mm256_storeu_ps(c + 4 * ldc, cv4);
+  _mm256_storeu_ps(c + 5 * ldc, cv5);
 }
+#endif  // __x86_64__
 
-// C = alpha * A * B + beta * C
-void Gemm::WriteWithAlphaBeta(int mc, int nc, float *c, float *C, int ldc) {}
-
-// C = A * B + C
-void Gemm::WriteWithAdd(int mc, int nc, float *c, float *C, int ldc) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr;
-  float32x4_t cv;
-  float32x4_t cv1;
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      cv1 = vld1q_f32(C_ptr);
-      cv = vaddq_f32(cv, cv1);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      cv1 = vld1q_f32(C_ptr);
-      cv = vaddq_f32(cv, cv1);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-      }
-    }
-  }
-}
-// C = A * B + bias
-void Gemm::WriteWithAddV1(int mc, int nc, float *c, float *C, int ldc,
-                          float *bias) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr;
-  float32x4_t cv;
-  float32x4_t biasv;
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    biasv = vld1q_dup_f32(bias + i);
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      cv = vaddq_f32(cv, biasv);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      cv = vaddq_f32(cv, biasv);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-        C_ptr++;
+void Gemm::AddDot4x4(int k, const float *a, const float *b, float *c, int ldc) {
+  float r[4][4] = {{0}};
+  for (int p = 0; p < k; ++p, a += 4, b += 4) {
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        r[i][j] += a[i] * b[j];
       }
     }
   }
-}
-
-// C = A * B + C, relu(C)
-void Gemm::WriteWithAddRelu(int mc, int nc, float *c, float *C, int ldc) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr;
-  float32x4_t cv;
-  float32x4_t cv1;
-  float32x4_t zero = vdupq_n_f32(0.0);
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      cv1 = vld1q_f32(C_ptr);
-      cv = vaddq_f32(cv, cv1);
-      cv = vmaxq_f32(cv, zero);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      cv1 = vld1q_f32(C_ptr);
-      cv = vaddq_f32(cv, cv1);
-      cv = vmaxq_f32(cv, zero);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-      }
-    }
+  for (int i = 0; i < 4; ++i) {
+    memcpy(c + i * ldc, r[i], 4 * sizeof(float));
   }
 }
 
-// C = A * B + bias, relu(C)
-void Gemm::WriteWithAddReluV1(int mc, int nc, float *c, float *C, int ldc,
-                              float *bias) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr;
-  float32x4_t cv;
-  float32x4_t biasv;
-  float32x4_t zero = vdupq_n_f32(0.0);
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    biasv = vld1q_dup_f32(bias + i);
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      cv = vaddq_f32(cv, biasv);
-      cv = vmaxq_f32(cv, zero);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      cv = vaddq_f32(cv, biasv);
-      cv = vmaxq_f32(cv, zero);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-        C_ptr++;
+void Gemm::AddDot4x8(int k, const float *a, const float *b, float *c, int ldc) {
+  float r[4][8] = {{0}};
+  for (int p = 0; p < k; ++p, a += 4, b += 8) {
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 8; ++j) {
+        r[i][j] += a[i] * b[j];
       }
     }
   }
-}
-
-// C = A * B + C,prelu(C)
-void Gemm::WriteWithAddPRelu(int mc, int nc, float *c, float *C, int ldc,
-                             float *p, std::string mode, float *bias,
-                             float *bias1) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr;
-  float32x4_t cv;
-  float32x4_t cv1;
-  float32x4_t biasv;
-  float32x4_t biasv1;
-  float32x4_t zero = vdupq_n_f32(0.0);
-  float32x4_t pv;
-  float *ptr = p;
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    biasv = vld1q_dup_f32(bias + i);
-    if (bias1 == nullptr) {
-      biasv1 = zero;
-    } else {
-      biasv1 = vld1q_dup_f32(bias1 + i);
-    }
-
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      cv = vaddq_f32(cv, biasv);
-      cv = vaddq_f32(cv, biasv1);
-      cv = vmaxq_f32(cv, zero);
-      cv1 = vminq_f32(cv, zero);
-      if (mode == "channel") {
-        cv1 = vmulq_n_f32(cv1, ptr[i]);
-      } else if (mode == "element") {
-        pv = vld1q_f32(ptr);
-        cv1 = vmulq_f32(cv1, pv);
-        ptr = ptr + 4;
-      } else {
-        cv1 = vmulq_n_f32(cv1, ptr[0]);
-      }
-      cv = vaddq_f32(cv, cv1);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      cv = vaddq_f32(cv, biasv);
-      cv = vaddq_f32(cv, biasv1);
-      cv = vmaxq_f32(cv, zero);
-      cv1 = vminq_f32(cv, zero);
-      if (mode == "channel") {
-        cv1 = vmulq_n_f32(cv1, ptr[i]);
-      } else if (mode == "element") {
-        pv = vld1q_f32(ptr);
-        cv1 = vmulq_f32(cv1, pv);
-        ptr = ptr + 4;
-      } else {
-        cv1 = vmulq_n_f32(cv1, ptr[0]);
-      }
-      cv = vaddq_f32(cv, cv1);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-        C_ptr++;
-      }
-    }
+  for (int i = 0; i < 4; ++i) {
+    memcpy(c + i * ldc, r[i], 8 * sizeof(float));
   }
 }
 
-// C = A * B, batchnorm(C)
-void Gemm::WriteWithBn(int mc, int nc, float *c, float *C, int ldc,
-                       float *new_scale, float *new_bias) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr;
-  float32x4_t cv;
-  float32x4_t cv1;
-  float32x4_t bias;
-  float32x2_t scale;
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    bias = vld1q_dup_f32(new_bias);
-    scale = vld1_dup_f32(new_scale);
-    new_bias++;
-    new_scale++;
-    float scale0 = vget_lane_f32(scale, 0);
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      cv = vmlaq_n_f32(bias, cv, scale0);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      cv = vmlaq_n_f32(bias, cv, scale0);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-        C_ptr++;
-      }
-    }
+void Gemm::AddDot6x8(int k, const float *a, const float *b, float *c, int ldc) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (HasAvx2()) {
+    AddDot6x8Avx2(k, a, b, c, ldc);
+    return;
   }
-}
-
-// C = A * B, batchnorm(C), relu(C)
-void Gemm::WriteWithBnRelu(int mc, int nc, float *c, float *C, int ldc,
-                           float *new_scale, float *new_bias) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr;
-  float32x4_t cv;
-  float32x4_t bias;
-  float32x2_t scale;
-  float32x4_t zero = vdupq_n_f32(0.0);
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    bias = vld1q_dup_f32(new_bias);
-    scale = vld1_dup_f32(new_scale);
-    new_bias++;
-    new_scale++;
-    float scale0 = vget_lane_f32(scale, 0);
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      cv = vmlaq_n_f32(bias, cv, scale0);
-      cv = vmaxq_f32(cv, zero);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      cv = vmlaq_n_f32(bias, cv, scale0);
-      cv = vmaxq_f32(cv, zero);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
+#endif  // __x86_64__
+  float r[6][8] = {{0}};
+  for (int p = 0; p < k; ++p, a += 6, b += 8) {
+    for (int i = 0; i < 6; ++i) {
+      for (int j = 0; j < 8; ++j) {
+        r[i][j] += a[i] * b[j];
       }
     }
   }
-}
-
-// C = A * B, batchnorm(C),C = C + bias; relu(C)
-void Gemm::WriteWithBnAddRelu(int mc, int nc, float *c, float *C, int ldc,
-                              float *new_scale, float *new_bias, float *bias) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr, *bias_ptr;
-  float32x4_t cv;
-  float32x4_t nbias;
-  float32x2_t scale;
-  float32x4_t biasv;
-  float32x4_t zero = vdupq_n_f32(0.0);
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    bias_ptr = bias + i * ldc;
-    nbias = vld1q_dup_f32(new_bias);
-    scale = vld1_dup_f32(new_scale);
-    new_bias++;
-    new_scale++;
-    float scale0 = vget_lane_f32(scale, 0);
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      biasv = vld1q_f32(bias_ptr);
-      cv = vmlaq_n_f32(nbias, cv, scale0);
-      cv = vaddq_f32(cv, biasv);
-      cv = vmaxq_f32(cv, zero);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-      bias_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      biasv = vld1q_f32(bias_ptr);
-      cv = vmlaq_n_f32(nbias, cv, scale0);
-      cv = vaddq_f32(cv, biasv);
-      cv = vmaxq_f32(cv, zero);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-      }
-    }
+  for (int i = 0; i < 6; ++i) {
+    memcpy(c + i * ldc, r[i], 8 * sizeof(float));
   }
 }
+#endif  // __ARM_NEON
 
-#else
+#if __ARM_NEON
+#ifndef __aarch64__
 
 void Gemm::VectorKernel(int m, int n, int k, float alpha, const float *A,
                         int lda, const float *B, int ldb, float beta, float *C,
                         int ldc, bool relu) {
-  float *bufferC = static_cast<float *>(memory::Alloc(sizeof(float) * n));
+  framework::WorkspaceScope scratch;
+  float *bufferC = scratch.Allocate<float>(n);
 
   const float *a0, *b0, *b1, *b2, *b3;
   float *c0, *C0;
@@ -1983,7 +2000,8 @@ void Gemm::VectorKernelWithBn(int m, int n, int k, float alpha, const float *A,
                               int lda, const float *B, int ldb, float beta,
                               float *C, int ldc, bool relu, float *new_scale,
                               float *new_bias) {
-  float *bufferC = static_cast<float *>(memory::Alloc(sizeof(float) * n));
+  framework::WorkspaceScope scratch;
+  float *bufferC = scratch.Allocate<float>(n);
 
   const float *a0, *b0, *b1, *b2, *b3;
   float *c0, *C0;
@@ -2192,823 +2210,45 @@ void Gemm::VectorKernelWithBn(int m, int n, int k, float alpha, const float *A,
 }
 
 // C = A * B
-void Gemm::WriteBasic(int mc, int nc, float *c, float *C, int ldc) {
-  int nc1 = nc / 16;
-  int _nc1 = nc % 16;
-  int step = 4 * ldc;
-  int step1 = 4 * (NC - 16 * nc1);
-  int volatile m = mc;
-
-  float *volatile c_ptr, *volatile C_ptr;
-  float *C0, *c0;
-  c_ptr = c;
-  C_ptr = C;
-  if (nc1 > 0) {
-    asm volatile(
-        "subs       %[mc], %[mc], #1        \n\t"
-        "blt        end_mc_%=               \n\t"
-        "loop_mc_%=:                        \n\t"
+void Gemm::VecWriteBasic(int n, float *c, float *C, int ldc) {
+  int nc1 = n / 16;
+  int _nc1 = n % 16;
+  int nc2 = _nc1 / 4;
+  int nc3 = 16 - 4 * (_nc1 % 4);
 
-        "mov        r6,   %[C_ptr]          \n\t"
-        "mov        r5,   %[nc1]            \n\t"
-        "subs       r5,   r5,   #1          \n\t"
-        "blt        end_nc1_%=              \n\t"
-        "loop_nc1_%=:                       \n\t"
+  asm volatile(
+      "subs       %[nc1],   %[nc1],   #1  \n\t"
+      "blt        end_nc1_%=              \n\t"
+      "loop_nc1_%=:                       \n\t"
 
-        "vld1.32    {q0, q1}, [%[c_ptr]]!   \n\t"
-        "vst1.32    {q0, q1}, [r6]!         \n\t"
+      "vld1.32    {q0, q1}, [%[c]]!       \n\t"
+      "vst1.32    {q0, q1}, [%[C]]!       \n\t"
 
-        "vld1.32    {q2, q3}, [%[c_ptr]]!   \n\t"
-        "vst1.32    {q2, q3}, [r6]!         \n\t"
+      "vld1.32    {q2, q3}, [%[c]]!       \n\t"
+      "vst1.32    {q2, q3}, [%[C]]!       \n\t"
 
-        "subs       r5,   r5,   #1          \n\t"
-        "bge        loop_nc1_%=             \n\t"
-        "end_nc1_%=:                        \n\t"
+      "subs       %[nc1],   %[nc1],   #1  \n\t"
+      "bge        loop_nc1_%=             \n\t"
+      "end_nc1_%=:                        \n\t"
 
-        "add        %[C_ptr], %[C_ptr], %[step]   \n\t"
-        "add        %[c_ptr], %[c_ptr], %[step1]  \n\t"
-        "subs       %[mc], %[mc], #1        \n\t"
-        "bge        loop_mc_%=              \n\t"
-        "end_mc_%=:                         \n\t"
+      "subs       %[nc2],   %[nc2],   #1  \n\t"
+      "blt        end_nc2_%=              \n\t"
+      "loop_nc2_%=:                       \n\t"
 
-        :
-        : [C_ptr] "r"(C_ptr), [c_ptr] "r"(c_ptr), [mc] "r"(m), [nc1] "r"(nc1),
-          [step] "r"(step), [step1] "r"(step1)
-        : "memory", "r5", "r6", "q0", "q1", "q2", "q3");
-  }
+      "vld1.32    {q4},     [%[c]]!       \n\t"
+      "vst1.32    {q4},     [%[C]]!       \n\t"
 
-  if (_nc1 != 0) {
-    for (int i = 0; i < mc; i++) {
-      C0 = C_ptr + nc1 * 16 + i * ldc;
-      c0 = c_ptr + nc1 * 16 + i * NC;
-      for (int j = 0; j < _nc1; j++) {
-        *C0++ = *c0++;
-      }
-    }
-  }
-}
+      "subs       %[nc2],   %[nc2],   #1  \n\t"
+      "bge        loop_nc2_%=             \n\t"
+      "end_nc2_%=:                        \n\t"
 
-// C = alpha * A * B + beta * C
-void Gemm::WriteWithAlphaBeta(int mc, int nc, float *c, float *C, int ldc) {}
-
-// C = A * B + C
-void Gemm::WriteWithAdd(int mc, int nc, float *c, float *C, int ldc) {
-  int nc1 = nc / 16;
-  int _nc1 = nc % 16;
-  int step = 4 * ldc;
-  int step1 = 4 * (NC - 16 * nc1);
-  int volatile m = mc;
-
-  float *volatile c_ptr, *volatile C_ptr;
-  float *C0, *c0;
-  c_ptr = c;
-  C_ptr = C;
-  if (nc1 > 0) {
-    asm volatile(
-        "subs       %[mc], %[mc], #1        \n\t"
-        "blt        end_mc_%=               \n\t"
-        "loop_mc_%=:                        \n\t"
-
-        "mov        r6,   %[C_ptr]          \n\t"
-        "mov        r5,   %[nc1]            \n\t"
-        "subs       r5,   r5,   #1          \n\t"
-        "blt        end_nc1_%=              \n\t"
-        "loop_nc1_%=:                       \n\t"
-
-        "vld1.32    {q0, q1},   [r6]        \n\t"
-        "vld1.32    {q2, q3},   [%[c_ptr]]! \n\t"
-        "vadd.f32   q10,  q0,   q2          \n\t"
-        "vadd.f32   q11,  q1,   q3          \n\t"
-        "vst1.32    {q10, q11}, [r6]!       \n\t"
-
-        "vld1.32    {q4, q5},   [r6]        \n\t"
-        "vld1.32    {q6, q7},   [%[c_ptr]]! \n\t"
-        "vadd.f32   q12,  q4,   q6          \n\t"
-        "vadd.f32   q13,  q5,   q7          \n\t"
-        "vst1.32    {q12, q13}, [r6]!       \n\t"
-
-        "subs       r5,   r5,   #1          \n\t"
-        "bge        loop_nc1_%=             \n\t"
-        "end_nc1_%=:                        \n\t"
-
-        "add        %[C_ptr], %[C_ptr], %[step]     \n\t"
-        "add        %[c_ptr], %[c_ptr], %[step1]    \n\t"
-        "subs       %[mc], %[mc], #1        \n\t"
-        "bge        loop_mc_%=              \n\t"
-        "end_mc_%=:                         \n\t"
-
-        :
-        : [C_ptr] "r"(C_ptr), [c_ptr] "r"(c_ptr), [mc] "r"(m), [nc1] "r"(nc1),
-          [step] "r"(step), [step1] "r"(step1)
-        : "memory", "r5", "r6", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7",
-          "q10", "q11", "q12", "q13");
-  }
-
-  if (_nc1 != 0) {
-    for (int i = 0; i < mc; i++) {
-      C0 = C_ptr + nc1 * 16 + i * ldc;
-      c0 = c_ptr + nc1 * 16 + i * NC;
-      for (int j = 0; j < _nc1; j++) {
-        *C0++ += *c0++;
-      }
-    }
-  }
-}
-
-// C = A * B + bias
-void Gemm::WriteWithAddV1(int mc, int nc, float *c, float *C, int ldc,
-                          float *bias) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr;
-  float32x4_t cv;
-  float32x4_t biasv;
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    biasv = vld1q_dup_f32(bias + i);
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      cv = vaddq_f32(cv, biasv);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      cv = vaddq_f32(cv, biasv);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-        C_ptr++;
-      }
-    }
-  }
-}
-
-// C = A * B + C, relu(C)
-void Gemm::WriteWithAddRelu(int mc, int nc, float *c, float *C, int ldc) {
-  int nc1 = nc / 16;
-  int _nc1 = nc % 16;
-  int step = 4 * ldc;
-  int step1 = 4 * (NC - 16 * nc1);
-  int volatile m = mc;
-
-  float *volatile c_ptr, *volatile C_ptr;
-  float *C0, *c0;
-  c_ptr = c;
-  C_ptr = C;
-  if (nc1 > 0) {
-    asm volatile(
-        "vmov.f32   q14,    #0.0            \n\t"
-        "subs       %[mc], %[mc], #1        \n\t"
-        "blt        end_mc_%=               \n\t"
-        "loop_mc_%=:                        \n\t"
-
-        "mov        r6,   %[C_ptr]          \n\t"
-        "mov        r5,   %[nc1]            \n\t"
-        "subs       r5,   r5,   #1          \n\t"
-        "blt        end_nc1_%=              \n\t"
-        "loop_nc1_%=:                       \n\t"
-
-        "vld1.32    {q0, q1},   [r6]        \n\t"
-        "vld1.32    {q2, q3},   [%[c_ptr]]! \n\t"
-        "vadd.f32   q10,  q0,   q2          \n\t"
-        "vadd.f32   q11,  q1,   q3          \n\t"
-        "vmax.f32   q10,  q10,  q14         \n\t"
-        "vmax.f32   q11,  q11,  q14         \n\t"
-        "vst1.32    {q10, q11}, [r6]!       \n\t"
-
-        "vld1.32    {q4, q5},   [r6]        \n\t"
-        "vld1.32    {q6, q7},   [%[c_ptr]]! \n\t"
-        "vadd.f32   q12,  q4,   q6          \n\t"
-        "vadd.f32   q13,  q5,   q7          \n\t"
-        "vmax.f32   q12,  q12,  q14         \n\t"
-        "vmax.f32   q13,  q13,  q14         \n\t"
-        "vst1.32    {q12, q13}, [r6]!       \n\t"
-
-        "subs       r5,   r5,   #1          \n\t"
-        "bge        loop_nc1_%=             \n\t"
-        "end_nc1_%=:                        \n\t"
-
-        "add        %[C_ptr], %[C_ptr], %[step]     \n\t"
-        "add        %[c_ptr], %[c_ptr], %[step1]    \n\t"
-        "subs       %[mc], %[mc], #1        \n\t"
-        "bge        loop_mc_%=              \n\t"
-        "end_mc_%=:                         \n\t"
-
-        :
-        : [C_ptr] "r"(C_ptr), [c_ptr] "r"(c_ptr), [mc] "r"(m), [nc1] "r"(nc1),
-          [step] "r"(step), [step1] "r"(step1)
-        : "memory", "r5", "r6", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7",
-          "q10", "q11", "q12", "q13");
-  }
-
-  if (_nc1 != 0) {
-    for (int i = 0; i < mc; i++) {
-      C0 = C_ptr + nc1 * 16 + i * ldc;
-      c0 = c_ptr + nc1 * 16 + i * NC;
-      for (int j = 0; j < _nc1; j++) {
-        *C0 += *c0;
-        if (*C0 < 0) {
-          *C0 = 0;
-        }
-        C0++;
-        c0++;
-      }
-    }
-  }
-}
-
-// C = A * B + bias, relu(C)
-void Gemm::WriteWithAddReluV1(int mc, int nc, float *c, float *C, int ldc,
-                              float *bias) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr;
-  float32x4_t cv;
-  float32x4_t biasv;
-  float32x4_t zero = vdupq_n_f32(0.0);
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    biasv = vld1q_dup_f32(bias + i);
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      cv = vaddq_f32(cv, biasv);
-      cv = vmaxq_f32(cv, zero);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      cv = vaddq_f32(cv, biasv);
-      cv = vmaxq_f32(cv, zero);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-        C_ptr++;
-      }
-    }
-  }
-}
-
-void Gemm::WriteWithAddPRelu(int mc, int nc, float *c, float *C, int ldc,
-                             float *p, std::string mode, float *bias,
-                             float *bias1) {
-  if (nc < 4) {
-    if (bias1 == nullptr) {
-      for (int i = 0; i < mc; ++i) {
-        for (int j = 0; j < nc; ++j) {
-          float r = c[i * NC + j] + bias[i];
-          if (r < 0) {
-            r *= p[i];
-          }
-          C[i * ldc + j] = r;
-        }
-      }
-    } else {
-      for (int i = 0; i < mc; ++i) {
-        for (int j = 0; j < nc; ++j) {
-          float r = c[i * NC + j] + bias[i];
-          r += bias1[i * ldc + j];
-          if (r < 0) {
-            r *= p[i];
-          }
-          C[i * ldc + j] = r;
-        }
-      }
-    }
-    return;
-  }
-
-  int nc1 = nc / 16;
-  int _nc1 = nc % 16;
-  int nc2 = _nc1 / 4;
-  int nc3 = 16 - 4 * (_nc1 % 4);
-  int step = 4 * (ldc - nc);
-  int step1 = 4 * (NC - nc);
-
-  if (bias1 == nullptr) {
-    asm volatile(
-        "vmov.f32   q14,    #0.0            \n\t"
-        "subs       %[mc], %[mc], #1        \n\t"
-        "blt        end_mc_%=               \n\t"
-        "loop_mc_%=:                        \n\t"
-
-        "mov        r5,     %[nc1]          \n\t"
-        "mov        r6,     %[nc2]          \n\t"
-        "vld1.32    {d0},   [%[bias]]       \n\t"
-        "vld1.32    {d1},   [%[p]]          \n\t"
-        "vdup.32    q1,     d0[0]           \n\t"
-        "vdup.32    q2,     d1[0]           \n\t"
-
-        "subs       r5,   r5,   #1          \n\t"
-        "blt        end_nc1_%=              \n\t"
-        "loop_nc1_%=:                       \n\t"
-
-        "pld        [%[c], #32]             \n\t"
-        "vld1.32    {q3, q4},   [%[c]]!     \n\t"
-        "vld1.32    {q9, q10},  [%[c]]!     \n\t"
-
-        "vadd.f32   q3,   q3,   q1          \n\t"
-        "vadd.f32   q4,   q4,   q1          \n\t"
-        "vadd.f32   q9,   q9,   q1          \n\t"
-        "vadd.f32   q10,  q10,  q1          \n\t"
-
-        "vmax.f32   q5,   q3,   q14         \n\t"
-        "vmin.f32   q7,   q3,   q14         \n\t"
-        "vmax.f32   q6,   q4,   q14         \n\t"
-        "vmin.f32   q8,   q4,   q14         \n\t"
-
-        "vmax.f32   q11,  q9,   q14         \n\t"
-        "vmin.f32   q13,  q9,   q14         \n\t"
-        "vmax.f32   q12,  q10,  q14         \n\t"
-        "vmin.f32   q15,  q10,  q14         \n\t"
-
-        "vmla.f32   q5,   q7,   q2          \n\t"
-        "vmla.f32   q6,   q8,   q2          \n\t"
-        "vmla.f32   q11,  q13,  q2          \n\t"
-        "vmla.f32   q12,  q15,  q2          \n\t"
-
-        "vst1.32    {q5, q6},   [%[C]]!     \n\t"
-        "vst1.32    {q11, q12}, [%[C]]!     \n\t"
-
-        "subs       r5,   r5,   #1          \n\t"
-        "bge        loop_nc1_%=             \n\t"
-        "end_nc1_%=:                        \n\t"
-
-        "subs       r6,  r6,   #1           \n\t"
-        "blt        end_nc2_%=              \n\t"
-        "loop_nc2_%=:                       \n\t"
-
-        "vld1.32    {q3},       [%[c]]!     \n\t"
-        "vadd.f32   q3,   q3,   q1          \n\t"
-        "vmax.f32   q5,   q3,   q14         \n\t"
-        "vmin.f32   q7,   q3,   q14         \n\t"
-        "vmla.f32   q5,   q7,   q2          \n\t"
-        "vst1.32    {q5},       [%[C]]!     \n\t"
-
-        "subs       r6,   r6,   #1          \n\t"
-        "bge        loop_nc2_%=             \n\t"
-        "end_nc2_%=:                        \n\t"
-
-        "cmp        %[nc3],    #16          \n\t"
-        "beq        end_nc3_%=              \n\t"
-
-        "sub        %[c],     %[c],   %[nc3]      \n\t"
-        "sub        %[C],     %[C],   %[nc3]      \n\t"
-
-        "vld1.32    {q4},       [%[c]]!     \n\t"
-        "vadd.f32   q4,   q4,   q1          \n\t"
-        "vmax.f32   q6,   q4,   q14         \n\t"
-        "vmin.f32   q8,   q4,   q14         \n\t"
-        "vmla.f32   q6,   q8,   q2          \n\t"
-        "vst1.32    {q6},       [%[C]]!     \n\t"
-        "end_nc3_%=:                        \n\t"
-
-        "add        %[p],     %[p],     #4        \n\t"
-        "add        %[bias],  %[bias],  #4        \n\t"
-        "add        %[c],     %[c],     %[step1]  \n\t"
-        "add        %[C],     %[C],     %[step]   \n\t"
-
-        "subs       %[mc], %[mc], #1        \n\t"
-        "bge        loop_mc_%=              \n\t"
-        "end_mc_%=:                         \n\t"
-
-        :
-        : [C] "r"(C), [c] "r"(c), [mc] "r"(mc), [nc1] "r"(nc1), [nc2] "r"(nc2),
-          [nc3] "r"(nc3), [step] "r"(step), [step1] "r"(step1), [p] "r"(p),
-          [bias] "r"(bias), [bias1] "r"(bias1)
-        : "memory", "r5", "r6", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7",
-          "q8");
-  } else {
-    asm volatile(
-        "vmov.f32   q14,    #0.0            \n\t"
-        "subs       %[mc], %[mc], #1        \n\t"
-        "blt        end_mc_%=               \n\t"
-        "loop_mc_%=:                        \n\t"
-
-        "mov        r5,     %[nc1]          \n\t"
-        "mov        r6,     %[nc2]          \n\t"
-        "vld1.32    {d0},   [%[bias]]       \n\t"
-        "vld1.32    {d1},   [%[p]]          \n\t"
-        "vdup.32    q1,     d0[0]           \n\t"
-        "vdup.32    q2,     d1[0]           \n\t"
-
-        "subs       r5,   r5,   #1          \n\t"
-        "blt        end_nc1_%=              \n\t"
-        "loop_nc1_%=:                       \n\t"
-
-        "pld        [%[c], #32]             \n\t"
-        "pld        [%[bias1], #32]         \n\t"
-        "vld1.32    {q3, q4},   [%[c]]!     \n\t"
-        "vld1.32    {q9, q10},  [%[bias1]]! \n\t"
-        "vadd.f32   q3,   q3,   q1          \n\t"
-        "vadd.f32   q4,   q4,   q1          \n\t"
-        "vadd.f32   q3,   q3,   q9          \n\t"
-        "vadd.f32   q4,   q4,   q10         \n\t"
-        "vmax.f32   q5,   q3,   q14         \n\t"
-        "vmin.f32   q7,   q3,   q14         \n\t"
-        "vmax.f32   q6,   q4,   q14         \n\t"
-        "vmin.f32   q8,   q4,   q14         \n\t"
-        "vmla.f32   q5,   q7,   q2          \n\t"
-        "vmla.f32   q6,   q8,   q2          \n\t"
-        "vst1.32    {q5, q6},   [%[C]]!     \n\t"
-
-        "vld1.32    {q3, q4},   [%[c]]!     \n\t"
-        "vld1.32    {q9, q10},  [%[bias1]]! \n\t"
-        "vadd.f32   q3,   q3,   q1          \n\t"
-        "vadd.f32   q4,   q4,   q1          \n\t"
-        "vadd.f32   q3,   q3,   q9          \n\t"
-        "vadd.f32   q4,   q4,   q10         \n\t"
-        "vmax.f32   q5,   q3,   q14         \n\t"
-        "vmin.f32   q7,   q3,   q14         \n\t"
-        "vmax.f32   q6,   q4,   q14         \n\t"
-        "vmin.f32   q8,   q4,   q14         \n\t"
-        "vmla.f32   q5,   q7,   q2          \n\t"
-        "vmla.f32   q6,   q8,   q2          \n\t"
-        "vst1.32    {q5, q6},   [%[C]]!     \n\t"
-
-        "subs       r5,   r5,   #1          \n\t"
-        "bge        loop_nc1_%=             \n\t"
-        "end_nc1_%=:                        \n\t"
-
-        "subs       r6,  r6,   #1           \n\t"
-        "blt        end_nc2_%=              \n\t"
-        "loop_nc2_%=:                       \n\t"
-
-        "vld1.32    {q3},       [%[c]]!     \n\t"
-        "vld1.32    {q9},       [%[bias1]]! \n\t"
-        "vadd.f32   q3,   q3,   q1          \n\t"
-        "vadd.f32   q3,   q3,   q9          \n\t"
-        "vmax.f32   q5,   q3,   q14         \n\t"
-        "vmin.f32   q7,   q3,   q14         \n\t"
-        "vmla.f32   q5,   q7,   q2          \n\t"
-        "vst1.32    {q5},      [%[C]]!      \n\t"
-
-        "subs       r6,   r6,   #1          \n\t"
-        "bge        loop_nc2_%=             \n\t"
-        "end_nc2_%=:                        \n\t"
-
-        "cmp        %[nc3],    #16          \n\t"
-        "beq        end_nc3_%=              \n\t"
-
-        "sub        %[c],     %[c],     %[nc3]    \n\t"
-        "sub        %[C],     %[C],     %[nc3]    \n\t"
-        "sub        %[bias1], %[bias1], %[nc3]    \n\t"
-
-        "vld1.32    {q4},       [%[c]]!     \n\t"
-        "vld1.32    {q10},      [%[bias1]]! \n\t"
-        "vadd.f32   q4,   q4,   q1          \n\t"
-        "vadd.f32   q4,   q4,   q10         \n\t"
-        "vmax.f32   q6,   q4,   q14         \n\t"
-        "vmin.f32   q8,   q4,   q14         \n\t"
-        "vmla.f32   q6,   q8,   q2          \n\t"
-        "vst1.32    {q6},       [%[C]]!     \n\t"
-        "end_nc3_%=:                        \n\t"
-
-        "add        %[p],     %[p],     #4        \n\t"
-        "add        %[bias],  %[bias],  #4        \n\t"
-        "add        %[c],     %[c],     %[step1]  \n\t"
-        "add        %[C],     %[C],     %[step]   \n\t"
-        "add        %[bias1], %[bias1], %[step]   \n\t"
-
-        "subs       %[mc], %[mc], #1        \n\t"
-        "bge        loop_mc_%=              \n\t"
-        "end_mc_%=:                         \n\t"
-
-        :
-        : [C] "r"(C), [c] "r"(c), [mc] "r"(mc), [nc1] "r"(nc1), [nc2] "r"(nc2),
-          [nc3] "r"(nc3), [step] "r"(step), [step1] "r"(step1), [p] "r"(p),
-          [bias] "r"(bias), [bias1] "r"(bias1)
-        : "memory", "r5", "r6", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7",
-          "q8", "q9", "q10");
-  }
-}
-
-// C = A * B, batchnorm(C)
-void Gemm::WriteWithBn(int mc, int nc, float *c, float *C, int ldc,
-                       float *scale, float *bias) {
-  if (nc < 4) {
-    for (int i = 0; i < mc; ++i) {
-      for (int j = 0; j < nc; ++j) {
-        *C = (*c) * (*scale) + (*bias);
-        C++;
-        c++;
-      }
-      C += (ldc - nc);
-      c += (NC - nc);
-      scale++;
-      bias++;
-    }
-    return;
-  }
-
-  int volatile nc1 = nc / 16;
-  int _nc1 = nc % 16;
-  int volatile nc2 = _nc1 / 4;
-  int volatile nc3 = 16 - 4 * (_nc1 % 4);
-  int volatile step = 4 * (ldc - nc);
-  int volatile step1 = 4 * (NC - nc);
-
-  asm volatile(
-      "subs       %[mc], %[mc], #1        \n\t"
-      "blt        end_mc_%=               \n\t"
-      "loop_mc_%=:                        \n\t"
-
-      "mov        r5,   %[nc1]            \n\t"
-      "mov        r6,   %[nc2]            \n\t"
-      "vld1.32    {d0},   [%[scale]]      \n\t"
-      "vld1.32    {d1},   [%[bias]]       \n\t"
-      "vdup.32    q1,   d0[0]             \n\t"
-      "vdup.32    q2,   d1[0]             \n\t"
-
-      "subs       r5,   r5,   #1          \n\t"
-      "blt        end_nc1_%=              \n\t"
-      "loop_nc1_%=:                       \n\t"
-
-      "vld1.32    {q3, q4},   [%[c]]!     \n\t"
-      "vmul.f32   q10,  q3,   q1          \n\t"
-      "vmul.f32   q11,  q4,   q1          \n\t"
-      "vadd.f32   q10,  q10,  q2          \n\t"
-      "vadd.f32   q11,  q11,  q2          \n\t"
-      "vst1.32    {q10, q11}, [%[C]]!     \n\t"
-
-      "vld1.32    {q5, q6},   [%[c]]!     \n\t"
-      "vmul.f32   q12,  q5,   q1          \n\t"
-      "vmul.f32   q13,  q6,   q1          \n\t"
-      "vadd.f32   q12,  q12,  q2          \n\t"
-      "vadd.f32   q13,  q13,  q2          \n\t"
-      "vst1.32    {q12, q13}, [%[C]]!     \n\t"
-
-      "subs       r5,   r5,   #1          \n\t"
-      "bge        loop_nc1_%=             \n\t"
-      "end_nc1_%=:                        \n\t"
-
-      "subs       r6,  r6,   #1           \n\t"
-      "blt        end_nc2_%=              \n\t"
-      "loop_nc2_%=:                       \n\t"
-
-      "vld1.32    {q7},       [%[c]]!     \n\t"
-      "vmul.f32   q10,  q7,   q1          \n\t"
-      "vadd.f32   q10,  q10,  q2          \n\t"
-      "vst1.32    {q10},      [%[C]]!     \n\t"
-
-      "subs       r6,   r6,   #1          \n\t"
-      "bge        loop_nc2_%=             \n\t"
-      "end_nc2_%=:                        \n\t"
-
-      "cmp        %[nc3],    #16          \n\t"
-      "beq        end_nc3_%=              \n\t"
-
-      "sub        %[c],     %[c],   %[nc3]      \n\t"
-      "sub        %[C],     %[C],   %[nc3]      \n\t"
-
-      "vld1.32    {q8},       [%[c]]!     \n\t"
-      "vmul.f32   q11,  q8,   q1          \n\t"
-      "vadd.f32   q11,  q11,  q2          \n\t"
-      "vst1.32    {q11},      [%[C]]!     \n\t"
-      "end_nc3_%=:                        \n\t"
-
-      "add        %[scale], %[scale], #4        \n\t"
-      "add        %[bias],  %[bias],  #4        \n\t"
-      "add        %[c],     %[c],     %[step1]  \n\t"
-      "add        %[C],     %[C],     %[step]   \n\t"
-
-      "subs       %[mc], %[mc], #1        \n\t"
-      "bge        loop_mc_%=              \n\t"
-      "end_mc_%=:                         \n\t"
-
-      :
-      : [C] "r"(C), [c] "r"(c), [mc] "r"(mc), [nc1] "r"(nc1), [nc2] "r"(nc2),
-        [nc3] "r"(nc3), [step] "r"(step), [step1] "r"(step1),
-        [scale] "r"(scale), [bias] "r"(bias)
-      : "memory", "r5", "r6", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7",
-        "q8", "q10", "q11", "q12", "q13");
-}
-
-// C = A * B, batchnorm(C), relu(C)
-void Gemm::WriteWithBnRelu(int mc, int nc, float *c, float *C, int ldc,
-                           float *scale, float *bias) {
-  if (nc < 4) {
-    for (int i = 0; i < mc; ++i) {
-      for (int j = 0; j < nc; ++j) {
-        *C = (*c) * (*scale) + (*bias);
-        if (*C < 0) {
-          *C = 0;
-        }
-        C++;
-        c++;
-      }
-      C += (ldc - nc);
-      c += (NC - nc);
-      scale++;
-      bias++;
-    }
-    return;
-  }
-
-  int nc1 = nc / 16;
-  int _nc1 = nc % 16;
-  int nc2 = _nc1 / 4;
-  int nc3 = 16 - 4 * (_nc1 % 4);
-  int step = 4 * (ldc - nc);
-  int step1 = 4 * (NC - nc);
-
-  asm volatile(
-      "vmov.f32   q14,    #0.0            \n\t"
-      "subs       %[mc], %[mc], #1        \n\t"
-      "blt        end_mc_%=               \n\t"
-      "loop_mc_%=:                        \n\t"
-
-      "mov        r5,   %[nc1]            \n\t"
-      "mov        r6,   %[nc2]            \n\t"
-      "vld1.32    {d0},   [%[scale]]      \n\t"
-      "vld1.32    {d1},   [%[bias]]       \n\t"
-      "vdup.32    q1,   d0[0]             \n\t"
-      "vdup.32    q2,   d1[0]             \n\t"
-
-      "subs       r5,   r5,   #1          \n\t"
-      "blt        end_nc1_%=              \n\t"
-      "loop_nc1_%=:                       \n\t"
-
-      "vld1.32    {q3, q4},   [%[c]]!     \n\t"
-      "vmul.f32   q10,  q3,   q1          \n\t"
-      "vmul.f32   q11,  q4,   q1          \n\t"
-      "vadd.f32   q10,  q10,  q2          \n\t"
-      "vadd.f32   q11,  q11,  q2          \n\t"
-      "vmax.f32   q10,  q10,  q14         \n\t"
-      "vmax.f32   q11,  q11,  q14         \n\t"
-      "vst1.32    {q10, q11}, [%[C]]!     \n\t"
-
-      "vld1.32    {q5, q6},   [%[c]]!     \n\t"
-      "vmul.f32   q12,  q5,   q1          \n\t"
-      "vmul.f32   q13,  q6,   q1          \n\t"
-      "vadd.f32   q12,  q12,  q2          \n\t"
-      "vadd.f32   q13,  q13,  q2          \n\t"
-      "vmax.f32   q12,  q12,  q14         \n\t"
-      "vmax.f32   q13,  q13,  q14         \n\t"
-      "vst1.32    {q12, q13}, [%[C]]!     \n\t"
-
-      "subs       r5,   r5,   #1          \n\t"
-      "bge        loop_nc1_%=             \n\t"
-      "end_nc1_%=:                        \n\t"
-
-      "subs       r6,  r6,   #1           \n\t"
-      "blt        end_nc2_%=              \n\t"
-      "loop_nc2_%=:                       \n\t"
-
-      "vld1.32    {q7},       [%[c]]!     \n\t"
-      "vmul.f32   q10,  q7,   q1          \n\t"
-      "vadd.f32   q10,  q10,  q2          \n\t"
-      "vmax.f32   q10,  q10,  q14         \n\t"
-      "vst1.32    {q10},      [%[C]]!     \n\t"
-
-      "subs       r6,   r6,   #1          \n\t"
-      "bge        loop_nc2_%=             \n\t"
-      "end_nc2_%=:                        \n\t"
-
-      "cmp        %[nc3],    #16          \n\t"
-      "beq        end_nc3_%=              \n\t"
-
-      "sub        %[c],     %[c],   %[nc3]      \n\t"
-      "sub        %[C],     %[C],   %[nc3]      \n\t"
-
-      "vld1.32    {q8},       [%[c]]!     \n\t"
-      "vmul.f32   q11,  q8,   q1          \n\t"
-      "vadd.f32   q11,  q11,  q2          \n\t"
-      "vmax.f32   q11,  q11,  q14         \n\t"
-      "vst1.32    {q11},      [%[C]]!     \n\t"
-      "end_nc3_%=:                        \n\t"
-
-      "add        %[scale], %[scale], #4        \n\t"
-      "add        %[bias],  %[bias],  #4        \n\t"
-      "add        %[c],     %[c],     %[step1]  \n\t"
-      "add        %[C],     %[C],     %[step]   \n\t"
-
-      "subs       %[mc], %[mc], #1        \n\t"
-      "bge        loop_mc_%=              \n\t"
-      "end_mc_%=:                         \n\t"
-
-      :
-      : [C] "r"(C), [c] "r"(c), [mc] "r"(mc), [nc1] "r"(nc1), [nc2] "r"(nc2),
-        [nc3] "r"(nc3), [step] "r"(step), [step1] "r"(step1),
-        [scale] "r"(scale), [bias] "r"(bias)
-      : "memory", "r5", "r6", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7",
-        "q8", "q10", "q11", "q12", "q13", "q14");
-}
-
-// C = A * B, batchnorm(C),C = C + bias; relu(C)
-void Gemm::WriteWithBnAddRelu(int mc, int nc, float *c, float *C, int ldc,
-                              float *new_scale, float *new_bias, float *bias) {
-  int nc1 = nc / 4;
-  int _nc1 = nc % 4;
-
-  float *c_ptr, *C_ptr, *bias_ptr;
-  float32x4_t cv;
-  float32x4_t nbias;
-  float32x2_t scale;
-  float32x4_t biasv;
-  float32x4_t zero = vdupq_n_f32(0.0);
-  for (int i = 0; i < mc; ++i) {
-    c_ptr = c + i * NC;
-    C_ptr = C + i * ldc;
-    bias_ptr = bias + i * ldc;
-    nbias = vld1q_dup_f32(new_bias);
-    scale = vld1_dup_f32(new_scale);
-    new_bias++;
-    new_scale++;
-    float scale0 = vget_lane_f32(scale, 0);
-    for (int j = 0; j < nc1; ++j) {
-      cv = vld1q_f32(c_ptr);
-      biasv = vld1q_f32(bias_ptr);
-      cv = vmlaq_n_f32(nbias, cv, scale0);
-      cv = vaddq_f32(cv, biasv);
-      cv = vmaxq_f32(cv, zero);
-      vst1q_f32(C_ptr, cv);
-      c_ptr += 4;
-      C_ptr += 4;
-      bias_ptr += 4;
-    }
-    if (_nc1 != 0) {
-      cv = vld1q_f32(c_ptr);
-      biasv = vld1q_f32(bias_ptr);
-      cv = vmlaq_n_f32(nbias, cv, scale0);
-      cv = vaddq_f32(cv, biasv);
-      cv = vmaxq_f32(cv, zero);
-      if (_nc1 >= 1) {
-        vst1q_lane_f32(C_ptr, cv, 0);
-        C_ptr++;
-      }
-      if (_nc1 >= 2) {
-        vst1q_lane_f32(C_ptr, cv, 1);
-        C_ptr++;
-      }
-      if (_nc1 >= 3) {
-        vst1q_lane_f32(C_ptr, cv, 2);
-      }
-    }
-  }
-}
-
-// C = A * B
-void Gemm::VecWriteBasic(int n, float *c, float *C, int ldc) {
-  int nc1 = n / 16;
-  int _nc1 = n % 16;
-  int nc2 = _nc1 / 4;
-  int nc3 = 16 - 4 * (_nc1 % 4);
-
-  asm volatile(
-      "subs       %[nc1],   %[nc1],   #1  \n\t"
-      "blt        end_nc1_%=              \n\t"
-      "loop_nc1_%=:                       \n\t"
-
-      "vld1.32    {q0, q1}, [%[c]]!       \n\t"
-      "vst1.32    {q0, q1}, [%[C]]!       \n\t"
-
-      "vld1.32    {q2, q3}, [%[c]]!       \n\t"
-      "vst1.32    {q2, q3}, [%[C]]!       \n\t"
-
-      "subs       %[nc1],   %[nc1],   #1  \n\t"
-      "bge        loop_nc1_%=             \n\t"
-      "end_nc1_%=:                        \n\t"
-
-      "subs       %[nc2],   %[nc2],   #1  \n\t"
-      "blt        end_nc2_%=              \n\t"
-      "loop_nc2_%=:                       \n\t"
-
-      "vld1.32    {q4},     [%[c]]!       \n\t"
-      "vst1.32    {q4},     [%[C]]!       \n\t"
-
-      "subs       %[nc2],   %[nc2],   #1  \n\t"
-      "bge        loop_nc2_%=             \n\t"
-      "end_nc2_%=:                        \n\t"
-
-      "cmp        %[nc3],    #16          \n\t"
-      "beq        end_nc3_%=              \n\t"
-      "sub        %[c],     %[c],   %[nc3]    \n\t"
-      "sub        %[C],     %[C],   %[nc3]    \n\t"
-      "vld1.32    {q5},     [%[c]]!       \n\t"
-      "vst1.32    {q5},     [%[C]]!       \n\t"
-      "end_nc3_%=:                        \n\t"
+      "cmp        %[nc3],    #16          \n\t"
+      "beq        end_nc3_%=              \n\t"
+      "sub        %[c],     %[c],   %[nc3]    \n\t"
+      "sub        %[C],     %[C],   %[nc3]    \n\t"
+      "vld1.32    {q5},     [%[c]]!       \n\t"
+      "vst1.32    {q5},     [%[C]]!       \n\t"
+      "end_nc3_%=:                        \n\t"
 
       :
       : [C] "r"(C), [c] "r"(c), [nc1] "r"(nc1), [nc2] "r"(nc2), [nc3] "r"(nc3)
@@ -3246,89 +2486,222 @@ void Gemm::VecWriteWithBnRelu(int n, float *c, float *C, int ldc, float *scale,
 }
 
 #endif  // __aarch64__
+#else
+
+#if defined(__x86_64__) || defined(__i386__)
+// c = A * B, A 只有一行
+AVX2_TARGET static void VectorDotAvx2(int n, int k, const float *A,
+                                      const float *B, int ldb, float *c) {
+  memset(c, 0, n * sizeof(float));
+  for (int p = 0; p < k; ++p) {
+    const float *b = B + p * ldb;
+    __m256 av = _mm256_set1_ps(A[p]);
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+      __m256 c0 = _mm256_loadu_ps(c + j);
+      __m256 c1 = _mm256_loadu_ps(c + j + 8);
+      c0 = _mm256_fmadd_ps(av, _mm256_loadu_ps(b + j), c0);
+      c1 = _mm256_fmadd_ps(av, _mm256_loadu_ps(b + j + 8), c1);
+      _mm256_storeu_ps(c + j, c0);
+      _mm256_storeu_ps(c + j + 8, c1);
+    }
+    for (; j < n; ++j) {
+      c[j] += A[p] * b[j];
+    }
+  }
+}
+#endif  // __x86_64__
+
+void Gemm::VectorKernel(int m, int n, int k, float alpha, const float *A,
+                        int lda, const float *B, int ldb, float beta, float *C,
+                        int ldc, bool relu) {
+  framework::WorkspaceScope scratch;
+  float *bufferC = scratch.Allocate<float>(n);
+#if defined(__x86_64__) || defined(__i386__)
+  if (HasAvx2()) {
+    VectorDotAvx2(n, k, A, B, ldb, bufferC);
+  } else {
+#endif  // __x86_64__
+    memset(bufferC, 0, n * sizeof(float));
+    for (int p = 0; p < k; ++p) {
+      const float *b = B + p * ldb;
+      for (int j = 0; j < n; ++j) {
+        bufferC[j] += A[p] * b[j];
+      }
+    }
+#if defined(__x86_64__) || defined(__i386__)
+  }
+#endif  // __x86_64__
+
+  if (alpha != 1) {
+    VecWriteWithAlphaBeta(n, bufferC, C, ldc);
+  } else if (beta == 0) {
+    VecWriteBasic(n, bufferC, C, ldc);
+  } else if (beta == 1 && !relu) {
+    VecWriteWithAdd(n, bufferC, C, ldc);
+  } else if (beta == 1 && relu) {
+    VecWriteWithAddRelu(n, bufferC, C, ldc);
+  }
+}
+
+void Gemm::VectorKernelWithBn(int m, int n, int k, float alpha, const float *A,
+                              int lda, const float *B, int ldb, float beta,
+                              float *C, int ldc, bool relu, float *new_scale,
+                              float *new_bias) {
+  framework::WorkspaceScope scratch;
+  float *bufferC = scratch.Allocate<float>(n);
+#if defined(__x86_64__) || defined(__i386__)
+  if (HasAvx2()) {
+    VectorDotAvx2(n, k, A, B, ldb, bufferC);
+  } else {
+#endif  // __x86_64__
+    memset(bufferC, 0, n * sizeof(float));
+    for (int p = 0; p < k; ++p) {
+      const float *b = B + p * ldb;
+      for (int j = 0; j < n; ++j) {
+        bufferC[j] += A[p] * b[j];
+      }
+    }
+#if defined(__x86_64__) || defined(__i386__)
+  }
+#endif  // __x86_64__
+
+  if (relu) {
+    VecWriteWithBnRelu(n, bufferC, C, ldc, new_scale, new_bias);
+  } else {
+    VecWriteWithBn(n, bufferC, C, ldc, new_scale, new_bias);
+  }
+}
+
+// C = A * B
+void Gemm::VecWriteBasic(int n, float *c, float *C, int ldc) {
+  memcpy(C, c, n * sizeof(float));
+}
+
+// C = alpha * A * B + beta * C
+void Gemm::VecWriteWithAlphaBeta(int n, float *c, float *C, int ldc) {}
+
+// C = A * B + C
+void Gemm::VecWriteWithAdd(int n, float *c, float *C, int ldc) {
+  for (int j = 0; j < n; ++j) {
+    C[j] += c[j];
+  }
+}
+
+// C = A * B + C, relu(C)
+void Gemm::VecWriteWithAddRelu(int n, float *c, float *C, int ldc) {
+  for (int j = 0; j < n; ++j) {
+    C[j] = std::max(C[j] + c[j], 0.f);
+  }
+}
+
+// C = A * B, batchnorm(C)
+void Gemm::VecWriteWithBn(int n, float *c, float *C, int ldc, float *scale,
+                          float *bias) {
+  for (int j = 0; j < n; ++j) {
+    C[j] = c[j] * scale[j] + bias[j];
+  }
+}
+
+// C = A * B, batchnorm(C), relu(C)
+void Gemm::VecWriteWithBnRelu(int n, float *c, float *C, int ldc, float *scale,
+                              float *bias) {
+  for (int j = 0; j < n; ++j) {
+    C[j] = std::max(c[j] * scale[j] + bias[j], 0.f);
+  }
+}
 #endif  // __ARM_NEON
 
 // 32位 float 矩阵乘法
+// k 按 KC 分块时, 第一块按 beta 和 bias 回写, 其余的块累加到 C 上, relu 只
+// 在最后一块回写时做
 void Gemm::Sgemm(int m, int n, int k, float alpha, const float *A, int lda,
                  const float *B, int ldb, float beta, float *C, int ldc,
                  bool relu, float *bias) {
-  // L1 data cache is 32 kib (Per Contex-A57, Contex-A72, Contex-A73)
-  // L2 cache is 0.5~4 Mib (Contex-A72 cluster)
-  int L1 = 32 * 1024;
-  int L2 = 512 * 1024;
-
-  KC = k;
+  // L1/L2 cache budgets from the detected cache sizes
+  const GemmBlocking blocking = Blocking(m, n, k, 1);
+  int L1 = GetCPUInfo().l1_cache * blocking.scale;
+  int L2 = GetCPUInfo().l2_cache * blocking.scale;
+  const bool alt = blocking.micro_kernel == MICRO_KERNEL_ALT;
+  const int mr = alt ? MR_ALT : MR;
+  const int nr = alt ? NR_ALT : NR;
+  const int kc = (blocking.kc > 0 && blocking.kc < k) ? blocking.kc : k;
+
+  KC = kc;
   MC = L1 / (KC * sizeof(float));
   NC = L2 / (KC * sizeof(float));
 
   // make sure MC is multiple of MR, and NC is multiple of NR
   if (MC == 0) {
-    MC = MR;
+    MC = mr;
   } else {
     int mblock_num = (m + MC - 1) / MC;
     MC = (m + mblock_num - 1) / mblock_num;
-    MC = (MC + MR - 1) / MR * MR;
+    MC = (MC + mr - 1) / mr * mr;
   }
   //  DLOG << "mblock_num = " << mblock_num << ", MC = " << MC << "\n";
   if (NC == 0) {
-    NC = NR;
+    NC = nr;
   } else {
     int nblock_num = (n + NC - 1) / NC;
     NC = (n + nblock_num - 1) / nblock_num;
-    NC = (NC + NR - 1) / NR * NR;
+    NC = (NC + nr - 1) / nr * nr;
   }
   //  DLOG << "nblock_num = " << nblock_num << ", NC = " << NC << "\n";
 
-  packedA = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * MC * KC));
-  packedB = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * KC * NC));
-  packedC = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * MC * NC));
-  zero = static_cast<float *>(paddle_mobile::memory::Alloc(sizeof(float) * KC));
+  framework::WorkspaceScope scratch;
+  packedA = scratch.Allocate<float>(MC * KC);
+  packedB = scratch.Allocate<float>(KC * NC);
+  packedC = scratch.Allocate<float>(MC * NC);
+  zero = scratch.Allocate<float>(KC);
   memset(static_cast<void *>(zero), 0, sizeof(float) * KC);
 
-  int mc, nc;
-  for (int j = 0; j < n; j += NC) {
-    nc = s_min(n - j, NC);
-#if __aarch64__
-    // PackMatrixB_12c(KC, nc, nc % NR, &B(0, j), ldb, packedB);
-    PackMatrixB_16c(KC, nc, nc % NR, &B(0, j), ldb, packedB);
-#else
-    PackMatrixB_8c(KC, nc, nc % NR, &B(0, j), ldb, packedB);
-#endif
-    for (int i = 0; i < m; i += MC) {
-      mc = s_min(m - i, MC);
 #if __aarch64__
-      PackMatrixA_6r(mc, KC, mc % MR, &A(i, 0), lda, packedA);
-      // PackMatrixA_8r(mc, KC, mc % MR, &A(i, 0), lda, packedA);
+  if (alt) {
+    procPackA = &Gemm::PackMatrixA_8r;
+    procPackB = &Gemm::PackMatrixB_12c;
+  } else {
+    procPackA = &Gemm::PackMatrixA_6r;
+    procPackB = &Gemm::PackMatrixB_16c;
+  }
 #else
-      PackMatrixA_6r(mc, KC, mc % MR, &A(i, 0), lda, packedA);
+  procPackB = &Gemm::PackMatrixB_8c;
+  if (alt) {
+    procPackA = &Gemm::PackMatrixA_4r;
+  } else {
+    procPackA = &Gemm::PackMatrixA_6r;
+  }
 #endif
-      if (bias == nullptr) {
-        InnerKernelWithBias(mc, nc, alpha, packedA, packedB, beta, packedC,
-                            &C(i, j), ldc, relu, nullptr);
-      } else {
-        InnerKernelWithBias(mc, nc, alpha, packedA, packedB, beta, packedC,
-                            &C(i, j), ldc, relu, bias + i);
+  micro_kernel_ = alt ? MICRO_KERNEL_ALT : MICRO_KERNEL_DEFAULT;
+
+  int mc, nc;
+  for (int j = 0; j < n; j += NC) {
+    nc = s_min(n - j, NC);
+    for (int p = 0; p < k; p += kc) {
+      KC = s_min(k - p, kc);
+      const bool first = p == 0;
+      const bool last = p + KC == k;
+      (*this.*procPackB)(KC, nc, nc % nr, &B(p, j), ldb, packedB);
+      for (int i = 0; i < m; i += MC) {
+        mc = s_min(m - i, MC);
+        (*this.*procPackA)(mc, KC, mc % mr, &A(i, p), lda, packedA);
+        InnerKernelWithBias(mc, nc, alpha, packedA, packedB, first ? beta : 1.f,
+                            packedC, &C(i, j), ldc, relu && last,
+                            (first && bias != nullptr) ? bias + i : nullptr);
       }
     }
   }
-
-  paddle_mobile::memory::Free(packedA);
-  paddle_mobile::memory::Free(packedB);
-  paddle_mobile::memory::Free(packedC);
-  paddle_mobile::memory::Free(zero);
+  micro_kernel_ = MICRO_KERNEL_DEFAULT;
 }
 
 void Gemm::SgemmWithBn(int m, int n, int k, float alpha, const float *A,
                        int lda, const float *B, int ldb, float beta, float *C,
                        int ldc, bool relu, float *new_scale, float *new_bias,
                        float *bias) {
-  // L1 data cache is 32 kib (Per Contex-A57, Contex-A72, Contex-A73)
-  // L2 cache is 0.5~4 Mib (Contex-A72 cluster)
-  int L1 = 32 * 1024;
-  int L2 = 512 * 1024;
+  // L1/L2 cache budgets from the detected cache sizes
+  float scale = BlockingScale(m, n, k, 1);
+  int L1 = GetCPUInfo().l1_cache * scale;
+  int L2 = GetCPUInfo().l2_cache * scale;
 
   KC = k;
   MC = L1 / (KC * sizeof(float));
@@ -3352,13 +2725,11 @@ void Gemm::SgemmWithBn(int m, int n, int k, float alpha, const float *A,
   }
   //  DLOG << "nblock_num = " << nblock_num << ", NC = " << NC << "\n";
 
-  packedA = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * MC * KC));
-  packedB = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * KC * NC));
-  packedC = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * MC * NC));
-  zero = static_cast<float *>(paddle_mobile::memory::Alloc(sizeof(float) * KC));
+  framework::WorkspaceScope scratch;
+  packedA = scratch.Allocate<float>(MC * KC);
+  packedB = scratch.Allocate<float>(KC * NC);
+  packedC = scratch.Allocate<float>(MC * NC);
+  zero = scratch.Allocate<float>(KC);
   memset(static_cast<void *>(zero), 0, sizeof(float) * KC);
 
   int mc, nc;
@@ -3388,20 +2759,15 @@ void Gemm::SgemmWithBn(int m, int n, int k, float alpha, const float *A,
       }
     }
   }
-
-  paddle_mobile::memory::Free(packedA);
-  paddle_mobile::memory::Free(packedB);
-  paddle_mobile::memory::Free(packedC);
-  paddle_mobile::memory::Free(zero);
 }
 
 void Gemm::SgemmWithPRelu(int m, int n, int k, const float *A, int lda,
                           const float *B, int ldb, float *C, int ldc, float *p,
                           std::string mode, float *bias, float *bias1) {
-  // L1 data cache is 32 kib (Per Contex-A57, Contex-A72, Contex-A73)
-  // L2 cache is 0.5~4 Mib (Contex-A72 cluster)
-  int L1 = 32 * 1024;
-  int L2 = 0.5 * 1024 * 1024;
+  // L1/L2 cache budgets from the detected cache sizes
+  float scale = BlockingScale(m, n, k, 1);
+  int L1 = GetCPUInfo().l1_cache * scale;
+  int L2 = GetCPUInfo().l2_cache * scale;
 
   KC = k;
   MC = L1 / (KC * sizeof(float));
@@ -3425,13 +2791,11 @@ void Gemm::SgemmWithPRelu(int m, int n, int k, const float *A, int lda,
   }
   //  DLOG << "nblock_num = " << nblock_num << ", NC = " << NC << "\n";
 
-  packedA = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * MC * KC));
-  packedB = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * KC * NC));
-  packedC = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * MC * NC));
-  zero = static_cast<float *>(paddle_mobile::memory::Alloc(sizeof(float) * KC));
+  framework::WorkspaceScope scratch;
+  packedA = scratch.Allocate<float>(MC * KC);
+  packedB = scratch.Allocate<float>(KC * NC);
+  packedC = scratch.Allocate<float>(MC * NC);
+  zero = scratch.Allocate<float>(KC);
 
   for (int l = 0; l < KC; ++l) {
     zero[l] = 0;
@@ -3463,11 +2827,6 @@ void Gemm::SgemmWithPRelu(int m, int n, int k, const float *A, int lda,
       }
     }
   }
-
-  paddle_mobile::memory::Free(packedA);
-  paddle_mobile::memory::Free(packedB);
-  paddle_mobile::memory::Free(packedC);
-  paddle_mobile::memory::Free(zero);
 }
 
 // 32位 float 矩阵乘法
@@ -3479,139 +2838,144 @@ void Gemm::Sgemm_omp(int m, int n, int k, float alpha, const float *A, int lda,
     return VectorKernel(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, relu);
   }
 #endif  // __aarch64__
-#ifdef _OPENMP
-  int max_threads = omp_get_max_threads();
-#else
-  int max_threads = 1;
-#endif
-
-  //  int L1 = 64 / max_threads * 1024;
-  int L = (max_threads > 2) ? 64 : 32;
-  int L1 = L / max_threads * 1024;
-  KC = k;
-  zero = static_cast<float *>(paddle_mobile::memory::Alloc(sizeof(float) * KC));
+  int max_threads = ThreadPool::Instance()->ThreadNum();
+  const GemmBlocking blocking = Blocking(m, n, k, max_threads);
+  const bool alt = blocking.micro_kernel == MICRO_KERNEL_ALT;
+  const int mr = alt ? MR_ALT : MR;
+  const int nr = alt ? NR_ALT : NR;
+  const int kc = (blocking.kc > 0 && blocking.kc < k) ? blocking.kc : k;
+
+  // each thread takes a share of the L1 budget, two L1 caches for more than
+  // two threads
+  int L = (max_threads > 2) ? 2 : 1;
+  int L1 = GetCPUInfo().l1_cache * blocking.scale * L / max_threads;
+  KC = kc;
+  framework::WorkspaceScope scratch;
+  zero = scratch.Allocate<float>(KC);
   memset(static_cast<void *>(zero), 0, sizeof(float) * KC);
   if (m > n) {
     // 对 A 分块
     MC = L1 / (KC * sizeof(float));
     if (MC == 0) {
-      MC = MR;
+      MC = mr;
     } else {
       int mblock_num = (m + MC - 1) / MC;
       MC = (m + mblock_num - 1) / mblock_num;
-      MC = (MC + MR - 1) / MR * MR;
+      MC = (MC + mr - 1) / mr * mr;
     }
     // 补齐 B
-    NC = (n + NR - 1) / NR * NR;
+    NC = (n + nr - 1) / nr * nr;
 
 #if __aarch64__
-    procPackA = &Gemm::PackMatrixA_6r;
-    procPackB = &Gemm::PackMatrixB_omp_16c;
-    procAddDot = &Gemm::AddDot6x16;
+    if (alt) {
+      procPackA = &Gemm::PackMatrixA_8r;
+      procPackB = &Gemm::PackMatrixB_omp_12c;
+      procAddDot = &Gemm::AddDot8x12;
+    } else {
+      procPackA = &Gemm::PackMatrixA_6r;
+      procPackB = &Gemm::PackMatrixB_omp_16c;
+      procAddDot = &Gemm::AddDot6x16;
+    }
 #else
-    procPackA = &Gemm::PackMatrixA_6r;
     procPackB = &Gemm::PackMatrixB_omp_8c;
-    procAddDot = &Gemm::AddDot6x8;
+    if (alt) {
+      procPackA = &Gemm::PackMatrixA_4r;
+      procAddDot = &Gemm::AddDot4x8;
+    } else {
+      procPackA = &Gemm::PackMatrixA_6r;
+      procAddDot = &Gemm::AddDot6x8;
+    }
 #endif
 
-    packedB = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * KC * NC));
-    (*this.*procPackB)(KC, n, n % NR, B, ldb, packedB);
-    packedA = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * MC * KC * max_threads));
+    packedB = scratch.Allocate<float>(KC * NC);
+    packedA = scratch.Allocate<float>(MC * KC * max_threads);
   } else {
     // 对 B 分块
     NC = L1 / (KC * sizeof(float));
     if (NC == 0) {
-      NC = NR;
+      NC = nr;
     } else {
       int nblock_num = (n + NC - 1) / NC;
       NC = (n + nblock_num - 1) / nblock_num;
-      NC = (NC + NR - 1) / NR * NR;
+      NC = (NC + nr - 1) / nr * nr;
     }
     // 补齐 A
-    MC = (m + MR - 1) / MR * MR;
+    MC = (m + mr - 1) / mr * mr;
 
 #if __aarch64__
-    procPackA = &Gemm::PackMatrixA_omp_6r;
-    procPackB = &Gemm::PackMatrixB_16c;
-    procAddDot = &Gemm::AddDot6x16;
+    if (alt) {
+      procPackA = &Gemm::PackMatrixA_omp_8r;
+      procPackB = &Gemm::PackMatrixB_12c;
+      procAddDot = &Gemm::AddDot8x12;
+    } else {
+      procPackA = &Gemm::PackMatrixA_omp_6r;
+      procPackB = &Gemm::PackMatrixB_16c;
+      procAddDot = &Gemm::AddDot6x16;
+    }
 #else
-
-    procPackA = &Gemm::PackMatrixA_omp_6r;
     procPackB = &Gemm::PackMatrixB_8c;
-    procAddDot = &Gemm::AddDot6x8;
-#endif
-
-    packedA = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * MC * KC));
-    (*this.*procPackA)(m, KC, m % MR, A, lda, packedA);
-    packedB = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * KC * NC * max_threads));
-  }
-  packedC = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * MC * NC * max_threads));
-
-  if (m > n) {
-#pragma omp parallel for
-    for (int i = 0; i < m; i += MC) {
-#ifdef _OPENMP
-      int local_threads = omp_get_thread_num();
-#else
-      int local_threads = 0;
-#endif
-
-      int mc;
-      mc = s_min(m - i, MC);
-      float *local_A = packedA + MC * KC * local_threads;
-      float *local_C = packedC + MC * NC * local_threads;
-      (*this.*procPackA)(mc, KC, mc % MR, &A(i, 0), lda, local_A);
-      if (bias == nullptr) {
-        InnerKernelWithBias(mc, n, alpha, local_A, packedB, beta, local_C,
-                            &C(i, 0), ldc, relu, nullptr);
-      } else {
-        InnerKernelWithBias(mc, n, alpha, local_A, packedB, beta, local_C,
-                            &C(i, 0), ldc, relu, bias + i);
-      }
+    if (alt) {
+      procPackA = &Gemm::PackMatrixA_4r;
+      procAddDot = &Gemm::AddDot4x8;
+    } else {
+      procPackA = &Gemm::PackMatrixA_omp_6r;
+      procAddDot = &Gemm::AddDot6x8;
     }
-  } else {
-#pragma omp parallel for
-    for (int j = 0; j < n; j += NC) {
-#ifdef _OPENMP
-      int local_threads = omp_get_thread_num();
-#else
-      int local_threads = 0;
 #endif
 
-      int nc;
-      nc = s_min(n - j, NC);
-      float *local_B = packedB + KC * NC * local_threads;
-      float *local_C = packedC + MC * NC * local_threads;
-      (*this.*procPackB)(KC, nc, nc % NR, &B(0, j), ldb, local_B);
-      InnerKernelWithBias(m, nc, alpha, packedA, local_B, beta, local_C,
-                          &C(0, j), ldc, relu, bias);
-    }
-  }
-
-  paddle_mobile::memory::Free(packedA);
-  paddle_mobile::memory::Free(packedB);
-  paddle_mobile::memory::Free(packedC);
-  paddle_mobile::memory::Free(zero);
+    packedA = scratch.Allocate<float>(MC * KC);
+    packedB = scratch.Allocate<float>(KC * NC * max_threads);
+  }
+  packedC = scratch.Allocate<float>(MC * NC * max_threads);
+  micro_kernel_ = alt ? MICRO_KERNEL_ALT : MICRO_KERNEL_DEFAULT;
+
+  // k 按 KC 分块, 回写同 Sgemm
+  for (int p = 0; p < k; p += kc) {
+    KC = s_min(k - p, kc);
+    const float block_beta = p == 0 ? beta : 1.f;
+    const bool block_relu = relu && p + KC == k;
+    float *block_bias = p == 0 ? bias : nullptr;
+    if (m > n) {
+      (*this.*procPackB)(KC, n, n % nr, &B(p, 0), ldb, packedB);
+      parallel_for_tid(0, (m + MC - 1) / MC, [&](int ib, int local_threads) {
+        int i = ib * MC;
+        int mc;
+        mc = s_min(m - i, MC);
+        float *local_A = packedA + MC * KC * local_threads;
+        float *local_C = packedC + MC * NC * local_threads;
+        (*this.*procPackA)(mc, KC, mc % mr, &A(i, p), lda, local_A);
+        InnerKernelWithBias(mc, n, alpha, local_A, packedB, block_beta,
+                            local_C, &C(i, 0), ldc, block_relu,
+                            block_bias == nullptr ? nullptr : block_bias + i);
+      });
+    } else {
+      (*this.*procPackA)(m, KC, m % mr, &A(0, p), lda, packedA);
+      parallel_for_tid(0, (n + NC - 1) / NC, [&](int jb, int local_threads) {
+        int j = jb * NC;
+        int nc;
+        nc = s_min(n - j, NC);
+        float *local_B = packedB + KC * NC * local_threads;
+        float *local_C = packedC + MC * NC * local_threads;
+        (*this.*procPackB)(KC, nc, nc % nr, &B(p, j), ldb, local_B);
+        InnerKernelWithBias(m, nc, alpha, packedA, local_B, block_beta,
+                            local_C, &C(0, j), ldc, block_relu, block_bias);
+      });
+    }
+  }
+  micro_kernel_ = MICRO_KERNEL_DEFAULT;
 }
 
 void Gemm::SgemmWithBn_omp(int m, int n, int k, float alpha, const float *A,
                            int lda, const float *B, int ldb, float beta,
                            float *C, int ldc, bool relu, float *new_scale,
                            float *new_bias, float *bias) {
-#ifdef _OPENMP
-  int max_threads = omp_get_max_threads();
-#else
-  int max_threads = 1;
-#endif
+  int max_threads = ThreadPool::Instance()->ThreadNum();
 
-  int L1 = 64 / max_threads * 1024;
+  int L1 = GetCPUInfo().l1_cache * BlockingScale(m, n, k, max_threads) * 2 /
+           max_threads;
   KC = k;
-  zero = static_cast<float *>(paddle_mobile::memory::Alloc(sizeof(float) * KC));
+  framework::WorkspaceScope scratch;
+  zero = scratch.Allocate<float>(KC);
   memset(static_cast<void *>(zero), 0, sizeof(float) * KC);
   if (m > n) {
     // 对 A 分块
@@ -3636,11 +3000,9 @@ void Gemm::SgemmWithBn_omp(int m, int n, int k, float alpha, const float *A,
     procAddDot = &Gemm::AddDot6x8;
 #endif
 
-    packedB = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * KC * NC));
+    packedB = scratch.Allocate<float>(KC * NC);
     (*this.*procPackB)(KC, n, n % NR, B, ldb, packedB);
-    packedA = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * MC * KC * max_threads));
+    packedA = scratch.Allocate<float>(MC * KC * max_threads);
   } else {
     // 对 B 分块
     NC = L1 / (KC * sizeof(float));
@@ -3664,24 +3026,15 @@ void Gemm::SgemmWithBn_omp(int m, int n, int k, float alpha, const float *A,
     procAddDot = &Gemm::AddDot6x8;
 #endif
 
-    packedA = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * MC * KC));
+    packedA = scratch.Allocate<float>(MC * KC);
     (*this.*procPackA)(m, KC, m % MR, A, lda, packedA);
-    packedB = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * KC * NC * max_threads));
+    packedB = scratch.Allocate<float>(KC * NC * max_threads);
   }
-  packedC = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * MC * NC * max_threads));
+  packedC = scratch.Allocate<float>(MC * NC * max_threads);
 
   if (m > n) {
-#pragma omp parallel for
-    for (int i = 0; i < m; i += MC) {
-#ifdef _OPENMP
-      int local_threads = omp_get_thread_num();
-#else
-      int local_threads = 0;
-#endif
-
+    parallel_for_tid(0, (m + MC - 1) / MC, [&](int ib, int local_threads) {
+      int i = ib * MC;
       int mc;
       mc = s_min(m - i, MC);
       float *local_A = packedA + MC * KC * local_threads;
@@ -3695,16 +3048,10 @@ void Gemm::SgemmWithBn_omp(int m, int n, int k, float alpha, const float *A,
                              &C(i, 0), ldc, relu, new_scale + i, new_bias + i,
                              bias + i * ldc);
       }
-    }
+    });
   } else {
-#pragma omp parallel for
-    for (int j = 0; j < n; j += NC) {
-#ifdef _OPENMP
-      int local_threads = omp_get_thread_num();
-#else
-      int local_threads = 0;
-#endif
-
+    parallel_for_tid(0, (n + NC - 1) / NC, [&](int jb, int local_threads) {
+      int j = jb * NC;
       int nc;
       nc = s_min(n - j, NC);
       float *local_B = packedB + KC * NC * local_threads;
@@ -3718,28 +3065,20 @@ void Gemm::SgemmWithBn_omp(int m, int n, int k, float alpha, const float *A,
                              &C(0, j), ldc, relu, new_scale, new_bias,
                              bias + j);
       }
-    }
+    });
   }
-
-  paddle_mobile::memory::Free(packedA);
-  paddle_mobile::memory::Free(packedB);
-  paddle_mobile::memory::Free(packedC);
-  paddle_mobile::memory::Free(zero);
 }
 
 void Gemm::SgemmWithPRelu_omp(int m, int n, int k, const float *A, int lda,
                               const float *B, int ldb, float *C, int ldc,
                               float *p, std::string mode, float *bias,
                               float *bias1) {
-#ifdef _OPENMP
-  int max_threads = omp_get_max_threads();
-#else
-  int max_threads = 1;
-#endif
+  int max_threads = ThreadPool::Instance()->ThreadNum();
 
-  int L1 = 8 * 1024;
+  int L1 = GetCPUInfo().l1_cache * BlockingScale(m, n, k, max_threads) / 4;
   KC = k;
-  zero = static_cast<float *>(paddle_mobile::memory::Alloc(sizeof(float) * KC));
+  framework::WorkspaceScope scratch;
+  zero = scratch.Allocate<float>(KC);
   memset(static_cast<void *>(zero), 0, sizeof(float) * KC);
   if (m > n) {
     // 对 A 分块
@@ -3764,11 +3103,9 @@ void Gemm::SgemmWithPRelu_omp(int m, int n, int k, const float *A, int lda,
     procAddDot = &Gemm::AddDot6x8;
 #endif
 
-    packedB = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * KC * NC));
+    packedB = scratch.Allocate<float>(KC * NC);
     (*this.*procPackB)(KC, n, n % NR, B, ldb, packedB);
-    packedA = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * MC * KC * max_threads));
+    packedA = scratch.Allocate<float>(MC * KC * max_threads);
   } else {
     // 对 B 分块
     NC = L1 / (KC * sizeof(float));
@@ -3792,24 +3129,15 @@ void Gemm::SgemmWithPRelu_omp(int m, int n, int k, const float *A, int lda,
     procAddDot = &Gemm::AddDot6x8;
 #endif
 
-    packedA = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * MC * KC));
+    packedA = scratch.Allocate<float>(MC * KC);
     (*this.*procPackA)(m, KC, m % MR, A, lda, packedA);
-    packedB = static_cast<float *>(
-        paddle_mobile::memory::Alloc(sizeof(float) * KC * NC * max_threads));
+    packedB = scratch.Allocate<float>(KC * NC * max_threads);
   }
-  packedC = static_cast<float *>(
-      paddle_mobile::memory::Alloc(sizeof(float) * MC * NC * max_threads));
+  packedC = scratch.Allocate<float>(MC * NC * max_threads);
 
   if (m > n) {
-#pragma omp parallel for
-    for (int i = 0; i < m; i += MC) {
-#ifdef _OPENMP
-      int local_threads = omp_get_thread_num();
-#else
-      int local_threads = 0;
-#endif
-
+    parallel_for_tid(0, (m + MC - 1) / MC, [&](int ib, int local_threads) {
+      int i = ib * MC;
       int mc;
       mc = s_min(m - i, MC);
       float *local_A = packedA + MC * KC * local_threads;
@@ -3822,16 +3150,10 @@ void Gemm::SgemmWithPRelu_omp(int m, int n, int k, const float *A, int lda,
         InnerKernelWithPRelu(mc, n, local_A, packedB, local_C, &C(i, 0), ldc,
                              p + i, mode, bias + i, bias1 + i * ldc);
       }
-    }
+    });
   } else {
-#pragma omp parallel for
-    for (int j = 0; j < n; j += NC) {
-#ifdef _OPENMP
-      int local_threads = omp_get_thread_num();
-#else
-      int local_threads = 0;
-#endif
-
+    parallel_for_tid(0, (n + NC - 1) / NC, [&](int jb, int local_threads) {
+      int j = jb * NC;
       int nc;
       nc = s_min(n - j, NC);
       float *local_B = packedB + KC * NC * local_threads;
@@ -3844,13 +3166,185 @@ void Gemm::SgemmWithPRelu_omp(int m, int n, int k, const float *A, int lda,
         InnerKernelWithPRelu(m, nc, packedA, local_B, local_C, &C(0, j), ldc, p,
                              mode, bias, bias1 + j);
       }
+    });
+  }
+}
+
+int Gemm::PackedASize(int m, int k) { return (m + MR - 1) / MR * MR * k; }
+
+int Gemm::PackedBSize(int k, int n) { return (n + NR - 1) / NR * NR * k; }
+
+// 预打包后 A 中以第 i 行(MR 的整数倍)开始的分块位于 buffer + i * k,
+// 与 PackMatrixA_6r 对该分块单独打包的结果相同
+void Gemm::PackWeightA(int m, int k, const float *A, int lda, float *buffer) {
+  framework::WorkspaceScope scratch;
+  zero = scratch.Allocate<float>(k);
+  memset(static_cast<void *>(zero), 0, sizeof(float) * k);
+  PackMatrixA_6r(m, k, m % MR, A, lda, buffer);
+  zero = nullptr;
+}
+
+// 预打包后 B 中以第 j 列(NR 的整数倍)开始的分块位于 buffer + j * k
+void Gemm::PackWeightB(int k, int n, const float *B, int ldb, float *buffer) {
+#if __aarch64__
+  PackMatrixB_omp_16c(k, n, n % NR, B, ldb, buffer);
+#else
+  PackMatrixB_omp_8c(k, n, n % NR, B, ldb, buffer);
+#endif
+}
+
+void Gemm::PackedBlocking(int m, int n, int k, int max_threads) {
+  int L = (max_threads > 2) ? 2 : 1;
+  int L1 = GetCPUInfo().l1_cache * BlockingScale(m, n, k, max_threads) * L /
+           max_threads;
+  KC = k;
+  if (m > n) {
+    // 对 A 分块
+    MC = L1 / (KC * sizeof(float));
+    if (MC == 0) {
+      MC = MR;
+    } else {
+      int mblock_num = (m + MC - 1) / MC;
+      MC = (m + mblock_num - 1) / mblock_num;
+      MC = (MC + MR - 1) / MR * MR;
+    }
+    // 补齐 B
+    NC = (n + NR - 1) / NR * NR;
+  } else {
+    // 对 B 分块
+    NC = L1 / (KC * sizeof(float));
+    if (NC == 0) {
+      NC = NR;
+    } else {
+      int nblock_num = (n + NC - 1) / NC;
+      NC = (n + nblock_num - 1) / nblock_num;
+      NC = (NC + NR - 1) / NR * NR;
     }
+    // 补齐 A
+    MC = (m + MR - 1) / MR * MR;
+  }
+}
+
+int Gemm::PackedAWorkspaceSize(int m, int n, int k, bool unpack) {
+  int max_threads = ThreadPool::Instance()->ThreadNum();
+  PackedBlocking(m, n, k, max_threads);
+  int packed_b_size = (m > n) ? KC * NC : KC * NC * max_threads;
+  int unpacked_a_size = 0;
+  if (unpack) {
+    unpacked_a_size = (m > n) ? MC * KC * max_threads : PackedASize(m, k);
   }
+  return packed_b_size + MC * NC * max_threads + unpacked_a_size;
+}
+
+int Gemm::PackedBWorkspaceSize(int m, int n, int k, bool unpack) {
+  int max_threads = ThreadPool::Instance()->ThreadNum();
+  PackedBlocking(m, n, k, max_threads);
+  int packed_a_size = (m > n) ? MC * KC * max_threads : MC * KC;
+  int unpacked_b_size = 0;
+  if (unpack) {
+    unpacked_b_size = (m > n) ? PackedBSize(k, n) : KC * NC * max_threads;
+  }
+  return packed_a_size + MC * NC * max_threads + KC + unpacked_b_size;
+}
+
+// 压缩结果中 scale 和 offset 的起始位置, 按 16 字节对齐
+static int CompressedScaleOffset(int packed_size) {
+  return (packed_size + 15) / 16 * 16;
+}
+
+int Gemm::CompressedSize(int packed_size, int k) {
+  int lines = packed_size / k;
+  return CompressedScaleOffset(packed_size) +
+         (2 * lines * sizeof(float) + 15) / 16 * 16;
+}
+
+// 打包后宽为 width 的分块中, 第 kk 个 width 元素依次属于分块的各行(列)
+static void CompressPacked(int packed_size, int k, int width,
+                           const float *packed, uint8_t *buffer) {
+  const int lines = packed_size / k;
+  float *scale =
+      reinterpret_cast<float *>(buffer + CompressedScaleOffset(packed_size));
+  float *offset = scale + lines;
+  for (int first = 0; first < lines; first += width) {
+    const float *panel = packed + first * k;
+    uint8_t *q = buffer + first * k;
+    for (int r = 0; r < width; ++r) {
+      float min_value = panel[r];
+      float max_value = panel[r];
+      for (int kk = 1; kk < k; ++kk) {
+        min_value = std::min(min_value, panel[kk * width + r]);
+        max_value = std::max(max_value, panel[kk * width + r]);
+      }
+      const float step = (max_value - min_value) / 255;
+      const float inv_step = step > 0 ? 1 / step : 0;
+      for (int kk = 0; kk < k; ++kk) {
+        float value = (panel[kk * width + r] - min_value) * inv_step + 0.5f;
+        q[kk * width + r] =
+            static_cast<uint8_t>(std::min(std::max(value, 0.f), 255.f));
+      }
+      scale[first + r] = step;
+      offset[first + r] = min_value;
+    }
+  }
+}
+
+void Gemm::CompressPackedA(int packed_size, int k, const float *packed_A,
+                           uint8_t *buffer) {
+  CompressPacked(packed_size, k, MR, packed_A, buffer);
+}
+
+void Gemm::CompressPackedB(int packed_size, int k, const float *packed_B,
+                           uint8_t *buffer) {
+  CompressPacked(packed_size, k, NR, packed_B, buffer);
+}
+
+void Gemm::DequantizePacked(int packed_size, int k, int width,
+                            const uint8_t *compressed, int first, int count,
+                            float *buffer) {
+  const int lines = packed_size / k;
+  const float *scale = reinterpret_cast<const float *>(
+      compressed + CompressedScaleOffset(packed_size));
+  const float *offset = scale + lines;
+  const int last = std::min(first + count, lines);
+  for (int i = first; i < last; i += width) {
+    const uint8_t *q = compressed + i * k;
+    const float *s = scale + i;
+    const float *o = offset + i;
+    float *out = buffer + (i - first) * k;
+    for (int kk = 0; kk < k; ++kk) {
+      for (int r = 0; r < width; ++r) {
+        out[r] = q[r] * s[r] + o[r];
+      }
+      q += width;
+      out += width;
+    }
+  }
+}
+
+void Gemm::UnpackPacked(int packed_size, int k, int width,
+                        const PackedMatrix &packed, int first, int count,
+                        float *buffer) {
+  if (packed.compressed != nullptr) {
+    DequantizePacked(packed_size, k, width, packed.compressed, first, count,
+                     buffer);
+    return;
+  }
+  // half 的排布与打包的 float 相同, 逐个转换即可. 与反量化一样转换到整个
+  // 分块为止, 最后的分块不足 width 行(列)时也是如此
+  const int blocks = (count + width - 1) / width;
+  const int last = std::min(first + blocks * width, packed_size / k);
+  HalfToFloat(packed.half_data + first * k, buffer, (last - first) * k);
+}
+
+GemmBlocking Gemm::Blocking(int m, int n, int k, int threads) {
+  if (fixed_blocking_) {
+    return blocking_;
+  }
+  return GemmTuner::Instance()->Blocking(m, n, k, threads);
+}
 
-  paddle_mobile::memory::Free(packedA);
-  paddle_mobile::memory::Free(packedB);
-  paddle_mobile::memory::Free(packedC);
-  paddle_mobile::memory::Free(zero);
+float Gemm::BlockingScale(int m, int n, int k, int threads) {
+  return Blocking(m, n, k, threads).scale;
 }
 
 }  // namespace math
@@ -15,10 +15,14 @@ limitations under the License. */
 #pragma once
 #include <cstring>
 #include <string>
+#include "common/cpu_info.h"
 #include "common/log.h"
+#include "common/threadpool.h"
+#include "common/types.h"
 #include "memory/t_malloc.h"
-#ifdef _OPENMP
-#include <omp.h>
+#include "operators/math/gemm_tuner.h"
+#if __ARM_NEON
+#include <arm_neon.h>
 #endif
 
 // 矩阵取值运算宏，假设矩阵按行存储
@@ -31,11 +35,15 @@ limitations under the License. */
 #define NR_INT8 2
 #define MR 6
 #define NR 16
+#define MR_ALT 8
+#define NR_ALT 12
 #else
 #define MR_INT8 4
 #define NR_INT8 2
 #define MR 6
 #define NR 8
+#define MR_ALT 4
+#define NR_ALT 8
 #endif
 
 #define s_min(i, j) ((i) < (j) ? (i) : (j))
@@ -44,8 +52,76 @@ namespace paddle_mobile {
 namespace operators {
 namespace math {
 
+// int8 矩阵乘法写回时的重量化参数, 对第 i 行
+// C = round(act(c * scale[i] + bias[i]) * quant_scale), 并饱和到 [-127, 127]
+struct RequantParam {
+  const float *scale = nullptr;
+  const float *bias = nullptr;
+  ActivationType act = IDENTITY;
+  float quant_scale = 1.f;
+  RoundType round = ROUND_NEAREST_AWAY_ZERO;
+};
+
+// 隐式 im2col 时一张图片 (一组) 的卷积参数. B 矩阵不显式存在, 第 r 行第 j 列
+// 是第 j 个输出像素在第 r 个卷积核位置上的输入, 越界时为 0, 行的顺序与
+// Im2ColFunctor<kCFO> 的 col 矩阵相同
+struct Im2ColGeometry {
+  const float *input = nullptr;
+  int height = 0;
+  int width = 0;
+  int kernel_h = 0;
+  int kernel_w = 0;
+  int stride_h = 1;
+  int stride_w = 1;
+  int pad_h = 0;
+  int pad_w = 0;
+  int dilation_h = 1;
+  int dilation_w = 1;
+  int output_w = 0;
+};
+
+// dst = epilogue(src), 对 rows x cols 的矩阵逐元素应用, 见 gemm_epilogue.h.
+// dst 可以与 src 相同. 有 NEON 时常用的组合另有非模板的重载
+template <typename Epilogue>
+inline void WriteWithEpilogue(int rows, int cols, const float *src,
+                              int src_ld, float *dst, int dst_ld,
+                              const Epilogue &epilogue) {
+  for (int i = 0; i < rows; ++i) {
+    const float *src_ptr = src + i * src_ld;
+    float *dst_ptr = dst + i * dst_ld;
+    int j = 0;
+#if __ARM_NEON
+    for (; j + 3 < cols; j += 4) {
+      vst1q_f32(dst_ptr + j, epilogue(vld1q_f32(src_ptr + j), i, j));
+    }
+#endif
+    for (; j < cols; ++j) {
+      dst_ptr[j] = epilogue(src_ptr[j], i, j);
+    }
+  }
+}
+
 class Gemm {
  public:
+  // 预打包的权重, 为 float, 或由 CompressPackedA/CompressPackedB 压缩的
+  // uint8, 或转换为 half 的 float. 后两者在计算时按分块转换回 float 到打包
+  // 缓冲区
+  struct PackedMatrix {
+    PackedMatrix(const float *data) : data(data) {}  // NOLINT
+    PackedMatrix(const uint8_t *compressed)          // NOLINT
+        : compressed(compressed) {}
+    PackedMatrix(const half *half_data)  // NOLINT
+        : half_data(half_data) {}
+
+    const float *data = nullptr;
+    const uint8_t *compressed = nullptr;
+    const half *half_data = nullptr;
+  };
+
+  // 微内核, 默认的为 MR x NR. Sgemm 和 Sgemm_omp 也可使用 GemmTuner 按矩阵
+  // 形状选择的 MR_ALT x NR_ALT, 预打包的矩阵乘法只使用默认的
+  enum MicroKernel { MICRO_KERNEL_DEFAULT = 0, MICRO_KERNEL_ALT = 1 };
+
   typedef void (Gemm::*FnPack)(int, int, int, const float *, int, float *);
   typedef void (Gemm::*FnAddDot)(int, const float *, const float *, float *,
                                  int);
@@ -68,6 +144,9 @@ class Gemm {
                       float *buffer);
   void PackMatrixB_omp_8c(int k, int n, int n_tail, const float *B, int ldb,
                           float *buffer);
+  // 从输入图片直接打包以第 j 个输出像素开始的 n (n <= NR) 列
+  void PackMatrixB_im2col(int k, int j, int n, const Im2ColGeometry &geo,
+                          float *buffer);
 #if __aarch64__
   void PackMatrixB_12c(int k, int n, int n_tail, const float *B, int ldb,
                        float *buffer);
@@ -96,6 +175,12 @@ class Gemm {
   void InnerKernelWithPRelu(int mc, int nc, const float *a, const float *b,
                             float *c, float *C, int ldc, float *p,
                             std::string mode, float *bias, float *bias1);
+  // 分块矩阵乘法, 每个 MR x NR 的小块算完后趁其还在 L1 中立即经 epilogue
+  // 回写到 C, 结果只写一次
+  template <typename Epilogue>
+  void InnerKernelWithEpilogue(int mc, int nc, const float *a, const float *b,
+                               float *c, float *C, int ldc,
+                               const Epilogue &epilogue);
 
   // 计算一个更小的 C 矩阵分块
 #if __aarch64__
@@ -108,32 +193,6 @@ class Gemm {
   void AddDot6x8(int k, const float *a, const float *b, float *c, int ldc);
 #endif
 
-  // 分块矩阵乘法结果回写
-  // C = A * B
-  void WriteBasic(int mc, int nc, float *c, float *C, int ldc);
-  // C = alpha * A * B + beta * C
-  void WriteWithAlphaBeta(int mc, int nc, float *c, float *C, int ldc);
-  // C = A * B + C
-  void WriteWithAdd(int mc, int nc, float *c, float *C, int ldc);
-  // C = A * B + bias
-  void WriteWithAddV1(int mc, int nc, float *c, float *C, int ldc, float *bias);
-  // C = A * B + C, relu(C)
-  void WriteWithAddRelu(int mc, int nc, float *c, float *C, int ldc);
-  // C = A * B + C,prelu(C)
-  void WriteWithAddPRelu(int mc, int nc, float *c, float *C, int ldc, float *p,
-                         std::string mode, float *bias, float *bias1);
-  // C = A * B + bias ,relu(C)
-  void WriteWithAddReluV1(int mc, int nc, float *c, float *C, int ldc,
-                          float *bias);
-  // C = A * B, batchnorm(C)
-  void WriteWithBn(int mc, int nc, float *c, float *C, int ldc,
-                   float *new_scale, float *new_bias);
-  // C = A * B, batchnorm(C), relu(C)
-  void WriteWithBnRelu(int mc, int nc, float *c, float *C, int ldc,
-                       float *new_scale, float *new_bias);
-  void WriteWithBnAddRelu(int mc, int nc, float *c, float *C, int ldc,
-                          float *new_scale, float *new_bias, float *bias1);
-
   // 向量矩阵乘法 (M = 1)
 #if __aarch64__
 #else
@@ -192,6 +251,56 @@ class Gemm {
                           const float *B, int ldb, float *C, int ldc, float *p,
                           std::string mode, float *bias, float *bias1);
 
+  // 权重预打包, 在 kernel Init 阶段调用一次, 打包结果在每次推理时复用
+  // A 整体按 MR 行分块打包, 大小为 PackedASize(m, k)
+  static int PackedASize(int m, int k);
+  void PackWeightA(int m, int k, const float *A, int lda, float *buffer);
+  // B 整体按 NR 列分块打包, 大小为 PackedBSize(k, n)
+  static int PackedBSize(int k, int n);
+  void PackWeightB(int k, int n, const float *B, int ldb, float *buffer);
+
+  // 权重压缩: 打包后的 A 的每行或 B 的每列按其最小值和最大值线性量化为
+  // uint8, 值为 q * scale + offset. 压缩结果依次为 packed_size 个 q, 按 16
+  // 字节对齐后是各行(列)的 scale 和 offset, 共 CompressedSize 字节
+  static int CompressedSize(int packed_size, int k);
+  static void CompressPackedA(int packed_size, int k, const float *packed_A,
+                              uint8_t *buffer);
+  static void CompressPackedB(int packed_size, int k, const float *packed_B,
+                              uint8_t *buffer);
+
+  // 固定分块参数, 不再查询 GemmTuner, 用于自动调优
+  void SetBlocking(const GemmBlocking &blocking) {
+    blocking_ = blocking;
+    fixed_blocking_ = true;
+  }
+
+  // 预打包矩阵乘法所需的 workspace 大小(float 个数), 权重不是 float 时另需
+  // 转换回 float 的缓冲区
+  int PackedAWorkspaceSize(int m, int n, int k, bool unpack = false);
+  int PackedBWorkspaceSize(int m, int n, int k, bool unpack = false);
+
+  // 以下预打包的矩阵乘法在回写时对 A * B 应用 epilogue, 如偏置, batch norm,
+  // 残差和激活, 见 gemm_epilogue.h
+
+  // 32位 float 矩阵乘法, A 已预打包, 临时缓冲区使用外部传入的 workspace
+  template <typename Epilogue>
+  void SgemmPackedA(int m, int n, int k, const PackedMatrix &packed_A,
+                    const float *B, int ldb, float *C, int ldc,
+                    const Epilogue &epilogue, float *workspace);
+
+  // 32位 float 卷积的隐式 gemm, A 为预打包的权重, B 在打包时由输入图片
+  // 直接生成, 不需要 im2col 的 col 缓冲区
+  template <typename Epilogue>
+  void SgemmPackedAIm2Col(int m, int n, int k, const PackedMatrix &packed_A,
+                          const Im2ColGeometry &geo, float *C, int ldc,
+                          const Epilogue &epilogue, float *workspace);
+
+  // 32位 float 矩阵乘法, B 已预打包
+  template <typename Epilogue>
+  void SgemmPackedB(int m, int n, int k, const float *A, int lda,
+                    const PackedMatrix &packed_B, float *C, int ldc,
+                    const Epilogue &epilogue, float *workspace);
+
   // 8 bits function cluster begins
   // 8 bits int small block inner product
   void AddDot4x8(int32_t k, const int8_t *a, const int8_t *b, int32_t *c,
@@ -250,9 +359,19 @@ class Gemm {
   void Sgemm(int32_t m, int32_t n, int32_t k, float alpha, const int8_t *A,
              int32_t lda, const int8_t *B, int32_t ldb, float beta, Otype *C,
              int32_t ldc, bool relu, int32_t *bias, bool addOnRow = false);
+  // 8 bits int 矩阵乘法, 写回时按行重量化为 int8, 不写出 int32 中间结果
+  void SgemmWithRequant(int32_t m, int32_t n, int32_t k, const int8_t *A,
+                        int32_t lda, const int8_t *B, int32_t ldb, int8_t *C,
+                        int32_t ldc, const RequantParam &requant);
+  void InnerKernelWithRequant(int32_t mc, int32_t nc, const int8_t *a,
+                              const int8_t *b, int32_t *c, int8_t *C,
+                              int32_t ldc, const RequantParam &requant);
   // 8 bits int write back
   // C = A * B
   void WriteBasic(int32_t mc, int32_t nc, int32_t *c, int32_t *C, int32_t ldc);
+  // C = requant(A * B), requant 的 scale 和 bias 按行给出
+  void WriteWithRequant(int32_t mc, int32_t nc, int32_t *c, int8_t *C,
+                        int32_t ldc, const RequantParam &requant);
   // C = A * B + bias, scale * relu(C)
   void WriteWithAddReluScale(int32_t mc, int32_t nc, int32_t *c, int8_t *C,
                              int32_t ldc, int32_t *bias, float scale);
@@ -264,11 +383,40 @@ class Gemm {
                           int32_t ldc, int32_t *bias, float scale);
 
  private:
+  // 分块参数, 由 GemmTuner 按矩阵形状给出
+  GemmBlocking Blocking(int m, int n, int k, int threads);
+  // 缓存预算的缩放系数
+  float BlockingScale(int m, int n, int k, int threads);
+
+  // 预打包矩阵乘法的分块大小, 与 Sgemm_omp 一致
+  void PackedBlocking(int m, int n, int k, int max_threads);
+  // 反量化压缩的权重中以第 first 行(列)开始的 count 行(列), first 为 width
+  // 的整数倍, 结果与压缩前打包的分块相同
+  static void DequantizePacked(int packed_size, int k, int width,
+                               const uint8_t *compressed, int first,
+                               int count, float *buffer);
+  // 同上, 将压缩或 half 的权重转换回 float
+  static void UnpackPacked(int packed_size, int k, int width,
+                           const PackedMatrix &packed, int first, int count,
+                           float *buffer);
+  // pack_b(j, nc, buffer) 打包以第 j 列开始的 nc 列
+  template <typename Pack, typename Func>
+  void SgemmPackedADriver(int m, int n, int k, const PackedMatrix &packed_A,
+                          Pack pack_b, float *workspace, Func inner);
+  template <typename Func>
+  void SgemmPackedADriver(int m, int n, int k, const PackedMatrix &packed_A,
+                          const float *B, int ldb, float *workspace,
+                          Func inner);
+
   int MC = 0;
   int KC = 0;
   int NC = 0;
+  GemmBlocking blocking_;
+  bool fixed_blocking_ = false;
+  // InnerKernelWithEpilogue 使用的微内核, 与 A, B 的打包方式一致
+  MicroKernel micro_kernel_ = MICRO_KERNEL_DEFAULT;
 
-  // 32位 float
+  // 32位 float, 计算期间取自 framework::WorkspaceScope
   float *packedA;
   float *packedB;
   float *packedC;
@@ -287,10 +435,9 @@ void Gemm::Sgemm(int32_t m, int32_t n, int32_t k, float alpha, const int8_t *A,
                  int32_t lda, const int8_t *B, int32_t ldb, float beta,
                  Otype *C, int32_t ldc, bool relu, int32_t *bias,
                  bool addOnRow) {
-  // L1 data cache is 32 kib (Per Contex-A57, Contex-A72, Contex-A73)
-  // L2 cache is 0.5~4 Mib (Contex-A72 cluster)
-  int32_t L1 = 32 * 1024;
-  int32_t L2 = 512 * 1024;
+  // L1/L2 cache budgets from the detected cache sizes
+  int32_t L1 = GetCPUInfo().l1_cache;
+  int32_t L2 = GetCPUInfo().l2_cache;
 
   const int32_t k_complete = (k + 15) - ((k + 15) & 15);
   KC = k_complete;
@@ -360,13 +507,9 @@ void Gemm::Sgemm_omp(int32_t m, int32_t n, int32_t k, float alpha,
                      const int8_t *A, int32_t lda, const int8_t *B, int32_t ldb,
                      float beta, Otype *C, int32_t ldc, bool relu,
                      int32_t *bias, bool addOnRow) {
-#ifdef _OPENMP
-  int32_t max_threads = omp_get_max_threads();
-#else
-  int32_t max_threads = 1;
-#endif
+  int32_t max_threads = ThreadPool::Instance()->ThreadNum();
 
-  int32_t L1 = 64 / max_threads * 1024;
+  int32_t L1 = GetCPUInfo().l1_cache * 2 / max_threads;
   const int32_t k_complete = (k + 15) - ((k + 15) & 15);
   KC = k_complete;
   zero_int8 =
@@ -421,14 +564,8 @@ void Gemm::Sgemm_omp(int32_t m, int32_t n, int32_t k, float alpha,
       paddle_mobile::memory::Alloc(sizeof(int32_t) * MC * NC * max_threads));
 
   if (m > n) {
-#pragma omp parallel for
-    for (int32_t i = 0; i < m; i += MC) {
-#ifdef _OPENMP
-      int32_t local_threads = omp_get_thread_num();
-#else
-      int32_t local_threads = 0;
-#endif
-
+    parallel_for_tid(0, (m + MC - 1) / MC, [&](int ib, int local_threads) {
+      int i = ib * MC;
       int32_t mc;
       mc = s_min(m - i, MC);
       int8_t *local_A = packedA_int8 + MC * KC * local_threads;
@@ -450,15 +587,10 @@ void Gemm::Sgemm_omp(int32_t m, int32_t n, int32_t k, float alpha,
                               local_C, &C(i, 0), ldc, relu, bias + i, addOnRow);
         }
       }
-    }
+    });
   } else {
-#pragma omp parallel for
-    for (int32_t j = 0; j < n; j += NC) {
-#ifdef _OPENMP
-      int32_t local_threads = omp_get_thread_num();
-#else
-      int32_t local_threads = 0;
-#endif
+    parallel_for_tid(0, (n + NC - 1) / NC, [&](int jb, int local_threads) {
+      int j = jb * NC;
       int32_t nc;
       nc = s_min(n - j, NC);
       int8_t *local_B = packedB_int8 + KC * NC * local_threads;
@@ -480,7 +612,7 @@ void Gemm::Sgemm_omp(int32_t m, int32_t n, int32_t k, float alpha,
                               local_C, &C(0, j), ldc, relu, bias, addOnRow);
         }
       }
-    }
+    });
   }
 
   paddle_mobile::memory::Free(packedA_int8);
@@ -489,6 +621,200 @@ void Gemm::Sgemm_omp(int32_t m, int32_t n, int32_t k, float alpha,
   paddle_mobile::memory::Free(zero_int8);
 }
 
+template <typename Epilogue>
+void Gemm::InnerKernelWithEpilogue(int mc, int nc, const float *a,
+                                   const float *b, float *c, float *C, int ldc,
+                                   const Epilogue &epilogue) {
+  const bool alt = micro_kernel_ == MICRO_KERNEL_ALT;
+  const int mr = alt ? MR_ALT : MR;
+  const int nr = alt ? NR_ALT : NR;
+  parallel_for(0, (nc + nr - 1) / nr, [&](int jb) {
+    int j = jb * nr;
+    for (int i = 0; i < mc; i += mr) {
+#if __aarch64__
+      if (alt) {
+        AddDot8x12(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
+      } else {
+        AddDot6x16(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
+      }
+#else
+      if (alt) {
+        AddDot4x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
+      } else {
+        AddDot6x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
+      }
+#endif
+      WriteWithEpilogue(s_min(mc - i, mr), s_min(nc - j, nr), c + i * NC + j,
+                        NC, &C(i, j), ldc, epilogue.Offset(i, j));
+    }
+  });
+}
+
+// inner(mc, nc, a, b, c, i, j) 计算以 (i, j) 开始的 C 分块并回写
+template <typename Pack, typename Func>
+void Gemm::SgemmPackedADriver(int m, int n, int k,
+                              const PackedMatrix &packed_A, Pack pack_b,
+                              float *workspace, Func inner) {
+  int max_threads = ThreadPool::Instance()->ThreadNum();
+  PackedBlocking(m, n, k, max_threads);
+  const int packed_size = PackedASize(m, k);
+
+  if (m > n) {
+    float *packed_B = workspace;
+    float *packed_C = workspace + KC * NC;
+    // 压缩或 half 的 A 按 MC 行分块转换到各线程的缓冲区
+    float *unpacked_A = packed_C + MC * NC * max_threads;
+    // B 整体打包, 按 NR 列并行
+    parallel_for(0, (n + NR - 1) / NR, [&](int jb) {
+      int j = jb * NR;
+      pack_b(j, s_min(n - j, NR), packed_B + j * KC);
+    });
+
+    parallel_for_tid(0, (m + MC - 1) / MC, [&](int ib, int local_threads) {
+      int i = ib * MC;
+      int mc = s_min(m - i, MC);
+      float *local_C = packed_C + MC * NC * local_threads;
+      const float *local_A = nullptr;
+      if (packed_A.data == nullptr) {
+        float *buffer = unpacked_A + MC * KC * local_threads;
+        UnpackPacked(packed_size, KC, MR, packed_A, i, mc, buffer);
+        local_A = buffer;
+      } else {
+        local_A = packed_A.data + i * KC;
+      }
+      inner(mc, n, local_A, packed_B, local_C, i, 0);
+    });
+  } else {
+    float *packed_B = workspace;
+    float *packed_C = workspace + KC * NC * max_threads;
+    // 每个线程都读取整个 A, 压缩或 half 的 A 先整体转换, 按 MR 行并行
+    const float *A = packed_A.data;
+    if (A == nullptr) {
+      float *unpacked_A = packed_C + MC * NC * max_threads;
+      parallel_for(0, (m + MR - 1) / MR, [&](int ib) {
+        UnpackPacked(packed_size, KC, MR, packed_A, ib * MR, MR,
+                     unpacked_A + ib * MR * KC);
+      });
+      A = unpacked_A;
+    }
+
+    parallel_for_tid(0, (n + NC - 1) / NC, [&](int jb, int local_threads) {
+      int j = jb * NC;
+      int nc = s_min(n - j, NC);
+      float *local_B = packed_B + KC * NC * local_threads;
+      float *local_C = packed_C + MC * NC * local_threads;
+      pack_b(j, nc, local_B);
+      inner(m, nc, A, local_B, local_C, 0, j);
+    });
+  }
+}
+
+template <typename Func>
+void Gemm::SgemmPackedADriver(int m, int n, int k,
+                              const PackedMatrix &packed_A,
+                              const float *B, int ldb, float *workspace,
+                              Func inner) {
+  SgemmPackedADriver(m, n, k, packed_A,
+                     [&](int j, int nc, float *buffer) {
+#if __aarch64__
+                       PackMatrixB_16c(KC, nc, nc % NR, &B(0, j), ldb, buffer);
+#else
+                       PackMatrixB_8c(KC, nc, nc % NR, &B(0, j), ldb, buffer);
+#endif
+                     },
+                     workspace, inner);
+}
+
+template <typename Epilogue>
+void Gemm::SgemmPackedA(int m, int n, int k, const PackedMatrix &packed_A,
+                        const float *B, int ldb, float *C, int ldc,
+                        const Epilogue &epilogue, float *workspace) {
+  SgemmPackedADriver(
+      m, n, k, packed_A, B, ldb, workspace,
+      [&](int mc, int nc, const float *a, const float *b, float *c, int i,
+          int j) {
+        InnerKernelWithEpilogue(mc, nc, a, b, c, &C(i, j), ldc,
+                                epilogue.Offset(i, j));
+      });
+}
+
+// B 的每 NR 列在打包时由输入图片生成
+template <typename Epilogue>
+void Gemm::SgemmPackedAIm2Col(int m, int n, int k,
+                              const PackedMatrix &packed_A,
+                              const Im2ColGeometry &geo, float *C, int ldc,
+                              const Epilogue &epilogue, float *workspace) {
+  SgemmPackedADriver(
+      m, n, k, packed_A,
+      [&](int j, int nc, float *buffer) {
+        for (int jj = 0; jj < nc; jj += NR) {
+          PackMatrixB_im2col(KC, j + jj, s_min(nc - jj, NR), geo,
+                             buffer + jj * KC);
+        }
+      },
+      workspace,
+      [&](int mc, int nc, const float *a, const float *b, float *c, int i,
+          int j) {
+        InnerKernelWithEpilogue(mc, nc, a, b, c, &C(i, j), ldc,
+                                epilogue.Offset(i, j));
+      });
+}
+
+template <typename Epilogue>
+void Gemm::SgemmPackedB(int m, int n, int k, const float *A, int lda,
+                        const PackedMatrix &packed_B, float *C, int ldc,
+                        const Epilogue &epilogue, float *workspace) {
+  int max_threads = ThreadPool::Instance()->ThreadNum();
+  PackedBlocking(m, n, k, max_threads);
+  const int packed_size = PackedBSize(k, n);
+
+  float *packed_A = workspace;
+  float *packed_C = packed_A + ((m > n) ? MC * KC * max_threads : MC * KC);
+  zero = packed_C + MC * NC * max_threads;
+  memset(static_cast<void *>(zero), 0, sizeof(float) * KC);
+  float *unpacked_B = zero + KC;
+
+  if (m > n) {
+    // 每个线程都读取整个 B, 压缩或 half 的 B 先整体转换, 按 NR 列并行
+    const float *B = packed_B.data;
+    if (B == nullptr) {
+      parallel_for(0, (n + NR - 1) / NR, [&](int jb) {
+        UnpackPacked(packed_size, KC, NR, packed_B, jb * NR, NR,
+                     unpacked_B + jb * NR * KC);
+      });
+      B = unpacked_B;
+    }
+    parallel_for_tid(0, (m + MC - 1) / MC, [&](int ib, int local_threads) {
+      int i = ib * MC;
+      int mc = s_min(m - i, MC);
+      float *local_A = packed_A + MC * KC * local_threads;
+      float *local_C = packed_C + MC * NC * local_threads;
+      PackMatrixA_6r(mc, KC, mc % MR, &A(i, 0), lda, local_A);
+      InnerKernelWithEpilogue(mc, n, local_A, B, local_C, &C(i, 0), ldc,
+                              epilogue.Offset(i, 0));
+    });
+  } else {
+    PackMatrixA_omp_6r(m, KC, m % MR, A, lda, packed_A);
+    parallel_for_tid(0, (n + NC - 1) / NC, [&](int jb, int local_threads) {
+      int j = jb * NC;
+      int nc = s_min(n - j, NC);
+      float *local_C = packed_C + MC * NC * local_threads;
+      const float *local_B = nullptr;
+      if (packed_B.data == nullptr) {
+        // 压缩或 half 的 B 按 NC 列分块转换到各线程的缓冲区
+        float *buffer = unpacked_B + KC * NC * local_threads;
+        UnpackPacked(packed_size, KC, NR, packed_B, j, nc, buffer);
+        local_B = buffer;
+      } else {
+        local_B = packed_B.data + j * KC;
+      }
+      InnerKernelWithEpilogue(m, nc, packed_A, local_B, local_C, &C(0, j),
+                              ldc, epilogue.Offset(0, j));
+    });
+  }
+  zero = nullptr;
+}
+
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle_mobile
@@ -0,0 +1,331 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+#include "common/types.h"
+#include "framework/tensor.h"
+#include "operators/math/activation.h"
+#include "operators/math/gemm.h"
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+// 矩阵乘法回写时的后处理阶段. 每个阶段把 C 第 i 行第 j 列的值 v 变换为
+// stage(v, i, j), 有 NEON 时另有一次变换第 j 列起 4 个值的重载.
+// Offset(i, j) 返回原点移到第 i 行第 j 列的阶段, 用于分块和分组.
+namespace epilogue {
+
+// v * alpha
+struct Scale {
+  float alpha;
+
+  float operator()(float v, int i, int j) const { return v * alpha; }
+#if __ARM_NEON
+  float32x4_t operator()(float32x4_t v, int i, int j) const {
+    return vmulq_n_f32(v, alpha);
+  }
+#endif
+  Scale Offset(int i, int j) const { return *this; }
+};
+
+// 每行 (卷积的输出通道) 一个偏置
+struct RowBias {
+  const float *bias;
+
+  float operator()(float v, int i, int j) const { return v + bias[i]; }
+#if __ARM_NEON
+  float32x4_t operator()(float32x4_t v, int i, int j) const {
+    return vaddq_f32(v, vdupq_n_f32(bias[i]));
+  }
+#endif
+  RowBias Offset(int i, int j) const { return {bias + i}; }
+};
+
+// 每列 (全连接的输出) 一个偏置
+struct ColBias {
+  const float *bias;
+
+  float operator()(float v, int i, int j) const { return v + bias[j]; }
+#if __ARM_NEON
+  float32x4_t operator()(float32x4_t v, int i, int j) const {
+    return vaddq_f32(v, vld1q_f32(bias + j));
+  }
+#endif
+  ColBias Offset(int i, int j) const { return {bias + j}; }
+};
+
+// v * scale[i] + shift[i], 即按行折叠的 batch norm
+struct RowScaleShift {
+  const float *scale;
+  const float *shift;
+
+  float operator()(float v, int i, int j) const {
+    return v * scale[i] + shift[i];
+  }
+#if __ARM_NEON
+  float32x4_t operator()(float32x4_t v, int i, int j) const {
+    return vmlaq_n_f32(vdupq_n_f32(shift[i]), v, scale[i]);
+  }
+#endif
+  RowScaleShift Offset(int i, int j) const { return {scale + i, shift + i}; }
+};
+
+// 加上行距为 ld 的同形状矩阵, 如残差连接. data 为 C 本身时即 C += A * B,
+// 每个元素在写回前读出, 所以可以原地进行
+struct Residual {
+  const float *data;
+  int ld;
+
+  float operator()(float v, int i, int j) const {
+    return v + data[i * ld + j];
+  }
+#if __ARM_NEON
+  float32x4_t operator()(float32x4_t v, int i, int j) const {
+    return vaddq_f32(v, vld1q_f32(data + i * ld + j));
+  }
+#endif
+  Residual Offset(int i, int j) const { return {data + i * ld + j, ld}; }
+};
+
+template <ActivationType Act>
+struct Activation {
+  float operator()(float v, int i, int j) const { return Active<Act>(v); }
+#if __ARM_NEON
+  float32x4_t operator()(float32x4_t v, int i, int j) const {
+    return vActiveq_f32<Act>(v);
+  }
+#endif
+  Activation Offset(int i, int j) const { return *this; }
+};
+
+// 负半轴的斜率为 alpha
+template <>
+struct Activation<LEAKY_RELU> {
+  float alpha;
+
+  float operator()(float v, int i, int j) const {
+    return v < 0 ? v * alpha : v;
+  }
+#if __ARM_NEON
+  float32x4_t operator()(float32x4_t v, int i, int j) const {
+    uint32x4_t negative = vcltq_f32(v, vdupq_n_f32(0.f));
+    return vbslq_f32(negative, vmulq_n_f32(v, alpha), v);
+  }
+#endif
+  Activation Offset(int i, int j) const { return *this; }
+};
+
+// 第 (i, j) 个元素的斜率为 slope[i * row_step + j * col_step], 步长
+// (0, 0), (1, 0), (ld, 1) 分别对应 prelu 的 all, channel, element 模式
+struct PRelu {
+  const float *slope;
+  int row_step;
+  int col_step;
+
+  float operator()(float v, int i, int j) const {
+    return v < 0 ? v * slope[i * row_step + j * col_step] : v;
+  }
+#if __ARM_NEON
+  float32x4_t operator()(float32x4_t v, int i, int j) const {
+    const float *p = slope + i * row_step + j * col_step;
+    float32x4_t s = col_step == 0 ? vdupq_n_f32(*p) : vld1q_f32(p);
+    uint32x4_t negative = vcltq_f32(v, vdupq_n_f32(0.f));
+    return vbslq_f32(negative, vmulq_f32(v, s), v);
+  }
+#endif
+  PRelu Offset(int i, int j) const {
+    return {slope + i * row_step + j * col_step, row_step, col_step};
+  }
+};
+
+}  // namespace epilogue
+
+// 按顺序依次应用的后处理阶段, 在编译期组合, 回写时对每个元素只做一次
+// 读写. 通常的顺序为 偏置 -> 缩放平移 -> 残差 -> 激活
+template <typename... Stages>
+struct Epilogue;
+
+template <>
+struct Epilogue<> {
+  template <typename V>
+  V operator()(V v, int i, int j) const {
+    return v;
+  }
+  Epilogue Offset(int i, int j) const { return *this; }
+};
+
+template <typename Stage, typename... Rest>
+struct Epilogue<Stage, Rest...> {
+  Stage stage;
+  Epilogue<Rest...> rest;
+
+  template <typename V>
+  V operator()(V v, int i, int j) const {
+    return rest(stage(v, i, j), i, j);
+  }
+  Epilogue Offset(int i, int j) const {
+    return {stage.Offset(i, j), rest.Offset(i, j)};
+  }
+};
+
+inline Epilogue<> MakeEpilogue() { return {}; }
+
+template <typename Stage, typename... Rest>
+Epilogue<Stage, Rest...> MakeEpilogue(const Stage &stage,
+                                      const Rest &... rest) {
+  return {stage, MakeEpilogue(rest...)};
+}
+
+#if __ARM_NEON
+// 常用组合的回写, 在 gemm.cpp 中由 armv7 汇编或按行广播的 NEON 实现. 它们
+// 不是模板, 重载解析时优先于 gemm.h 中通用的 WriteWithEpilogue,
+// InnerKernelWithEpilogue 实例化时通过实参相关查找找到
+void WriteWithEpilogue(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld, const Epilogue<> &epilogue);
+void WriteWithEpilogue(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld,
+                       const Epilogue<epilogue::Residual> &epilogue);
+void WriteWithEpilogue(
+    int rows, int cols, const float *src, int src_ld, float *dst, int dst_ld,
+    const Epilogue<epilogue::Residual, epilogue::Activation<RELU>> &epilogue);
+void WriteWithEpilogue(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld,
+                       const Epilogue<epilogue::RowBias> &epilogue);
+void WriteWithEpilogue(
+    int rows, int cols, const float *src, int src_ld, float *dst, int dst_ld,
+    const Epilogue<epilogue::RowBias, epilogue::Activation<RELU>> &epilogue);
+void WriteWithEpilogue(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld,
+                       const Epilogue<epilogue::RowScaleShift> &epilogue);
+void WriteWithEpilogue(int rows, int cols, const float *src, int src_ld,
+                       float *dst, int dst_ld,
+                       const Epilogue<epilogue::RowScaleShift,
+                                      epilogue::Activation<RELU>> &epilogue);
+void WriteWithEpilogue(
+    int rows, int cols, const float *src, int src_ld, float *dst, int dst_ld,
+    const Epilogue<epilogue::RowScaleShift, epilogue::Residual,
+                   epilogue::Activation<RELU>> &epilogue);
+#endif
+
+// prelu 的模式对应的斜率步长, cols 为每个通道的元素个数
+inline epilogue::PRelu MakePRelu(const float *slope, const std::string &mode,
+                                 int cols) {
+  if (mode == "all") {
+    return {slope, 0, 0};
+  }
+  if (mode == "element") {
+    return {slope, cols, 1};
+  }
+  return {slope, 1, 0};
+}
+
+// 预打包的权重为 float, 或由 CompressPackedWeight 压缩的 uint8, 或由
+// ConvertToHalf 转换的 half
+inline bool IsPackedFloat(const framework::Tensor &packed) {
+  return packed.type() == typeid(float);
+}
+
+inline Gemm::PackedMatrix PackedMatrixOf(const framework::Tensor &packed) {
+  if (packed.type() == typeid(uint8_t)) {
+    return packed.data<uint8_t>();
+  } else if (packed.type() == typeid(half)) {
+    return packed.data<half>();
+  }
+  return packed.data<float>();
+}
+
+// matrix_a 已由 PackConvFilter 预打包, workspace 在多次调用间复用
+template <typename Epilogue>
+void MatMulPackedA(const framework::Tensor &packed_a,
+                   const framework::Tensor &matrix_b,
+                   framework::Tensor *matrix_out, const Epilogue &epilogue,
+                   framework::Tensor *workspace) {
+  auto dim_b = matrix_b.dims();
+  auto dim_out = matrix_out->dims();
+  PADDLE_MOBILE_ENFORCE(dim_b.size() == 2 && dim_out.size() == 2,
+                        "The input and output of MatMul be matrix");
+
+  int M = dim_out[0];
+  int N = dim_out[1];
+  int K = dim_b[0];
+  Gemm gemm;
+  float *workspace_data = workspace->mutable_data<float>(
+      {gemm.PackedAWorkspaceSize(M, N, K, !IsPackedFloat(packed_a))});
+  gemm.SgemmPackedA(M, N, K, PackedMatrixOf(packed_a), matrix_b.data<float>(),
+                    N, matrix_out->data<float>(), N, epilogue,
+                    workspace_data);
+}
+
+// 隐式 gemm 卷积, matrix_b 不显式存在, 由 geo 描述的输入图片在打包时生成,
+// matrix_out 为 [out_channel, output_h * output_w]
+template <typename Epilogue>
+void MatMulPackedAIm2Col(const framework::Tensor &packed_a,
+                         const Im2ColGeometry &geo, int k,
+                         framework::Tensor *matrix_out,
+                         const Epilogue &epilogue,
+                         framework::Tensor *workspace) {
+  auto dim_out = matrix_out->dims();
+  PADDLE_MOBILE_ENFORCE(dim_out.size() == 2,
+                        "The output of MatMul should be matrix");
+
+  int M = dim_out[0];
+  int N = dim_out[1];
+  Gemm gemm;
+  float *workspace_data = workspace->mutable_data<float>(
+      {gemm.PackedAWorkspaceSize(M, N, k, !IsPackedFloat(packed_a))});
+  gemm.SgemmPackedAIm2Col(M, N, k, PackedMatrixOf(packed_a), geo,
+                          matrix_out->data<float>(), N, epilogue,
+                          workspace_data);
+}
+
+// matrix_b 已由 PackFcWeight 预打包
+template <typename Epilogue>
+void MatMulPackedB(const framework::Tensor &matrix_a,
+                   const framework::Tensor &packed_b,
+                   framework::Tensor *matrix_out, const Epilogue &epilogue,
+                   framework::Tensor *workspace) {
+  auto dim_a = matrix_a.dims();
+  auto dim_out = matrix_out->dims();
+  PADDLE_MOBILE_ENFORCE(dim_a.size() == 2 && dim_out.size() == 2,
+                        "The input and output of MatMul be matrix");
+
+  int M = dim_out[0];
+  int N = dim_out[1];
+  int K = dim_a[1];
+  Gemm gemm;
+  float *workspace_data = workspace->mutable_data<float>(
+      {gemm.PackedBWorkspaceSize(M, N, K, !IsPackedFloat(packed_b))});
+  gemm.SgemmPackedB(M, N, K, matrix_a.data<float>(), K,
+                    PackedMatrixOf(packed_b), matrix_out->data<float>(), N,
+                    epilogue, workspace_data);
+}
+
+// 对不经过 gemm 计算的卷积输出原地应用只含逐元素阶段的 epilogue,
+// 输出按 rows x cols 的矩阵看待
+template <typename Epilogue>
+void ApplyEpilogue(int rows, int cols, framework::Tensor *output,
+                   const Epilogue &epilogue) {
+  float *data = output->data<float>();
+  parallel_for(0, rows, [&](int i) {
+    WriteWithEpilogue(1, cols, data + i * cols, cols, data + i * cols, cols,
+                      epilogue.Offset(i, 0));
+  });
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
@@ -12,16 +12,17 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
 #include <string.h>
+#include "common/enforce.h"
 #include "common/log.h"
+#include "operators/math/activation.h"
 #include "operators/math/gemm.h"
+#include "operators/math/quantize.h"
 #if __ARM_NEON
 #include <arm_neon.h>
 #include <iostream>
 
-#endif
-#ifdef _OPENMP
-#include <omp.h>
 #endif
 
 namespace paddle_mobile {
@@ -249,7 +250,30 @@ void Gemm::AddDot4x2(int32_t k, const int8_t *a, const int8_t *b, int32_t *c,
                      int32_t ldc) {
 #if __ARM_NEON
 #if __aarch64__
-// TODO
+  // 与 armv7 相同: 每 16 个 k 的乘积两两相加到 int16, 再累加到 int32.
+  // 量化的值在 [-127, 127] 内, 两个乘积之和不会溢出 int16
+  int32x4_t sum[4][2];
+  for (int32_t i = 0; i < 4; ++i) {
+    sum[i][0] = vdupq_n_s32(0);
+    sum[i][1] = vdupq_n_s32(0);
+  }
+  for (int32_t l = 0; l < k; l += 16, a += 64, b += 32) {
+    int8x16_t b0 = vld1q_s8(b);
+    int8x16_t b1 = vld1q_s8(b + 16);
+    for (int32_t i = 0; i < 4; ++i) {
+      int8x16_t ai = vld1q_s8(a + i * 16);
+      int16x8_t p0 = vmull_s8(vget_low_s8(ai), vget_low_s8(b0));
+      int16x8_t p1 = vmull_s8(vget_low_s8(ai), vget_low_s8(b1));
+      p0 = vmlal_s8(p0, vget_high_s8(ai), vget_high_s8(b0));
+      p1 = vmlal_s8(p1, vget_high_s8(ai), vget_high_s8(b1));
+      sum[i][0] = vpadalq_s16(sum[i][0], p0);
+      sum[i][1] = vpadalq_s16(sum[i][1], p1);
+    }
+  }
+  for (int32_t i = 0; i < 4; ++i) {
+    c[i * ldc] = vaddvq_s32(sum[i][0]);
+    c[i * ldc + 1] = vaddvq_s32(sum[i][1]);
+  }
 #else
 #define PADDLE_LABEL_LOOP "1"
 #define PADDLE_LABEL_AFTER_LOOP "2"
@@ -368,6 +392,22 @@ void Gemm::AddDot4x2(int32_t k, const int8_t *a, const int8_t *b, int32_t *c,
 #undef PADDLE_LABEL_LOOP
 
 #endif  // __aarch64__
+#else
+  // a 按 16 个 k 一组存 4 行，b 按 16 个 k 一组存 2 列
+  int32_t sum[4][2] = {{0}};
+  for (int32_t l = 0; l < k; l += 16, a += 64, b += 32) {
+    for (int32_t i = 0; i < 4; ++i) {
+      for (int32_t j = 0; j < 2; ++j) {
+        for (int32_t p = 0; p < 16; ++p) {
+          sum[i][j] += a[i * 16 + p] * b[j * 16 + p];
+        }
+      }
+    }
+  }
+  for (int32_t i = 0; i < 4; ++i) {
+    c[i * ldc] = sum[i][0];
+    c[i * ldc + 1] = sum[i][1];
+  }
 #endif  // __ARM_NEON
 }
 
@@ -677,18 +717,14 @@ template <>
 void Gemm::InnerKernel(int32_t mc, int32_t nc, float alpha, const int8_t *a,
                        const int8_t *b, float beta, int32_t *c, int32_t *C,
                        int32_t ldc, bool relu) {
-#pragma omp parallel for
-  for (int32_t j = 0; j < nc; j += NR_INT8) {
+  parallel_for(0, (nc + NR_INT8 - 1) / NR_INT8, [&](int jb) {
+    int j = jb * NR_INT8;
     for (int32_t i = 0; i < mc; i += MR_INT8) {
-#if __aarch64__
-    // TODO
-#else
       //      AddDot6x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
       //      AddDot4x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
       AddDot4x2(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-#endif  // __aarch64__
     }
-  }
+  });
   if (!relu) {
     WriteBasic(mc, nc, c, C, ldc);
     return;
@@ -700,18 +736,14 @@ void Gemm::InnerKernelWithBias(int32_t mc, int32_t nc, float alpha,
                                const int8_t *a, const int8_t *b, float beta,
                                int32_t *c, int8_t *C, int32_t ldc, bool relu,
                                int32_t *bias, bool addOnRow) {
-#pragma omp parallel for
-  for (int32_t j = 0; j < nc; j += NR_INT8) {
+  parallel_for(0, (nc + NR_INT8 - 1) / NR_INT8, [&](int jb) {
+    int j = jb * NR_INT8;
     for (int32_t i = 0; i < mc; i += MR_INT8) {
-#if __aarch64__
-    // TODO
-#else
       //      AddDot6x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
       //      AddDot4x8(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
       AddDot4x2(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
-#endif  // __aarch64__
     }
-  }
+  });
   if (relu) {
     WriteWithAddReluScale(mc, nc, c, C, ldc, bias, alpha);
     return;
@@ -746,7 +778,15 @@ void Gemm::PackMatrixA_4r_16(int32_t m, int32_t k, int32_t m_tail,
     for (int32_t j = 0; j < k_count; ++j) {
 #if __ARM_NEON
 #if __aarch64__
-    // TODO
+      vst1q_s8(local_buffer, vld1q_s8(a0));
+      vst1q_s8(local_buffer + 16, vld1q_s8(a1));
+      vst1q_s8(local_buffer + 32, vld1q_s8(a2));
+      vst1q_s8(local_buffer + 48, vld1q_s8(a3));
+      a0 += 16;
+      a1 += 16;
+      a2 += 16;
+      a3 += 16;
+      local_buffer += 64;
 #else
       asm volatile(
           "vld1.s8    {d0, d1},   [%[a0]]!         \n\t"
@@ -826,7 +866,15 @@ void Gemm::PackMatrixA_4r_16(int32_t m, int32_t k, int32_t m_tail,
     for (int32_t j = 0; j < k_count; ++j) {
 #if __ARM_NEON
 #if __aarch64__
-    // TODO
+      vst1q_s8(local_buffer, vld1q_s8(a0));
+      vst1q_s8(local_buffer + 16, vld1q_s8(a1));
+      vst1q_s8(local_buffer + 32, vld1q_s8(a2));
+      vst1q_s8(local_buffer + 48, vld1q_s8(a3));
+      a0 += 16;
+      a1 += 16;
+      a2 += 16;
+      a3 += 16;
+      local_buffer += 64;
 #else
       asm volatile(
           "vld1.s8    {d0, d1},   [%[a0]]!         \n\t"
@@ -1102,10 +1150,7 @@ void Gemm::PackMatrixB_8c(int32_t k, int32_t n, int32_t n_tail, const int8_t *B,
 // C = A * B
 void Gemm::WriteBasic(int32_t mc, int32_t nc, int32_t *c, int32_t *C,
                       int32_t ldc) {
-#if __ARM_NEON
-#if __aarch64__
-// TODO
-#else
+#if __ARM_NEON && !__aarch64__
   int32_t nc1 = nc >> 4;
   int32_t _nc1 = nc & 15;
   int32_t step = sizeof(int32_t) * ldc;
@@ -1159,17 +1204,39 @@ void Gemm::WriteBasic(int32_t mc, int32_t nc, int32_t *c, int32_t *C,
       }
     }
   }
-#endif  // __aarch64__
+#else
+  for (int32_t i = 0; i < mc; ++i) {
+    memcpy(C + i * ldc, c + i * NC, nc * sizeof(int32_t));
+  }
 #endif  // __ARM_NEON
 }
 
+#if !__ARM_NEON || __aarch64__
+// armv8 和没有 NEON 时的写回, 与 armv7 汇编相同: 加 bias, 乘 scale 后向零
+// 截断, 再饱和到 [-127, 127]
+static void WriteScaledRows(int32_t mc, int32_t nc, const int32_t *c,
+                            int32_t ldc_c, int8_t *C, int32_t ldc,
+                            const int32_t *bias, bool bias_on_row, bool relu,
+                            float scale) {
+  for (int32_t i = 0; i < mc; ++i) {
+    for (int32_t j = 0; j < nc; ++j) {
+      int64_t v = static_cast<int64_t>(c[i * ldc_c + j]) +
+                  (bias_on_row ? bias[i] : bias[j]);
+      if (relu && v < 0) {
+        v = 0;
+      }
+      int64_t q = static_cast<int64_t>(static_cast<float>(v) * scale);
+      C[i * ldc + j] = static_cast<int8_t>(std::min<int64_t>(
+          std::max<int64_t>(q, -127), 127));
+    }
+  }
+}
+#endif  // !__ARM_NEON || __aarch64__
+
 // C = A * B + bias, scale * C, bias is added on column
 void Gemm::WriteWithAddScale(int32_t mc, int32_t nc, int32_t *c, int8_t *C,
                              int32_t ldc, int32_t *bias, float scale) {
-#if __ARM_NEON
-#if __aarch64__
-// TODO
-#else
+#if __ARM_NEON && !__aarch64__
   int8_t narrow = -128;
   int32_t nc1 = nc >> 3;
   int32_t _nc1 = nc & 7;
@@ -1282,17 +1349,15 @@ void Gemm::WriteWithAddScale(int32_t mc, int32_t nc, int32_t *c, int8_t *C,
           : "cc", "memory", "q0", "q1", "q2", "q3", "q4", "q12", "q13", "q15");
     }
   }
-#endif  // __aarch64__
+#else
+  WriteScaledRows(mc, nc, c, NC, C, ldc, bias, true, false, scale);
 #endif  // __ARM_NEON
 }
 
 // C = A * B + bias, scale * C, bias is added on row
 void Gemm::WriteWithAddScaleT(int32_t mc, int32_t nc, int32_t *c, int8_t *C,
                               int32_t ldc, int32_t *bias, float scale) {
-#if __ARM_NEON
-#if __aarch64__
-// TODO
-#else
+#if __ARM_NEON && !__aarch64__
   int8_t narrow = -128;
   int32_t nc1 = nc >> 3;
   int32_t _nc1 = nc & 7;
@@ -1405,17 +1470,15 @@ void Gemm::WriteWithAddScaleT(int32_t mc, int32_t nc, int32_t *c, int8_t *C,
           : "cc", "memory", "q0", "q1", "q2", "q3", "q4", "q12", "q13", "q15");
     }
   }
-#endif  // __aarch64__
+#else
+  WriteScaledRows(mc, nc, c, NC, C, ldc, bias, false, false, scale);
 #endif  // __ARM_NEON
 }
 
 // C = A * B + bias, scale * relu(C), bias is added on column
 void Gemm::WriteWithAddReluScale(int32_t mc, int32_t nc, int32_t *c, int8_t *C,
                                  int32_t ldc, int32_t *bias, float scale) {
-#if __ARM_NEON
-#if __aarch64__
-// TODO
-#else
+#if __ARM_NEON && !__aarch64__
   int32_t zero = 0;
   int32_t nc1 = nc >> 3;
   int32_t _nc1 = nc & 7;
@@ -1526,8 +1589,152 @@ void Gemm::WriteWithAddReluScale(int32_t mc, int32_t nc, int32_t *c, int8_t *C,
           : "cc", "memory", "q0", "q1", "q2", "q3", "q4", "q13", "q14", "q15");
     }
   }
-#endif  // __aarch64__
+#else
+  WriteScaledRows(mc, nc, c, NC, C, ldc, bias, true, true, scale);
+#endif  // __ARM_NEON
+}
+
+// 一行 int32 结果的重量化: C = round(act(c * scale + bias) * quant_scale)
+template <ActivationType Act, RoundType R>
+static void RequantRow(const int32_t *c, int8_t *C, int32_t n, float scale,
+                       float bias, float quant_scale) {
+  int32_t remain = n;
+#if __ARM_NEON
+  float32x4_t __scale = vdupq_n_f32(scale);
+  float32x4_t __bias = vdupq_n_f32(bias);
+  float32x4_t __quant_scale = vdupq_n_f32(quant_scale);
+  int8x8_t __min = vdup_n_s8(-127);
+  for (int32_t j = 0; j < n - 7; j += 8, c += 8, C += 8) {
+    float32x4_t f0 = vcvtq_f32_s32(vld1q_s32(c));
+    float32x4_t f1 = vcvtq_f32_s32(vld1q_s32(c + 4));
+    f0 = vActiveq_f32<Act>(vmlaq_f32(__bias, f0, __scale));
+    f1 = vActiveq_f32<Act>(vmlaq_f32(__bias, f1, __scale));
+    int32x4_t q0 = vRoundq_f32<R>(vmulq_f32(f0, __quant_scale));
+    int32x4_t q1 = vRoundq_f32<R>(vmulq_f32(f1, __quant_scale));
+    int16x8_t q = vcombine_s16(vqmovn_s32(q0), vqmovn_s32(q1));
+    vst1_s8(C, vmax_s8(vqmovn_s16(q), __min));
+  }
+  remain = n & 7;
 #endif  // __ARM_NEON
+  for (int32_t j = 0; j < remain; ++j) {
+    float x = Active<Act>(c[j] * scale + bias) * quant_scale;
+    C[j] = Round<R>(std::min(std::max(x, -127.f), 127.f));
+  }
+}
+
+template <ActivationType Act, RoundType R>
+static void RequantRows(int32_t mc, int32_t nc, const int32_t *c, int32_t ldc_c,
+                        int8_t *C, int32_t ldc, const RequantParam &requant) {
+  parallel_for(0, mc, [&](int i) {
+    RequantRow<Act, R>(c + i * ldc_c, C + i * ldc, nc, requant.scale[i],
+                       requant.bias[i], requant.quant_scale);
+  });
+}
+
+template <ActivationType Act>
+static void RequantRows(int32_t mc, int32_t nc, const int32_t *c, int32_t ldc_c,
+                        int8_t *C, int32_t ldc, const RequantParam &requant) {
+  switch (requant.round) {
+    case ROUND_NEAREST_TO_EVEN:
+      RequantRows<Act, ROUND_NEAREST_TO_EVEN>(mc, nc, c, ldc_c, C, ldc,
+                                              requant);
+      break;
+    case ROUND_NEAREST_TOWARDS_ZERO:
+      RequantRows<Act, ROUND_NEAREST_TOWARDS_ZERO>(mc, nc, c, ldc_c, C, ldc,
+                                                   requant);
+      break;
+    default:
+      RequantRows<Act, ROUND_NEAREST_AWAY_ZERO>(mc, nc, c, ldc_c, C, ldc,
+                                                requant);
+      break;
+  }
+}
+
+// C = requant(A * B), requant 的 scale 和 bias 按行给出
+void Gemm::WriteWithRequant(int32_t mc, int32_t nc, int32_t *c, int8_t *C,
+                            int32_t ldc, const RequantParam &requant) {
+  switch (requant.act) {
+    case IDENTITY:
+      RequantRows<IDENTITY>(mc, nc, c, NC, C, ldc, requant);
+      break;
+    case RELU:
+      RequantRows<RELU>(mc, nc, c, NC, C, ldc, requant);
+      break;
+    case RELU6:
+      RequantRows<RELU6>(mc, nc, c, NC, C, ldc, requant);
+      break;
+    default:
+      PADDLE_MOBILE_THROW_EXCEPTION("activation %d is not supported",
+                                    requant.act);
+  }
+}
+
+// 8 bits int inner product, 写回时重量化
+void Gemm::InnerKernelWithRequant(int32_t mc, int32_t nc, const int8_t *a,
+                                  const int8_t *b, int32_t *c, int8_t *C,
+                                  int32_t ldc, const RequantParam &requant) {
+  parallel_for(0, (nc + NR_INT8 - 1) / NR_INT8, [&](int jb) {
+    int j = jb * NR_INT8;
+    for (int32_t i = 0; i < mc; i += MR_INT8) {
+      AddDot4x2(KC, a + i * KC, b + j * KC, c + i * NC + j, NC);
+    }
+  });
+  WriteWithRequant(mc, nc, c, C, ldc, requant);
+}
+
+// 8 bits int matrix product (m*k x k*n), 输出重量化为 int8
+void Gemm::SgemmWithRequant(int32_t m, int32_t n, int32_t k, const int8_t *A,
+                            int32_t lda, const int8_t *B, int32_t ldb,
+                            int8_t *C, int32_t ldc,
+                            const RequantParam &requant) {
+  int32_t L1 = GetCPUInfo().l1_cache;
+  int32_t L2 = GetCPUInfo().l2_cache;
+
+  KC = (k + 15) - ((k + 15) & 15);
+  MC = L1 / (KC * sizeof(int8_t));
+  NC = L2 / (KC * sizeof(int8_t));
+  if (MC == 0) {
+    MC = MR_INT8;
+  } else {
+    int32_t mblock_num = (m + MC - 1) / MC;
+    MC = (m + mblock_num - 1) / mblock_num;
+    MC = (MC + MR_INT8 - 1) / MR_INT8 * MR_INT8;
+  }
+  if (NC == 0) {
+    NC = NR_INT8;
+  } else {
+    int32_t nblock_num = (n + NC - 1) / NC;
+    NC = (n + nblock_num - 1) / nblock_num;
+    NC = (NC + NR_INT8 - 1) / NR_INT8 * NR_INT8;
+  }
+  packedA_int8 = static_cast<int8_t *>(
+      paddle_mobile::memory::Alloc(sizeof(int8_t) * MC * KC));
+  packedB_int8 = static_cast<int8_t *>(
+      paddle_mobile::memory::Alloc(sizeof(int8_t) * KC * NC));
+  packedC_int32 = static_cast<int32_t *>(
+      paddle_mobile::memory::Alloc(sizeof(int32_t) * MC * NC));
+  zero_int8 =
+      static_cast<int8_t *>(paddle_mobile::memory::Alloc(sizeof(int8_t) * k));
+  memset(static_cast<void *>(zero_int8), 0, sizeof(int8_t) * k);
+
+  for (int32_t j = 0; j < n; j += NC) {
+    int32_t nc = s_min(n - j, NC);
+    PackMatrixB_2c_16(k, nc, nc % NR_INT8, &B(0, j), ldb, packedB_int8);
+    for (int32_t i = 0; i < m; i += MC) {
+      int32_t mc = s_min(m - i, MC);
+      PackMatrixA_4r_16(mc, k, mc % MR_INT8, &A(i, 0), lda, packedA_int8);
+      RequantParam block = requant;
+      block.scale += i;
+      block.bias += i;
+      InnerKernelWithRequant(mc, nc, packedA_int8, packedB_int8,
+                             packedC_int32, &C(i, j), ldc, block);
+    }
+  }
+
+  paddle_mobile::memory::Free(packedA_int8);
+  paddle_mobile::memory::Free(packedB_int8);
+  paddle_mobile::memory::Free(packedC_int32);
+  paddle_mobile::memory::Free(zero_int8);
 }
 
 }  // namespace math
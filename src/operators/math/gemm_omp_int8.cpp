@@ -19,9 +19,6 @@ limitations under the License. */
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 
 namespace paddle_mobile {
 namespace operators {
@@ -30,8 +27,8 @@ namespace math {
 void Gemm::PackMatrixB_omp_8c(int32_t k, int32_t n, int32_t n_tail,
                               const int8_t *B, int32_t ldb, int8_t *buffer) {
   const int32_t j_length = n - n_tail;
-#pragma omp parallel for
-  for (int32_t j = 0; j < j_length; j += 8) {
+  parallel_for(0, (j_length + 7) / 8, [&](int jb) {
+    int j = jb * 8;
     int8_t *local_buffer = buffer + j * k;
     for (int32_t i = 0; i < k; ++i) {
       const int8_t *b0 = &B(i, j);
@@ -58,7 +55,7 @@ void Gemm::PackMatrixB_omp_8c(int32_t k, int32_t n, int32_t n_tail,
       *local_buffer++ = *b0++;
 #endif  // __ARM_NEON
     }
-  }
+  });
   if (n_tail != 0) {
     int8_t *local_buffer = buffer + j_length * k;
     for (int32_t i = 0; i < k; ++i) {
@@ -76,8 +73,8 @@ void Gemm::PackMatrixB_omp_8c(int32_t k, int32_t n, int32_t n_tail,
 void Gemm::PackMatrixA_omp_4r(int32_t m, int32_t k, int32_t m_tail,
                               const int8_t *A, int32_t lda, int8_t *buffer) {
   const int32_t i_length = m - m_tail;
-#pragma omp parallel for
-  for (int32_t i = 0; i < i_length; i += 4) {
+  parallel_for(0, (i_length + 3) / 4, [&](int ib) {
+    int i = ib * 4;
     const int8_t *a0 = A + i * lda;
     const int8_t *a1 = A + (i + 1) * lda;
     const int8_t *a2 = A + (i + 2) * lda;
@@ -89,7 +86,7 @@ void Gemm::PackMatrixA_omp_4r(int32_t m, int32_t k, int32_t m_tail,
       *local_buffer++ = *a2++;
       *local_buffer++ = *a3++;
     }
-  }
+  });
 
   if (m_tail != 0) {
     const int8_t *a0 = &A(i_length, 0);
@@ -123,8 +120,8 @@ void Gemm::PackMatrixA_omp_4r_16(int32_t m, int32_t k, int32_t m_tail,
   const int32_t i_length = m - m_tail;
   const int32_t k_count = k >> 4;
   const int32_t k_tail = k & 15;
-#pragma omp parallel for
-  for (int32_t i = 0; i < i_length; i += 4) {
+  parallel_for(0, (i_length + 3) / 4, [&](int ib) {
+    int i = ib * 4;
     const int8_t *a0 = A + i * lda;
     const int8_t *a1 = A + (i + 1) * lda;
     const int8_t *a2 = A + (i + 2) * lda;
@@ -191,7 +188,7 @@ void Gemm::PackMatrixA_omp_4r_16(int32_t m, int32_t k, int32_t m_tail,
         *local_buffer++ = 0;
       }
     }
-  }
+  });
 
   if (m_tail != 0) {
     const int8_t *a0 = &A(i_length, 0);
@@ -280,8 +277,8 @@ void Gemm::PackMatrixB_omp_2c_16(int32_t k, int32_t n, int32_t n_tail,
   const int32_t j_length = n - n_tail;
   const int32_t k_count = k >> 4;
   const int32_t k_tail = k & 15;
-#pragma omp parallel for
-  for (int32_t j = 0; j < j_length; j += 2) {
+  parallel_for(0, (j_length + 1) / 2, [&](int jb) {
+    int j = jb * 2;
     int8_t *local_buffer = buffer + j * KC;
     for (int32_t i = 0; i < k_count; ++i) {
       const int8_t *b0 = &B((i << 4), j);
@@ -314,7 +311,7 @@ void Gemm::PackMatrixB_omp_2c_16(int32_t k, int32_t n, int32_t n_tail,
         *local_buffer++ = 0;
       }
     }
-  }
+  });
   if (n_tail != 0) {
     int8_t *local_buffer = buffer + j_length * KC;
     for (int32_t i = 0; i < k_count; ++i) {
@@ -0,0 +1,214 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "operators/math/gemm_tuner.h"
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include "common/common.h"
+#include "common/log.h"
+#include "operators/math/gemm.h"
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+// the scale is searched first with the default micro kernel and the whole k,
+// as the prepacked gemms use only the scale, then the micro kernel and the
+// depth of the k blocks
+static const float kCandidateScales[] = {0.5f, 1.f, 2.f, 4.f};
+static const int kCandidateKc[] = {128, 256, 512};
+static const int kTuneRepeats = 3;
+// the operands and the result timed are at most this many floats (16MB)
+static const int64_t kMaxTuneFloats = 1 << 22;
+
+static int Log2Class(int x) {
+  int c = 0;
+  while ((1 << c) < x && c < 30) {
+    ++c;
+  }
+  return c;
+}
+
+GemmTuner *GemmTuner::Instance() {
+  static GemmTuner tuner;
+  return &tuner;
+}
+
+void GemmTuner::EnableTuning(const std::string &profile) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (enabled_ && profile_ == profile) {
+    return;
+  }
+  profile_ = profile;
+  LoadProfile();
+  enabled_ = true;
+}
+
+GemmTuner::Key GemmTuner::ShapeClass(int m, int n, int k, int threads) const {
+  return Key{{threads, Log2Class(m), Log2Class(n), Log2Class(k)}};
+}
+
+GemmBlocking GemmTuner::Blocking(int m, int n, int k, int threads) {
+  if (!enabled_) {
+    return GemmBlocking();
+  }
+  Key key = ShapeClass(m, n, k, threads);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = blockings_.find(key);
+  return iter != blockings_.end() ? iter->second : GemmBlocking();
+}
+
+void GemmTuner::Tune(int m, int n, int k) {
+  if (!enabled_ || m <= 0 || n <= 0 || k <= 0) {
+    return;
+  }
+  Key key = ShapeClass(m, n, k, ThreadPool::Instance()->ThreadNum());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (blockings_.count(key) != 0) {
+      return;
+    }
+  }
+  int64_t floats = static_cast<int64_t>(m) * k +
+                   static_cast<int64_t>(k) * n + static_cast<int64_t>(m) * n;
+  if (floats > kMaxTuneFloats) {
+    DLOG << "gemm " << m << "x" << n << "x" << k
+         << " is too large to tune, the default blocking is kept";
+    return;
+  }
+  // kernels meeting the same class at once tune it each, the first result
+  // is kept
+  GemmBlocking blocking = Search(m, n, k);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!blockings_.insert(std::make_pair(key, blocking)).second) {
+      return;
+    }
+  }
+  SaveProfile();
+}
+
+// times the gemm of this shape with the candidate blockings and returns the
+// fastest
+GemmBlocking GemmTuner::Search(int m, int n, int k) const {
+  std::vector<float> a(m * k), b(k * n), c(m * n);
+  for (size_t i = 0; i < a.size(); ++i) {
+    a[i] = static_cast<float>(rand() % 16) / 16;  // NOLINT
+  }
+  for (size_t i = 0; i < b.size(); ++i) {
+    b[i] = static_cast<float>(rand() % 16) / 16;  // NOLINT
+  }
+
+  GemmBlocking best;
+  double best_time = -1;
+  auto time_blocking = [&](const GemmBlocking &blocking) {
+    Gemm gemm;
+    gemm.SetBlocking(blocking);
+    double min_time = -1;
+    // the first run warms up caches and is not counted
+    for (int r = 0; r <= kTuneRepeats; ++r) {
+      auto t0 = paddle_mobile::time();
+      if (ThreadPool::Instance()->ThreadNum() > 1) {
+        gemm.Sgemm_omp(m, n, k, 1.f, a.data(), k, b.data(), n, 0.f, c.data(), n,
+                       false, nullptr);
+      } else {
+        gemm.Sgemm(m, n, k, 1.f, a.data(), k, b.data(), n, 0.f, c.data(), n,
+                   false, nullptr);
+      }
+      double cost = time_diff(t0, paddle_mobile::time());
+      if (r > 0 && (min_time < 0 || cost < min_time)) {
+        min_time = cost;
+      }
+    }
+    if (best_time < 0 || min_time < best_time) {
+      best_time = min_time;
+      best = blocking;
+    }
+  };
+
+  for (float scale : kCandidateScales) {
+    GemmBlocking blocking;
+    blocking.scale = scale;
+    time_blocking(blocking);
+  }
+  GemmBlocking blocking = best;
+  blocking.micro_kernel = Gemm::MICRO_KERNEL_ALT;
+  time_blocking(blocking);
+  blocking = best;
+  for (int kc : kCandidateKc) {
+    if (kc < k) {
+      blocking.kc = kc;
+      time_blocking(blocking);
+    }
+  }
+  DLOG << "tuned gemm " << m << "x" << n << "x" << k
+       << ", blocking scale: " << best.scale << ", kc: " << best.kc
+       << ", micro kernel: " << best.micro_kernel << ", cost: " << best_time
+       << "ms";
+  return best;
+}
+
+// one shape class per line: threads m_class n_class k_class scale kc
+// micro_kernel, the profiles written with the scale only are still read
+void GemmTuner::LoadProfile() {
+  FILE *file = fopen(profile_.c_str(), "r");
+  if (file == nullptr) {
+    return;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    Key key;
+    GemmBlocking blocking;
+    if (sscanf(line, "%d %d %d %d %f %d %d", &key[0], &key[1], &key[2],
+               &key[3], &blocking.scale, &blocking.kc,
+               &blocking.micro_kernel) >= 5) {
+      blockings_[key] = blocking;
+    }
+  }
+  fclose(file);
+  DLOG << "load " << blockings_.size() << " gemm shape classes from "
+       << profile_;
+}
+
+void GemmTuner::SaveProfile() {
+  // the snapshot is taken under profile_mutex_, so an older one never
+  // overwrites a newer one
+  std::lock_guard<std::mutex> profile_lock(profile_mutex_);
+  std::string profile;
+  std::map<Key, GemmBlocking> blockings;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    profile = profile_;
+    blockings = blockings_;
+  }
+  FILE *file = fopen(profile.c_str(), "w");
+  if (file == nullptr) {
+    LOG(kLOG_WARNING) << "can not write gemm tuning profile " << profile;
+    return;
+  }
+  for (const auto &iter : blockings) {
+    const Key &key = iter.first;
+    const GemmBlocking &blocking = iter.second;
+    fprintf(file, "%d %d %d %d %g %d %d\n", key[0], key[1], key[2], key[3],
+            blocking.scale, blocking.kc, blocking.micro_kernel);
+  }
+  fclose(file);
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
@@ -0,0 +1,84 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+// blocking of the float gemm of a shape class
+struct GemmBlocking {
+  // scale of the L1/L2 cache budgets MC and NC are derived from
+  float scale = 1.f;
+  // depth of the k blocks, 0 keeps the whole k in one block
+  int kc = 0;
+  // Gemm::MicroKernel
+  int micro_kernel = 0;
+};
+
+// Gemm derives MC and NC from the L1/L2 cache budgets, the budgets are the
+// detected cache sizes multiplied by a scale. GemmTuner picks that scale, the
+// depth of the k blocks and the micro kernel per shape class by timing a few
+// candidates. The kernels tune their gemm shapes at Init, so that no
+// inference pays for it, and the results are kept in a profile file so that
+// later processes skip tuning.
+class GemmTuner {
+ public:
+  static GemmTuner *Instance();
+
+  // start tuning unseen shape classes, previous results are loaded from
+  // profile if it exists and new results are written back to it
+  void EnableTuning(const std::string &profile);
+
+  // times the candidates for the class of a (m x k) * (k x n) product with
+  // the current threads unless it is known or tuning is off. The operands
+  // timed are capped, larger shapes keep the default blocking
+  void Tune(int m, int n, int k);
+
+  // blocking of a (m x k) * (k x n) product with threads, the default one
+  // for the classes not tuned
+  GemmBlocking Blocking(int m, int n, int k, int threads);
+
+ private:
+  // threads and the log2 classes of m, n and k
+  typedef std::array<int, 4> Key;
+
+  GemmTuner() {}
+  Key ShapeClass(int m, int n, int k, int threads) const;
+  GemmBlocking Search(int m, int n, int k) const;
+  void LoadProfile();
+  // writes the current blockings without holding mutex_ during the file io
+  void SaveProfile();
+
+  // checked without the lock, gemms do not synchronize while tuning is off
+  std::atomic<bool> enabled_{false};
+  // protects profile_ and blockings_, tuning runs without it so that other
+  // threads keep running their gemms meanwhile
+  std::mutex mutex_;
+  // serializes the writes of the profile file
+  std::mutex profile_mutex_;
+  std::string profile_;
+  std::map<Key, GemmBlocking> blockings_;
+};
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
@@ -0,0 +1,140 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "operators/math/half_convert.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#ifdef __aarch64__
+#include <arm_neon.h>
+#endif
+#include "operators/math/math_func_avx.h"
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+static half FloatToHalfSoft(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  const uint32_t sign = (bits >> 16) & 0x8000;
+  const uint32_t abs_bits = bits & 0x7fffffff;
+  uint32_t result;
+  if (abs_bits > 0x7f800000) {
+    // NaN
+    result = sign | 0x7e00;
+  } else if (abs_bits >= 0x477ff000) {
+    // 大于等于 65520 的值舍入为 inf
+    result = sign | 0x7c00;
+  } else if (abs_bits < 0x38800000) {
+    // 小于 2^-14 的值为非规格化数, 以 2^-24 为单位舍入
+    float abs_value;
+    memcpy(&abs_value, &abs_bits, sizeof(abs_value));
+    result = sign | static_cast<uint32_t>(std::nearbyint(abs_value * 16777216));
+  } else {
+    // 舍去的 13 位尾数舍入到最近的偶数, 进位时指数加一
+    const uint32_t rounded = abs_bits + 0xfff + ((abs_bits >> 13) & 1);
+    result = sign | ((rounded - 0x38000000) >> 13);
+  }
+  return static_cast<half>(result);
+}
+
+static float HalfToFloatSoft(half value) {
+  const uint32_t h = static_cast<uint16_t>(value);
+  const uint32_t sign = (h & 0x8000) << 16;
+  const uint32_t exponent = (h >> 10) & 0x1f;
+  const uint32_t mantissa = h & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0) {
+    // 零和非规格化数
+    float abs_value = mantissa / 16777216.f;
+    memcpy(&bits, &abs_value, sizeof(bits));
+    bits |= sign;
+  } else if (exponent == 0x1f) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+  float result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+F16C_TARGET static void FloatToHalfF16c(const float *input, half *output,
+                                        int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(input + i),
+                                _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), h);
+  }
+  for (; i < count; ++i) {
+    output[i] = FloatToHalfSoft(input[i]);
+  }
+}
+
+F16C_TARGET static void HalfToFloatF16c(const half *input, float *output,
+                                        int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i h =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+    _mm256_storeu_ps(output + i, _mm256_cvtph_ps(h));
+  }
+  for (; i < count; ++i) {
+    output[i] = HalfToFloatSoft(input[i]);
+  }
+}
+#endif
+
+void FloatToHalf(const float *input, half *output, int count) {
+  int i = 0;
+#ifdef __aarch64__
+  for (; i + 4 <= count; i += 4) {
+    float16x4_t h = vcvt_f16_f32(vld1q_f32(input + i));
+    vst1_s16(output + i, vreinterpret_s16_f16(h));
+  }
+#elif defined(__x86_64__) || defined(__i386__)
+  if (HasF16c()) {
+    FloatToHalfF16c(input, output, count);
+    return;
+  }
+#endif
+  for (; i < count; ++i) {
+    output[i] = FloatToHalfSoft(input[i]);
+  }
+}
+
+void HalfToFloat(const half *input, float *output, int count) {
+  int i = 0;
+#ifdef __aarch64__
+  for (; i + 4 <= count; i += 4) {
+    float16x4_t h = vreinterpret_f16_s16(vld1_s16(input + i));
+    vst1q_f32(output + i, vcvt_f32_f16(h));
+  }
+#elif defined(__x86_64__) || defined(__i386__)
+  if (HasF16c()) {
+    HalfToFloatF16c(input, output, count);
+    return;
+  }
+#endif
+  for (; i < count; ++i) {
+    output[i] = HalfToFloatSoft(input[i]);
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
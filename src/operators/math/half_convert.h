@@ -0,0 +1,30 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include "common/types.h"
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+// float 与 IEEE 754 半精度 half 之间的转换, 舍入到最近的偶数. x86 上有 F16C
+// 时和 armv8 上使用硬件指令, 否则软件转换, 结果相同
+void FloatToHalf(const float *input, half *output, int count);
+void HalfToFloat(const half *input, float *output, int count);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
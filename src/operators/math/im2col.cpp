@@ -17,6 +17,7 @@ limitations under the License. */
 #ifdef __ARM_NEON
 #include <arm_neon.h>
 #endif
+#include "common/threadpool.h"
 #include "common/types.h"
 namespace paddle_mobile {
 namespace operators {
@@ -432,8 +433,7 @@ void Im2ColFunctor<ColFormat::kCFO, CPU, float>::operator()(
     int col_spatial_size = col_height * col_width;
     // pad 0
     memset(col_data, 0, col->numel() * sizeof(float));
-    #pragma omp parallel for
-    for (int ic = 0; ic < im_channels; ++ic) {
+    parallel_for(0, im_channels, [&](int ic) {
       const float *local_im_data = im_data + ic * im_spatial_size;
       float *local_col_data =
           col_data + ic * filter_height * filter_width * col_spatial_size;
@@ -445,7 +445,7 @@ void Im2ColFunctor<ColFormat::kCFO, CPU, float>::operator()(
           local_col_data += col_spatial_size;
         }
       }
-    }
+    });
   } else {
 #endif
     for (int c = 0; c < channels_col; ++c) {
@@ -562,8 +562,7 @@ void Im2ColFunctor<ColFormat::kCFO, CPU, int8_t>::operator()(
     int col_spatial_size = col_height * col_width;
     // pad 0
     memset(col_data, 0, col->numel() * sizeof(int8_t));
-    #pragma omp parallel for
-    for (int ic = 0; ic < im_channels; ++ic) {
+    parallel_for(0, im_channels, [&](int ic) {
       const int8_t *local_im_data = im_data + ic * im_spatial_size;
       int8_t *local_col_data =
           col_data + ic * filter_height * filter_width * col_spatial_size;
@@ -575,7 +574,7 @@ void Im2ColFunctor<ColFormat::kCFO, CPU, int8_t>::operator()(
           local_col_data += col_spatial_size;
         }
       }
-    }
+    });
   } else {
 #endif
     for (int c = 0; c < channels_col; ++c) {
@@ -0,0 +1,165 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include <cstddef>
+#include "common/cpu_info.h"
+
+// Functions with this attribute are compiled for avx2 and fma whatever the
+// target flags of the build are, they must only be called after HasAvx2()
+// returns true.
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+// the same for the conversions between float and half, after HasF16c()
+#define F16C_TARGET __attribute__((target("avx,f16c")))
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+inline bool HasAvx2() {
+  static const bool has_avx2 = GetCPUInfo().avx2 && GetCPUInfo().fma;
+  return has_avx2;
+}
+
+inline bool HasF16c() {
+  static const bool has_f16c = GetCPUInfo().f16c;
+  return has_f16c;
+}
+
+// exp() computed for 8 float at once, the same cephes polynomial as
+// exp_ps in math_func_neon.h
+AVX2_TARGET static inline __m256 exp256_ps(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.f);
+  x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+  x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949f));
+
+  // express exp(x) as exp(g + n*log(2))
+  __m256 fx = _mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341f),
+                              _mm256_set1_ps(0.5f));
+  fx = _mm256_floor_ps(fx);
+  x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(0.693359375f), x);
+  x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(-2.12194440e-4f), x);
+
+  __m256 y = _mm256_set1_ps(1.9875691500E-4f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507E-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073E-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894E-2f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201E-1f));
+  y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), x);
+  y = _mm256_add_ps(y, one);
+
+  // build 2^n
+  __m256i n = _mm256_cvttps_epi32(fx);
+  n = _mm256_add_epi32(n, _mm256_set1_epi32(0x7f));
+  n = _mm256_slli_epi32(n, 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+// natural logarithm computed for 8 float at once, returns NaN for x <= 0
+AVX2_TARGET static inline __m256 log256_ps(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.f);
+  __m256 invalid = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OS);
+  // cut off denormalized values
+  x = _mm256_max_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x00800000)));
+
+  __m256i exponent = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+  exponent = _mm256_sub_epi32(exponent, _mm256_set1_epi32(0x7f));
+  // keep the mantissa in [0.5, 1)
+  x = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000)));
+  x = _mm256_or_ps(x, _mm256_set1_ps(0.5f));
+  __m256 e = _mm256_add_ps(_mm256_cvtepi32_ps(exponent), one);
+
+  // if x < SQRTHF, e -= 1 and x = x + x - 1, else x = x - 1
+  __m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(0.707106781186547524f),
+                              _CMP_LT_OS);
+  __m256 tmp = _mm256_and_ps(x, mask);
+  x = _mm256_sub_ps(x, one);
+  e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+  x = _mm256_add_ps(x, tmp);
+
+  __m256 z = _mm256_mul_ps(x, x);
+  __m256 y = _mm256_set1_ps(7.0376836292E-2f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.1514610310E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.1676998740E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.2420140846E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.4249322787E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.6668057665E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(2.0000714765E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-2.4999993993E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(3.3333331174E-1f));
+  y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+
+  y = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+  y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+  x = _mm256_add_ps(x, y);
+  x = _mm256_fmadd_ps(e, _mm256_set1_ps(0.693359375f), x);
+  return _mm256_or_ps(x, invalid);
+}
+
+AVX2_TARGET static inline float hmax256_ps(__m256 x) {
+  __m128 r =
+      _mm_max_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+  r = _mm_max_ps(r, _mm_movehl_ps(r, r));
+  r = _mm_max_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r);
+}
+
+AVX2_TARGET static inline float hadd256_ps(__m256 x) {
+  __m128 r =
+      _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+  r = _mm_add_ps(r, _mm_movehl_ps(r, r));
+  r = _mm_add_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r);
+}
+
+// splits 16 consecutive floats in lo and hi into the even and odd ones,
+// which are the inputs of stride 2 windows
+AVX2_TARGET static inline void deinterleave256_ps(__m256 lo, __m256 hi,
+                                                  __m256 *even, __m256 *odd) {
+  // [lo0 lo2 hi0 hi2 | lo4 lo6 hi4 hi6] -> [lo0 lo2 lo4 lo6 | hi0 hi2 hi4 hi6]
+  __m256 e = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+  __m256 o = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+  *even = _mm256_castpd_ps(
+      _mm256_permute4x64_pd(_mm256_castps_pd(e), _MM_SHUFFLE(3, 1, 2, 0)));
+  *odd = _mm256_castpd_ps(
+      _mm256_permute4x64_pd(_mm256_castps_pd(o), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+// y = x * scale + bias over n floats
+AVX2_TARGET static inline void ScaleBias256(const float *x, float scale,
+                                            float bias, float *y, size_t n) {
+  const __m256 __scale = _mm256_set1_ps(scale);
+  const __m256 __bias = _mm256_set1_ps(bias);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256 r0 = _mm256_loadu_ps(x + i);
+    __m256 r1 = _mm256_loadu_ps(x + i + 8);
+    _mm256_storeu_ps(y + i, _mm256_fmadd_ps(r0, __scale, __bias));
+    _mm256_storeu_ps(y + i + 8, _mm256_fmadd_ps(r1, __scale, __bias));
+  }
+  for (; i < n; ++i) {
+    y[i] = x[i] * scale + bias;
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
+
+#endif  // __x86_64__
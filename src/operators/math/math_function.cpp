@@ -17,7 +17,9 @@ limitations under the License. */
 #include "common/enforce.h"
 #include "framework/data_type.h"
 #include "framework/tensor.h"
+#include "framework/workspace.h"
 #include "operators/math/gemm.h"
+#include "operators/math/half_convert.h"
 
 namespace paddle_mobile {
 namespace operators {
@@ -57,12 +59,12 @@ void MatMul<float, float>(const framework::Tensor &matrix_a, bool trans_a,
   int K = (!trans_a) ? dim_a[1] : dim_a[0];
   Gemm gemm;
   if (trans_a) {
-    framework::Tensor matrix_trans;
+    framework::WorkspaceScope scratch;
     int numel = matrix_a.numel();
     int m = matrix_a.dims()[0];
     int n = matrix_a.dims()[1];
     float *tmp = (float *)(matrix_a.data<float>());  // NOLINT
-    float *a = matrix_trans.mutable_data<float>(matrix_a.dims());
+    float *a = scratch.Allocate<float>(numel);
     int index = 0;
     for (int j = 0; j < n; j++) {
       for (int i = 0; i < m; i++) {
@@ -70,23 +72,23 @@ void MatMul<float, float>(const framework::Tensor &matrix_a, bool trans_a,
       }
     }
 
-#ifdef _OPENMP
-    gemm.Sgemm_omp(M, N, K, alpha, a, K, matrix_b.data<float>(), N, beta,
-                   matrix_out->data<float>(), N, relu, bias);
-#else
-    gemm.Sgemm(M, N, K, alpha, a, K, matrix_b.data<float>(), N, beta,
-               matrix_out->data<float>(), N, relu, bias);
-#endif
+    if (ThreadPool::Instance()->ThreadNum() > 1) {
+      gemm.Sgemm_omp(M, N, K, alpha, a, K, matrix_b.data<float>(), N, beta,
+                     matrix_out->data<float>(), N, relu, bias);
+    } else {
+      gemm.Sgemm(M, N, K, alpha, a, K, matrix_b.data<float>(), N, beta,
+                 matrix_out->data<float>(), N, relu, bias);
+    }
   } else {
-#ifdef _OPENMP
-    gemm.Sgemm_omp(M, N, K, alpha, matrix_a.data<float>(), K,
-                   matrix_b.data<float>(), N, beta, matrix_out->data<float>(),
-                   N, relu, bias);
-#else
-    gemm.Sgemm(M, N, K, alpha, matrix_a.data<float>(), K,
-               matrix_b.data<float>(), N, beta, matrix_out->data<float>(), N,
-               relu, bias);
-#endif
+    if (ThreadPool::Instance()->ThreadNum() > 1) {
+      gemm.Sgemm_omp(M, N, K, alpha, matrix_a.data<float>(), K,
+                     matrix_b.data<float>(), N, beta, matrix_out->data<float>(),
+                     N, relu, bias);
+    } else {
+      gemm.Sgemm(M, N, K, alpha, matrix_a.data<float>(), K,
+                 matrix_b.data<float>(), N, beta, matrix_out->data<float>(), N,
+                 relu, bias);
+    }
   }
 }
 
@@ -107,17 +109,18 @@ void MatMulWithBn(const framework::Tensor &matrix_a, bool trans_a,
   int N = dim_out[1];
   int K = (!trans_a) ? dim_a[1] : dim_a[0];
 
-#ifdef _OPENMP
-  gemm.SgemmWithBn_omp(
-      M, N, K, alpha, matrix_a.data<float>(), K, matrix_b.data<float>(), N,
-      beta, matrix_out->data<float>(), N, relu,
-      new_scale->data<float>() + group, new_bias->data<float>() + group, bias);
-#else
-  gemm.SgemmWithBn(M, N, K, alpha, matrix_a.data<float>(), K,
-                   matrix_b.data<float>(), N, beta, matrix_out->data<float>(),
-                   N, relu, new_scale->data<float>() + group,
-                   new_bias->data<float>() + group, bias);
-#endif
+  if (ThreadPool::Instance()->ThreadNum() > 1) {
+    gemm.SgemmWithBn_omp(
+        M, N, K, alpha, matrix_a.data<float>(), K, matrix_b.data<float>(), N,
+        beta, matrix_out->data<float>(), N, relu,
+        new_scale->data<float>() + group, new_bias->data<float>() + group,
+        bias);
+  } else {
+    gemm.SgemmWithBn(M, N, K, alpha, matrix_a.data<float>(), K,
+                     matrix_b.data<float>(), N, beta, matrix_out->data<float>(),
+                     N, relu, new_scale->data<float>() + group,
+                     new_bias->data<float>() + group, bias);
+  }
 }
 void MatMulWithPRelu(const framework::Tensor &matrix_a, bool trans_a,
                      const framework::Tensor &matrix_b, bool trans_b,
@@ -135,15 +138,75 @@ void MatMulWithPRelu(const framework::Tensor &matrix_a, bool trans_a,
   int N = dim_out[1];
   int K = (!trans_a) ? dim_a[1] : dim_a[0];
 
-#ifdef _OPENMP
-  gemm.SgemmWithPRelu_omp(M, N, K, matrix_a.data<float>(), K,
-                          matrix_b.data<float>(), N, matrix_out->data<float>(),
-                          N, p, mode, bias, bias1);
-#else
-  gemm.SgemmWithPRelu(M, N, K, matrix_a.data<float>(), K,
-                      matrix_b.data<float>(), N, matrix_out->data<float>(), N,
-                      p, mode, bias, bias1);
-#endif
+  if (ThreadPool::Instance()->ThreadNum() > 1) {
+    gemm.SgemmWithPRelu_omp(M, N, K, matrix_a.data<float>(), K,
+                            matrix_b.data<float>(), N,
+                            matrix_out->data<float>(), N, p, mode, bias, bias1);
+  } else {
+    gemm.SgemmWithPRelu(M, N, K, matrix_a.data<float>(), K,
+                        matrix_b.data<float>(), N, matrix_out->data<float>(), N,
+                        p, mode, bias, bias1);
+  }
+}
+
+void PackConvFilter(const framework::Tensor &filter, int groups,
+                    framework::Tensor *packed_filter) {
+  if (packed_filter->IsInitialized()) {
+    // 已由 OperatorBase::InitFrom 从其他 executor 共享
+    return;
+  }
+  int out_step = static_cast<int>(filter.dims()[0]) / groups;
+  int k = static_cast<int>(filter.numel() / filter.dims()[0]);
+  int packed_size = Gemm::PackedASize(out_step, k);
+  float *packed_data =
+      packed_filter->mutable_data<float>({groups, packed_size});
+  const float *filter_data = filter.data<float>();
+  Gemm gemm;
+  for (int g = 0; g < groups; ++g) {
+    gemm.PackWeightA(out_step, k, filter_data + g * out_step * k, k,
+                     packed_data + g * packed_size);
+  }
+}
+
+void PackFcWeight(const framework::Tensor &weight,
+                  framework::Tensor *packed_weight) {
+  if (packed_weight->IsInitialized()) {
+    // 已由 OperatorBase::InitFrom 从其他 executor 共享
+    return;
+  }
+  PADDLE_MOBILE_ENFORCE(weight.dims().size() == 2,
+                        "The weight of fc should be matrix");
+  int k = weight.dims()[0];
+  int n = weight.dims()[1];
+  float *packed_data =
+      packed_weight->mutable_data<float>({Gemm::PackedBSize(k, n)});
+  Gemm gemm;
+  gemm.PackWeightB(k, n, weight.data<float>(), n, packed_data);
+}
+
+void CompressPackedWeight(const framework::Tensor &packed, bool packed_a,
+                          int k, framework::Tensor *compressed) {
+  int groups = packed.dims().size() == 2 ? packed.dims()[0] : 1;
+  int packed_size = static_cast<int>(packed.numel() / groups);
+  int compressed_size = Gemm::CompressedSize(packed_size, k);
+  uint8_t *compressed_data =
+      compressed->mutable_data<uint8_t>({groups, compressed_size});
+  const float *packed_data = packed.data<float>();
+  for (int g = 0; g < groups; ++g) {
+    if (packed_a) {
+      Gemm::CompressPackedA(packed_size, k, packed_data + g * packed_size,
+                            compressed_data + g * compressed_size);
+    } else {
+      Gemm::CompressPackedB(packed_size, k, packed_data + g * packed_size,
+                            compressed_data + g * compressed_size);
+    }
+  }
+}
+
+void ConvertToHalf(const framework::Tensor &input, framework::Tensor *output) {
+  half *output_data = output->mutable_data<half>(input.dims());
+  FloatToHalf(input.data<float>(), output_data,
+              static_cast<int>(input.numel()));
 }
 
 template <typename T>
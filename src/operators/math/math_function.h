@@ -21,6 +21,8 @@ namespace paddle_mobile {
 namespace operators {
 namespace math {
 
+struct RequantParam;
+
 void SetConstant(framework::Tensor *tensor, float value);
 
 template <typename Itype, typename Otype>
@@ -35,6 +37,12 @@ void MatMul(const framework::Tensor &matrix_a, bool trans_a,
             framework::Tensor *matrix_out, float beta, bool relu, Otype *bias,
             bool addOnRow);
 
+// int8 矩阵乘法, 写回时按输出行重量化, matrix_out 为 int8
+void MatMulWithRequant(const framework::Tensor &matrix_a,
+                       const framework::Tensor &matrix_b,
+                       framework::Tensor *matrix_out,
+                       const RequantParam &requant);
+
 void MatMulWithBn(const framework::Tensor &matrix_a, bool trans_a,
                   const framework::Tensor &matrix_b, bool trans_b, float alpha,
                   framework::Tensor *matrix_out, float beta, bool relu,
@@ -46,6 +54,24 @@ void MatMulWithPRelu(const framework::Tensor &matrix_a, bool trans_a,
                      framework::Tensor *matrix_out, float *p, std::string mode,
                      float *bias, float *bias1);
 
+// 在 kernel Init 阶段预打包卷积权重, packed_filter 的第 g 行是第 g 组的权重,
+// packed_filter 已与其他 executor 共享时直接返回
+void PackConvFilter(const framework::Tensor &filter, int groups,
+                    framework::Tensor *packed_filter);
+
+// 在 kernel Init 阶段预打包全连接权重 (K x N), 已共享时直接返回
+void PackFcWeight(const framework::Tensor &weight,
+                  framework::Tensor *packed_weight);
+
+// 将 PackConvFilter 或 PackFcWeight 预打包的权重压缩为 uint8, 每行为一组,
+// 见 Gemm::CompressPackedA 和 Gemm::CompressPackedB. MatMulPackedA,
+// MatMulPackedAIm2Col 和 MatMulPackedB 计算时按分块反量化
+void CompressPackedWeight(const framework::Tensor &packed, bool packed_a,
+                          int k, framework::Tensor *compressed);
+
+// 将 float 的权重转换为同样形状的 half, 如预打包的权重和 lookup_table 的表
+void ConvertToHalf(const framework::Tensor &input, framework::Tensor *output);
+
 template <typename Device, typename T>
 struct ClearTensor {
   void operator()(framework::Tensor *tensor);
@@ -53,45 +53,45 @@ void MatMul<int8_t, int32_t>(const framework::Tensor &matrix_a, bool trans_a,
       }
     }
 
-#ifdef _OPENMP
-    if (bias != nullptr) {
-      gemm.Sgemm_omp(M, N, K, alpha, a, K, matrix_b.data<int8_t>(), N, beta,
-                     matrix_out->data<int8_t>(), N, relu, bias, addOnRow);
-    } else {
-      gemm.Sgemm_omp(M, N, K, alpha, a, K, matrix_b.data<int8_t>(), N, beta,
-                     matrix_out->data<int32_t>(), N, relu, bias, addOnRow);
-    }
-#else
-    if (bias != nullptr) {
-      gemm.Sgemm(M, N, K, alpha, a, K, matrix_b.data<int8_t>(), N, beta,
-                 matrix_out->data<int8_t>(), N, relu, bias, addOnRow);
+    if (ThreadPool::Instance()->ThreadNum() > 1) {
+      if (bias != nullptr) {
+        gemm.Sgemm_omp(M, N, K, alpha, a, K, matrix_b.data<int8_t>(), N, beta,
+                       matrix_out->data<int8_t>(), N, relu, bias, addOnRow);
+      } else {
+        gemm.Sgemm_omp(M, N, K, alpha, a, K, matrix_b.data<int8_t>(), N, beta,
+                       matrix_out->data<int32_t>(), N, relu, bias, addOnRow);
+      }
     } else {
-      gemm.Sgemm(M, N, K, alpha, a, K, matrix_b.data<int8_t>(), N, beta,
-                 matrix_out->data<int32_t>(), N, relu, bias, addOnRow);
+      if (bias != nullptr) {
+        gemm.Sgemm(M, N, K, alpha, a, K, matrix_b.data<int8_t>(), N, beta,
+                   matrix_out->data<int8_t>(), N, relu, bias, addOnRow);
+      } else {
+        gemm.Sgemm(M, N, K, alpha, a, K, matrix_b.data<int8_t>(), N, beta,
+                   matrix_out->data<int32_t>(), N, relu, bias, addOnRow);
+      }
     }
-#endif
   } else {
-#ifdef _OPENMP
-    if (bias != nullptr) {
-      gemm.Sgemm_omp(M, N, K, alpha, matrix_a.data<int8_t>(), K,
-                     matrix_b.data<int8_t>(), N, beta,
-                     matrix_out->data<int8_t>(), N, relu, bias, addOnRow);
-    } else {
-      gemm.Sgemm_omp(M, N, K, alpha, matrix_a.data<int8_t>(), K,
-                     matrix_b.data<int8_t>(), N, beta,
-                     matrix_out->data<int32_t>(), N, relu, bias, addOnRow);
-    }
-#else
-    if (bias != nullptr) {
-      gemm.Sgemm(M, N, K, alpha, matrix_a.data<int8_t>(), K,
-                 matrix_b.data<int8_t>(), N, beta, matrix_out->data<int8_t>(),
-                 N, relu, bias, addOnRow);
+    if (ThreadPool::Instance()->ThreadNum() > 1) {
+      if (bias != nullptr) {
+        gemm.Sgemm_omp(M, N, K, alpha, matrix_a.data<int8_t>(), K,
+                       matrix_b.data<int8_t>(), N, beta,
+                       matrix_out->data<int8_t>(), N, relu, bias, addOnRow);
+      } else {
+        gemm.Sgemm_omp(M, N, K, alpha, matrix_a.data<int8_t>(), K,
+                       matrix_b.data<int8_t>(), N, beta,
+                       matrix_out->data<int32_t>(), N, relu, bias, addOnRow);
+      }
     } else {
-      gemm.Sgemm(M, N, K, alpha, matrix_a.data<int8_t>(), K,
-                 matrix_b.data<int8_t>(), N, beta, matrix_out->data<int32_t>(),
-                 N, relu, bias, addOnRow);
+      if (bias != nullptr) {
+        gemm.Sgemm(M, N, K, alpha, matrix_a.data<int8_t>(), K,
+                   matrix_b.data<int8_t>(), N, beta, matrix_out->data<int8_t>(),
+                   N, relu, bias, addOnRow);
+      } else {
+        gemm.Sgemm(M, N, K, alpha, matrix_a.data<int8_t>(), K,
+                   matrix_b.data<int8_t>(), N, beta,
+                   matrix_out->data<int32_t>(), N, relu, bias, addOnRow);
+      }
     }
-#endif
   }
 }
 
@@ -104,6 +104,25 @@ void MatMul<int8_t, int32_t>(const framework::Tensor &matrix_a, bool trans_a,
                           matrix_out, beta, relu, bias, false);
 }
 
+void MatMulWithRequant(const framework::Tensor &matrix_a,
+                       const framework::Tensor &matrix_b,
+                       framework::Tensor *matrix_out,
+                       const RequantParam &requant) {
+  auto dim_a = matrix_a.dims();
+  auto dim_b = matrix_b.dims();
+  auto dim_out = matrix_out->dims();
+  PADDLE_MOBILE_ENFORCE(
+      dim_a.size() == 2 && dim_b.size() == 2 && dim_out.size() == 2,
+      "The input and output of MatMul be matrix");
+  int32_t M = dim_out[0];
+  int32_t N = dim_out[1];
+  int32_t K = dim_a[1];
+  Gemm gemm;
+  gemm.SgemmWithRequant(M, N, K, matrix_a.data<int8_t>(), K,
+                        matrix_b.data<int8_t>(), N,
+                        matrix_out->data<int8_t>(), N, requant);
+}
+
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle_mobile
@@ -15,6 +15,7 @@ limitations under the License. */
 #ifdef POOL_OP
 
 #include "operators/math/pooling.h"
+#include "common/threadpool.h"
 namespace paddle_mobile {
 namespace operators {
 namespace math {
@@ -43,33 +44,32 @@ void Pooling<P>::operator()(const framework::Tensor &input,
   const size_t input_spatial_size = input_height * input_width;
   const size_t output_spatial_size = output_height * output_width;
 
-  #pragma omp parallel for collapse(2)
-  for (int i = 0; i < batch_size; i++) {
-    for (int c = 0; c < output_channels; ++c) {
-      int channel = i * output_channels + c;
-      const float *input_ptr = input_data + channel * input_spatial_size;
-      float *output_ptr = output_data + channel * output_spatial_size;
+  parallel_for(0, batch_size * output_channels, [&](int index) {
+    int i = index / output_channels;
+    int c = index % output_channels;
+    int channel = i * output_channels + c;
+    const float *input_ptr = input_data + channel * input_spatial_size;
+    float *output_ptr = output_data + channel * output_spatial_size;
 
-      for (int ph = 0; ph < output_height; ++ph) {
-        int hstart = ph * stride_height - padding_height;
-        int hend = std::min(hstart + ksize_height, input_height);
-        hstart = std::max(hstart, 0);
-        for (int pw = 0; pw < output_width; ++pw) {
-          int wstart = pw * stride_width - padding_width;
-          int wend = std::min(wstart + ksize_width, input_width);
-          wstart = std::max(wstart, 0);
+    for (int ph = 0; ph < output_height; ++ph) {
+      int hstart = ph * stride_height - padding_height;
+      int hend = std::min(hstart + ksize_height, input_height);
+      hstart = std::max(hstart, 0);
+      for (int pw = 0; pw < output_width; ++pw) {
+        int wstart = pw * stride_width - padding_width;
+        int wend = std::min(wstart + ksize_width, input_width);
+        wstart = std::max(wstart, 0);
 
-          PoolingVal<P> val;
-          for (int h = hstart; h < hend; ++h) {
-            for (int w = wstart; w < wend; ++w) {
-              val += input_ptr[h * input_width + w];
-            }
+        PoolingVal<P> val;
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            val += input_ptr[h * input_width + w];
           }
-          output_ptr[ph * output_width + pw] = val.Value();
         }
+        output_ptr[ph * output_width + pw] = val.Value();
       }
     }
-  }
+  });
 }
 
 template struct Pooling<MAX>;
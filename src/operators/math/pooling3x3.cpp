@@ -17,6 +17,7 @@ limitations under the License. */
 #if defined(__ARM_NEON) || defined(__ARM_NEON__)
 
 #include <arm_neon.h>
+#include "common/threadpool.h"
 #include "operators/math/pooling.h"
 
 namespace paddle_mobile {
@@ -175,570 +176,569 @@ struct Pooling3x3<P, 1> {
     int valid_w = input_w - 2;
     int valid_w_end = valid_w_start + valid_w;
 
-    #pragma omp parallel for collapse(2)
-    for (int batch = 0; batch < output->dims()[0]; ++batch) {
-      for (int c = 0; c < output->dims()[1]; ++c) {
-        int channel = batch * output->dims()[1] + c;
-        const float *input_ptr = input_data + channel * image_size;
-        float *output_ptr = output_data + channel * out_image_size;
-        // top
-        for (int h = 0; h < valid_h_start; ++h) {
-          Pooling3x3NormalRow<P, 1>(input_ptr, h, input_h, input_w, padding_h,
-                                    padding_w, output_w, output_ptr);
-        }
-        // valid
-        int output_w_tiles = valid_w / 6;
-        int output_w_remain = valid_w - output_w_tiles * 6;
-        for (int h = valid_h_start; h < valid_h_end - 3; h += 4) {
-          const float *input_ptr0 = input_ptr + (h - padding_h) * input_w;
-          const float *input_ptr1 = input_ptr0 + input_w;
-          const float *input_ptr2 = input_ptr1 + input_w;
-          const float *input_ptr3 = input_ptr2 + input_w;
-          const float *input_ptr4 = input_ptr3 + input_w;
-          const float *input_ptr5 = input_ptr4 + input_w;
-          float *output_ptr0 = output_ptr + h * output_w;
-          float *output_ptr1 = output_ptr0 + output_w;
-          float *output_ptr2 = output_ptr1 + output_w;
-          float *output_ptr3 = output_ptr2 + output_w;
-          // pad left
-          if (padding_w) {
-            float32x2_t row0 = vld1_f32(input_ptr0);
-            float32x2_t row1 = vld1_f32(input_ptr1);
-            float32x2_t row2 = vld1_f32(input_ptr2);
-            float32x2_t row3 = vld1_f32(input_ptr3);
-            float32x2_t row4 = vld1_f32(input_ptr4);
-            float32x2_t row5 = vld1_f32(input_ptr5);
-            float32x2_t pad0 = vPoolInit_f32<P>();
-            float32x2_t acc0, acc1, acc2, acc3, acc12, acc34, post;
-            for (int w = valid_w_start - 1; w >= 0; --w) {
-              int padding = padding_w - w;
-              if (padding >= 3) {
-                output_ptr0[w] = 0.f;
-                output_ptr1[w] = 0.f;
-                output_ptr2[w] = 0.f;
-                output_ptr3[w] = 0.f;
-              } else {
-                post = vdup_n_f32(1.f / (3 * (3 - padding)));
-                acc12 = vPoolPre_f32<P>(row1, row2);
-                acc34 = vPoolPre_f32<P>(row3, row4);
-                acc0 = vPoolPre_f32<P>(row0, acc12);
-                acc1 = vPoolPre_f32<P>(row3, acc12);
-                acc2 = vPoolPre_f32<P>(row2, acc34);
-                acc3 = vPoolPre_f32<P>(row5, acc34);
-                acc0 = vpPoolPre_f32<P>(acc0, acc0);
-                acc1 = vpPoolPre_f32<P>(acc1, acc1);
-                acc2 = vpPoolPre_f32<P>(acc2, acc2);
-                acc3 = vpPoolPre_f32<P>(acc3, acc3);
-                acc0 = vPoolPost_f32<P>(acc0, post);
-                acc1 = vPoolPost_f32<P>(acc1, post);
-                acc2 = vPoolPost_f32<P>(acc2, post);
-                acc3 = vPoolPost_f32<P>(acc3, post);
-                vst1_lane_f32(output_ptr0 + w, acc0, 0);
-                vst1_lane_f32(output_ptr1 + w, acc1, 0);
-                vst1_lane_f32(output_ptr2 + w, acc2, 0);
-                vst1_lane_f32(output_ptr3 + w, acc3, 0);
-                row0 = vext_f32(pad0, row0, 1);
-                row1 = vext_f32(pad0, row1, 1);
-                row2 = vext_f32(pad0, row2, 1);
-                row3 = vext_f32(pad0, row3, 1);
-                row4 = vext_f32(pad0, row4, 1);
-                row5 = vext_f32(pad0, row5, 1);
-              }
+    parallel_for(0, output->dims()[0] * output->dims()[1], [&](int index) {
+      int batch = index / output->dims()[1];
+      int c = index % output->dims()[1];
+      int channel = batch * output->dims()[1] + c;
+      const float *input_ptr = input_data + channel * image_size;
+      float *output_ptr = output_data + channel * out_image_size;
+      // top
+      for (int h = 0; h < valid_h_start; ++h) {
+        Pooling3x3NormalRow<P, 1>(input_ptr, h, input_h, input_w, padding_h,
+                                  padding_w, output_w, output_ptr);
+      }
+      // valid
+      int output_w_tiles = valid_w / 6;
+      int output_w_remain = valid_w - output_w_tiles * 6;
+      for (int h = valid_h_start; h < valid_h_end - 3; h += 4) {
+        const float *input_ptr0 = input_ptr + (h - padding_h) * input_w;
+        const float *input_ptr1 = input_ptr0 + input_w;
+        const float *input_ptr2 = input_ptr1 + input_w;
+        const float *input_ptr3 = input_ptr2 + input_w;
+        const float *input_ptr4 = input_ptr3 + input_w;
+        const float *input_ptr5 = input_ptr4 + input_w;
+        float *output_ptr0 = output_ptr + h * output_w;
+        float *output_ptr1 = output_ptr0 + output_w;
+        float *output_ptr2 = output_ptr1 + output_w;
+        float *output_ptr3 = output_ptr2 + output_w;
+        // pad left
+        if (padding_w) {
+          float32x2_t row0 = vld1_f32(input_ptr0);
+          float32x2_t row1 = vld1_f32(input_ptr1);
+          float32x2_t row2 = vld1_f32(input_ptr2);
+          float32x2_t row3 = vld1_f32(input_ptr3);
+          float32x2_t row4 = vld1_f32(input_ptr4);
+          float32x2_t row5 = vld1_f32(input_ptr5);
+          float32x2_t pad0 = vPoolInit_f32<P>();
+          float32x2_t acc0, acc1, acc2, acc3, acc12, acc34, post;
+          for (int w = valid_w_start - 1; w >= 0; --w) {
+            int padding = padding_w - w;
+            if (padding >= 3) {
+              output_ptr0[w] = 0.f;
+              output_ptr1[w] = 0.f;
+              output_ptr2[w] = 0.f;
+              output_ptr3[w] = 0.f;
+            } else {
+              post = vdup_n_f32(1.f / (3 * (3 - padding)));
+              acc12 = vPoolPre_f32<P>(row1, row2);
+              acc34 = vPoolPre_f32<P>(row3, row4);
+              acc0 = vPoolPre_f32<P>(row0, acc12);
+              acc1 = vPoolPre_f32<P>(row3, acc12);
+              acc2 = vPoolPre_f32<P>(row2, acc34);
+              acc3 = vPoolPre_f32<P>(row5, acc34);
+              acc0 = vpPoolPre_f32<P>(acc0, acc0);
+              acc1 = vpPoolPre_f32<P>(acc1, acc1);
+              acc2 = vpPoolPre_f32<P>(acc2, acc2);
+              acc3 = vpPoolPre_f32<P>(acc3, acc3);
+              acc0 = vPoolPost_f32<P>(acc0, post);
+              acc1 = vPoolPost_f32<P>(acc1, post);
+              acc2 = vPoolPost_f32<P>(acc2, post);
+              acc3 = vPoolPost_f32<P>(acc3, post);
+              vst1_lane_f32(output_ptr0 + w, acc0, 0);
+              vst1_lane_f32(output_ptr1 + w, acc1, 0);
+              vst1_lane_f32(output_ptr2 + w, acc2, 0);
+              vst1_lane_f32(output_ptr3 + w, acc3, 0);
+              row0 = vext_f32(pad0, row0, 1);
+              row1 = vext_f32(pad0, row1, 1);
+              row2 = vext_f32(pad0, row2, 1);
+              row3 = vext_f32(pad0, row3, 1);
+              row4 = vext_f32(pad0, row4, 1);
+              row5 = vext_f32(pad0, row5, 1);
             }
-            output_ptr0 += valid_w_start;
-            output_ptr1 += valid_w_start;
-            output_ptr2 += valid_w_start;
-            output_ptr3 += valid_w_start;
           }
-          // valid
-          float32x4x2_t x0, x1, x2;
-          float32x4x2_t y0, y1, y2;
-          float32x4_t post = vdupq_n_f32(1.f / 9);
-          for (int loop = 0; loop < output_w_tiles; ++loop) {
-            x0.val[0] = vld1q_f32(input_ptr0);
-            x0.val[1] = vld1q_f32(input_ptr0 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-
-            x0.val[0] = vld1q_f32(input_ptr1);
-            x0.val[1] = vld1q_f32(input_ptr1 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(y1.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(y1.val[1], y0.val[1]);
-
-            x0.val[0] = vld1q_f32(input_ptr2);
-            x0.val[1] = vld1q_f32(input_ptr2 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            y2.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y2.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(y2.val[0], y1.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(y2.val[1], y1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(y2.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(y2.val[1], y0.val[1]);
-            y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
-            y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
-            vst1q_f32(output_ptr0, y0.val[0]);
-            vst1_f32(output_ptr0 + 4, vget_low_f32(y0.val[1]));
-
-            x0.val[0] = vld1q_f32(input_ptr3);
-            x0.val[1] = vld1q_f32(input_ptr3 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(y0.val[0], y1.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(y0.val[1], y1.val[1]);
-            y2.val[0] = vPoolPreq_f32<P>(y0.val[0], y2.val[0]);
-            y2.val[1] = vPoolPreq_f32<P>(y0.val[1], y2.val[1]);
-            y1.val[0] = vPoolPostq_f32<P>(y1.val[0], post);
-            y1.val[1] = vPoolPostq_f32<P>(y1.val[1], post);
-            vst1q_f32(output_ptr1, y1.val[0]);
-            vst1_f32(output_ptr1 + 4, vget_low_f32(y1.val[1]));
-
-            x0.val[0] = vld1q_f32(input_ptr4);
-            x0.val[1] = vld1q_f32(input_ptr4 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-            y2.val[0] = vPoolPreq_f32<P>(x0.val[0], y2.val[0]);
-            y2.val[1] = vPoolPreq_f32<P>(x0.val[1], y2.val[1]);
-            y2.val[0] = vPoolPostq_f32<P>(y2.val[0], post);
-            y2.val[1] = vPoolPostq_f32<P>(y2.val[1], post);
-            vst1q_f32(output_ptr2, y2.val[0]);
-            vst1_f32(output_ptr2 + 4, vget_low_f32(y2.val[1]));
-
-            x0.val[0] = vld1q_f32(input_ptr5);
-            x0.val[1] = vld1q_f32(input_ptr5 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-            y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
-            y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
-            vst1q_f32(output_ptr3, y0.val[0]);
-            vst1_f32(output_ptr3 + 4, vget_low_f32(y0.val[1]));
-
-            input_ptr0 += 6;
-            input_ptr1 += 6;
-            input_ptr2 += 6;
-            input_ptr3 += 6;
-            input_ptr4 += 6;
-            input_ptr5 += 6;
-            output_ptr0 += 6;
-            output_ptr1 += 6;
-            output_ptr2 += 6;
-            output_ptr3 += 6;
-          }
-          // remain width
-          if (output_w_remain > 0) {
-            float32x4x2_t y3;
-            x0.val[0] = vld1q_f32(input_ptr0);
-            x0.val[1] = vld1q_f32(input_ptr0 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-
-            x0.val[0] = vld1q_f32(input_ptr1);
-            x0.val[1] = vld1q_f32(input_ptr1 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(y1.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(y1.val[1], y0.val[1]);
-
-            x0.val[0] = vld1q_f32(input_ptr2);
-            x0.val[1] = vld1q_f32(input_ptr2 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            y2.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y2.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(y2.val[0], y1.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(y2.val[1], y1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(y2.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(y2.val[1], y0.val[1]);
-            y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
-            y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
-
-            x0.val[0] = vld1q_f32(input_ptr3);
-            x0.val[1] = vld1q_f32(input_ptr3 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            y3.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y3.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(y3.val[0], y1.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(y3.val[1], y1.val[1]);
-            y2.val[0] = vPoolPreq_f32<P>(y3.val[0], y2.val[0]);
-            y2.val[1] = vPoolPreq_f32<P>(y3.val[1], y2.val[1]);
-            y1.val[0] = vPoolPostq_f32<P>(y1.val[0], post);
-            y1.val[1] = vPoolPostq_f32<P>(y1.val[1], post);
-
-            x0.val[0] = vld1q_f32(input_ptr4);
-            x0.val[1] = vld1q_f32(input_ptr4 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y3.val[0] = vPoolPreq_f32<P>(x0.val[0], y3.val[0]);
-            y3.val[1] = vPoolPreq_f32<P>(x0.val[1], y3.val[1]);
-            y2.val[0] = vPoolPreq_f32<P>(x0.val[0], y2.val[0]);
-            y2.val[1] = vPoolPreq_f32<P>(x0.val[1], y2.val[1]);
-            y2.val[0] = vPoolPostq_f32<P>(y2.val[0], post);
-            y2.val[1] = vPoolPostq_f32<P>(y2.val[1], post);
-
-            x0.val[0] = vld1q_f32(input_ptr5);
-            x0.val[1] = vld1q_f32(input_ptr5 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y3.val[0] = vPoolPreq_f32<P>(x0.val[0], y3.val[0]);
-            y3.val[1] = vPoolPreq_f32<P>(x0.val[1], y3.val[1]);
-            y3.val[0] = vPoolPostq_f32<P>(y3.val[0], post);
-            y3.val[1] = vPoolPostq_f32<P>(y3.val[1], post);
-
-            switch (output_w_remain) {
-              case 1:
-                vst1q_lane_f32(output_ptr0, y0.val[0], 0);
-                vst1q_lane_f32(output_ptr1, y1.val[0], 0);
-                vst1q_lane_f32(output_ptr2, y2.val[0], 0);
-                vst1q_lane_f32(output_ptr3, y3.val[0], 0);
-                break;
-              case 2:
-                vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
-                vst1_f32(output_ptr1, vget_low_f32(y1.val[0]));
-                vst1_f32(output_ptr2, vget_low_f32(y2.val[0]));
-                vst1_f32(output_ptr3, vget_low_f32(y3.val[0]));
-                break;
-              case 3:
-                vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
-                vst1_f32(output_ptr1, vget_low_f32(y1.val[0]));
-                vst1_f32(output_ptr2, vget_low_f32(y2.val[0]));
-                vst1_f32(output_ptr3, vget_low_f32(y3.val[0]));
-                vst1q_lane_f32(output_ptr0 + 2, y0.val[0], 2);
-                vst1q_lane_f32(output_ptr1 + 2, y1.val[0], 2);
-                vst1q_lane_f32(output_ptr2 + 2, y2.val[0], 2);
-                vst1q_lane_f32(output_ptr3 + 2, y3.val[0], 2);
-                break;
-              case 4:
-                vst1q_f32(output_ptr0, y0.val[0]);
-                vst1q_f32(output_ptr1, y1.val[0]);
-                vst1q_f32(output_ptr2, y2.val[0]);
-                vst1q_f32(output_ptr3, y3.val[0]);
-                break;
-              case 5:
-                vst1q_f32(output_ptr0, y0.val[0]);
-                vst1q_f32(output_ptr1, y1.val[0]);
-                vst1q_f32(output_ptr2, y2.val[0]);
-                vst1q_f32(output_ptr3, y3.val[0]);
-                vst1q_lane_f32(output_ptr0 + 4, y0.val[1], 0);
-                vst1q_lane_f32(output_ptr1 + 4, y1.val[1], 0);
-                vst1q_lane_f32(output_ptr2 + 4, y2.val[1], 0);
-                vst1q_lane_f32(output_ptr3 + 4, y3.val[1], 0);
-                break;
-            }
-            input_ptr0 += output_w_remain;
-            input_ptr1 += output_w_remain;
-            input_ptr2 += output_w_remain;
-            input_ptr3 += output_w_remain;
-            input_ptr4 += output_w_remain;
-            input_ptr5 += output_w_remain;
-            output_ptr0 += output_w_remain;
-            output_ptr1 += output_w_remain;
-            output_ptr2 += output_w_remain;
-            output_ptr3 += output_w_remain;
+          output_ptr0 += valid_w_start;
+          output_ptr1 += valid_w_start;
+          output_ptr2 += valid_w_start;
+          output_ptr3 += valid_w_start;
+        }
+        // valid
+        float32x4x2_t x0, x1, x2;
+        float32x4x2_t y0, y1, y2;
+        float32x4_t post = vdupq_n_f32(1.f / 9);
+        for (int loop = 0; loop < output_w_tiles; ++loop) {
+          x0.val[0] = vld1q_f32(input_ptr0);
+          x0.val[1] = vld1q_f32(input_ptr0 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+
+          x0.val[0] = vld1q_f32(input_ptr1);
+          x0.val[1] = vld1q_f32(input_ptr1 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(y1.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(y1.val[1], y0.val[1]);
+
+          x0.val[0] = vld1q_f32(input_ptr2);
+          x0.val[1] = vld1q_f32(input_ptr2 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          y2.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y2.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(y2.val[0], y1.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(y2.val[1], y1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(y2.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(y2.val[1], y0.val[1]);
+          y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
+          y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
+          vst1q_f32(output_ptr0, y0.val[0]);
+          vst1_f32(output_ptr0 + 4, vget_low_f32(y0.val[1]));
+
+          x0.val[0] = vld1q_f32(input_ptr3);
+          x0.val[1] = vld1q_f32(input_ptr3 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(y0.val[0], y1.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(y0.val[1], y1.val[1]);
+          y2.val[0] = vPoolPreq_f32<P>(y0.val[0], y2.val[0]);
+          y2.val[1] = vPoolPreq_f32<P>(y0.val[1], y2.val[1]);
+          y1.val[0] = vPoolPostq_f32<P>(y1.val[0], post);
+          y1.val[1] = vPoolPostq_f32<P>(y1.val[1], post);
+          vst1q_f32(output_ptr1, y1.val[0]);
+          vst1_f32(output_ptr1 + 4, vget_low_f32(y1.val[1]));
+
+          x0.val[0] = vld1q_f32(input_ptr4);
+          x0.val[1] = vld1q_f32(input_ptr4 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+          y2.val[0] = vPoolPreq_f32<P>(x0.val[0], y2.val[0]);
+          y2.val[1] = vPoolPreq_f32<P>(x0.val[1], y2.val[1]);
+          y2.val[0] = vPoolPostq_f32<P>(y2.val[0], post);
+          y2.val[1] = vPoolPostq_f32<P>(y2.val[1], post);
+          vst1q_f32(output_ptr2, y2.val[0]);
+          vst1_f32(output_ptr2 + 4, vget_low_f32(y2.val[1]));
+
+          x0.val[0] = vld1q_f32(input_ptr5);
+          x0.val[1] = vld1q_f32(input_ptr5 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+          y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
+          y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
+          vst1q_f32(output_ptr3, y0.val[0]);
+          vst1_f32(output_ptr3 + 4, vget_low_f32(y0.val[1]));
+
+          input_ptr0 += 6;
+          input_ptr1 += 6;
+          input_ptr2 += 6;
+          input_ptr3 += 6;
+          input_ptr4 += 6;
+          input_ptr5 += 6;
+          output_ptr0 += 6;
+          output_ptr1 += 6;
+          output_ptr2 += 6;
+          output_ptr3 += 6;
+        }
+        // remain width
+        if (output_w_remain > 0) {
+          float32x4x2_t y3;
+          x0.val[0] = vld1q_f32(input_ptr0);
+          x0.val[1] = vld1q_f32(input_ptr0 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+
+          x0.val[0] = vld1q_f32(input_ptr1);
+          x0.val[1] = vld1q_f32(input_ptr1 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(y1.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(y1.val[1], y0.val[1]);
+
+          x0.val[0] = vld1q_f32(input_ptr2);
+          x0.val[1] = vld1q_f32(input_ptr2 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          y2.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y2.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(y2.val[0], y1.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(y2.val[1], y1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(y2.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(y2.val[1], y0.val[1]);
+          y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
+          y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
+
+          x0.val[0] = vld1q_f32(input_ptr3);
+          x0.val[1] = vld1q_f32(input_ptr3 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          y3.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y3.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(y3.val[0], y1.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(y3.val[1], y1.val[1]);
+          y2.val[0] = vPoolPreq_f32<P>(y3.val[0], y2.val[0]);
+          y2.val[1] = vPoolPreq_f32<P>(y3.val[1], y2.val[1]);
+          y1.val[0] = vPoolPostq_f32<P>(y1.val[0], post);
+          y1.val[1] = vPoolPostq_f32<P>(y1.val[1], post);
+
+          x0.val[0] = vld1q_f32(input_ptr4);
+          x0.val[1] = vld1q_f32(input_ptr4 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y3.val[0] = vPoolPreq_f32<P>(x0.val[0], y3.val[0]);
+          y3.val[1] = vPoolPreq_f32<P>(x0.val[1], y3.val[1]);
+          y2.val[0] = vPoolPreq_f32<P>(x0.val[0], y2.val[0]);
+          y2.val[1] = vPoolPreq_f32<P>(x0.val[1], y2.val[1]);
+          y2.val[0] = vPoolPostq_f32<P>(y2.val[0], post);
+          y2.val[1] = vPoolPostq_f32<P>(y2.val[1], post);
+
+          x0.val[0] = vld1q_f32(input_ptr5);
+          x0.val[1] = vld1q_f32(input_ptr5 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y3.val[0] = vPoolPreq_f32<P>(x0.val[0], y3.val[0]);
+          y3.val[1] = vPoolPreq_f32<P>(x0.val[1], y3.val[1]);
+          y3.val[0] = vPoolPostq_f32<P>(y3.val[0], post);
+          y3.val[1] = vPoolPostq_f32<P>(y3.val[1], post);
+
+          switch (output_w_remain) {
+            case 1:
+              vst1q_lane_f32(output_ptr0, y0.val[0], 0);
+              vst1q_lane_f32(output_ptr1, y1.val[0], 0);
+              vst1q_lane_f32(output_ptr2, y2.val[0], 0);
+              vst1q_lane_f32(output_ptr3, y3.val[0], 0);
+              break;
+            case 2:
+              vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
+              vst1_f32(output_ptr1, vget_low_f32(y1.val[0]));
+              vst1_f32(output_ptr2, vget_low_f32(y2.val[0]));
+              vst1_f32(output_ptr3, vget_low_f32(y3.val[0]));
+              break;
+            case 3:
+              vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
+              vst1_f32(output_ptr1, vget_low_f32(y1.val[0]));
+              vst1_f32(output_ptr2, vget_low_f32(y2.val[0]));
+              vst1_f32(output_ptr3, vget_low_f32(y3.val[0]));
+              vst1q_lane_f32(output_ptr0 + 2, y0.val[0], 2);
+              vst1q_lane_f32(output_ptr1 + 2, y1.val[0], 2);
+              vst1q_lane_f32(output_ptr2 + 2, y2.val[0], 2);
+              vst1q_lane_f32(output_ptr3 + 2, y3.val[0], 2);
+              break;
+            case 4:
+              vst1q_f32(output_ptr0, y0.val[0]);
+              vst1q_f32(output_ptr1, y1.val[0]);
+              vst1q_f32(output_ptr2, y2.val[0]);
+              vst1q_f32(output_ptr3, y3.val[0]);
+              break;
+            case 5:
+              vst1q_f32(output_ptr0, y0.val[0]);
+              vst1q_f32(output_ptr1, y1.val[0]);
+              vst1q_f32(output_ptr2, y2.val[0]);
+              vst1q_f32(output_ptr3, y3.val[0]);
+              vst1q_lane_f32(output_ptr0 + 4, y0.val[1], 0);
+              vst1q_lane_f32(output_ptr1 + 4, y1.val[1], 0);
+              vst1q_lane_f32(output_ptr2 + 4, y2.val[1], 0);
+              vst1q_lane_f32(output_ptr3 + 4, y3.val[1], 0);
+              break;
           }
-          // pad right
-          if (padding_w) {
-            float32x2_t row0 = vld1_f32(input_ptr0);
-            float32x2_t row1 = vld1_f32(input_ptr1);
-            float32x2_t row2 = vld1_f32(input_ptr2);
-            float32x2_t row3 = vld1_f32(input_ptr3);
-            float32x2_t row4 = vld1_f32(input_ptr4);
-            float32x2_t row5 = vld1_f32(input_ptr5);
-            float32x2_t pad0 = vPoolInit_f32<P>();
-            float32x2_t acc0, acc1, acc2, acc3, acc12, acc34, post;
-            for (int w = valid_w_end; w < output_w; ++w) {
-              int padding = w + 3 - (padding_w + input_w);
-              if (padding >= 3) {
-                *output_ptr0 = 0.f;
-                *output_ptr1 = 0.f;
-                *output_ptr2 = 0.f;
-                *output_ptr3 = 0.f;
-              } else {
-                post = vdup_n_f32(1.f / (3 * (3 - padding)));
-                acc12 = vPoolPre_f32<P>(row1, row2);
-                acc34 = vPoolPre_f32<P>(row3, row4);
-                acc0 = vPoolPre_f32<P>(row0, acc12);
-                acc1 = vPoolPre_f32<P>(row3, acc12);
-                acc2 = vPoolPre_f32<P>(row2, acc34);
-                acc3 = vPoolPre_f32<P>(row5, acc34);
-                acc0 = vpPoolPre_f32<P>(acc0, acc0);
-                acc1 = vpPoolPre_f32<P>(acc1, acc1);
-                acc2 = vpPoolPre_f32<P>(acc2, acc2);
-                acc3 = vpPoolPre_f32<P>(acc3, acc3);
-                acc0 = vPoolPost_f32<P>(acc0, post);
-                acc1 = vPoolPost_f32<P>(acc1, post);
-                acc2 = vPoolPost_f32<P>(acc2, post);
-                acc3 = vPoolPost_f32<P>(acc3, post);
-                vst1_lane_f32(output_ptr0, acc0, 0);
-                vst1_lane_f32(output_ptr1, acc1, 0);
-                vst1_lane_f32(output_ptr2, acc2, 0);
-                vst1_lane_f32(output_ptr3, acc3, 0);
-                row0 = vext_f32(row0, pad0, 1);
-                row1 = vext_f32(row1, pad0, 1);
-                row2 = vext_f32(row2, pad0, 1);
-                row3 = vext_f32(row3, pad0, 1);
-                row4 = vext_f32(row4, pad0, 1);
-                row5 = vext_f32(row5, pad0, 1);
-              }
-              output_ptr0++;
-              output_ptr1++;
-              output_ptr2++;
-              output_ptr3++;
+          input_ptr0 += output_w_remain;
+          input_ptr1 += output_w_remain;
+          input_ptr2 += output_w_remain;
+          input_ptr3 += output_w_remain;
+          input_ptr4 += output_w_remain;
+          input_ptr5 += output_w_remain;
+          output_ptr0 += output_w_remain;
+          output_ptr1 += output_w_remain;
+          output_ptr2 += output_w_remain;
+          output_ptr3 += output_w_remain;
+        }
+        // pad right
+        if (padding_w) {
+          float32x2_t row0 = vld1_f32(input_ptr0);
+          float32x2_t row1 = vld1_f32(input_ptr1);
+          float32x2_t row2 = vld1_f32(input_ptr2);
+          float32x2_t row3 = vld1_f32(input_ptr3);
+          float32x2_t row4 = vld1_f32(input_ptr4);
+          float32x2_t row5 = vld1_f32(input_ptr5);
+          float32x2_t pad0 = vPoolInit_f32<P>();
+          float32x2_t acc0, acc1, acc2, acc3, acc12, acc34, post;
+          for (int w = valid_w_end; w < output_w; ++w) {
+            int padding = w + 3 - (padding_w + input_w);
+            if (padding >= 3) {
+              *output_ptr0 = 0.f;
+              *output_ptr1 = 0.f;
+              *output_ptr2 = 0.f;
+              *output_ptr3 = 0.f;
+            } else {
+              post = vdup_n_f32(1.f / (3 * (3 - padding)));
+              acc12 = vPoolPre_f32<P>(row1, row2);
+              acc34 = vPoolPre_f32<P>(row3, row4);
+              acc0 = vPoolPre_f32<P>(row0, acc12);
+              acc1 = vPoolPre_f32<P>(row3, acc12);
+              acc2 = vPoolPre_f32<P>(row2, acc34);
+              acc3 = vPoolPre_f32<P>(row5, acc34);
+              acc0 = vpPoolPre_f32<P>(acc0, acc0);
+              acc1 = vpPoolPre_f32<P>(acc1, acc1);
+              acc2 = vpPoolPre_f32<P>(acc2, acc2);
+              acc3 = vpPoolPre_f32<P>(acc3, acc3);
+              acc0 = vPoolPost_f32<P>(acc0, post);
+              acc1 = vPoolPost_f32<P>(acc1, post);
+              acc2 = vPoolPost_f32<P>(acc2, post);
+              acc3 = vPoolPost_f32<P>(acc3, post);
+              vst1_lane_f32(output_ptr0, acc0, 0);
+              vst1_lane_f32(output_ptr1, acc1, 0);
+              vst1_lane_f32(output_ptr2, acc2, 0);
+              vst1_lane_f32(output_ptr3, acc3, 0);
+              row0 = vext_f32(row0, pad0, 1);
+              row1 = vext_f32(row1, pad0, 1);
+              row2 = vext_f32(row2, pad0, 1);
+              row3 = vext_f32(row3, pad0, 1);
+              row4 = vext_f32(row4, pad0, 1);
+              row5 = vext_f32(row5, pad0, 1);
             }
+            output_ptr0++;
+            output_ptr1++;
+            output_ptr2++;
+            output_ptr3++;
           }
         }
-        // remain height
-        int start_h = valid_h_start + (valid_h & 0xFFFC);
-        for (int h = start_h; h < valid_h_end; ++h) {
-          const float *input_ptr0 = input_ptr + (h - padding_h) * input_w;
-          const float *input_ptr1 = input_ptr0 + input_w;
-          const float *input_ptr2 = input_ptr1 + input_w;
-          float *output_ptr0 = output_ptr + h * output_w;
-          // pad left
-          if (padding_w) {
-            float32x2_t row0 = vld1_f32(input_ptr0);
-            float32x2_t row1 = vld1_f32(input_ptr1);
-            float32x2_t row2 = vld1_f32(input_ptr2);
-            float32x2_t pad0 = vPoolInit_f32<P>();
-            float32x2_t acc0, post;
-            for (int w = valid_w_start - 1; w >= 0; --w) {
-              int padding = padding_w - w;
-              if (padding >= 3) {
-                output_ptr0[w] = 0.f;
-              } else {
-                post = vdup_n_f32(1.f / (3 * (3 - padding)));
-                acc0 = vPoolPre_f32<P>(row0, row1);
-                acc0 = vPoolPre_f32<P>(acc0, row2);
-                acc0 = vpPoolPre_f32<P>(acc0, acc0);
-                acc0 = vPoolPost_f32<P>(acc0, post);
-                vst1_lane_f32(output_ptr0 + w, acc0, 0);
-                row0 = vext_f32(pad0, row0, 1);
-                row1 = vext_f32(pad0, row1, 1);
-                row2 = vext_f32(pad0, row2, 1);
-              }
+      }
+      // remain height
+      int start_h = valid_h_start + (valid_h & 0xFFFC);
+      for (int h = start_h; h < valid_h_end; ++h) {
+        const float *input_ptr0 = input_ptr + (h - padding_h) * input_w;
+        const float *input_ptr1 = input_ptr0 + input_w;
+        const float *input_ptr2 = input_ptr1 + input_w;
+        float *output_ptr0 = output_ptr + h * output_w;
+        // pad left
+        if (padding_w) {
+          float32x2_t row0 = vld1_f32(input_ptr0);
+          float32x2_t row1 = vld1_f32(input_ptr1);
+          float32x2_t row2 = vld1_f32(input_ptr2);
+          float32x2_t pad0 = vPoolInit_f32<P>();
+          float32x2_t acc0, post;
+          for (int w = valid_w_start - 1; w >= 0; --w) {
+            int padding = padding_w - w;
+            if (padding >= 3) {
+              output_ptr0[w] = 0.f;
+            } else {
+              post = vdup_n_f32(1.f / (3 * (3 - padding)));
+              acc0 = vPoolPre_f32<P>(row0, row1);
+              acc0 = vPoolPre_f32<P>(acc0, row2);
+              acc0 = vpPoolPre_f32<P>(acc0, acc0);
+              acc0 = vPoolPost_f32<P>(acc0, post);
+              vst1_lane_f32(output_ptr0 + w, acc0, 0);
+              row0 = vext_f32(pad0, row0, 1);
+              row1 = vext_f32(pad0, row1, 1);
+              row2 = vext_f32(pad0, row2, 1);
             }
-            output_ptr0 += valid_w_start;
           }
-          // valid
-          float32x4x2_t x0, x1, x2, y0;
-          float32x4_t post = vdupq_n_f32(1.f / 9);
-          for (int loop = 0; loop < output_w_tiles; ++loop) {
-            x0.val[0] = vld1q_f32(input_ptr0);
-            x0.val[1] = vld1q_f32(input_ptr0 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-
-            x0.val[0] = vld1q_f32(input_ptr1);
-            x0.val[1] = vld1q_f32(input_ptr1 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-
-            x0.val[0] = vld1q_f32(input_ptr2);
-            x0.val[1] = vld1q_f32(input_ptr2 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-            y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
-            y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
-            vst1q_f32(output_ptr0, y0.val[0]);
-            vst1_f32(output_ptr0 + 4, vget_low_f32(y0.val[1]));
-
-            input_ptr0 += 6;
-            input_ptr1 += 6;
-            input_ptr2 += 6;
-            output_ptr0 += 6;
-          }
-          // remain width
-          if (output_w_remain > 0) {
-            x0.val[0] = vld1q_f32(input_ptr0);
-            x0.val[1] = vld1q_f32(input_ptr0 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-
-            x0.val[0] = vld1q_f32(input_ptr1);
-            x0.val[1] = vld1q_f32(input_ptr1 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-
-            x0.val[0] = vld1q_f32(input_ptr2);
-            x0.val[1] = vld1q_f32(input_ptr2 + 4);
-            x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
-            x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
-            x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
-            x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-            y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
-            y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
-            // restore
-            switch (output_w_remain) {
-              case 1:
-                vst1q_lane_f32(output_ptr0, y0.val[0], 0);
-                break;
-              case 2:
-                vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
-                break;
-              case 3:
-                vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
-                vst1q_lane_f32(output_ptr0 + 2, y0.val[0], 2);
-                break;
-              case 4:
-                vst1q_f32(output_ptr0, y0.val[0]);
-                break;
-              case 5:
-                vst1q_f32(output_ptr0, y0.val[0]);
-                vst1q_lane_f32(output_ptr0 + 4, y0.val[1], 0);
-                break;
-            }
-            input_ptr0 += output_w_remain;
-            input_ptr1 += output_w_remain;
-            input_ptr2 += output_w_remain;
-            output_ptr0 += output_w_remain;
+          output_ptr0 += valid_w_start;
+        }
+        // valid
+        float32x4x2_t x0, x1, x2, y0;
+        float32x4_t post = vdupq_n_f32(1.f / 9);
+        for (int loop = 0; loop < output_w_tiles; ++loop) {
+          x0.val[0] = vld1q_f32(input_ptr0);
+          x0.val[1] = vld1q_f32(input_ptr0 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+
+          x0.val[0] = vld1q_f32(input_ptr1);
+          x0.val[1] = vld1q_f32(input_ptr1 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+
+          x0.val[0] = vld1q_f32(input_ptr2);
+          x0.val[1] = vld1q_f32(input_ptr2 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+          y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
+          y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
+          vst1q_f32(output_ptr0, y0.val[0]);
+          vst1_f32(output_ptr0 + 4, vget_low_f32(y0.val[1]));
+
+          input_ptr0 += 6;
+          input_ptr1 += 6;
+          input_ptr2 += 6;
+          output_ptr0 += 6;
+        }
+        // remain width
+        if (output_w_remain > 0) {
+          x0.val[0] = vld1q_f32(input_ptr0);
+          x0.val[1] = vld1q_f32(input_ptr0 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+
+          x0.val[0] = vld1q_f32(input_ptr1);
+          x0.val[1] = vld1q_f32(input_ptr1 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+
+          x0.val[0] = vld1q_f32(input_ptr2);
+          x0.val[1] = vld1q_f32(input_ptr2 + 4);
+          x1.val[0] = vextq_f32(x0.val[0], x0.val[1], 1);
+          x1.val[1] = vextq_f32(x0.val[1], x0.val[1], 1);
+          x2.val[0] = vextq_f32(x0.val[0], x0.val[1], 2);
+          x2.val[1] = vextq_f32(x0.val[1], x0.val[1], 2);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x1.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+          y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
+          y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
+          // restore
+          switch (output_w_remain) {
+            case 1:
+              vst1q_lane_f32(output_ptr0, y0.val[0], 0);
+              break;
+            case 2:
+              vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
+              break;
+            case 3:
+              vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
+              vst1q_lane_f32(output_ptr0 + 2, y0.val[0], 2);
+              break;
+            case 4:
+              vst1q_f32(output_ptr0, y0.val[0]);
+              break;
+            case 5:
+              vst1q_f32(output_ptr0, y0.val[0]);
+              vst1q_lane_f32(output_ptr0 + 4, y0.val[1], 0);
+              break;
           }
-          // pad right
-          if (padding_w) {
-            float32x2_t row0 = vld1_f32(input_ptr0);
-            float32x2_t row1 = vld1_f32(input_ptr1);
-            float32x2_t row2 = vld1_f32(input_ptr2);
-            float32x2_t pad0 = vPoolInit_f32<P>();
-            float32x2_t acc0, post;
-            for (int w = valid_w_end; w < output_w; ++w) {
-              int padding = w + 3 - (padding_w + input_w);
-              if (padding >= 3) {
-                *output_ptr0 = 0.f;
-              } else {
-                post = vdup_n_f32(1.f / (3 * (3 - padding)));
-                acc0 = vPoolPre_f32<P>(row0, row1);
-                acc0 = vPoolPre_f32<P>(acc0, row2);
-                acc0 = vpPoolPre_f32<P>(acc0, acc0);
-                acc0 = vPoolPost_f32<P>(acc0, post);
-                vst1_lane_f32(output_ptr0, acc0, 0);
-                row0 = vext_f32(row0, pad0, 1);
-                row1 = vext_f32(row1, pad0, 1);
-                row2 = vext_f32(row2, pad0, 1);
-              }
-              output_ptr0++;
+          input_ptr0 += output_w_remain;
+          input_ptr1 += output_w_remain;
+          input_ptr2 += output_w_remain;
+          output_ptr0 += output_w_remain;
+        }
+        // pad right
+        if (padding_w) {
+          float32x2_t row0 = vld1_f32(input_ptr0);
+          float32x2_t row1 = vld1_f32(input_ptr1);
+          float32x2_t row2 = vld1_f32(input_ptr2);
+          float32x2_t pad0 = vPoolInit_f32<P>();
+          float32x2_t acc0, post;
+          for (int w = valid_w_end; w < output_w; ++w) {
+            int padding = w + 3 - (padding_w + input_w);
+            if (padding >= 3) {
+              *output_ptr0 = 0.f;
+            } else {
+              post = vdup_n_f32(1.f / (3 * (3 - padding)));
+              acc0 = vPoolPre_f32<P>(row0, row1);
+              acc0 = vPoolPre_f32<P>(acc0, row2);
+              acc0 = vpPoolPre_f32<P>(acc0, acc0);
+              acc0 = vPoolPost_f32<P>(acc0, post);
+              vst1_lane_f32(output_ptr0, acc0, 0);
+              row0 = vext_f32(row0, pad0, 1);
+              row1 = vext_f32(row1, pad0, 1);
+              row2 = vext_f32(row2, pad0, 1);
             }
+            output_ptr0++;
           }
         }
-        // pad bottom
-        for (int h = valid_h_end; h < output_h; ++h) {
-          Pooling3x3NormalRow<P, 1>(input_ptr, h, input_h, input_w, padding_h,
-                                    padding_w, output_w, output_ptr);
-        }
       }
-    }
+      // pad bottom
+      for (int h = valid_h_end; h < output_h; ++h) {
+        Pooling3x3NormalRow<P, 1>(input_ptr, h, input_h, input_w, padding_h,
+                                  padding_w, output_w, output_ptr);
+      }
+    });
   }
 };
 
@@ -775,522 +775,521 @@ struct Pooling3x3<P, 2> {
     // for pad left
     int valid_input_w_start = (valid_w_start << 1) - padding_w;
 
-    #pragma omp parallel for collapse(2)
-    for (int batch = 0; batch < output->dims()[0]; ++batch) {
-      for (int c = 0; c < output->dims()[1]; ++c) {
-        int channel = batch * output->dims()[1] + c;
-        const float *input_ptr = input_data + channel * image_size;
-        float *output_ptr = output_data + channel * out_image_size;
-        // top
-        for (int h = 0; h < valid_h_start; ++h) {
-          Pooling3x3NormalRow<P, 2>(input_ptr, h, input_h, input_w, padding_h,
-                                    padding_w, output_w, output_ptr);
-        }
-        // valid
-        int output_w_tiles = valid_w / 6;
-        int output_w_remain = valid_w - output_w_tiles * 6;
-        for (int h = valid_h_start; h < valid_h_end - 2; h += 3) {
-          const float *input_ptr0 = input_ptr + (2 * h - padding_h) * input_w;
-          const float *input_ptr1 = input_ptr0 + input_w;
-          const float *input_ptr2 = input_ptr1 + input_w;
-          const float *input_ptr3 = input_ptr2 + input_w;
-          const float *input_ptr4 = input_ptr3 + input_w;
-          const float *input_ptr5 = input_ptr4 + input_w;
-          const float *input_ptr6 = input_ptr5 + input_w;
-          float *output_ptr0 = output_ptr + h * output_w;
-          float *output_ptr1 = output_ptr0 + output_w;
-          float *output_ptr2 = output_ptr1 + output_w;
-          // pad left
-          if (padding_w) {
-            float32x2_t row0 = vld1_f32(input_ptr0);
-            float32x2_t row1 = vld1_f32(input_ptr1);
-            float32x2_t row2 = vld1_f32(input_ptr2);
-            float32x2_t row3 = vld1_f32(input_ptr3);
-            float32x2_t row4 = vld1_f32(input_ptr4);
-            float32x2_t row5 = vld1_f32(input_ptr5);
-            float32x2_t row6 = vld1_f32(input_ptr6);
-            float32x2_t pad0 = vPoolInit_f32<P>();
-            float32x2_t acc0, acc1, acc2, post;
-            for (int w = valid_w_start - 1; w >= 0; --w) {
-              int padding = padding_w - (w << 1);
-              if (padding >= 3) {
-                output_ptr0[w] = 0.f;
-                output_ptr1[w] = 0.f;
-                output_ptr2[w] = 0.f;
-              } else {
-                post = vdup_n_f32(1.f / (3 * (3 - padding)));
-                acc0 = vPoolPre_f32<P>(row0, row1);
-                acc1 = vPoolPre_f32<P>(row2, row3);
-                acc2 = vPoolPre_f32<P>(row4, row5);
-                acc0 = vPoolPre_f32<P>(acc0, row2);
-                acc1 = vPoolPre_f32<P>(acc1, row4);
-                acc2 = vPoolPre_f32<P>(acc2, row6);
-                if (padding == 1) {
-                  acc0 = vpPoolPre_f32<P>(acc0, acc0);
-                  acc1 = vpPoolPre_f32<P>(acc1, acc1);
-                  acc2 = vpPoolPre_f32<P>(acc2, acc2);
-                }
-                acc0 = vPoolPost_f32<P>(acc0, post);
-                acc1 = vPoolPost_f32<P>(acc1, post);
-                acc2 = vPoolPost_f32<P>(acc2, post);
-                vst1_lane_f32(output_ptr0 + w, acc0, 0);
-                vst1_lane_f32(output_ptr1 + w, acc1, 0);
-                vst1_lane_f32(output_ptr2 + w, acc2, 0);
+    parallel_for(0, output->dims()[0] * output->dims()[1], [&](int index) {
+      int batch = index / output->dims()[1];
+      int c = index % output->dims()[1];
+      int channel = batch * output->dims()[1] + c;
+      const float *input_ptr = input_data + channel * image_size;
+      float *output_ptr = output_data + channel * out_image_size;
+      // top
+      for (int h = 0; h < valid_h_start; ++h) {
+        Pooling3x3NormalRow<P, 2>(input_ptr, h, input_h, input_w, padding_h,
+                                  padding_w, output_w, output_ptr);
+      }
+      // valid
+      int output_w_tiles = valid_w / 6;
+      int output_w_remain = valid_w - output_w_tiles * 6;
+      for (int h = valid_h_start; h < valid_h_end - 2; h += 3) {
+        const float *input_ptr0 = input_ptr + (2 * h - padding_h) * input_w;
+        const float *input_ptr1 = input_ptr0 + input_w;
+        const float *input_ptr2 = input_ptr1 + input_w;
+        const float *input_ptr3 = input_ptr2 + input_w;
+        const float *input_ptr4 = input_ptr3 + input_w;
+        const float *input_ptr5 = input_ptr4 + input_w;
+        const float *input_ptr6 = input_ptr5 + input_w;
+        float *output_ptr0 = output_ptr + h * output_w;
+        float *output_ptr1 = output_ptr0 + output_w;
+        float *output_ptr2 = output_ptr1 + output_w;
+        // pad left
+        if (padding_w) {
+          float32x2_t row0 = vld1_f32(input_ptr0);
+          float32x2_t row1 = vld1_f32(input_ptr1);
+          float32x2_t row2 = vld1_f32(input_ptr2);
+          float32x2_t row3 = vld1_f32(input_ptr3);
+          float32x2_t row4 = vld1_f32(input_ptr4);
+          float32x2_t row5 = vld1_f32(input_ptr5);
+          float32x2_t row6 = vld1_f32(input_ptr6);
+          float32x2_t pad0 = vPoolInit_f32<P>();
+          float32x2_t acc0, acc1, acc2, post;
+          for (int w = valid_w_start - 1; w >= 0; --w) {
+            int padding = padding_w - (w << 1);
+            if (padding >= 3) {
+              output_ptr0[w] = 0.f;
+              output_ptr1[w] = 0.f;
+              output_ptr2[w] = 0.f;
+            } else {
+              post = vdup_n_f32(1.f / (3 * (3 - padding)));
+              acc0 = vPoolPre_f32<P>(row0, row1);
+              acc1 = vPoolPre_f32<P>(row2, row3);
+              acc2 = vPoolPre_f32<P>(row4, row5);
+              acc0 = vPoolPre_f32<P>(acc0, row2);
+              acc1 = vPoolPre_f32<P>(acc1, row4);
+              acc2 = vPoolPre_f32<P>(acc2, row6);
+              if (padding == 1) {
+                acc0 = vpPoolPre_f32<P>(acc0, acc0);
+                acc1 = vpPoolPre_f32<P>(acc1, acc1);
+                acc2 = vpPoolPre_f32<P>(acc2, acc2);
               }
+              acc0 = vPoolPost_f32<P>(acc0, post);
+              acc1 = vPoolPost_f32<P>(acc1, post);
+              acc2 = vPoolPost_f32<P>(acc2, post);
+              vst1_lane_f32(output_ptr0 + w, acc0, 0);
+              vst1_lane_f32(output_ptr1 + w, acc1, 0);
+              vst1_lane_f32(output_ptr2 + w, acc2, 0);
             }
-            input_ptr0 += valid_input_w_start;
-            input_ptr1 += valid_input_w_start;
-            input_ptr2 += valid_input_w_start;
-            input_ptr3 += valid_input_w_start;
-            input_ptr4 += valid_input_w_start;
-            input_ptr5 += valid_input_w_start;
-            input_ptr6 += valid_input_w_start;
-            output_ptr0 += valid_w_start;
-            output_ptr1 += valid_w_start;
-            output_ptr2 += valid_w_start;
           }
-          // valid
-          float32x4x2_t x0, x1, x2;
-          float32x4x2_t y0, y1, y2;
-          float32x4_t post = vdupq_n_f32(1.f / 9);
-          for (int loop = 0; loop < output_w_tiles; ++loop) {
-            x0 = vld2q_f32(input_ptr0);
-            x1 = vld2q_f32(input_ptr0 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-
-            x0 = vld2q_f32(input_ptr1);
-            x1 = vld2q_f32(input_ptr1 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-
-            x0 = vld2q_f32(input_ptr2);
-            x1 = vld2q_f32(input_ptr2 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(y1.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(y1.val[1], y0.val[1]);
-            y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
-            y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
-            vst1q_f32(output_ptr0, y0.val[0]);
-            vst1_f32(output_ptr0 + 4, vget_low_f32(y0.val[1]));
-
-            x0 = vld2q_f32(input_ptr3);
-            x1 = vld2q_f32(input_ptr3 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(x0.val[0], y1.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(x0.val[1], y1.val[1]);
-
-            x0 = vld2q_f32(input_ptr4);
-            x1 = vld2q_f32(input_ptr4 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(y0.val[0], y1.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(y0.val[1], y1.val[1]);
-            y1.val[0] = vPoolPostq_f32<P>(y1.val[0], post);
-            y1.val[1] = vPoolPostq_f32<P>(y1.val[1], post);
-            vst1q_f32(output_ptr1, y1.val[0]);
-            vst1_f32(output_ptr1 + 4, vget_low_f32(y1.val[1]));
-
-            x0 = vld2q_f32(input_ptr5);
-            x1 = vld2q_f32(input_ptr5 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-
-            x0 = vld2q_f32(input_ptr6);
-            x1 = vld2q_f32(input_ptr6 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-            y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
-            y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
-            vst1q_f32(output_ptr2, y0.val[0]);
-            vst1_f32(output_ptr2 + 4, vget_low_f32(y0.val[1]));
-
-            input_ptr0 += 12;
-            input_ptr1 += 12;
-            input_ptr2 += 12;
-            input_ptr3 += 12;
-            input_ptr4 += 12;
-            input_ptr5 += 12;
-            input_ptr6 += 12;
-            output_ptr0 += 6;
-            output_ptr1 += 6;
-            output_ptr2 += 6;
-          }
-          // remain width
-          if (output_w_remain > 0) {
-            x0 = vld2q_f32(input_ptr0);
-            x1 = vld2q_f32(input_ptr0 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-
-            x0 = vld2q_f32(input_ptr1);
-            x1 = vld2q_f32(input_ptr1 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-
-            x0 = vld2q_f32(input_ptr2);
-            x1 = vld2q_f32(input_ptr2 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(y1.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(y1.val[1], y0.val[1]);
-            y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
-            y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
-
-            x0 = vld2q_f32(input_ptr3);
-            x1 = vld2q_f32(input_ptr3 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(x0.val[0], y1.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(x0.val[1], y1.val[1]);
-
-            x0 = vld2q_f32(input_ptr4);
-            x1 = vld2q_f32(input_ptr4 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            y2.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y2.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y1.val[0] = vPoolPreq_f32<P>(y2.val[0], y1.val[0]);
-            y1.val[1] = vPoolPreq_f32<P>(y2.val[1], y1.val[1]);
-            y1.val[0] = vPoolPostq_f32<P>(y1.val[0], post);
-            y1.val[1] = vPoolPostq_f32<P>(y1.val[1], post);
-
-            x0 = vld2q_f32(input_ptr5);
-            x1 = vld2q_f32(input_ptr5 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y2.val[0] = vPoolPreq_f32<P>(x0.val[0], y2.val[0]);
-            y2.val[1] = vPoolPreq_f32<P>(x0.val[1], y2.val[1]);
-
-            x0 = vld2q_f32(input_ptr6);
-            x1 = vld2q_f32(input_ptr6 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y2.val[0] = vPoolPreq_f32<P>(x0.val[0], y2.val[0]);
-            y2.val[1] = vPoolPreq_f32<P>(x0.val[1], y2.val[1]);
-            y2.val[0] = vPoolPostq_f32<P>(y2.val[0], post);
-            y2.val[1] = vPoolPostq_f32<P>(y2.val[1], post);
-
-            switch (output_w_remain) {
-              case 1:
-                vst1q_lane_f32(output_ptr0, y0.val[0], 0);
-                vst1q_lane_f32(output_ptr1, y1.val[0], 0);
-                vst1q_lane_f32(output_ptr2, y2.val[0], 0);
-                break;
-              case 2:
-                vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
-                vst1_f32(output_ptr1, vget_low_f32(y1.val[0]));
-                vst1_f32(output_ptr2, vget_low_f32(y2.val[0]));
-                break;
-              case 3:
-                vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
-                vst1_f32(output_ptr1, vget_low_f32(y1.val[0]));
-                vst1_f32(output_ptr2, vget_low_f32(y2.val[0]));
-                vst1q_lane_f32(output_ptr0 + 2, y0.val[0], 2);
-                vst1q_lane_f32(output_ptr1 + 2, y1.val[0], 2);
-                vst1q_lane_f32(output_ptr2 + 2, y2.val[0], 2);
-                break;
-              case 4:
-                vst1q_f32(output_ptr0, y0.val[0]);
-                vst1q_f32(output_ptr1, y1.val[0]);
-                vst1q_f32(output_ptr2, y2.val[0]);
-                break;
-              case 5:
-                vst1q_f32(output_ptr0, y0.val[0]);
-                vst1q_f32(output_ptr1, y1.val[0]);
-                vst1q_f32(output_ptr2, y2.val[0]);
-                vst1q_lane_f32(output_ptr0 + 4, y0.val[1], 0);
-                vst1q_lane_f32(output_ptr1 + 4, y1.val[1], 0);
-                vst1q_lane_f32(output_ptr2 + 4, y2.val[1], 0);
-                break;
-            }
-            input_ptr0 += (output_w_remain << 1);
-            input_ptr1 += (output_w_remain << 1);
-            input_ptr2 += (output_w_remain << 1);
-            input_ptr3 += (output_w_remain << 1);
-            input_ptr4 += (output_w_remain << 1);
-            input_ptr5 += (output_w_remain << 1);
-            input_ptr6 += (output_w_remain << 1);
-            output_ptr0 += output_w_remain;
-            output_ptr1 += output_w_remain;
-            output_ptr2 += output_w_remain;
+          input_ptr0 += valid_input_w_start;
+          input_ptr1 += valid_input_w_start;
+          input_ptr2 += valid_input_w_start;
+          input_ptr3 += valid_input_w_start;
+          input_ptr4 += valid_input_w_start;
+          input_ptr5 += valid_input_w_start;
+          input_ptr6 += valid_input_w_start;
+          output_ptr0 += valid_w_start;
+          output_ptr1 += valid_w_start;
+          output_ptr2 += valid_w_start;
+        }
+        // valid
+        float32x4x2_t x0, x1, x2;
+        float32x4x2_t y0, y1, y2;
+        float32x4_t post = vdupq_n_f32(1.f / 9);
+        for (int loop = 0; loop < output_w_tiles; ++loop) {
+          x0 = vld2q_f32(input_ptr0);
+          x1 = vld2q_f32(input_ptr0 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+
+          x0 = vld2q_f32(input_ptr1);
+          x1 = vld2q_f32(input_ptr1 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+
+          x0 = vld2q_f32(input_ptr2);
+          x1 = vld2q_f32(input_ptr2 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(y1.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(y1.val[1], y0.val[1]);
+          y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
+          y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
+          vst1q_f32(output_ptr0, y0.val[0]);
+          vst1_f32(output_ptr0 + 4, vget_low_f32(y0.val[1]));
+
+          x0 = vld2q_f32(input_ptr3);
+          x1 = vld2q_f32(input_ptr3 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(x0.val[0], y1.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(x0.val[1], y1.val[1]);
+
+          x0 = vld2q_f32(input_ptr4);
+          x1 = vld2q_f32(input_ptr4 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(y0.val[0], y1.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(y0.val[1], y1.val[1]);
+          y1.val[0] = vPoolPostq_f32<P>(y1.val[0], post);
+          y1.val[1] = vPoolPostq_f32<P>(y1.val[1], post);
+          vst1q_f32(output_ptr1, y1.val[0]);
+          vst1_f32(output_ptr1 + 4, vget_low_f32(y1.val[1]));
+
+          x0 = vld2q_f32(input_ptr5);
+          x1 = vld2q_f32(input_ptr5 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+
+          x0 = vld2q_f32(input_ptr6);
+          x1 = vld2q_f32(input_ptr6 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+          y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
+          y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
+          vst1q_f32(output_ptr2, y0.val[0]);
+          vst1_f32(output_ptr2 + 4, vget_low_f32(y0.val[1]));
+
+          input_ptr0 += 12;
+          input_ptr1 += 12;
+          input_ptr2 += 12;
+          input_ptr3 += 12;
+          input_ptr4 += 12;
+          input_ptr5 += 12;
+          input_ptr6 += 12;
+          output_ptr0 += 6;
+          output_ptr1 += 6;
+          output_ptr2 += 6;
+        }
+        // remain width
+        if (output_w_remain > 0) {
+          x0 = vld2q_f32(input_ptr0);
+          x1 = vld2q_f32(input_ptr0 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+
+          x0 = vld2q_f32(input_ptr1);
+          x1 = vld2q_f32(input_ptr1 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+
+          x0 = vld2q_f32(input_ptr2);
+          x1 = vld2q_f32(input_ptr2 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(y1.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(y1.val[1], y0.val[1]);
+          y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
+          y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
+
+          x0 = vld2q_f32(input_ptr3);
+          x1 = vld2q_f32(input_ptr3 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(x0.val[0], y1.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(x0.val[1], y1.val[1]);
+
+          x0 = vld2q_f32(input_ptr4);
+          x1 = vld2q_f32(input_ptr4 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          y2.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y2.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y1.val[0] = vPoolPreq_f32<P>(y2.val[0], y1.val[0]);
+          y1.val[1] = vPoolPreq_f32<P>(y2.val[1], y1.val[1]);
+          y1.val[0] = vPoolPostq_f32<P>(y1.val[0], post);
+          y1.val[1] = vPoolPostq_f32<P>(y1.val[1], post);
+
+          x0 = vld2q_f32(input_ptr5);
+          x1 = vld2q_f32(input_ptr5 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y2.val[0] = vPoolPreq_f32<P>(x0.val[0], y2.val[0]);
+          y2.val[1] = vPoolPreq_f32<P>(x0.val[1], y2.val[1]);
+
+          x0 = vld2q_f32(input_ptr6);
+          x1 = vld2q_f32(input_ptr6 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y2.val[0] = vPoolPreq_f32<P>(x0.val[0], y2.val[0]);
+          y2.val[1] = vPoolPreq_f32<P>(x0.val[1], y2.val[1]);
+          y2.val[0] = vPoolPostq_f32<P>(y2.val[0], post);
+          y2.val[1] = vPoolPostq_f32<P>(y2.val[1], post);
+
+          switch (output_w_remain) {
+            case 1:
+              vst1q_lane_f32(output_ptr0, y0.val[0], 0);
+              vst1q_lane_f32(output_ptr1, y1.val[0], 0);
+              vst1q_lane_f32(output_ptr2, y2.val[0], 0);
+              break;
+            case 2:
+              vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
+              vst1_f32(output_ptr1, vget_low_f32(y1.val[0]));
+              vst1_f32(output_ptr2, vget_low_f32(y2.val[0]));
+              break;
+            case 3:
+              vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
+              vst1_f32(output_ptr1, vget_low_f32(y1.val[0]));
+              vst1_f32(output_ptr2, vget_low_f32(y2.val[0]));
+              vst1q_lane_f32(output_ptr0 + 2, y0.val[0], 2);
+              vst1q_lane_f32(output_ptr1 + 2, y1.val[0], 2);
+              vst1q_lane_f32(output_ptr2 + 2, y2.val[0], 2);
+              break;
+            case 4:
+              vst1q_f32(output_ptr0, y0.val[0]);
+              vst1q_f32(output_ptr1, y1.val[0]);
+              vst1q_f32(output_ptr2, y2.val[0]);
+              break;
+            case 5:
+              vst1q_f32(output_ptr0, y0.val[0]);
+              vst1q_f32(output_ptr1, y1.val[0]);
+              vst1q_f32(output_ptr2, y2.val[0]);
+              vst1q_lane_f32(output_ptr0 + 4, y0.val[1], 0);
+              vst1q_lane_f32(output_ptr1 + 4, y1.val[1], 0);
+              vst1q_lane_f32(output_ptr2 + 4, y2.val[1], 0);
+              break;
           }
-          // pad right
-          if (padding_r > 0) {
-            float32x2_t row0 = vld1_f32(input_ptr0);
-            float32x2_t row1 = vld1_f32(input_ptr1);
-            float32x2_t row2 = vld1_f32(input_ptr2);
-            float32x2_t row3 = vld1_f32(input_ptr3);
-            float32x2_t row4 = vld1_f32(input_ptr4);
-            float32x2_t row5 = vld1_f32(input_ptr5);
-            float32x2_t row6 = vld1_f32(input_ptr6);
-            float32x2_t pad0 = vPoolInit_f32<P>();
-            float32x2_t acc0, acc1, acc2, post;
-            for (int w = valid_w_end; w < output_w; ++w) {
-              int padding = 2 * w + 3 - (padding_w + input_w);
-              if (padding >= 3) {
-                *output_ptr0 = 0.f;
-                *output_ptr1 = 0.f;
-                *output_ptr2 = 0.f;
-              } else {
-                post = vdup_n_f32(1.f / (3 * (3 - padding)));
-                acc0 = vPoolPre_f32<P>(row0, row1);
-                acc1 = vPoolPre_f32<P>(row2, row3);
-                acc2 = vPoolPre_f32<P>(row4, row5);
-                acc0 = vPoolPre_f32<P>(acc0, row2);
-                acc1 = vPoolPre_f32<P>(acc1, row4);
-                acc2 = vPoolPre_f32<P>(acc2, row6);
-                if (padding == 1) {
-                  acc0 = vpPoolPre_f32<P>(acc0, acc0);
-                  acc1 = vpPoolPre_f32<P>(acc1, acc1);
-                  acc2 = vpPoolPre_f32<P>(acc2, acc2);
-                }
-                acc0 = vPoolPost_f32<P>(acc0, post);
-                acc1 = vPoolPost_f32<P>(acc1, post);
-                acc2 = vPoolPost_f32<P>(acc2, post);
-                vst1_lane_f32(output_ptr0, acc0, 0);
-                vst1_lane_f32(output_ptr1, acc1, 0);
-                vst1_lane_f32(output_ptr2, acc2, 0);
+          input_ptr0 += (output_w_remain << 1);
+          input_ptr1 += (output_w_remain << 1);
+          input_ptr2 += (output_w_remain << 1);
+          input_ptr3 += (output_w_remain << 1);
+          input_ptr4 += (output_w_remain << 1);
+          input_ptr5 += (output_w_remain << 1);
+          input_ptr6 += (output_w_remain << 1);
+          output_ptr0 += output_w_remain;
+          output_ptr1 += output_w_remain;
+          output_ptr2 += output_w_remain;
+        }
+        // pad right
+        if (padding_r > 0) {
+          float32x2_t row0 = vld1_f32(input_ptr0);
+          float32x2_t row1 = vld1_f32(input_ptr1);
+          float32x2_t row2 = vld1_f32(input_ptr2);
+          float32x2_t row3 = vld1_f32(input_ptr3);
+          float32x2_t row4 = vld1_f32(input_ptr4);
+          float32x2_t row5 = vld1_f32(input_ptr5);
+          float32x2_t row6 = vld1_f32(input_ptr6);
+          float32x2_t pad0 = vPoolInit_f32<P>();
+          float32x2_t acc0, acc1, acc2, post;
+          for (int w = valid_w_end; w < output_w; ++w) {
+            int padding = 2 * w + 3 - (padding_w + input_w);
+            if (padding >= 3) {
+              *output_ptr0 = 0.f;
+              *output_ptr1 = 0.f;
+              *output_ptr2 = 0.f;
+            } else {
+              post = vdup_n_f32(1.f / (3 * (3 - padding)));
+              acc0 = vPoolPre_f32<P>(row0, row1);
+              acc1 = vPoolPre_f32<P>(row2, row3);
+              acc2 = vPoolPre_f32<P>(row4, row5);
+              acc0 = vPoolPre_f32<P>(acc0, row2);
+              acc1 = vPoolPre_f32<P>(acc1, row4);
+              acc2 = vPoolPre_f32<P>(acc2, row6);
+              if (padding == 1) {
+                acc0 = vpPoolPre_f32<P>(acc0, acc0);
+                acc1 = vpPoolPre_f32<P>(acc1, acc1);
+                acc2 = vpPoolPre_f32<P>(acc2, acc2);
               }
-              output_ptr0++;
-              output_ptr1++;
-              output_ptr2++;
+              acc0 = vPoolPost_f32<P>(acc0, post);
+              acc1 = vPoolPost_f32<P>(acc1, post);
+              acc2 = vPoolPost_f32<P>(acc2, post);
+              vst1_lane_f32(output_ptr0, acc0, 0);
+              vst1_lane_f32(output_ptr1, acc1, 0);
+              vst1_lane_f32(output_ptr2, acc2, 0);
             }
+            output_ptr0++;
+            output_ptr1++;
+            output_ptr2++;
           }
         }
-        // remain height
-        int start_h = valid_h_start + valid_h / 3 * 3;
-        for (int h = start_h; h < valid_h_end; ++h) {
-          const float *input_ptr0 = input_ptr + (2 * h - padding_h) * input_w;
-          const float *input_ptr1 = input_ptr0 + input_w;
-          const float *input_ptr2 = input_ptr1 + input_w;
-          float *output_ptr0 = output_ptr + h * output_w;
-          // pad left
-          if (padding_w) {
-            float32x2_t row0 = vld1_f32(input_ptr0);
-            float32x2_t row1 = vld1_f32(input_ptr1);
-            float32x2_t row2 = vld1_f32(input_ptr2);
-            float32x2_t pad0 = vPoolInit_f32<P>();
-            float32x2_t acc0, post;
-            for (int w = valid_w_start - 1; w >= 0; --w) {
-              int padding = padding_w - (w << 1);
-              if (padding >= 3) {
-                output_ptr0[w] = 0.f;
-              } else {
-                post = vdup_n_f32(1.f / (3 * (3 - padding)));
-                acc0 = vPoolPre_f32<P>(row0, row1);
-                acc0 = vPoolPre_f32<P>(acc0, row2);
-                if (padding == 1) {
-                  acc0 = vpPoolPre_f32<P>(acc0, acc0);
-                }
-                acc0 = vPoolPost_f32<P>(acc0, post);
-                vst1_lane_f32(output_ptr0 + w, acc0, 0);
+      }
+      // remain height
+      int start_h = valid_h_start + valid_h / 3 * 3;
+      for (int h = start_h; h < valid_h_end; ++h) {
+        const float *input_ptr0 = input_ptr + (2 * h - padding_h) * input_w;
+        const float *input_ptr1 = input_ptr0 + input_w;
+        const float *input_ptr2 = input_ptr1 + input_w;
+        float *output_ptr0 = output_ptr + h * output_w;
+        // pad left
+        if (padding_w) {
+          float32x2_t row0 = vld1_f32(input_ptr0);
+          float32x2_t row1 = vld1_f32(input_ptr1);
+          float32x2_t row2 = vld1_f32(input_ptr2);
+          float32x2_t pad0 = vPoolInit_f32<P>();
+          float32x2_t acc0, post;
+          for (int w = valid_w_start - 1; w >= 0; --w) {
+            int padding = padding_w - (w << 1);
+            if (padding >= 3) {
+              output_ptr0[w] = 0.f;
+            } else {
+              post = vdup_n_f32(1.f / (3 * (3 - padding)));
+              acc0 = vPoolPre_f32<P>(row0, row1);
+              acc0 = vPoolPre_f32<P>(acc0, row2);
+              if (padding == 1) {
+                acc0 = vpPoolPre_f32<P>(acc0, acc0);
               }
+              acc0 = vPoolPost_f32<P>(acc0, post);
+              vst1_lane_f32(output_ptr0 + w, acc0, 0);
             }
-            input_ptr0 += valid_input_w_start;
-            input_ptr1 += valid_input_w_start;
-            input_ptr2 += valid_input_w_start;
-            output_ptr0 += valid_w_start;
           }
-          // valid
-          float32x4x2_t x0, x1, x2, y0;
-          float32x4_t post = vdupq_n_f32(1.f / 9);
-          for (int loop = 0; loop < output_w_tiles; ++loop) {
-            x0 = vld2q_f32(input_ptr0);
-            x1 = vld2q_f32(input_ptr0 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-
-            x0 = vld2q_f32(input_ptr1);
-            x1 = vld2q_f32(input_ptr1 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-
-            x0 = vld2q_f32(input_ptr2);
-            x1 = vld2q_f32(input_ptr2 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-            y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
-            y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
-            vst1q_f32(output_ptr0, y0.val[0]);
-            vst1_f32(output_ptr0 + 4, vget_low_f32(y0.val[1]));
-
-            input_ptr0 += 12;
-            input_ptr1 += 12;
-            input_ptr2 += 12;
-            output_ptr0 += 6;
-          }
-          // remain width
-          if (output_w_remain > 0) {
-            x0 = vld2q_f32(input_ptr0);
-            x1 = vld2q_f32(input_ptr0 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-
-            x0 = vld2q_f32(input_ptr1);
-            x1 = vld2q_f32(input_ptr1 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-
-            x0 = vld2q_f32(input_ptr2);
-            x1 = vld2q_f32(input_ptr2 + 8);
-            x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
-            x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
-            x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
-            x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
-            x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
-            y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
-            y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
-            y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
-            y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
-            // restore
-            switch (output_w_remain) {
-              case 1:
-                vst1q_lane_f32(output_ptr0, y0.val[0], 0);
-                break;
-              case 2:
-                vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
-                break;
-              case 3:
-                vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
-                vst1q_lane_f32(output_ptr0 + 2, y0.val[0], 2);
-                break;
-              case 4:
-                vst1q_f32(output_ptr0, y0.val[0]);
-                break;
-              case 5:
-                vst1q_f32(output_ptr0, y0.val[0]);
-                vst1q_lane_f32(output_ptr0 + 4, y0.val[1], 0);
-                break;
-            }
-            input_ptr0 += (output_w_remain << 1);
-            input_ptr1 += (output_w_remain << 1);
-            input_ptr2 += (output_w_remain << 1);
-            output_ptr0 += output_w_remain;
+          input_ptr0 += valid_input_w_start;
+          input_ptr1 += valid_input_w_start;
+          input_ptr2 += valid_input_w_start;
+          output_ptr0 += valid_w_start;
+        }
+        // valid
+        float32x4x2_t x0, x1, x2, y0;
+        float32x4_t post = vdupq_n_f32(1.f / 9);
+        for (int loop = 0; loop < output_w_tiles; ++loop) {
+          x0 = vld2q_f32(input_ptr0);
+          x1 = vld2q_f32(input_ptr0 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+
+          x0 = vld2q_f32(input_ptr1);
+          x1 = vld2q_f32(input_ptr1 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+
+          x0 = vld2q_f32(input_ptr2);
+          x1 = vld2q_f32(input_ptr2 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+          y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
+          y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
+          vst1q_f32(output_ptr0, y0.val[0]);
+          vst1_f32(output_ptr0 + 4, vget_low_f32(y0.val[1]));
+
+          input_ptr0 += 12;
+          input_ptr1 += 12;
+          input_ptr2 += 12;
+          output_ptr0 += 6;
+        }
+        // remain width
+        if (output_w_remain > 0) {
+          x0 = vld2q_f32(input_ptr0);
+          x1 = vld2q_f32(input_ptr0 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+
+          x0 = vld2q_f32(input_ptr1);
+          x1 = vld2q_f32(input_ptr1 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+
+          x0 = vld2q_f32(input_ptr2);
+          x1 = vld2q_f32(input_ptr2 + 8);
+          x2.val[0] = vextq_f32(x0.val[0], x1.val[0], 1);
+          x2.val[1] = vextq_f32(x1.val[0], x1.val[0], 1);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x0.val[1]);
+          x0.val[1] = vPoolPreq_f32<P>(x1.val[0], x1.val[1]);
+          x0.val[0] = vPoolPreq_f32<P>(x0.val[0], x2.val[0]);
+          x0.val[1] = vPoolPreq_f32<P>(x0.val[1], x2.val[1]);
+          y0.val[0] = vPoolPreq_f32<P>(x0.val[0], y0.val[0]);
+          y0.val[1] = vPoolPreq_f32<P>(x0.val[1], y0.val[1]);
+          y0.val[0] = vPoolPostq_f32<P>(y0.val[0], post);
+          y0.val[1] = vPoolPostq_f32<P>(y0.val[1], post);
+          // restore
+          switch (output_w_remain) {
+            case 1:
+              vst1q_lane_f32(output_ptr0, y0.val[0], 0);
+              break;
+            case 2:
+              vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
+              break;
+            case 3:
+              vst1_f32(output_ptr0, vget_low_f32(y0.val[0]));
+              vst1q_lane_f32(output_ptr0 + 2, y0.val[0], 2);
+              break;
+            case 4:
+              vst1q_f32(output_ptr0, y0.val[0]);
+              break;
+            case 5:
+              vst1q_f32(output_ptr0, y0.val[0]);
+              vst1q_lane_f32(output_ptr0 + 4, y0.val[1], 0);
+              break;
           }
-          // pad right
-          if (padding_r > 0) {
-            float32x2_t row0 = vld1_f32(input_ptr0);
-            float32x2_t row1 = vld1_f32(input_ptr1);
-            float32x2_t row2 = vld1_f32(input_ptr2);
-            float32x2_t pad0 = vPoolInit_f32<P>();
-            float32x2_t acc0, post;
-            for (int w = valid_w_end; w < output_w; ++w) {
-              int padding = 2 * w + 3 - (padding_w + input_w);
-              if (padding >= 3) {
-                *output_ptr0 = 0.f;
-              } else {
-                post = vdup_n_f32(1.f / (3 * (3 - padding)));
-                acc0 = vPoolPre_f32<P>(row0, row1);
-                acc0 = vPoolPre_f32<P>(acc0, row2);
-                if (padding == 1) {
-                  acc0 = vpPoolPre_f32<P>(acc0, acc0);
-                }
-                acc0 = vPoolPost_f32<P>(acc0, post);
-                vst1_lane_f32(output_ptr0, acc0, 0);
+          input_ptr0 += (output_w_remain << 1);
+          input_ptr1 += (output_w_remain << 1);
+          input_ptr2 += (output_w_remain << 1);
+          output_ptr0 += output_w_remain;
+        }
+        // pad right
+        if (padding_r > 0) {
+          float32x2_t row0 = vld1_f32(input_ptr0);
+          float32x2_t row1 = vld1_f32(input_ptr1);
+          float32x2_t row2 = vld1_f32(input_ptr2);
+          float32x2_t pad0 = vPoolInit_f32<P>();
+          float32x2_t acc0, post;
+          for (int w = valid_w_end; w < output_w; ++w) {
+            int padding = 2 * w + 3 - (padding_w + input_w);
+            if (padding >= 3) {
+              *output_ptr0 = 0.f;
+            } else {
+              post = vdup_n_f32(1.f / (3 * (3 - padding)));
+              acc0 = vPoolPre_f32<P>(row0, row1);
+              acc0 = vPoolPre_f32<P>(acc0, row2);
+              if (padding == 1) {
+                acc0 = vpPoolPre_f32<P>(acc0, acc0);
               }
-              output_ptr0++;
+              acc0 = vPoolPost_f32<P>(acc0, post);
+              vst1_lane_f32(output_ptr0, acc0, 0);
             }
+            output_ptr0++;
           }
         }
-        // bottom
-        for (int h = valid_h_end; h < output_h; ++h) {
-          Pooling3x3NormalRow<P, 2>(input_ptr, h, input_h, input_w, padding_h,
-                                    padding_w, output_w, output_ptr);
-        }
       }
-    }
+      // bottom
+      for (int h = valid_h_end; h < output_h; ++h) {
+        Pooling3x3NormalRow<P, 2>(input_ptr, h, input_h, input_w, padding_h,
+                                  padding_w, output_w, output_ptr);
+      }
+    });
   }
 };
 
@@ -1303,5 +1302,155 @@ template struct Pooling3x3<AVG, 2>;
 }  // namespace operators
 }  // namespace paddle_mobile
 
+#else
+
+#include <algorithm>
+#include "common/threadpool.h"
+#include "operators/math/math_func_avx.h"
+#include "operators/math/pooling.h"
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+#if defined(__x86_64__) || defined(__i386__)
+template <PoolingType P = MAX>
+AVX2_TARGET inline __m256 vPoolPre256_f32(const __m256 &x1, const __m256 &x2) {
+  return _mm256_max_ps(x1, x2);
+}
+
+template <>
+AVX2_TARGET inline __m256 vPoolPre256_f32<AVG>(const __m256 &x1,
+                                               const __m256 &x2) {
+  return _mm256_add_ps(x1, x2);
+}
+
+// 三行输入都有效时, 窗口完全落在输入内的部分, 每次计算 8 个输出,
+// 返回下一个未计算的位置
+template <PoolingType P, int Stride>
+AVX2_TARGET int Pooling3x3RowAvx2(const float *const rows[3], int padding_w,
+                                  int input_w, int ow, int ow_end,
+                                  float *output) {
+  const __m256 __post = _mm256_set1_ps(1.f / 9);
+  for (; ow + 8 <= ow_end; ow += 8) {
+    const int iw = ow * Stride - padding_w;
+    // 步长为 2 时多读 2 个 float
+    if (Stride == 2 && iw + 18 > input_w) {
+      break;
+    }
+    __m256 y;
+    for (int r = 0; r < 3; ++r) {
+      const float *in = rows[r] + iw;
+      __m256 x0, x1, x2;
+      if (Stride == 1) {
+        x0 = _mm256_loadu_ps(in);
+        x1 = _mm256_loadu_ps(in + 1);
+        x2 = _mm256_loadu_ps(in + 2);
+      } else {
+        __m256 unused;
+        deinterleave256_ps(_mm256_loadu_ps(in), _mm256_loadu_ps(in + 8), &x0,
+                           &x1);
+        deinterleave256_ps(_mm256_loadu_ps(in + 2), _mm256_loadu_ps(in + 10),
+                           &x2, &unused);
+      }
+      __m256 v = vPoolPre256_f32<P>(vPoolPre256_f32<P>(x0, x1), x2);
+      y = (r == 0) ? v : vPoolPre256_f32<P>(y, v);
+    }
+    if (P == AVG) {
+      y = _mm256_mul_ps(y, __post);
+    }
+    _mm256_storeu_ps(output + ow, y);
+  }
+  return ow;
+}
+#endif  // __x86_64__
+
+template <PoolingType P, int Stride>
+void Pooling3x3<P, Stride>::operator()(const framework::Tensor &input,
+                                       const std::vector<int> &paddings,
+                                       framework::Tensor *output) {
+  const float *input_data = input.data<float>();
+  float *output_data = output->mutable_data<float>();
+  const int input_h = input.dims()[2];
+  const int input_w = input.dims()[3];
+  const int output_h = output->dims()[2];
+  const int output_w = output->dims()[3];
+  const int padding_h = paddings[0];
+  const int padding_w = paddings[1];
+  // 窗口的列完全落在输入内的输出区间 [valid_w_start, valid_w_end)
+  const int valid_w_start =
+      std::min((padding_w + Stride - 1) / Stride, output_w);
+  const int valid_w_end =
+      input_w + padding_w < 3
+          ? valid_w_start
+          : std::max(std::min((input_w + padding_w - 3) / Stride + 1, output_w),
+                     valid_w_start);
+
+  parallel_for(0, output->dims()[0] * output->dims()[1], [&](int index) {
+    const float *input_ptr = input_data + index * input_h * input_w;
+    float *output_ptr = output_data + index * output_h * output_w;
+    for (int h = 0; h < output_h; ++h) {
+      const int h_in_start = -padding_h + h * Stride;
+      const int h_start = std::max(h_in_start, 0);
+      const int h_end = std::min(h_in_start + 3, input_h);
+      float *out = output_ptr + h * output_w;
+      auto border = [&](int w) {
+        const int w_in_start = -padding_w + w * Stride;
+        const int w_start = std::max(w_in_start, 0);
+        const int w_end = std::min(w_in_start + 3, input_w);
+        PoolingVal<P> val;
+        for (int h_in = h_start; h_in < h_end; ++h_in) {
+          for (int w_in = w_start; w_in < w_end; ++w_in) {
+            val += input_ptr[h_in * input_w + w_in];
+          }
+        }
+        out[w] = val.Value();
+      };
+      if (h_end - h_start != 3) {
+        for (int w = 0; w < output_w; ++w) {
+          border(w);
+        }
+        continue;
+      }
+      const float *rows[3] = {input_ptr + h_start * input_w,
+                              input_ptr + (h_start + 1) * input_w,
+                              input_ptr + (h_start + 2) * input_w};
+      for (int w = 0; w < valid_w_start; ++w) {
+        border(w);
+      }
+      int w = valid_w_start;
+#if defined(__x86_64__) || defined(__i386__)
+      if (HasAvx2()) {
+        w = Pooling3x3RowAvx2<P, Stride>(rows, padding_w, input_w, w,
+                                         valid_w_end, out);
+      }
+#endif  // __x86_64__
+      for (; w < valid_w_end; ++w) {
+        const int w_in = -padding_w + w * Stride;
+        float val = PoolPre<P>(rows[0][w_in], rows[0][w_in + 1]);
+        val = PoolPre<P>(val, rows[0][w_in + 2]);
+        for (int r = 1; r < 3; ++r) {
+          val = PoolPre<P>(val, rows[r][w_in]);
+          val = PoolPre<P>(val, rows[r][w_in + 1]);
+          val = PoolPre<P>(val, rows[r][w_in + 2]);
+        }
+        out[w] = PoolPost<P>(val, 1.f / 9);
+      }
+      for (w = valid_w_end; w < output_w; ++w) {
+        border(w);
+      }
+    }
+  });
+}
+
+template struct Pooling3x3<MAX, 1>;
+template struct Pooling3x3<AVG, 1>;
+template struct Pooling3x3<MAX, 2>;
+template struct Pooling3x3<AVG, 2>;
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
+
 #endif  // __ARM_NEON
 #endif  // POOL_OP
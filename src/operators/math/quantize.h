@@ -12,8 +12,6 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
-#ifdef QUANT_OP
-
 #pragma once
 
 #include <cmath>
@@ -104,5 +102,3 @@ inline int32x4_t vRoundq_f32<ROUND_NEAREST_TO_EVEN>(const float32x4_t &x) {
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle_mobile
-
-#endif  // QUANT_OP
@@ -18,7 +18,9 @@ limitations under the License. */
 #include <math.h>
 #include <algorithm>
 #include <limits>
+#include "common/threadpool.h"
 #include "common/types.h"
+#include "operators/math/math_func_avx.h"
 #include "operators/math/math_func_neon.h"
 
 namespace paddle_mobile {
@@ -39,6 +41,48 @@ inline float32_t vaddvq_f32(const float32x4_t &r) {
 #endif  // __aarch64__
 #endif  // __ARM_NEON__
 
+#if defined(__x86_64__) || defined(__i386__)
+AVX2_TARGET void SoftmaxAvx2(const float *input, int num_classes, float *y) {
+  int loop = num_classes >> 3;
+  int remain = num_classes & 0x7;
+  // find max
+  __m256 __max = _mm256_set1_ps(-std::numeric_limits<float>::max());
+  for (int i = 0; i < loop; ++i) {
+    __max = _mm256_max_ps(_mm256_loadu_ps(input + i * 8), __max);
+  }
+  float max = hmax256_ps(__max);
+  for (int i = loop * 8; i < num_classes; ++i) {
+    max = std::max(max, input[i]);
+  }
+
+  // exp(x - max) and sum(exp(x - max))
+  __max = _mm256_set1_ps(max);
+  __m256 __sum = _mm256_setzero_ps();
+  for (int i = 0; i < loop; ++i) {
+    __m256 x = _mm256_sub_ps(_mm256_loadu_ps(input + i * 8), __max);
+    x = exp256_ps(x);
+    __sum = _mm256_add_ps(x, __sum);
+    _mm256_storeu_ps(y + i * 8, x);
+  }
+  float sum = hadd256_ps(__sum);
+  for (int i = loop * 8; i < num_classes; ++i) {
+    y[i] = expf(input[i] - max);
+    sum += y[i];
+  }
+
+  // exp(x - max) / sum
+  float inv_sum = 1.f / sum;
+  __m256 __inv_sum = _mm256_set1_ps(inv_sum);
+  for (int i = 0; i < loop; ++i) {
+    _mm256_storeu_ps(y + i * 8,
+                     _mm256_mul_ps(_mm256_loadu_ps(y + i * 8), __inv_sum));
+  }
+  for (int i = loop * 8; i < loop * 8 + remain; ++i) {
+    y[i] *= inv_sum;
+  }
+}
+#endif  // __x86_64__
+
 float find_max(const float *input, const int num_classes) {
   int remain = num_classes;
   float max = -std::numeric_limits<float>::max();
@@ -61,6 +105,11 @@ float find_max(const float *input, const int num_classes) {
 }
 
 void SoftmaxBasic(const float *input, int num_classes, float *y) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (HasAvx2()) {
+    return SoftmaxAvx2(input, num_classes, y);
+  }
+#endif  // __x86_64__
   float *output = y;
   // find max
   float max = find_max(input, num_classes);
@@ -122,15 +171,14 @@ void SoftmaxFuntor<CPU, float>::operator()(const framework::Tensor *X,
   const float *x = X->data<float>();
   float *y = Y->mutable_data<float>();
 
-  #pragma omp parallel for collapse(2)
-  for (int batch = 0; batch < X->dims()[0]; ++batch) {
-    for (int channel = 0; channel < channels; ++channel) {
-      size_t offset = (batch * channels + channel) * num_classes;
-      const float *input = x + offset;
-      float *output = y + offset;
-      SoftmaxBasic(input, num_classes, output);
-    }
-  }
+  parallel_for(0, X->dims()[0] * channels, [&](int index) {
+    int batch = index / channels;
+    int channel = index % channels;
+    size_t offset = (batch * channels + channel) * num_classes;
+    const float *input = x + offset;
+    float *output = y + offset;
+    SoftmaxBasic(input, num_classes, output);
+  });
 }
 
 template <>
@@ -140,14 +188,13 @@ void SequenceSoftmaxFuntor<CPU, float>::operator()(
   const auto &lod = X->lod().back();
   float *y = Y->mutable_data<float>();
 
-  #pragma omp parallel for
-  for (int batch = 0; batch < lod.size() - 1; ++batch) {
+  parallel_for(0, lod.size() - 1, [&](int batch) {
     int num_classes = lod[batch + 1] - lod[batch];
     size_t offset = lod[batch];
     const float *input = x + offset;
     float *output = y + offset;
     SoftmaxBasic(input, num_classes, output);
-  }
+  });
 }
 
 }  // namespace math
@@ -12,8 +12,6 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
-#ifdef CONV_OP
-
 #pragma once
 
 #include "framework/tensor.h"
@@ -22,6 +20,9 @@ namespace paddle_mobile {
 namespace operators {
 namespace math {
 
+// tile 为输入块边长, kernel 为卷积核边长, 输出块边长为 tile - kernel + 1.
+// <8, 3> 即 F(6,3), 只有 arm 实现; <4, 3> F(2,3), <6, 3> F(4,3) 和
+// <6, 5> F(2,5) 为平台无关的实现, 见 winograd_transform_common.cpp
 template <int tile, int kernel>
 void winograd_transform_weight(const framework::Tensor &weight,
                                framework::Tensor *output);
@@ -30,6 +31,18 @@ template <int tile, int kernel>
 void winograd_transform_input(const framework::Tensor &input,
                               framework::Tensor *output);
 
+// winograd_transform_input 对 input_dims 的 [1, c, h, w] 输入所需元素个数的
+// 上界, 各实现按 tile 分块, armv7 的 f6k3 还将块数补齐到 8 的倍数
+template <int tile, int kernel>
+inline int64_t winograd_transformed_input_size(
+    const framework::DDim &input_dims) {
+  const int out_tile = tile - kernel + 1;
+  int64_t h_tiles = (input_dims[2] - kernel + out_tile) / out_tile;
+  int64_t w_tiles = (input_dims[3] - kernel + out_tile) / out_tile;
+  int64_t tiles = (h_tiles * w_tiles + 7) / 8 * 8;
+  return tile * tile * input_dims[1] * tiles;
+}
+
 template <int tile, int kernel>
 void winograd_transform_output(const framework::Tensor &input,
                                const framework::Tensor &weight,
@@ -38,5 +51,3 @@ void winograd_transform_output(const framework::Tensor &input,
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle_mobile
-
-#endif
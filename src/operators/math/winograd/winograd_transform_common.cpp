@@ -0,0 +1,305 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// 与平台无关的 winograd 变换: F(2,3), F(4,3) 和 F(2,5), 变换矩阵参考
+// https://github.com/andravin/wincnn, 插值点为 0, 1, -1, 2, -2
+
+#include <algorithm>
+#include <vector>
+#include "common/threadpool.h"
+#include "framework/workspace.h"
+#include "operators/math/gemm.h"
+#include "operators/math/winograd/winograd_transform.h"
+
+namespace paddle_mobile {
+namespace operators {
+namespace math {
+
+// tile 为输入块边长 alpha, 输出块边长为 tile - kernel + 1. G 用于权重变换,
+// Input 对一行 (列) 做 B_T * d, Output 对一行 (列) 做 A_T * m
+template <int tile, int kernel>
+struct WinogradMatrix;
+
+// F(2,3)
+template <>
+struct WinogradMatrix<4, 3> {
+  static const float G[4][3];
+
+  static inline void Input(const float *d, int ds, float *o, int os) {
+    o[0] = d[0] - d[2 * ds];
+    o[os] = d[ds] + d[2 * ds];
+    o[2 * os] = d[2 * ds] - d[ds];
+    o[3 * os] = d[ds] - d[3 * ds];
+  }
+
+  static inline void Output(const float *m, int ms, float *o, int os) {
+    o[0] = m[0] + m[ms] + m[2 * ms];
+    o[os] = m[ms] - m[2 * ms] - m[3 * ms];
+  }
+};
+
+const float WinogradMatrix<4, 3>::G[4][3] = {
+    {1, 0, 0}, {0.5f, 0.5f, 0.5f}, {0.5f, -0.5f, 0.5f}, {0, 0, 1}};
+
+// F(4,3) 与 F(2,5) 的 B_T:
+// 4  0 -5  0  1  0
+// 0 -4 -4  1  1  0
+// 0  4 -4 -1  1  0
+// 0 -2 -1  2  1  0
+// 0  2 -1 -2  1  0
+// 0  4  0 -5  0  1
+static inline void InputTile6(const float *d, int ds, float *o, int os) {
+  float d0 = d[0];
+  float d1 = d[ds];
+  float d2 = d[2 * ds];
+  float d3 = d[3 * ds];
+  float d4 = d[4 * ds];
+  float d5 = d[5 * ds];
+  float v1 = d4 - 4 * d2;
+  float v2 = d3 - 4 * d1;
+  float v3 = d4 - d2;
+  float v4 = 2 * (d3 - d1);
+  o[0] = 4 * d0 - 5 * d2 + d4;
+  o[os] = v1 + v2;
+  o[2 * os] = v1 - v2;
+  o[3 * os] = v3 + v4;
+  o[4 * os] = v3 - v4;
+  o[5 * os] = 4 * d1 - 5 * d3 + d5;
+}
+
+// F(4,3)
+template <>
+struct WinogradMatrix<6, 3> {
+  static const float G[6][3];
+
+  static inline void Input(const float *d, int ds, float *o, int os) {
+    InputTile6(d, ds, o, os);
+  }
+
+  static inline void Output(const float *m, int ms, float *o, int os) {
+    float t1 = m[ms] + m[2 * ms];
+    float t2 = m[ms] - m[2 * ms];
+    float t3 = m[3 * ms] + m[4 * ms];
+    float t4 = m[3 * ms] - m[4 * ms];
+    o[0] = m[0] + t1 + t3;
+    o[os] = t2 + 2 * t4;
+    o[2 * os] = t1 + 4 * t3;
+    o[3 * os] = t2 + 8 * t4 + m[5 * ms];
+  }
+};
+
+const float WinogradMatrix<6, 3>::G[6][3] = {
+    {1.f / 4, 0, 0},
+    {-1.f / 6, -1.f / 6, -1.f / 6},
+    {-1.f / 6, 1.f / 6, -1.f / 6},
+    {1.f / 24, 1.f / 12, 1.f / 6},
+    {1.f / 24, -1.f / 12, 1.f / 6},
+    {0, 0, 1}};
+
+// F(2,5)
+template <>
+struct WinogradMatrix<6, 5> {
+  static const float G[6][5];
+
+  static inline void Input(const float *d, int ds, float *o, int os) {
+    InputTile6(d, ds, o, os);
+  }
+
+  static inline void Output(const float *m, int ms, float *o, int os) {
+    float t1 = m[ms] + m[2 * ms];
+    float t2 = m[ms] - m[2 * ms];
+    float t3 = m[3 * ms] + m[4 * ms];
+    float t4 = m[3 * ms] - m[4 * ms];
+    o[0] = m[0] + t1 + t3;
+    o[os] = t2 + 2 * t4 + m[5 * ms];
+  }
+};
+
+const float WinogradMatrix<6, 5>::G[6][5] = {
+    {1.f / 4, 0, 0, 0, 0},
+    {-1.f / 6, -1.f / 6, -1.f / 6, -1.f / 6, -1.f / 6},
+    {-1.f / 6, 1.f / 6, -1.f / 6, 1.f / 6, -1.f / 6},
+    {1.f / 24, 1.f / 12, 1.f / 6, 1.f / 3, 2.f / 3},
+    {1.f / 24, -1.f / 12, 1.f / 6, -1.f / 3, 2.f / 3},
+    {0, 0, 0, 0, 1}};
+
+// 权重变换 U = G * g * G_T, 输出 shape 为 [tile * tile, out_channel,
+// in_channel], 每个变换位置是一个 out_channel x in_channel 的矩阵
+template <int tile, int kernel>
+void TransformWeight(const framework::Tensor &weight,
+                     framework::Tensor *output) {
+  typedef WinogradMatrix<tile, kernel> Matrix;
+  int out_channel = weight.dims()[0];
+  int in_channel = weight.dims()[1];
+  int channels = out_channel * in_channel;
+  framework::DDim transformed_shape = framework::make_ddim(
+      std::vector<int>{tile * tile, out_channel, in_channel});
+  float *outptr = output->mutable_data<float>(transformed_shape);
+  const float *inptr = weight.data<float>();
+  for (int c = 0; c < channels; ++c) {
+    const float *g = inptr + c * kernel * kernel;
+    float gt[tile][kernel];
+    for (int i = 0; i < tile; ++i) {
+      for (int j = 0; j < kernel; ++j) {
+        float sum = 0.f;
+        for (int k = 0; k < kernel; ++k) {
+          sum += Matrix::G[i][k] * g[k * kernel + j];
+        }
+        gt[i][j] = sum;
+      }
+    }
+    for (int i = 0; i < tile; ++i) {
+      for (int j = 0; j < tile; ++j) {
+        float sum = 0.f;
+        for (int k = 0; k < kernel; ++k) {
+          sum += gt[i][k] * Matrix::G[j][k];
+        }
+        outptr[(i * tile + j) * channels + c] = sum;
+      }
+    }
+  }
+}
+
+// 输入变换 V = B_T * d * B, input 为已 pad 的 [1, c, h, w], 输出 shape 为
+// [tile * tile, c, h_tiles, w_tiles], 越界的输入按 0 处理, 按通道和块行并行
+template <int tile, int kernel>
+void TransformInput(const framework::Tensor &input,
+                    framework::Tensor *output) {
+  typedef WinogradMatrix<tile, kernel> Matrix;
+  const int out_tile = tile - kernel + 1;
+  int channel = input.dims()[1];
+  int height = input.dims()[2];
+  int width = input.dims()[3];
+  int h_tiles = (height - kernel + out_tile) / out_tile;
+  int w_tiles = (width - kernel + out_tile) / out_tile;
+  int tiles = h_tiles * w_tiles;
+  framework::DDim transformed_shape = framework::make_ddim(
+      std::vector<int>{tile * tile, channel, h_tiles, w_tiles});
+  float *outptr = output->mutable_data<float>(transformed_shape);
+  const float *inptr = input.data<float>();
+  const int stride = channel * tiles;
+
+  parallel_for(0, channel * h_tiles, [&](int index) {
+    int c = index / h_tiles;
+    int th = index % h_tiles;
+    const float *in = inptr + c * height * width;
+    float *out = outptr + c * tiles + th * w_tiles;
+    int h0 = th * out_tile;
+    int rows = std::min(tile, height - h0);
+    for (int tw = 0; tw < w_tiles; ++tw) {
+      int w0 = tw * out_tile;
+      int cols = std::min(tile, width - w0);
+      float d[tile][tile] = {{0}};
+      for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+          d[i][j] = in[(h0 + i) * width + w0 + j];
+        }
+      }
+      // B_T * d 按列, 再乘 B 按行, 结果直接写到各变换位置
+      float bd[tile][tile];
+      for (int j = 0; j < tile; ++j) {
+        Matrix::Input(&d[0][j], tile, &bd[0][j], tile);
+      }
+      for (int i = 0; i < tile; ++i) {
+        Matrix::Input(bd[i], 1, out + i * tile * stride + tw, stride);
+      }
+    }
+  });
+}
+
+// 每个变换位置做一次 [oc, ic] x [ic, tiles] 的矩阵乘法, 再做输出变换
+// Y = A_T * m * A, 只写回 output 范围内的结果, 按位置和输出通道并行
+template <int tile, int kernel>
+void TransformOutput(const framework::Tensor &input,
+                     const framework::Tensor &weight,
+                     framework::Tensor *output) {
+  typedef WinogradMatrix<tile, kernel> Matrix;
+  const int out_tile = tile - kernel + 1;
+  int out_channel = weight.dims()[1];
+  int in_channel = weight.dims()[2];
+  int h_tiles = input.dims()[2];
+  int w_tiles = input.dims()[3];
+  int tiles = h_tiles * w_tiles;
+  int out_h = output->dims()[2];
+  int out_w = output->dims()[3];
+  // [tile * tile, out_channel, tiles] 的乘积
+  framework::WorkspaceScope scratch;
+  float *product_data =
+      scratch.Allocate<float>(tile * tile * out_channel * tiles);
+  const float *v = input.data<float>();
+  const float *u = weight.data<float>();
+
+  parallel_for(0, tile * tile, [&](int pos) {
+    Gemm gemm;
+    gemm.Sgemm(out_channel, tiles, in_channel, 1.f,
+               u + pos * out_channel * in_channel, in_channel,
+               v + pos * in_channel * tiles, tiles, 0.f,
+               product_data + pos * out_channel * tiles, tiles, false,
+               nullptr);
+  });
+
+  float *outptr = output->data<float>();
+  const int stride = out_channel * tiles;
+  parallel_for(0, out_channel * h_tiles, [&](int index) {
+    int oc = index / h_tiles;
+    int th = index % h_tiles;
+    const float *m = product_data + oc * tiles + th * w_tiles;
+    float *out = outptr + oc * out_h * out_w;
+    int h0 = th * out_tile;
+    int rows = std::min(out_tile, out_h - h0);
+    for (int tw = 0; tw < w_tiles; ++tw) {
+      int w0 = tw * out_tile;
+      int cols = std::min(out_tile, out_w - w0);
+      float am[out_tile][tile];
+      for (int j = 0; j < tile; ++j) {
+        Matrix::Output(m + j * stride + tw, tile * stride, &am[0][j], tile);
+      }
+      float y[out_tile][out_tile];
+      for (int i = 0; i < out_tile; ++i) {
+        Matrix::Output(am[i], 1, y[i], 1);
+      }
+      for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+          out[(h0 + i) * out_w + w0 + j] = y[i][j];
+        }
+      }
+    }
+  });
+}
+
+#define WINOGRAD_TRANSFORM_IMPL(tile, kernel)                               \
+  template <>                                                               \
+  void winograd_transform_weight<tile, kernel>(                             \
+      const framework::Tensor &weight, framework::Tensor *output) {         \
+    TransformWeight<tile, kernel>(weight, output);                          \
+  }                                                                         \
+  template <>                                                               \
+  void winograd_transform_input<tile, kernel>(                              \
+      const framework::Tensor &input, framework::Tensor *output) {          \
+    TransformInput<tile, kernel>(input, output);                            \
+  }                                                                         \
+  template <>                                                               \
+  void winograd_transform_output<tile, kernel>(                             \
+      const framework::Tensor &input, const framework::Tensor &weight,      \
+      framework::Tensor *output) {                                          \
+    TransformOutput<tile, kernel>(input, weight, output);                   \
+  }
+
+WINOGRAD_TRANSFORM_IMPL(4, 3)
+WINOGRAD_TRANSFORM_IMPL(6, 3)
+WINOGRAD_TRANSFORM_IMPL(6, 5)
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle_mobile
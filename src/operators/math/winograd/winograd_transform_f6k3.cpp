@@ -15,10 +15,10 @@ limitations under the License. */
 // Inspired by https://arxiv.org/abs/1509.09308 and refered from nnpack and ncnn
 // project.
 
-#ifdef CONV_OP
-
 #ifndef __aarch64__
 
+#include "common/threadpool.h"
+#include "framework/workspace.h"
 #include "operators/math/pad.h"
 #include "operators/math/winograd/winograd_transform.h"
 
@@ -55,8 +55,8 @@ void winograd_transform_weight<8, 3>(const framework::Tensor &weight,
 #if 0
   remain_start = 0;
 #else
-  #pragma omp parallel for
-  for (int oc = 0; oc < out_channel - 3; oc += 4) {
+  parallel_for(0, out_channel / 4, [&](int ocb) {
+    int oc = ocb * 4;
     float gw[96];  // gw[3][8][4]
     const float *inptr0 = inptr + oc * in_channel * 9;
     const float *inptr1 = inptr + (oc + 1) * in_channel * 9;
@@ -257,12 +257,11 @@ void winograd_transform_weight<8, 3>(const framework::Tensor &weight,
           : "cc", "memory", "q0", "q1", "q2", "q3", "q9", "q10", "q11", "q12",
             "q13", "r0");
     }
-  }
+  });
 #endif
 
   // remain output channel
-  #pragma omp parallel for
-  for (int oc = remain_start; oc < out_channel; ++oc) {
+  parallel_for(remain_start, out_channel, [&](int oc) {
     float gw[3][8];                                     // gw[3][8]
     const float *inptr0 = inptr + oc * in_channel * 9;  //
     // (oc / 4) * 64 * in_channel * 4 + oc % 4
@@ -307,7 +306,7 @@ void winograd_transform_weight<8, 3>(const framework::Tensor &weight,
       }
       outptr += 4;
     }
-  }
+  });
 }
 
 template <>
@@ -338,12 +337,14 @@ void winograd_transform_input<8, 3>(const framework::Tensor &input,
   const float *inptr = input.data<float>();
   height = h_tiles * 6 + 2;
   width = w_tiles * 6 + 2;
+  framework::WorkspaceScope scratch;
   framework::Tensor input_pad;
   if (height > input.dims()[2] || width > input.dims()[3]) {
     framework::DDim input_shape =
         framework::make_ddim(std::vector<int>{1, channel, height, width});
     PadFunctor<CPU, float> pad;
-    inptr = input_pad.mutable_data<float>(input_shape);
+    input_pad = scratch.NewTensor<float>(input_shape);
+    inptr = input_pad.data<float>();
     pad(input, 0, height - input.dims()[2], 0, width - input.dims()[3],
         &input_pad);
   }
@@ -354,8 +355,8 @@ void winograd_transform_input<8, 3>(const framework::Tensor &input,
 #if 1
   remain_c_start = 0;
 #else
-  #pragma omp parallel for
-  for (int c = 0; c < channel - 3; c += 4) {
+  parallel_for(0, channel / 4, [&](int cb) {
+    int c = cb * 4;
     const float *in = inptr + c * image_size;
     float d_bt[64 * 4];  // d * B_t
     for (int h = 0; h < h_tiles; ++h) {
@@ -649,12 +650,11 @@ void winograd_transform_input<8, 3>(const framework::Tensor &input,
               "q8", "q9", "q10", "q11", "q12", "q13", "r0", "r1");
       }
     }
-  }
+  });
 #endif
 
   // remainer channels
-  #pragma omp parallel for
-  for (int c = remain_c_start; c < channel; ++c) {
+  parallel_for(remain_c_start, channel, [&](int c) {
     const float *in = inptr + c * image_size;
     float d_bt[64];  // d * B_t
     for (int h = 0; h < h_tiles; ++h) {
@@ -863,7 +863,7 @@ void winograd_transform_input<8, 3>(const framework::Tensor &input,
               "q8", "q9", "q10", "q11", "q12", "q13", "r0");
       }
     }
-  }
+  });
 }
 
 template <>
@@ -877,15 +877,13 @@ void winograd_transform_output<8, 3>(const framework::Tensor &input,
   int out_channel = weight.dims()[0];
 
   // compute U*V first
-  framework::Tensor uv_trans;
-  framework::DDim shape =
-      framework::make_ddim(std::vector<int>{out_channel, tiles, 64, 32});
-  float *uv_trans_ptr = uv_trans.mutable_data<float>(shape);
+  // [out_channel, tiles, 64, 32]
+  framework::WorkspaceScope scratch;
+  float *uv_trans_ptr = scratch.Allocate<float>(out_channel * tiles * 64 * 32);
   const float *input_ptr = input.data<float>();
   const float *weight_ptr = weight.data<float>();
 
-  #pragma omp parallel for
-  for (int i = 0; i < out_channel; ++i) {
+  parallel_for(0, out_channel, [&](int i) {
     float *uv_ptr = uv_trans_ptr + (i * tiles * 64 * 32);
     for (int j = 0; j < tiles; ++j) {
       for (int k = 0; k < 64; ++k) {
@@ -959,7 +957,7 @@ void winograd_transform_output<8, 3>(const framework::Tensor &input,
               "q8", "q9", "q10", "q11", "q12", "q13", "q14", "q15");
       }
     }
-  }
+  });
 
   /*
    * s0 = m0 + (m1 + m2) +      (m3 + m4) + 32 * (m5 + m6)
@@ -978,8 +976,7 @@ void winograd_transform_output<8, 3>(const framework::Tensor &input,
   float *output_ptr = output->mutable_data<float>();
   float transform_matrix[8] = {2.f, 4.f, 8.f, 16.f};
 
-  #pragma omp parallel for
-  for (int oc = 0; oc < output->dims()[1]; ++oc) {
+  parallel_for(0, output->dims()[1], [&](int oc) {
     float at_m[48];        // [6][8]
     float output_tmp[36];  // [6][6], temporarily restore results
     // (oc / 4) * tiles * 64 * 32 + (oc & 0x3) * 8
@@ -1340,7 +1337,7 @@ void winograd_transform_output<8, 3>(const framework::Tensor &input,
         }
       }
     }
-  }
+  });
 }
 
 }  // namespace math
@@ -1348,4 +1345,3 @@ void winograd_transform_output<8, 3>(const framework::Tensor &input,
 }  // namespace paddle_mobile
 
 #endif  // __aarch64__
-#endif  // CONV_OP
@@ -15,7 +15,6 @@ limitations under the License. */
 // We refer https://github.com/andravin/wincnn to access the winograd transform
 // matrixs
 
-#ifdef CONV_OP
 #ifdef __aarch64__
 
 #include "operators/math/winograd/winograd_transform.h"
@@ -410,4 +409,3 @@ void winograd_transform_output<8, 3>(const framework::Tensor &input,
 }  // namespace paddle_mobile
 
 #endif  // __aarch64__
-#endif  // CONV_OP
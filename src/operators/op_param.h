@@ -20,6 +20,7 @@ limitations under the License. */
 #include "common/type_define.h"
 #include "common/types.h"
 #include "framework/lod_tensor.h"
+#include "framework/packed_weight.h"
 #include "framework/scope.h"
 #include "framework/tensor.h"
 #include "framework/variable.h"
@@ -69,7 +70,49 @@ struct DtypeTensorTrait<GPU_CL> {
 #endif
 
 class OpParam {
+ public:
+  // share the data derived from the weights by kernel Init with the same
+  // param of another executor, see OperatorBase::InitFrom
+  void ShareWeightsFrom(const OpParam &shared) {}
+
+  // name of the kernel implementation chosen at Init, for profiling
+  std::string ExecModeName() const { return ""; }
+  // see OperatorBase::KernelWeights and OperatorBase::SetExecModeName, the
+  // entries of KernelWeights may be nullptr
+  std::vector<framework::Tensor *> KernelWeights() { return {}; }
+  void SetExecModeName(const std::string &name) {}
+  // forgets the implementation picked at Init if it depends on the input
+  // shape and returns whether Init has to pick again, see OperatorBase::Replan
+  bool ResetExecMode() { return false; }
+  // see OperatorBase::PackedWeights
+  std::vector<framework::PackedWeight> PackedWeights() { return {}; }
+
  protected:
+  // the filter of a conv packed as the A of the gemm. The convs of blocked
+  // inputs pack it otherwise and the depthwise ones may read the filter
+  // itself, neither is described. So the depthwise filters stay float under
+  // weight_compression and weight_precision: they hold 9 values per channel
+  // against a whole channel of activations, 44640 of the 4.2M weights of
+  // mobilenet v1, and halving them would take half variants of every
+  // depthwise kernel for about 1% of the weight memory.
+  static std::vector<framework::PackedWeight> PackedConvFilter(
+      framework::Tensor *packed, const framework::Tensor *input,
+      const framework::Tensor *filter, int groups) {
+    if (!packed->IsInitialized() ||
+        framework::DataLayoutBlock(input->layout()) > 1 ||
+        groups == input->dims()[1]) {
+      return {};
+    }
+    const int k = static_cast<int>(filter->numel() / filter->dims()[0]);
+    return {{packed, true, k, "Filter"}};
+  }
+  template <typename T>
+  static std::vector<framework::PackedWeight> PackedConvFilter(
+      framework::Tensor *packed, const T *input, const T *filter,
+      int groups) {
+    return {};
+  }
+
   template <typename T>
   static T *InputH0From(const VariableNameMap &inputs, const Scope &scope) {
     return GetVarValue<T>("H0", inputs, scope);
@@ -419,11 +462,32 @@ class ConvParam : public OpParam {
     input_ = OpParam::InputFrom<GType>(inputs, scope);
     if (outputs.count("Output")) {
       output_ = OpParam::OutputFrom<GType>(outputs, scope);
+    } else if (outputs.count("Out")) {
+      // the fused convs write to Out, the shared float conv reads it here
+      output_ = OpParam::OutFrom<GType>(outputs, scope);
     }
     strides_ = OpParam::GetAttr<vector<int>>("strides", attrs);
     paddings_ = OpParam::GetAttr<vector<int>>("paddings", attrs);
     dilations_ = OpParam::GetAttr<vector<int>>("dilations", attrs);
     groups = OpParam::GetAttr<int>("groups", attrs);
+    exec_mode_ = EXEC_INVALID;
+  }
+
+  void ShareWeightsFrom(const ConvParam<Dtype> &shared) {
+    if (shared.packed_filter_.IsInitialized()) {
+      packed_filter_.ShareDataWith(shared.packed_filter_);
+    }
+    if (shared.transformed_filter_.IsInitialized()) {
+      transformed_filter_.ShareDataWith(shared.transformed_filter_);
+    }
+  }
+
+  std::vector<framework::Tensor *> KernelWeights() {
+    return {&packed_filter_, &transformed_filter_};
+  }
+
+  std::vector<framework::PackedWeight> PackedWeights() {
+    return PackedConvFilter(&packed_filter_, input_, filter_, groups);
   }
 
   const RType *Input() const { return input_; }
@@ -441,11 +505,15 @@ class ConvParam : public OpParam {
   enum ExecMode {
     EXEC_INVALID = 0,
     EXEC_GEMM_FLOAT,
+    EXEC_GEMM_IMPLICIT_FLOAT,
+    EXEC_BLOCKED_FLOAT,
     EXEC_DEPTHWISE3x3S1P1_FLOAT,
     EXEC_DEPTHWISE3x3S2P0_FLOAT,
     EXEC_DEPTHWISE3x3S2P1_FLOAT,
     EXEC_DEPTHWISE3x3_FLOAT,
     EXEC_WINOGRAD3X3_FLOAT,
+    EXEC_WINOGRAD3X3_F2_FLOAT,
+    EXEC_WINOGRAD3X3_F4_FLOAT,
     EXEC_WINOGRAD5X5_FLOAT,
     EXEC_DEPTHWISE5x5_FLOAT,
     EXEC_GEMM_INT8,
@@ -455,6 +523,68 @@ class ConvParam : public OpParam {
 
   ExecMode &ExecMode() const { return exec_mode_; }
 
+  std::string ExecModeName() const {
+    switch (exec_mode_) {
+      case EXEC_GEMM_FLOAT:
+        return "gemm_float";
+      case EXEC_GEMM_IMPLICIT_FLOAT:
+        return "gemm_implicit_float";
+      case EXEC_BLOCKED_FLOAT:
+        return "blocked_float";
+      case EXEC_DEPTHWISE3x3S1P1_FLOAT:
+        return "depthwise3x3s1p1_float";
+      case EXEC_DEPTHWISE3x3S2P0_FLOAT:
+        return "depthwise3x3s2p0_float";
+      case EXEC_DEPTHWISE3x3S2P1_FLOAT:
+        return "depthwise3x3s2p1_float";
+      case EXEC_DEPTHWISE3x3_FLOAT:
+        return "depthwise3x3_float";
+      case EXEC_WINOGRAD3X3_FLOAT:
+        return "winograd3x3_float";
+      case EXEC_WINOGRAD3X3_F2_FLOAT:
+        return "winograd3x3_f2_float";
+      case EXEC_WINOGRAD3X3_F4_FLOAT:
+        return "winograd3x3_f4_float";
+      case EXEC_WINOGRAD5X5_FLOAT:
+        return "winograd5x5_float";
+      case EXEC_DEPTHWISE5x5_FLOAT:
+        return "depthwise5x5_float";
+      case EXEC_GEMM_INT8:
+        return "gemm_int8";
+      case EXEC_DEPTHWISE3x3_INT8:
+        return "depthwise3x3_int8";
+      case EXEC_DEPTHWISE5x5_INT8:
+        return "depthwise5x5_int8";
+      default:
+        return "";
+    }
+  }
+
+  void SetExecModeName(const std::string &name) {
+    for (int mode = EXEC_GEMM_FLOAT; mode <= EXEC_DEPTHWISE5x5_INT8; ++mode) {
+      exec_mode_ = static_cast<enum ExecMode>(mode);
+      if (ExecModeName() == name) {
+        return;
+      }
+    }
+    exec_mode_ = EXEC_INVALID;
+  }
+
+  // the float algorithms are picked for the input shape, the int8 and the
+  // blocked convs and the fused ones not picking an algorithm are left alone
+  bool ResetExecMode() {
+    if (exec_mode_ == EXEC_INVALID || exec_mode_ == EXEC_BLOCKED_FLOAT ||
+        exec_mode_ >= EXEC_GEMM_INT8) {
+      return false;
+    }
+    exec_mode_ = EXEC_INVALID;
+    // the weights may be shared with a clone or kept by another shape plan,
+    // Init derives new ones
+    packed_filter_ = framework::Tensor();
+    transformed_filter_ = framework::Tensor();
+    return true;
+  }
+
   const int &Groups() const { return groups; }
 
 #ifdef PADDLE_MOBILE_CL
@@ -468,7 +598,13 @@ class ConvParam : public OpParam {
   RType *input_;
   RType *output_;
   RType *filter_;
-  RType *transformed_filter_;
+  // filter transformed for winograd by kernel Init, empty if it is not
+  framework::Tensor transformed_filter_;
+  // filter packed for gemm by kernel Init, empty if it is not packed
+  framework::Tensor packed_filter_;
+  mutable framework::Tensor gemm_workspace_;
+  // gemm workspace of every thread when the images of a batch run in parallel
+  mutable std::vector<framework::Tensor> thread_workspaces_;
   vector<int> strides_;
   vector<int> paddings_;
   vector<int> dilations_;
@@ -500,7 +636,7 @@ template <typename Dtype>
 Print &operator<<(Print &printer, const ConvParam<Dtype> &conv_param);
 
 template <typename Dtype>
-class ElementwiseAddParam : OpParam {
+class ElementwiseAddParam : public OpParam {
   typedef typename DtypeTensorTrait<Dtype>::gtype GType;
   typedef typename DtypeTensorTrait<Dtype>::rtype RType;
 
@@ -540,7 +676,7 @@ class ElementwiseAddParam : OpParam {
 
 #ifdef ELEMENTWISEMUL_OP
 template <typename Dtype>
-class ElementwiseMulParam : OpParam {
+class ElementwiseMulParam : public OpParam {
   typedef typename DtypeTensorTrait<Dtype>::gtype GType;
   typedef typename DtypeTensorTrait<Dtype>::rtype RType;
 
@@ -577,7 +713,7 @@ using ElementwiseAddReluParam = ElementwiseAddParam<Dtype>;
 
 #ifdef ELEMENTWISESUB_OP
 template <typename Dtype>
-class ElementwiseSubParam : OpParam {
+class ElementwiseSubParam : public OpParam {
   typedef typename DtypeTensorTrait<Dtype>::gtype GType;
   typedef typename DtypeTensorTrait<Dtype>::rtype RType;
 
@@ -609,7 +745,7 @@ class ElementwiseSubParam : OpParam {
 
 #ifdef MUL_OP
 template <typename Dtype>
-class MulParam : OpParam {
+class MulParam : public OpParam {
   typedef typename DtypeTensorTrait<Dtype>::gtype GType;
   typedef typename DtypeTensorTrait<Dtype>::rtype RType;
 
@@ -758,7 +894,7 @@ class LrnParam : public OpParam {
 
 #ifdef NORM_OP
 template <typename Dtype>
-class NormParam : OpParam {
+class NormParam : public OpParam {
   typedef typename DtypeTensorTrait<Dtype>::gtype GType;
   typedef typename DtypeTensorTrait<Dtype>::rtype RType;
 
@@ -793,7 +929,7 @@ class NormParam : OpParam {
 
 #ifdef BATCHNORM_OP
 template <typename Dtype>
-class BatchNormParam : OpParam {
+class BatchNormParam : public OpParam {
   typedef typename DtypeTensorTrait<Dtype>::gtype GType;
   typedef typename DtypeTensorTrait<Dtype>::rtype RType;
 
@@ -1342,6 +1478,10 @@ class LookupParam : public OpParam {
   GType *Out() const { return out_; }
   int64_t PaddingIdx() const { return padding_idx_; }
 
+  std::vector<framework::PackedWeight> PackedWeights() {
+    return {{input_w_, false, 0, "W"}};
+  }
+
  private:
   GType *input_w_;
   GType *input_ids_;
@@ -1714,6 +1854,26 @@ class FusionFcParam : public OpParam {
     y_num_col_dims_ = GetAttr<int>("y_num_col_dims", attrs);
     axis_ = GetAttr<int>("axis", attrs);
   }
+
+  void ShareWeightsFrom(const FusionFcParam<Dtype> &shared) {
+    if (shared.packed_weight_.IsInitialized()) {
+      packed_weight_.ShareDataWith(shared.packed_weight_);
+    }
+  }
+
+  std::vector<framework::Tensor *> KernelWeights() {
+    return {&packed_weight_};
+  }
+
+  std::vector<framework::PackedWeight> PackedWeights() {
+    if (!packed_weight_.IsInitialized()) {
+      return {};
+    }
+    const int k = static_cast<int>(
+        framework::flatten_to_2d(input_y_->dims(), y_num_col_dims_)[0]);
+    return {{&packed_weight_, false, k, "Y"}};
+  }
+
   GType *InputX() const { return input_x_; }
 
   RType *InputY() const { return input_y_; }
@@ -1737,6 +1897,11 @@ class FusionFcParam : public OpParam {
   int y_num_col_dims_;
   int axis_;
 
+ public:
+  // weight packed for gemm by kernel Init, empty if it is not packed
+  framework::Tensor packed_weight_;
+  mutable framework::Tensor gemm_workspace_;
+
 #ifdef PADDLE_MOBILE_FPGA
  private:  // NOLINT
   fpga::SplitConvArgs fpga_conv_args;
@@ -1765,6 +1930,17 @@ class FusionConvAddParam : public ConvParam<Dtype> {
     bias_ = OpParam::InputYFrom<GType>(inputs, scope);
     axis_ = OpParam::GetAttr<int>("axis", attrs);
     output_ = OpParam::OutFrom<GType>(outputs, scope);
+    // the activation and the residual added before it are optional, the
+    // graph optimization fuses them into the conv
+    if (OpParam::HasAttr("fuse_activation", attrs)) {
+      fuse_activation_ = OpParam::GetStringAttr("fuse_activation", attrs);
+    }
+    if (OpParam::HasAttr("fuse_alpha", attrs)) {
+      fuse_alpha_ = OpParam::GetAttr<float>("fuse_alpha", attrs);
+    }
+    if (inputs.count("ResidualData")) {
+      residual_ = OpParam::GetVarValue<GType>("ResidualData", inputs, scope);
+    }
   }
   RType *Bias() const { return bias_; }
 
@@ -1772,10 +1948,19 @@ class FusionConvAddParam : public ConvParam<Dtype> {
 
   RType *Output() const { return output_; }
 
+  const std::string &FuseActivation() const { return fuse_activation_; }
+
+  float FuseAlpha() const { return fuse_alpha_; }
+
+  RType *ResidualData() const { return residual_; }
+
  protected:
   RType *bias_;
   int axis_;
   RType *output_;
+  std::string fuse_activation_;
+  float fuse_alpha_ = 0.f;
+  RType *residual_ = nullptr;
 };
 
 template <typename Dtype>
@@ -2862,20 +3047,54 @@ class DequantizeParam : public OpParam {
     output_ = OutFrom<GType>(outputs, scope);
     activation_scale_ = OpParam::GetVarValue<GType>("Scale", inputs, scope);
     // dequantization is performed as x = x / static_scale / online_scale
-    if (OpParam::HasAttr("weight_scale", attrs)) {
+    if (OpParam::HasAttr("weight_scales", attrs)) {
+      // weights quantized channel by channel have a scale per output channel
+      weight_scales_ =
+          OpParam::GetAttr<std::vector<float>>("weight_scales", attrs);
+    } else if (OpParam::HasAttr("weight_scale", attrs)) {
       weight_scale_ = OpParam::GetAttr<float>("weight_scale", attrs);
     } else {
       weight_scale_ = OpParam::GetAttr<float>("max_range", attrs);
     }
   }
 
+  // weight scale of the output channel c
+  float WeightScale(int c) const {
+    return weight_scales_.empty() ? weight_scale_ : weight_scales_[c];
+  }
+
  public:
   // op input
   GType *input_;
   // op output
   GType *output_;
   RType *activation_scale_;
-  float weight_scale_;
+  float weight_scale_ = 1.f;
+  std::vector<float> weight_scales_;
+};
+#endif
+
+#ifdef LAYOUT_TRANSFORM_OP
+template <typename Dtype>
+class LayoutTransformParam : public OpParam {
+  typedef typename DtypeTensorTrait<Dtype>::gtype GType;
+  typedef typename DtypeTensorTrait<Dtype>::rtype RType;
+
+ public:
+  LayoutTransformParam(const VariableNameMap &inputs,
+                       const VariableNameMap &outputs,
+                       const AttributeMap &attrs, const Scope &scope) {
+    input_ = InputXFrom<GType>(inputs, scope);
+    output_ = OutFrom<GType>(outputs, scope);
+    dst_layout_ = framework::StringToDataLayout(
+        GetStringAttr("dst_layout", attrs));
+  }
+
+ public:
+  GType *input_;
+  GType *output_;
+  // the layout the input is converted to
+  framework::DataLayout dst_layout_;
 };
 #endif
 
@@ -2974,6 +3193,81 @@ class FusionDequantAddBNQuantParam : public FusionDequantAddBNParam<Dtype> {
 };
 #endif
 
+#if defined(FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP) || \
+    defined(FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP) ||     \
+    defined(FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP) ||    \
+    defined(FUSION_CONV_DEQUANT_RELU_QUANT_OP)
+template <typename Dtype>
+class FusionConvDequantQuantParam : public ConvParam<Dtype> {
+  typedef typename DtypeTensorTrait<Dtype>::gtype GType;
+  typedef typename DtypeTensorTrait<Dtype>::rtype RType;
+
+ public:
+  FusionConvDequantQuantParam(const VariableNameMap &inputs,
+                              const VariableNameMap &outputs,
+                              const AttributeMap &attrs, const Scope &scope)
+      : ConvParam<Dtype>(inputs, outputs, attrs, scope) {
+    this->output_ = OpParam::OutFrom<GType>(outputs, scope);
+    // dequantize params
+    activation_scale_ = OpParam::GetVarValue<GType>("Scale", inputs, scope);
+    if (OpParam::HasAttr("weight_scales", attrs)) {
+      weight_scales_ =
+          OpParam::GetAttr<std::vector<float>>("weight_scales", attrs);
+    } else if (OpParam::HasAttr("weight_scale", attrs)) {
+      weight_scale_ = OpParam::GetAttr<float>("weight_scale", attrs);
+    } else {
+      weight_scale_ = OpParam::GetAttr<float>("max_range", attrs);
+    }
+    // element wise add and batch norm params are optional
+    if (inputs.count("Y")) {
+      bias_ = OpParam::InputYFrom<GType>(inputs, scope);
+    }
+    if (inputs.count("BNScale")) {
+      bn_mean_ = OpParam::GetVarValue<GType>("BNMean", inputs, scope);
+      bn_variance_ = OpParam::GetVarValue<GType>("BNVariance", inputs, scope);
+      bn_scale_ = OpParam::GetVarValue<GType>("BNScale", inputs, scope);
+      bn_bias_ = OpParam::GetVarValue<GType>("BNBias", inputs, scope);
+      epsilon_ = OpParam::GetAttr<float>("epsilon", attrs);
+    }
+    // quantize params, the scale must be calibrated offline
+    online_scale_ = OpParam::GetVarValue<GType>("OutScale", outputs, scope);
+    offline_scale_ = OpParam::GetVarValue<GType>("InScale", inputs, scope);
+    if (OpParam::HasAttr("round_type", attrs)) {
+      round_type_ = OpParam::GetAttr<RoundType>("round_type", attrs);
+    }
+  }
+
+  // weight scale of the output channel c
+  float WeightScale(int c) const {
+    return weight_scales_.empty() ? weight_scale_ : weight_scales_[c];
+  }
+
+ public:
+  // dequantize
+  RType *activation_scale_;
+  float weight_scale_ = 1.f;
+  std::vector<float> weight_scales_;
+  // elementwise add
+  RType *bias_ = nullptr;
+  // batch norm
+  RType *bn_mean_ = nullptr;
+  RType *bn_variance_ = nullptr;
+  RType *bn_scale_ = nullptr;
+  RType *bn_bias_ = nullptr;
+  float epsilon_ = 0.f;
+  // quantize
+  RType *online_scale_;
+  RType *offline_scale_;
+  RoundType round_type_ = ROUND_NEAREST_AWAY_ZERO;
+  // bias add and batch norm folded into a scale and bias per output channel
+  framework::Tensor fused_scale_;
+  framework::Tensor fused_bias_;
+  // the requantize scale and bias of the int32 gemm output
+  mutable framework::Tensor requant_scale_;
+  mutable framework::Tensor requant_bias_;
+};
+#endif
+
 #ifdef SEQUENCE_EXPAND_OP
 template <typename Dtype>
 class SequenceExpandParam : public OpParam {
@@ -12,12 +12,14 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <cmath>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
 #include <limits>
 #include <random>
 #include <type_traits>
+#include <vector>
 #include "../test_helper.h"
 #include "common/log.h"
 #include "memory/t_malloc.h"
@@ -286,6 +288,88 @@ int do_sgemm_with_bias(int m, int n, int k, bool relu, int pr,
   return 0;
 }
 
+int do_sgemm_with_requant(int m, int n, int k, bool relu, int pr) {
+  int lda = k;
+  int ldb = n;
+  int ldc = n;
+  default_random_engine e;
+  uniform_int_distribution<int8_t> pixel(-127, 127);
+  std::uniform_real_distribution<float> real(0.5f, 1.5f);
+  int8_t *a = static_cast<int8_t *>(
+      paddle_mobile::memory::Alloc(sizeof(int8_t) * m * k));
+  int8_t *b = static_cast<int8_t *>(
+      paddle_mobile::memory::Alloc(sizeof(int8_t) * k * n));
+  int8_t *c = static_cast<int8_t *>(
+      paddle_mobile::memory::Alloc(sizeof(int8_t) * m * n));
+  int8_t *c1 = static_cast<int8_t *>(
+      paddle_mobile::memory::Alloc(sizeof(int8_t) * m * n));
+  std::vector<float> scale(m), bias(m);
+
+  for (int i = 0; i < m * k; ++i) {
+    a[i] = pixel(e);
+  }
+  for (int i = 0; i < k * n; ++i) {
+    b[i] = pixel(e);
+  }
+  // the int32 results are about sqrt(k) * 127 * 127 / 3
+  float quant_scale = 20.f / (std::sqrt(static_cast<float>(k)) * 127 * 127);
+  for (int i = 0; i < m; ++i) {
+    scale[i] = real(e);
+    bias[i] = real(e) - 1.f;
+  }
+
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      int32_t r = 0;
+      for (int p = 0; p < k; p++) {
+        r += static_cast<int32_t>(a(i, p)) * static_cast<int32_t>(b(p, j));
+      }
+      float v = r * scale[i] + bias[i];
+      if (relu) v = std::max(0.f, v);
+      v = std::round(v * quant_scale);
+      c1(i, j) = static_cast<int8_t>(std::min(std::max(v, -127.f), 127.f));
+    }
+  }
+
+  paddle_mobile::operators::math::RequantParam requant;
+  requant.scale = scale.data();
+  requant.bias = bias.data();
+  requant.act = relu ? paddle_mobile::RELU : paddle_mobile::IDENTITY;
+  requant.quant_scale = quant_scale;
+  paddle_mobile::operators::math::Gemm gemm;
+  gemm.SgemmWithRequant(m, n, k, a, lda, b, ldb, c, ldc, requant);
+  int eq = 0;
+  int neq = 0;
+  for (int i = 0; i < m * n; ++i) {
+    // multiply-add may be fused, the rounding can differ by one
+    if (std::abs(c[i] - c1[i]) <= 1) {
+      ++eq;
+    } else {
+      ++neq;
+    }
+  }
+
+  if (pr > 0) {
+    std::cout << "C:" << std::endl;
+    print_matrix(m, n, ldc, c);
+    std::cout << "C1:" << std::endl;
+    print_matrix(m, n, ldc, c1);
+  }
+
+  std::cout << "mnk=" << m << " " << n << " " << k << " relu=" << relu
+            << "   eq=" << eq << " neq=" << neq << std::endl;
+
+  PADDLE_MOBILE_ENFORCE(neq == 0,
+                        "The execution of do_sgemm_with_requant is failed!");
+
+  paddle_mobile::memory::Free(a);
+  paddle_mobile::memory::Free(b);
+  paddle_mobile::memory::Free(c);
+  paddle_mobile::memory::Free(c1);
+
+  return 0;
+}
+
 int main() {
 #ifdef _OPENMP
   omp_set_num_threads(4);
@@ -342,5 +426,14 @@ int main() {
   do_sgemm_with_bias(333, 797, 939, true, 0);
   do_sgemm_with_bias(1024, 1024, 1024, true, 0);
 
+  std::cout << "\n\n******************************************************\n\n"
+            << std::endl;
+  std::cout << "Test gemm with requantization:" << std::endl;
+  do_sgemm_with_requant(9, 9, 9, false, 1);
+  do_sgemm_with_requant(10, 6, 12, true, 0);
+  do_sgemm_with_requant(512, 256, 384, false, 0);
+  do_sgemm_with_requant(599, 1133, 393, true, 0);
+  do_sgemm_with_requant(777, 555, 999, true, 0);
+
   return 0;
 }
@@ -0,0 +1,447 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include "common/enforce.h"
+#include "common/log.h"
+#include "operators/math/gemm.h"
+#include "operators/math/gemm_epilogue.h"
+#include "operators/math/gemm_tuner.h"
+#include "operators/math/half_convert.h"
+
+using paddle_mobile::half;
+using paddle_mobile::operators::math::FloatToHalf;
+using paddle_mobile::operators::math::Gemm;
+using paddle_mobile::operators::math::GemmBlocking;
+using paddle_mobile::operators::math::HalfToFloat;
+using paddle_mobile::operators::math::MakeEpilogue;
+namespace epilogue = paddle_mobile::operators::math::epilogue;
+
+int count_neq(const std::vector<float> &c, const std::vector<float> &c1) {
+  int neq = 0;
+  for (size_t i = 0; i < c.size(); ++i) {
+    if (static_cast<int>(c[i]) != static_cast<int>(c1[i])) {
+      ++neq;
+    }
+  }
+  return neq;
+}
+
+// compare the gemm with pre-packed weights against the one packing per call
+int do_sgemm_packed(int m, int n, int k, bool relu) {
+  std::vector<float> a(m * k), b(k * n), bias(m), scale(m);
+  std::vector<float> c(m * n), c1(m * n);
+  for (auto &v : a) v = -4 + rand() % 10;
+  for (auto &v : b) v = -4 + rand() % 10;
+  for (auto &v : bias) v = rand() % 10;
+  for (auto &v : scale) v = rand() % 10;
+
+  Gemm gemm;
+  std::vector<float> packed_a(Gemm::PackedASize(m, k));
+  std::vector<float> packed_b(Gemm::PackedBSize(k, n));
+  gemm.PackWeightA(m, k, a.data(), k, packed_a.data());
+  gemm.PackWeightB(k, n, b.data(), n, packed_b.data());
+  std::vector<float> workspace(gemm.PackedAWorkspaceSize(m, n, k));
+
+  const epilogue::RowBias row_bias{bias.data()};
+  const epilogue::RowScaleShift bn{scale.data(), bias.data()};
+  const epilogue::Activation<paddle_mobile::RELU> act{};
+  Gemm().Sgemm_omp(m, n, k, 1, a.data(), k, b.data(), n, 1, c1.data(), n, relu,
+                   bias.data());
+  if (relu) {
+    gemm.SgemmPackedA(m, n, k, packed_a.data(), b.data(), n, c.data(), n,
+                      MakeEpilogue(row_bias, act), workspace.data());
+  } else {
+    gemm.SgemmPackedA(m, n, k, packed_a.data(), b.data(), n, c.data(), n,
+                      MakeEpilogue(row_bias), workspace.data());
+  }
+  int neq = count_neq(c, c1);
+
+  Gemm().SgemmWithBn_omp(m, n, k, 1, a.data(), k, b.data(), n, 0, c1.data(), n,
+                         relu, scale.data(), bias.data(), nullptr);
+  if (relu) {
+    gemm.SgemmPackedA(m, n, k, packed_a.data(), b.data(), n, c.data(), n,
+                      MakeEpilogue(bn, act), workspace.data());
+  } else {
+    gemm.SgemmPackedA(m, n, k, packed_a.data(), b.data(), n, c.data(), n,
+                      MakeEpilogue(bn), workspace.data());
+  }
+  neq += count_neq(c, c1);
+
+  workspace.resize(gemm.PackedBWorkspaceSize(m, n, k));
+  std::fill(c.begin(), c.end(), 1.f);
+  std::fill(c1.begin(), c1.end(), 1.f);
+  Gemm().Sgemm_omp(m, n, k, 1, a.data(), k, b.data(), n, 1, c1.data(), n, relu,
+                   bias.data());
+  if (relu) {
+    gemm.SgemmPackedB(m, n, k, a.data(), k, packed_b.data(), c.data(), n,
+                      MakeEpilogue(row_bias, act), workspace.data());
+  } else {
+    gemm.SgemmPackedB(m, n, k, a.data(), k, packed_b.data(), c.data(), n,
+                      MakeEpilogue(row_bias), workspace.data());
+  }
+  neq += count_neq(c, c1);
+
+  std::cout << "mnk=" << m << " " << n << " " << k << " relu=" << relu
+            << " neq=" << neq << std::endl;
+  PADDLE_MOBILE_ENFORCE(neq == 0,
+                        "The execution of do_sgemm_packed is failed!");
+  return 0;
+}
+
+// compare the gemm with weights compressed to uint8 against the one with the
+// float weights, every row of a and column of b spans 256 levels of 1/16 so
+// that the compression is exact
+int do_sgemm_compressed(int m, int n, int k) {
+  std::vector<float> a(m * k), b(k * n);
+  std::vector<float> c(m * n), c1(m * n);
+  for (auto &v : a) v = (rand() % 256) / 16.f - 8;
+  for (auto &v : b) v = (rand() % 256) / 16.f - 8;
+  for (int i = 0; i < m; ++i) {
+    a[i * k] = -8;
+    a[i * k + 1] = 255 / 16.f - 8;
+  }
+  for (int j = 0; j < n; ++j) {
+    b[j] = -8;
+    b[n + j] = 255 / 16.f - 8;
+  }
+
+  Gemm gemm;
+  const int packed_a_size = Gemm::PackedASize(m, k);
+  const int packed_b_size = Gemm::PackedBSize(k, n);
+  std::vector<float> packed_a(packed_a_size), packed_b(packed_b_size);
+  gemm.PackWeightA(m, k, a.data(), k, packed_a.data());
+  gemm.PackWeightB(k, n, b.data(), n, packed_b.data());
+  std::vector<uint8_t> compressed_a(Gemm::CompressedSize(packed_a_size, k));
+  std::vector<uint8_t> compressed_b(Gemm::CompressedSize(packed_b_size, k));
+  Gemm::CompressPackedA(packed_a_size, k, packed_a.data(),
+                        compressed_a.data());
+  Gemm::CompressPackedB(packed_b_size, k, packed_b.data(),
+                        compressed_b.data());
+
+  const auto identity = MakeEpilogue();
+  std::vector<float> workspace(gemm.PackedAWorkspaceSize(m, n, k, true));
+  gemm.SgemmPackedA(m, n, k, packed_a.data(), b.data(), n, c1.data(), n,
+                    identity, workspace.data());
+  gemm.SgemmPackedA(m, n, k, compressed_a.data(), b.data(), n, c.data(), n,
+                    identity, workspace.data());
+  int neq = c == c1 ? 0 : 1;
+
+  workspace.resize(gemm.PackedBWorkspaceSize(m, n, k, true));
+  gemm.SgemmPackedB(m, n, k, a.data(), k, packed_b.data(), c1.data(), n,
+                    identity, workspace.data());
+  gemm.SgemmPackedB(m, n, k, a.data(), k, compressed_b.data(), c.data(), n,
+                    identity, workspace.data());
+  neq += c == c1 ? 0 : 1;
+
+  std::cout << "compressed mnk=" << m << " " << n << " " << k
+            << " neq=" << neq << std::endl;
+  PADDLE_MOBILE_ENFORCE(neq == 0,
+                        "The execution of do_sgemm_compressed is failed!");
+  return 0;
+}
+
+// weights exact in half give the same results when they are stored as half
+int do_sgemm_half(int m, int n, int k) {
+  std::vector<float> a(m * k), b(k * n);
+  std::vector<float> c(m * n), c1(m * n);
+  for (auto &v : a) v = (rand() % 2048) / 256.f - 4;
+  for (auto &v : b) v = (rand() % 2048) / 256.f - 4;
+
+  Gemm gemm;
+  const int packed_a_size = Gemm::PackedASize(m, k);
+  const int packed_b_size = Gemm::PackedBSize(k, n);
+  std::vector<float> packed_a(packed_a_size), packed_b(packed_b_size);
+  gemm.PackWeightA(m, k, a.data(), k, packed_a.data());
+  gemm.PackWeightB(k, n, b.data(), n, packed_b.data());
+  std::vector<half> half_a(packed_a_size), half_b(packed_b_size);
+  FloatToHalf(packed_a.data(), half_a.data(), packed_a_size);
+  FloatToHalf(packed_b.data(), half_b.data(), packed_b_size);
+
+  const auto identity = MakeEpilogue();
+  std::vector<float> workspace(gemm.PackedAWorkspaceSize(m, n, k, true));
+  gemm.SgemmPackedA(m, n, k, packed_a.data(), b.data(), n, c1.data(), n,
+                    identity, workspace.data());
+  gemm.SgemmPackedA(m, n, k, half_a.data(), b.data(), n, c.data(), n,
+                    identity, workspace.data());
+  int neq = c == c1 ? 0 : 1;
+
+  workspace.resize(gemm.PackedBWorkspaceSize(m, n, k, true));
+  gemm.SgemmPackedB(m, n, k, a.data(), k, packed_b.data(), c1.data(), n,
+                    identity, workspace.data());
+  gemm.SgemmPackedB(m, n, k, a.data(), k, half_b.data(), c.data(), n,
+                    identity, workspace.data());
+  neq += c == c1 ? 0 : 1;
+
+  std::cout << "half mnk=" << m << " " << n << " " << k << " neq=" << neq
+            << std::endl;
+  PADDLE_MOBILE_ENFORCE(neq == 0, "The execution of do_sgemm_half is failed!");
+  return 0;
+}
+
+// the rounding of float to half, and every half back and forth
+int do_half_convert() {
+  const float tiny = 1.f / 16777216;  // 2^-24, the smallest half
+  // ties round to the even half
+  const std::vector<float> values = {0.f,
+                                     -0.f,
+                                     1.f,
+                                     -2.f,
+                                     65504.f,
+                                     65519.f,
+                                     65520.f,
+                                     std::numeric_limits<float>::infinity(),
+                                     tiny,
+                                     tiny / 2,
+                                     tiny * 3 / 2,
+                                     tiny * 1024,
+                                     1 + tiny * 16384,
+                                     1 + tiny * 8192,
+                                     1 + tiny * 24576};
+  const std::vector<uint16_t> expected = {
+      0x0000, 0x8000, 0x3c00, 0xc000, 0x7bff, 0x7bff, 0x7c00, 0x7c00,
+      0x0001, 0x0000, 0x0002, 0x0400, 0x3c01, 0x3c00, 0x3c02};
+  std::vector<half> halves(values.size());
+  FloatToHalf(values.data(), halves.data(), values.size());
+  int neq = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    neq += static_cast<uint16_t>(halves[i]) == expected[i] ? 0 : 1;
+  }
+
+  std::vector<half> all;
+  for (int h = 0; h < 65536; ++h) {
+    // skip NaN, whose payload may change
+    if ((h & 0x7c00) != 0x7c00 || (h & 0x3ff) == 0) {
+      all.push_back(static_cast<half>(h));
+    }
+  }
+  std::vector<float> floats(all.size());
+  std::vector<half> back(all.size());
+  HalfToFloat(all.data(), floats.data(), all.size());
+  FloatToHalf(floats.data(), back.data(), all.size());
+  neq += all == back ? 0 : 1;
+
+  std::cout << "half convert neq=" << neq << std::endl;
+  PADDLE_MOBILE_ENFORCE(neq == 0,
+                        "The execution of do_half_convert is failed!");
+  return 0;
+}
+
+// compare the implicit gemm conv against the packed gemm of an explicit col
+int do_sgemm_im2col(int channels, int height, int width, int out_channels,
+                    int kernel, int stride, int pad, int dilation) {
+  int extent = dilation * (kernel - 1) + 1;
+  int out_h = (height + 2 * pad - extent) / stride + 1;
+  int out_w = (width + 2 * pad - extent) / stride + 1;
+  int m = out_channels;
+  int n = out_h * out_w;
+  int k = channels * kernel * kernel;
+  std::vector<float> input(channels * height * width), a(m * k), col(k * n);
+  std::vector<float> c(m * n), c1(m * n);
+  for (auto &v : input) v = -4 + rand() % 10;
+  for (auto &v : a) v = -4 + rand() % 10;
+  for (int r = 0; r < k; ++r) {
+    int ch = r / (kernel * kernel);
+    int ki = r / kernel % kernel;
+    int kj = r % kernel;
+    for (int j = 0; j < n; ++j) {
+      int ih = j / out_w * stride - pad + ki * dilation;
+      int iw = j % out_w * stride - pad + kj * dilation;
+      bool inside = ih >= 0 && ih < height && iw >= 0 && iw < width;
+      col[r * n + j] =
+          inside ? input[(ch * height + ih) * width + iw] : 0.f;
+    }
+  }
+
+  paddle_mobile::operators::math::Im2ColGeometry geo;
+  geo.input = input.data();
+  geo.height = height;
+  geo.width = width;
+  geo.kernel_h = geo.kernel_w = kernel;
+  geo.stride_h = geo.stride_w = stride;
+  geo.pad_h = geo.pad_w = pad;
+  geo.dilation_h = geo.dilation_w = dilation;
+  geo.output_w = out_w;
+
+  Gemm gemm;
+  std::vector<float> packed_a(Gemm::PackedASize(m, k));
+  gemm.PackWeightA(m, k, a.data(), k, packed_a.data());
+  std::vector<float> workspace(gemm.PackedAWorkspaceSize(m, n, k));
+  gemm.SgemmPackedA(m, n, k, packed_a.data(), col.data(), n, c1.data(), n,
+                    MakeEpilogue(), workspace.data());
+  gemm.SgemmPackedAIm2Col(m, n, k, packed_a.data(), geo, c.data(), n,
+                          MakeEpilogue(), workspace.data());
+  int neq = count_neq(c, c1);
+  std::cout << "conv c=" << channels << " h=" << height << " w=" << width
+            << " oc=" << out_channels << " k=" << kernel << " s=" << stride
+            << " p=" << pad << " d=" << dilation << " neq=" << neq
+            << std::endl;
+  PADDLE_MOBILE_ENFORCE(neq == 0,
+                        "The execution of do_sgemm_im2col is failed!");
+  return 0;
+}
+
+// compare bias -> scale and shift -> residual -> activation composed in the
+// write back of the gemm against applying them one by one
+int do_sgemm_epilogue(int m, int n, int k) {
+  std::vector<float> a(m * k), b(k * n), bias(m), scale(m), shift(m);
+  std::vector<float> residual(m * n), c(m * n), c1(m * n), c2(m * n);
+  for (auto &v : a) v = -4 + rand() % 10;
+  for (auto &v : b) v = -4 + rand() % 10;
+  for (auto &v : bias) v = -4 + rand() % 10;
+  for (auto &v : scale) v = (rand() % 5) * 0.25f;
+  for (auto &v : shift) v = -2 + rand() % 5;
+  for (auto &v : residual) v = -8 + rand() % 17;
+
+  Gemm gemm;
+  std::vector<float> packed_a(Gemm::PackedASize(m, k));
+  gemm.PackWeightA(m, k, a.data(), k, packed_a.data());
+  std::vector<float> workspace(gemm.PackedAWorkspaceSize(m, n, k));
+  gemm.SgemmPackedA(m, n, k, packed_a.data(), b.data(), n, c1.data(), n,
+                    MakeEpilogue(), workspace.data());
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      float v = (c1[i * n + j] + bias[i]) * scale[i] + shift[i] +
+                residual[i * n + j];
+      c1[i * n + j] = std::min(std::max(v, 0.f), 6.f);
+      c2[i * n + j] = v < 0 ? v * 0.5f : v;
+    }
+  }
+
+  const epilogue::RowBias row_bias{bias.data()};
+  const epilogue::RowScaleShift bn{scale.data(), shift.data()};
+  const epilogue::Residual add{residual.data(), n};
+  gemm.SgemmPackedA(
+      m, n, k, packed_a.data(), b.data(), n, c.data(), n,
+      MakeEpilogue(row_bias, bn, add,
+                   epilogue::Activation<paddle_mobile::RELU6>{}),
+      workspace.data());
+  int neq = count_neq(c, c1);
+  gemm.SgemmPackedA(
+      m, n, k, packed_a.data(), b.data(), n, c.data(), n,
+      MakeEpilogue(row_bias, bn, add,
+                   epilogue::Activation<paddle_mobile::LEAKY_RELU>{0.5f}),
+      workspace.data());
+  neq += count_neq(c, c2);
+  std::cout << "epilogue mnk=" << m << " " << n << " " << k << " neq=" << neq
+            << std::endl;
+  PADDLE_MOBILE_ENFORCE(neq == 0,
+                        "The execution of do_sgemm_epilogue is failed!");
+  return 0;
+}
+
+// the gemm with the k blocks and the micro kernels GemmTuner may pick
+// against the plain loops, the first k block adds bias or the old c and the
+// last one applies relu
+int do_sgemm_blocking(int m, int n, int k, bool relu) {
+  std::vector<float> a(m * k), b(k * n), bias(m);
+  std::vector<float> c0(m * n), expect_bias(m * n), expect_add(m * n);
+  for (auto &v : a) v = -4 + rand() % 10;
+  for (auto &v : b) v = -4 + rand() % 10;
+  for (auto &v : bias) v = rand() % 10;
+  for (auto &v : c0) v = -8 + rand() % 10;
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      float sum = 0;
+      for (int p = 0; p < k; ++p) {
+        sum += a[i * k + p] * b[p * n + j];
+      }
+      expect_bias[i * n + j] = sum + bias[i];
+      expect_add[i * n + j] = sum + c0[i * n + j];
+      if (relu) {
+        expect_bias[i * n + j] = std::max(expect_bias[i * n + j], 0.f);
+        expect_add[i * n + j] = std::max(expect_add[i * n + j], 0.f);
+      }
+    }
+  }
+
+  int neq = 0;
+  for (int kc : {0, 64}) {
+    for (int micro_kernel :
+         {Gemm::MICRO_KERNEL_DEFAULT, Gemm::MICRO_KERNEL_ALT}) {
+      GemmBlocking blocking;
+      blocking.kc = kc;
+      blocking.micro_kernel = micro_kernel;
+      for (bool omp : {false, true}) {
+        Gemm gemm;
+        gemm.SetBlocking(blocking);
+        std::vector<float> c(m * n);
+        if (omp) {
+          gemm.Sgemm_omp(m, n, k, 1, a.data(), k, b.data(), n, 0, c.data(), n,
+                         relu, bias.data());
+        } else {
+          gemm.Sgemm(m, n, k, 1, a.data(), k, b.data(), n, 0, c.data(), n,
+                     relu, bias.data());
+        }
+        neq += count_neq(c, expect_bias);
+        c = c0;
+        if (omp) {
+          gemm.Sgemm_omp(m, n, k, 1, a.data(), k, b.data(), n, 1, c.data(), n,
+                         relu, nullptr);
+        } else {
+          gemm.Sgemm(m, n, k, 1, a.data(), k, b.data(), n, 1, c.data(), n,
+                     relu, nullptr);
+        }
+        neq += count_neq(c, expect_add);
+      }
+    }
+  }
+
+  std::cout << "blocking mnk=" << m << " " << n << " " << k
+            << " relu=" << relu << " neq=" << neq << std::endl;
+  PADDLE_MOBILE_ENFORCE(neq == 0,
+                        "The execution of do_sgemm_blocking is failed!");
+  return 0;
+}
+
+int main() {
+  do_sgemm_packed(9, 9, 9, true);
+  do_sgemm_packed(10, 6, 12, false);
+  do_sgemm_packed(64, 3136, 27, true);
+  do_sgemm_packed(512, 256, 384, false);
+  do_sgemm_packed(1255, 755, 333, true);
+  do_sgemm_packed(2, 1000, 1024, false);
+
+  do_sgemm_compressed(9, 9, 9);
+  do_sgemm_compressed(64, 3136, 27);
+  do_sgemm_compressed(1255, 75, 333);
+  do_sgemm_compressed(1, 1000, 1024);
+
+  do_half_convert();
+  do_sgemm_half(9, 9, 9);
+  do_sgemm_half(64, 3136, 27);
+  do_sgemm_half(1255, 75, 333);
+  do_sgemm_half(1, 1000, 1024);
+
+  do_sgemm_im2col(3, 33, 35, 16, 3, 1, 1, 1);
+  do_sgemm_im2col(16, 28, 28, 4, 3, 2, 1, 1);
+  do_sgemm_im2col(8, 17, 19, 24, 3, 1, 2, 2);
+  do_sgemm_im2col(32, 14, 14, 64, 1, 1, 0, 1);
+  do_sgemm_im2col(5, 20, 11, 7, 5, 1, 2, 1);
+  do_sgemm_im2col(3, 57, 45, 8, 7, 2, 3, 1);
+
+  do_sgemm_epilogue(9, 9, 9);
+  do_sgemm_epilogue(37, 53, 29);
+  do_sgemm_epilogue(128, 300, 64);
+
+  do_sgemm_blocking(9, 9, 9, true);
+  do_sgemm_blocking(37, 53, 200, false);
+  do_sgemm_blocking(130, 45, 129, true);
+  do_sgemm_blocking(23, 300, 257, false);
+  return 0;
+}
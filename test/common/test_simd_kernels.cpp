@@ -0,0 +1,180 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "common/cpu_info.h"
+#include "common/enforce.h"
+#include "operators/math/depthwise_conv3x3.h"
+#include "operators/math/pooling.h"
+#include "operators/math/softmax.h"
+
+using paddle_mobile::framework::Tensor;
+using paddle_mobile::framework::make_ddim;
+namespace math = paddle_mobile::operators::math;
+
+// the simd kernels, avx2 on x86 hosts which support it, against plain loops
+
+void Random(Tensor *tensor, int range) {
+  float *data = tensor->mutable_data<float>();
+  for (int i = 0; i < tensor->numel(); ++i) {
+    data[i] = (rand() % (2 * range + 1) - range) / 7.f;  // NOLINT
+  }
+}
+
+void Compare(const char *name, const Tensor &expect, const Tensor &actual) {
+  for (int i = 0; i < expect.numel(); ++i) {
+    float diff = std::fabs(expect.data<float>()[i] - actual.data<float>()[i]);
+    PADDLE_MOBILE_ENFORCE(diff < 1e-3, "%s mismatch at %d: %f vs %f", name, i,
+                          expect.data<float>()[i], actual.data<float>()[i]);
+  }
+}
+
+void DepthwiseReference(const Tensor &input, const Tensor &filter, int stride,
+                        int padding, const float *scale, const float *bias,
+                        bool relu, Tensor *output) {
+  const int channels = input.dims()[1];
+  const int h = input.dims()[2];
+  const int w = input.dims()[3];
+  const int out_h = output->dims()[2];
+  const int out_w = output->dims()[3];
+  const float *x = input.data<float>();
+  const float *k = filter.data<float>();
+  float *y = output->mutable_data<float>();
+  for (int n = 0; n < input.dims()[0] * channels; ++n) {
+    const int c = n % channels;
+    for (int oh = 0; oh < out_h; ++oh) {
+      for (int ow = 0; ow < out_w; ++ow) {
+        float acc = 0.f;
+        for (int i = 0; i < 3; ++i) {
+          for (int j = 0; j < 3; ++j) {
+            int ih = oh * stride - padding + i;
+            int iw = ow * stride - padding + j;
+            if (ih >= 0 && ih < h && iw >= 0 && iw < w) {
+              acc += x[(n * h + ih) * w + iw] * k[c * 9 + i * 3 + j];
+            }
+          }
+        }
+        acc = acc * (scale ? scale[c] : 1.f) + (bias ? bias[c] : 0.f);
+        y[(n * out_h + oh) * out_w + ow] = relu ? std::max(acc, 0.f) : acc;
+      }
+    }
+  }
+}
+
+void TestDepthwise(int batch, int channels, int h, int w) {
+  Tensor input, filter, scale, bias;
+  input.Resize(make_ddim({batch, channels, h, w}));
+  filter.Resize(make_ddim({channels, 1, 3, 3}));
+  scale.Resize(make_ddim({channels}));
+  bias.Resize(make_ddim({channels}));
+  Random(&input, 50);
+  Random(&filter, 10);
+  Random(&scale, 10);
+  Random(&bias, 10);
+  for (int relu = 0; relu < 2; ++relu) {
+    Tensor expect, actual;
+    expect.Resize(make_ddim({batch, channels, h, w}));
+    actual.Resize(expect.dims());
+    DepthwiseReference(input, filter, 1, 1, nullptr, bias.data<float>(), relu,
+                       &expect);
+    math::DepthwiseConv3x3s1p1(&input, &filter, &actual, &bias, true, relu);
+    Compare("depthwise s1p1", expect, actual);
+    DepthwiseReference(input, filter, 1, 1, scale.data<float>(),
+                       bias.data<float>(), relu, &expect);
+    math::DepthwiseConvAddBNRelu3x3s1p1(&input, &filter, &actual, &scale,
+                                        &bias, relu);
+    Compare("depthwise bn s1p1", expect, actual);
+
+    expect.Resize(make_ddim({batch, channels, (h + 1) / 2, (w + 1) / 2}));
+    actual.Resize(expect.dims());
+    DepthwiseReference(input, filter, 2, 1, nullptr, bias.data<float>(), relu,
+                       &expect);
+    math::DepthwiseConv3x3s2p1v2(&input, &filter, &actual, &bias, true, relu);
+    Compare("depthwise s2p1", expect, actual);
+    DepthwiseReference(input, filter, 2, 1, scale.data<float>(),
+                       bias.data<float>(), relu, &expect);
+    math::DepthwiseConvAddBNRelu3x3s2p1v2(&input, &filter, &actual, &scale,
+                                          &bias, relu);
+    Compare("depthwise bn s2p1", expect, actual);
+  }
+}
+
+template <paddle_mobile::PoolingType P, int Stride>
+void TestPooling3x3(const Tensor &input, int padding) {
+  const int h = input.dims()[2];
+  const int w = input.dims()[3];
+  Tensor expect, actual;
+  expect.Resize(make_ddim({input.dims()[0], input.dims()[1],
+                           (h + 2 * padding - 3) / Stride + 1,
+                           (w + 2 * padding - 3) / Stride + 1}));
+  actual.Resize(expect.dims());
+  math::Pooling<P>()(input, {3, 3}, {Stride, Stride}, {padding, padding},
+                     &expect);
+  math::Pooling3x3<P, Stride>()(input, {padding, padding}, &actual);
+  Compare("pooling 3x3", expect, actual);
+}
+
+void TestSoftmax(int classes) {
+  Tensor input, output;
+  input.Resize(make_ddim({2, classes}));
+  output.Resize(input.dims());
+  Random(&input, 500);
+  math::SoftmaxFuntor<paddle_mobile::CPU, float>()(&input, &output);
+  const float *x = input.data<float>();
+  for (int b = 0; b < 2; ++b, x += classes) {
+    float max = x[0];
+    for (int i = 0; i < classes; ++i) {
+      max = std::max(max, x[i]);
+    }
+    double sum = 0;
+    for (int i = 0; i < classes; ++i) {
+      sum += std::exp(x[i] - max);
+    }
+    for (int i = 0; i < classes; ++i) {
+      float expect = std::exp(x[i] - max) / sum;
+      float diff = std::fabs(expect - output.data<float>()[b * classes + i]);
+      PADDLE_MOBILE_ENFORCE(diff < 1e-5, "softmax mismatch at %d", i);
+    }
+  }
+}
+
+int main() {
+  const paddle_mobile::CPUInfo &info = paddle_mobile::GetCPUInfo();
+  std::cout << "avx2: " << info.avx2 << " fma: " << info.fma << std::endl;
+
+  TestDepthwise(1, 8, 14, 14);
+  TestDepthwise(2, 4, 28, 28);
+  TestDepthwise(1, 3, 19, 35);
+
+  for (int h : {7, 14, 33}) {
+    Tensor input;
+    input.Resize(make_ddim({2, 3, h, h + 5}));
+    Random(&input, 100);
+    for (int padding = 0; padding < 2; ++padding) {
+      TestPooling3x3<paddle_mobile::MAX, 1>(input, padding);
+      TestPooling3x3<paddle_mobile::AVG, 1>(input, padding);
+      TestPooling3x3<paddle_mobile::MAX, 2>(input, padding);
+      TestPooling3x3<paddle_mobile::AVG, 2>(input, padding);
+    }
+  }
+
+  for (int classes : {1, 7, 8, 100, 1001}) {
+    TestSoftmax(classes);
+  }
+  std::cout << "simd kernels passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,110 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "common/common.h"
+#include "common/enforce.h"
+#include "common/threadpool.h"
+
+using paddle_mobile::ThreadPool;
+using paddle_mobile::parallel_for;
+using paddle_mobile::parallel_for_tid;
+
+// every index runs exactly once on a valid thread id
+void check_cover(int threads, int n) {
+  std::vector<int> count(n, 0);
+  std::vector<int> tids(n, -1);
+  parallel_for_tid(0, n, [&](int i, int tid) {
+    count[i] += 1;
+    tids[i] = tid;
+  });
+  for (int i = 0; i < n; ++i) {
+    PADDLE_MOBILE_ENFORCE(count[i] == 1, "index %d ran %d times", i,
+                          count[i]);
+    PADDLE_MOBILE_ENFORCE(tids[i] >= 0 && tids[i] < threads,
+                          "invalid thread id %d", tids[i]);
+  }
+}
+
+int main() {
+  for (int threads : {1, 2, 4, 3}) {
+    ThreadPool::Instance()->SetThreadNum(threads);
+    for (int n : {0, 1, 5, 64, 1001}) {
+      check_cover(threads, n);
+    }
+
+    // nested regions run serially on the calling thread
+    std::vector<int> nested(16 * 16, 0);
+    parallel_for(0, 16, [&](int i) {
+      parallel_for(0, 16, [&](int j) { nested[i * 16 + j] += 1; });
+    });
+    for (int v : nested) {
+      PADDLE_MOBILE_ENFORCE(v == 1, "nested region is wrong");
+    }
+
+    // regions issued from two threads at the same time
+    std::vector<int> a(1000, 0), b(1000, 0);
+    std::thread other([&] {
+      for (int r = 0; r < 100; ++r) {
+        parallel_for(0, 1000, [&](int i) { a[i] += 1; });
+      }
+    });
+    for (int r = 0; r < 100; ++r) {
+      parallel_for(0, 1000, [&](int i) { b[i] += 1; });
+    }
+    other.join();
+    for (int i = 0; i < 1000; ++i) {
+      PADDLE_MOBILE_ENFORCE(a[i] == 100 && b[i] == 100,
+                            "concurrent region is wrong");
+    }
+
+#ifdef ENABLE_EXCEPTION
+    // a throwing share, on the caller or on a worker, reaches the caller
+    // after the region ends and leaves the pool usable
+    for (int thrower : {0, threads - 1}) {
+      bool caught = false;
+      try {
+        parallel_for_tid(0, threads, [&](int i, int tid) {
+          PADDLE_MOBILE_ENFORCE(tid != thrower, "share %d throws", tid);
+        });
+      } catch (const paddle_mobile::PaddleMobileException &e) {
+        caught = true;
+      }
+      PADDLE_MOBILE_ENFORCE(caught, "exception of share %d is lost",
+                            thrower);
+      // the workers take their shares again instead of the caller
+      std::vector<std::thread::id> ids(threads);
+      parallel_for(0, threads,
+                   [&](int i) { ids[i] = std::this_thread::get_id(); });
+      for (int i = 1; i < threads; ++i) {
+        PADDLE_MOBILE_ENFORCE(ids[i] != std::this_thread::get_id(),
+                              "region runs serially after an exception");
+      }
+    }
+#endif
+
+    const int repeats = 1000;
+    auto time1 = paddle_mobile::time();
+    for (int r = 0; r < repeats; ++r) {
+      parallel_for(0, threads, [](int i) {});
+    }
+    auto time2 = paddle_mobile::time();
+    std::cout << threads << " threads, empty region cost: "
+              << paddle_mobile::time_diff(time1, time2) * 1000 / repeats
+              << "us" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,185 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include "../program_for_test.h"
+#include "../test_helper.h"
+#include "../test_include.h"
+#include "framework/calibrator.h"
+#include "framework/loader.h"
+
+using paddle_mobile::framework::Histogram;
+
+int TestHistogram() {
+  // gaussian activations with a few large outliers
+  std::vector<float> values(100000);
+  for (size_t i = 0; i < values.size(); ++i) {
+    float u1 = (i % 997 + 0.5f) / 997.f;
+    float u2 = (i % 991 + 0.5f) / 991.f;
+    values[i] = std::sqrt(-2.f * std::log(u1)) * std::cos(6.2831853f * u2);
+  }
+  values[7] = 40.f;
+  values[77] = -60.f;
+
+  Histogram histogram;
+  // add in two parts, the second one widens the range
+  histogram.Add(values.data(), 50);
+  histogram.Add(values.data() + 50, values.size() - 50);
+
+  if (histogram.Max() != 60.f) {
+    std::cout << "max " << histogram.Max() << " != 60" << std::endl;
+    return 1;
+  }
+  float percentile = histogram.PercentileThreshold(0.999f);
+  if (percentile < 2.f || percentile > 5.f) {
+    std::cout << "percentile threshold " << percentile << std::endl;
+    return 1;
+  }
+  // the outliers must be clipped, the gaussian body kept
+  float kl = histogram.KLThreshold();
+  if (kl < 1.f || kl > 20.f) {
+    std::cout << "kl threshold " << kl << std::endl;
+    return 1;
+  }
+  std::cout << "percentile: " << percentile << ", kl: " << kl << std::endl;
+  return 0;
+}
+
+// a program written by the model writer loads as the same ops, variables
+// and weights, and predicts as the program before the write
+int TestModelWriter() {
+  ProgramForTest program;
+  program.AddConvNet();
+  program.Save("writer_model", "writer_params");
+
+  paddle_mobile::framework::Loader<paddle_mobile::CPU> loader;
+  auto loaded = loader.Load(std::string("writer_model"),
+                            std::string("writer_params"), false);
+  auto expect_block = program.Desc()->Block(0);
+  auto block = loaded.originProgram->Block(0);
+  auto expect_ops = expect_block->Ops();
+  auto ops = block->Ops();
+  if (ops.size() != expect_ops.size()) {
+    std::cout << "ops: " << ops.size() << " != " << expect_ops.size()
+              << std::endl;
+    return 1;
+  }
+  for (int i = 0; i < ops.size(); ++i) {
+    if (ops[i]->Type() != expect_ops[i]->Type() ||
+        ops[i]->GetInputs() != expect_ops[i]->GetInputs() ||
+        ops[i]->GetOutputs() != expect_ops[i]->GetOutputs()) {
+      std::cout << "op " << i << " " << ops[i]->Type() << " is written wrong"
+                << std::endl;
+      return 1;
+    }
+  }
+  auto expect_vars = expect_block->Vars();
+  auto vars = block->Vars();
+  if (vars.size() != expect_vars.size()) {
+    std::cout << "vars: " << vars.size() << " != " << expect_vars.size()
+              << std::endl;
+    return 1;
+  }
+  for (int i = 0; i < vars.size(); ++i) {
+    if (vars[i]->Name() != expect_vars[i]->Name() ||
+        vars[i]->Persistable() != expect_vars[i]->Persistable() ||
+        vars[i]->Tensor_desc().Dims() !=
+            expect_vars[i]->Tensor_desc().Dims()) {
+      std::cout << "var " << vars[i]->Name() << " is written wrong"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // the executor reads the weights from the combined params
+  paddle_mobile::PaddleMobileConfigInternal config;
+  paddle_mobile::framework::Executor<paddle_mobile::CPU> executor(
+      loaded, config, 1, false);
+  for (const char *name : {"w0", "w1"}) {
+    const auto &expect = program.Param(name);
+    auto *weight = loaded.scope->FindVar(name)->GetMutable<LoDTensor>();
+    if (weight->dims() != expect.dims() ||
+        memcmp(weight->data<float>(), expect.data<float>(),
+               expect.memory_size()) != 0) {
+      std::cout << "weight " << name << " is written wrong" << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<int64_t> dims{1, 4, 8, 8};
+  std::vector<float> input = ProgramForTest::Input(dims);
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile;
+  if (!program.Load(&paddle_mobile, false)) {
+    return 1;
+  }
+  return CompareOutputs(paddle_mobile.Predict(input, dims),
+                        executor.Predict(input, dims))
+             ? 0
+             : 1;
+}
+
+int TestMobilenet() {
+  std::vector<int64_t> dims{1, 3, 224, 224};
+  paddle_mobile::framework::Tensor input;
+  GetInput<float>(g_test_image_1x3x224x224_banana, &input,
+                  paddle_mobile::framework::make_ddim(dims));
+
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile;
+  paddle_mobile.SetThreadNum(1);
+  if (!paddle_mobile.Load(g_mobilenet, true)) {
+    return 1;
+  }
+  paddle_mobile.Predict(input);
+  auto fp32_output = paddle_mobile.Fetch();
+
+  paddle_mobile::framework::CalibrationConfig config;
+  paddle_mobile::framework::Calibrator calibrator(g_mobilenet, config);
+  calibrator.Collect(input);
+  calibrator.Save("mobilenet_int8_model", "mobilenet_int8_params");
+
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> int8_mobile;
+  int8_mobile.SetThreadNum(1);
+  if (!int8_mobile.Load(std::string("mobilenet_int8_model"),
+                        std::string("mobilenet_int8_params"), true)) {
+    return 1;
+  }
+  int8_mobile.Predict(input);
+  auto int8_output = int8_mobile.Fetch();
+  int fp32_top = 0, int8_top = 0;
+  for (int i = 1; i < fp32_output->numel(); ++i) {
+    if (fp32_output->data<float>()[i] > fp32_output->data<float>()[fp32_top]) {
+      fp32_top = i;
+    }
+    if (int8_output->data<float>()[i] > int8_output->data<float>()[int8_top]) {
+      int8_top = i;
+    }
+  }
+  std::cout << "fp32 top1: " << fp32_top << ", int8 top1: " << int8_top
+            << std::endl;
+  return fp32_top == int8_top ? 0 : 1;
+}
+
+int main() {
+  if (TestHistogram() != 0 || TestModelWriter() != 0) {
+    return 1;
+  }
+  if (!FileExists(std::string(g_mobilenet) + "/__model__")) {
+    std::cout << "calibrator passed, " << g_mobilenet << " is missing"
+              << std::endl;
+    return 0;
+  }
+  return TestMobilenet();
+}
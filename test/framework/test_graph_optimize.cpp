@@ -0,0 +1,184 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include "../program_for_test.h"
+#include "../test_helper.h"
+#include "../test_include.h"
+#include "framework/graph_optimize.h"
+
+// a conv, its bias, a batch norm and a relu
+static void AddConvBNRelu(ProgramForTest *program) {
+  program->AddVar("x", {1, 4, 8, 8});
+  program->AddParam("w", {6, 4, 3, 3});
+  program->AddParam("bias", {6});
+  program->AddParam("mean", {6});
+  program->AddParam("variance", {6}, 0.5f, 2.f);
+  program->AddParam("scale", {6}, 0.5f, 1.5f);
+  program->AddParam("shift", {6});
+  for (const char *name : {"c", "cb", "y", "r"}) {
+    program->AddVar(name, {1, 6, 8, 8});
+  }
+  program->AddFeed("x");
+  program->AddConv("x", "w", "c");
+  paddle_mobile::framework::AttributeMap attrs;
+  attrs["axis"].Set<int>(1);
+  attrs["epsilon"].Set<float>(1e-5f);
+  attrs["momentum"].Set<float>(0.9f);
+  program->AddOp("elementwise_add", {{"X", {"c"}}, {"Y", {"bias"}}},
+                 {{"Out", {"cb"}}}, attrs);
+  program->AddOp("batch_norm",
+                 {{"X", {"cb"}},
+                  {"Mean", {"mean"}},
+                  {"Variance", {"variance"}},
+                  {"Scale", {"scale"}},
+                  {"Bias", {"shift"}}},
+                 {{"Y", {"y"}}}, attrs);
+  program->AddOp("relu", {{"X", {"y"}}}, {{"Out", {"r"}}});
+  program->AddFetch("r");
+}
+
+// the pass leaves one conv whose filter and bias apply the batch norm, the
+// weights of the batch norm are dropped
+static bool TestFoldBatchNorm() {
+#if defined(FUSION_CONVADD_OP) && defined(FUSION_CONVADDRELU_OP)
+  ProgramForTest program;
+  AddConvBNRelu(&program);
+  auto scope = std::make_shared<paddle_mobile::framework::Scope>();
+  program.ShareParams(scope.get());
+  auto weight = [&](const std::string &name) {
+    return scope->FindVar(name)->GetMutable<LoDTensor>()->data<float>();
+  };
+  // the pass erases the folded weights from the scope
+  std::map<std::string, const float *> weights;
+  for (const char *name : {"w", "bias", "mean", "variance", "scale", "shift"}) {
+    weights[name] = weight(name);
+  }
+  paddle_mobile::framework::GraphOptPass pass(scope);
+  auto block = program.Desc()->Block(0);
+  pass(block);
+
+  auto ops = block->Ops();
+  if (ops.size() != 3 || ops[1]->Type() != "fusion_conv_add_relu" ||
+      ops[1]->Output("Out")[0] != "r") {
+    std::cout << "the conv, batch norm and relu are not fused" << std::endl;
+    return false;
+  }
+  for (const auto &var_desc : block->Vars()) {
+    if (weights.count(var_desc->Name())) {
+      std::cout << var_desc->Name() << " is not dropped" << std::endl;
+      return false;
+    }
+  }
+  const float *folded_w = weight(ops[1]->Input("Filter")[0]);
+  const float *folded_bias = weight(ops[1]->Input("Y")[0]);
+  const int size = 4 * 3 * 3;
+  for (int c = 0; c < 6; ++c) {
+    float scale =
+        weights["scale"][c] / std::sqrt(weights["variance"][c] + 1e-5f);
+    float bias =
+        (weights["bias"][c] - weights["mean"][c]) * scale + weights["shift"][c];
+    for (int i = c * size; i < (c + 1) * size; ++i) {
+      if (std::abs(folded_w[i] - weights["w"][i] * scale) > 1e-5f) {
+        std::cout << "filter of channel " << c << " is folded wrong"
+                  << std::endl;
+        return false;
+      }
+    }
+    if (std::abs(folded_bias[c] - bias) > 1e-5f) {
+      std::cout << "bias of channel " << c << " is folded wrong" << std::endl;
+      return false;
+    }
+  }
+#endif
+  return true;
+}
+
+// the folded net predicts as the one run op by op
+static bool TestPredict() {
+  ProgramForTest program;
+  AddConvBNRelu(&program);
+  std::vector<int64_t> dims{1, 4, 8, 8};
+  std::vector<float> input = ProgramForTest::Input(dims);
+  std::vector<std::vector<float>> outputs;
+  for (bool graph_optimization : {false, true}) {
+    paddle_mobile::PaddleMobileConfigInternal config;
+    config.graph_optimization = graph_optimization;
+    paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile(config);
+    if (!program.Load(&paddle_mobile, false)) {
+      return false;
+    }
+    outputs.push_back(paddle_mobile.Predict(input, dims));
+  }
+  return CompareOutputs(outputs[0], outputs[1], 1e-4f, true);
+}
+
+// the outputs of the graph optimization must match the unfused program up
+// to rounding
+int TestGraphOptimize(const char *model) {
+  std::vector<float> input;
+  std::vector<int64_t> dims{1, 3, 224, 224};
+  GetInput<float>(g_test_image_1x3x224x224_banana, &input, dims);
+
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile;
+  paddle_mobile.SetThreadNum(4);
+  if (!paddle_mobile.Load(model, false)) {
+    return 1;
+  }
+  auto time1 = time();
+  auto expect = paddle_mobile.Predict(input, dims);
+  auto time2 = time();
+
+  paddle_mobile::PaddleMobileConfigInternal config;
+  config.graph_optimization = true;
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile_opt(config);
+  paddle_mobile_opt.SetThreadNum(4);
+  if (!paddle_mobile_opt.Load(model, false)) {
+    return 1;
+  }
+  paddle_mobile_opt.Predict(input, dims);
+  auto time3 = time();
+  auto result = paddle_mobile_opt.Predict(input, dims);
+  auto time4 = time();
+
+  if (!CompareOutputs(expect, result, 1e-4f, true)) {
+    return 1;
+  }
+  std::cout << model << " predict cost: " << time_diff(time1, time2)
+            << "ms, with graph optimization: " << time_diff(time3, time4)
+            << "ms" << std::endl;
+  return 0;
+}
+
+int main() {
+  if (!TestFoldBatchNorm() || !TestPredict()) {
+    return 1;
+  }
+  if (!FileExists(std::string(g_mobilenet) + "/__model__") ||
+      !FileExists(std::string(g_resnet_50) + "/__model__")) {
+    std::cout << "graph optimize passed, " << g_mobilenet << " or "
+              << g_resnet_50 << " is missing" << std::endl;
+    return 0;
+  }
+  // the batch norms of mobilenet are folded into the conv filters, the
+  // shortcut adds and relus of resnet are applied by the convs
+  if (TestGraphOptimize(g_mobilenet) != 0 ||
+      TestGraphOptimize(g_resnet_50) != 0) {
+    return 1;
+  }
+  std::cout << "graph optimize passed" << std::endl;
+  return 0;
+}
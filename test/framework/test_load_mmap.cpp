@@ -0,0 +1,133 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cstdio>
+#include <iostream>
+#include "../program_for_test.h"
+#include "../test_helper.h"
+#include "../test_include.h"
+#include "common/util.h"
+
+// the mapping has the bytes of the file, its pages are private so writing
+// them leaves the file alone, and a tensor over it keeps it mapped
+static bool TestMapFile() {
+  const std::string path = "./mmap_test.bin";
+  std::string content(10000, 0);
+  for (int i = 0; i < content.size(); ++i) {
+    content[i] = static_cast<char>(i * 7);
+  }
+  paddle_mobile::framework::WriteFile(path, content);
+  size_t size = 0;
+  std::shared_ptr<char> mapped = paddle_mobile::MapFileToBuff(path, &size);
+  if (mapped == nullptr || size != content.size() ||
+      std::string(mapped.get(), size) != content) {
+    std::cout << "mapped bytes differ from the file" << std::endl;
+    return false;
+  }
+  mapped.get()[0] = content[0] + 1;
+  char *reread = paddle_mobile::ReadFileToBuff(path);
+  bool unchanged = reread[0] == content[0];
+  delete[] reread;
+  remove(path.c_str());
+  if (!unchanged) {
+    std::cout << "writing the mapping changed the file" << std::endl;
+    return false;
+  }
+
+  Tensor tensor;
+  tensor.Resize(paddle_mobile::framework::make_ddim({2000}));
+  tensor.ShareExternalData(mapped.get() + 16, 2000 * sizeof(float),
+                           typeid(float), mapped);
+  if (tensor.data<float>() !=
+          reinterpret_cast<float *>(mapped.get() + 16) ||
+      mapped.use_count() != 2) {
+    std::cout << "the tensor does not refer to the mapping" << std::endl;
+    return false;
+  }
+  tensor = Tensor();
+  if (mapped.use_count() != 1) {
+    std::cout << "the tensor keeps the mapping" << std::endl;
+    return false;
+  }
+  return paddle_mobile::MapFileToBuff(path, &size) == nullptr;
+}
+
+// a small net loaded with mmap predicts as one loaded from the heap
+static bool TestPredict() {
+  ProgramForTest program;
+  program.AddConvNet();
+  const std::string model_path = "./mmap_test.model";
+  const std::string params_path = "./mmap_test.params";
+  program.Save(model_path, params_path);
+
+  std::vector<int64_t> dims{1, 4, 8, 8};
+  std::vector<float> input = ProgramForTest::Input(dims);
+  std::vector<std::vector<float>> outputs;
+  for (bool load_with_mmap : {false, true}) {
+    paddle_mobile::PaddleMobileConfigInternal config;
+    config.load_with_mmap = load_with_mmap;
+    paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile(config);
+    if (!paddle_mobile.Load(model_path, params_path, true)) {
+      return false;
+    }
+    outputs.push_back(paddle_mobile.Predict(input, dims));
+  }
+  remove(model_path.c_str());
+  remove(params_path.c_str());
+  return CompareOutputs(outputs[0], outputs[1]);
+}
+
+int main() {
+  if (!TestMapFile() || !TestPredict()) {
+    return 1;
+  }
+  const std::string model_path = std::string(g_mobilenet_combined) + "/model";
+  const std::string para_path = std::string(g_mobilenet_combined) + "/params";
+  if (!FileExists(model_path)) {
+    std::cout << "load with mmap passed, " << g_mobilenet_combined
+              << " is missing" << std::endl;
+    return 0;
+  }
+
+  std::vector<float> input;
+  std::vector<int64_t> dims{1, 3, 224, 224};
+  GetInput<float>(g_test_image_1x3x224x224_banana, &input, dims);
+
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile;
+  auto time1 = time();
+  if (!paddle_mobile.Load(model_path, para_path, true)) {
+    return 1;
+  }
+  auto time2 = time();
+  auto expect = paddle_mobile.Predict(input, dims);
+
+  paddle_mobile::PaddleMobileConfigInternal config;
+  config.load_with_mmap = true;
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile_mmap(config);
+  auto time3 = time();
+  if (!paddle_mobile_mmap.Load(model_path, para_path, true)) {
+    return 1;
+  }
+  auto time4 = time();
+  auto result = paddle_mobile_mmap.Predict(input, dims);
+  std::cout << "load cost: " << time_diff(time1, time2)
+            << "ms, load with mmap cost: " << time_diff(time3, time4) << "ms"
+            << std::endl;
+
+  if (!CompareOutputs(expect, result)) {
+    return 1;
+  }
+  std::cout << "load with mmap passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,157 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include "../program_for_test.h"
+#include "../test_helper.h"
+#include "../test_include.h"
+#include "framework/stream_reader.h"
+
+using paddle_mobile::framework::StreamReadFunc;
+using paddle_mobile::framework::StreamReader;
+
+// reads a file in small pieces, as a decrypting or downloading reader may
+static StreamReadFunc FileReader(const std::string &path) {
+  std::shared_ptr<FILE> fp(fopen(path.c_str(), "rb"), [](FILE *fp) {
+    if (fp != nullptr) {
+      fclose(fp);
+    }
+  });
+  return [fp](void *buffer, size_t size) -> size_t {
+    if (fp == nullptr) {
+      return 0;
+    }
+    return fread(buffer, 1, std::min<size_t>(size, 4093), fp.get());
+  };
+}
+
+// returns 1 to 7 bytes of data a call, fewer than any chunk
+static StreamReadFunc ShortReader(const std::string &data) {
+  std::shared_ptr<size_t> offset = std::make_shared<size_t>(0);
+  return [data, offset](void *buffer, size_t size) -> size_t {
+    size_t count = std::min(
+        {size, data.size() - *offset, static_cast<size_t>(*offset % 7 + 1)});
+    memcpy(buffer, data.data() + *offset, count);
+    *offset += count;
+    return count;
+  };
+}
+
+// reads of any size across the chunks return the bytes of the stream in
+// order, a read past its end fails
+static bool TestStreamReader() {
+  std::string data(1000, 0);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i * 7 % 251);
+  }
+  std::string result;
+  {
+    StreamReader reader(ShortReader(data), 16, 2);
+    char buffer[41];
+    for (size_t size = 0; result.size() + size <= data.size();
+         size = (size + 3) % 41) {
+      if (!reader.Read(buffer, size)) {
+        std::cout << "stream ends at " << result.size() << std::endl;
+        return false;
+      }
+      result.append(buffer, size);
+    }
+    size_t rest = data.size() - result.size();
+    if (reader.Read(buffer, rest + 1)) {
+      std::cout << "a read past the end of the stream succeeds" << std::endl;
+      return false;
+    }
+  }
+  if (data.compare(0, result.size(), result) != 0) {
+    std::cout << "stream read back wrong" << std::endl;
+    return false;
+  }
+  // a reader destroyed before the end of the stream stops reading ahead
+  {
+    StreamReader reader(ShortReader(data), 16, 2);
+    char buffer[8];
+    if (!reader.Read(buffer, sizeof(buffer))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// a model loaded from readers must predict as one loaded from memory
+static bool TestSmallNet() {
+  ProgramForTest program;
+  program.AddConvNet();
+
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> expect_engine;
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> stream_engine;
+  if (!program.Load(&expect_engine) ||
+      stream_engine.LoadStream(ShortReader(program.Model()),
+                               ShortReader(program.Params()),
+                               true) != paddle_mobile::PMSuccess) {
+    return false;
+  }
+  std::vector<int64_t> dims{1, 4, 8, 8};
+  std::vector<float> input = ProgramForTest::Input(dims);
+  return CompareOutputs(expect_engine.Predict(input, dims),
+                        stream_engine.Predict(input, dims));
+}
+
+int main() {
+  if (!TestStreamReader() || !TestSmallNet()) {
+    return 1;
+  }
+  const std::string model_path = std::string(g_mobilenet_combined) + "/model";
+  const std::string params_path =
+      std::string(g_mobilenet_combined) + "/params";
+  if (!FileExists(model_path)) {
+    std::cout << "load stream passed, " << model_path << " is missing"
+              << std::endl;
+    return 0;
+  }
+
+  std::vector<float> input;
+  std::vector<int64_t> dims{1, 3, 224, 224};
+  GetInput<float>(g_test_image_1x3x224x224_banana, &input, dims);
+
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> expect_engine;
+  expect_engine.SetThreadNum(4);
+  auto time1 = time();
+  if (!expect_engine.Load(model_path, params_path, true)) {
+    return 1;
+  }
+  auto time2 = time();
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> stream_engine;
+  stream_engine.SetThreadNum(4);
+  if (stream_engine.LoadStream(FileReader(model_path),
+                               FileReader(params_path),
+                               true) != paddle_mobile::PMSuccess) {
+    return 1;
+  }
+  auto time3 = time();
+
+  auto expect = expect_engine.Predict(input, dims);
+  auto result = stream_engine.Predict(input, dims);
+  if (!CompareOutputs(expect, result)) {
+    return 1;
+  }
+  std::cout << "load cost: " << time_diff(time1, time2)
+            << "ms, from readers: " << time_diff(time2, time3) << "ms"
+            << std::endl;
+  std::cout << "load stream passed" << std::endl;
+  return 0;
+}
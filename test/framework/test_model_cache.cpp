@@ -0,0 +1,202 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cstdio>
+#include <iostream>
+#include "../program_for_test.h"
+#include "../test_helper.h"
+#include "../test_include.h"
+#include "framework/model_cache.h"
+
+using paddle_mobile::framework::DataLayout;
+using paddle_mobile::framework::ModelCache;
+
+// a cache file is read back as it was written, under its key only
+static bool TestReadWrite() {
+  const std::string filename = "./test.cache";
+  ModelCache written("key");
+  written.program = "program";
+  written.params = std::string("\0params", 7);
+  written.var_layouts.emplace_back("conv", DataLayout::kNCHW8);
+  written.kernels.resize(2);
+  written.kernels[0].exec_mode = "winograd";
+  written.kernels[0].weights.resize(2);
+  SetupTensor<float>(&written.kernels[0].weights[1],
+                     paddle_mobile::framework::make_ddim({2, 3, 4}), -1.f,
+                     1.f);
+  if (!written.Write(filename)) {
+    return false;
+  }
+
+  ModelCache other("another key");
+  ModelCache read("key");
+  bool passed = !other.Read(filename) && !other.Restored() &&
+                read.Read(filename) && read.Restored() &&
+                read.program == written.program &&
+                read.params == written.params &&
+                read.var_layouts == written.var_layouts &&
+                read.kernels.size() == 2 &&
+                read.kernels[0].exec_mode == "winograd" &&
+                read.kernels[0].weights.size() == 2 &&
+                !read.kernels[0].weights[0].IsInitialized() &&
+                read.kernels[1].weights.empty();
+  if (passed) {
+    const auto &expect = written.kernels[0].weights[1];
+    const auto &result = read.kernels[0].weights[1];
+    passed = expect.dims() == result.dims() &&
+             CompareOutputs(
+                 std::vector<float>(expect.data<float>(),
+                                    expect.data<float>() + expect.numel()),
+                 std::vector<float>(result.data<float>(),
+                                    result.data<float>() + result.numel()),
+                 0.f);
+  }
+
+  // a file cut short is damaged
+  std::string content;
+  FILE *fp = fopen(filename.c_str(), "rb");
+  char buffer[256];
+  size_t read_size = 0;
+  while ((read_size = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+    content.append(buffer, read_size);
+  }
+  fclose(fp);
+  paddle_mobile::framework::WriteFile(filename,
+                                      content.substr(0, content.size() - 1));
+  ModelCache damaged("key");
+  passed = passed && !damaged.Read(filename) && damaged.kernels.empty();
+  remove(filename.c_str());
+  if (!passed) {
+    std::cout << "model cache read back wrong" << std::endl;
+  }
+  return passed;
+}
+
+template <typename LoadFunc>
+static std::vector<float> Predict(const std::string &model_cache,
+                                  LoadFunc load,
+                                  const std::vector<float> &input,
+                                  const std::vector<int64_t> &dims,
+                                  double *load_time) {
+  paddle_mobile::PaddleMobileConfigInternal config;
+  config.graph_optimization = true;
+  config.model_cache = model_cache;
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile(config);
+  paddle_mobile.SetThreadNum(4);
+  auto time1 = time();
+  if (!load(&paddle_mobile)) {
+    return {};
+  }
+  *load_time = time_diff(time1, time());
+  return paddle_mobile.Predict(input, dims);
+}
+
+// the first load with a model cache writes it, the second one restores the
+// program and the kernels from it, both must predict as a load without it
+template <typename LoadFunc>
+static bool TestLoad(const std::string &model_cache, LoadFunc load,
+                     const std::vector<float> &input,
+                     const std::vector<int64_t> &dims) {
+  remove(model_cache.c_str());
+  double load_time[3];
+  auto expect = Predict("", load, input, dims, &load_time[0]);
+  auto cached = Predict(model_cache, load, input, dims, &load_time[1]);
+  bool written = FileExists(model_cache);
+  auto restored = Predict(model_cache, load, input, dims, &load_time[2]);
+  remove(model_cache.c_str());
+
+  if (!written) {
+    std::cout << model_cache << " is not written" << std::endl;
+    return false;
+  }
+  if (!CompareOutputs(expect, cached) || !CompareOutputs(expect, restored)) {
+    return false;
+  }
+  std::cout << "load cost: " << load_time[0]
+            << "ms, writing the cache: " << load_time[1]
+            << "ms, from the cache: " << load_time[2] << "ms" << std::endl;
+  return true;
+}
+
+// a conv, batch norm and relu the graph pass folds, and a conv
+static bool TestSmallNet() {
+  ProgramForTest program;
+  program.AddVar("x", {1, 8, 10, 10});
+  program.AddParam("w0", {16, 8, 3, 3});
+  program.AddParam("w1", {8, 16, 3, 3});
+  for (const char *name : {"mean", "scale", "bias"}) {
+    program.AddParam(name, {16});
+  }
+  program.AddParam("variance", {16}, 0.5f, 2.f);
+  for (const char *name : {"c0", "bn", "r0"}) {
+    program.AddVar(name, {1, 16, 10, 10});
+  }
+  program.AddVar("c1", {1, 8, 10, 10});
+  program.AddFeed("x");
+  program.AddConv("x", "w0", "c0");
+  paddle_mobile::framework::AttributeMap attrs;
+  attrs["epsilon"].Set<float>(1e-5f);
+  attrs["momentum"].Set<float>(0.9f);
+  program.AddOp("batch_norm",
+                {{"X", {"c0"}},
+                 {"Mean", {"mean"}},
+                 {"Variance", {"variance"}},
+                 {"Scale", {"scale"}},
+                 {"Bias", {"bias"}}},
+                {{"Y", {"bn"}}}, attrs);
+  program.AddOp("relu", {{"X", {"bn"}}}, {{"Out", {"r0"}}});
+  program.AddConv("r0", "w1", "c1");
+  program.AddFetch("c1");
+
+  const std::string model_path = "./test_model_cache.model";
+  const std::string params_path = "./test_model_cache.params";
+  program.Save(model_path, params_path);
+  std::vector<int64_t> dims{1, 8, 10, 10};
+  bool passed = TestLoad(
+      "./small_net.cache",
+      [&](paddle_mobile::PaddleMobile<paddle_mobile::CPU> *paddle_mobile) {
+        return paddle_mobile->Load(model_path, params_path, true) ==
+               paddle_mobile::PMSuccess;
+      },
+      ProgramForTest::Input(dims), dims);
+  remove(model_path.c_str());
+  remove(params_path.c_str());
+  return passed;
+}
+
+int main() {
+  if (!TestReadWrite() || !TestSmallNet()) {
+    return 1;
+  }
+  if (!FileExists(std::string(g_mobilenet) + "/__model__")) {
+    std::cout << "model cache passed, " << g_mobilenet << " is missing"
+              << std::endl;
+    return 0;
+  }
+
+  std::vector<float> input;
+  std::vector<int64_t> dims{1, 3, 224, 224};
+  GetInput<float>(g_test_image_1x3x224x224_banana, &input, dims);
+  if (!TestLoad(
+          "./mobilenet.cache",
+          [](paddle_mobile::PaddleMobile<paddle_mobile::CPU> *paddle_mobile) {
+            return paddle_mobile->Load(g_mobilenet, true) ==
+                   paddle_mobile::PMSuccess;
+          },
+          input, dims)) {
+    return 1;
+  }
+  std::cout << "model cache passed" << std::endl;
+  return 0;
+}
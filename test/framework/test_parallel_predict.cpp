@@ -0,0 +1,144 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <iostream>
+#include "../program_for_test.h"
+#include "../test_helper.h"
+#include "../test_include.h"
+#include "framework/op_dag.h"
+
+// two convs of the fed x, an add of both and a relu rewriting the output
+// of the first conv, which the add reads before
+static void AddBranches(ProgramForTest *program, const std::string &output) {
+  program->AddVar("x", {1, 4, 8, 8});
+  program->AddParam("w0", {6, 4, 3, 3});
+  program->AddParam("w1", {6, 4, 3, 3});
+  for (const char *name : {"a", "b", "c", "d"}) {
+    program->AddVar(name, {1, 6, 8, 8});
+  }
+  program->AddFeed("x");
+  program->AddConv("x", "w0", "a");
+  program->AddConv("x", "w1", "b");
+  paddle_mobile::framework::AttributeMap attrs;
+  attrs["axis"].Set<int>(-1);
+  program->AddOp("elementwise_add", {{"X", {"a"}}, {"Y", {"b"}}},
+                 {{"Out", {"c"}}}, attrs);
+  program->AddOp("relu", {{"X", {"c"}}}, {{"Out", {output}}});
+  program->AddFetch(output);
+}
+
+// the convs of the branches are independent, everything else is ordered,
+// also the relu writing a after the add read it
+static bool TestDAG() {
+  ProgramForTest program;
+  AddBranches(&program, "a");
+  paddle_mobile::framework::OpDAG dag(program.Desc()->Block(0)->Ops());
+  const bool precedes[6][6] = {
+      {0, 1, 1, 1, 1, 1}, {0, 0, 0, 1, 1, 1}, {0, 0, 0, 1, 1, 1},
+      {0, 0, 0, 0, 1, 1}, {0, 0, 0, 0, 0, 1}, {0, 0, 0, 0, 0, 0}};
+  for (int i = 0; i < 6; ++i) {
+    for (int j = 0; j < 6; ++j) {
+      if (dag.Precedes(i, j) != precedes[i][j]) {
+        std::cout << "op " << i << (precedes[i][j] ? " should" : " shouldn't")
+                  << " precede op " << j << std::endl;
+        return false;
+      }
+    }
+  }
+  if (dag.Width() != 2 || dag.InDegree(3) != 2 || dag.InDegree(4) != 2 ||
+      dag.Height(0) != 5 || dag.Height(1) != 4 || dag.Height(2) != 4) {
+    std::cout << "width: " << dag.Width() << ", in degrees: "
+              << dag.InDegree(3) << ", " << dag.InDegree(4) << ", heights: "
+              << dag.Height(0) << ", " << dag.Height(1) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// the branches predict the same on several threads of ops
+static bool TestPredict() {
+  ProgramForTest program;
+  AddBranches(&program, "d");
+  std::vector<int64_t> dims{1, 4, 8, 8};
+  std::vector<float> input = ProgramForTest::Input(dims);
+  std::vector<float> expect;
+  for (int inter_op_threads = 1; inter_op_threads <= 2; ++inter_op_threads) {
+    paddle_mobile::PaddleMobileConfigInternal config;
+    config.memory_optimization = true;
+    config.inter_op_threads = inter_op_threads;
+    paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile(config);
+    paddle_mobile.SetThreadNum(2);
+    if (!program.Load(&paddle_mobile, false)) {
+      return false;
+    }
+    paddle_mobile.Predict(input, dims);
+    auto result = paddle_mobile.Predict(input, dims);
+    if (inter_op_threads == 1) {
+      expect = result;
+    } else if (!CompareOutputs(expect, result)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  if (!TestDAG() || !TestPredict()) {
+    return 1;
+  }
+  if (!FileExists(std::string(g_googlenet) + "/__model__")) {
+    std::cout << "parallel predict passed, " << g_googlenet << " is missing"
+              << std::endl;
+    return 0;
+  }
+
+  // the inception branches of googlenet run at the same time with
+  // inter_op_threads, the outputs must match the sequential prediction
+  std::vector<float> input;
+  std::vector<int64_t> dims{1, 3, 224, 224};
+  GetInput<float>(g_test_image_1x3x224x224_banana, &input, dims);
+
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile;
+  paddle_mobile.SetThreadNum(4);
+  if (!paddle_mobile.Load(g_googlenet, true)) {
+    return 1;
+  }
+  auto expect = paddle_mobile.Predict(input, dims);
+
+  for (int inter_op_threads = 2; inter_op_threads <= 4; ++inter_op_threads) {
+    paddle_mobile::PaddleMobileConfigInternal config;
+    config.memory_optimization = true;
+    config.inter_op_threads = inter_op_threads;
+    paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile_par(config);
+    paddle_mobile_par.SetThreadNum(4);
+    if (!paddle_mobile_par.Load(g_googlenet, true)) {
+      return 1;
+    }
+    auto time1 = time();
+    paddle_mobile_par.Predict(input, dims);
+    auto result = paddle_mobile_par.Predict(input, dims);
+    auto time2 = time();
+
+    if (!CompareOutputs(expect, result)) {
+      std::cout << "inter_op_threads " << inter_op_threads << " mismatch"
+                << std::endl;
+      return 1;
+    }
+    std::cout << "inter_op_threads " << inter_op_threads
+              << ", predict cost: " << time_diff(time1, time2) / 2 << "ms"
+              << std::endl;
+  }
+  std::cout << "parallel predict passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,160 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <exception>
+#include <future>
+#include <iostream>
+#include "../program_for_test.h"
+#include "../test_helper.h"
+#include "../test_include.h"
+
+typedef paddle_mobile::PaddleMobile<paddle_mobile::CPU> PaddleMobileCPU;
+
+// the pipelined predictions must match the synchronous ones and complete in
+// the order they were submitted, inputs[1] is 1 - inputs[0]
+static bool TestAsync(PaddleMobileCPU *paddle_mobile,
+                      const std::vector<float> &input,
+                      const std::vector<int64_t> &dims) {
+  const int kRequests = 16;
+  std::vector<std::vector<float>> inputs(2, input);
+  for (auto &value : inputs[1]) {
+    value = 1.f - value;
+  }
+
+  std::vector<std::vector<float>> expects;
+  auto time1 = time();
+  for (int i = 0; i < kRequests; ++i) {
+    auto output = paddle_mobile->Predict(inputs[i % 2], dims);
+    if (i < 2) {
+      expects.push_back(output);
+    }
+  }
+  auto time2 = time();
+
+  std::vector<std::future<std::vector<float>>> futures;
+  for (int i = 0; i < kRequests; ++i) {
+    futures.push_back(paddle_mobile->PredictAsync(inputs[i % 2], dims));
+  }
+  for (int i = 0; i < kRequests; ++i) {
+    if (!CompareOutputs(expects[i % 2], futures[i].get())) {
+      return false;
+    }
+  }
+  auto time3 = time();
+
+  std::vector<int> order;
+  bool matched = true;
+  for (int i = 0; i < kRequests; ++i) {
+    paddle_mobile->PredictAsync(
+        inputs[i % 2], dims,
+        [&, i](paddle_mobile::PMStatus status, std::vector<float> output) {
+          order.push_back(i);
+          matched = matched && status == paddle_mobile::PMSuccess &&
+                    CompareOutputs(expects[i % 2], output);
+        });
+  }
+  paddle_mobile->WaitAsync();
+  if (!matched || order.size() != kRequests) {
+    return false;
+  }
+  for (int i = 0; i < kRequests; ++i) {
+    if (order[i] != i) {
+      std::cout << "request " << order[i] << " completed out of order"
+                << std::endl;
+      return false;
+    }
+  }
+
+  std::cout << "predict cost: " << time_diff(time1, time2) / kRequests
+            << "ms, pipelined: " << time_diff(time2, time3) / kRequests
+            << "ms" << std::endl;
+  return true;
+}
+
+// a request the net can not run fails alone: its future throws, its
+// callback gets the status and the requests around it still complete
+static bool TestFailure(PaddleMobileCPU *paddle_mobile,
+                        const std::vector<float> &input,
+                        const std::vector<int64_t> &dims) {
+#ifdef ENABLE_EXCEPTION
+  const std::vector<int64_t> bad_dims{dims[0], dims[1], dims[2] * dims[3]};
+  auto expect = paddle_mobile->Predict(input, dims);
+  auto before = paddle_mobile->PredictAsync(input, dims);
+  auto failed = paddle_mobile->PredictAsync(input, bad_dims);
+  auto status = paddle_mobile::PMSuccess;
+  std::vector<float> output(1);
+  paddle_mobile->PredictAsync(
+      input, bad_dims,
+      [&](paddle_mobile::PMStatus request_status, std::vector<float> result) {
+        status = request_status;
+        output = result;
+      });
+  auto after = paddle_mobile->PredictAsync(input, dims);
+  paddle_mobile->WaitAsync();
+
+  bool thrown = false;
+  try {
+    failed.get();
+  } catch (const std::exception &e) {
+    thrown = true;
+  }
+  if (!thrown || status == paddle_mobile::PMSuccess || !output.empty()) {
+    std::cout << "a failed request is reported as done" << std::endl;
+    return false;
+  }
+  return CompareOutputs(expect, before.get()) &&
+         CompareOutputs(expect, after.get());
+#else
+  return true;
+#endif
+}
+
+// the conv net of ProgramForTest
+static bool TestSmallNet() {
+  ProgramForTest program;
+  program.AddConvNet();
+
+  PaddleMobileCPU paddle_mobile;
+  paddle_mobile.SetThreadNum(2);
+  if (!program.Load(&paddle_mobile)) {
+    return false;
+  }
+  std::vector<int64_t> dims{1, 4, 8, 8};
+  std::vector<float> input = ProgramForTest::Input(dims);
+  return TestAsync(&paddle_mobile, input, dims) &&
+         TestFailure(&paddle_mobile, input, dims);
+}
+
+int main() {
+  if (!TestSmallNet()) {
+    return 1;
+  }
+  if (!FileExists(std::string(g_mobilenet) + "/__model__")) {
+    std::cout << "async predict passed, " << g_mobilenet << " is missing"
+              << std::endl;
+    return 0;
+  }
+
+  std::vector<int64_t> dims{1, 3, 224, 224};
+  std::vector<float> input;
+  GetInput<float>(g_test_image_1x3x224x224_banana, &input, dims);
+  PaddleMobileCPU paddle_mobile;
+  paddle_mobile.SetThreadNum(4);
+  if (!paddle_mobile.Load(g_mobilenet, true) ||
+      !TestAsync(&paddle_mobile, input, dims)) {
+    return 1;
+  }
+  std::cout << "async predict passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,54 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <fstream>
+#include <iostream>
+#include "../test_helper.h"
+#include "../test_include.h"
+
+int main() {
+  std::vector<float> input;
+  std::vector<int64_t> dims{1, 3, 224, 224};
+  GetInput<float>(g_test_image_1x3x224x224_banana, &input, dims);
+
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile;
+  paddle_mobile.SetThreadNum(1);
+  if (!paddle_mobile.Load(g_mobilenet, true)) {
+    return 1;
+  }
+  // warm up without profiling
+  paddle_mobile.Predict(input, dims);
+
+  paddle_mobile.EnableProfile(true);
+  paddle_mobile.Predict(input, dims);
+  paddle_mobile.Predict(input, dims);
+  paddle_mobile.EnableProfile(false);
+  const std::string trace = paddle_mobile.GetProfileTrace();
+  paddle_mobile.Predict(input, dims);
+
+  if (trace.find("{\"traceEvents\":[") != 0 ||
+      trace.find("\"run\":1") == std::string::npos) {
+    std::cout << "unexpected trace: " << trace << std::endl;
+    return 1;
+  }
+  if (paddle_mobile.GetProfileTrace() != trace) {
+    std::cout << "disabled profiler should not record" << std::endl;
+    return 1;
+  }
+
+  std::ofstream("profile_trace.json") << trace;
+  std::cout << paddle_mobile.GetProfileSummary() << std::endl;
+  std::cout << "trace is saved to profile_trace.json" << std::endl;
+  return 0;
+}
@@ -0,0 +1,159 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <functional>
+#include <iostream>
+#include "../program_for_test.h"
+#include "../test_helper.h"
+#include "../test_include.h"
+
+typedef paddle_mobile::PaddleMobile<paddle_mobile::CPU> PaddleMobileCPU;
+// loads the net for the input shape dims, a net may ignore the shape
+typedef std::function<bool(PaddleMobileCPU *, const std::vector<int64_t> &)>
+    LoadFunc;
+
+// switch the input shape of a fully convolutional net around the shapes
+// twice, every output should be the same as an instance which is loaded for
+// one shape and only sees it. Fewer plans than shapes drop and plan them
+// again.
+static bool TestShapes(const LoadFunc &load,
+                       const std::vector<std::vector<int64_t>> &shapes,
+                       const std::vector<std::vector<float>> &inputs,
+                       int max_shape_plans = 8) {
+  paddle_mobile::PaddleMobileConfigInternal config;
+  config.memory_optimization = true;
+  config.max_shape_plans = max_shape_plans;
+  PaddleMobileCPU paddle_mobile(config);
+  if (!load(&paddle_mobile, shapes[0])) {
+    return false;
+  }
+
+  std::vector<std::vector<float>> expects;
+  for (int i = 0; i < shapes.size(); ++i) {
+    PaddleMobileCPU single(config);
+    if (!load(&single, shapes[i])) {
+      return false;
+    }
+    expects.push_back(single.Predict(inputs[i], shapes[i]));
+  }
+
+  for (int i = 0; i < 2 * shapes.size(); ++i) {
+    const auto &dims = shapes[i % shapes.size()];
+    auto time1 = time();
+    auto result = paddle_mobile.Predict(inputs[i % shapes.size()], dims);
+    auto time2 = time();
+    std::cout << dims[2] << "x" << dims[3]
+              << " predict cost: " << time_diff(time1, time2) << "ms"
+              << std::endl;
+    if (!CompareOutputs(expects[i % shapes.size()], result)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::vector<std::vector<float>> Inputs(
+    const std::vector<std::vector<int64_t>> &shapes) {
+  std::vector<std::vector<float>> inputs;
+  for (const auto &dims : shapes) {
+    inputs.push_back(ProgramForTest::Input(dims));
+  }
+  return inputs;
+}
+
+// a small net of two convs and a pooling, the shapes of every activation
+// change with the input
+static bool TestSmallNet() {
+  ProgramForTest program;
+  program.AddVar("x", {1, 2, 8, 8});
+  program.AddParam("w0", {6, 2, 3, 3});
+  program.AddParam("w1", {3, 6, 3, 3});
+  program.AddVar("c0", {1, 6, 8, 8});
+  program.AddVar("r0", {1, 6, 8, 8});
+  program.AddVar("p0", {1, 6, 4, 4});
+  program.AddVar("c1", {1, 3, 4, 4});
+  program.AddFeed("x");
+  program.AddConv("x", "w0", "c0");
+  program.AddOp("relu", {{"X", {"c0"}}}, {{"Out", {"r0"}}});
+  paddle_mobile::framework::AttributeMap attrs;
+  attrs["pooling_type"].SetString("max");
+  attrs["ksize"].Set<std::vector<int>>(std::vector<int>{2, 2});
+  attrs["strides"].Set<std::vector<int>>(std::vector<int>{2, 2});
+  attrs["paddings"].Set<std::vector<int>>(std::vector<int>{0, 0});
+  attrs["global_pooling"].Set<bool>(false);
+  attrs["ceil_mode"].Set<bool>(false);
+  program.AddOp("pool2d", {{"X", {"r0"}}}, {{"Out", {"p0"}}}, attrs);
+  program.AddConv("p0", "w1", "c1");
+  program.AddFetch("c1");
+
+  std::vector<std::vector<int64_t>> shapes{{1, 2, 8, 8}, {1, 2, 20, 12}};
+  return TestShapes(
+      [&](PaddleMobileCPU *paddle_mobile, const std::vector<int64_t> &dims) {
+        return program.Load(paddle_mobile);
+      },
+      shapes, Inputs(shapes));
+}
+
+// a wide conv runs the implicit gemm on small feature maps and winograd on
+// larger ones, it picks again for every new plan as it does when it is
+// loaded for the shape. Two plans for three shapes drop the least recently
+// used one for every new shape.
+static bool TestWideConv() {
+  ProgramForTest program;
+  program.AddVar("x", {1, 64, 4, 4});
+  program.AddParam("w", {64, 64, 3, 3});
+  program.AddVar("c", {1, 64, 4, 4});
+  program.AddFeed("x");
+  program.AddConv("x", "w", "c");
+  program.AddFetch("c");
+  std::vector<std::vector<int64_t>> shapes{
+      {1, 64, 4, 4}, {1, 64, 16, 16}, {1, 64, 12, 8}};
+  return TestShapes(
+      [&](PaddleMobileCPU *paddle_mobile, const std::vector<int64_t> &dims) {
+        program.ResizeVar("x", dims);
+        program.ResizeVar("c", dims);
+        return program.Load(paddle_mobile);
+      },
+      shapes, Inputs(shapes), 2);
+}
+
+int main() {
+  if (!TestSmallNet() || !TestWideConv()) {
+    return 1;
+  }
+  if (!FileExists(std::string(g_super) + "/model")) {
+    std::cout << "shape plan passed, " << g_super << " is missing"
+              << std::endl;
+    return 0;
+  }
+
+  std::vector<int64_t> small_dims{1, 1, 300, 300};
+  std::vector<int64_t> large_dims{1, 1, 500, 500};
+  std::vector<float> small_input, large_input;
+  GetInput<float>(g_super_img, &small_input, small_dims);
+  GetInput<float>(g_super_img, &large_input, large_dims);
+  if (!TestShapes(
+          [](PaddleMobileCPU *paddle_mobile,
+             const std::vector<int64_t> &dims) {
+            paddle_mobile->SetThreadNum(1);
+            return paddle_mobile->Load(std::string(g_super) + "/model",
+                                       std::string(g_super) + "/params",
+                                       true);
+          },
+          {small_dims, large_dims}, {small_input, large_input})) {
+    return 1;
+  }
+  std::cout << "shape plan passed" << std::endl;
+  return 0;
+}
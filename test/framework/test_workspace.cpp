@@ -0,0 +1,122 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "common/enforce.h"
+#include "framework/workspace.h"
+#include "operators/math/math_function.h"
+
+using paddle_mobile::framework::DDim;
+using paddle_mobile::framework::Tensor;
+using paddle_mobile::framework::Workspace;
+using paddle_mobile::framework::WorkspaceBinding;
+using paddle_mobile::framework::WorkspaceScope;
+using paddle_mobile::framework::make_ddim;
+
+// the allocations of an op: a few buffers, a tensor and a nested scope
+static std::vector<uintptr_t> RunOp() {
+  WorkspaceScope scratch;
+  std::vector<uintptr_t> addresses;
+  addresses.push_back(reinterpret_cast<uintptr_t>(scratch.Allocate(100)));
+  addresses.push_back(
+      reinterpret_cast<uintptr_t>(scratch.Allocate<float>(1000)));
+  Tensor tensor = scratch.NewTensor<float>(make_ddim({3, 50}));
+  addresses.push_back(reinterpret_cast<uintptr_t>(tensor.data<float>()));
+  {
+    WorkspaceScope nested;
+    addresses.push_back(
+        reinterpret_cast<uintptr_t>(nested.Allocate<int8_t>(5000)));
+  }
+  // the nested scope gave its memory back
+  WorkspaceScope nested;
+  addresses.push_back(
+      reinterpret_cast<uintptr_t>(nested.Allocate<int8_t>(10)));
+  for (uintptr_t address : addresses) {
+    PADDLE_MOBILE_ENFORCE(address % 64 == 0, "allocation is not aligned");
+  }
+  return addresses;
+}
+
+// MatMul of a transposed A takes its temporaries from the workspace
+static std::vector<float> TransposedMatMul() {
+  Tensor a, b, c;
+  float *a_data = a.mutable_data<float>(make_ddim({37, 20}));
+  float *b_data = b.mutable_data<float>(make_ddim({37, 29}));
+  c.mutable_data<float>(make_ddim({20, 29}));
+  for (int i = 0; i < a.numel(); ++i) {
+    a_data[i] = (i % 17) * 0.25f - 2;
+  }
+  for (int i = 0; i < b.numel(); ++i) {
+    b_data[i] = (i % 13) * 0.5f - 3;
+  }
+  paddle_mobile::operators::math::MatMul<float, float>(a, true, b, false, 1.f,
+                                                       &c, 0.f);
+  return std::vector<float>(c.data<float>(), c.data<float>() + c.numel());
+}
+
+int main() {
+  // without a workspace the temporaries come from the heap
+  PADDLE_MOBILE_ENFORCE(Workspace::Instance() == nullptr,
+                        "a workspace is bound by default");
+  RunOp();
+  const std::vector<float> expect = TransposedMatMul();
+
+  Workspace workspace;
+  {
+    WorkspaceBinding binding(&workspace);
+    PADDLE_MOBILE_ENFORCE(Workspace::Instance() == &workspace,
+                          "the workspace is not bound");
+    // the first run plans the block, the later ones reuse it
+    RunOp();
+    const size_t capacity = workspace.Capacity();
+    PADDLE_MOBILE_ENFORCE(capacity >= 100 + 4000 + 600 + 5000,
+                          "the block is too small: %d",
+                          static_cast<int>(capacity));
+    const std::vector<uintptr_t> first = RunOp();
+    PADDLE_MOBILE_ENFORCE(first[3] == first[4],
+                          "the nested scope did not give its memory back");
+    for (int r = 0; r < 3; ++r) {
+      PADDLE_MOBILE_ENFORCE(RunOp() == first, "the same allocations moved");
+      PADDLE_MOBILE_ENFORCE(workspace.Capacity() == capacity,
+                            "the block grew again");
+    }
+
+    // a bigger op grows the block once it finished
+    {
+      WorkspaceScope scratch;
+      scratch.Allocate(capacity * 2);
+    }
+    PADDLE_MOBILE_ENFORCE(workspace.Capacity() >= capacity * 2,
+                          "the block did not grow");
+
+    // a reserved tensor is filled in place as long as it fits
+    {
+      WorkspaceScope scratch;
+      Tensor reserved = scratch.Reserve(64 * sizeof(float));
+      const float *data = reserved.mutable_data<float>(make_ddim({8, 8}));
+      const float *next = static_cast<float *>(scratch.Allocate(0));
+      PADDLE_MOBILE_ENFORCE(data + 64 == next,
+                            "the reserved tensor was allocated again");
+    }
+
+    const std::vector<float> result = TransposedMatMul();
+    PADDLE_MOBILE_ENFORCE(result == expect, "MatMul differs on a workspace");
+  }
+  PADDLE_MOBILE_ENFORCE(Workspace::Instance() == nullptr,
+                        "the binding was not undone");
+  std::cout << "workspace test passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,64 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <iostream>
+#include "../test_helper.h"
+#include "../test_include.h"
+
+// a batch of images should give the same outputs as predicting every image
+// alone, and should be faster per image with several threads
+int main() {
+  const int batch_size = 4;
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile;
+  paddle_mobile.SetThreadNum(4);
+  if (!paddle_mobile.Load(g_mobilenet, true)) {
+    return 1;
+  }
+
+  std::vector<int64_t> dims{1, 3, 224, 224};
+  std::vector<float> image;
+  GetInput<float>(g_test_image_1x3x224x224_banana, &image, dims);
+  std::vector<std::vector<float>> images(batch_size, image);
+  for (int i = 1; i < batch_size; ++i) {
+    for (auto &value : images[i]) {
+      value *= 1.f - 0.1f * i;
+    }
+  }
+
+  std::vector<std::vector<float>> expects;
+  auto time1 = time();
+  for (const auto &input : images) {
+    expects.push_back(paddle_mobile.Predict(input, dims));
+  }
+  auto time2 = time();
+  auto outputs = paddle_mobile.PredictBatch(images, dims);
+  auto time3 = time();
+  std::cout << "one by one cost: " << time_diff(time1, time2) / batch_size
+            << "ms per image, batch cost: "
+            << time_diff(time2, time3) / batch_size << "ms per image"
+            << std::endl;
+
+  for (int i = 0; i < batch_size; ++i) {
+    PADDLE_MOBILE_ENFORCE(outputs[i].size() == expects[i].size(),
+                          "output size of image %d mismatch", i);
+    for (int k = 0; k < expects[i].size(); ++k) {
+      PADDLE_MOBILE_ENFORCE(std::abs(outputs[i][k] - expects[i][k]) < 1e-4,
+                            "image %d output[%d] mismatch, %f vs %f", i, k,
+                            outputs[i][k], expects[i][k]);
+    }
+  }
+  std::cout << "batch predict passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,67 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <iostream>
+#include <memory>
+#include "../test_helper.h"
+#include "../test_include.h"
+#include "framework/calibrator.h"
+
+int main(int argc, char* argv[]) {
+  if (argc < 6) {
+    std::cout << "Usage: " << std::endl
+              << "./test-calibrate fluid_model output_dir feed_shape method "
+                 "sample [sample ...]"
+              << std::endl;
+    std::cout << "fluid_model: model dir, or model,params of combined model\n";
+    std::cout << "method: 0 max, 1 kl, 2 percentile\n";
+    std::cout << "sample: raw float32 file of one input of feed_shape\n";
+    return 1;
+  }
+  std::string fluid_model = argv[1];
+  std::string output_dir = argv[2];
+  std::vector<int64_t> dims{1, 3, 224, 224};
+  sscanf(argv[3], "%ld,%ld,%ld,%ld", &dims[0], &dims[1], &dims[2], &dims[3]);
+
+  paddle_mobile::framework::CalibrationConfig config;
+  config.method =
+      static_cast<paddle_mobile::framework::CalibrationMethod>(atoi(argv[4]));
+  config.batch_size = dims[0];
+
+  std::unique_ptr<paddle_mobile::framework::Calibrator> calibrator;
+  size_t comma = fluid_model.find(',');
+  if (comma == std::string::npos) {
+    calibrator.reset(
+        new paddle_mobile::framework::Calibrator(fluid_model, config));
+  } else {
+    calibrator.reset(new paddle_mobile::framework::Calibrator(
+        fluid_model.substr(0, comma), fluid_model.substr(comma + 1), config));
+  }
+
+  auto time1 = time();
+  for (int i = 5; i < argc; ++i) {
+    paddle_mobile::framework::Tensor input;
+    GetInput<float>(argv[i], &input, paddle_mobile::framework::make_ddim(dims));
+    calibrator->Collect(input);
+  }
+  auto time2 = time();
+  std::cout << "calibrate " << argc - 5 << " samples cost :"
+            << time_diff(time1, time2) << "ms\n";
+  for (const auto& threshold : calibrator->Thresholds()) {
+    std::cout << threshold.first << ": " << threshold.second << "\n";
+  }
+  calibrator->Save(output_dir + "/model", output_dir + "/params");
+  std::cout << "int8 model is saved to " << output_dir << std::endl;
+  return 0;
+}
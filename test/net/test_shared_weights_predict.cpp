@@ -0,0 +1,70 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <iostream>
+#include <thread>  // NOLINT
+#include "../test_helper.h"
+#include "../test_include.h"
+
+// load mobilenet once and predict with several clones in their own threads,
+// every clone should give the same result as the loaded instance
+int main() {
+  const int thread_num = 4;
+  const int repeats = 10;
+  paddle_mobile::PaddleMobile<paddle_mobile::CPU> paddle_mobile;
+  paddle_mobile.SetThreadNum(1);
+  if (!paddle_mobile.Load(g_mobilenet, true)) {
+    return 1;
+  }
+
+  vector<float> input;
+  vector<int64_t> dims{1, 3, 224, 224};
+  GetInput<float>(g_test_image_1x3x224x224_banana, &input, dims);
+  const auto expected = paddle_mobile.Predict(input, dims);
+
+  std::vector<std::shared_ptr<paddle_mobile::PaddleMobile<paddle_mobile::CPU>>>
+      clones;
+  for (int i = 0; i < thread_num; ++i) {
+    clones.push_back(paddle_mobile.Clone());
+  }
+
+  std::vector<int> mismatch(thread_num, 0);
+  std::vector<std::thread> threads;
+  auto time1 = time();
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back([&, i] {
+      for (int r = 0; r < repeats; ++r) {
+        auto result = clones[i]->Predict(input, dims);
+        for (int k = 0; k < result.size(); ++k) {
+          if (std::abs(result[k] - expected[k]) > 1e-5) {
+            mismatch[i] += 1;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto time2 = time();
+  std::cout << thread_num << " clones, predict cost: "
+            << time_diff(time1, time2) / (thread_num * repeats) << "ms"
+            << std::endl;
+
+  for (int i = 0; i < thread_num; ++i) {
+    PADDLE_MOBILE_ENFORCE(mismatch[i] == 0, "clone %d got %d wrong outputs", i,
+                          mismatch[i]);
+  }
+  return 0;
+}
@@ -15,6 +15,7 @@ limitations under the License. */
 #include "../test_helper.h"
 #include "../test_include.h"
 #include "operators/fusion_conv_bn_relu_op.h"
+#include "operators/math/conv_tuner.h"
 
 namespace paddle_mobile {
 
@@ -66,7 +67,7 @@ int TestConvBnReluOp(int in_channels, int in_height, int in_width,
   SetupTensor<float>(input_mean, shape, -10.0, 10.0);
   auto vari_var = scope.get()->Var("input_variance");
   auto vari = vari_var->template GetMutable<framework::LoDTensor>();
-  SetupTensor<float>(vari, shape, -10.0, 10.0);
+  SetupTensor<float>(vari, shape, 0.1, 10.0);
   auto scale_var = scope.get()->Var("input_scale");
   auto scale = scale_var->template GetMutable<framework::LoDTensor>();
   SetupTensor<float>(scale, shape, -10.0, 10.0);
@@ -100,6 +101,52 @@ int TestConvBnReluOp(int in_channels, int in_height, int in_width,
            << std::endl;
   out_file.close();
 
+  // compare with the conv followed by batch norm and relu
+  auto output = output_var->template Get<framework::LoDTensor>();
+  const int output_h = output->dims()[2];
+  const int output_w = output->dims()[3];
+  const int channels_per_group = input_c / groups;
+  const float *in_data = input->data<float>();
+  const float *filter_data = filter->data<float>();
+  const float *output_data = output->data<float>();
+  for (int oc = 0; oc < output_c; ++oc) {
+    int g = oc / (output_c / groups);
+    float new_scale = scale->data<float>()[oc] /
+                      std::sqrt(vari->data<float>()[oc] + 1e-6);
+    float new_bias = input_bias->data<float>()[oc] -
+                     input_mean->data<float>()[oc] * new_scale;
+    for (int oh = 0; oh < output_h; ++oh) {
+      for (int ow = 0; ow < output_w; ++ow) {
+        float sum = 0.f;
+        for (int ic = 0; ic < channels_per_group; ++ic) {
+          int c = g * channels_per_group + ic;
+          int filter_offset = (oc * channels_per_group + ic) * kernel_h;
+          const float *w_data = filter_data + filter_offset * kernel_w;
+          for (int kh = 0; kh < kernel_h; ++kh) {
+            for (int kw = 0; kw < kernel_w; ++kw) {
+              int h = oh * stride_h - pad_h + kh;
+              int w = ow * stride_w - pad_w + kw;
+              if (h < 0 || h >= input_h || w < 0 || w >= input_w) {
+                continue;
+              }
+              sum += in_data[(c * input_h + h) * input_w + w] *
+                     w_data[kh * kernel_w + kw];
+            }
+          }
+        }
+        float expect = std::max(sum * new_scale + new_bias, 0.f);
+        float actual = output_data[(oc * output_h + oh) * output_w + ow];
+        // winograd is accurate to about 0.1 before the batch norm
+        float max_gap = 0.1f * std::abs(new_scale) + 1e-3 * std::abs(expect);
+        if (std::abs(actual - expect) > max_gap) {
+          std::cerr << opname << ": output[" << oc << ", " << oh << ", " << ow
+                    << "] = " << actual << ", expect " << expect << std::endl;
+          exit(1);
+        }
+      }
+    }
+  }
+
   delete op;
   return 0;
 }
@@ -168,5 +215,20 @@ int main(int argc, char *argv[]) {
   paddle_mobile::TestConvBnReluOp<float, float, 1, 0, 1>(
       192, 6, 6, 64, 1, "MBConv_5x5_stage2_pw3");
 
+  // wide convolutions of stride 1 run in winograd by default
+  paddle_mobile::TestConvBnReluOp<float, float, 3, 1, 1>(64, 20, 20, 64, 1,
+                                                         "winograd_conv3x3");
+  paddle_mobile::TestConvBnReluOp<float, float, 5, 2, 1>(64, 13, 9, 72, 1,
+                                                         "winograd_conv5x5");
+
+  // the algorithms picked by tuning apply batch norm and relu as well
+  paddle_mobile::operators::math::ConvTuner::Instance()->EnableTuning(
+      "conv_tuning_profile.txt");
+  paddle_mobile::TestConvBnReluOp<float, float, 3, 1, 1>(16, 24, 24, 16, 1,
+                                                         "tuned_conv3x3s1");
+  paddle_mobile::TestConvBnReluOp<float, float, 3, 1, 2>(3, 48, 48, 16, 1,
+                                                         "tuned_conv3x3s2");
+  paddle_mobile::TestConvBnReluOp<float, float, 1, 0, 1>(24, 12, 12, 16, 1,
+                                                         "tuned_conv1x1");
   return 0;
 }
@@ -16,6 +16,7 @@ limitations under the License. */
 #include "../test_helper.h"
 #include "../test_include.h"
 #include "operators/conv_op.h"
+#include "operators/math/conv_tuner.h"
 
 namespace paddle_mobile {
 
@@ -129,9 +130,11 @@ void conv2d(const framework::Tensor *input, const framework::Tensor *filter,
   }
 }
 
+// max_gap is the absolute error allowed besides the relative one, winograd
+// rounds differently from the direct sum
 template <typename Itype, typename Otype, int Kernel, int Pad, int Stride>
 int TestConvOp(int in_channels, int in_height, int in_width, int out_channels,
-               int groups) {
+               int groups, float max_gap = 1e-2) {
   int kernel_h = Kernel;
   int kernel_w = Kernel;
   int pad_h = Pad;
@@ -210,7 +213,8 @@ int TestConvOp(int in_channels, int in_height, int in_width, int out_channels,
     //    PADDLE_MOBILE_ENFORCE(std::abs(gap / (output_data[i] + 1e-5)) < 1e-3,
     //                          "output[%d] = %d, output_cmp[%d] = %d", i,
     //                          output_data[i], i, output_cmp_data[i]);
-    if (gap > 1e-2 && std::abs(gap / (output_data[i] + 1e-5)) > 1e-3) {
+    if (std::abs(gap) > max_gap &&
+        std::abs(gap / (output_data[i] + 1e-5)) > 1e-3) {
       std::cerr << "output_data[" << i << "] = " << output_data[i]
                 << ", output_cmp_data[" << i << "] = " << output_cmp_data[i]
                 << std::endl;
@@ -337,6 +341,41 @@ int TestAll(const int in_channels, const int in_height, const int in_width,
   return 0;
 }
 
+// wide convolutions of stride 1 run in winograd by default
+int TestWinograd(const int in_channels, const int in_height,
+                 const int in_width, const int out_channels) {
+  std::cerr << "winograd, in_channels=" << in_channels
+            << ", in_height=" << in_height << ", in_width=" << in_width
+            << ", out_channels=" << out_channels << std::endl;
+  paddle_mobile::TestConvOp<float, float, 3, 1, 1>(
+      in_channels, in_height, in_width, out_channels, 1, 0.1f);
+  paddle_mobile::TestConvOp<float, float, 3, 0, 1>(
+      in_channels, in_height, in_width, out_channels, 1, 0.1f);
+  paddle_mobile::TestConvOp<float, float, 5, 2, 1>(
+      in_channels, in_height, in_width, out_channels, 1, 0.1f);
+  paddle_mobile::TestConvOp<float, float, 5, 0, 1>(
+      in_channels, in_height, in_width, out_channels, 1, 0.1f);
+  return 0;
+}
+
+// the algorithms picked by tuning must give the results of the reference
+int TestTuning(const int in_channels, const int in_height, const int in_width,
+               const int out_channels, const int groups) {
+  std::cerr << "tuning, in_channels=" << in_channels
+            << ", in_height=" << in_height << ", in_width=" << in_width
+            << ", out_channels=" << out_channels << ", groups=" << groups
+            << std::endl;
+  paddle_mobile::TestConvOp<float, float, 3, 1, 1>(
+      in_channels, in_height, in_width, out_channels, groups, 0.1f);
+  paddle_mobile::TestConvOp<float, float, 3, 0, 2>(
+      in_channels, in_height, in_width, out_channels, groups, 0.1f);
+  paddle_mobile::TestConvOp<float, float, 3, 1, 2>(
+      in_channels, in_height, in_width, out_channels, groups, 0.1f);
+  paddle_mobile::TestConvOp<float, float, 5, 2, 1>(
+      in_channels, in_height, in_width, out_channels, groups, 0.1f);
+  return 0;
+}
+
 int main() {
   TestAll(1, 5, 5, 1, 1);
   TestAll(1, 5, 5, 10, 1);
@@ -349,5 +388,14 @@ int main() {
   TestAll(5, 33, 13, 5, 1);
   TestAll(5, 33, 13, 13, 1);
   TestAll(13, 33, 13, 13, 13);
+
+  TestWinograd(64, 20, 20, 64);
+  TestWinograd(64, 13, 9, 72);
+
+  paddle_mobile::operators::math::ConvTuner::Instance()->EnableTuning(
+      "conv_tuning_profile.txt");
+  TestTuning(16, 33, 33, 16, 1);
+  TestTuning(16, 33, 33, 16, 16);
+  TestTuning(5, 33, 13, 13, 1);
   return 0;
 }
@@ -0,0 +1,207 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cstdlib>
+#include <iostream>
+#include "../test_helper.h"
+#include "../test_include.h"
+#include "operators/activation_op.h"
+#include "operators/batchnorm_op.h"
+#include "operators/conv_op.h"
+#include "operators/dequantize_op.h"
+#include "operators/elementwise_add_op.h"
+#include "operators/fusion_conv_dequant_quant_op.h"
+#include "operators/quantize_op.h"
+
+namespace paddle_mobile {
+
+template <typename Op>
+void RunOp(const std::string &type, const VariableNameMap &inputs,
+           const VariableNameMap &outputs, const framework::AttributeMap &attrs,
+           std::shared_ptr<framework::Scope> scope) {
+  Op op(type, inputs, outputs, attrs, scope);
+  op.InferShape();
+  op.Init();
+  op.Run();
+}
+
+framework::LoDTensor *NewVar(framework::Scope *scope, const std::string &name) {
+  return scope->Var(name)->template GetMutable<framework::LoDTensor>();
+}
+
+void SetScalar(framework::Scope *scope, const std::string &name, float v) {
+  framework::LoDTensor *tensor = NewVar(scope, name);
+  tensor->mutable_data<float>(framework::make_ddim({1}))[0] = v;
+}
+
+// the fused op must requantize the int32 conv output as the chain of conv,
+// dequantize, elementwise add, batch norm, relu (6) and quantize does, which
+// checks the bias and batch norm folded at Init
+template <typename FusedOp, typename ActOp>
+int TestConvDequantQuant(const std::string &fused_type, bool add, bool bn,
+                         bool per_channel) {
+  const int in_channels = 8;
+  const int out_channels = 12;
+  auto scope = std::make_shared<framework::Scope>();
+  framework::Scope *s = scope.get();
+
+  SetupTensor<int8_t>(NewVar(s, "input"), framework::make_ddim({1, 8, 9, 9}),
+                      -127, 127);
+  SetupTensor<int8_t>(NewVar(s, "filter"),
+                      framework::make_ddim({out_channels, in_channels, 3, 3}),
+                      -127, 127);
+  SetScalar(s, "scale", 0.02f);
+  SetScalar(s, "in_scale", 6.f);
+  framework::DDim channel_dims = framework::make_ddim({out_channels});
+  SetupTensor<float>(NewVar(s, "bias"), channel_dims, -1.f, 1.f);
+  SetupTensor<float>(NewVar(s, "bn_mean"), channel_dims, -1.f, 1.f);
+  SetupTensor<float>(NewVar(s, "bn_variance"), channel_dims, 0.5f, 2.f);
+  SetupTensor<float>(NewVar(s, "bn_scale"), channel_dims, 0.5f, 1.5f);
+  SetupTensor<float>(NewVar(s, "bn_bias"), channel_dims, -1.f, 1.f);
+  std::vector<float> weight_scales(out_channels);
+  for (int c = 0; c < out_channels; ++c) {
+    weight_scales[c] = per_channel ? 100.f + 5.f * c : 127.f;
+  }
+
+  framework::AttributeMap attrs;
+  attrs["strides"].Set<std::vector<int>>(std::vector<int>{1, 1});
+  attrs["paddings"].Set<std::vector<int>>(std::vector<int>{1, 1});
+  attrs["dilations"].Set<std::vector<int>>(std::vector<int>{1, 1});
+  attrs["groups"].Set<int>(1);
+  attrs["axis"].Set<int>(1);
+  attrs["epsilon"].Set<float>(1e-5f);
+  attrs["momentum"].Set<float>(0.9f);
+  if (per_channel) {
+    attrs["weight_scales"].Set<std::vector<float>>(weight_scales);
+  } else {
+    attrs["weight_scale"].Set<float>(weight_scales[0]);
+  }
+
+  // the unfused chain
+  NewVar(s, "conv");
+  RunOp<operators::ConvOp<CPU, float>>(
+      "conv2d", {{"Input", {"input"}}, {"Filter", {"filter"}}},
+      {{"Output", {"conv"}}}, attrs, scope);
+  std::string x = "dequant";
+  NewVar(s, x);
+  RunOp<operators::DequantizeOp<CPU, float>>(
+      "dequantize", {{"X", {"conv"}}, {"Scale", {"scale"}}}, {{"Out", {x}}},
+      attrs, scope);
+  if (add) {
+    NewVar(s, "add");
+    RunOp<operators::ElementwiseAddOp<CPU, float>>(
+        "elementwise_add", {{"X", {x}}, {"Y", {"bias"}}}, {{"Out", {"add"}}},
+        attrs, scope);
+    x = "add";
+  }
+  if (bn) {
+    NewVar(s, "bn");
+    RunOp<operators::BatchNormOp<CPU, float>>(
+        "batch_norm",
+        {{"X", {x}},
+         {"Mean", {"bn_mean"}},
+         {"Variance", {"bn_variance"}},
+         {"Scale", {"bn_scale"}},
+         {"Bias", {"bn_bias"}}},
+        {{"Y", {"bn"}}}, attrs, scope);
+    x = "bn";
+  }
+  NewVar(s, "act");
+  RunOp<ActOp>("relu", {{"X", {x}}}, {{"Out", {"act"}}}, attrs, scope);
+  NewVar(s, "expect");
+  NewVar(s, "expect_scale");
+  RunOp<operators::QuantizeOp<CPU, float>>(
+      "quantize", {{"X", {"act"}}, {"InScale", {"in_scale"}}},
+      {{"Out", {"expect"}}, {"OutScale", {"expect_scale"}}}, attrs, scope);
+
+  // the fused op
+  VariableNameMap inputs = {{"Input", {"input"}},
+                            {"Filter", {"filter"}},
+                            {"Scale", {"scale"}},
+                            {"InScale", {"in_scale"}}};
+  if (add) {
+    inputs["Y"] = {"bias"};
+  }
+  if (bn) {
+    inputs["BNMean"] = {"bn_mean"};
+    inputs["BNVariance"] = {"bn_variance"};
+    inputs["BNScale"] = {"bn_scale"};
+    inputs["BNBias"] = {"bn_bias"};
+  }
+  NewVar(s, "output");
+  NewVar(s, "output_scale");
+  RunOp<FusedOp>(fused_type, inputs,
+                 {{"Out", {"output"}}, {"OutScale", {"output_scale"}}}, attrs,
+                 scope);
+
+  const framework::LoDTensor *expect = NewVar(s, "expect");
+  const framework::LoDTensor *output = NewVar(s, "output");
+  PADDLE_MOBILE_ENFORCE(expect->dims() == output->dims(),
+                        "%s: output dims mismatch", fused_type.c_str());
+  const int8_t *expect_data = expect->data<int8_t>();
+  const int8_t *output_data = output->data<int8_t>();
+  for (int i = 0; i < output->numel(); ++i) {
+    // the float ops of the chain may round differently by one step
+    if (std::abs(expect_data[i] - output_data[i]) > 1) {
+      std::cerr << fused_type << ": output[" << i
+                << "] = " << static_cast<int>(output_data[i])
+                << ", expect: " << static_cast<int>(expect_data[i])
+                << std::endl;
+      return 1;
+    }
+  }
+  PADDLE_MOBILE_ENFORCE(
+      NewVar(s, "output_scale")->data<float>()[0] ==
+          NewVar(s, "expect_scale")->data<float>()[0],
+      "%s: output scale mismatch", fused_type.c_str());
+  return 0;
+}
+
+}  // namespace paddle_mobile
+
+int main() {
+  using paddle_mobile::CPU;
+  using paddle_mobile::operators::ReluOp;
+  using paddle_mobile::operators::Relu6Op;
+  int failed = 0;
+#ifdef FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP
+  failed |= paddle_mobile::TestConvDequantQuant<
+      paddle_mobile::operators::FusionConvDequantAddBNReluQuantOp<CPU, float>,
+      ReluOp<CPU, float>>("fusion_conv_dequant_add_bn_relu_quant", true, true,
+                          true);
+#endif
+#ifdef FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP
+  failed |= paddle_mobile::TestConvDequantQuant<
+      paddle_mobile::operators::FusionConvDequantBNReluQuantOp<CPU, float>,
+      ReluOp<CPU, float>>("fusion_conv_dequant_bn_relu_quant", false, true,
+                          false);
+#endif
+#ifdef FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP
+  failed |= paddle_mobile::TestConvDequantQuant<
+      paddle_mobile::operators::FusionConvDequantBNRelu6QuantOp<CPU, float>,
+      Relu6Op<CPU, float>>("fusion_conv_dequant_bn_relu6_quant", false, true,
+                           true);
+#endif
+#ifdef FUSION_CONV_DEQUANT_RELU_QUANT_OP
+  failed |= paddle_mobile::TestConvDequantQuant<
+      paddle_mobile::operators::FusionConvDequantReluQuantOp<CPU, float>,
+      ReluOp<CPU, float>>("fusion_conv_dequant_relu_quant", false, false,
+                          false);
+#endif
+  if (failed) {
+    return 1;
+  }
+  std::cout << "fused int8 conv matches the unfused ops" << std::endl;
+  return 0;
+}
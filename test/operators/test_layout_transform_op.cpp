@@ -0,0 +1,221 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <iostream>
+#include "../test_helper.h"
+#include "../test_include.h"
+#include "operators/conv_op.h"
+#include "operators/layout_transform_op.h"
+#include "operators/math/blocked_layout.h"
+#include "operators/math/pooling.h"
+
+namespace paddle_mobile {
+
+namespace math = operators::math;
+using framework::DataLayout;
+using framework::Tensor;
+
+// converts x to NCHW through the layout_transform op
+void ToNCHW(const Tensor &x, Tensor *y) {
+  auto scope = std::make_shared<framework::Scope>();
+  scope->Var("x")->GetMutable<framework::LoDTensor>()->ShareDataWith(x);
+  scope->Var("y");
+  framework::AttributeMap attrs;
+  attrs["dst_layout"].SetString("NCHW");
+  operators::LayoutTransformOp<CPU, float> op(
+      "layout_transform", {{"X", {"x"}}}, {{"Out", {"y"}}}, attrs, scope);
+  op.InferShape();
+  op.Init();
+  op.Run();
+  y->ShareDataWith(*scope->Var("y")->Get<framework::LoDTensor>());
+}
+
+void Compare(const char *name, const Tensor &blocked, const Tensor &expect) {
+  Tensor output;
+  ToNCHW(blocked, &output);
+  const float *x = output.data<float>();
+  const float *y = expect.data<float>();
+  for (int i = 0; i < expect.numel(); ++i) {
+    float gap = std::abs(x[i] - y[i]);
+    if (gap > 1e-2 && gap / (std::abs(y[i]) + 1e-5) > 1e-3) {
+      std::cerr << name << ": output[" << i << "] = " << x[i]
+                << ", expect[" << i << "] = " << y[i] << std::endl;
+      exit(1);
+    }
+  }
+}
+
+// the conv op on a blocked input must give the results of the NCHW one
+int TestConvBlocked(DataLayout layout, int in_channels, int in_height,
+                    int in_width, int out_channels, int groups, int kernel,
+                    int pad, int stride, int dilation) {
+  std::cerr << "conv " << DataLayoutToString(layout)
+            << ", in_channels=" << in_channels << ", out_channels="
+            << out_channels << ", groups=" << groups << ", kernel=" << kernel
+            << ", pad=" << pad << ", stride=" << stride
+            << ", dilation=" << dilation << std::endl;
+  auto scope = std::make_shared<framework::Scope>();
+  auto *input = scope->Var("input")->GetMutable<framework::LoDTensor>();
+  SetupTensor<float>(
+      input, framework::make_ddim({2, in_channels, in_height, in_width}), -1,
+      1);
+  auto *filter = scope->Var("filter")->GetMutable<framework::LoDTensor>();
+  SetupTensor<float>(filter,
+                     framework::make_ddim({out_channels, in_channels / groups,
+                                           kernel, kernel}),
+                     -1, 1);
+  auto *blocked = scope->Var("blocked")->GetMutable<framework::LoDTensor>();
+  math::LayoutTransform(*input, layout, blocked);
+  scope->Var("output");
+  scope->Var("blocked_output")
+      ->GetMutable<framework::LoDTensor>()
+      ->set_layout(layout);
+
+  framework::AttributeMap attrs;
+  attrs["strides"].Set<vector<int>>(std::vector<int>({stride, stride}));
+  attrs["paddings"].Set<vector<int>>(std::vector<int>({pad, pad}));
+  attrs["dilations"].Set<vector<int>>(std::vector<int>({dilation, dilation}));
+  attrs["groups"].Set<int>(groups);
+  operators::ConvOp<CPU, float> op(
+      "conv2d", {{"Input", {"input"}}, {"Filter", {"filter"}}},
+      {{"Output", {"output"}}}, attrs, scope);
+  op.InferShape();
+  op.Init();
+  op.Run();
+  operators::ConvOp<CPU, float> blocked_op(
+      "conv2d", {{"Input", {"blocked"}}, {"Filter", {"filter"}}},
+      {{"Output", {"blocked_output"}}}, attrs, scope);
+  blocked_op.InferShape();
+  blocked_op.Init();
+  blocked_op.Run();
+
+  Compare("conv", *scope->Var("blocked_output")->Get<framework::LoDTensor>(),
+          *scope->Var("output")->Get<framework::LoDTensor>());
+  return 0;
+}
+
+template <PoolingType P>
+int TestPoolBlocked(DataLayout layout, int channels, int kernel, int pad,
+                    int stride) {
+  std::cerr << "pool " << DataLayoutToString(layout) << ", type=" << P
+            << ", channels=" << channels << ", kernel=" << kernel
+            << ", pad=" << pad << ", stride=" << stride << std::endl;
+  Tensor input, blocked, output, blocked_output;
+  SetupTensor<float>(&input, framework::make_ddim({1, channels, 17, 13}), -1,
+                     1);
+  math::LayoutTransform(input, layout, &blocked);
+  const int out_h = (17 + 2 * pad - kernel) / stride + 1;
+  const int out_w = (13 + 2 * pad - kernel) / stride + 1;
+  auto out_dims = framework::make_ddim({1, channels, out_h, out_w});
+  std::vector<int> ksize({kernel, kernel});
+  std::vector<int> strides({stride, stride});
+  std::vector<int> paddings({pad, pad});
+  output.mutable_data<float>(out_dims);
+  math::Pooling<P>()(input, ksize, strides, paddings, &output);
+  blocked_output.Resize(out_dims);
+  math::PoolBlocked<P>(blocked, ksize, strides, paddings, &blocked_output);
+  Compare("pool", blocked_output, output);
+  return 0;
+}
+
+// scale and bias, add and concat against plain loops over NCHW
+int TestElementwiseBlocked(DataLayout layout, int channels) {
+  std::cerr << "elementwise " << DataLayoutToString(layout)
+            << ", channels=" << channels << std::endl;
+  const int spatial = 7 * 5;
+  auto dims = framework::make_ddim({2, channels, 7, 5});
+  Tensor x0, x1, b0, b1, expect, output;
+  SetupTensor<float>(&x0, dims, -1, 1);
+  SetupTensor<float>(&x1, dims, -1, 1);
+  math::LayoutTransform(x0, layout, &b0);
+  math::LayoutTransform(x1, layout, &b1);
+  std::vector<float> scale(channels), bias(channels);
+  for (int c = 0; c < channels; ++c) {
+    scale[c] = 0.5f + 0.1f * c;
+    bias[c] = -0.3f + 0.05f * c;
+  }
+
+  float *y = expect.mutable_data<float>(dims);
+  const float *a = x0.data<float>();
+  const float *b = x1.data<float>();
+  for (int i = 0; i < x0.numel(); ++i) {
+    float v = a[i] * scale[(i / spatial) % channels] +
+              bias[(i / spatial) % channels];
+    y[i] = std::max(v, 0.f);
+  }
+  output.Resize(dims);
+  math::ScaleBiasBlocked(b0, scale.data(), bias.data(), true, &output);
+  Compare("scale_bias", output, expect);
+
+  for (int i = 0; i < x0.numel(); ++i) {
+    y[i] = a[i] + b[i];
+  }
+  math::AddBlocked(b0, b1, &output);
+  Compare("add", output, expect);
+
+  // the channels of the first input are a multiple of the block
+  const int block = framework::DataLayoutBlock(layout);
+  Tensor x2, b2;
+  SetupTensor<float>(&x2, framework::make_ddim({2, block * 2, 7, 5}), -1, 1);
+  math::LayoutTransform(x2, layout, &b2);
+  auto concat_dims = framework::make_ddim({2, block * 2 + channels, 7, 5});
+  y = expect.mutable_data<float>(concat_dims);
+  const float *c = x2.data<float>();
+  for (int n = 0; n < 2; ++n) {
+    for (int i = 0; i < block * 2 * spatial; ++i) {
+      *y++ = c[n * block * 2 * spatial + i];
+    }
+    for (int i = 0; i < channels * spatial; ++i) {
+      *y++ = a[n * channels * spatial + i];
+    }
+  }
+  output.Resize(concat_dims);
+  math::ConcatBlocked({&b2, &b0}, &output);
+  Compare("concat", output, expect);
+  return 0;
+}
+
+}  // namespace paddle_mobile
+
+int TestAll(paddle_mobile::framework::DataLayout layout) {
+  using paddle_mobile::TestConvBlocked;
+  TestConvBlocked(layout, 3, 19, 23, 16, 1, 3, 1, 1, 1);
+  TestConvBlocked(layout, 16, 19, 23, 13, 1, 3, 1, 2, 1);
+  TestConvBlocked(layout, 13, 19, 23, 21, 1, 1, 0, 1, 1);
+  TestConvBlocked(layout, 8, 19, 23, 8, 1, 5, 2, 1, 1);
+  TestConvBlocked(layout, 8, 19, 23, 16, 1, 3, 2, 1, 2);
+  TestConvBlocked(layout, 32, 37, 41, 32, 1, 3, 1, 1, 1);
+  TestConvBlocked(layout, 16, 19, 23, 16, 16, 3, 1, 1, 1);
+  TestConvBlocked(layout, 13, 19, 23, 13, 13, 3, 1, 2, 1);
+  TestConvBlocked(layout, 24, 19, 23, 24, 24, 5, 2, 1, 1);
+
+  paddle_mobile::TestPoolBlocked<paddle_mobile::MAX>(layout, 13, 3, 1, 2);
+  paddle_mobile::TestPoolBlocked<paddle_mobile::MAX>(layout, 16, 2, 0, 2);
+  paddle_mobile::TestPoolBlocked<paddle_mobile::AVG>(layout, 13, 3, 1, 1);
+  paddle_mobile::TestPoolBlocked<paddle_mobile::AVG>(layout, 8, 3, 0, 2);
+
+  paddle_mobile::TestElementwiseBlocked(layout, 13);
+  paddle_mobile::TestElementwiseBlocked(layout, 16);
+  return 0;
+}
+
+int main() {
+  TestAll(paddle_mobile::framework::DataLayout::kNCHW4);
+  TestAll(paddle_mobile::framework::DataLayout::kNCHW8);
+  std::cerr << "preferred layout: "
+            << paddle_mobile::framework::DataLayoutToString(
+                   paddle_mobile::operators::math::PreferredBlockedLayout())
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,300 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./test_helper.h"
+#include "framework/executor.h"
+#include "framework/lod_tensor.h"
+#include "framework/model_writer.h"
+#include "framework/program/program.h"
+#include "framework/program/program_desc.h"
+#include "framework/scope.h"
+#include "io/paddle_mobile.h"
+
+// ProgramForTest builds a float program of one block in memory, so that a
+// test of a framework mechanism runs without model files. Its weights are
+// random as SetupTensor makes them, Save and Load encode the program as a
+// combined model with the model writer.
+class ProgramForTest {
+ public:
+  ProgramForTest() {
+    for (const char *name : {"feed", "fetch"}) {
+      AddVar(name, {}, true);
+    }
+  }
+
+  // an activation, dims are those of the first prediction
+  void AddVar(const std::string &name, const std::vector<int64_t> &dims,
+              bool persistable = false) {
+    vars_.push_back({name, dims, persistable});
+  }
+
+  // changes the dims of an activation, as if the model is saved for another
+  // input shape
+  void ResizeVar(const std::string &name, const std::vector<int64_t> &dims) {
+    for (auto &var : vars_) {
+      if (var.name == name) {
+        var.dims = dims;
+      }
+    }
+  }
+
+  // a weight of values in [lower, upper]
+  void AddParam(const std::string &name, const std::vector<int64_t> &dims,
+                float lower = -1.f, float upper = 1.f) {
+    AddVar(name, dims, true);
+    SetupTensor<float>(&params_[name],
+                       paddle_mobile::framework::make_ddim(dims), lower,
+                       upper);
+  }
+
+  void AddOp(const std::string &type,
+             const paddle_mobile::VariableNameMap &inputs,
+             const paddle_mobile::VariableNameMap &outputs,
+             const paddle_mobile::framework::AttributeMap &attrs = {}) {
+    ops_.push_back({type, inputs, outputs, attrs});
+  }
+
+  // the input and the output of Predict
+  void AddFeed(const std::string &name) {
+    AddOp("feed", {{"X", {"feed"}}}, {{"Out", {name}}});
+  }
+  void AddFetch(const std::string &name) {
+    AddOp("fetch", {{"X", {name}}}, {{"Out", {"fetch"}}});
+  }
+
+  // a conv2d of a 3x3 filter keeping the height and the width
+  void AddConv(const std::string &input, const std::string &filter,
+               const std::string &output) {
+    paddle_mobile::framework::AttributeMap attrs;
+    attrs["strides"].Set<std::vector<int>>(std::vector<int>{1, 1});
+    attrs["paddings"].Set<std::vector<int>>(std::vector<int>{1, 1});
+    attrs["dilations"].Set<std::vector<int>>(std::vector<int>{1, 1});
+    attrs["groups"].Set<int>(1);
+    AddOp("conv2d", {{"Input", {input}}, {"Filter", {filter}}},
+          {{"Output", {output}}}, attrs);
+  }
+
+  // x [1, 4, 8, 8] fed to a conv of 8 filters, a relu and a conv of 4
+  void AddConvNet() {
+    AddVar("x", {1, 4, 8, 8});
+    AddParam("w0", {8, 4, 3, 3});
+    AddParam("w1", {4, 8, 3, 3});
+    AddVar("c0", {1, 8, 8, 8});
+    AddVar("r0", {1, 8, 8, 8});
+    AddVar("c1", {1, 4, 8, 8});
+    AddFeed("x");
+    AddConv("x", "w0", "c0");
+    AddOp("relu", {{"X", {"c0"}}}, {{"Out", {"r0"}}});
+    AddConv("r0", "w1", "c1");
+    AddFetch("c1");
+  }
+
+  // x [1, 4, 8, 8] fed to a max pooling of 3x3 keeping the shape, a relu,
+  // a shortcut add of x and a sigmoid, every activation changes with the
+  // input shape
+  void AddPoolingNet() {
+    AddVar("x", {1, 4, 8, 8});
+    for (const char *name : {"p", "r", "s", "y"}) {
+      AddVar(name, {1, 4, 8, 8});
+    }
+    AddFeed("x");
+    paddle_mobile::framework::AttributeMap attrs;
+    attrs["pooling_type"].SetString("max");
+    attrs["ksize"].Set<std::vector<int>>(std::vector<int>{3, 3});
+    attrs["strides"].Set<std::vector<int>>(std::vector<int>{1, 1});
+    attrs["paddings"].Set<std::vector<int>>(std::vector<int>{1, 1});
+    attrs["global_pooling"].Set<bool>(false);
+    attrs["ceil_mode"].Set<bool>(false);
+    AddOp("pool2d", {{"X", {"x"}}}, {{"Out", {"p"}}}, attrs);
+    AddOp("relu", {{"X", {"p"}}}, {{"Out", {"r"}}});
+    paddle_mobile::framework::AttributeMap add_attrs;
+    add_attrs["axis"].Set<int>(-1);
+    AddOp("elementwise_add", {{"X", {"r"}}, {"Y", {"x"}}}, {{"Out", {"s"}}},
+          add_attrs);
+    AddOp("sigmoid", {{"X", {"s"}}}, {{"Out", {"y"}}});
+    AddFetch("y");
+  }
+
+  // a new description of the program, as the loader would parse it
+  std::shared_ptr<paddle_mobile::framework::ProgramDesc> Desc() const {
+    const PaddleMobile__Framework__Proto__VarType__TensorDesc tensor_init =
+        PADDLE_MOBILE__FRAMEWORK__PROTO__VAR_TYPE__TENSOR_DESC__INIT;
+    const PaddleMobile__Framework__Proto__VarType__LoDTensorDesc
+        lod_tensor_init =
+            PADDLE_MOBILE__FRAMEWORK__PROTO__VAR_TYPE__LO_DTENSOR_DESC__INIT;
+    const PaddleMobile__Framework__Proto__VarType type_init =
+        PADDLE_MOBILE__FRAMEWORK__PROTO__VAR_TYPE__INIT;
+    const PaddleMobile__Framework__Proto__VarDesc var_init =
+        PADDLE_MOBILE__FRAMEWORK__PROTO__VAR_DESC__INIT;
+    std::vector<PaddleMobile__Framework__Proto__VarType__TensorDesc> tensors(
+        vars_.size(), tensor_init);
+    std::vector<PaddleMobile__Framework__Proto__VarType__LoDTensorDesc>
+        lod_tensors(vars_.size(), lod_tensor_init);
+    std::vector<PaddleMobile__Framework__Proto__VarType> types(vars_.size(),
+                                                               type_init);
+    std::vector<PaddleMobile__Framework__Proto__VarDesc> vars(vars_.size(),
+                                                              var_init);
+    std::vector<std::vector<int64_t>> dims(vars_.size());
+    std::vector<PaddleMobile__Framework__Proto__VarDesc *> var_ptrs;
+    for (int i = 0; i < vars_.size(); ++i) {
+      dims[i] = vars_[i].dims;
+      tensors[i].data_type =
+          PADDLE_MOBILE__FRAMEWORK__PROTO__VAR_TYPE__TYPE__FP32;
+      tensors[i].n_dims = dims[i].size();
+      tensors[i].dims = dims[i].data();
+      lod_tensors[i].tensor = &tensors[i];
+      types[i].type =
+          PADDLE_MOBILE__FRAMEWORK__PROTO__VAR_TYPE__TYPE__LOD_TENSOR;
+      types[i].lod_tensor = &lod_tensors[i];
+      vars[i].name = const_cast<char *>(vars_[i].name.c_str());
+      vars[i].type = &types[i];
+      vars[i].persistable = vars_[i].persistable;
+      var_ptrs.push_back(&vars[i]);
+    }
+    const PaddleMobile__Framework__Proto__OpDesc op_init =
+        PADDLE_MOBILE__FRAMEWORK__PROTO__OP_DESC__INIT;
+    std::vector<PaddleMobile__Framework__Proto__OpDesc> ops(ops_.size(),
+                                                            op_init);
+    std::vector<PaddleMobile__Framework__Proto__OpDesc *> op_ptrs;
+    for (int i = 0; i < ops_.size(); ++i) {
+      ops[i].type = const_cast<char *>(ops_[i].type.c_str());
+      op_ptrs.push_back(&ops[i]);
+    }
+
+    PaddleMobile__Framework__Proto__BlockDesc block =
+        PADDLE_MOBILE__FRAMEWORK__PROTO__BLOCK_DESC__INIT;
+    block.n_vars = var_ptrs.size();
+    block.vars = var_ptrs.data();
+    block.n_ops = op_ptrs.size();
+    block.ops = op_ptrs.data();
+    PaddleMobile__Framework__Proto__BlockDesc *blocks[] = {&block};
+    PaddleMobile__Framework__Proto__ProgramDesc program =
+        PADDLE_MOBILE__FRAMEWORK__PROTO__PROGRAM_DESC__INIT;
+    program.n_blocks = 1;
+    program.blocks = blocks;
+    auto desc =
+        std::make_shared<paddle_mobile::framework::ProgramDesc>(&program);
+    // the arguments and the attributes are set as parsed
+    auto op_descs = desc->Block(0)->Ops();
+    for (int i = 0; i < ops_.size(); ++i) {
+      op_descs[i]->SetInputs(ops_[i].inputs);
+      op_descs[i]->SetOutputs(ops_[i].outputs);
+      op_descs[i]->SetAttrMap(ops_[i].attrs);
+    }
+    return desc;
+  }
+
+  // the __model__ and the combined params, in the order of the variables
+  std::string Model() const {
+    return paddle_mobile::framework::SerializeProgram(Desc().get());
+  }
+  std::string Params() const {
+    std::string params;
+    for (const auto &var_desc : Desc()->Block(0)->Vars()) {
+      auto param = params_.find(var_desc->Name());
+      if (param != params_.end()) {
+        paddle_mobile::framework::SerializeTensor(
+            param->second, paddle_mobile::framework::VARTYPE_TYPE_FP32,
+            &params);
+      }
+    }
+    return params;
+  }
+
+  void Save(const std::string &model_path,
+            const std::string &params_path) const {
+    paddle_mobile::framework::WriteFile(model_path, Model());
+    paddle_mobile::framework::WriteFile(params_path, Params());
+  }
+
+  template <typename Device>
+  bool Load(paddle_mobile::PaddleMobile<Device> *paddle_mobile,
+            bool optimize = true) const {
+    std::string model = Model();
+    std::string params = Params();
+    return paddle_mobile->LoadCombinedMemory(
+        model.size(), reinterpret_cast<const uint8_t *>(model.data()),
+        params.size(), reinterpret_cast<uint8_t *>(&params[0]), optimize);
+  }
+
+  // the weights in scope, as loading them would put them
+  void ShareParams(paddle_mobile::framework::Scope *scope) const {
+    for (const auto &param : params_) {
+      scope->Var(param.first)
+          ->GetMutable<paddle_mobile::framework::LoDTensor>()
+          ->ShareDataWith(param.second);
+    }
+  }
+  const paddle_mobile::framework::LoDTensor &Param(
+      const std::string &name) const {
+    return params_.at(name);
+  }
+
+  // an executor of a program without weights in a new scope, whose tensors
+  // are sized as the loader does
+  std::shared_ptr<paddle_mobile::framework::Executor<paddle_mobile::CPU>>
+  Executor(const paddle_mobile::PaddleMobileConfigInternal &config =
+               paddle_mobile::PaddleMobileConfigInternal()) const {
+    paddle_mobile::framework::Program<paddle_mobile::CPU> program;
+    program.originProgram = Desc();
+    program.scope = std::make_shared<paddle_mobile::framework::Scope>();
+    for (const auto &var : vars_) {
+      program.scope->Var(var.name)
+          ->GetMutable<paddle_mobile::framework::LoDTensor>()
+          ->Resize(paddle_mobile::framework::make_ddim(var.dims));
+    }
+    program.combined_params_len = 0;
+    program.combined_params_buf = nullptr;
+    return std::make_shared<
+        paddle_mobile::framework::Executor<paddle_mobile::CPU>>(
+        program, config, 1, false);
+  }
+
+  // an input of the dims in [-0.5, 0.5)
+  static std::vector<float> Input(const std::vector<int64_t> &dims) {
+    int64_t size = 1;
+    for (int64_t dim : dims) {
+      size *= dim;
+    }
+    std::vector<float> input(size);
+    for (int64_t i = 0; i < size; ++i) {
+      input[i] = static_cast<float>(i % 13) / 13 - 0.5f;
+    }
+    return input;
+  }
+
+ private:
+  struct Var {
+    std::string name;
+    std::vector<int64_t> dims;
+    bool persistable;
+  };
+  struct Op {
+    std::string type;
+    paddle_mobile::VariableNameMap inputs;
+    paddle_mobile::VariableNameMap outputs;
+    paddle_mobile::framework::AttributeMap attrs;
+  };
+
+  std::vector<Var> vars_;
+  std::vector<Op> ops_;
+  std::map<std::string, paddle_mobile::framework::LoDTensor> params_;
+};
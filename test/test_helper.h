@@ -14,7 +14,10 @@ limitations under the License. */
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <iostream>
 #include <random>
 #include <string>
 #include <vector>
@@ -137,3 +140,32 @@ void GetInput(const std::string &input_name,
   in.read(reinterpret_cast<char *>(input_ptr), input->numel() * sizeof(T));
   in.close();
 }
+
+// whether the outputs of two predictions match, an element may differ by
+// max_gap, scaled by max(1, |expect|) if relative. Prints the first
+// mismatch.
+inline bool CompareOutputs(const std::vector<float> &expect,
+                           const std::vector<float> &result,
+                           float max_gap = 1e-5f, bool relative = false) {
+  if (expect.empty() || expect.size() != result.size()) {
+    std::cout << "output size mismatch, expect: " << expect.size()
+              << ", but got: " << result.size() << std::endl;
+    return false;
+  }
+  for (int i = 0; i < expect.size(); ++i) {
+    float gap = relative ? max_gap * std::max(1.f, std::abs(expect[i]))
+                         : max_gap;
+    if (std::abs(expect[i] - result[i]) > gap) {
+      std::cout << "output[" << i << "] mismatch, expect: " << expect[i]
+                << ", but got: " << result[i] << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// the tests comparing against a model skip that part without its files
+inline bool FileExists(const std::string &path) {
+  std::ifstream in(path, std::ios::in | std::ios::binary);
+  return in.good();
+}
@@ -278,12 +278,17 @@ if(NOT FOUND_MATCH)
   set(CAST_OP ON)
   set(QUANT_OP ON)
   set(DEQUANT_OP ON)
+  set(LAYOUT_TRANSFORM_OP ON)
   set(FUSION_DEQUANT_BN_OP ON)
   set(FUSION_DEQUANT_ADD_BN_OP ON)
   set(FUSION_DEQUANT_BN_RELU_OP ON)
   set(FUSION_DEQUANT_ADD_BN_RELU_OP ON)
   set(FUSION_DEQUANT_ADD_BN_QUANT_OP ON)
   set(FUSION_DEQUANT_ADD_BN_RELU_QUANT_OP ON)
+  set(FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP ON)
+  set(FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP ON)
+  set(FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP ON)
+  set(FUSION_CONV_DEQUANT_RELU_QUANT_OP ON)
   set(SEQUENCE_EXPAND_OP ON)
   set(SEQUENCE_POOL_OP ON)
   set(SEQUENCE_SOFTMAX_OP ON)
@@ -517,6 +522,9 @@ endif()
 if (DEQUANT_OP)
   add_definitions(-DDEQUANT_OP)
 endif()
+if (LAYOUT_TRANSFORM_OP)
+  add_definitions(-DLAYOUT_TRANSFORM_OP)
+endif()
 if (FUSION_DEQUANT_BN_OP)
   add_definitions(-DFUSION_DEQUANT_BN_OP)
 endif()
@@ -535,6 +543,18 @@ endif()
 if (FUSION_DEQUANT_ADD_BN_RELU_QUANT_OP)
 #  add_definitions(-DFUSION_DEQUANT_ADD_BN_RELU_QUANT_OP)
 endif()
+if (FUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP)
+  add_definitions(-DFUSION_CONV_DEQUANT_ADD_BN_RELU_QUANT_OP)
+endif()
+if (FUSION_CONV_DEQUANT_BN_RELU_QUANT_OP)
+  add_definitions(-DFUSION_CONV_DEQUANT_BN_RELU_QUANT_OP)
+endif()
+if (FUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP)
+  add_definitions(-DFUSION_CONV_DEQUANT_BN_RELU6_QUANT_OP)
+endif()
+if (FUSION_CONV_DEQUANT_RELU_QUANT_OP)
+  add_definitions(-DFUSION_CONV_DEQUANT_RELU_QUANT_OP)
+endif()
 if (SEQUENCE_EXPAND_OP)
   add_definitions(-DSEQUENCE_EXPAND_OP)
 endif()